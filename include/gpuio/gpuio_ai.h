@@ -27,6 +27,7 @@ typedef struct gpuio_model* gpuio_model_handle_t;
 typedef struct gpuio_ai_context* gpuio_ai_context_t;
 typedef struct gpuio_inference_request* gpuio_inference_request_t;
 typedef struct gpuio_training_batch* gpuio_training_batch_t;
+typedef struct gpuio_data_loader* gpuio_data_loader_t;
 
 /**
  * AI workload priority classes.
@@ -493,6 +494,31 @@ gpuio_error_t gpuio_ai_inference(gpuio_ai_context_t ai_ctx,
                                   const gpuio_inference_params_t* params,
                                   gpuio_inference_result_t* result);
 
+/**
+ * Inputs for one training step, as produced by a lookahead source and as
+ * staged (pinned) for the step body.
+ */
+typedef struct {
+    const void** inputs;
+    size_t* input_sizes;
+    int num_inputs;
+    const void* labels;
+    size_t labels_size;
+} gpuio_training_inputs_t;
+
+/*
+ * Lookahead source: fill inputs for the given step. Called from a prefetch
+ * thread while earlier steps run; the pointers only need to stay valid
+ * until the next call. Return GPUIO_ERROR_NOT_FOUND when exhausted.
+ */
+typedef gpuio_error_t (*gpuio_training_source_fn)(void* user_data, uint64_t step,
+                                                   gpuio_training_inputs_t* inputs);
+
+/* Step body, run on the staged inputs */
+typedef gpuio_error_t (*gpuio_training_compute_fn)(void* user_data,
+                                                    const gpuio_training_inputs_t* staged,
+                                                    float* loss);
+
 /**
  * Training batch configuration.
  */
@@ -515,13 +541,27 @@ typedef struct {
     const char* checkpoint_path;
     int checkpoint_interval_steps;
     
+    /* Lookahead input source (replaces inputs/labels when set) */
+    gpuio_data_loader_t loader;
+    gpuio_training_source_fn source;
+    void* source_data;
+    int num_buffers;                /* 2 = double, 3 = triple buffering (default 2) */
+    
+    /* Step body (optional) */
+    gpuio_training_compute_fn compute;
+    void* compute_data;
+    
     /* Control */
     gpuio_stream_t stream;
 } gpuio_training_params_t;
 
 typedef struct {
     float loss;
+    uint64_t step;
     uint64_t step_time_us;
+    uint64_t io_wait_us;            /* Step blocked waiting for its inputs */
+    uint64_t fetch_time_us;         /* Time spent fetching and staging them */
+    double overlap;                 /* Fraction of fetch time hidden behind earlier steps */
     bool checkpoint_saved;
     char checkpoint_path[512];
     gpuio_error_t status;
@@ -529,13 +569,37 @@ typedef struct {
 
 /**
  * Execute training step with checkpointing and engram updates.
+ *
+ * With a lookahead source (loader or source callback), the inputs of the
+ * next num_buffers - 1 steps are fetched into pinned staging buffers while
+ * the current step runs. The pipeline stays bound to the source across
+ * calls; passing a different source rebinds it. Returns
+ * GPUIO_ERROR_NOT_FOUND once the source is exhausted.
  */
 gpuio_error_t gpuio_ai_training_step(gpuio_ai_context_t ai_ctx,
                                       const gpuio_training_params_t* params,
                                       gpuio_training_result_t* result);
 
+/**
+ * Stop input prefetching and drop staged batches. Call before destroying
+ * the loader or source a training pipeline is bound to.
+ */
+gpuio_error_t gpuio_ai_training_reset(gpuio_ai_context_t ai_ctx);
+
 /**
  * Model checkpointing.
+ *
+ * A checkpoint is a directory holding a MANIFEST and N data shard files.
+ * gpuio_ai_checkpoint_save() writes every registered tensor, spreading
+ * tensors across shards written in parallel, and commits by atomically
+ * renaming the manifest into place. gpuio_ai_checkpoint_load() restores
+ * the registered tensors by name, verifying a hash of every data block.
+ *
+ * With async = true, save only snapshots the tensors into a pinned staging
+ * pool and returns; a background writer persists the snapshot, optionally
+ * bandwidth-limited, and reports completion through the checkpoint
+ * callback and gpuio_ai_checkpoint_wait(). At most one async save is in
+ * flight; the next save or load waits for it to finish first.
  */
 gpuio_error_t gpuio_ai_checkpoint_save(gpuio_ai_context_t ai_ctx,
                                         const char* path,
@@ -546,6 +610,170 @@ gpuio_error_t gpuio_ai_checkpoint_load(gpuio_ai_context_t ai_ctx,
                                         const char* path,
                                         gpuio_stream_t stream);
 
+/*
+ * Incremental save: only blocks that changed since parent_path are
+ * written; the rest are referenced from the parent chain on load.
+ */
+gpuio_error_t gpuio_ai_checkpoint_save_incremental(gpuio_ai_context_t ai_ctx,
+                                                    const char* path,
+                                                    const char* parent_path,
+                                                    bool async,
+                                                    gpuio_stream_t stream);
+
+/* Tensor registration (name must be unique, data must stay valid) */
+gpuio_error_t gpuio_ai_checkpoint_register_tensor(gpuio_ai_context_t ai_ctx,
+                                                   const char* name,
+                                                   void* data,
+                                                   size_t size);
+gpuio_error_t gpuio_ai_checkpoint_unregister_tensor(gpuio_ai_context_t ai_ctx,
+                                                     const char* name);
+
+/**
+ * Checkpoint writer configuration. Zero fields select defaults.
+ */
+typedef struct {
+    int num_shards;                 /* Data shard files (default 8) */
+    int num_threads;                /* IO worker threads (default num_shards) */
+    size_t io_size;                 /* Bytes per write/read (default 8MB) */
+    bool direct_io;                 /* O_DIRECT where supported */
+    
+    /* Optional per-device shard directories, assigned round-robin */
+    const char** shard_dirs;
+    int num_shard_dirs;
+    
+    uint64_t async_bandwidth;       /* Async save write limit, bytes/s (0 = none) */
+} gpuio_checkpoint_config_t;
+
+gpuio_error_t gpuio_ai_checkpoint_configure(gpuio_ai_context_t ai_ctx,
+                                             const gpuio_checkpoint_config_t* config);
+
+typedef struct {
+    uint64_t checkpoints_saved;
+    uint64_t checkpoints_loaded;
+    uint64_t last_save_bytes;
+    uint64_t last_save_time_us;
+    double last_save_gbps;
+    uint64_t last_load_bytes;
+    uint64_t last_load_time_us;
+    double last_load_gbps;
+    uint64_t async_saves;
+    uint64_t async_failures;
+    uint64_t last_snapshot_time_us; /* Time save(async) blocked the caller */
+    uint64_t last_save_stored_bytes;/* Bytes actually written by the last save */
+    double last_save_dedup_ratio;   /* 1 - stored / total for the last save */
+    uint64_t last_restore_ready_us; /* load_lazy() call to return */
+    uint64_t last_restore_time_us;  /* load_lazy() call to all tensors resident */
+    uint64_t demand_fetches;        /* Tensors materialized by acquire() */
+} gpuio_checkpoint_stats_t;
+
+gpuio_error_t gpuio_ai_checkpoint_get_stats(gpuio_ai_context_t ai_ctx,
+                                             gpuio_checkpoint_stats_t* stats);
+
+/* Async save completion, invoked from the background writer thread */
+typedef void (*gpuio_checkpoint_callback_t)(const char* path,
+                                            gpuio_error_t status,
+                                            void* user_data);
+
+gpuio_error_t gpuio_ai_checkpoint_set_callback(gpuio_ai_context_t ai_ctx,
+                                                gpuio_checkpoint_callback_t callback,
+                                                void* user_data);
+
+/*
+ * Wait for the in-flight lazy restore and async save; timeout_ms < 0
+ * waits forever.
+ */
+gpuio_error_t gpuio_ai_checkpoint_wait(gpuio_ai_context_t ai_ctx,
+                                        int timeout_ms);
+
+/*
+ * Lazy restore: maps the shard files and returns once the checkpoint is
+ * validated. Tensors are then materialized in registration (layer) order
+ * by a background thread. Call gpuio_ai_checkpoint_acquire() before the
+ * first use of a tensor; it materializes that tensor immediately if the
+ * background thread has not reached it yet. Once the restore is reaped,
+ * acquire() keeps reporting each tensor's result until the next load, and
+ * GPUIO_ERROR_NOT_FOUND for tensors the restore did not cover.
+ */
+gpuio_error_t gpuio_ai_checkpoint_load_lazy(gpuio_ai_context_t ai_ctx,
+                                             const char* path);
+
+gpuio_error_t gpuio_ai_checkpoint_acquire(gpuio_ai_context_t ai_ctx,
+                                           const char* name);
+
+/* ============================================================================
+ * Data Loader API
+ * ============================================================================ */
+
+/**
+ * Training data loader over record-oriented shard files.
+ *
+ * Records are either fixed-size (record_size > 0) or prefixed with a
+ * little-endian uint32 length. Reader threads stream shards in a per-epoch
+ * shuffled order; records are mixed through a bounded shuffle buffer and
+ * packed into pinned batch buffers, K of which are kept ready ahead of the
+ * training step. For a given seed and configuration the batch sequence is
+ * identical on every run, regardless of thread timing.
+ */
+
+typedef struct {
+    const char** shard_paths;
+    int num_shards;
+    
+    size_t record_size;             /* Fixed record size, 0 = length-prefixed */
+    size_t max_record_size;         /* Length-prefixed bound (default 16MB) */
+    
+    int batch_size;                 /* Records per batch */
+    int num_readers;                /* Reader threads (default 4) */
+    int prefetch_batches;           /* K batches kept ready (default 4) */
+    size_t shuffle_buffer;          /* Records held for shuffling, 0 = none */
+    size_t read_size;               /* Bytes per read (default 1MB) */
+    uint64_t seed;
+    int num_epochs;                 /* 0 = repeat forever */
+} gpuio_data_loader_config_t;
+
+/**
+ * One batch, laid out to feed gpuio_training_params_t directly. Valid
+ * until passed to gpuio_data_loader_release().
+ */
+typedef struct {
+    const void** inputs;
+    size_t* input_sizes;
+    int num_inputs;                 /* < batch_size only at epoch end */
+    
+    uint64_t epoch;
+    uint64_t index;                 /* Batch number since creation */
+    uint64_t stall_us;              /* Time next() waited for this batch */
+    
+    int slot;                       /* Internal */
+} gpuio_data_batch_t;
+
+typedef struct {
+    uint64_t batches;
+    uint64_t records;
+    uint64_t bytes;
+    uint64_t stall_us_total;
+    uint64_t stall_us_max;
+    uint64_t last_stall_us;
+    double avg_stall_us;            /* Per step */
+} gpuio_data_loader_stats_t;
+
+gpuio_error_t gpuio_data_loader_create(gpuio_ai_context_t ai_ctx,
+                                        const gpuio_data_loader_config_t* config,
+                                        gpuio_data_loader_t* loader);
+
+gpuio_error_t gpuio_data_loader_destroy(gpuio_data_loader_t loader);
+
+/* Next batch; GPUIO_ERROR_NOT_FOUND once all epochs are exhausted */
+gpuio_error_t gpuio_data_loader_next(gpuio_data_loader_t loader,
+                                      gpuio_data_batch_t* batch);
+
+/* Return a batch's buffer to the prefetch pool */
+gpuio_error_t gpuio_data_loader_release(gpuio_data_loader_t loader,
+                                         gpuio_data_batch_t* batch);
+
+gpuio_error_t gpuio_data_loader_get_stats(gpuio_data_loader_t loader,
+                                           gpuio_data_loader_stats_t* stats);
+
 /* ============================================================================
  * Compression API
  * ============================================================================ */
@@ -556,7 +784,7 @@ gpuio_error_t gpuio_ai_checkpoint_load(gpuio_ai_context_t ai_ctx,
 typedef struct gpuio_codec* gpuio_codec_t;
 
 typedef enum {
-    GPUIO_CODEC_LZ4 = 0,            /* Fast compression */
+    GPUIO_CODEC_LZ4 = 0,            /* Fast lossless compression (LZ4 block) */
     GPUIO_CODEC_ZSTD = 1,           /* Balanced compression */
     GPUIO_CODEC_GZIP = 2,           /* Maximum compression */
     GPUIO_CODEC_FP16 = 3,           /* FP32 -> FP16 for tensors */
@@ -124,6 +124,35 @@ gpuio_error_t gpuio_ai_context_create(gpuio_context_t ctx,
         /* Graph RAG is initialized on index creation */
     }
     
+    /* Checkpointing is always available */
+    ai->checkpoint = calloc(1, sizeof(struct ai_checkpoint));
+    if (!ai->checkpoint) {
+        AI_LOG_ERROR(ai, "Failed to allocate checkpoint structure");
+        free(ai->graph_rag);
+        free(ai->engram);
+        free(ai->dsa_kv);
+        pthread_mutex_destroy(&ai->lock);
+        pthread_mutex_destroy(&ai->stats_lock);
+        free(ai);
+        return GPUIO_ERROR_NOMEM;
+    }
+    ai_checkpoint_init(ai->checkpoint, ai);
+    
+    ai->training = calloc(1, sizeof(struct ai_training));
+    if (!ai->training) {
+        AI_LOG_ERROR(ai, "Failed to allocate training structure");
+        ai_checkpoint_cleanup(ai->checkpoint);
+        free(ai->checkpoint);
+        free(ai->graph_rag);
+        free(ai->engram);
+        free(ai->dsa_kv);
+        pthread_mutex_destroy(&ai->lock);
+        pthread_mutex_destroy(&ai->stats_lock);
+        free(ai);
+        return GPUIO_ERROR_NOMEM;
+    }
+    ai_training_init(ai->training, ai);
+    
     ai->initialized = true;
     *ai_ctx = ai;
     
@@ -170,6 +199,20 @@ gpuio_error_t gpuio_ai_context_destroy(gpuio_ai_context_t ai_ctx) {
         ai->engram = NULL;
     }
     
+    /* Stop input prefetch before the subsystems it may checkpoint into */
+    if (ai->training) {
+        ai_training_cleanup(ai->training);
+        free(ai->training);
+        ai->training = NULL;
+    }
+    
+    /* Clean up checkpoint subsystem */
+    if (ai->checkpoint) {
+        ai_checkpoint_cleanup(ai->checkpoint);
+        free(ai->checkpoint);
+        ai->checkpoint = NULL;
+    }
+    
     /* Clean up Graph RAG subsystem */
     if (ai->graph_rag) {
         free(ai->graph_rag);
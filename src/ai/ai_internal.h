@@ -35,6 +35,8 @@ extern "C" {
 struct ai_dsa_kv;
 struct ai_engram;
 struct ai_graph_rag;
+struct ai_checkpoint;
+struct ai_training;
 
 /* ============================================================================
  * Internal AI Context
@@ -48,6 +50,8 @@ struct gpuio_ai_context {
     struct ai_dsa_kv* dsa_kv;
     struct ai_engram* engram;
     struct ai_graph_rag* graph_rag;
+    struct ai_checkpoint* checkpoint;
+    struct ai_training* training;
     
     /* Global statistics */
     pthread_mutex_t stats_lock;
@@ -89,6 +93,9 @@ void ai_context_update_stats(gpuio_ai_context_t ai_ctx,
 #include "engram_internal.h"
 #include "graph_rag_internal.h"
 #include "compression_internal.h"
+#include "checkpoint_internal.h"
+#include "data_loader_internal.h"
+#include "training_internal.h"
 
 #ifdef __cplusplus
 }
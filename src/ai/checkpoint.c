@@ -0,0 +1,2378 @@
+/**
+ * @file checkpoint.c
+ * @brief AI Extensions module - Sharded parallel checkpointing
+ * @version 1.0.0
+ *
+ * Implements gpuio_ai_checkpoint_save/load. Registered tensors are packed
+ * into N shard files (largest-first onto the least loaded shard) and the
+ * shards are written by a pool of worker threads through aligned staging
+ * buffers, with O_DIRECT where the filesystem supports it. Every shard is
+ * fsync'd before MANIFEST.tmp is written, fsync'd and renamed over
+ * MANIFEST, so a crash leaves either the old or the new checkpoint.
+ */
+
+#include "ai_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+/* ============================================================================
+ * File Helpers
+ * ============================================================================ */
+
+static int ckpt_mkdirs(const char* path) {
+    char buf[PATH_MAX];
+    size_t len = strlen(path);
+    
+    if (len == 0 || len >= sizeof(buf)) return -1;
+    memcpy(buf, path, len + 1);
+    
+    for (char* p = buf + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(buf, 0755) != 0 && errno != EEXIST) return -1;
+        *p = '/';
+    }
+    
+    if (mkdir(buf, 0755) != 0 && errno != EEXIST) return -1;
+    return 0;
+}
+
+static int ckpt_join(char* out, size_t out_size, const char* dir,
+                     const char* name) {
+    int n = snprintf(out, out_size, "%s/%s", dir, name);
+    return (n < 0 || (size_t)n >= out_size) ? -1 : 0;
+}
+
+/* Resolve a manifest shard path against the checkpoint directory */
+static int ckpt_shard_path(char* out, size_t out_size, const char* dir,
+                           const char* shard_path) {
+    if (shard_path[0] == '/') {
+        int n = snprintf(out, out_size, "%s", shard_path);
+        return (n < 0 || (size_t)n >= out_size) ? -1 : 0;
+    }
+    return ckpt_join(out, out_size, dir, shard_path);
+}
+
+static int ckpt_fsync_dir(const char* dir) {
+    int fd = open(dir, O_RDONLY);
+    if (fd < 0) return -1;
+    
+    int ret = fsync(fd);
+    close(fd);
+    return ret;
+}
+
+static int ckpt_open(const char* path, int flags, bool direct_io) {
+#ifdef O_DIRECT
+    if (direct_io) {
+        int fd = open(path, flags | O_DIRECT, 0644);
+        if (fd >= 0) return fd;
+        /* Filesystem (e.g. tmpfs) may reject O_DIRECT; fall back */
+    }
+#else
+    (void)direct_io;
+#endif
+    return open(path, flags, 0644);
+}
+
+/* Drop O_DIRECT on an open fd after the kernel rejects an IO */
+static bool ckpt_clear_direct(int fd) {
+#ifdef O_DIRECT
+    int fl = fcntl(fd, F_GETFL);
+    if (fl >= 0 && (fl & O_DIRECT)) {
+        return fcntl(fd, F_SETFL, fl & ~O_DIRECT) == 0;
+    }
+#else
+    (void)fd;
+#endif
+    return false;
+}
+
+static int ckpt_pwrite_full(int fd, const void* buf, size_t len, off_t off) {
+    size_t done = 0;
+    
+    while (done < len) {
+        ssize_t n = pwrite(fd, (const char*)buf + done, len - done, off + done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EINVAL && ckpt_clear_direct(fd)) continue;
+            return -1;
+        }
+        done += n;
+    }
+    
+    return 0;
+}
+
+/* Read up to len bytes; returns bytes read (short only at EOF) or -1 */
+static ssize_t ckpt_pread_full(int fd, void* buf, size_t len, off_t off) {
+    size_t done = 0;
+    
+    while (done < len) {
+        ssize_t n = pread(fd, (char*)buf + done, len - done, off + done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EINVAL && ckpt_clear_direct(fd)) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        done += n;
+    }
+    
+    return (ssize_t)done;
+}
+
+/* ============================================================================
+ * Manifest Serialization
+ * ============================================================================ */
+
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    size_t cap;
+    bool failed;
+} ckpt_buf_t;
+
+static void ckpt_buf_put(ckpt_buf_t* b, const void* src, size_t len) {
+    if (b->failed) return;
+    
+    if (b->len + len > b->cap) {
+        size_t cap = b->cap ? b->cap * 2 : 4096;
+        while (cap < b->len + len) cap *= 2;
+        uint8_t* data = realloc(b->data, cap);
+        if (!data) {
+            b->failed = true;
+            return;
+        }
+        b->data = data;
+        b->cap = cap;
+    }
+    
+    memcpy(b->data + b->len, src, len);
+    b->len += len;
+}
+
+static void ckpt_put_u16(ckpt_buf_t* b, uint16_t v) { ckpt_buf_put(b, &v, sizeof(v)); }
+static void ckpt_put_u32(ckpt_buf_t* b, uint32_t v) { ckpt_buf_put(b, &v, sizeof(v)); }
+static void ckpt_put_u64(ckpt_buf_t* b, uint64_t v) { ckpt_buf_put(b, &v, sizeof(v)); }
+
+static void ckpt_put_str(ckpt_buf_t* b, const char* s) {
+    size_t len = strlen(s);
+    ckpt_put_u16(b, (uint16_t)len);
+    ckpt_buf_put(b, s, len);
+}
+
+typedef struct {
+    const uint8_t* data;
+    size_t len;
+    size_t pos;
+    bool failed;
+} ckpt_cursor_t;
+
+static void ckpt_get(ckpt_cursor_t* c, void* dst, size_t len) {
+    if (c->failed || c->pos + len > c->len) {
+        c->failed = true;
+        memset(dst, 0, len);
+        return;
+    }
+    memcpy(dst, c->data + c->pos, len);
+    c->pos += len;
+}
+
+static uint16_t ckpt_get_u16(ckpt_cursor_t* c) { uint16_t v; ckpt_get(c, &v, sizeof(v)); return v; }
+static uint32_t ckpt_get_u32(ckpt_cursor_t* c) { uint32_t v; ckpt_get(c, &v, sizeof(v)); return v; }
+static uint64_t ckpt_get_u64(ckpt_cursor_t* c) { uint64_t v; ckpt_get(c, &v, sizeof(v)); return v; }
+
+static char* ckpt_get_str(ckpt_cursor_t* c) {
+    uint16_t len = ckpt_get_u16(c);
+    if (c->failed || c->pos + len > c->len) {
+        c->failed = true;
+        return NULL;
+    }
+    
+    char* s = malloc(len + 1);
+    if (!s) {
+        c->failed = true;
+        return NULL;
+    }
+    memcpy(s, c->data + c->pos, len);
+    s[len] = '\0';
+    c->pos += len;
+    return s;
+}
+
+void ai_ckpt_manifest_free(ai_ckpt_manifest_t* manifest) {
+    if (!manifest) return;
+    
+    if (manifest->ancestors) {
+        for (uint32_t i = 0; i < manifest->num_ancestors; i++) {
+            free(manifest->ancestors[i].path);
+        }
+        free(manifest->ancestors);
+    }
+    
+    if (manifest->shards) {
+        for (uint32_t i = 0; i < manifest->num_shards; i++) {
+            free(manifest->shards[i].path);
+        }
+        free(manifest->shards);
+    }
+    
+    if (manifest->tensors) {
+        for (uint32_t i = 0; i < manifest->num_tensors; i++) {
+            free(manifest->tensors[i].name);
+            free(manifest->tensors[i].blocks);
+        }
+        free(manifest->tensors);
+    }
+    
+    memset(manifest, 0, sizeof(*manifest));
+}
+
+/**
+ * @brief Write the manifest and atomically commit it.
+ *
+ * Layout: header (magic, version, id, total and stored bytes, ancestor,
+ * shard and tensor counts), ancestor records, shard records, tensor
+ * records with their block tables, then a hash of everything before it.
+ * Written to MANIFEST.tmp, fsync'd, renamed over MANIFEST and the
+ * directory fsync'd.
+ */
+gpuio_error_t ai_ckpt_manifest_write(const char* dir,
+                                      const ai_ckpt_manifest_t* manifest) {
+    ckpt_buf_t b = {0};
+    
+    ckpt_put_u32(&b, CKPT_MAGIC);
+    ckpt_put_u32(&b, CKPT_VERSION);
+    ckpt_put_u64(&b, manifest->checkpoint_id);
+    ckpt_put_u64(&b, manifest->total_bytes);
+    ckpt_put_u64(&b, manifest->stored_bytes);
+    ckpt_put_u32(&b, manifest->num_ancestors);
+    ckpt_put_u32(&b, manifest->num_shards);
+    ckpt_put_u32(&b, manifest->num_tensors);
+    
+    for (uint32_t i = 0; i < manifest->num_ancestors; i++) {
+        ckpt_put_u64(&b, manifest->ancestors[i].checkpoint_id);
+        ckpt_put_str(&b, manifest->ancestors[i].path);
+    }
+    
+    for (uint32_t i = 0; i < manifest->num_shards; i++) {
+        const ai_ckpt_shard_desc_t* s = &manifest->shards[i];
+        ckpt_put_u64(&b, s->size);
+        ckpt_put_str(&b, s->path);
+    }
+    
+    for (uint32_t i = 0; i < manifest->num_tensors; i++) {
+        const ai_ckpt_tensor_desc_t* t = &manifest->tensors[i];
+        ckpt_put_u64(&b, t->size);
+        ckpt_put_u64(&b, t->offset);
+        ckpt_put_u32(&b, t->shard);
+        ckpt_put_str(&b, t->name);
+        for (uint32_t k = 0; k < t->num_blocks; k++) {
+            ckpt_put_u64(&b, t->blocks[k].hash);
+            ckpt_put_u16(&b, t->blocks[k].depth);
+        }
+    }
+    
+    if (b.failed) {
+        free(b.data);
+        return GPUIO_ERROR_NOMEM;
+    }
+    ckpt_put_u64(&b, gpuio_hash_bytes(b.data, b.len, CKPT_HASH_SEED));
+    if (b.failed) {
+        free(b.data);
+        return GPUIO_ERROR_NOMEM;
+    }
+    
+    char tmp_path[PATH_MAX];
+    char final_path[PATH_MAX];
+    if (ckpt_join(tmp_path, sizeof(tmp_path), dir, CKPT_MANIFEST_TMP_NAME) != 0 ||
+        ckpt_join(final_path, sizeof(final_path), dir, CKPT_MANIFEST_NAME) != 0) {
+        free(b.data);
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        free(b.data);
+        return GPUIO_ERROR_IO;
+    }
+    
+    int ret = ckpt_pwrite_full(fd, b.data, b.len, 0);
+    if (ret == 0) ret = fsync(fd);
+    close(fd);
+    free(b.data);
+    
+    if (ret != 0 || rename(tmp_path, final_path) != 0) {
+        unlink(tmp_path);
+        return GPUIO_ERROR_IO;
+    }
+    
+    ckpt_fsync_dir(dir);
+    return GPUIO_SUCCESS;
+}
+
+gpuio_error_t ai_ckpt_manifest_read(const char* dir, ai_ckpt_manifest_t* manifest) {
+    memset(manifest, 0, sizeof(*manifest));
+    
+    char path[PATH_MAX];
+    if (ckpt_join(path, sizeof(path), dir, CKPT_MANIFEST_NAME) != 0) {
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return GPUIO_ERROR_NOT_FOUND;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)(2 * sizeof(uint64_t))) {
+        close(fd);
+        return GPUIO_ERROR_IO;
+    }
+    
+    size_t len = (size_t)st.st_size;
+    uint8_t* data = malloc(len);
+    if (!data) {
+        close(fd);
+        return GPUIO_ERROR_NOMEM;
+    }
+    
+    ssize_t n = ckpt_pread_full(fd, data, len, 0);
+    close(fd);
+    if (n != (ssize_t)len) {
+        free(data);
+        return GPUIO_ERROR_IO;
+    }
+    
+    /* Trailer hash covers the whole manifest */
+    uint64_t stored;
+    memcpy(&stored, data + len - sizeof(uint64_t), sizeof(uint64_t));
+    if (stored != gpuio_hash_bytes(data, len - sizeof(uint64_t), CKPT_HASH_SEED)) {
+        free(data);
+        return GPUIO_ERROR_IO;
+    }
+    
+    ckpt_cursor_t c = { .data = data, .len = len - sizeof(uint64_t) };
+    
+    uint32_t magic = ckpt_get_u32(&c);
+    uint32_t version = ckpt_get_u32(&c);
+    if (magic != CKPT_MAGIC || version != CKPT_VERSION) {
+        free(data);
+        return GPUIO_ERROR_UNSUPPORTED;
+    }
+    
+    manifest->checkpoint_id = ckpt_get_u64(&c);
+    manifest->total_bytes = ckpt_get_u64(&c);
+    manifest->stored_bytes = ckpt_get_u64(&c);
+    uint32_t num_ancestors = ckpt_get_u32(&c);
+    uint32_t num_shards = ckpt_get_u32(&c);
+    uint32_t num_tensors = ckpt_get_u32(&c);
+    
+    if (c.failed || num_shards > CKPT_MAX_SHARDS || num_ancestors > CKPT_MAX_CHAIN) {
+        free(data);
+        return GPUIO_ERROR_IO;
+    }
+    
+    manifest->ancestors = calloc(num_ancestors ? num_ancestors : 1,
+                                 sizeof(ai_ckpt_ancestor_t));
+    manifest->shards = calloc(num_shards ? num_shards : 1,
+                              sizeof(ai_ckpt_shard_desc_t));
+    manifest->tensors = calloc(num_tensors ? num_tensors : 1,
+                               sizeof(ai_ckpt_tensor_desc_t));
+    if (!manifest->ancestors || !manifest->shards || !manifest->tensors) {
+        ai_ckpt_manifest_free(manifest);
+        free(data);
+        return GPUIO_ERROR_NOMEM;
+    }
+    
+    for (uint32_t i = 0; i < num_ancestors && !c.failed; i++) {
+        ai_ckpt_ancestor_t* a = &manifest->ancestors[i];
+        a->checkpoint_id = ckpt_get_u64(&c);
+        a->path = ckpt_get_str(&c);
+        manifest->num_ancestors = i + 1;
+    }
+    
+    for (uint32_t i = 0; i < num_shards && !c.failed; i++) {
+        ai_ckpt_shard_desc_t* s = &manifest->shards[i];
+        s->size = ckpt_get_u64(&c);
+        s->path = ckpt_get_str(&c);
+        manifest->num_shards = i + 1;
+    }
+    
+    for (uint32_t i = 0; i < num_tensors && !c.failed; i++) {
+        ai_ckpt_tensor_desc_t* t = &manifest->tensors[i];
+        t->size = ckpt_get_u64(&c);
+        t->offset = ckpt_get_u64(&c);
+        t->shard = ckpt_get_u32(&c);
+        t->name = ckpt_get_str(&c);
+        manifest->num_tensors = i + 1;
+        
+        if (c.failed || t->shard >= num_shards ||
+            t->offset + t->size > manifest->shards[t->shard].size) {
+            c.failed = true;
+            break;
+        }
+        
+        t->num_blocks = ai_ckpt_num_blocks(t->size);
+        t->blocks = calloc(t->num_blocks ? t->num_blocks : 1, sizeof(ai_ckpt_block_t));
+        if (!t->blocks) {
+            c.failed = true;
+            break;
+        }
+        for (uint32_t k = 0; k < t->num_blocks && !c.failed; k++) {
+            t->blocks[k].hash = ckpt_get_u64(&c);
+            t->blocks[k].depth = ckpt_get_u16(&c);
+            if (t->blocks[k].depth > manifest->num_ancestors) c.failed = true;
+        }
+    }
+    
+    free(data);
+    
+    if (c.failed) {
+        ai_ckpt_manifest_free(manifest);
+        return GPUIO_ERROR_IO;
+    }
+    
+    return GPUIO_SUCCESS;
+}
+
+/* ============================================================================
+ * Parallel Shard IO
+ * ============================================================================ */
+
+/* qsort_r comparators over tensor indices; arg is the manifest */
+static int ckpt_cmp_offset(const void* a, const void* b, void* arg) {
+    const ai_ckpt_manifest_t* m = arg;
+    uint64_t oa = m->tensors[*(const uint32_t*)a].offset;
+    uint64_t ob = m->tensors[*(const uint32_t*)b].offset;
+    return (oa > ob) - (oa < ob);
+}
+
+static int ckpt_cmp_name(const void* a, const void* b, void* arg) {
+    const ai_ckpt_manifest_t* m = arg;
+    return strcmp(m->tensors[*(const uint32_t*)a].name,
+                  m->tensors[*(const uint32_t*)b].name);
+}
+
+/* Tensor indices of m sorted by name, for ckpt_find_tensor() */
+static uint32_t* ckpt_index_by_name(const ai_ckpt_manifest_t* m) {
+    uint32_t* by_name = malloc((m->num_tensors ? m->num_tensors : 1) *
+                               sizeof(uint32_t));
+    if (!by_name) return NULL;
+    
+    for (uint32_t i = 0; i < m->num_tensors; i++) by_name[i] = i;
+    
+    qsort_r(by_name, m->num_tensors, sizeof(uint32_t), ckpt_cmp_name, (void*)m);
+    
+    return by_name;
+}
+
+static ai_ckpt_tensor_desc_t* ckpt_find_tensor(const ai_ckpt_manifest_t* m,
+                                               const uint32_t* by_name,
+                                               const char* name) {
+    uint32_t lo = 0, hi = m->num_tensors;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int c = strcmp(m->tensors[by_name[mid]].name, name);
+        if (c < 0) lo = mid + 1; else hi = mid;
+    }
+    
+    if (lo == m->num_tensors || strcmp(m->tensors[by_name[lo]].name, name) != 0) {
+        return NULL;
+    }
+    return &m->tensors[by_name[lo]];
+}
+
+typedef struct {
+    struct ai_checkpoint* ckpt;
+    gpuio_context_t ctx;
+    gpuio_stream_t stream;
+    const char* dir;
+    ai_ckpt_manifest_t* manifest;
+    bool load;
+    
+    /* Per-shard tensor lists, sorted by offset (indices into manifest) */
+    uint32_t** shard_items;
+    uint32_t* shard_counts;
+    
+    /* Host pointer per manifest tensor (source on save, dest on load) */
+    void** buffers;
+    
+    /*
+     * Referenced checkpoints: on save refs[0] is the parent being diffed
+     * against; on load refs[d - 1] is ancestor d. Empty manifests stand in
+     * for ancestors that could not be read.
+     */
+    ai_ckpt_manifest_t* refs;
+    uint32_t** ref_by_name;
+    uint32_t num_refs;
+    
+    size_t io_size;
+    bool direct_io;
+    
+    /* Write throttle (async saves); bytes/s, 0 = unlimited */
+    uint64_t bandwidth;
+    uint64_t start_us;
+    uint64_t bytes_written;
+    
+    int next_shard;
+    gpuio_error_t status;
+    pthread_mutex_t status_lock;
+} ckpt_job_t;
+
+static void ckpt_job_fail(ckpt_job_t* job, gpuio_error_t err) {
+    pthread_mutex_lock(&job->status_lock);
+    if (job->status == GPUIO_SUCCESS) job->status = err;
+    pthread_mutex_unlock(&job->status_lock);
+}
+
+static bool ckpt_job_failed(ckpt_job_t* job) {
+    pthread_mutex_lock(&job->status_lock);
+    bool failed = (job->status != GPUIO_SUCCESS);
+    pthread_mutex_unlock(&job->status_lock);
+    return failed;
+}
+
+/* Sleep until the job is back under its bandwidth budget */
+static void ckpt_throttle(ckpt_job_t* job, size_t len) {
+    if (job->bandwidth == 0) return;
+    
+    uint64_t done = __sync_add_and_fetch(&job->bytes_written, len);
+    uint64_t due_us = (uint64_t)((double)done * 1e6 / (double)job->bandwidth);
+    uint64_t elapsed = gpuio_get_time_us() - job->start_us;
+    if (due_us > elapsed) usleep((useconds_t)(due_us - elapsed));
+}
+
+/* Staging buffer writer for one shard */
+typedef struct {
+    ckpt_job_t* job;
+    int fd;
+    char* staging;
+    size_t io_size;
+    size_t fill;
+    uint64_t base;               /* File offset of staging[0] */
+} ckpt_writer_t;
+
+static int ckpt_writer_flush(ckpt_writer_t* w) {
+    if (w->fill == 0) return 0;
+    
+    /* Direct IO needs aligned lengths; the tail is truncated afterwards */
+    size_t len = gpuio_align_up(w->fill, CKPT_ALIGN);
+    if (len > w->fill) memset(w->staging + w->fill, 0, len - w->fill);
+    
+    if (ckpt_pwrite_full(w->fd, w->staging, len, (off_t)w->base) != 0) {
+        return -1;
+    }
+    ckpt_throttle(w->job, len);
+    
+    w->base += w->fill;
+    w->fill = 0;
+    return 0;
+}
+
+/*
+ * Continue writing at file offset pos. Skipped ranges stay holes. Seek
+ * targets are CKPT_ALIGN-aligned except at a tensor's end, which is only
+ * ever followed by another seek, so every flush starts aligned.
+ */
+static int ckpt_writer_seek(ckpt_writer_t* w, uint64_t pos) {
+    if (w->base + w->fill == pos) return 0;
+    if (ckpt_writer_flush(w) != 0) return -1;
+    w->base = pos;
+    return 0;
+}
+
+/*
+ * Copy one block (at most io_size bytes) from tensor memory, which may be on
+ * the device, into staging at the write position and return it there. It is
+ * only written once ckpt_writer_commit() takes it.
+ */
+static char* ckpt_writer_stage(ckpt_writer_t* w, ckpt_job_t* job, const void* src,
+                               size_t len) {
+    if (len > w->io_size - w->fill && ckpt_writer_flush(w) != 0) return NULL;
+    
+    char* dst = w->staging + w->fill;
+    if (gpuio_memcpy(job->ctx, dst, src, len, job->stream) != GPUIO_SUCCESS) {
+        return NULL;
+    }
+    return dst;
+}
+
+static int ckpt_writer_commit(ckpt_writer_t* w, size_t len) {
+    w->fill += len;
+    if (w->fill == w->io_size && ckpt_writer_flush(w) != 0) return -1;
+    return 0;
+}
+
+static gpuio_error_t ckpt_save_shard(ckpt_job_t* job, uint32_t shard,
+                                     char* staging) {
+    ai_ckpt_manifest_t* m = job->manifest;
+    ai_ckpt_shard_desc_t* sd = &m->shards[shard];
+    const ai_ckpt_manifest_t* parent = job->num_refs ? &job->refs[0] : NULL;
+    
+    char path[PATH_MAX];
+    if (ckpt_shard_path(path, sizeof(path), job->dir, sd->path) != 0) {
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    int fd = ckpt_open(path, O_WRONLY | O_CREAT | O_TRUNC, job->direct_io);
+    if (fd < 0) {
+        AI_LOG_ERROR(job->ckpt->ai_ctx, "Checkpoint: cannot create %s: %s",
+                     path, strerror(errno));
+        return GPUIO_ERROR_IO;
+    }
+    
+    ckpt_writer_t w = {
+        .job = job,
+        .fd = fd,
+        .staging = staging,
+        .io_size = job->io_size,
+    };
+    
+    uint64_t stored = 0;
+    for (uint32_t i = 0; i < job->shard_counts[shard]; i++) {
+        ai_ckpt_tensor_desc_t* t = &m->tensors[job->shard_items[shard][i]];
+        const char* src = job->buffers[job->shard_items[shard][i]];
+        const ai_ckpt_tensor_desc_t* pt = parent ?
+            ckpt_find_tensor(parent, job->ref_by_name[0], t->name) : NULL;
+        
+        for (uint32_t b = 0; b < t->num_blocks; b++) {
+            uint64_t off = (uint64_t)b * CKPT_HASH_BLOCK;
+            size_t len = ai_ckpt_block_len(t->size, b);
+            
+            /* Hash the staged copy: src may be device memory */
+            const char* block = NULL;
+            if (ckpt_writer_seek(&w, t->offset + off) != 0 ||
+                !(block = ckpt_writer_stage(&w, job, src + off, len))) {
+                close(fd);
+                return GPUIO_ERROR_IO;
+            }
+            uint64_t h = gpuio_hash_bytes(block, len, CKPT_HASH_SEED);
+            t->blocks[b].hash = h;
+            
+            /* Unchanged since the parent: reference it, unless too deep.
+             * The staged copy is overwritten by whatever comes next. */
+            if (pt && b < pt->num_blocks &&
+                ai_ckpt_block_len(pt->size, b) == len &&
+                pt->blocks[b].hash == h &&
+                pt->blocks[b].depth < m->num_ancestors) {
+                t->blocks[b].depth = pt->blocks[b].depth + 1;
+                continue;
+            }
+            
+            t->blocks[b].depth = 0;
+            if (ckpt_writer_commit(&w, len) != 0) {
+                close(fd);
+                return GPUIO_ERROR_IO;
+            }
+            stored += len;
+        }
+    }
+    
+    if (ckpt_writer_flush(&w) != 0 ||
+        ftruncate(fd, (off_t)sd->size) != 0 ||
+        fsync(fd) != 0) {
+        close(fd);
+        return GPUIO_ERROR_IO;
+    }
+    
+    close(fd);
+    __sync_fetch_and_add(&m->stored_bytes, stored);
+    return GPUIO_SUCCESS;
+}
+
+/* Open file cache for reads from ancestor shards */
+typedef struct {
+    int fd;
+    char path[PATH_MAX];
+} ckpt_src_t;
+
+static int ckpt_src_open(ckpt_src_t* src, const char* path, bool direct_io) {
+    if (src->fd >= 0 && strcmp(src->path, path) == 0) return src->fd;
+    
+    if (src->fd >= 0) close(src->fd);
+    src->fd = ckpt_open(path, O_RDONLY, direct_io);
+    snprintf(src->path, sizeof(src->path), "%s", path);
+    return src->fd;
+}
+
+/*
+ * Read blocks [first, last) of tensor t from fd, where the tensor's data
+ * starts at file offset base, verifying each block hash.
+ */
+static gpuio_error_t ckpt_read_run(ckpt_job_t* job, int fd, uint64_t base,
+                                   const ai_ckpt_tensor_desc_t* t, char* dst,
+                                   uint32_t first, uint32_t last, char* staging) {
+    uint64_t pos = (uint64_t)first * CKPT_HASH_BLOCK;
+    uint64_t end = (uint64_t)last * CKPT_HASH_BLOCK;
+    if (end > t->size) end = t->size;
+    
+    while (pos < end) {
+        size_t want = job->io_size;
+        if (want > end - pos) want = (size_t)(end - pos);
+        
+        ssize_t n = ckpt_pread_full(fd, staging, gpuio_align_up(want, CKPT_ALIGN),
+                                    (off_t)(base + pos));
+        if (n < (ssize_t)want) return GPUIO_ERROR_IO;
+        
+        /* io_size is a multiple of the block size, so chunks hold whole blocks */
+        for (size_t off = 0; off < want; off += CKPT_HASH_BLOCK) {
+            uint32_t b = (uint32_t)((pos + off) / CKPT_HASH_BLOCK);
+            size_t len = ai_ckpt_block_len(t->size, b);
+            if (gpuio_hash_bytes(staging + off, len, CKPT_HASH_SEED) !=
+                t->blocks[b].hash) {
+                AI_LOG_ERROR(job->ckpt->ai_ctx,
+                             "Checkpoint: tensor '%s' block %u hash mismatch",
+                             t->name, b);
+                return GPUIO_ERROR_IO;
+            }
+        }
+        
+        gpuio_memcpy(job->ctx, dst + pos, staging, want, job->stream);
+        pos += want;
+    }
+    
+    return GPUIO_SUCCESS;
+}
+
+static gpuio_error_t ckpt_load_shard(ckpt_job_t* job, uint32_t shard,
+                                     char* staging) {
+    ai_ckpt_manifest_t* m = job->manifest;
+    ai_ckpt_shard_desc_t* sd = &m->shards[shard];
+    
+    char path[PATH_MAX];
+    if (ckpt_shard_path(path, sizeof(path), job->dir, sd->path) != 0) {
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    int fd = ckpt_open(path, O_RDONLY, job->direct_io);
+    if (fd < 0) {
+        AI_LOG_ERROR(job->ckpt->ai_ctx, "Checkpoint: cannot open %s: %s",
+                     path, strerror(errno));
+        return GPUIO_ERROR_NOT_FOUND;
+    }
+    
+    ckpt_src_t src = { .fd = -1 };
+    gpuio_error_t err = GPUIO_SUCCESS;
+    
+    for (uint32_t i = 0; i < job->shard_counts[shard] && err == GPUIO_SUCCESS; i++) {
+        uint32_t ti = job->shard_items[shard][i];
+        ai_ckpt_tensor_desc_t* t = &m->tensors[ti];
+        char* dst = job->buffers[ti];
+        if (!dst) continue;
+        
+        /* Runs of consecutive blocks living in the same checkpoint */
+        uint32_t b = 0;
+        while (b < t->num_blocks && err == GPUIO_SUCCESS) {
+            uint16_t depth = t->blocks[b].depth;
+            uint32_t e = b + 1;
+            while (e < t->num_blocks && t->blocks[e].depth == depth) e++;
+            
+            if (depth == 0) {
+                err = ckpt_read_run(job, fd, t->offset, t, dst, b, e, staging);
+                b = e;
+                continue;
+            }
+            
+            const ai_ckpt_manifest_t* anc = &job->refs[depth - 1];
+            const ai_ckpt_tensor_desc_t* at =
+                ckpt_find_tensor(anc, job->ref_by_name[depth - 1], t->name);
+            char anc_path[PATH_MAX];
+            
+            if (!at || (uint64_t)(e - 1) * CKPT_HASH_BLOCK >= at->size ||
+                ckpt_shard_path(anc_path, sizeof(anc_path),
+                                m->ancestors[depth - 1].path,
+                                anc->shards[at->shard].path) != 0) {
+                AI_LOG_ERROR(job->ckpt->ai_ctx,
+                             "Checkpoint: tensor '%s' missing from ancestor %s",
+                             t->name, m->ancestors[depth - 1].path);
+                err = GPUIO_ERROR_NOT_FOUND;
+                break;
+            }
+            
+            int afd = ckpt_src_open(&src, anc_path, job->direct_io);
+            if (afd < 0) {
+                err = GPUIO_ERROR_NOT_FOUND;
+                break;
+            }
+            
+            err = ckpt_read_run(job, afd, at->offset, t, dst, b, e, staging);
+            b = e;
+        }
+    }
+    
+    if (src.fd >= 0) close(src.fd);
+    close(fd);
+    return err;
+}
+
+/*
+ * Check that every block a load will read can be reached before anything
+ * is copied into the tensors, so a broken chain leaves them untouched.
+ */
+static gpuio_error_t ckpt_load_validate(ckpt_job_t* job) {
+    ai_ckpt_manifest_t* m = job->manifest;
+    
+    for (uint32_t ti = 0; ti < m->num_tensors; ti++) {
+        const ai_ckpt_tensor_desc_t* t = &m->tensors[ti];
+        if (!job->buffers[ti]) continue;
+        
+        uint32_t b = 0;
+        while (b < t->num_blocks) {
+            uint16_t depth = t->blocks[b].depth;
+            uint32_t e = b + 1;
+            while (e < t->num_blocks && t->blocks[e].depth == depth) e++;
+            
+            const char* dir = job->dir;
+            const ai_ckpt_manifest_t* src = m;
+            const ai_ckpt_tensor_desc_t* st = t;
+            if (depth > 0) {
+                if (depth > job->num_refs) return GPUIO_ERROR_NOT_FOUND;
+                dir = m->ancestors[depth - 1].path;
+                src = &job->refs[depth - 1];
+                st = ckpt_find_tensor(src, job->ref_by_name[depth - 1], t->name);
+            }
+            
+            uint64_t end = (uint64_t)e * CKPT_HASH_BLOCK;
+            if (end > t->size) end = t->size;
+            
+            char path[PATH_MAX];
+            struct stat sb;
+            if (!st || end > st->size || st->shard >= src->num_shards ||
+                ckpt_shard_path(path, sizeof(path), dir,
+                                src->shards[st->shard].path) != 0 ||
+                stat(path, &sb) != 0 ||
+                (uint64_t)sb.st_size < st->offset + end) {
+                AI_LOG_ERROR(job->ckpt->ai_ctx,
+                             "Checkpoint: tensor '%s' blocks %u-%u unreachable in %s",
+                             t->name, b, e - 1, dir);
+                return GPUIO_ERROR_NOT_FOUND;
+            }
+            b = e;
+        }
+    }
+    
+    return GPUIO_SUCCESS;
+}
+
+static void* ckpt_io_thread(void* arg) {
+    ckpt_job_t* job = (ckpt_job_t*)arg;
+    
+    char* staging = NULL;
+    if (posix_memalign((void**)&staging, CKPT_ALIGN, job->io_size) != 0) {
+        ckpt_job_fail(job, GPUIO_ERROR_NOMEM);
+        return NULL;
+    }
+    
+    /* Register the staging buffer so vendor backends can pin it */
+    gpuio_memory_region_t region;
+    bool registered = gpuio_register_memory(job->ctx, staging, job->io_size,
+                                            GPUIO_MEM_READ_WRITE,
+                                            &region) == GPUIO_SUCCESS;
+    
+    while (!ckpt_job_failed(job)) {
+        int shard = __sync_fetch_and_add(&job->next_shard, 1);
+        if (shard >= (int)job->manifest->num_shards) break;
+        
+        gpuio_error_t err = job->load ?
+            ckpt_load_shard(job, (uint32_t)shard, staging) :
+            ckpt_save_shard(job, (uint32_t)shard, staging);
+        if (err != GPUIO_SUCCESS) ckpt_job_fail(job, err);
+    }
+    
+    if (registered) gpuio_unregister_memory(job->ctx, &region);
+    free(staging);
+    return NULL;
+}
+
+static gpuio_error_t ckpt_run_job(ckpt_job_t* job, int num_threads) {
+    pthread_t threads[CKPT_MAX_THREADS];
+    int started = 0;
+    
+    if (num_threads > (int)job->manifest->num_shards) {
+        num_threads = (int)job->manifest->num_shards;
+    }
+    if (num_threads > CKPT_MAX_THREADS) num_threads = CKPT_MAX_THREADS;
+    
+    for (int i = 0; i < num_threads; i++) {
+        if (pthread_create(&threads[started], NULL, ckpt_io_thread, job) == 0) {
+            started++;
+        }
+    }
+    
+    /* No threads at all: do the work inline */
+    if (started == 0) {
+        ckpt_io_thread(job);
+    }
+    
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    return job->status;
+}
+
+/* refs (may be NULL) stays owned by the caller and must outlive the job */
+static gpuio_error_t ckpt_job_init(ckpt_job_t* job, struct ai_checkpoint* ckpt,
+                                   const gpuio_checkpoint_config_t* config,
+                                   const char* dir, ai_ckpt_manifest_t* m,
+                                   ai_ckpt_manifest_t* refs, uint32_t num_refs,
+                                   bool load, gpuio_stream_t stream) {
+    memset(job, 0, sizeof(*job));
+    job->ckpt = ckpt;
+    job->ctx = ai_context_get_base(ckpt->ai_ctx);
+    job->stream = stream;
+    job->dir = dir;
+    job->manifest = m;
+    job->load = load;
+    job->io_size = config->io_size;
+    job->direct_io = config->direct_io;
+    job->start_us = gpuio_get_time_us();
+    job->status = GPUIO_SUCCESS;
+    pthread_mutex_init(&job->status_lock, NULL);
+    
+    uint32_t num_shards = m->num_shards ? m->num_shards : 1;
+    job->shard_items = calloc(num_shards, sizeof(uint32_t*));
+    job->shard_counts = calloc(num_shards, sizeof(uint32_t));
+    job->buffers = calloc(m->num_tensors ? m->num_tensors : 1, sizeof(void*));
+    if (!job->shard_items || !job->shard_counts || !job->buffers) {
+        return GPUIO_ERROR_NOMEM;
+    }
+    
+    if (num_refs > 0) {
+        job->ref_by_name = calloc(num_refs, sizeof(uint32_t*));
+        if (!job->ref_by_name) return GPUIO_ERROR_NOMEM;
+        job->refs = refs;
+        job->num_refs = num_refs;
+        for (uint32_t r = 0; r < num_refs; r++) {
+            job->ref_by_name[r] = ckpt_index_by_name(&refs[r]);
+            if (!job->ref_by_name[r]) return GPUIO_ERROR_NOMEM;
+        }
+    }
+    
+    for (uint32_t i = 0; i < m->num_tensors; i++) {
+        job->shard_counts[m->tensors[i].shard]++;
+    }
+    for (uint32_t s = 0; s < m->num_shards; s++) {
+        job->shard_items[s] = malloc((job->shard_counts[s] ? job->shard_counts[s] : 1) *
+                                     sizeof(uint32_t));
+        if (!job->shard_items[s]) return GPUIO_ERROR_NOMEM;
+        job->shard_counts[s] = 0;
+    }
+    for (uint32_t i = 0; i < m->num_tensors; i++) {
+        uint32_t s = m->tensors[i].shard;
+        job->shard_items[s][job->shard_counts[s]++] = i;
+    }
+    
+    for (uint32_t s = 0; s < m->num_shards; s++) {
+        qsort_r(job->shard_items[s], job->shard_counts[s], sizeof(uint32_t),
+                ckpt_cmp_offset, (void*)m);
+    }
+    
+    return GPUIO_SUCCESS;
+}
+
+static void ckpt_job_cleanup(ckpt_job_t* job) {
+    if (job->shard_items && job->manifest) {
+        for (uint32_t s = 0; s < job->manifest->num_shards; s++) {
+            free(job->shard_items[s]);
+        }
+    }
+    if (job->ref_by_name) {
+        for (uint32_t r = 0; r < job->num_refs; r++) {
+            free(job->ref_by_name[r]);
+        }
+    }
+    free(job->ref_by_name);
+    free(job->shard_items);
+    free(job->shard_counts);
+    free(job->buffers);
+    pthread_mutex_destroy(&job->status_lock);
+}
+
+/* ============================================================================
+ * Subsystem Lifecycle
+ * ============================================================================ */
+
+static gpuio_error_t ckpt_restore_wait(struct ai_checkpoint* ckpt, int timeout_ms);
+static void ckpt_restore_free(ai_ckpt_restore_t* r);
+
+int ai_checkpoint_init(struct ai_checkpoint* ckpt, gpuio_ai_context_t ai_ctx) {
+    if (!ckpt) return -1;
+    
+    memset(ckpt, 0, sizeof(*ckpt));
+    ckpt->ai_ctx = ai_ctx;
+    ckpt->config.num_shards = CKPT_DEFAULT_SHARDS;
+    ckpt->config.num_threads = CKPT_DEFAULT_SHARDS;
+    ckpt->config.io_size = CKPT_DEFAULT_IO_SIZE;
+    ckpt->config.direct_io = true;
+    
+    ckpt->async_status = GPUIO_SUCCESS;
+    ckpt->restore_status = GPUIO_SUCCESS;
+    
+    pthread_mutex_init(&ckpt->lock, NULL);
+    pthread_mutex_init(&ckpt->stats_lock, NULL);
+    pthread_mutex_init(&ckpt->async_lock, NULL);
+    pthread_cond_init(&ckpt->async_cond, NULL);
+    
+    return 0;
+}
+
+static void ckpt_free_shard_dirs(gpuio_checkpoint_config_t* config) {
+    if (config->shard_dirs) {
+        for (int i = 0; i < config->num_shard_dirs; i++) {
+            free((char*)config->shard_dirs[i]);
+        }
+        free((void*)config->shard_dirs);
+    }
+    config->shard_dirs = NULL;
+    config->num_shard_dirs = 0;
+}
+
+void ai_checkpoint_cleanup(struct ai_checkpoint* ckpt) {
+    if (!ckpt) return;
+    
+    /* Let an in-flight async save commit, then stop the writer */
+    pthread_mutex_lock(&ckpt->async_lock);
+    while (ckpt->pending) {
+        pthread_cond_wait(&ckpt->async_cond, &ckpt->async_lock);
+    }
+    ckpt->shutdown = true;
+    pthread_cond_broadcast(&ckpt->async_cond);
+    pthread_mutex_unlock(&ckpt->async_lock);
+    
+    if (ckpt->writer_started) {
+        pthread_join(ckpt->writer, NULL);
+        ckpt->writer_started = false;
+    }
+    
+    if (ckpt->pool_registered) {
+        gpuio_unregister_memory(ai_context_get_base(ckpt->ai_ctx),
+                                &ckpt->pool_region);
+    }
+    free(ckpt->pool);
+    ckpt->pool = NULL;
+    ckpt->pool_size = 0;
+    
+    pthread_mutex_lock(&ckpt->lock);
+    ckpt_restore_wait(ckpt, -1);
+    ckpt_restore_free(ckpt->restored);
+    ckpt->restored = NULL;
+    for (int i = 0; i < ckpt->num_tensors; i++) {
+        free(ckpt->tensors[i].name);
+    }
+    free(ckpt->tensors);
+    ckpt->tensors = NULL;
+    ckpt->num_tensors = 0;
+    ckpt_free_shard_dirs(&ckpt->config);
+    pthread_mutex_unlock(&ckpt->lock);
+    
+    pthread_mutex_destroy(&ckpt->lock);
+    pthread_mutex_destroy(&ckpt->stats_lock);
+    pthread_mutex_destroy(&ckpt->async_lock);
+    pthread_cond_destroy(&ckpt->async_cond);
+}
+
+static struct ai_checkpoint* ckpt_from_ctx(gpuio_ai_context_t ai_ctx) {
+    if (ai_context_validate(ai_ctx, false, false, false) != GPUIO_SUCCESS) {
+        return NULL;
+    }
+    return ((struct gpuio_ai_context*)ai_ctx)->checkpoint;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+/**
+ * @brief Configure shard count, IO threads, IO size and shard placement.
+ *
+ * @param ai_ctx AI context
+ * @param config Checkpoint configuration; zero fields keep defaults
+ * @return GPUIO_SUCCESS on success, error code otherwise
+ */
+gpuio_error_t gpuio_ai_checkpoint_configure(gpuio_ai_context_t ai_ctx,
+                                             const gpuio_checkpoint_config_t* config) {
+    struct ai_checkpoint* ckpt = ckpt_from_ctx(ai_ctx);
+    if (!ckpt || !config) return GPUIO_ERROR_INVALID_ARG;
+    
+    if (config->num_shards < 0 || config->num_shards > CKPT_MAX_SHARDS ||
+        config->num_threads < 0 || config->num_shard_dirs < 0 ||
+        (config->num_shard_dirs > 0 && !config->shard_dirs)) {
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    const char** dirs = NULL;
+    if (config->num_shard_dirs > 0) {
+        dirs = calloc(config->num_shard_dirs, sizeof(char*));
+        if (!dirs) return GPUIO_ERROR_NOMEM;
+        
+        for (int i = 0; i < config->num_shard_dirs; i++) {
+            dirs[i] = config->shard_dirs[i] ? strdup(config->shard_dirs[i]) : NULL;
+            if (!dirs[i]) {
+                for (int j = 0; j < i; j++) free((char*)dirs[j]);
+                free((void*)dirs);
+                return config->shard_dirs[i] ? GPUIO_ERROR_NOMEM :
+                                               GPUIO_ERROR_INVALID_ARG;
+            }
+        }
+    }
+    
+    pthread_mutex_lock(&ckpt->lock);
+    
+    ckpt_free_shard_dirs(&ckpt->config);
+    
+    ckpt->config.num_shards = config->num_shards ? config->num_shards :
+                                                   CKPT_DEFAULT_SHARDS;
+    ckpt->config.num_threads = config->num_threads ? config->num_threads :
+                                                     ckpt->config.num_shards;
+    ckpt->config.io_size = gpuio_align_up(config->io_size ? config->io_size :
+                                          CKPT_DEFAULT_IO_SIZE,
+                                          CKPT_HASH_BLOCK);
+    ckpt->config.direct_io = config->direct_io;
+    ckpt->config.async_bandwidth = config->async_bandwidth;
+    ckpt->config.shard_dirs = dirs;
+    ckpt->config.num_shard_dirs = config->num_shard_dirs;
+    
+    pthread_mutex_unlock(&ckpt->lock);
+    
+    return GPUIO_SUCCESS;
+}
+
+/**
+ * @brief Register a tensor to be included in checkpoints.
+ *
+ * @param ai_ctx AI context
+ * @param name Unique tensor name
+ * @param data Tensor memory (must remain valid until unregistered)
+ * @param size Tensor size in bytes
+ * @return GPUIO_SUCCESS on success, error code otherwise
+ */
+gpuio_error_t gpuio_ai_checkpoint_register_tensor(gpuio_ai_context_t ai_ctx,
+                                                   const char* name,
+                                                   void* data,
+                                                   size_t size) {
+    struct ai_checkpoint* ckpt = ckpt_from_ctx(ai_ctx);
+    if (!ckpt || !name || !data || size == 0 ||
+        strlen(name) >= CKPT_MAX_NAME) {
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    pthread_mutex_lock(&ckpt->lock);
+    
+    for (int i = 0; i < ckpt->num_tensors; i++) {
+        if (strcmp(ckpt->tensors[i].name, name) == 0) {
+            pthread_mutex_unlock(&ckpt->lock);
+            return GPUIO_ERROR_ALREADY_INITIALIZED;
+        }
+    }
+    
+    if (ckpt->num_tensors == ckpt->tensors_capacity) {
+        int cap = ckpt->tensors_capacity ? ckpt->tensors_capacity * 2 : 64;
+        ai_ckpt_tensor_t* tensors = realloc(ckpt->tensors,
+                                            cap * sizeof(ai_ckpt_tensor_t));
+        if (!tensors) {
+            pthread_mutex_unlock(&ckpt->lock);
+            return GPUIO_ERROR_NOMEM;
+        }
+        ckpt->tensors = tensors;
+        ckpt->tensors_capacity = cap;
+    }
+    
+    ai_ckpt_tensor_t* t = &ckpt->tensors[ckpt->num_tensors];
+    t->name = strdup(name);
+    if (!t->name) {
+        pthread_mutex_unlock(&ckpt->lock);
+        return GPUIO_ERROR_NOMEM;
+    }
+    t->data = data;
+    t->size = size;
+    ckpt->num_tensors++;
+    
+    pthread_mutex_unlock(&ckpt->lock);
+    
+    return GPUIO_SUCCESS;
+}
+
+/**
+ * @brief Remove a tensor from future checkpoints.
+ *
+ * @param ai_ctx AI context
+ * @param name Tensor name
+ * @return GPUIO_SUCCESS on success, GPUIO_ERROR_NOT_FOUND if not registered
+ */
+gpuio_error_t gpuio_ai_checkpoint_unregister_tensor(gpuio_ai_context_t ai_ctx,
+                                                     const char* name) {
+    struct ai_checkpoint* ckpt = ckpt_from_ctx(ai_ctx);
+    if (!ckpt || !name) return GPUIO_ERROR_INVALID_ARG;
+    
+    pthread_mutex_lock(&ckpt->lock);
+    
+    /* A lazy restore may still be writing into the tensor */
+    ckpt_restore_wait(ckpt, -1);
+    
+    for (int i = 0; i < ckpt->num_tensors; i++) {
+        if (strcmp(ckpt->tensors[i].name, name) == 0) {
+            free(ckpt->tensors[i].name);
+            ckpt->tensors[i] = ckpt->tensors[--ckpt->num_tensors];
+            pthread_mutex_unlock(&ckpt->lock);
+            return GPUIO_SUCCESS;
+        }
+    }
+    
+    pthread_mutex_unlock(&ckpt->lock);
+    return GPUIO_ERROR_NOT_FOUND;
+}
+
+/* Largest tensors first, so greedy placement balances shard sizes; arg is
+ * the checkpoint's tensor array */
+static int ckpt_cmp_size_desc(const void* a, const void* b, void* arg) {
+    const ai_ckpt_tensor_t* tensors = arg;
+    size_t sa = tensors[*(const uint32_t*)a].size;
+    size_t sb = tensors[*(const uint32_t*)b].size;
+    if (sa != sb) return (sa < sb) ? 1 : -1;
+    return (*(const uint32_t*)a > *(const uint32_t*)b) -
+           (*(const uint32_t*)a < *(const uint32_t*)b);
+}
+
+/*
+ * Build the new manifest layout from the registered tensors. For an
+ * incremental save, parent/parent_dir give the checkpoint to diff against;
+ * its own ancestors are inherited, up to CKPT_MAX_CHAIN.
+ */
+static gpuio_error_t ckpt_plan(struct ai_checkpoint* ckpt, uint64_t prev_id,
+                               const ai_ckpt_manifest_t* parent,
+                               const char* parent_dir,
+                               ai_ckpt_manifest_t* m) {
+    int num_tensors = ckpt->num_tensors;
+    uint32_t num_shards = (uint32_t)ckpt->config.num_shards;
+    if (num_tensors > 0 && num_shards > (uint32_t)num_tensors) {
+        num_shards = (uint32_t)num_tensors;
+    }
+    if (num_shards == 0) num_shards = 1;
+    
+    memset(m, 0, sizeof(*m));
+    m->shards = calloc(num_shards, sizeof(ai_ckpt_shard_desc_t));
+    m->tensors = calloc(num_tensors ? num_tensors : 1,
+                        sizeof(ai_ckpt_tensor_desc_t));
+    uint32_t* order = malloc((num_tensors ? num_tensors : 1) * sizeof(uint32_t));
+    if (!m->shards || !m->tensors || !order) {
+        free(order);
+        ai_ckpt_manifest_free(m);
+        return GPUIO_ERROR_NOMEM;
+    }
+    
+    /* Unique per save, so a new generation never overwrites live shards */
+    uint64_t id = gpuio_get_time_us();
+    if (id <= prev_id) id = prev_id + 1;
+    m->checkpoint_id = id;
+    m->num_shards = num_shards;
+    m->num_tensors = (uint32_t)num_tensors;
+    
+    if (parent) {
+        uint32_t n = parent->num_ancestors + 1;
+        if (n > CKPT_MAX_CHAIN) n = CKPT_MAX_CHAIN;
+        
+        m->ancestors = calloc(n, sizeof(ai_ckpt_ancestor_t));
+        if (!m->ancestors) {
+            free(order);
+            ai_ckpt_manifest_free(m);
+            return GPUIO_ERROR_NOMEM;
+        }
+        m->num_ancestors = n;
+        
+        m->ancestors[0].path = strdup(parent_dir);
+        m->ancestors[0].checkpoint_id = parent->checkpoint_id;
+        for (uint32_t a = 1; a < n; a++) {
+            m->ancestors[a].path = strdup(parent->ancestors[a - 1].path);
+            m->ancestors[a].checkpoint_id = parent->ancestors[a - 1].checkpoint_id;
+        }
+        for (uint32_t a = 0; a < n; a++) {
+            if (!m->ancestors[a].path) {
+                free(order);
+                ai_ckpt_manifest_free(m);
+                return GPUIO_ERROR_NOMEM;
+            }
+        }
+    }
+    
+    for (uint32_t s = 0; s < num_shards; s++) {
+        char name[64];
+        char path[PATH_MAX];
+        snprintf(name, sizeof(name), "shard_%016llx_%05u.bin",
+                 (unsigned long long)id, s);
+        
+        if (ckpt->config.num_shard_dirs > 0) {
+            const char* sdir = ckpt->config.shard_dirs[s % ckpt->config.num_shard_dirs];
+            char resolved[PATH_MAX];
+            if (ckpt_mkdirs(sdir) != 0 || !realpath(sdir, resolved) ||
+                ckpt_join(path, sizeof(path), resolved, name) != 0) {
+                free(order);
+                ai_ckpt_manifest_free(m);
+                return GPUIO_ERROR_IO;
+            }
+        } else {
+            snprintf(path, sizeof(path), "%s", name);
+        }
+        
+        m->shards[s].path = strdup(path);
+        if (!m->shards[s].path) {
+            free(order);
+            ai_ckpt_manifest_free(m);
+            return GPUIO_ERROR_NOMEM;
+        }
+    }
+    
+    for (int i = 0; i < num_tensors; i++) {
+        order[i] = (uint32_t)i;
+        m->tensors[i].name = strdup(ckpt->tensors[i].name);
+        m->tensors[i].size = ckpt->tensors[i].size;
+        m->tensors[i].num_blocks = ai_ckpt_num_blocks(ckpt->tensors[i].size);
+        m->tensors[i].blocks = calloc(m->tensors[i].num_blocks,
+                                      sizeof(ai_ckpt_block_t));
+        if (!m->tensors[i].name || !m->tensors[i].blocks) {
+            free(order);
+            ai_ckpt_manifest_free(m);
+            return GPUIO_ERROR_NOMEM;
+        }
+    }
+    
+    qsort_r(order, num_tensors, sizeof(uint32_t), ckpt_cmp_size_desc,
+            ckpt->tensors);
+    
+    for (int i = 0; i < num_tensors; i++) {
+        uint32_t best = 0;
+        for (uint32_t s = 1; s < num_shards; s++) {
+            if (m->shards[s].size < m->shards[best].size) best = s;
+        }
+        
+        ai_ckpt_tensor_desc_t* t = &m->tensors[order[i]];
+        t->shard = best;
+        t->offset = gpuio_align_up(m->shards[best].size, CKPT_ALIGN);
+        m->shards[best].size = t->offset + t->size;
+        m->total_bytes += t->size;
+    }
+    
+    free(order);
+    return GPUIO_SUCCESS;
+}
+
+static void ckpt_remove_shards(const char* dir, const ai_ckpt_manifest_t* m,
+                               const ai_ckpt_manifest_t* keep) {
+    for (uint32_t s = 0; s < m->num_shards; s++) {
+        bool live = false;
+        for (uint32_t k = 0; keep && k < keep->num_shards; k++) {
+            if (strcmp(m->shards[s].path, keep->shards[k].path) == 0) {
+                live = true;
+                break;
+            }
+        }
+        if (live) continue;
+        
+        char path[PATH_MAX];
+        if (ckpt_shard_path(path, sizeof(path), dir, m->shards[s].path) == 0) {
+            unlink(path);
+        }
+    }
+}
+
+static void ckpt_record(struct ai_checkpoint* ckpt, bool load, uint64_t bytes,
+                        uint64_t elapsed_us) {
+    double gbps = elapsed_us ? (double)bytes / (elapsed_us * 1e3) : 0.0;
+    
+    pthread_mutex_lock(&ckpt->stats_lock);
+    if (load) {
+        ckpt->stats.checkpoints_loaded++;
+        ckpt->stats.last_load_bytes = bytes;
+        ckpt->stats.last_load_time_us = elapsed_us;
+        ckpt->stats.last_load_gbps = gbps;
+    } else {
+        ckpt->stats.checkpoints_saved++;
+        ckpt->stats.last_save_bytes = bytes;
+        ckpt->stats.last_save_time_us = elapsed_us;
+        ckpt->stats.last_save_gbps = gbps;
+    }
+    pthread_mutex_unlock(&ckpt->stats_lock);
+    
+    ai_context_update_stats(ckpt->ai_ctx, 1, bytes);
+}
+
+/* Write shards and commit the manifest; consumes the manifests in p */
+static gpuio_error_t ckpt_persist(struct ai_checkpoint* ckpt, ai_ckpt_pending_t* p,
+                                  uint64_t bandwidth, gpuio_stream_t stream) {
+    ai_ckpt_manifest_t* m = &p->manifest;
+    
+    ckpt_job_t job;
+    gpuio_error_t err = ckpt_job_init(&job, ckpt, &p->config, p->path, m,
+                                      p->have_parent ? &p->parent : NULL,
+                                      p->have_parent ? 1 : 0, false, stream);
+    if (err == GPUIO_SUCCESS) {
+        memcpy(job.buffers, p->buffers, m->num_tensors * sizeof(void*));
+        job.bandwidth = bandwidth;
+        err = ckpt_run_job(&job, p->config.num_threads);
+    }
+    ckpt_job_cleanup(&job);
+    
+    if (err == GPUIO_SUCCESS) {
+        err = ai_ckpt_manifest_write(p->path, m);
+    }
+    
+    if (err == GPUIO_SUCCESS) {
+        /* Committed: the previous generation's shards are now garbage */
+        if (p->have_old) ckpt_remove_shards(p->path, &p->old, m);
+    } else {
+        ckpt_remove_shards(p->path, m, p->have_old ? &p->old : NULL);
+        AI_LOG_ERROR(ckpt->ai_ctx, "Checkpoint: save to %s failed (%d)",
+                     p->path, err);
+    }
+    
+    uint64_t bytes = m->total_bytes;
+    uint64_t stored = m->stored_bytes;
+    uint64_t elapsed = gpuio_get_time_us() - p->start_us;
+    
+    if (p->have_old) ai_ckpt_manifest_free(&p->old);
+    if (p->have_parent) ai_ckpt_manifest_free(&p->parent);
+    ai_ckpt_manifest_free(m);
+    p->have_old = false;
+    p->have_parent = false;
+    
+    if (err == GPUIO_SUCCESS) {
+        ckpt_record(ckpt, false, bytes, elapsed);
+        
+        pthread_mutex_lock(&ckpt->stats_lock);
+        ckpt->stats.last_save_stored_bytes = stored;
+        ckpt->stats.last_save_dedup_ratio = bytes ?
+            1.0 - (double)stored / (double)bytes : 0.0;
+        pthread_mutex_unlock(&ckpt->stats_lock);
+        
+        AI_LOG_INFO(ckpt->ai_ctx,
+                    "Checkpoint: saved %llu bytes (%llu stored) to %s in %llu us",
+                    (unsigned long long)bytes, (unsigned long long)stored,
+                    p->path, (unsigned long long)elapsed);
+    }
+    
+    return err;
+}
+
+/* ============================================================================
+ * Async Save
+ * ============================================================================ */
+
+/* Wait until no async save is in flight; returns the last async status */
+static gpuio_error_t ckpt_async_wait_idle(struct ai_checkpoint* ckpt,
+                                          int timeout_ms) {
+    struct timespec deadline;
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+    
+    pthread_mutex_lock(&ckpt->async_lock);
+    while (ckpt->pending) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&ckpt->async_cond, &ckpt->async_lock);
+        } else if (pthread_cond_timedwait(&ckpt->async_cond, &ckpt->async_lock,
+                                          &deadline) == ETIMEDOUT &&
+                   ckpt->pending) {
+            pthread_mutex_unlock(&ckpt->async_lock);
+            return GPUIO_ERROR_TIMEOUT;
+        }
+    }
+    gpuio_error_t err = ckpt->async_status;
+    pthread_mutex_unlock(&ckpt->async_lock);
+    
+    return err;
+}
+
+static void ckpt_pending_free(ai_ckpt_pending_t* p) {
+    if (!p) return;
+    free(p->path);
+    free(p->buffers);
+    free(p);
+}
+
+static void* ckpt_writer_thread(void* arg) {
+    struct ai_checkpoint* ckpt = (struct ai_checkpoint*)arg;
+    
+    pthread_mutex_lock(&ckpt->async_lock);
+    for (;;) {
+        while (!ckpt->pending && !ckpt->shutdown) {
+            pthread_cond_wait(&ckpt->async_cond, &ckpt->async_lock);
+        }
+        if (!ckpt->pending) break;
+        
+        ai_ckpt_pending_t* p = ckpt->pending;
+        gpuio_checkpoint_callback_t callback = ckpt->callback;
+        void* user_data = ckpt->callback_data;
+        pthread_mutex_unlock(&ckpt->async_lock);
+        
+        gpuio_error_t err = ckpt_persist(ckpt, p, p->config.async_bandwidth, NULL);
+        if (err != GPUIO_SUCCESS) {
+            pthread_mutex_lock(&ckpt->stats_lock);
+            ckpt->stats.async_failures++;
+            pthread_mutex_unlock(&ckpt->stats_lock);
+        }
+        
+        /* Run before pending clears, so wait() also covers the callback */
+        if (callback) callback(p->path, err, user_data);
+        
+        pthread_mutex_lock(&ckpt->async_lock);
+        ckpt->async_status = err;
+        ckpt->pending = NULL;
+        pthread_cond_broadcast(&ckpt->async_cond);
+        ckpt_pending_free(p);
+    }
+    pthread_mutex_unlock(&ckpt->async_lock);
+    
+    return NULL;
+}
+
+/* Grow the pinned snapshot pool; only called with no save in flight */
+static int ckpt_pool_reserve(struct ai_checkpoint* ckpt, size_t size) {
+    if (ckpt->pool_size >= size) return 0;
+    
+    gpuio_context_t ctx = ai_context_get_base(ckpt->ai_ctx);
+    if (ckpt->pool_registered) {
+        gpuio_unregister_memory(ctx, &ckpt->pool_region);
+        ckpt->pool_registered = false;
+    }
+    free(ckpt->pool);
+    ckpt->pool = NULL;
+    ckpt->pool_size = 0;
+    
+    char* pool = NULL;
+    if (posix_memalign((void**)&pool, CKPT_ALIGN, size) != 0) return -1;
+    
+    ckpt->pool = pool;
+    ckpt->pool_size = size;
+    ckpt->pool_registered = gpuio_register_memory(ctx, pool, size,
+                                                  GPUIO_MEM_READ_WRITE,
+                                                  &ckpt->pool_region) == GPUIO_SUCCESS;
+    return 0;
+}
+
+/*
+ * Copy the registered tensors into the pool and hand the save to the
+ * writer. On success the writer owns req (heap allocated); on failure the
+ * caller keeps it and may persist it synchronously instead.
+ */
+static gpuio_error_t ckpt_snapshot(struct ai_checkpoint* ckpt,
+                                   ai_ckpt_pending_t* req,
+                                   gpuio_stream_t stream) {
+    gpuio_context_t ctx = ai_context_get_base(ckpt->ai_ctx);
+    
+    size_t total = 0;
+    for (int i = 0; i < ckpt->num_tensors; i++) {
+        total = gpuio_align_up(total, CKPT_ALIGN) + ckpt->tensors[i].size;
+    }
+    total = gpuio_align_up(total ? total : 1, CKPT_ALIGN);
+    
+    if (ckpt_pool_reserve(ckpt, total) != 0) return GPUIO_ERROR_NOMEM;
+    
+    if (!ckpt->writer_started) {
+        if (pthread_create(&ckpt->writer, NULL, ckpt_writer_thread, ckpt) != 0) {
+            return GPUIO_ERROR_GENERAL;
+        }
+        ckpt->writer_started = true;
+    }
+    
+    size_t off = 0;
+    for (int i = 0; i < ckpt->num_tensors; i++) {
+        off = gpuio_align_up(off, CKPT_ALIGN);
+        req->buffers[i] = ckpt->pool + off;
+        gpuio_memcpy(ctx, req->buffers[i], ckpt->tensors[i].data,
+                     ckpt->tensors[i].size, stream);
+        off += ckpt->tensors[i].size;
+    }
+    gpuio_stream_synchronize(ctx, stream);
+    
+    pthread_mutex_lock(&ckpt->stats_lock);
+    ckpt->stats.async_saves++;
+    ckpt->stats.last_snapshot_time_us = gpuio_get_time_us() - req->start_us;
+    pthread_mutex_unlock(&ckpt->stats_lock);
+    
+    pthread_mutex_lock(&ckpt->async_lock);
+    ckpt->pending = req;
+    pthread_cond_broadcast(&ckpt->async_cond);
+    pthread_mutex_unlock(&ckpt->async_lock);
+    
+    return GPUIO_SUCCESS;
+}
+
+/* Save path shared by full and incremental saves; parent may be NULL */
+static gpuio_error_t ckpt_save(gpuio_ai_context_t ai_ctx, const char* path,
+                               const char* parent_path, bool async,
+                               gpuio_stream_t stream) {
+    struct ai_checkpoint* ckpt = ckpt_from_ctx(ai_ctx);
+    if (!ckpt || !path) return GPUIO_ERROR_INVALID_ARG;
+    
+    if (ckpt_mkdirs(path) != 0) {
+        AI_LOG_ERROR(ai_ctx, "Checkpoint: cannot create directory %s", path);
+        return GPUIO_ERROR_IO;
+    }
+    
+    /* Ancestors are recorded by absolute path; a chain cannot loop on itself */
+    char parent_dir[PATH_MAX];
+    char self_dir[PATH_MAX];
+    if (parent_path) {
+        if (!realpath(parent_path, parent_dir)) return GPUIO_ERROR_NOT_FOUND;
+        if (!realpath(path, self_dir) || strcmp(self_dir, parent_dir) == 0) {
+            return GPUIO_ERROR_INVALID_ARG;
+        }
+    }
+    
+    pthread_mutex_lock(&ckpt->lock);
+    
+    /* One save at a time; the previous async result is reported via wait() */
+    ckpt_async_wait_idle(ckpt, -1);
+    ckpt_restore_wait(ckpt, -1);
+    
+    ai_ckpt_pending_t* req = calloc(1, sizeof(ai_ckpt_pending_t));
+    if (req) {
+        req->path = strdup(path);
+        req->buffers = calloc(ckpt->num_tensors ? ckpt->num_tensors : 1,
+                              sizeof(void*));
+    }
+    if (!req || !req->path || !req->buffers) {
+        ckpt_pending_free(req);
+        pthread_mutex_unlock(&ckpt->lock);
+        return GPUIO_ERROR_NOMEM;
+    }
+    
+    req->start_us = gpuio_get_time_us();
+    req->config = ckpt->config;
+    req->config.shard_dirs = NULL;      /* Resolved into the manifest by the plan */
+    req->config.num_shard_dirs = 0;
+    
+    gpuio_error_t err = GPUIO_SUCCESS;
+    if (parent_path) {
+        err = ai_ckpt_manifest_read(parent_dir, &req->parent);
+        req->have_parent = (err == GPUIO_SUCCESS);
+        if (err != GPUIO_SUCCESS) {
+            AI_LOG_ERROR(ai_ctx, "Checkpoint: cannot read parent %s (%d)",
+                         parent_path, err);
+        }
+        
+        /* Overwriting any ancestor would delete shards the chain still reads */
+        for (uint32_t a = 0; req->have_parent &&
+                             a < req->parent.num_ancestors; a++) {
+            if (strcmp(req->parent.ancestors[a].path, self_dir) == 0) {
+                AI_LOG_ERROR(ai_ctx, "Checkpoint: %s is an ancestor of %s",
+                             path, parent_path);
+                err = GPUIO_ERROR_INVALID_ARG;
+                break;
+            }
+        }
+    }
+    
+    if (err == GPUIO_SUCCESS) {
+        req->have_old = (ai_ckpt_manifest_read(path, &req->old) == GPUIO_SUCCESS);
+        err = ckpt_plan(ckpt, req->have_old ? req->old.checkpoint_id : 0,
+                        req->have_parent ? &req->parent : NULL, parent_dir,
+                        &req->manifest);
+    }
+    
+    if (err != GPUIO_SUCCESS) {
+        if (req->have_old) ai_ckpt_manifest_free(&req->old);
+        if (req->have_parent) ai_ckpt_manifest_free(&req->parent);
+        ckpt_pending_free(req);
+        pthread_mutex_unlock(&ckpt->lock);
+        return err;
+    }
+    
+    if (async) {
+        err = ckpt_snapshot(ckpt, req, stream);
+        if (err == GPUIO_SUCCESS) {
+            pthread_mutex_unlock(&ckpt->lock);
+            return GPUIO_SUCCESS;
+        }
+        AI_LOG_WARN(ai_ctx, "Checkpoint: snapshot failed (%d), saving synchronously",
+                    err);
+    }
+    
+    for (int i = 0; i < ckpt->num_tensors; i++) {
+        req->buffers[i] = ckpt->tensors[i].data;
+    }
+    err = ckpt_persist(ckpt, req, 0, stream);
+    
+    ckpt_pending_free(req);
+    pthread_mutex_unlock(&ckpt->lock);
+    
+    return err;
+}
+
+/**
+ * @brief Save all registered tensors as a sharded checkpoint.
+ *
+ * With async = false the checkpoint is committed before returning. With
+ * async = true the tensors are copied into the pinned snapshot pool and
+ * the shards are written by the background writer; the caller only waits
+ * for the copy (and for a previous async save, if one is still running).
+ * If the snapshot cannot be taken the save falls back to synchronous.
+ *
+ * @param ai_ctx AI context
+ * @param path Checkpoint directory (created if missing)
+ * @param async Snapshot and persist in the background
+ * @param stream Stream used for tensor copies
+ * @return GPUIO_SUCCESS on success, error code otherwise
+ */
+gpuio_error_t gpuio_ai_checkpoint_save(gpuio_ai_context_t ai_ctx,
+                                        const char* path,
+                                        bool async,
+                                        gpuio_stream_t stream) {
+    return ckpt_save(ai_ctx, path, NULL, async, stream);
+}
+
+/**
+ * @brief Save an incremental checkpoint against a parent checkpoint.
+ *
+ * Blocks whose hash matches the parent's are not written; the manifest
+ * references the parent (and its ancestors) instead. The parent chain must
+ * stay on disk for as long as this checkpoint is loaded from.
+ *
+ * @param ai_ctx AI context
+ * @param path Checkpoint directory (created if missing; not the parent)
+ * @param parent_path Existing checkpoint directory to diff against
+ * @param async Snapshot and persist in the background
+ * @param stream Stream used for tensor copies
+ * @return GPUIO_SUCCESS on success, error code otherwise
+ */
+gpuio_error_t gpuio_ai_checkpoint_save_incremental(gpuio_ai_context_t ai_ctx,
+                                                    const char* path,
+                                                    const char* parent_path,
+                                                    bool async,
+                                                    gpuio_stream_t stream) {
+    if (!parent_path) return GPUIO_ERROR_INVALID_ARG;
+    return ckpt_save(ai_ctx, path, parent_path, async, stream);
+}
+
+/* Read the ancestor manifests; unreadable or reused ones are left empty */
+static ai_ckpt_manifest_t* ckpt_read_ancestors(gpuio_ai_context_t ai_ctx,
+                                               const ai_ckpt_manifest_t* m) {
+    (void)ai_ctx;                 /* Logging only */
+    
+    ai_ckpt_manifest_t* refs = calloc(m->num_ancestors ? m->num_ancestors : 1,
+                                      sizeof(ai_ckpt_manifest_t));
+    if (!refs) return NULL;
+    
+    for (uint32_t a = 0; a < m->num_ancestors; a++) {
+        const ai_ckpt_ancestor_t* anc = &m->ancestors[a];
+        if (ai_ckpt_manifest_read(anc->path, &refs[a]) != GPUIO_SUCCESS) {
+            AI_LOG_WARN(ai_ctx, "Checkpoint: ancestor %s unreadable",
+                        anc->path);
+        } else if (refs[a].checkpoint_id != anc->checkpoint_id) {
+            AI_LOG_WARN(ai_ctx, "Checkpoint: ancestor %s was overwritten",
+                        anc->path);
+            ai_ckpt_manifest_free(&refs[a]);
+        }
+    }
+    
+    return refs;
+}
+
+/**
+ * @brief Restore registered tensors from a checkpoint.
+ *
+ * Every registered tensor must be present in the checkpoint with the same
+ * size. Checkpoint tensors that are not registered are skipped. Blocks of
+ * an incremental checkpoint are read from the ancestor that stores them.
+ *
+ * @param ai_ctx AI context
+ * @param path Checkpoint directory
+ * @param stream Stream used for tensor copies
+ * @return GPUIO_SUCCESS on success, error code otherwise
+ */
+gpuio_error_t gpuio_ai_checkpoint_load(gpuio_ai_context_t ai_ctx,
+                                        const char* path,
+                                        gpuio_stream_t stream) {
+    struct ai_checkpoint* ckpt = ckpt_from_ctx(ai_ctx);
+    if (!ckpt || !path) return GPUIO_ERROR_INVALID_ARG;
+    
+    pthread_mutex_lock(&ckpt->lock);
+    uint64_t start = gpuio_get_time_us();
+    
+    /* An async save may still be rewriting this directory */
+    ckpt_async_wait_idle(ckpt, -1);
+    ckpt_restore_wait(ckpt, -1);
+    ckpt_restore_free(ckpt->restored);
+    ckpt->restored = NULL;
+    
+    ai_ckpt_manifest_t m;
+    gpuio_error_t err = ai_ckpt_manifest_read(path, &m);
+    if (err != GPUIO_SUCCESS) {
+        pthread_mutex_unlock(&ckpt->lock);
+        AI_LOG_ERROR(ai_ctx, "Checkpoint: cannot read manifest in %s (%d)",
+                     path, err);
+        return err;
+    }
+    
+    ai_ckpt_manifest_t* refs = ckpt_read_ancestors(ai_ctx, &m);
+    uint32_t num_refs = m.num_ancestors;
+    
+    ckpt_job_t job;
+    err = ckpt_job_init(&job, ckpt, &ckpt->config, path, &m, refs,
+                        refs ? num_refs : 0, true, stream);
+    if (err == GPUIO_SUCCESS && !refs) err = GPUIO_ERROR_NOMEM;
+    
+    uint32_t* by_name = NULL;
+    uint64_t bytes = 0;
+    
+    if (err == GPUIO_SUCCESS) {
+        by_name = ckpt_index_by_name(&m);
+        if (!by_name) err = GPUIO_ERROR_NOMEM;
+    }
+    
+    /* Match registered tensors to checkpoint entries */
+    for (int i = 0; i < ckpt->num_tensors && err == GPUIO_SUCCESS; i++) {
+        ai_ckpt_tensor_t* t = &ckpt->tensors[i];
+        ai_ckpt_tensor_desc_t* d = ckpt_find_tensor(&m, by_name, t->name);
+        
+        if (!d) {
+            AI_LOG_ERROR(ai_ctx, "Checkpoint: tensor '%s' not in %s",
+                         t->name, path);
+            err = GPUIO_ERROR_NOT_FOUND;
+        } else if (d->size != t->size) {
+            AI_LOG_ERROR(ai_ctx, "Checkpoint: tensor '%s' size mismatch",
+                         t->name);
+            err = GPUIO_ERROR_INVALID_ARG;
+        } else {
+            job.buffers[d - m.tensors] = t->data;
+            bytes += t->size;
+        }
+    }
+    
+    if (err == GPUIO_SUCCESS) err = ckpt_load_validate(&job);
+    if (err == GPUIO_SUCCESS) {
+        err = ckpt_run_job(&job, ckpt->config.num_threads);
+    }
+    
+    free(by_name);
+    ckpt_job_cleanup(&job);
+    if (refs) {
+        for (uint32_t a = 0; a < num_refs; a++) ai_ckpt_manifest_free(&refs[a]);
+        free(refs);
+    }
+    ai_ckpt_manifest_free(&m);
+    
+    uint64_t elapsed = gpuio_get_time_us() - start;
+    pthread_mutex_unlock(&ckpt->lock);
+    
+    if (err == GPUIO_SUCCESS) {
+        ckpt_record(ckpt, true, bytes, elapsed);
+        AI_LOG_INFO(ai_ctx, "Checkpoint: loaded %llu bytes from %s in %llu us",
+                    (unsigned long long)bytes, path,
+                    (unsigned long long)elapsed);
+    }
+    
+    return err;
+}
+
+/* ============================================================================
+ * Lazy Restore
+ * ============================================================================ */
+
+/* Drop the mappings and ancestors; the items and their index stay usable */
+static void ckpt_restore_release(ai_ckpt_restore_t* r) {
+    if (r->maps) {
+        for (uint32_t d = 0; d <= r->num_refs; d++) {
+            const ai_ckpt_manifest_t* md = d ? &r->refs[d - 1] : &r->manifest;
+            if (!r->maps[d]) continue;
+            for (uint32_t s = 0; s < md->num_shards; s++) {
+                if (r->maps[d][s].base) munmap(r->maps[d][s].base, r->maps[d][s].size);
+            }
+            free(r->maps[d]);
+        }
+        free(r->maps);
+    }
+    
+    if (r->ref_by_name) {
+        for (uint32_t d = 0; d < r->num_refs; d++) free(r->ref_by_name[d]);
+        free(r->ref_by_name);
+    }
+    if (r->refs) {
+        for (uint32_t d = 0; d < r->num_refs; d++) ai_ckpt_manifest_free(&r->refs[d]);
+        free(r->refs);
+    }
+    
+    r->maps = NULL;
+    r->ref_by_name = NULL;
+    r->refs = NULL;
+    r->num_refs = 0;
+}
+
+static void ckpt_restore_free(ai_ckpt_restore_t* r) {
+    if (!r) return;
+    
+    ckpt_restore_release(r);
+    free(r->items);
+    free(r->item_of);
+    free(r->by_name);
+    ai_ckpt_manifest_free(&r->manifest);
+    pthread_mutex_destroy(&r->lock);
+    pthread_cond_destroy(&r->cond);
+    free(r);
+}
+
+/* Map every shard of the checkpoint and its ancestors read-only */
+static gpuio_error_t ckpt_restore_map(ai_ckpt_restore_t* r, const char* path) {
+    r->maps = calloc(r->num_refs + 1, sizeof(ai_ckpt_map_t*));
+    if (!r->maps) return GPUIO_ERROR_NOMEM;
+    
+    for (uint32_t d = 0; d <= r->num_refs; d++) {
+        const ai_ckpt_manifest_t* md = d ? &r->refs[d - 1] : &r->manifest;
+        const char* dir = d ? r->manifest.ancestors[d - 1].path : path;
+        
+        r->maps[d] = calloc(md->num_shards ? md->num_shards : 1, sizeof(ai_ckpt_map_t));
+        if (!r->maps[d]) return GPUIO_ERROR_NOMEM;
+        
+        for (uint32_t s = 0; s < md->num_shards; s++) {
+            char shard_path[PATH_MAX];
+            if (md->shards[s].size == 0 ||
+                ckpt_shard_path(shard_path, sizeof(shard_path), dir,
+                                md->shards[s].path) != 0) {
+                continue;
+            }
+            
+            /* Missing files are reported by validation if actually needed */
+            int fd = open(shard_path, O_RDONLY);
+            if (fd < 0) continue;
+            
+            void* base = mmap(NULL, md->shards[s].size, PROT_READ, MAP_SHARED, fd, 0);
+            close(fd);
+            if (base == MAP_FAILED) continue;
+            
+            madvise(base, md->shards[s].size, MADV_SEQUENTIAL);
+            r->maps[d][s].base = base;
+            r->maps[d][s].size = md->shards[s].size;
+        }
+    }
+    
+    return GPUIO_SUCCESS;
+}
+
+/* Source of blocks [b, ...) of t: the tensor record and mapping holding them */
+static const ai_ckpt_tensor_desc_t* ckpt_restore_source(const ai_ckpt_restore_t* r,
+                                                        const ai_ckpt_tensor_desc_t* t,
+                                                        uint16_t depth,
+                                                        const ai_ckpt_map_t** map) {
+    const ai_ckpt_tensor_desc_t* st = t;
+    if (depth > 0) {
+        st = ckpt_find_tensor(&r->refs[depth - 1], r->ref_by_name[depth - 1], t->name);
+        if (!st) return NULL;
+    }
+    
+    *map = &r->maps[depth][st->shard];
+    return (*map)->base ? st : NULL;
+}
+
+/* Check up front that every block of every item can be reached */
+static gpuio_error_t ckpt_restore_validate(const ai_ckpt_restore_t* r) {
+    for (int i = 0; i < r->num_items; i++) {
+        const ai_ckpt_tensor_desc_t* t = r->items[i].desc;
+        
+        for (uint32_t b = 0; b < t->num_blocks; b++) {
+            const ai_ckpt_map_t* map;
+            const ai_ckpt_tensor_desc_t* st =
+                ckpt_restore_source(r, t, t->blocks[b].depth, &map);
+            
+            if (!st || st->offset + (uint64_t)b * CKPT_HASH_BLOCK +
+                       ai_ckpt_block_len(t->size, b) > map->size) {
+                return GPUIO_ERROR_NOT_FOUND;
+            }
+        }
+    }
+    
+    return GPUIO_SUCCESS;
+}
+
+/* Copy one tensor out of the mappings; page faults do the actual reads */
+static gpuio_error_t ckpt_restore_item(struct ai_checkpoint* ckpt,
+                                       const ai_ckpt_restore_t* r,
+                                       const ai_ckpt_restore_item_t* item) {
+    gpuio_context_t ctx = ai_context_get_base(ckpt->ai_ctx);
+    const ai_ckpt_tensor_desc_t* t = item->desc;
+    
+    uint32_t b = 0;
+    while (b < t->num_blocks) {
+        uint16_t depth = t->blocks[b].depth;
+        uint32_t e = b + 1;
+        while (e < t->num_blocks && t->blocks[e].depth == depth) e++;
+        
+        const ai_ckpt_map_t* map;
+        const ai_ckpt_tensor_desc_t* st = ckpt_restore_source(r, t, depth, &map);
+        if (!st) return GPUIO_ERROR_NOT_FOUND;
+        
+        const char* src = (const char*)map->base + st->offset;
+        uint64_t lo = (uint64_t)b * CKPT_HASH_BLOCK;
+        uint64_t hi = (uint64_t)e * CKPT_HASH_BLOCK;
+        if (hi > t->size) hi = t->size;
+        
+        /* Start readahead for the whole run; offsets are page aligned */
+        madvise((void*)(src + lo), hi - lo, MADV_WILLNEED);
+        
+        for (uint32_t k = b; k < e; k++) {
+            uint64_t off = (uint64_t)k * CKPT_HASH_BLOCK;
+            size_t len = ai_ckpt_block_len(t->size, k);
+            
+            if (gpuio_hash_bytes(src + off, len, CKPT_HASH_SEED) != t->blocks[k].hash) {
+                AI_LOG_ERROR(ckpt->ai_ctx,
+                             "Checkpoint: tensor '%s' block %u hash mismatch",
+                             t->name, k);
+                return GPUIO_ERROR_IO;
+            }
+            gpuio_memcpy(ctx, item->dst + off, src + off, len, NULL);
+        }
+        
+        b = e;
+    }
+    
+    return GPUIO_SUCCESS;
+}
+
+static void ckpt_restore_item_done(ai_ckpt_restore_t* r,
+                                   ai_ckpt_restore_item_t* item,
+                                   gpuio_error_t err) {
+    pthread_mutex_lock(&r->lock);
+    item->state = CKPT_ITEM_DONE;
+    item->status = err;
+    if (err != GPUIO_SUCCESS && r->status == GPUIO_SUCCESS) r->status = err;
+    r->num_done++;
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+}
+
+/* Background prefetcher: materialize items in order, skipping claimed ones */
+static void* ckpt_restore_thread(void* arg) {
+    struct ai_checkpoint* ckpt = (struct ai_checkpoint*)arg;
+    ai_ckpt_restore_t* r = ckpt->restore;
+    
+    for (;;) {
+        pthread_mutex_lock(&r->lock);
+        while (r->next_item < r->num_items &&
+               r->items[r->next_item].state != CKPT_ITEM_PENDING) {
+            r->next_item++;
+        }
+        if (r->next_item == r->num_items) {
+            /* Wait for items an acquire() is still copying */
+            while (r->num_done < r->num_items) {
+                pthread_cond_wait(&r->cond, &r->lock);
+            }
+            pthread_mutex_unlock(&r->lock);
+            break;
+        }
+        ai_ckpt_restore_item_t* item = &r->items[r->next_item++];
+        item->state = CKPT_ITEM_BUSY;
+        pthread_mutex_unlock(&r->lock);
+        
+        ckpt_restore_item_done(r, item, ckpt_restore_item(ckpt, r, item));
+    }
+    
+    uint64_t elapsed = gpuio_get_time_us() - r->start_us;
+    if (r->status == GPUIO_SUCCESS) {
+        ckpt_record(ckpt, true, r->bytes, elapsed);
+    }
+    pthread_mutex_lock(&ckpt->stats_lock);
+    ckpt->stats.last_restore_time_us = elapsed;
+    pthread_mutex_unlock(&ckpt->stats_lock);
+    
+    pthread_mutex_lock(&r->lock);
+    r->finished = true;
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+    
+    return NULL;
+}
+
+/*
+ * Wait for the lazy restore to finish and reap it. Caller holds
+ * ckpt->lock. Returns the restore status, or GPUIO_ERROR_TIMEOUT.
+ */
+static gpuio_error_t ckpt_restore_wait(struct ai_checkpoint* ckpt, int timeout_ms) {
+    ai_ckpt_restore_t* r = ckpt->restore;
+    if (!r) return ckpt->restore_status;
+    
+    struct timespec deadline;
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+    
+    pthread_mutex_lock(&r->lock);
+    while (!r->finished) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&r->cond, &r->lock);
+        } else if (pthread_cond_timedwait(&r->cond, &r->lock, &deadline) == ETIMEDOUT &&
+                   !r->finished) {
+            pthread_mutex_unlock(&r->lock);
+            return GPUIO_ERROR_TIMEOUT;
+        }
+    }
+    pthread_mutex_unlock(&r->lock);
+    
+    if (r->threaded) pthread_join(r->thread, NULL);
+    
+    /* Keep the per-tensor results for acquire() until the next load */
+    ckpt_restore_release(r);
+    ckpt_restore_free(ckpt->restored);
+    ckpt->restored = r;
+    ckpt->restore_status = r->status;
+    ckpt->restore = NULL;
+    
+    return ckpt->restore_status;
+}
+
+/**
+ * @brief Start a lazy restore of the registered tensors.
+ *
+ * Reads and validates the manifest chain and maps the shard files, then
+ * returns; tensor data is copied in by a background thread in
+ * registration order, or by gpuio_ai_checkpoint_acquire() on demand.
+ *
+ * @param ai_ctx AI context
+ * @param path Checkpoint directory
+ * @return GPUIO_SUCCESS once the restore is running, error code otherwise
+ */
+gpuio_error_t gpuio_ai_checkpoint_load_lazy(gpuio_ai_context_t ai_ctx,
+                                             const char* path) {
+    struct ai_checkpoint* ckpt = ckpt_from_ctx(ai_ctx);
+    if (!ckpt || !path) return GPUIO_ERROR_INVALID_ARG;
+    
+    pthread_mutex_lock(&ckpt->lock);
+    uint64_t start = gpuio_get_time_us();
+    
+    ckpt_async_wait_idle(ckpt, -1);
+    ckpt_restore_wait(ckpt, -1);
+    ckpt_restore_free(ckpt->restored);
+    ckpt->restored = NULL;
+    
+    ai_ckpt_restore_t* r = calloc(1, sizeof(ai_ckpt_restore_t));
+    if (!r) {
+        pthread_mutex_unlock(&ckpt->lock);
+        return GPUIO_ERROR_NOMEM;
+    }
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->cond, NULL);
+    r->start_us = start;
+    r->status = GPUIO_SUCCESS;
+    
+    gpuio_error_t err = ai_ckpt_manifest_read(path, &r->manifest);
+    if (err != GPUIO_SUCCESS) {
+        AI_LOG_ERROR(ai_ctx, "Checkpoint: cannot read manifest in %s (%d)",
+                     path, err);
+    }
+    
+    if (err == GPUIO_SUCCESS) {
+        r->refs = ckpt_read_ancestors(ai_ctx, &r->manifest);
+        r->num_refs = r->refs ? r->manifest.num_ancestors : 0;
+        r->ref_by_name = calloc(r->num_refs ? r->num_refs : 1, sizeof(uint32_t*));
+        r->by_name = ckpt_index_by_name(&r->manifest);
+        r->items = calloc(ckpt->num_tensors ? ckpt->num_tensors : 1,
+                          sizeof(ai_ckpt_restore_item_t));
+        r->item_of = malloc((r->manifest.num_tensors ? r->manifest.num_tensors : 1) *
+                            sizeof(int32_t));
+        if (!r->refs || !r->ref_by_name || !r->by_name || !r->items || !r->item_of) {
+            err = GPUIO_ERROR_NOMEM;
+        }
+        for (uint32_t d = 0; d < r->num_refs && err == GPUIO_SUCCESS; d++) {
+            r->ref_by_name[d] = ckpt_index_by_name(&r->refs[d]);
+            if (!r->ref_by_name[d]) err = GPUIO_ERROR_NOMEM;
+        }
+    }
+    
+    if (err == GPUIO_SUCCESS) {
+        for (uint32_t i = 0; i < r->manifest.num_tensors; i++) r->item_of[i] = -1;
+        
+        for (int i = 0; i < ckpt->num_tensors && err == GPUIO_SUCCESS; i++) {
+            ai_ckpt_tensor_t* t = &ckpt->tensors[i];
+            const ai_ckpt_tensor_desc_t* d =
+                ckpt_find_tensor(&r->manifest, r->by_name, t->name);
+            
+            if (!d) {
+                AI_LOG_ERROR(ai_ctx, "Checkpoint: tensor '%s' not in %s",
+                             t->name, path);
+                err = GPUIO_ERROR_NOT_FOUND;
+            } else if (d->size != t->size) {
+                AI_LOG_ERROR(ai_ctx, "Checkpoint: tensor '%s' size mismatch",
+                             t->name);
+                err = GPUIO_ERROR_INVALID_ARG;
+            } else {
+                r->item_of[d - r->manifest.tensors] = r->num_items;
+                r->items[r->num_items].desc = d;
+                r->items[r->num_items].dst = t->data;
+                r->num_items++;
+                r->bytes += t->size;
+            }
+        }
+    }
+    
+    if (err == GPUIO_SUCCESS) err = ckpt_restore_map(r, path);
+    if (err == GPUIO_SUCCESS) {
+        err = ckpt_restore_validate(r);
+        if (err != GPUIO_SUCCESS) {
+            AI_LOG_ERROR(ai_ctx, "Checkpoint: %s references missing shard data",
+                         path);
+        }
+    }
+    
+    if (err != GPUIO_SUCCESS) {
+        ckpt_restore_free(r);
+        pthread_mutex_unlock(&ckpt->lock);
+        return err;
+    }
+    
+    ckpt->restore = r;
+    r->threaded = (pthread_create(&r->thread, NULL, ckpt_restore_thread, ckpt) == 0);
+    if (!r->threaded) {
+        /* No prefetcher: restore everything before returning */
+        ckpt_restore_thread(ckpt);
+    }
+    
+    pthread_mutex_lock(&ckpt->stats_lock);
+    ckpt->stats.last_restore_ready_us = gpuio_get_time_us() - start;
+    pthread_mutex_unlock(&ckpt->stats_lock);
+    
+    pthread_mutex_unlock(&ckpt->lock);
+    
+    AI_LOG_INFO(ai_ctx, "Checkpoint: lazy restore of %d tensors from %s started",
+                r->num_items, path);
+    
+    return GPUIO_SUCCESS;
+}
+
+/**
+ * @brief Make sure a tensor is resident before its first use.
+ *
+ * Returns immediately if the tensor has already been materialized, waits
+ * if the prefetcher is copying it, and otherwise copies it right away.
+ *
+ * @param ai_ctx AI context
+ * @param name Registered tensor name
+ * @return GPUIO_SUCCESS when the tensor is resident, GPUIO_ERROR_NOT_FOUND
+ *         if it is not part of the lazy restore, other errors on failure
+ */
+gpuio_error_t gpuio_ai_checkpoint_acquire(gpuio_ai_context_t ai_ctx,
+                                           const char* name) {
+    struct ai_checkpoint* ckpt = ckpt_from_ctx(ai_ctx);
+    if (!ckpt || !name) return GPUIO_ERROR_INVALID_ARG;
+    
+    pthread_mutex_lock(&ckpt->lock);
+    
+    /* Once reaped, the finished restore still answers for its tensors */
+    ai_ckpt_restore_t* r = ckpt->restore ? ckpt->restore : ckpt->restored;
+    const ai_ckpt_tensor_desc_t* d =
+        r ? ckpt_find_tensor(&r->manifest, r->by_name, name) : NULL;
+    int32_t idx = d ? r->item_of[d - r->manifest.tensors] : -1;
+    if (idx < 0) {
+        pthread_mutex_unlock(&ckpt->lock);
+        return GPUIO_ERROR_NOT_FOUND;
+    }
+    
+    ai_ckpt_restore_item_t* item = &r->items[idx];
+    gpuio_error_t err;
+    
+    pthread_mutex_lock(&r->lock);
+    if (item->state == CKPT_ITEM_PENDING) {
+        item->state = CKPT_ITEM_BUSY;
+        pthread_mutex_unlock(&r->lock);
+        
+        err = ckpt_restore_item(ckpt, r, item);
+        ckpt_restore_item_done(r, item, err);
+        
+        pthread_mutex_lock(&ckpt->stats_lock);
+        ckpt->stats.demand_fetches++;
+        pthread_mutex_unlock(&ckpt->stats_lock);
+    } else {
+        while (item->state != CKPT_ITEM_DONE) {
+            pthread_cond_wait(&r->cond, &r->lock);
+        }
+        err = item->status;
+        pthread_mutex_unlock(&r->lock);
+    }
+    
+    pthread_mutex_unlock(&ckpt->lock);
+    return err;
+}
+
+/**
+ * @brief Get checkpoint throughput statistics.
+ *
+ * @param ai_ctx AI context
+ * @param stats Output statistics
+ * @return GPUIO_SUCCESS on success, error code otherwise
+ */
+gpuio_error_t gpuio_ai_checkpoint_get_stats(gpuio_ai_context_t ai_ctx,
+                                             gpuio_checkpoint_stats_t* stats) {
+    struct ai_checkpoint* ckpt = ckpt_from_ctx(ai_ctx);
+    if (!ckpt || !stats) return GPUIO_ERROR_INVALID_ARG;
+    
+    pthread_mutex_lock(&ckpt->stats_lock);
+    *stats = ckpt->stats;
+    pthread_mutex_unlock(&ckpt->stats_lock);
+    
+    return GPUIO_SUCCESS;
+}
+
+/**
+ * @brief Set the async save completion callback.
+ *
+ * The callback runs on the background writer thread and must not call
+ * back into the checkpoint API.
+ *
+ * @param ai_ctx AI context
+ * @param callback Completion callback (NULL to disable)
+ * @param user_data Passed through to the callback
+ * @return GPUIO_SUCCESS on success, error code otherwise
+ */
+gpuio_error_t gpuio_ai_checkpoint_set_callback(gpuio_ai_context_t ai_ctx,
+                                                gpuio_checkpoint_callback_t callback,
+                                                void* user_data) {
+    struct ai_checkpoint* ckpt = ckpt_from_ctx(ai_ctx);
+    if (!ckpt) return GPUIO_ERROR_INVALID_ARG;
+    
+    pthread_mutex_lock(&ckpt->async_lock);
+    ckpt->callback = callback;
+    ckpt->callback_data = user_data;
+    pthread_mutex_unlock(&ckpt->async_lock);
+    
+    return GPUIO_SUCCESS;
+}
+
+/**
+ * @brief Wait for the in-flight lazy restore and async save to complete.
+ *
+ * @param ai_ctx AI context
+ * @param timeout_ms Maximum wait in milliseconds (per operation), negative
+ *                   to wait forever
+ * @return First error of the most recent restore and async save,
+ *         GPUIO_ERROR_TIMEOUT, or GPUIO_SUCCESS
+ */
+gpuio_error_t gpuio_ai_checkpoint_wait(gpuio_ai_context_t ai_ctx,
+                                        int timeout_ms) {
+    struct ai_checkpoint* ckpt = ckpt_from_ctx(ai_ctx);
+    if (!ckpt) return GPUIO_ERROR_INVALID_ARG;
+    
+    pthread_mutex_lock(&ckpt->lock);
+    gpuio_error_t restore_err = ckpt_restore_wait(ckpt, timeout_ms);
+    pthread_mutex_unlock(&ckpt->lock);
+    
+    gpuio_error_t err = ckpt_async_wait_idle(ckpt, timeout_ms);
+    return restore_err != GPUIO_SUCCESS ? restore_err : err;
+}
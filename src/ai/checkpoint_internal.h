@@ -0,0 +1,232 @@
+/**
+ * @file checkpoint_internal.h
+ * @brief AI Extensions module - Sharded checkpoint internal structures
+ * @version 1.1.0
+ *
+ * Internal structures for the checkpoint writer/loader. A checkpoint is a
+ * directory with a binary MANIFEST and N shard files. Tensors are packed
+ * into shards at CKPT_ALIGN boundaries; shards are written in parallel with
+ * large aligned IOs and committed by renaming MANIFEST.tmp over MANIFEST.
+ *
+ * Every tensor is split into CKPT_HASH_BLOCK blocks with a hash each. An
+ * incremental checkpoint stores only blocks whose hash differs from the
+ * parent; unchanged blocks are left as holes in the (sparse) shard and
+ * point at the ancestor that holds them.
+ */
+
+#ifndef CHECKPOINT_INTERNAL_H
+#define CHECKPOINT_INTERNAL_H
+
+#include "ai_internal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * Configuration Constants
+ * ============================================================================ */
+
+#define CKPT_MAGIC               0x504B4347u  /* "GCKP" */
+#define CKPT_VERSION             2
+#define CKPT_MANIFEST_NAME       "MANIFEST"
+#define CKPT_MANIFEST_TMP_NAME   "MANIFEST.tmp"
+
+#define CKPT_ALIGN               4096         /* Tensor placement / direct IO */
+#define CKPT_HASH_BLOCK          (1 << 20)    /* Checksum granularity */
+#define CKPT_HASH_SEED           0x6770696f636b7074ULL
+
+#define CKPT_DEFAULT_SHARDS      8
+#define CKPT_DEFAULT_IO_SIZE     (8 << 20)
+#define CKPT_MAX_SHARDS          4096
+#define CKPT_MAX_THREADS         64
+#define CKPT_MAX_NAME            1024
+#define CKPT_MAX_CHAIN           16           /* Ancestors one checkpoint may reference */
+
+/* ============================================================================
+ * Registered Tensor
+ * ============================================================================ */
+
+typedef struct ai_ckpt_tensor {
+    char* name;
+    void* data;
+    size_t size;
+} ai_ckpt_tensor_t;
+
+/* ============================================================================
+ * Manifest (in-memory form)
+ * ============================================================================ */
+
+typedef struct ai_ckpt_shard_desc {
+    char* path;                  /* Relative to checkpoint dir, or absolute */
+    uint64_t size;
+} ai_ckpt_shard_desc_t;
+
+typedef struct ai_ckpt_block {
+    uint64_t hash;               /* gpuio_hash_bytes of the block */
+    uint16_t depth;              /* 0 = stored here, d = in ancestor d */
+} ai_ckpt_block_t;
+
+typedef struct ai_ckpt_tensor_desc {
+    char* name;
+    uint64_t size;
+    uint32_t shard;
+    uint64_t offset;             /* Byte offset within shard */
+    uint32_t num_blocks;
+    ai_ckpt_block_t* blocks;
+} ai_ckpt_tensor_desc_t;
+
+typedef struct ai_ckpt_ancestor {
+    char* path;                  /* Absolute checkpoint directory */
+    uint64_t checkpoint_id;      /* Guards against the directory being reused */
+} ai_ckpt_ancestor_t;
+
+typedef struct ai_ckpt_manifest {
+    uint64_t checkpoint_id;
+    uint64_t total_bytes;        /* Logical tensor bytes */
+    uint64_t stored_bytes;       /* Bytes stored in this checkpoint's shards */
+    uint32_t num_ancestors;      /* ancestors[0] is the parent */
+    uint32_t num_shards;
+    uint32_t num_tensors;
+    ai_ckpt_ancestor_t* ancestors;
+    ai_ckpt_shard_desc_t* shards;
+    ai_ckpt_tensor_desc_t* tensors;
+} ai_ckpt_manifest_t;
+
+/* ============================================================================
+ * Async Save (snapshot awaiting persistence)
+ * ============================================================================ */
+
+typedef struct ai_ckpt_pending {
+    char* path;
+    ai_ckpt_manifest_t manifest;
+    ai_ckpt_manifest_t old;      /* Generation to garbage-collect on commit */
+    bool have_old;
+    ai_ckpt_manifest_t parent;   /* Incremental saves only */
+    bool have_parent;
+    void** buffers;              /* Per manifest tensor, inside the pool */
+    gpuio_checkpoint_config_t config;  /* Copy taken at snapshot time */
+    uint64_t start_us;
+} ai_ckpt_pending_t;
+
+/* ============================================================================
+ * Lazy Restore (mmap'd shards, materialized in the background or on demand)
+ * ============================================================================ */
+
+typedef enum {
+    CKPT_ITEM_PENDING = 0,
+    CKPT_ITEM_BUSY,
+    CKPT_ITEM_DONE
+} ai_ckpt_item_state_t;
+
+typedef struct ai_ckpt_restore_item {
+    const ai_ckpt_tensor_desc_t* desc;  /* In the restore manifest */
+    char* dst;
+    ai_ckpt_item_state_t state;
+    gpuio_error_t status;
+} ai_ckpt_restore_item_t;
+
+typedef struct ai_ckpt_map {
+    void* base;
+    size_t size;
+} ai_ckpt_map_t;
+
+typedef struct ai_ckpt_restore {
+    ai_ckpt_manifest_t manifest;
+    uint32_t* by_name;
+    ai_ckpt_manifest_t* refs;    /* refs[d - 1] is ancestor d */
+    uint32_t** ref_by_name;
+    uint32_t num_refs;
+    ai_ckpt_map_t** maps;        /* maps[d][shard]; d = 0 is this checkpoint */
+    
+    /* Registered tensors in registration (layer) order */
+    ai_ckpt_restore_item_t* items;
+    int32_t* item_of;            /* Manifest tensor -> item, or -1 */
+    int num_items;
+    int next_item;
+    int num_done;
+    
+    uint64_t bytes;
+    uint64_t start_us;
+    gpuio_error_t status;
+    bool threaded;
+    bool finished;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} ai_ckpt_restore_t;
+
+/* ============================================================================
+ * Checkpoint Subsystem
+ * ============================================================================ */
+
+struct ai_checkpoint {
+    gpuio_ai_context_t ai_ctx;
+    
+    /* Configuration (shard_dirs deep-copied) */
+    gpuio_checkpoint_config_t config;
+    
+    /* Registered tensors */
+    ai_ckpt_tensor_t* tensors;
+    int num_tensors;
+    int tensors_capacity;
+    
+    /* Serializes save/load against each other and registration */
+    pthread_mutex_t lock;
+    
+    /* Pinned snapshot pool, reused across async saves */
+    char* pool;
+    size_t pool_size;
+    gpuio_memory_region_t pool_region;
+    bool pool_registered;
+    
+    /* Background writer; pending is owned by it until completion */
+    pthread_t writer;
+    bool writer_started;
+    bool shutdown;
+    ai_ckpt_pending_t* pending;
+    gpuio_error_t async_status;
+    pthread_mutex_t async_lock;
+    pthread_cond_t async_cond;
+    
+    gpuio_checkpoint_callback_t callback;
+    void* callback_data;
+    
+    /* Lazy restore in flight (created and reaped under lock) */
+    ai_ckpt_restore_t* restore;
+    gpuio_error_t restore_status;
+    
+    /* Last reaped restore, unmapped; kept for acquire() until the next load */
+    ai_ckpt_restore_t* restored;
+    
+    /* Statistics */
+    gpuio_checkpoint_stats_t stats;
+    pthread_mutex_t stats_lock;
+};
+
+/* ============================================================================
+ * Checkpoint Internal Functions
+ * ============================================================================ */
+
+int ai_checkpoint_init(struct ai_checkpoint* ckpt, gpuio_ai_context_t ai_ctx);
+void ai_checkpoint_cleanup(struct ai_checkpoint* ckpt);
+
+gpuio_error_t ai_ckpt_manifest_read(const char* dir, ai_ckpt_manifest_t* manifest);
+gpuio_error_t ai_ckpt_manifest_write(const char* dir,
+                                      const ai_ckpt_manifest_t* manifest);
+void ai_ckpt_manifest_free(ai_ckpt_manifest_t* manifest);
+
+static inline uint32_t ai_ckpt_num_blocks(uint64_t size) {
+    return (uint32_t)((size + CKPT_HASH_BLOCK - 1) / CKPT_HASH_BLOCK);
+}
+
+static inline size_t ai_ckpt_block_len(uint64_t size, uint32_t block) {
+    uint64_t off = (uint64_t)block * CKPT_HASH_BLOCK;
+    return (size_t)(size - off < CKPT_HASH_BLOCK ? size - off : CKPT_HASH_BLOCK);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHECKPOINT_INTERNAL_H */
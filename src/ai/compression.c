@@ -4,7 +4,8 @@
  * @version 1.0.0
  * 
  * Compression and quantization codecs for AI/ML workloads including
- * FP16 half-precision, INT8 quantization, and 4-bit compression.
+ * FP16 half-precision, INT8 quantization, 4-bit compression and lossless
+ * LZ4 (block format).
  */
 
 #include "ai_internal.h"
@@ -454,6 +455,209 @@ gpuio_error_t ai_codec_decompress_4bit(struct gpuio_codec* codec,
     return GPUIO_SUCCESS;
 }
 
+/* ============================================================================
+ * LZ4 Compression (Lossless, Block Format)
+ * ============================================================================ */
+
+#define LZ4_HASH_LOG        12
+#define LZ4_MIN_MATCH       4
+#define LZ4_MFLIMIT         12           /* No match starts this close to the end */
+#define LZ4_LAST_LITERALS   5            /* The block always ends in literals */
+#define LZ4_MAX_OFFSET      65535
+
+static inline uint32_t lz4_read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t lz4_hash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ4_HASH_LOG);
+}
+
+/* Write a 4-bit length's continuation bytes */
+static inline uint8_t* lz4_put_length(uint8_t* op, size_t len) {
+    for (len -= 15; len >= 255; len -= 255) {
+        *op++ = 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+/* Emit one sequence; match_len 0 means the final literals-only one */
+static uint8_t* lz4_put_sequence(uint8_t* op, uint8_t* oend, const uint8_t* literals,
+                                 size_t lit_len, size_t offset, size_t match_len) {
+    size_t ml = match_len ? match_len - LZ4_MIN_MATCH : 0;
+    size_t need = 1 + lit_len + lit_len / 255 + 1 + (match_len ? 2 + ml / 255 + 1 : 0);
+    if ((size_t)(oend - op) < need) return NULL;
+    
+    uint8_t* token = op++;
+    *token = (uint8_t)((lit_len < 15 ? lit_len : 15) << 4);
+    if (lit_len >= 15) op = lz4_put_length(op, lit_len);
+    memcpy(op, literals, lit_len);
+    op += lit_len;
+    
+    if (match_len) {
+        *op++ = (uint8_t)(offset & 0xFF);
+        *op++ = (uint8_t)(offset >> 8);
+        *token |= (uint8_t)(ml < 15 ? ml : 15);
+        if (ml >= 15) op = lz4_put_length(op, ml);
+    }
+    return op;
+}
+
+/**
+ * @brief Compress bytes to an LZ4 block.
+ *
+ * Greedy single-probe matcher. Fails with GPUIO_ERROR_INVALID_ARG when the
+ * result doesn't fit output_capacity, which callers can use to detect data
+ * that doesn't compress.
+ */
+gpuio_error_t ai_codec_compress_lz4(struct gpuio_codec* codec,
+                                     const void* input, size_t input_size,
+                                     void* output, size_t output_capacity,
+                                     size_t* output_size) {
+    (void)codec;
+    
+    if (!input || !output || !output_size) {
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    const uint8_t* in = (const uint8_t*)input;
+    const uint8_t* ip = in;
+    const uint8_t* anchor = in;
+    const uint8_t* end = in + input_size;
+    uint8_t* op = (uint8_t*)output;
+    uint8_t* oend = op + output_capacity;
+    
+    if (input_size > LZ4_MFLIMIT) {
+        uint32_t table[1 << LZ4_HASH_LOG] = {0};
+        const uint8_t* mflimit = end - LZ4_MFLIMIT;
+        const uint8_t* mlimit = end - LZ4_LAST_LITERALS;
+        
+        while (ip <= mflimit) {
+            uint32_t seq = lz4_read32(ip);
+            uint32_t h = lz4_hash(seq);
+            const uint8_t* ref = in + table[h];
+            table[h] = (uint32_t)(ip - in);
+            
+            if (ref >= ip || ip - ref > LZ4_MAX_OFFSET || lz4_read32(ref) != seq) {
+                /* Step faster through data that doesn't match */
+                ip += 1 + ((size_t)(ip - anchor) >> 6);
+                continue;
+            }
+            
+            /* Extend backwards over pending literals, then forwards */
+            while (ip > anchor && ref > in && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const uint8_t* mp = ip + LZ4_MIN_MATCH;
+            const uint8_t* rp = ref + LZ4_MIN_MATCH;
+            while (mp < mlimit && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+            
+            op = lz4_put_sequence(op, oend, anchor, (size_t)(ip - anchor),
+                                  (size_t)(ip - ref), (size_t)(mp - ip));
+            if (!op) return GPUIO_ERROR_INVALID_ARG;
+            
+            ip = mp;
+            anchor = ip;
+            if (ip - 2 > in) {
+                table[lz4_hash(lz4_read32(ip - 2))] = (uint32_t)(ip - 2 - in);
+            }
+        }
+    }
+    
+    op = lz4_put_sequence(op, oend, anchor, (size_t)(end - anchor), 0, 0);
+    if (!op) return GPUIO_ERROR_INVALID_ARG;
+    
+    *output_size = (size_t)(op - (uint8_t*)output);
+    return GPUIO_SUCCESS;
+}
+
+/* Read a 4-bit length's continuation bytes */
+static inline int lz4_get_length(const uint8_t** ip, const uint8_t* iend, size_t* len) {
+    uint8_t b;
+    do {
+        if (*ip >= iend) return -1;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return 0;
+}
+
+/**
+ * @brief Decompress an LZ4 block.
+ *
+ * Every length and offset is checked, so corrupt input fails with
+ * GPUIO_ERROR_IO rather than reading or writing out of bounds.
+ */
+gpuio_error_t ai_codec_decompress_lz4(struct gpuio_codec* codec,
+                                       const void* input, size_t input_size,
+                                       void* output, size_t output_capacity,
+                                       size_t* output_size) {
+    (void)codec;
+    
+    if (!input || !output || !output_size) {
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    const uint8_t* ip = (const uint8_t*)input;
+    const uint8_t* iend = ip + input_size;
+    uint8_t* out = (uint8_t*)output;
+    uint8_t* op = out;
+    uint8_t* oend = out + output_capacity;
+    
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        
+        size_t lit_len = token >> 4;
+        if (lit_len == 15 && lz4_get_length(&ip, iend, &lit_len) != 0) {
+            return GPUIO_ERROR_IO;
+        }
+        if (lit_len > (size_t)(iend - ip) || lit_len > (size_t)(oend - op)) {
+            return GPUIO_ERROR_IO;
+        }
+        memcpy(op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+        
+        /* The last sequence has no match */
+        if (ip == iend) break;
+        
+        if (iend - ip < 2) return GPUIO_ERROR_IO;
+        size_t offset = (size_t)ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - out)) {
+            return GPUIO_ERROR_IO;
+        }
+        
+        size_t match_len = token & 0x0F;
+        if (match_len == 15 && lz4_get_length(&ip, iend, &match_len) != 0) {
+            return GPUIO_ERROR_IO;
+        }
+        match_len += LZ4_MIN_MATCH;
+        if (match_len > (size_t)(oend - op)) return GPUIO_ERROR_IO;
+        
+        /* Matches may overlap their own output */
+        const uint8_t* ref = op - offset;
+        if (offset >= match_len) {
+            memcpy(op, ref, match_len);
+        } else {
+            for (size_t i = 0; i < match_len; i++) {
+                op[i] = ref[i];
+            }
+        }
+        op += match_len;
+    }
+    
+    *output_size = (size_t)(op - out);
+    return GPUIO_SUCCESS;
+}
+
 /* ============================================================================
  * Codec Management
  * ============================================================================ */
@@ -481,25 +685,30 @@ gpuio_error_t gpuio_codec_create(gpuio_context_t ctx,
     
     /* Setup function pointers based on codec type */
     switch (type) {
+        case GPUIO_CODEC_LZ4:
+            c->compress_fn = ai_codec_compress_lz4;
+            c->decompress_fn = ai_codec_decompress_lz4;
+            break;
+        
         case GPUIO_CODEC_FP16:
             c->compress_fn = ai_codec_compress_fp16;
             c->decompress_fn = ai_codec_decompress_fp16;
             break;
-            
+        
         case GPUIO_CODEC_INT8:
             c->compress_fn = ai_codec_compress_int8;
             c->decompress_fn = ai_codec_decompress_int8;
             c->num_channels = 1;
             break;
-            
+        
         case GPUIO_CODEC_CUSTOM:
             /* For CUSTOM type, user must set functions manually */
             c->compress_fn = NULL;
             c->decompress_fn = NULL;
             break;
-            
+        
         default:
-            /* LZ4, ZSTD, GZIP not implemented in this version */
+            /* ZSTD, GZIP not implemented in this version */
             free(c);
             return GPUIO_ERROR_UNSUPPORTED;
     }
@@ -507,6 +716,7 @@ gpuio_error_t gpuio_codec_create(gpuio_context_t ctx,
     *codec = c;
     
     AI_LOG_INFO(ctx, "Created %s codec (level=%d)",
+                type == GPUIO_CODEC_LZ4 ? "LZ4" :
                 type == GPUIO_CODEC_FP16 ? "FP16" :
                 type == GPUIO_CODEC_INT8 ? "INT8" : "CUSTOM",
                 level);
@@ -4,7 +4,8 @@
  * @version 1.1.0
  * 
  * Internal structures and functions for compression and quantization codecs
- * including FP16 half-precision, INT8 quantization, and 4-bit compression.
+ * including FP16 half-precision, INT8 quantization, 4-bit compression and
+ * lossless LZ4.
  */
 
 #ifndef COMPRESSION_INTERNAL_H
@@ -73,6 +74,14 @@ gpuio_error_t ai_codec_decompress_4bit(struct gpuio_codec* codec,
                                         const void* input, size_t input_size,
                                         void* output, size_t output_capacity,
                                         size_t* output_size);
+gpuio_error_t ai_codec_compress_lz4(struct gpuio_codec* codec,
+                                     const void* input, size_t input_size,
+                                     void* output, size_t output_capacity,
+                                     size_t* output_size);
+gpuio_error_t ai_codec_decompress_lz4(struct gpuio_codec* codec,
+                                       const void* input, size_t input_size,
+                                       void* output, size_t output_capacity,
+                                       size_t* output_size);
 
 /* ============================================================================
  * FP16 Conversion Helpers
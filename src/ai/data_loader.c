@@ -0,0 +1,935 @@
+/**
+ * @file data_loader.c
+ * @brief AI Extensions module - Multi-worker shuffled training data loader
+ * @version 1.0.0
+ *
+ * Produces gpuio_training_params_t inputs from record-oriented shard files.
+ * Shards are read with large positional reads by a pool of reader threads
+ * (shard order reshuffled every epoch), records are globally shuffled
+ * through a bounded buffer, and batches are packed into pinned memory K
+ * steps ahead of the consumer. next() reports how long the caller stalled.
+ */
+
+#include "ai_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* ============================================================================
+ * Helpers
+ * ============================================================================ */
+
+/* SplitMix64 stream; the only source of randomness in the loader */
+static inline uint64_t dl_rand(uint64_t* state) {
+    *state += 0x9e3779b97f4a7c15ULL;
+    return gpuio_hash_splitmix64(*state);
+}
+
+static inline uint32_t dl_read_le32(const char* p) {
+    const unsigned char* b = (const unsigned char*)p;
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) |
+           ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+/* Full-length pread, retrying short reads until EOF */
+static ssize_t dl_pread(int fd, void* buf, size_t count, uint64_t offset) {
+    size_t done = 0;
+    
+    while (done < count) {
+        ssize_t n = pread(fd, (char*)buf + done, count - done,
+                          (off_t)(offset + done));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        done += n;
+    }
+    
+    return (ssize_t)done;
+}
+
+/* Per-epoch shard permutation; identical in every reader */
+static void dl_shard_order(const struct gpuio_data_loader* loader,
+                           uint64_t epoch, int* order) {
+    int n = loader->config.num_shards;
+    uint64_t rng = loader->config.seed ^ gpuio_hash_splitmix64(epoch + 1);
+    
+    for (int i = 0; i < n; i++) order[i] = i;
+    for (int i = n - 1; i > 0; i--) {
+        int j = (int)(dl_rand(&rng) % (uint64_t)(i + 1));
+        int t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+}
+
+/* Record an error and stop the pipeline; the first error wins */
+static void dl_fail(struct gpuio_data_loader* loader, gpuio_error_t err) {
+    pthread_mutex_lock(&loader->lock);
+    if (loader->status == GPUIO_SUCCESS) loader->status = err;
+    loader->stopping = true;
+    pthread_cond_broadcast(&loader->chunk_cond);
+    pthread_cond_broadcast(&loader->slot_cond);
+    pthread_mutex_unlock(&loader->lock);
+}
+
+/* ============================================================================
+ * Chunks
+ * ============================================================================ */
+
+static dl_chunk_t* dl_chunk_get(struct gpuio_data_loader* loader, size_t cap) {
+    pthread_mutex_lock(&loader->lock);
+    dl_chunk_t* c = loader->free_chunks;
+    if (c) loader->free_chunks = c->next;
+    pthread_mutex_unlock(&loader->lock);
+    
+    if (!c) {
+        c = calloc(1, sizeof(dl_chunk_t));
+        if (!c) return NULL;
+    }
+    c->len = 0;
+    c->epoch_end = false;
+    c->next = NULL;
+    
+    if (c->cap < cap) {
+        char* data = realloc(c->data, cap);
+        if (!data) {
+            free(c->data);
+            free(c);
+            return NULL;
+        }
+        c->data = data;
+        c->cap = cap;
+    }
+    
+    return c;
+}
+
+/* Called with loader->lock held */
+static void dl_chunk_put_locked(struct gpuio_data_loader* loader, dl_chunk_t* c) {
+    c->next = loader->free_chunks;
+    loader->free_chunks = c;
+}
+
+static void dl_chunk_free_list(dl_chunk_t* c) {
+    while (c) {
+        dl_chunk_t* next = c->next;
+        free(c->data);
+        free(c);
+        c = next;
+    }
+}
+
+/* Queue a chunk for the mixer; -1 if the loader is stopping */
+static int dl_chunk_push(dl_reader_t* rd, dl_chunk_t* c) {
+    struct gpuio_data_loader* loader = rd->loader;
+    
+    pthread_mutex_lock(&loader->lock);
+    while (rd->depth >= DL_CHUNK_QUEUE_DEPTH && !loader->stopping) {
+        pthread_cond_wait(&loader->chunk_cond, &loader->lock);
+    }
+    if (loader->stopping) {
+        dl_chunk_put_locked(loader, c);
+        pthread_mutex_unlock(&loader->lock);
+        return -1;
+    }
+    
+    c->next = NULL;
+    if (rd->tail) rd->tail->next = c;
+    else rd->head = c;
+    rd->tail = c;
+    rd->depth++;
+    pthread_cond_broadcast(&loader->chunk_cond);
+    pthread_mutex_unlock(&loader->lock);
+    
+    return 0;
+}
+
+/* ============================================================================
+ * Reader Threads
+ * ============================================================================ */
+
+/*
+ * Length of the whole records at the front of buf. When none fits, *need
+ * is the read size required to hold the first one.
+ */
+static gpuio_error_t dl_whole_records(const struct gpuio_data_loader* loader,
+                                      const char* buf, size_t n,
+                                      size_t* whole, size_t* need) {
+    size_t rs = loader->config.record_size;
+    
+    *whole = 0;
+    *need = 0;
+    
+    if (rs > 0) {
+        *whole = n / rs * rs;
+        if (*whole == 0) *need = rs;
+        return GPUIO_SUCCESS;
+    }
+    
+    size_t pos = 0;
+    while (pos + DL_LEN_PREFIX <= n) {
+        size_t len = dl_read_le32(buf + pos);
+        if (len > loader->config.max_record_size) {
+            AI_LOG_ERROR(loader->ai_ctx, "Record of %zu bytes exceeds max_record_size",
+                         len);
+            return GPUIO_ERROR_IO;
+        }
+        if (pos + DL_LEN_PREFIX + len > n) {
+            if (pos == 0) *need = DL_LEN_PREFIX + len;
+            break;
+        }
+        pos += DL_LEN_PREFIX + len;
+    }
+    if (pos == 0 && *need == 0) *need = DL_LEN_PREFIX;
+    
+    *whole = pos;
+    return GPUIO_SUCCESS;
+}
+
+/* Stream one shard into chunks of whole records */
+static gpuio_error_t dl_read_shard(dl_reader_t* rd, const char* path) {
+    struct gpuio_data_loader* loader = rd->loader;
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        AI_LOG_ERROR(loader->ai_ctx, "Failed to open shard %s: %s",
+                     path, strerror(errno));
+        return GPUIO_ERROR_IO;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    
+    gpuio_error_t err = GPUIO_SUCCESS;
+    uint64_t offset = 0;
+    size_t want = loader->config.read_size;
+    dl_chunk_t* c = NULL;
+    
+    for (;;) {
+        if (!c || c->cap < want) {
+            if (c) {
+                pthread_mutex_lock(&loader->lock);
+                dl_chunk_put_locked(loader, c);
+                pthread_mutex_unlock(&loader->lock);
+            }
+            c = dl_chunk_get(loader, want);
+            if (!c) {
+                err = GPUIO_ERROR_NOMEM;
+                break;
+            }
+        }
+        
+        ssize_t n = dl_pread(fd, c->data, want, offset);
+        if (n < 0) {
+            AI_LOG_ERROR(loader->ai_ctx, "Read failed on shard %s: %s",
+                         path, strerror(errno));
+            err = GPUIO_ERROR_IO;
+            break;
+        }
+        if (n == 0) break;
+        
+        size_t whole, need;
+        err = dl_whole_records(loader, c->data, (size_t)n, &whole, &need);
+        if (err != GPUIO_SUCCESS) break;
+        
+        if (whole == 0) {
+            if ((size_t)n < want) {
+                AI_LOG_ERROR(loader->ai_ctx, "Truncated record at offset %llu in %s",
+                             (unsigned long long)offset, path);
+                err = GPUIO_ERROR_IO;
+                break;
+            }
+            want = need;
+            continue;
+        }
+        
+        c->len = whole;
+        offset += whole;
+        want = loader->config.read_size;
+        
+        dl_chunk_t* full = c;
+        c = NULL;
+        if (dl_chunk_push(rd, full) != 0) {
+            err = GPUIO_ERROR_CANCELED;
+            break;
+        }
+    }
+    
+    if (c) {
+        pthread_mutex_lock(&loader->lock);
+        dl_chunk_put_locked(loader, c);
+        pthread_mutex_unlock(&loader->lock);
+    }
+    close(fd);
+    
+    return err;
+}
+
+/*
+ * Reader r streams shards r, r+R, r+2R, ... of each epoch's permutation and
+ * closes the epoch with a marker chunk. Readers may run ahead into the next
+ * epoch; the bounded queue keeps that to DL_CHUNK_QUEUE_DEPTH chunks.
+ */
+static void* dl_reader_thread(void* arg) {
+    dl_reader_t* rd = (dl_reader_t*)arg;
+    struct gpuio_data_loader* loader = rd->loader;
+    int num_shards = loader->config.num_shards;
+    
+    int* order = malloc((size_t)num_shards * sizeof(int));
+    if (!order) {
+        dl_fail(loader, GPUIO_ERROR_NOMEM);
+        return NULL;
+    }
+    
+    for (uint64_t epoch = 0;
+         loader->config.num_epochs == 0 ||
+         epoch < (uint64_t)loader->config.num_epochs;
+         epoch++) {
+        dl_shard_order(loader, epoch, order);
+        
+        for (int k = rd->id; k < num_shards; k += loader->num_readers) {
+            gpuio_error_t err = dl_read_shard(rd, loader->config.shard_paths[order[k]]);
+            if (err == GPUIO_ERROR_CANCELED) goto out;
+            if (err != GPUIO_SUCCESS) {
+                dl_fail(loader, err);
+                goto out;
+            }
+        }
+        
+        dl_chunk_t* marker = dl_chunk_get(loader, 0);
+        if (!marker) {
+            dl_fail(loader, GPUIO_ERROR_NOMEM);
+            goto out;
+        }
+        marker->epoch_end = true;
+        if (dl_chunk_push(rd, marker) != 0) goto out;
+    }
+
+out:
+    free(order);
+    return NULL;
+}
+
+/* ============================================================================
+ * Batch Slots
+ * ============================================================================ */
+
+/* Grow a slot's pinned buffer, keeping the records already packed */
+static int dl_slot_reserve(struct gpuio_data_loader* loader, dl_slot_t* slot,
+                           size_t size) {
+    if (slot->cap >= size) return 0;
+    
+    size = gpuio_align_up(size, 4096);
+    char* data = NULL;
+    if (posix_memalign((void**)&data, 4096, size) != 0) return -1;
+    if (slot->used > 0) memcpy(data, slot->data, slot->used);
+    
+    gpuio_context_t ctx = ai_context_get_base(loader->ai_ctx);
+    if (slot->registered) {
+        gpuio_unregister_memory(ctx, &slot->region);
+        slot->registered = false;
+    }
+    free(slot->data);
+    
+    slot->data = data;
+    slot->cap = size;
+    slot->registered = gpuio_register_memory(ctx, data, size,
+                                             GPUIO_MEM_READ_WRITE,
+                                             &slot->region) == GPUIO_SUCCESS;
+    return 0;
+}
+
+/* Claim the next slot in sequence; NULL if the loader is stopping */
+static dl_slot_t* dl_slot_begin(struct gpuio_data_loader* loader,
+                                uint64_t epoch) {
+    pthread_mutex_lock(&loader->lock);
+    dl_slot_t* slot = &loader->slots[loader->produce_seq % loader->num_slots];
+    while (slot->state != DL_SLOT_FREE && !loader->stopping) {
+        pthread_cond_wait(&loader->slot_cond, &loader->lock);
+    }
+    if (loader->stopping) {
+        pthread_mutex_unlock(&loader->lock);
+        return NULL;
+    }
+    slot->state = DL_SLOT_FILLING;
+    slot->index = loader->produce_seq;
+    pthread_mutex_unlock(&loader->lock);
+    
+    slot->used = 0;
+    slot->count = 0;
+    slot->bytes = 0;
+    slot->epoch = epoch;
+    return slot;
+}
+
+static gpuio_error_t dl_slot_add(struct gpuio_data_loader* loader,
+                                 dl_slot_t* slot, const char* data, size_t len) {
+    size_t at = gpuio_align_up(slot->used, DL_BATCH_ALIGN);
+    
+    if (at + len > slot->cap) {
+        size_t size = slot->cap * 2 > at + len ? slot->cap * 2 : at + len;
+        if (dl_slot_reserve(loader, slot, size) != 0) return GPUIO_ERROR_NOMEM;
+    }
+    
+    memcpy(slot->data + at, data, len);
+    slot->offsets[slot->count] = at;
+    slot->sizes[slot->count] = len;
+    slot->count++;
+    slot->used = at + len;
+    slot->bytes += len;
+    
+    return GPUIO_SUCCESS;
+}
+
+static void dl_slot_publish(struct gpuio_data_loader* loader, dl_slot_t* slot) {
+    for (int i = 0; i < slot->count; i++) {
+        slot->inputs[i] = slot->data + slot->offsets[i];
+    }
+    
+    pthread_mutex_lock(&loader->lock);
+    slot->state = DL_SLOT_READY;
+    loader->produce_seq++;
+    pthread_cond_broadcast(&loader->slot_cond);
+    pthread_mutex_unlock(&loader->lock);
+}
+
+/* ============================================================================
+ * Mixer Thread
+ * ============================================================================ */
+
+/* Next record from a reader: 0 = record, 1 = reader ended the epoch, -1 = stop */
+static int dl_next_record(struct gpuio_data_loader* loader, dl_reader_t* rd,
+                          const char** data, size_t* len) {
+    for (;;) {
+        if (rd->cur && rd->pos < rd->cur->len) {
+            const char* p = rd->cur->data + rd->pos;
+            if (loader->config.record_size > 0) {
+                *len = loader->config.record_size;
+            } else {
+                *len = dl_read_le32(p);
+                p += DL_LEN_PREFIX;
+            }
+            *data = p;
+            rd->pos = (size_t)(p - rd->cur->data) + *len;
+            return 0;
+        }
+        
+        pthread_mutex_lock(&loader->lock);
+        if (rd->cur) {
+            dl_chunk_put_locked(loader, rd->cur);
+            rd->cur = NULL;
+        }
+        while (!rd->head && !loader->stopping) {
+            pthread_cond_wait(&loader->chunk_cond, &loader->lock);
+        }
+        if (loader->stopping) {
+            pthread_mutex_unlock(&loader->lock);
+            return -1;
+        }
+        
+        dl_chunk_t* c = rd->head;
+        rd->head = c->next;
+        if (!rd->head) rd->tail = NULL;
+        c->next = NULL;
+        rd->depth--;
+        pthread_cond_broadcast(&loader->chunk_cond);
+        
+        if (c->epoch_end) {
+            dl_chunk_put_locked(loader, c);
+            pthread_mutex_unlock(&loader->lock);
+            return 1;
+        }
+        pthread_mutex_unlock(&loader->lock);
+        
+        rd->cur = c;
+        rd->pos = 0;
+    }
+}
+
+/* Append a record to the batch being filled, publishing it when full */
+static gpuio_error_t dl_emit(struct gpuio_data_loader* loader, dl_slot_t** slot,
+                             uint64_t epoch, const char* data, size_t len) {
+    if (!*slot) {
+        *slot = dl_slot_begin(loader, epoch);
+        if (!*slot) return GPUIO_ERROR_CANCELED;
+    }
+    
+    gpuio_error_t err = dl_slot_add(loader, *slot, data, len);
+    if (err != GPUIO_SUCCESS) return err;
+    
+    if ((*slot)->count == loader->config.batch_size) {
+        dl_slot_publish(loader, *slot);
+        *slot = NULL;
+    }
+    
+    return GPUIO_SUCCESS;
+}
+
+static int dl_record_set(dl_record_t* rec, const char* data, size_t len) {
+    if (rec->cap < len) {
+        char* buf = realloc(rec->data, len);
+        if (!buf) return -1;
+        rec->data = buf;
+        rec->cap = len;
+    }
+    if (len > 0) memcpy(rec->data, data, len);
+    rec->len = len;
+    return 0;
+}
+
+/*
+ * Bounded shuffle: fill the buffer, then for every incoming record emit a
+ * uniformly chosen resident and store the newcomer in its place.
+ */
+static gpuio_error_t dl_shuffle_push(struct gpuio_data_loader* loader,
+                                     dl_slot_t** slot, uint64_t epoch,
+                                     const char* data, size_t len) {
+    size_t cap = loader->config.shuffle_buffer;
+    
+    if (cap == 0) return dl_emit(loader, slot, epoch, data, len);
+    
+    if (loader->shuffle_count < cap) {
+        if (dl_record_set(&loader->shuffle[loader->shuffle_count], data, len) != 0) {
+            return GPUIO_ERROR_NOMEM;
+        }
+        loader->shuffle_count++;
+        return GPUIO_SUCCESS;
+    }
+    
+    dl_record_t* victim = &loader->shuffle[dl_rand(&loader->rng) % cap];
+    gpuio_error_t err = dl_emit(loader, slot, epoch, victim->data, victim->len);
+    if (err != GPUIO_SUCCESS) return err;
+    
+    return dl_record_set(victim, data, len) == 0 ? GPUIO_SUCCESS : GPUIO_ERROR_NOMEM;
+}
+
+/* Empty the shuffle buffer in random order at the end of an epoch */
+static gpuio_error_t dl_shuffle_drain(struct gpuio_data_loader* loader,
+                                      dl_slot_t** slot, uint64_t epoch) {
+    while (loader->shuffle_count > 0) {
+        size_t n = loader->shuffle_count;
+        size_t j = (size_t)(dl_rand(&loader->rng) % n);
+        
+        gpuio_error_t err = dl_emit(loader, slot, epoch, loader->shuffle[j].data,
+                                    loader->shuffle[j].len);
+        if (err != GPUIO_SUCCESS) return err;
+        
+        dl_record_t t = loader->shuffle[j];
+        loader->shuffle[j] = loader->shuffle[n - 1];
+        loader->shuffle[n - 1] = t;
+        loader->shuffle_count--;
+    }
+    
+    return GPUIO_SUCCESS;
+}
+
+/*
+ * Records are taken from the readers strictly round-robin (skipping readers
+ * that finished the epoch), so the stream seen by the shuffle buffer does
+ * not depend on which reader happens to be faster.
+ */
+static void* dl_mixer_thread(void* arg) {
+    struct gpuio_data_loader* loader = (struct gpuio_data_loader*)arg;
+    gpuio_error_t err = GPUIO_SUCCESS;
+    dl_slot_t* slot = NULL;
+    
+    for (uint64_t epoch = 0;
+         loader->config.num_epochs == 0 ||
+         epoch < (uint64_t)loader->config.num_epochs;
+         epoch++) {
+        int active = loader->num_readers;
+        uint64_t records = 0;
+        
+        for (int r = 0; r < loader->num_readers; r++) {
+            loader->readers[r].done = false;
+        }
+        
+        for (int r = 0; active > 0; r = (r + 1) % loader->num_readers) {
+            dl_reader_t* rd = &loader->readers[r];
+            if (rd->done) continue;
+            
+            const char* data;
+            size_t len;
+            int rc = dl_next_record(loader, rd, &data, &len);
+            if (rc < 0) goto out;
+            if (rc > 0) {
+                rd->done = true;
+                active--;
+                continue;
+            }
+            
+            records++;
+            err = dl_shuffle_push(loader, &slot, epoch, data, len);
+            if (err != GPUIO_SUCCESS) goto out;
+        }
+        
+        err = dl_shuffle_drain(loader, &slot, epoch);
+        if (err != GPUIO_SUCCESS) goto out;
+        
+        /* Batches never span epochs */
+        if (slot) {
+            dl_slot_publish(loader, slot);
+            slot = NULL;
+        }
+        
+        /* Empty dataset: stop instead of spinning through epochs */
+        if (records == 0) break;
+    }
+
+out:
+    if (err != GPUIO_SUCCESS && err != GPUIO_ERROR_CANCELED) {
+        dl_fail(loader, err);
+    }
+    
+    pthread_mutex_lock(&loader->lock);
+    if (slot) slot->state = DL_SLOT_FREE;
+    loader->finished = true;
+    pthread_cond_broadcast(&loader->slot_cond);
+    pthread_mutex_unlock(&loader->lock);
+    
+    return NULL;
+}
+
+/* ============================================================================
+ * Lifecycle
+ * ============================================================================ */
+
+static void dl_free(struct gpuio_data_loader* loader) {
+    gpuio_context_t ctx = ai_context_get_base(loader->ai_ctx);
+    
+    if (loader->readers) {
+        for (int r = 0; r < loader->num_readers; r++) {
+            dl_reader_t* rd = &loader->readers[r];
+            dl_chunk_free_list(rd->head);
+            if (rd->cur) dl_chunk_free_list(rd->cur);
+        }
+        free(loader->readers);
+    }
+    dl_chunk_free_list(loader->free_chunks);
+    
+    if (loader->shuffle) {
+        for (size_t i = 0; i < loader->config.shuffle_buffer; i++) {
+            free(loader->shuffle[i].data);
+        }
+        free(loader->shuffle);
+    }
+    
+    if (loader->slots) {
+        for (int s = 0; s < loader->num_slots; s++) {
+            dl_slot_t* slot = &loader->slots[s];
+            if (slot->registered) gpuio_unregister_memory(ctx, &slot->region);
+            free(slot->data);
+            free(slot->offsets);
+            free(slot->inputs);
+            free(slot->sizes);
+        }
+        free(loader->slots);
+    }
+    
+    if (loader->config.shard_paths) {
+        for (int i = 0; i < loader->config.num_shards; i++) {
+            free((char*)loader->config.shard_paths[i]);
+        }
+        free((void*)loader->config.shard_paths);
+    }
+    
+    pthread_mutex_destroy(&loader->lock);
+    pthread_cond_destroy(&loader->chunk_cond);
+    pthread_cond_destroy(&loader->slot_cond);
+    free(loader);
+}
+
+/* Stop and join every thread that was started */
+static void dl_stop(struct gpuio_data_loader* loader) {
+    pthread_mutex_lock(&loader->lock);
+    loader->stopping = true;
+    pthread_cond_broadcast(&loader->chunk_cond);
+    pthread_cond_broadcast(&loader->slot_cond);
+    pthread_mutex_unlock(&loader->lock);
+    
+    for (int r = 0; r < loader->num_readers; r++) {
+        if (loader->readers[r].started) {
+            pthread_join(loader->readers[r].thread, NULL);
+        }
+    }
+    if (loader->mixer_started) {
+        pthread_join(loader->mixer, NULL);
+    }
+}
+
+/**
+ * @brief Create a data loader and start prefetching.
+ *
+ * Reader and mixer threads start immediately, so the first batches are
+ * usually ready by the time the first training step asks for them. The AI
+ * context must outlive the loader.
+ *
+ * @param ai_ctx AI context
+ * @param config Loader configuration (shard paths are copied)
+ * @param loader Output loader handle
+ * @return GPUIO_SUCCESS on success, error code otherwise
+ */
+gpuio_error_t gpuio_data_loader_create(gpuio_ai_context_t ai_ctx,
+                                        const gpuio_data_loader_config_t* config,
+                                        gpuio_data_loader_t* loader) {
+    if (!config || !loader || !config->shard_paths || config->num_shards <= 0 ||
+        config->batch_size <= 0 || config->num_readers < 0 ||
+        config->prefetch_batches < 0 || config->num_epochs < 0) {
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    gpuio_error_t err = ai_context_validate(ai_ctx, false, false, false);
+    if (err != GPUIO_SUCCESS) return err;
+    
+    for (int i = 0; i < config->num_shards; i++) {
+        struct stat st;
+        if (!config->shard_paths[i]) return GPUIO_ERROR_INVALID_ARG;
+        if (stat(config->shard_paths[i], &st) != 0) {
+            AI_LOG_ERROR(ai_ctx, "Shard %s not accessible: %s",
+                         config->shard_paths[i], strerror(errno));
+            return GPUIO_ERROR_NOT_FOUND;
+        }
+    }
+    
+    struct gpuio_data_loader* dl = calloc(1, sizeof(struct gpuio_data_loader));
+    if (!dl) return GPUIO_ERROR_NOMEM;
+    
+    dl->ai_ctx = ai_ctx;
+    dl->config = *config;
+    dl->config.shard_paths = NULL;
+    if (dl->config.num_readers == 0) dl->config.num_readers = DL_DEFAULT_READERS;
+    if (dl->config.num_readers > DL_MAX_READERS) dl->config.num_readers = DL_MAX_READERS;
+    if (dl->config.prefetch_batches == 0) dl->config.prefetch_batches = DL_DEFAULT_PREFETCH;
+    if (dl->config.prefetch_batches > DL_MAX_PREFETCH) {
+        dl->config.prefetch_batches = DL_MAX_PREFETCH;
+    }
+    if (dl->config.read_size == 0) dl->config.read_size = DL_DEFAULT_READ_SIZE;
+    if (dl->config.max_record_size == 0) dl->config.max_record_size = DL_DEFAULT_MAX_RECORD;
+    
+    dl->num_readers = dl->config.num_readers < config->num_shards ?
+                      dl->config.num_readers : config->num_shards;
+    dl->num_slots = dl->config.prefetch_batches + 1;
+    dl->rng = gpuio_hash_splitmix64(config->seed);
+    dl->status = GPUIO_SUCCESS;
+    
+    pthread_mutex_init(&dl->lock, NULL);
+    pthread_cond_init(&dl->chunk_cond, NULL);
+    pthread_cond_init(&dl->slot_cond, NULL);
+    
+    dl->config.shard_paths = calloc((size_t)config->num_shards, sizeof(char*));
+    dl->readers = calloc((size_t)dl->num_readers, sizeof(dl_reader_t));
+    dl->slots = calloc((size_t)dl->num_slots, sizeof(dl_slot_t));
+    if (dl->config.shuffle_buffer > 0) {
+        dl->shuffle = calloc(dl->config.shuffle_buffer, sizeof(dl_record_t));
+    }
+    if (!dl->config.shard_paths || !dl->readers || !dl->slots ||
+        (dl->config.shuffle_buffer > 0 && !dl->shuffle)) {
+        dl_free(dl);
+        return GPUIO_ERROR_NOMEM;
+    }
+    
+    for (int i = 0; i < config->num_shards; i++) {
+        dl->config.shard_paths[i] = strdup(config->shard_paths[i]);
+        if (!dl->config.shard_paths[i]) {
+            dl_free(dl);
+            return GPUIO_ERROR_NOMEM;
+        }
+    }
+    
+    /* Size slots for a full batch up front; variable records grow on demand */
+    size_t batch = (size_t)config->batch_size;
+    size_t initial = config->record_size > 0 ?
+                     batch * gpuio_align_up(config->record_size, DL_BATCH_ALIGN) :
+                     dl->config.read_size;
+    for (int s = 0; s < dl->num_slots; s++) {
+        dl_slot_t* slot = &dl->slots[s];
+        slot->offsets = calloc(batch, sizeof(size_t));
+        slot->inputs = calloc(batch, sizeof(void*));
+        slot->sizes = calloc(batch, sizeof(size_t));
+        if (!slot->offsets || !slot->inputs || !slot->sizes ||
+            dl_slot_reserve(dl, slot, initial) != 0) {
+            dl_free(dl);
+            return GPUIO_ERROR_NOMEM;
+        }
+    }
+    
+    for (int r = 0; r < dl->num_readers; r++) {
+        dl_reader_t* rd = &dl->readers[r];
+        rd->loader = dl;
+        rd->id = r;
+        if (pthread_create(&rd->thread, NULL, dl_reader_thread, rd) != 0) {
+            AI_LOG_ERROR(ai_ctx, "Failed to start data loader reader thread");
+            dl_stop(dl);
+            dl_free(dl);
+            return GPUIO_ERROR_GENERAL;
+        }
+        rd->started = true;
+    }
+    
+    if (pthread_create(&dl->mixer, NULL, dl_mixer_thread, dl) != 0) {
+        AI_LOG_ERROR(ai_ctx, "Failed to start data loader mixer thread");
+        dl_stop(dl);
+        dl_free(dl);
+        return GPUIO_ERROR_GENERAL;
+    }
+    dl->mixer_started = true;
+    
+    *loader = dl;
+    
+    AI_LOG_INFO(ai_ctx, "Data loader created (shards=%d, readers=%d, batch=%d, prefetch=%d)",
+                config->num_shards, dl->num_readers, config->batch_size,
+                dl->config.prefetch_batches);
+    
+    return GPUIO_SUCCESS;
+}
+
+/**
+ * @brief Stop a data loader and free its buffers.
+ *
+ * Outstanding batches become invalid.
+ *
+ * @param loader Loader to destroy
+ * @return GPUIO_SUCCESS on success, error code otherwise
+ */
+gpuio_error_t gpuio_data_loader_destroy(gpuio_data_loader_t loader) {
+    if (!loader) {
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    dl_stop(loader);
+    dl_free(loader);
+    
+    return GPUIO_SUCCESS;
+}
+
+/* ============================================================================
+ * Consumer API
+ * ============================================================================ */
+
+/**
+ * @brief Get the next batch in sequence.
+ *
+ * Blocks until the batch is ready; the wait is reported in batch->stall_us
+ * and accumulated in the loader statistics. At most prefetch_batches + 1
+ * batches can be held unreleased.
+ *
+ * @param loader Data loader
+ * @param batch Output batch
+ * @return GPUIO_SUCCESS, GPUIO_ERROR_NOT_FOUND after the last epoch, or the
+ *         error that stopped the readers
+ */
+gpuio_error_t gpuio_data_loader_next(gpuio_data_loader_t loader,
+                                      gpuio_data_batch_t* batch) {
+    if (!loader || !batch) {
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    gpuio_error_t err = GPUIO_SUCCESS;
+    uint64_t start = gpuio_get_time_us();
+    
+    pthread_mutex_lock(&loader->lock);
+    int idx = (int)(loader->consume_seq % loader->num_slots);
+    dl_slot_t* slot = &loader->slots[idx];
+    
+    while (slot->state != DL_SLOT_READY) {
+        if (loader->status != GPUIO_SUCCESS) {
+            err = loader->status;
+            break;
+        }
+        if (loader->finished) {
+            err = GPUIO_ERROR_NOT_FOUND;
+            break;
+        }
+        if (loader->stopping) {
+            err = GPUIO_ERROR_CANCELED;
+            break;
+        }
+        pthread_cond_wait(&loader->slot_cond, &loader->lock);
+    }
+    
+    if (err != GPUIO_SUCCESS) {
+        pthread_mutex_unlock(&loader->lock);
+        return err;
+    }
+    
+    uint64_t stall = gpuio_get_time_us() - start;
+    
+    slot->state = DL_SLOT_IN_USE;
+    loader->consume_seq++;
+    
+    loader->stats.batches++;
+    loader->stats.records += (uint64_t)slot->count;
+    loader->stats.bytes += slot->bytes;
+    loader->stats.stall_us_total += stall;
+    loader->stats.last_stall_us = stall;
+    if (stall > loader->stats.stall_us_max) loader->stats.stall_us_max = stall;
+    pthread_mutex_unlock(&loader->lock);
+    
+    batch->inputs = slot->inputs;
+    batch->input_sizes = slot->sizes;
+    batch->num_inputs = slot->count;
+    batch->epoch = slot->epoch;
+    batch->index = slot->index;
+    batch->stall_us = stall;
+    batch->slot = idx;
+    
+    return GPUIO_SUCCESS;
+}
+
+/**
+ * @brief Return a batch's pinned buffer so it can be refilled.
+ *
+ * @param loader Data loader
+ * @param batch Batch obtained from gpuio_data_loader_next()
+ * @return GPUIO_SUCCESS on success, error code otherwise
+ */
+gpuio_error_t gpuio_data_loader_release(gpuio_data_loader_t loader,
+                                         gpuio_data_batch_t* batch) {
+    if (!loader || !batch || batch->slot < 0 || batch->slot >= loader->num_slots) {
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    pthread_mutex_lock(&loader->lock);
+    dl_slot_t* slot = &loader->slots[batch->slot];
+    if (slot->state != DL_SLOT_IN_USE || slot->index != batch->index) {
+        pthread_mutex_unlock(&loader->lock);
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    slot->state = DL_SLOT_FREE;
+    pthread_cond_broadcast(&loader->slot_cond);
+    pthread_mutex_unlock(&loader->lock);
+    
+    batch->inputs = NULL;
+    batch->input_sizes = NULL;
+    batch->num_inputs = 0;
+    batch->slot = -1;
+    
+    return GPUIO_SUCCESS;
+}
+
+/**
+ * @brief Get data loader statistics.
+ *
+ * @param loader Data loader
+ * @param stats Output statistics
+ * @return GPUIO_SUCCESS on success, error code otherwise
+ */
+gpuio_error_t gpuio_data_loader_get_stats(gpuio_data_loader_t loader,
+                                           gpuio_data_loader_stats_t* stats) {
+    if (!loader || !stats) {
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    pthread_mutex_lock(&loader->lock);
+    *stats = loader->stats;
+    pthread_mutex_unlock(&loader->lock);
+    
+    stats->avg_stall_us = stats->batches ?
+                          (double)stats->stall_us_total / (double)stats->batches : 0.0;
+    
+    return GPUIO_SUCCESS;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file data_loader_internal.h
+ * @brief AI Extensions module - Training data loader internal structures
+ * @version 1.1.0
+ *
+ * Pipeline: R reader threads stream shard files into per-reader chunk
+ * queues; a mixer thread pulls records round-robin from the readers,
+ * passes them through a bounded shuffle buffer and packs them into a ring
+ * of K+1 pinned batch slots consumed in order by gpuio_data_loader_next().
+ * Every random choice is drawn from the seed, and the round-robin order is
+ * independent of thread timing, so a seed fixes the batch sequence.
+ */
+
+#ifndef DATA_LOADER_INTERNAL_H
+#define DATA_LOADER_INTERNAL_H
+
+#include "ai_internal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * Configuration Constants
+ * ============================================================================ */
+
+#define DL_DEFAULT_READERS       4
+#define DL_DEFAULT_PREFETCH      4
+#define DL_DEFAULT_READ_SIZE     (1 << 20)
+#define DL_DEFAULT_MAX_RECORD    (16 << 20)
+#define DL_MAX_READERS           64
+#define DL_MAX_PREFETCH          64
+#define DL_CHUNK_QUEUE_DEPTH     4            /* Chunks buffered per reader */
+#define DL_LEN_PREFIX            4            /* uint32 LE length header */
+#define DL_BATCH_ALIGN           64           /* Record placement in a batch */
+
+/* ============================================================================
+ * Reader Chunks
+ * ============================================================================ */
+
+/* A run of whole records read from one shard */
+typedef struct dl_chunk {
+    char* data;
+    size_t len;
+    size_t cap;
+    bool epoch_end;              /* Marker: reader finished the epoch */
+    struct dl_chunk* next;
+} dl_chunk_t;
+
+typedef struct dl_reader {
+    struct gpuio_data_loader* loader;
+    int id;
+    pthread_t thread;
+    bool started;
+    
+    /* Chunk queue (loader lock) */
+    dl_chunk_t* head;
+    dl_chunk_t* tail;
+    int depth;
+    
+    /* Mixer-side cursor */
+    dl_chunk_t* cur;
+    size_t pos;
+    bool done;                   /* Epoch end seen this epoch */
+} dl_reader_t;
+
+/* ============================================================================
+ * Shuffle Buffer and Batch Ring
+ * ============================================================================ */
+
+typedef struct dl_record {
+    char* data;
+    size_t len;
+    size_t cap;
+} dl_record_t;
+
+typedef enum {
+    DL_SLOT_FREE = 0,
+    DL_SLOT_FILLING,
+    DL_SLOT_READY,
+    DL_SLOT_IN_USE
+} dl_slot_state_t;
+
+typedef struct dl_slot {
+    char* data;                  /* Pinned record storage */
+    size_t used;
+    size_t cap;
+    gpuio_memory_region_t region;
+    bool registered;
+    
+    size_t* offsets;
+    const void** inputs;
+    size_t* sizes;
+    int count;
+    uint64_t bytes;
+    
+    uint64_t epoch;
+    uint64_t index;
+    dl_slot_state_t state;
+} dl_slot_t;
+
+/* ============================================================================
+ * Loader
+ * ============================================================================ */
+
+struct gpuio_data_loader {
+    gpuio_ai_context_t ai_ctx;
+    gpuio_data_loader_config_t config;   /* shard_paths deep-copied */
+    
+    dl_reader_t* readers;
+    int num_readers;
+    
+    dl_chunk_t* free_chunks;
+    
+    /* Mixer state (mixer thread only) */
+    pthread_t mixer;
+    bool mixer_started;
+    dl_record_t* shuffle;
+    size_t shuffle_count;
+    uint64_t rng;
+    
+    dl_slot_t* slots;
+    int num_slots;
+    uint64_t produce_seq;
+    uint64_t consume_seq;
+    
+    bool finished;               /* Mixer emitted the last batch */
+    bool stopping;
+    gpuio_error_t status;
+    
+    /* One lock guards queues, slot states, flags and stats */
+    pthread_mutex_t lock;
+    pthread_cond_t chunk_cond;
+    pthread_cond_t slot_cond;
+    
+    gpuio_data_loader_stats_t stats;
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DATA_LOADER_INTERNAL_H */
@@ -0,0 +1,417 @@
+/**
+ * @file training.c
+ * @brief AI Extensions module - Training step with overlapped input prefetch
+ * @version 1.0.0
+ *
+ * Implements gpuio_ai_training_step. Inputs are staged into a ring of
+ * pinned buffers; with a lookahead source bound, a prefetch thread fetches
+ * and stages the inputs of upcoming steps while the caller's step body
+ * runs, and every step reports how much of that IO was hidden.
+ */
+
+#include "ai_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================================================
+ * Staging
+ * ============================================================================ */
+
+static int train_buf_reserve(struct ai_training* train, ai_train_buf_t* buf,
+                             size_t size) {
+    if (buf->cap >= size) return 0;
+    
+    size = gpuio_align_up(size, 4096);
+    char* data = NULL;
+    if (posix_memalign((void**)&data, 4096, size) != 0) return -1;
+    
+    gpuio_context_t ctx = ai_context_get_base(train->ai_ctx);
+    if (buf->registered) {
+        gpuio_unregister_memory(ctx, &buf->region);
+        buf->registered = false;
+    }
+    free(buf->data);
+    
+    buf->data = data;
+    buf->cap = size;
+    buf->registered = gpuio_register_memory(ctx, data, size,
+                                            GPUIO_MEM_READ_WRITE,
+                                            &buf->region) == GPUIO_SUCCESS;
+    return 0;
+}
+
+/* Copy a step's inputs and labels into a pinned buffer */
+static gpuio_error_t train_stage(struct ai_training* train, ai_train_buf_t* buf,
+                                 const gpuio_training_inputs_t* in) {
+    gpuio_context_t ctx = ai_context_get_base(train->ai_ctx);
+    int n = in->num_inputs > 0 ? in->num_inputs : 0;
+    
+    if (n > 0 && (!in->inputs || !in->input_sizes)) return GPUIO_ERROR_INVALID_ARG;
+    
+    if (n > buf->inputs_cap) {
+        const void** inputs = realloc((void*)buf->inputs, (size_t)n * sizeof(void*));
+        if (inputs) buf->inputs = inputs;
+        size_t* sizes = realloc(buf->sizes, (size_t)n * sizeof(size_t));
+        if (sizes) buf->sizes = sizes;
+        size_t* offsets = realloc(buf->offsets, (size_t)n * sizeof(size_t));
+        if (offsets) buf->offsets = offsets;
+        if (!inputs || !sizes || !offsets) return GPUIO_ERROR_NOMEM;
+        buf->inputs_cap = n;
+    }
+    
+    size_t total = 0;
+    for (int i = 0; i < n; i++) {
+        buf->offsets[i] = total;
+        total = gpuio_align_up(total + in->input_sizes[i], TRAIN_STAGE_ALIGN);
+    }
+    size_t labels_off = total;
+    total += in->labels ? in->labels_size : 0;
+    
+    if (train_buf_reserve(train, buf, total ? total : 1) != 0) return GPUIO_ERROR_NOMEM;
+    
+    for (int i = 0; i < n; i++) {
+        buf->sizes[i] = in->input_sizes[i];
+        buf->inputs[i] = buf->data + buf->offsets[i];
+        if (in->input_sizes[i] == 0) continue;
+        gpuio_error_t err = gpuio_memcpy(ctx, buf->data + buf->offsets[i],
+                                         in->inputs[i], in->input_sizes[i], NULL);
+        if (err != GPUIO_SUCCESS) return err;
+    }
+    
+    buf->staged.inputs = n > 0 ? buf->inputs : NULL;
+    buf->staged.input_sizes = n > 0 ? buf->sizes : NULL;
+    buf->staged.num_inputs = n;
+    buf->staged.labels = NULL;
+    buf->staged.labels_size = 0;
+    
+    if (in->labels && in->labels_size > 0) {
+        gpuio_error_t err = gpuio_memcpy(ctx, buf->data + labels_off, in->labels,
+                                         in->labels_size, NULL);
+        if (err != GPUIO_SUCCESS) return err;
+        buf->staged.labels = buf->data + labels_off;
+        buf->staged.labels_size = in->labels_size;
+    }
+    
+    return GPUIO_SUCCESS;
+}
+
+/* Fetch one step from the bound source and stage it */
+static gpuio_error_t train_fetch(struct ai_training* train, ai_train_buf_t* buf,
+                                 uint64_t step) {
+    if (train->loader) {
+        gpuio_data_batch_t batch;
+        gpuio_error_t err = gpuio_data_loader_next(train->loader, &batch);
+        if (err != GPUIO_SUCCESS) return err;
+        
+        gpuio_training_inputs_t in = {
+            .inputs = batch.inputs,
+            .input_sizes = batch.input_sizes,
+            .num_inputs = batch.num_inputs,
+        };
+        err = train_stage(train, buf, &in);
+        gpuio_data_loader_release(train->loader, &batch);
+        return err;
+    }
+    
+    gpuio_training_inputs_t in;
+    memset(&in, 0, sizeof(in));
+    gpuio_error_t err = train->source(train->source_data, step, &in);
+    if (err != GPUIO_SUCCESS) return err;
+    
+    return train_stage(train, buf, &in);
+}
+
+/* ============================================================================
+ * Prefetch Thread
+ * ============================================================================ */
+
+/*
+ * Fills buffers strictly in step order. Only a FREE buffer is refilled, so
+ * with N buffers the thread runs at most N - 1 steps ahead of the consumer.
+ */
+static void* train_prefetch_thread(void* arg) {
+    struct ai_training* train = (struct ai_training*)arg;
+    
+    pthread_mutex_lock(&train->lock);
+    while (!train->stopping && !train->exhausted) {
+        ai_train_buf_t* buf = &train->bufs[train->fetch_seq % train->num_buffers];
+        if (buf->state != TRAIN_BUF_FREE) {
+            pthread_cond_wait(&train->cond, &train->lock);
+            continue;
+        }
+        
+        uint64_t step = train->fetch_seq;
+        buf->state = TRAIN_BUF_FILLING;
+        pthread_mutex_unlock(&train->lock);
+        
+        uint64_t start = gpuio_get_time_us();
+        gpuio_error_t err = train_fetch(train, buf, step);
+        uint64_t elapsed = gpuio_get_time_us() - start;
+        
+        pthread_mutex_lock(&train->lock);
+        buf->step = step;
+        buf->fetch_us = elapsed;
+        buf->status = err;
+        buf->state = TRAIN_BUF_READY;
+        train->fetch_seq++;
+        if (err != GPUIO_SUCCESS) {
+            train->exhausted = true;
+            train->source_status = err;
+        }
+        pthread_cond_broadcast(&train->cond);
+    }
+    pthread_mutex_unlock(&train->lock);
+    
+    return NULL;
+}
+
+/* Stop prefetching and drop staged inputs; called with step_lock held */
+static void train_unbind(struct ai_training* train) {
+    pthread_mutex_lock(&train->lock);
+    train->stopping = true;
+    pthread_cond_broadcast(&train->cond);
+    pthread_mutex_unlock(&train->lock);
+    
+    if (train->running) {
+        pthread_join(train->thread, NULL);
+        train->running = false;
+    }
+    
+    for (int i = 0; i < TRAIN_MAX_BUFFERS; i++) {
+        train->bufs[i].state = TRAIN_BUF_FREE;
+    }
+    train->loader = NULL;
+    train->source = NULL;
+    train->source_data = NULL;
+    train->stopping = false;
+    train->exhausted = false;
+    train->source_status = GPUIO_SUCCESS;
+    train->fetch_seq = 0;
+    train->consume_seq = 0;
+}
+
+static gpuio_error_t train_bind(struct ai_training* train,
+                                const gpuio_training_params_t* params,
+                                int num_buffers) {
+    /* A loader takes precedence; compare what would actually be bound */
+    gpuio_training_source_fn source = params->loader ? NULL : params->source;
+    void* source_data = params->loader ? NULL : params->source_data;
+    bool has_source = params->loader || source;
+    
+    if (train->loader == params->loader && train->source == source &&
+        train->source_data == source_data &&
+        train->num_buffers == num_buffers && (train->running || !has_source)) {
+        return GPUIO_SUCCESS;
+    }
+    
+    train_unbind(train);
+    train->num_buffers = num_buffers;
+    if (!has_source) return GPUIO_SUCCESS;
+    
+    train->loader = params->loader;
+    train->source = source;
+    train->source_data = source_data;
+    
+    if (pthread_create(&train->thread, NULL, train_prefetch_thread, train) != 0) {
+        AI_LOG_ERROR(train->ai_ctx, "Failed to start training prefetch thread");
+        train->loader = NULL;
+        train->source = NULL;
+        return GPUIO_ERROR_GENERAL;
+    }
+    train->running = true;
+    
+    return GPUIO_SUCCESS;
+}
+
+/* ============================================================================
+ * Subsystem Lifecycle
+ * ============================================================================ */
+
+int ai_training_init(struct ai_training* train, gpuio_ai_context_t ai_ctx) {
+    if (!train) return -1;
+    
+    memset(train, 0, sizeof(*train));
+    train->ai_ctx = ai_ctx;
+    train->num_buffers = TRAIN_DEFAULT_BUFFERS;
+    
+    pthread_mutex_init(&train->step_lock, NULL);
+    pthread_mutex_init(&train->lock, NULL);
+    pthread_cond_init(&train->cond, NULL);
+    
+    return 0;
+}
+
+void ai_training_cleanup(struct ai_training* train) {
+    if (!train) return;
+    
+    pthread_mutex_lock(&train->step_lock);
+    train_unbind(train);
+    
+    gpuio_context_t ctx = ai_context_get_base(train->ai_ctx);
+    for (int i = 0; i < TRAIN_MAX_BUFFERS; i++) {
+        ai_train_buf_t* buf = &train->bufs[i];
+        if (buf->registered) gpuio_unregister_memory(ctx, &buf->region);
+        free(buf->data);
+        free((void*)buf->inputs);
+        free(buf->sizes);
+        free(buf->offsets);
+        memset(buf, 0, sizeof(*buf));
+    }
+    pthread_mutex_unlock(&train->step_lock);
+    
+    pthread_mutex_destroy(&train->step_lock);
+    pthread_mutex_destroy(&train->lock);
+    pthread_cond_destroy(&train->cond);
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+/**
+ * @brief Execute one training step.
+ *
+ * Takes this step's staged inputs (waiting for the prefetch thread if they
+ * are not ready yet), runs the step body, returns the buffer for refill
+ * and applies the checkpoint policy. Without a lookahead source, the
+ * inputs in params are staged synchronously and nothing overlaps.
+ *
+ * @param ai_ctx AI context
+ * @param params Step parameters
+ * @param result Output step result (optional)
+ * @return GPUIO_SUCCESS, GPUIO_ERROR_NOT_FOUND when the source is
+ *         exhausted, or an error code
+ */
+gpuio_error_t gpuio_ai_training_step(gpuio_ai_context_t ai_ctx,
+                                      const gpuio_training_params_t* params,
+                                      gpuio_training_result_t* result) {
+    if (!params) {
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    gpuio_error_t err = ai_context_validate(ai_ctx, false, false, false);
+    if (err != GPUIO_SUCCESS) return err;
+    
+    int num_buffers = params->num_buffers ? params->num_buffers : TRAIN_DEFAULT_BUFFERS;
+    if (num_buffers < 2 || num_buffers > TRAIN_MAX_BUFFERS) {
+        return GPUIO_ERROR_INVALID_ARG;
+    }
+    
+    struct ai_training* train = ((struct gpuio_ai_context*)ai_ctx)->training;
+    gpuio_training_result_t res;
+    memset(&res, 0, sizeof(res));
+    
+    uint64_t start = gpuio_get_time_us();
+    
+    pthread_mutex_lock(&train->step_lock);
+    
+    err = train_bind(train, params, num_buffers);
+    if (err != GPUIO_SUCCESS) {
+        pthread_mutex_unlock(&train->step_lock);
+        return err;
+    }
+    
+    ai_train_buf_t* buf;
+    if (train->running) {
+        pthread_mutex_lock(&train->lock);
+        buf = &train->bufs[train->consume_seq % train->num_buffers];
+        while (buf->state != TRAIN_BUF_READY && !train->exhausted) {
+            pthread_cond_wait(&train->cond, &train->lock);
+        }
+        if (buf->state != TRAIN_BUF_READY) {
+            /* Source ended on an earlier step; gpuio_ai_training_reset rebinds */
+            err = train->source_status;
+            pthread_mutex_unlock(&train->lock);
+            pthread_mutex_unlock(&train->step_lock);
+            if (result) {
+                memset(result, 0, sizeof(*result));
+                result->status = err;
+            }
+            return err;
+        }
+        buf->state = TRAIN_BUF_IN_USE;
+        train->consume_seq++;
+        pthread_mutex_unlock(&train->lock);
+        
+        res.io_wait_us = gpuio_get_time_us() - start;
+        res.fetch_time_us = buf->fetch_us;
+        err = buf->status;
+    } else {
+        buf = &train->bufs[0];
+        gpuio_training_inputs_t in = {
+            .inputs = params->inputs,
+            .input_sizes = params->input_sizes,
+            .num_inputs = params->num_inputs,
+            .labels = params->labels,
+            .labels_size = params->labels_size,
+        };
+        err = train_stage(train, buf, &in);
+        res.io_wait_us = gpuio_get_time_us() - start;
+        res.fetch_time_us = res.io_wait_us;
+    }
+    
+    if (res.fetch_time_us > 0) {
+        uint64_t hidden = res.fetch_time_us > res.io_wait_us ?
+                          res.fetch_time_us - res.io_wait_us : 0;
+        res.overlap = (double)hidden / (double)res.fetch_time_us;
+    }
+    
+    if (err == GPUIO_SUCCESS && params->compute) {
+        err = params->compute(params->compute_data, &buf->staged, &res.loss);
+    }
+    
+    /* Hand the buffer back so step N + num_buffers can be fetched into it */
+    pthread_mutex_lock(&train->lock);
+    buf->state = TRAIN_BUF_FREE;
+    pthread_cond_broadcast(&train->cond);
+    pthread_mutex_unlock(&train->lock);
+    
+    if (err == GPUIO_SUCCESS) {
+        res.step = train->steps++;
+        
+        int interval = params->checkpoint_interval_steps;
+        if (params->checkpoint_after_step && params->checkpoint_path &&
+            (interval <= 0 || train->steps % (uint64_t)interval == 0)) {
+            err = gpuio_ai_checkpoint_save(ai_ctx, params->checkpoint_path, true,
+                                           params->stream);
+            if (err == GPUIO_SUCCESS) {
+                res.checkpoint_saved = true;
+                snprintf(res.checkpoint_path, sizeof(res.checkpoint_path), "%s",
+                         params->checkpoint_path);
+            }
+        }
+    }
+    
+    pthread_mutex_unlock(&train->step_lock);
+    
+    res.step_time_us = gpuio_get_time_us() - start;
+    res.status = err;
+    if (result) *result = res;
+    
+    if (err == GPUIO_SUCCESS) {
+        ai_context_update_stats(ai_ctx, 1, 0);
+    }
+    
+    return err;
+}
+
+/**
+ * @brief Stop input prefetching and release the bound source.
+ *
+ * @param ai_ctx AI context
+ * @return GPUIO_SUCCESS on success, error code otherwise
+ */
+gpuio_error_t gpuio_ai_training_reset(gpuio_ai_context_t ai_ctx) {
+    gpuio_error_t err = ai_context_validate(ai_ctx, false, false, false);
+    if (err != GPUIO_SUCCESS) return err;
+    
+    struct ai_training* train = ((struct gpuio_ai_context*)ai_ctx)->training;
+    
+    pthread_mutex_lock(&train->step_lock);
+    train_unbind(train);
+    train->steps = 0;
+    pthread_mutex_unlock(&train->step_lock);
+    
+    return GPUIO_SUCCESS;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file training_internal.h
+ * @brief AI Extensions module - Training step pipeline internal structures
+ * @version 1.1.0
+ *
+ * gpuio_ai_training_step stages each step's inputs and labels into one of
+ * N pinned buffers. When a lookahead source is bound, a prefetch thread
+ * keeps the buffers of the following steps filling while the current step
+ * runs, so step N+1's IO overlaps step N's compute.
+ */
+
+#ifndef TRAINING_INTERNAL_H
+#define TRAINING_INTERNAL_H
+
+#include "ai_internal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * Configuration Constants
+ * ============================================================================ */
+
+#define TRAIN_DEFAULT_BUFFERS    2
+#define TRAIN_MAX_BUFFERS        8
+#define TRAIN_STAGE_ALIGN        64
+
+/* ============================================================================
+ * Staging Buffers
+ * ============================================================================ */
+
+typedef enum {
+    TRAIN_BUF_FREE = 0,
+    TRAIN_BUF_FILLING,
+    TRAIN_BUF_READY,
+    TRAIN_BUF_IN_USE
+} ai_train_buf_state_t;
+
+typedef struct ai_train_buf {
+    char* data;                  /* Pinned: inputs, then labels */
+    size_t cap;
+    gpuio_memory_region_t region;
+    bool registered;
+    
+    const void** inputs;
+    size_t* sizes;
+    size_t* offsets;
+    int inputs_cap;
+    gpuio_training_inputs_t staged;
+    
+    uint64_t step;
+    uint64_t fetch_us;
+    gpuio_error_t status;
+    ai_train_buf_state_t state;
+} ai_train_buf_t;
+
+/* ============================================================================
+ * Training Subsystem
+ * ============================================================================ */
+
+struct ai_training {
+    gpuio_ai_context_t ai_ctx;
+    
+    ai_train_buf_t bufs[TRAIN_MAX_BUFFERS];
+    int num_buffers;
+    
+    /* Bound lookahead source */
+    gpuio_data_loader_t loader;
+    gpuio_training_source_fn source;
+    void* source_data;
+    
+    /* Prefetch thread */
+    pthread_t thread;
+    bool running;
+    bool stopping;
+    bool exhausted;              /* Source returned its last batch or an error */
+    gpuio_error_t source_status; /* Why it stopped */
+    uint64_t fetch_seq;
+    uint64_t consume_seq;
+    
+    uint64_t steps;              /* Completed steps, for checkpoint intervals */
+    
+    /* Serializes training_step/reset callers */
+    pthread_mutex_t step_lock;
+    
+    /* Guards buffer states and the prefetch flags */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+/* ============================================================================
+ * Training Internal Functions
+ * ============================================================================ */
+
+int ai_training_init(struct ai_training* train, gpuio_ai_context_t ai_ctx);
+void ai_training_cleanup(struct ai_training* train);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRAINING_INTERNAL_H */
@@ -0,0 +1,127 @@
+/**
+ * @file cufile_compat.h
+ * @brief LocalIO module - cuFile ABI subset
+ * @version 1.0.0
+ *
+ * Minimal declarations of the cuFile (GPUDirect Storage) types and entry
+ * points used by LocalIO. They mirror the layout of NVIDIA's cufile.h so
+ * that the real libcufile and the host-memory stand-in (cufile_stub.c) can
+ * be loaded interchangeably without pulling in the CUDA headers.
+ */
+
+#ifndef CUFILE_COMPAT_H
+#define CUFILE_COMPAT_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <time.h>
+
+/* Error codes (subset of CUfileOpError) */
+typedef enum CUfileOpError {
+    CU_FILE_SUCCESS = 0,
+    CU_FILE_DRIVER_NOT_INITIALIZED = 5001,
+    CU_FILE_INVALID_FILE_TYPE = 5018,
+    CU_FILE_INVALID_VALUE = 5022,
+    CU_FILE_MEMORY_ALREADY_REGISTERED = 5023,
+    CU_FILE_MEMORY_NOT_REGISTERED = 5024,
+    CU_FILE_DRIVER_ALREADY_OPEN = 5026,
+    CU_FILE_HANDLE_NOT_REGISTERED = 5027,
+    CU_FILE_INTERNAL_ERROR = 5030,
+    CU_FILE_BATCH_SUBMIT_FAILED = 5035,
+    CU_FILE_BATCH_FULL = 5037,
+} CUfileOpError;
+
+typedef struct CUfileError {
+    CUfileOpError err;
+    int cu_err;                  /* CUresult */
+} CUfileError_t;
+
+/* File handle registration */
+enum CUfileFileHandleType {
+    CU_FILE_HANDLE_TYPE_OPAQUE_FD = 1,
+    CU_FILE_HANDLE_TYPE_OPAQUE_WIN32 = 2,
+    CU_FILE_HANDLE_TYPE_USERSPACE_FS = 3,
+};
+
+typedef struct CUfileDescr_t {
+    enum CUfileFileHandleType type;
+    union {
+        int fd;
+        void* handle;
+    } handle;
+    const void* fs_ops;
+} CUfileDescr_t;
+
+typedef void* CUfileHandle_t;
+
+/* Batch IO */
+typedef enum CUfileOpcode {
+    CUFILE_READ = 0,
+    CUFILE_WRITE = 1,
+} CUfileOpcode_t;
+
+typedef enum CUFILEStatus_enum {
+    CUFILE_WAITING = 0x000001,
+    CUFILE_PENDING = 0x000002,
+    CUFILE_INVALID = 0x000004,
+    CUFILE_CANCELED = 0x000008,
+    CUFILE_COMPLETE = 0x000010,
+    CUFILE_TIMEOUT = 0x000020,
+    CUFILE_FAILED = 0x000040,
+} CUfileStatus_t;
+
+typedef enum cufileBatchMode {
+    CUFILE_BATCH = 1,
+} CUfileBatchMode_t;
+
+typedef struct CUfileIOParams {
+    CUfileBatchMode_t mode;
+    union {
+        struct {
+            void* devPtr_base;
+            off_t file_offset;
+            off_t devPtr_offset;
+            size_t size;
+        } batch;
+    } u;
+    CUfileHandle_t fh;
+    CUfileOpcode_t opcode;
+    void* cookie;
+} CUfileIOParams_t;
+
+typedef struct CUfileIOEvents {
+    void* cookie;
+    CUfileStatus_t status;
+    size_t ret;
+} CUfileIOEvents_t;
+
+typedef void* CUfileBatchHandle_t;
+
+/* Maximum entries per batch (cuFile default for max_batch_io_size) */
+#define CUFILE_MAX_BATCH_IO_SIZE 128
+
+/* Entry point signatures, as resolved with dlsym() */
+typedef CUfileError_t (*cufile_driver_open_fn)(void);
+typedef CUfileError_t (*cufile_driver_close_fn)(void);
+typedef CUfileError_t (*cufile_handle_register_fn)(CUfileHandle_t* fh,
+                                                   CUfileDescr_t* descr);
+typedef void (*cufile_handle_deregister_fn)(CUfileHandle_t fh);
+typedef ssize_t (*cufile_read_fn)(CUfileHandle_t fh, void* buf_base,
+                                  size_t size, off_t file_offset,
+                                  off_t buf_offset);
+typedef ssize_t (*cufile_write_fn)(CUfileHandle_t fh, const void* buf_base,
+                                   size_t size, off_t file_offset,
+                                   off_t buf_offset);
+typedef CUfileError_t (*cufile_batch_setup_fn)(CUfileBatchHandle_t* batch,
+                                               unsigned nr);
+typedef CUfileError_t (*cufile_batch_submit_fn)(CUfileBatchHandle_t batch,
+                                                unsigned nr,
+                                                CUfileIOParams_t* iocbp,
+                                                unsigned int flags);
+typedef CUfileError_t (*cufile_batch_status_fn)(CUfileBatchHandle_t batch,
+                                                unsigned min_nr, unsigned* nr,
+                                                CUfileIOEvents_t* iocbp,
+                                                struct timespec* timeout);
+typedef void (*cufile_batch_destroy_fn)(CUfileBatchHandle_t batch);
+
+#endif /* CUFILE_COMPAT_H */
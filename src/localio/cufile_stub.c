@@ -0,0 +1,557 @@
+/**
+ * @file cufile_stub.c
+ * @brief LocalIO module - cuFile-compatible GDS stand-in library
+ * @version 1.0.0
+ *
+ * Implements the cuFile read/write, buffer registration and batch IO entry
+ * points over host memory so the GDS code path in gds.c can be exercised
+ * and benchmarked on machines without the GPUDirect Storage stack. Built as
+ * libcufile.so; point GPUIO_CUFILE_LIBRARY (or LD_LIBRARY_PATH) at it.
+ *
+ * Synchronous reads and writes use pread/pwrite directly. Batch IO is
+ * serviced by a small pool of worker threads (GPUIO_CUFILE_STUB_THREADS,
+ * default 4) so submissions complete asynchronously like the real driver.
+ */
+
+#include "cufile_compat.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#define STUB_API __attribute__((visibility("default")))
+
+#define STUB_DEFAULT_THREADS   4
+#define STUB_MAX_THREADS       64
+#define STUB_MAX_BUFFERS       1024
+#define STUB_HANDLE_MAGIC      0x43554649u  /* "CUFI" */
+
+/* Registered file handle */
+typedef struct stub_handle {
+    uint32_t magic;
+    int fd;
+    int own_fd;                 /* Buffered reopen of an O_DIRECT fd, or -1 */
+} stub_handle_t;
+
+struct stub_batch;
+
+/* One batch entry, queued to the worker pool */
+typedef struct stub_io {
+    CUfileIOParams_t params;
+    CUfileStatus_t status;
+    ssize_t ret;
+    int reported;
+    struct stub_batch* batch;
+    struct stub_io* next;
+} stub_io_t;
+
+/* Batch handle */
+typedef struct stub_batch {
+    stub_io_t* ios;
+    unsigned max_nr;
+    unsigned num_submitted;
+    unsigned num_done;          /* Completed, failed or canceled */
+    unsigned num_reported;
+    unsigned in_flight;         /* Picked up by a worker */
+    int canceled;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} stub_batch_t;
+
+/* Driver state. Lock order: stub.lock before any batch->lock */
+static struct {
+    int open_count;
+    pthread_t threads[STUB_MAX_THREADS];
+    int num_threads;
+    int running;
+    
+    /* Work queue */
+    stub_io_t* head;
+    stub_io_t* tail;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    
+    /* Registered buffers (bookkeeping only, memory is host-resident) */
+    const void* buffers[STUB_MAX_BUFFERS];
+    int num_buffers;
+} stub = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static CUfileError_t stub_status(CUfileOpError err) {
+    CUfileError_t status = { .err = err, .cu_err = 0 };
+    return status;
+}
+
+static stub_handle_t* stub_get_handle(CUfileHandle_t fh) {
+    stub_handle_t* h = (stub_handle_t*)fh;
+    if (!h || h->magic != STUB_HANDLE_MAGIC) return NULL;
+    return h;
+}
+
+/* Full-length pread/pwrite, retrying short transfers */
+static ssize_t stub_pio(int fd, int write_op, void* buf, size_t size,
+                        off_t offset) {
+    size_t done = 0;
+    
+    while (done < size) {
+        ssize_t n = write_op ?
+            pwrite(fd, (char*)buf + done, size - done, offset + done) :
+            pread(fd, (char*)buf + done, size - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break; /* EOF */
+        done += n;
+    }
+    
+    return (ssize_t)done;
+}
+
+static void stub_io_execute(stub_io_t* io) {
+    stub_handle_t* h = stub_get_handle(io->params.fh);
+    if (!h) {
+        io->ret = -EBADF;
+        io->status = CUFILE_FAILED;
+        return;
+    }
+    
+    char* buf = (char*)io->params.u.batch.devPtr_base +
+                io->params.u.batch.devPtr_offset;
+    ssize_t n = stub_pio(h->fd, io->params.opcode == CUFILE_WRITE, buf,
+                         io->params.u.batch.size,
+                         io->params.u.batch.file_offset);
+    if (n < 0) {
+        io->ret = -errno;
+        io->status = CUFILE_FAILED;
+    } else {
+        io->ret = n;
+        io->status = CUFILE_COMPLETE;
+    }
+}
+
+static void* stub_worker(void* arg) {
+    (void)arg;
+    
+    pthread_mutex_lock(&stub.lock);
+    while (stub.running) {
+        stub_io_t* io = stub.head;
+        if (!io) {
+            pthread_cond_wait(&stub.cond, &stub.lock);
+            continue;
+        }
+        stub.head = io->next;
+        if (!stub.head) stub.tail = NULL;
+        
+        /*
+         * Claim the entry before dropping stub.lock: once it is off the
+         * queue, only in_flight keeps cuFileBatchIODestroy from freeing
+         * the batch under us. Entries canceled while queued are skipped
+         * without touching the batch again.
+         */
+        stub_batch_t* batch = io->batch;
+        pthread_mutex_lock(&batch->lock);
+        int skip = (io->status == CUFILE_CANCELED);
+        if (!skip) {
+            io->status = CUFILE_PENDING;
+            batch->in_flight++;
+        }
+        pthread_mutex_unlock(&batch->lock);
+        pthread_mutex_unlock(&stub.lock);
+        
+        if (!skip) {
+            stub_io_execute(io);
+            
+            pthread_mutex_lock(&batch->lock);
+            batch->in_flight--;
+            batch->num_done++;
+            pthread_cond_broadcast(&batch->cond);
+            pthread_mutex_unlock(&batch->lock);
+        }
+        
+        pthread_mutex_lock(&stub.lock);
+    }
+    pthread_mutex_unlock(&stub.lock);
+    
+    return NULL;
+}
+
+/* ============================================================================
+ * Driver
+ * ============================================================================ */
+
+STUB_API CUfileError_t cuFileDriverOpen(void) {
+    pthread_mutex_lock(&stub.lock);
+    
+    if (stub.open_count++ > 0) {
+        pthread_mutex_unlock(&stub.lock);
+        return stub_status(CU_FILE_SUCCESS);
+    }
+    
+    int threads = STUB_DEFAULT_THREADS;
+    const char* env = getenv("GPUIO_CUFILE_STUB_THREADS");
+    if (env && atoi(env) > 0) {
+        threads = atoi(env);
+    }
+    if (threads > STUB_MAX_THREADS) threads = STUB_MAX_THREADS;
+    
+    stub.running = 1;
+    stub.num_threads = 0;
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&stub.threads[i], NULL, stub_worker, NULL) != 0) {
+            break;
+        }
+        stub.num_threads++;
+    }
+    
+    if (stub.num_threads == 0) {
+        stub.running = 0;
+        stub.open_count = 0;
+        pthread_mutex_unlock(&stub.lock);
+        return stub_status(CU_FILE_INTERNAL_ERROR);
+    }
+    
+    pthread_mutex_unlock(&stub.lock);
+    return stub_status(CU_FILE_SUCCESS);
+}
+
+STUB_API CUfileError_t cuFileDriverClose(void) {
+    pthread_mutex_lock(&stub.lock);
+    
+    if (stub.open_count == 0) {
+        pthread_mutex_unlock(&stub.lock);
+        return stub_status(CU_FILE_DRIVER_NOT_INITIALIZED);
+    }
+    if (--stub.open_count > 0) {
+        pthread_mutex_unlock(&stub.lock);
+        return stub_status(CU_FILE_SUCCESS);
+    }
+    
+    stub.running = 0;
+    pthread_cond_broadcast(&stub.cond);
+    int num_threads = stub.num_threads;
+    pthread_mutex_unlock(&stub.lock);
+    
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(stub.threads[i], NULL);
+    }
+    
+    pthread_mutex_lock(&stub.lock);
+    stub.num_threads = 0;
+    stub.head = stub.tail = NULL;
+    stub.num_buffers = 0;
+    pthread_mutex_unlock(&stub.lock);
+    
+    return stub_status(CU_FILE_SUCCESS);
+}
+
+/* Newer cufile.h maps cuFileDriverClose to the _v2 symbol */
+STUB_API CUfileError_t cuFileDriverClose_v2(void) {
+    return cuFileDriverClose();
+}
+
+/* ============================================================================
+ * Handle and buffer registration
+ * ============================================================================ */
+
+STUB_API CUfileError_t cuFileHandleRegister(CUfileHandle_t* fh,
+                                            CUfileDescr_t* descr) {
+    if (!fh || !descr) return stub_status(CU_FILE_INVALID_VALUE);
+    if (descr->type != CU_FILE_HANDLE_TYPE_OPAQUE_FD || descr->handle.fd < 0) {
+        return stub_status(CU_FILE_INVALID_FILE_TYPE);
+    }
+    
+    stub_handle_t* h = calloc(1, sizeof(stub_handle_t));
+    if (!h) return stub_status(CU_FILE_INTERNAL_ERROR);
+    
+    h->magic = STUB_HANDLE_MAGIC;
+    h->fd = descr->handle.fd;
+    h->own_fd = -1;
+    
+    /* The driver takes unaligned IO on O_DIRECT descriptors; pread doesn't,
+     * so the stand-in goes through a buffered reopen of the same file */
+    int flags = fcntl(h->fd, F_GETFL);
+    if (flags >= 0 && (flags & O_DIRECT)) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/self/fd/%d", h->fd);
+        h->own_fd = open(path, flags & O_ACCMODE);
+        if (h->own_fd < 0) {
+            free(h);
+            return stub_status(CU_FILE_INTERNAL_ERROR);
+        }
+        h->fd = h->own_fd;
+    }
+    
+    *fh = h;
+    return stub_status(CU_FILE_SUCCESS);
+}
+
+STUB_API void cuFileHandleDeregister(CUfileHandle_t fh) {
+    stub_handle_t* h = stub_get_handle(fh);
+    if (!h) return;
+    
+    h->magic = 0;
+    if (h->own_fd >= 0) close(h->own_fd);
+    free(h);
+}
+
+STUB_API CUfileError_t cuFileBufRegister(const void* buf_base, size_t length,
+                                         int flags) {
+    (void)flags;
+    
+    if (!buf_base || length == 0) return stub_status(CU_FILE_INVALID_VALUE);
+    
+    pthread_mutex_lock(&stub.lock);
+    
+    for (int i = 0; i < stub.num_buffers; i++) {
+        if (stub.buffers[i] == buf_base) {
+            pthread_mutex_unlock(&stub.lock);
+            return stub_status(CU_FILE_MEMORY_ALREADY_REGISTERED);
+        }
+    }
+    
+    if (stub.num_buffers >= STUB_MAX_BUFFERS) {
+        pthread_mutex_unlock(&stub.lock);
+        return stub_status(CU_FILE_INTERNAL_ERROR);
+    }
+    
+    stub.buffers[stub.num_buffers++] = buf_base;
+    pthread_mutex_unlock(&stub.lock);
+    
+    return stub_status(CU_FILE_SUCCESS);
+}
+
+STUB_API CUfileError_t cuFileBufDeregister(const void* buf_base) {
+    pthread_mutex_lock(&stub.lock);
+    
+    for (int i = 0; i < stub.num_buffers; i++) {
+        if (stub.buffers[i] == buf_base) {
+            stub.buffers[i] = stub.buffers[--stub.num_buffers];
+            pthread_mutex_unlock(&stub.lock);
+            return stub_status(CU_FILE_SUCCESS);
+        }
+    }
+    
+    pthread_mutex_unlock(&stub.lock);
+    return stub_status(CU_FILE_MEMORY_NOT_REGISTERED);
+}
+
+/* ============================================================================
+ * Synchronous IO
+ * ============================================================================ */
+
+STUB_API ssize_t cuFileRead(CUfileHandle_t fh, void* buf_base, size_t size,
+                            off_t file_offset, off_t buf_offset) {
+    stub_handle_t* h = stub_get_handle(fh);
+    if (!h) return -CU_FILE_HANDLE_NOT_REGISTERED;
+    if (!buf_base) return -CU_FILE_INVALID_VALUE;
+    
+    return stub_pio(h->fd, 0, (char*)buf_base + buf_offset, size, file_offset);
+}
+
+STUB_API ssize_t cuFileWrite(CUfileHandle_t fh, const void* buf_base,
+                             size_t size, off_t file_offset,
+                             off_t buf_offset) {
+    stub_handle_t* h = stub_get_handle(fh);
+    if (!h) return -CU_FILE_HANDLE_NOT_REGISTERED;
+    if (!buf_base) return -CU_FILE_INVALID_VALUE;
+    
+    return stub_pio(h->fd, 1, (char*)buf_base + buf_offset, size, file_offset);
+}
+
+/* ============================================================================
+ * Batch IO
+ * ============================================================================ */
+
+STUB_API CUfileError_t cuFileBatchIOSetUp(CUfileBatchHandle_t* batch_idp,
+                                          unsigned nr) {
+    if (!batch_idp || nr == 0 || nr > CUFILE_MAX_BATCH_IO_SIZE) {
+        return stub_status(CU_FILE_INVALID_VALUE);
+    }
+    if (stub.open_count == 0) {
+        return stub_status(CU_FILE_DRIVER_NOT_INITIALIZED);
+    }
+    
+    stub_batch_t* batch = calloc(1, sizeof(stub_batch_t));
+    if (!batch) return stub_status(CU_FILE_INTERNAL_ERROR);
+    
+    batch->ios = calloc(nr, sizeof(stub_io_t));
+    if (!batch->ios) {
+        free(batch);
+        return stub_status(CU_FILE_INTERNAL_ERROR);
+    }
+    
+    batch->max_nr = nr;
+    pthread_mutex_init(&batch->lock, NULL);
+    pthread_cond_init(&batch->cond, NULL);
+    
+    *batch_idp = batch;
+    return stub_status(CU_FILE_SUCCESS);
+}
+
+STUB_API CUfileError_t cuFileBatchIOSubmit(CUfileBatchHandle_t batch_idp,
+                                           unsigned nr,
+                                           CUfileIOParams_t* iocbp,
+                                           unsigned int flags) {
+    (void)flags;
+    
+    stub_batch_t* batch = (stub_batch_t*)batch_idp;
+    if (!batch || !iocbp || nr == 0) return stub_status(CU_FILE_INVALID_VALUE);
+    
+    pthread_mutex_lock(&batch->lock);
+    if (batch->num_submitted + nr > batch->max_nr) {
+        pthread_mutex_unlock(&batch->lock);
+        return stub_status(CU_FILE_BATCH_FULL);
+    }
+    
+    /* Validate before queueing anything */
+    for (unsigned i = 0; i < nr; i++) {
+        if (iocbp[i].mode != CUFILE_BATCH || !stub_get_handle(iocbp[i].fh) ||
+            (iocbp[i].opcode != CUFILE_READ && iocbp[i].opcode != CUFILE_WRITE)) {
+            pthread_mutex_unlock(&batch->lock);
+            return stub_status(CU_FILE_BATCH_SUBMIT_FAILED);
+        }
+    }
+    
+    stub_io_t* first = &batch->ios[batch->num_submitted];
+    for (unsigned i = 0; i < nr; i++) {
+        stub_io_t* io = &first[i];
+        io->params = iocbp[i];
+        io->status = CUFILE_WAITING;
+        io->ret = 0;
+        io->reported = 0;
+        io->batch = batch;
+        io->next = (i + 1 < nr) ? &first[i + 1] : NULL;
+    }
+    batch->num_submitted += nr;
+    pthread_mutex_unlock(&batch->lock);
+    
+    /* Hand the chain to the worker pool */
+    pthread_mutex_lock(&stub.lock);
+    if (stub.tail) {
+        stub.tail->next = first;
+    } else {
+        stub.head = first;
+    }
+    stub.tail = &first[nr - 1];
+    pthread_cond_broadcast(&stub.cond);
+    pthread_mutex_unlock(&stub.lock);
+    
+    return stub_status(CU_FILE_SUCCESS);
+}
+
+STUB_API CUfileError_t cuFileBatchIOGetStatus(CUfileBatchHandle_t batch_idp,
+                                              unsigned min_nr, unsigned* nr,
+                                              CUfileIOEvents_t* iocbp,
+                                              struct timespec* timeout) {
+    stub_batch_t* batch = (stub_batch_t*)batch_idp;
+    if (!batch || !nr || !iocbp) return stub_status(CU_FILE_INVALID_VALUE);
+    
+    unsigned max_events = *nr;
+    if (min_nr > max_events) min_nr = max_events;
+    
+    struct timespec deadline;
+    if (timeout) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout->tv_sec;
+        deadline.tv_nsec += timeout->tv_nsec;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+    
+    pthread_mutex_lock(&batch->lock);
+    
+    /* Wait until enough unreported completions are available */
+    while (batch->num_done - batch->num_reported < min_nr &&
+           batch->num_done < batch->num_submitted) {
+        int rc = timeout ?
+            pthread_cond_timedwait(&batch->cond, &batch->lock, &deadline) :
+            pthread_cond_wait(&batch->cond, &batch->lock);
+        if (rc != 0) break;
+    }
+    
+    unsigned count = 0;
+    for (unsigned i = 0; i < batch->num_submitted && count < max_events; i++) {
+        stub_io_t* io = &batch->ios[i];
+        if (io->reported) continue;
+        if (io->status != CUFILE_COMPLETE && io->status != CUFILE_FAILED &&
+            io->status != CUFILE_CANCELED) {
+            continue;
+        }
+        
+        iocbp[count].cookie = io->params.cookie;
+        iocbp[count].status = io->status;
+        iocbp[count].ret = (size_t)io->ret;
+        io->reported = 1;
+        batch->num_reported++;
+        count++;
+    }
+    
+    pthread_mutex_unlock(&batch->lock);
+    
+    *nr = count;
+    return stub_status(CU_FILE_SUCCESS);
+}
+
+STUB_API CUfileError_t cuFileBatchIOCancel(CUfileBatchHandle_t batch_idp) {
+    stub_batch_t* batch = (stub_batch_t*)batch_idp;
+    if (!batch) return stub_status(CU_FILE_INVALID_VALUE);
+    
+    pthread_mutex_lock(&batch->lock);
+    batch->canceled = 1;
+    for (unsigned i = 0; i < batch->num_submitted; i++) {
+        if (batch->ios[i].status == CUFILE_WAITING) {
+            batch->ios[i].status = CUFILE_CANCELED;
+            batch->num_done++;
+        }
+    }
+    pthread_cond_broadcast(&batch->cond);
+    pthread_mutex_unlock(&batch->lock);
+    
+    return stub_status(CU_FILE_SUCCESS);
+}
+
+STUB_API void cuFileBatchIODestroy(CUfileBatchHandle_t batch_idp) {
+    stub_batch_t* batch = (stub_batch_t*)batch_idp;
+    if (!batch) return;
+    
+    /* Cancel whatever is still queued, then drain in-flight entries */
+    cuFileBatchIOCancel(batch);
+    
+    pthread_mutex_lock(&batch->lock);
+    while (batch->in_flight > 0 || batch->num_done < batch->num_submitted) {
+        pthread_cond_wait(&batch->cond, &batch->lock);
+    }
+    pthread_mutex_unlock(&batch->lock);
+    
+    /*
+     * Canceled entries may still sit in the work queue; unlink them.
+     * Workers only inspect an entry's batch while holding stub.lock, so
+     * nothing references the batch once this pass is done.
+     */
+    pthread_mutex_lock(&stub.lock);
+    stub_io_t** link = &stub.head;
+    stub.tail = NULL;
+    while (*link) {
+        if ((*link)->batch == batch) {
+            *link = (*link)->next;
+        } else {
+            stub.tail = *link;
+            link = &(*link)->next;
+        }
+    }
+    pthread_mutex_unlock(&stub.lock);
+    
+    pthread_mutex_destroy(&batch->lock);
+    pthread_cond_destroy(&batch->cond);
+    free(batch->ios);
+    free(batch);
+}
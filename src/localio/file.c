@@ -14,6 +14,7 @@
 #include <errno.h>
 #include <linux/fs.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 
 int localio_file_open(localio_context_t* ctx, const char* path, int flags,
                       localio_file_t** file_out) {
@@ -99,6 +100,17 @@ int localio_file_close(localio_file_t* file) {
     
     pthread_mutex_lock(&file->lock);
     
+    if (file->map_base) {
+        munmap(file->map_base, file->map_size);
+        file->map_base = NULL;
+    }
+    
+    if (file->ring) {
+        localio_uring_cleanup(file->ring);
+        free(file->ring);
+        file->ring = NULL;
+    }
+    
     if (file->fd >= 0) {
         close(file->fd);
         file->fd = -1;
@@ -113,10 +125,137 @@ int localio_file_close(localio_file_t* file) {
     return 0;
 }
 
+/* Copy from the mapping, clamped to the mapped size */
+static size_t file_map_copy(localio_file_t* file, void* buf, size_t count,
+                            uint64_t offset) {
+    if (offset >= file->map_size) return 0;
+    if (count > file->map_size - offset) count = file->map_size - offset;
+    
+    memcpy(buf, (const char*)file->map_base + offset, count);
+    return count;
+}
+
+/* Full-length pread, retrying short reads until EOF */
+static ssize_t file_pread(int fd, void* buf, size_t count, uint64_t offset) {
+    size_t done = 0;
+    
+    while (done < count) {
+        ssize_t n = pread(fd, (char*)buf + done, count - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        done += n;
+    }
+    
+    return (ssize_t)done;
+}
+
+/*
+ * The read path is chosen per file with localio_file_set_io_mode() before the
+ * handle is shared between threads. PREAD and MMAP reads are positional and
+ * run without the file lock; the io_uring ring is single-issuer and locked.
+ */
 int localio_file_read(localio_file_t* file, void* buf, size_t count,
                       uint64_t offset, size_t* bytes_read) {
     if (!file || !buf) return -1;
     
+    if (file->fd < 0) return -1;
+    
+    ssize_t n;
+    
+    switch (file->io_mode) {
+    case LOCALIO_IO_MMAP:
+        n = (ssize_t)file_map_copy(file, buf, count, offset);
+        break;
+    
+    case LOCALIO_IO_URING: {
+        localio_extent_t extent = { .offset = offset, .count = count };
+        pthread_mutex_lock(&file->lock);
+        if (localio_uring_read_batch(file->ring, file->fd, &extent, &buf,
+                                     &n, 1) != 0) {
+            n = -1;
+        }
+        pthread_mutex_unlock(&file->lock);
+        break;
+    }
+    
+    case LOCALIO_IO_PREAD:
+    default:
+        n = file_pread(file->fd, buf, count, offset);
+        break;
+    }
+    
+    if (n < 0) return -1;
+    
+    if (bytes_read) {
+        *bytes_read = n;
+    }
+    
+    return 0;
+}
+
+int localio_file_read_batch(localio_file_t* file, const localio_extent_t* extents,
+                            void** bufs, ssize_t* results, int count) {
+    if (!file || !extents || !bufs || !results || count < 0) return -1;
+    if (file->fd < 0) return -1;
+    
+    if (file->io_mode == LOCALIO_IO_URING) {
+        pthread_mutex_lock(&file->lock);
+        int ret = localio_uring_read_batch(file->ring, file->fd, extents, bufs,
+                                           results, count);
+        pthread_mutex_unlock(&file->lock);
+        return ret;
+    }
+    
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        if (file->io_mode == LOCALIO_IO_MMAP) {
+            results[i] = (ssize_t)file_map_copy(file, bufs[i], extents[i].count,
+                                                extents[i].offset);
+        } else {
+            results[i] = file_pread(file->fd, bufs[i], extents[i].count,
+                                    extents[i].offset);
+            if (results[i] < 0) failed++;
+        }
+    }
+    
+    return failed ? -1 : 0;
+}
+
+int localio_file_prefetch(localio_file_t* file, const localio_extent_t* extents,
+                          int count) {
+    if (!file || !extents || count < 0) return -1;
+    if (file->fd < 0) return -1;
+    
+    long page = sysconf(_SC_PAGESIZE);
+    
+    for (int i = 0; i < count; i++) {
+        uint64_t offset = extents[i].offset;
+        uint64_t start = offset & ~((uint64_t)page - 1);
+        
+        if (file->io_mode == LOCALIO_IO_MMAP) {
+            /* Only the mapped part of the extent can be advised */
+            if (offset >= file->map_size) continue;
+            size_t len = extents[i].count;
+            if (len > file->map_size - offset) len = file->map_size - offset;
+            madvise((char*)file->map_base + start, offset + len - start,
+                    MADV_WILLNEED);
+        } else {
+            /* readahead stops at EOF by itself; just don't wrap the end */
+            uint64_t len = extents[i].count;
+            if (offset > INT64_MAX || len > INT64_MAX - offset) continue;
+            readahead(file->fd, (off64_t)start, offset + len - start);
+        }
+    }
+    
+    return 0;
+}
+
+int localio_file_set_io_mode(localio_file_t* file, localio_io_mode_t mode) {
+    if (!file) return -1;
+    
     pthread_mutex_lock(&file->lock);
     
     if (file->fd < 0) {
@@ -124,22 +263,52 @@ int localio_file_read(localio_file_t* file, void* buf, size_t count,
         return -1;
     }
     
-    /* Seek to offset */
-    if (lseek(file->fd, offset, SEEK_SET) < 0) {
+    if (mode == file->io_mode) {
         pthread_mutex_unlock(&file->lock);
-        return -1;
+        return 0;
     }
     
-    /* Read data */
-    ssize_t n = read(file->fd, buf, count);
-    if (n < 0) {
-        pthread_mutex_unlock(&file->lock);
-        return -1;
+    /* Set up the new path before tearing down the old one */
+    void* map_base = NULL;
+    localio_uring_t* ring = NULL;
+    
+    if (mode == LOCALIO_IO_MMAP) {
+        /* Shared read-only mapping of a read-only regular file */
+        if (file->type != LOCALIO_FILE_REGULAR || file->size == 0 ||
+            (file->flags & GPUIO_MEM_WRITE)) {
+            pthread_mutex_unlock(&file->lock);
+            return -1;
+        }
+        
+        map_base = mmap(NULL, file->size, PROT_READ, MAP_SHARED, file->fd, 0);
+        if (map_base == MAP_FAILED) {
+            pthread_mutex_unlock(&file->lock);
+            return -1;
+        }
+        
+        /* Record reads are scattered; don't let the kernel read around them */
+        madvise(map_base, file->size, MADV_RANDOM);
+    } else if (mode == LOCALIO_IO_URING) {
+        ring = malloc(sizeof(localio_uring_t));
+        if (!ring || localio_uring_init(ring, 0) != 0) {
+            free(ring);
+            pthread_mutex_unlock(&file->lock);
+            return -1;
+        }
     }
     
-    if (bytes_read) {
-        *bytes_read = n;
+    if (file->map_base) {
+        munmap(file->map_base, file->map_size);
     }
+    if (file->ring) {
+        localio_uring_cleanup(file->ring);
+        free(file->ring);
+    }
+    
+    file->map_base = map_base;
+    file->map_size = map_base ? file->size : 0;
+    file->ring = ring;
+    file->io_mode = mode;
     
     pthread_mutex_unlock(&file->lock);
     return 0;
@@ -1,53 +1,105 @@
 /**
  * @file gds.c
- * @brief LocalIO module - GPUDirect Storage support (stub)
+ * @brief LocalIO module - GPUDirect Storage support
  * @version 1.0.0
+ *
+ * Loads libcufile at runtime. GPUIO_CUFILE_LIBRARY overrides the library
+ * path, e.g. to use the host-memory stand-in built from cufile_stub.c.
  */
 
 #include "localio_internal.h"
+#include "cufile_compat.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <dlfcn.h>
 
-/* GDS function pointers */
-typedef int (*gds_read_fn)(int fd, void* dev_ptr, size_t count, off_t offset);
-typedef int (*gds_write_fn)(int fd, const void* dev_ptr, size_t count, off_t offset);
-
 static struct {
     void* handle;
-    gds_read_fn read;
-    gds_write_fn write;
+    cufile_driver_open_fn driver_open;
+    cufile_driver_close_fn driver_close;
+    cufile_handle_register_fn handle_register;
+    cufile_handle_deregister_fn handle_deregister;
+    cufile_read_fn read;
+    cufile_write_fn write;
+    
+    /* Batch API (optional, cuFile >= 1.6) */
+    cufile_batch_setup_fn batch_setup;
+    cufile_batch_submit_fn batch_submit;
+    cufile_batch_status_fn batch_status;
+    cufile_batch_destroy_fn batch_destroy;
+    int batch_available;
+    
     int available;
 } gds_lib = {0};
 
+static void* gds_dlopen(void) {
+    const char* path = getenv("GPUIO_CUFILE_LIBRARY");
+    if (path && path[0]) {
+        return dlopen(path, RTLD_LAZY);
+    }
+    
+    void* handle = dlopen("libcufile.so.0", RTLD_LAZY);
+    if (!handle) {
+        handle = dlopen("libcufile.so", RTLD_LAZY);
+    }
+    return handle;
+}
+
 int localio_gds_init(localio_context_t* ctx) {
     if (!ctx) return -1;
     
     /* Try to load cuFile library */
-    gds_lib.handle = dlopen("libcufile.so.0", RTLD_LAZY);
-    if (!gds_lib.handle) {
-        gds_lib.handle = dlopen("libcufile.so", RTLD_LAZY);
-    }
+    gds_lib.handle = gds_dlopen();
     
     if (!gds_lib.handle) {
         ctx->gds_available = 0;
         return 0; /* GDS not available, but not an error */
     }
     
-    /* Load functions */
-    gds_lib.read = (gds_read_fn)dlsym(gds_lib.handle, "cuFileRead");
-    gds_lib.write = (gds_write_fn)dlsym(gds_lib.handle, "cuFileWrite");
+    /* Load functions (via void** so -Wpedantic accepts the conversion) */
+    *(void**)(&gds_lib.driver_open) =
+        dlsym(gds_lib.handle, "cuFileDriverOpen");
+    *(void**)(&gds_lib.driver_close) =
+        dlsym(gds_lib.handle, "cuFileDriverClose_v2");
+    if (!gds_lib.driver_close) {
+        *(void**)(&gds_lib.driver_close) =
+            dlsym(gds_lib.handle, "cuFileDriverClose");
+    }
+    *(void**)(&gds_lib.handle_register) =
+        dlsym(gds_lib.handle, "cuFileHandleRegister");
+    *(void**)(&gds_lib.handle_deregister) =
+        dlsym(gds_lib.handle, "cuFileHandleDeregister");
+    *(void**)(&gds_lib.read) = dlsym(gds_lib.handle, "cuFileRead");
+    *(void**)(&gds_lib.write) = dlsym(gds_lib.handle, "cuFileWrite");
     
-    if (gds_lib.read && gds_lib.write) {
-        ctx->gds_available = 1;
-        ctx->gds_handle = gds_lib.handle;
-    } else {
+    *(void**)(&gds_lib.batch_setup) =
+        dlsym(gds_lib.handle, "cuFileBatchIOSetUp");
+    *(void**)(&gds_lib.batch_submit) =
+        dlsym(gds_lib.handle, "cuFileBatchIOSubmit");
+    *(void**)(&gds_lib.batch_status) =
+        dlsym(gds_lib.handle, "cuFileBatchIOGetStatus");
+    *(void**)(&gds_lib.batch_destroy) =
+        dlsym(gds_lib.handle, "cuFileBatchIODestroy");
+    
+    if (!gds_lib.driver_open || !gds_lib.driver_close ||
+        !gds_lib.handle_register || !gds_lib.handle_deregister ||
+        !gds_lib.read || !gds_lib.write ||
+        gds_lib.driver_open().err != CU_FILE_SUCCESS) {
         dlclose(gds_lib.handle);
-        gds_lib.handle = NULL;
+        memset(&gds_lib, 0, sizeof(gds_lib));
         ctx->gds_available = 0;
+        return 0;
     }
     
+    gds_lib.batch_available = gds_lib.batch_setup && gds_lib.batch_submit &&
+                              gds_lib.batch_status && gds_lib.batch_destroy;
+    gds_lib.available = 1;
+    
+    ctx->gds_available = 1;
+    ctx->gds_handle = gds_lib.handle;
+    
     return 0;
 }
 
@@ -55,16 +107,29 @@ void localio_gds_cleanup(localio_context_t* ctx) {
     if (!ctx) return;
     
     if (gds_lib.handle) {
+        if (gds_lib.available) {
+            gds_lib.driver_close();
+        }
         dlclose(gds_lib.handle);
-        gds_lib.handle = NULL;
+        memset(&gds_lib, 0, sizeof(gds_lib));
     }
     
     ctx->gds_available = 0;
     ctx->gds_handle = NULL;
 }
 
-int localio_gds_read(localio_context_t* ctx, int fd, void* gpu_buf,
-                     size_t count, uint64_t offset) {
+static int gds_register_fd(int fd, CUfileHandle_t* fh) {
+    CUfileDescr_t descr;
+    memset(&descr, 0, sizeof(descr));
+    descr.type = CU_FILE_HANDLE_TYPE_OPAQUE_FD;
+    descr.handle.fd = fd;
+    
+    return gds_lib.handle_register(fh, &descr).err == CU_FILE_SUCCESS ? 0 : -1;
+}
+
+/* Returns the bytes read, short at end of file, or -1 */
+ssize_t localio_gds_read(localio_context_t* ctx, int fd, void* gpu_buf,
+                         size_t count, uint64_t offset) {
     if (!ctx || fd < 0 || !gpu_buf) return -1;
     
     if (!ctx->gds_available) {
@@ -80,19 +145,22 @@ int localio_gds_read(localio_context_t* ctx, int fd, void* gpu_buf,
         }
         
         /* Copy to GPU through parent context */
-        gpuio_error_t err = gpuio_memcpy(ctx->parent, gpu_buf, host_buf, 
-                                          n, NULL);
+        gpuio_error_t err = n > 0 ?
+            gpuio_memcpy(ctx->parent, gpu_buf, host_buf, (size_t)n, NULL) :
+            GPUIO_SUCCESS;
         free(host_buf);
         
-        return (err == GPUIO_SUCCESS) ? 0 : -1;
+        return (err == GPUIO_SUCCESS) ? n : -1;
     }
     
     /* Use GDS */
-    if (gds_lib.read) {
-        return gds_lib.read(fd, gpu_buf, count, offset);
-    }
+    CUfileHandle_t fh;
+    if (gds_register_fd(fd, &fh) != 0) return -1;
+    
+    ssize_t n = gds_lib.read(fh, gpu_buf, count, (off_t)offset, 0);
+    gds_lib.handle_deregister(fh);
     
-    return -1;
+    return (n >= 0) ? n : -1;
 }
 
 int localio_gds_write(localio_context_t* ctx, int fd, const void* gpu_buf,
@@ -119,9 +187,132 @@ int localio_gds_write(localio_context_t* ctx, int fd, const void* gpu_buf,
     }
     
     /* Use GDS */
-    if (gds_lib.write) {
-        return gds_lib.write(fd, gpu_buf, count, offset);
+    CUfileHandle_t fh;
+    if (gds_register_fd(fd, &fh) != 0) return -1;
+    
+    ssize_t n = gds_lib.write(fh, gpu_buf, count, (off_t)offset, 0);
+    gds_lib.handle_deregister(fh);
+    
+    return (n == (ssize_t)count) ? 0 : -1;
+}
+
+/* Issue IOs one at a time, recording per-entry results */
+static int gds_submit_serial(localio_context_t* ctx, localio_gds_io_t* ios,
+                             int count) {
+    int failed = 0;
+    
+    for (int i = 0; i < count; i++) {
+        if (ios[i].op == GPUIO_REQ_WRITE) {
+            int rc = localio_gds_write(ctx, ios[i].fd, ios[i].gpu_buf,
+                                       ios[i].count, ios[i].offset);
+            ios[i].result = (rc == 0) ? (ssize_t)ios[i].count : -1;
+        } else {
+            ios[i].result = localio_gds_read(ctx, ios[i].fd, ios[i].gpu_buf,
+                                             ios[i].count, ios[i].offset);
+        }
+        if (ios[i].result < 0) failed++;
+    }
+    
+    return failed ? -1 : 0;
+}
+
+/* Submit one chunk of at most CUFILE_MAX_BATCH_IO_SIZE entries */
+static int gds_submit_chunk(localio_gds_io_t* ios, int count) {
+    CUfileIOParams_t params[CUFILE_MAX_BATCH_IO_SIZE];
+    CUfileIOEvents_t events[CUFILE_MAX_BATCH_IO_SIZE];
+    CUfileHandle_t handles[CUFILE_MAX_BATCH_IO_SIZE];
+    int fds[CUFILE_MAX_BATCH_IO_SIZE];
+    int num_handles = 0;
+    int ret = -1;
+    
+    /* Register each distinct file once per chunk */
+    for (int i = 0; i < count; i++) {
+        int h = 0;
+        while (h < num_handles && fds[h] != ios[i].fd) h++;
+        if (h == num_handles) {
+            if (gds_register_fd(ios[i].fd, &handles[h]) != 0) goto out;
+            fds[h] = ios[i].fd;
+            num_handles++;
+        }
+        
+        memset(&params[i], 0, sizeof(params[i]));
+        params[i].mode = CUFILE_BATCH;
+        params[i].u.batch.devPtr_base = ios[i].gpu_buf;
+        params[i].u.batch.file_offset = (off_t)ios[i].offset;
+        params[i].u.batch.devPtr_offset = 0;
+        params[i].u.batch.size = ios[i].count;
+        params[i].fh = handles[h];
+        params[i].opcode = (ios[i].op == GPUIO_REQ_WRITE) ?
+                           CUFILE_WRITE : CUFILE_READ;
+        params[i].cookie = &ios[i];
+        ios[i].result = -1;
+    }
+    
+    CUfileBatchHandle_t batch;
+    if (gds_lib.batch_setup(&batch, (unsigned)count).err != CU_FILE_SUCCESS) {
+        goto out;
+    }
+    
+    if (gds_lib.batch_submit(batch, (unsigned)count, params, 0).err !=
+        CU_FILE_SUCCESS) {
+        gds_lib.batch_destroy(batch);
+        goto out;
+    }
+    
+    /* Reap until every entry has reported */
+    int completed = 0;
+    ret = 0;
+    while (completed < count) {
+        unsigned nr = (unsigned)(count - completed);
+        if (gds_lib.batch_status(batch, nr, &nr, events, NULL).err !=
+            CU_FILE_SUCCESS) {
+            ret = -1;
+            break;
+        }
+        
+        for (unsigned e = 0; e < nr; e++) {
+            localio_gds_io_t* io = (localio_gds_io_t*)events[e].cookie;
+            if (events[e].status == CUFILE_COMPLETE) {
+                io->result = (ssize_t)events[e].ret;
+                if (io->op == GPUIO_REQ_WRITE && io->result != (ssize_t)io->count) {
+                    ret = -1;
+                }
+            } else {
+                io->result = -1;
+                ret = -1;
+            }
+        }
+        completed += (int)nr;
+    }
+    
+    gds_lib.batch_destroy(batch);
+
+out:
+    for (int h = 0; h < num_handles; h++) {
+        gds_lib.handle_deregister(handles[h]);
+    }
+    return ret;
+}
+
+int localio_gds_submit_batch(localio_context_t* ctx, localio_gds_io_t* ios,
+                             int count) {
+    if (!ctx || !ios || count < 0) return -1;
+    if (count == 0) return 0;
+    
+    for (int i = 0; i < count; i++) {
+        if (ios[i].fd < 0 || !ios[i].gpu_buf) return -1;
+    }
+    
+    if (!ctx->gds_available || !gds_lib.batch_available) {
+        return gds_submit_serial(ctx, ios, count);
+    }
+    
+    int ret = 0;
+    for (int i = 0; i < count; i += CUFILE_MAX_BATCH_IO_SIZE) {
+        int n = count - i;
+        if (n > CUFILE_MAX_BATCH_IO_SIZE) n = CUFILE_MAX_BATCH_IO_SIZE;
+        if (gds_submit_chunk(&ios[i], n) != 0) ret = -1;
     }
     
-    return -1;
+    return ret;
 }
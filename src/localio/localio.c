@@ -8,6 +8,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <pthread.h>
 
 /* Worker thread function */
@@ -138,14 +140,63 @@ int localio_read_gpu(localio_context_t* ctx, const char* path, void* gpu_buf,
         if (fd < 0) return -1;
     }
     
-    int ret = localio_gds_read(ctx, fd, gpu_buf, count, offset);
+    ssize_t n = localio_gds_read(ctx, fd, gpu_buf, count, offset);
     close(fd);
     
-    if (ret == 0) {
-        ctx->bytes_read += count;
-        ctx->io_count++;
+    if (n < 0) return -1;
+    
+    ctx->bytes_read += (uint64_t)n;
+    ctx->io_count++;
+    
+    return 0;
+}
+
+/*
+ * Read a set of extents of one file straight into GPU memory. Goes through
+ * the cuFile batch API when it is there, one IO at a time otherwise. Each
+ * entry's bytes read (short at EOF) or -1 lands in results.
+ */
+int localio_read_gpu_batch(localio_context_t* ctx, const char* path,
+                           const localio_extent_t* extents, void** gpu_bufs,
+                           ssize_t* results, int count) {
+    if (!ctx || !path || !extents || !gpu_bufs || !results || count < 0) {
+        return -1;
+    }
+    if (count == 0) return 0;
+    
+    localio_gds_io_t* ios = calloc((size_t)count, sizeof(localio_gds_io_t));
+    if (!ios) return -1;
+    
+    /* The host bounce path reads into unaligned buffers: no O_DIRECT there */
+    int fd = ctx->gds_available ? open(path, O_RDONLY | O_DIRECT) : -1;
+    if (fd < 0) {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            free(ios);
+            return -1;
+        }
+    }
+    
+    for (int i = 0; i < count; i++) {
+        ios[i].op = GPUIO_REQ_READ;
+        ios[i].fd = fd;
+        ios[i].gpu_buf = gpu_bufs[i];
+        ios[i].count = extents[i].count;
+        ios[i].offset = extents[i].offset;
+    }
+    
+    int ret = localio_gds_submit_batch(ctx, ios, count);
+    close(fd);
+    
+    for (int i = 0; i < count; i++) {
+        results[i] = ios[i].result;
+        if (ios[i].result >= 0) {
+            ctx->bytes_read += (uint64_t)ios[i].result;
+            ctx->io_count++;
+        }
     }
     
+    free(ios);
     return ret;
 }
 
@@ -11,6 +11,7 @@
 #include <pthread.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <sys/types.h>
 
 /* File handle types */
 typedef enum {
@@ -19,6 +20,43 @@ typedef enum {
     LOCALIO_FILE_NVME,
 } localio_file_type_t;
 
+/* Per-file read path */
+typedef enum {
+    LOCALIO_IO_PREAD = 0,   /* pread() per request */
+    LOCALIO_IO_URING,       /* io_uring, batched */
+    LOCALIO_IO_MMAP,        /* memcpy from a shared read-only mapping */
+} localio_io_mode_t;
+
+/* File extent */
+typedef struct localio_extent {
+    uint64_t offset;
+    size_t count;
+} localio_extent_t;
+
+/* io_uring ring (raw syscall interface) */
+typedef struct localio_uring {
+    int fd;
+    unsigned entries;
+    
+    /* Submission queue */
+    void* sq_ptr;
+    size_t sq_size;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_array;
+    unsigned sq_mask;
+    void* sqes;
+    size_t sqes_size;
+    
+    /* Completion queue */
+    void* cq_ptr;
+    size_t cq_size;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned cq_mask;
+    void* cqes;
+} localio_uring_t;
+
 /* File handle */
 typedef struct localio_file {
     char* path;
@@ -31,10 +69,29 @@ typedef struct localio_file {
     /* For NVMe direct access */
     int nvme_ns_id;
     
+    /* Read path */
+    localio_io_mode_t io_mode;
+    void* map_base;             /* LOCALIO_IO_MMAP */
+    size_t map_size;
+    localio_uring_t* ring;      /* LOCALIO_IO_URING */
+    
     /* Thread safety */
     pthread_mutex_t lock;
 } localio_file_t;
 
+/* Request priority; prefetches may be shed under load */
+typedef enum {
+    LOCALIO_PRIO_NORMAL = 0,
+    LOCALIO_PRIO_PREFETCH,
+} localio_priority_t;
+
+/* What localio_queue_submit does above the high watermark */
+typedef enum {
+    LOCALIO_ADMIT_BLOCK = 0,        /* Wait until below the low watermark */
+    LOCALIO_ADMIT_REJECT,           /* Return GPUIO_ERROR_BUSY */
+    LOCALIO_ADMIT_SHED_PREFETCH,    /* Drop prefetches, block the rest */
+} localio_admit_policy_t;
+
 /* IO request queue */
 typedef struct localio_request {
     int op; /* READ or WRITE */
@@ -44,9 +101,25 @@ typedef struct localio_request {
     localio_file_t* file;
     gpuio_callback_t callback;
     void* user_data;
+    localio_priority_t priority;
+    
+    /* Filled in by the queue */
+    uint64_t submit_time_us;
+    uint64_t seq;
+    size_t result;              /* Bytes transferred */
+    
     struct localio_request* next;
 } localio_request_t;
 
+/* Queue defaults */
+#define LOCALIO_QUEUE_DEFAULT_MERGE_GAP      (16 * 1024)
+#define LOCALIO_QUEUE_DEFAULT_MAX_MERGE      (1024 * 1024)
+#define LOCALIO_QUEUE_DEFAULT_LATENCY_US     2000
+#define LOCALIO_QUEUE_DEFAULT_HIGH_DEPTH     4096
+#define LOCALIO_QUEUE_DEFAULT_LOW_DEPTH      3072
+#define LOCALIO_QUEUE_DEFAULT_HIGH_BYTES     (1024ULL * 1024 * 1024)
+#define LOCALIO_QUEUE_DEFAULT_LOW_BYTES      (768ULL * 1024 * 1024)
+
 /* Queue */
 typedef struct localio_queue {
     localio_request_t* head;
@@ -54,8 +127,54 @@ typedef struct localio_queue {
     pthread_mutex_t lock;
     pthread_cond_t cond;
     int depth;
+    size_t pending_bytes;
+    uint64_t next_seq;
+    
+    /* Admission control (0 disables a limit) */
+    int high_watermark;
+    int low_watermark;
+    size_t high_watermark_bytes;
+    size_t low_watermark_bytes;
+    localio_admit_policy_t admit_policy;
+    bool throttled;             /* Set at high, cleared at low watermark */
+    bool closing;               /* Cleanup started; submits are canceled */
+    int waiters;                /* Submitters blocked on space_cond */
+    pthread_cond_t space_cond;
+    
+    /* Elevator merging */
+    size_t merge_gap;           /* Max hole between merged reads */
+    size_t max_merge;           /* Max bytes per merged IO */
+    uint64_t latency_budget_us; /* Older requests dispatch first, unmerged */
+    
+    /* Statistics */
+    uint64_t requests_completed;
+    uint64_t ios_issued;
+    uint64_t requests_merged;   /* Requests served by a shared IO */
+    uint64_t deadline_dispatches;
+    uint64_t rejected;
+    uint64_t shed;
+    uint64_t blocked;
+    uint64_t blocked_time_us;
+    uint64_t queue_delay_total_us;
+    uint64_t queue_delay_max_us;
 } localio_queue_t;
 
+/* Queue statistics */
+typedef struct localio_queue_stats {
+    int depth;
+    size_t pending_bytes;
+    uint64_t requests_completed;
+    uint64_t ios_issued;
+    uint64_t requests_merged;
+    uint64_t deadline_dispatches;
+    uint64_t rejected;              /* Returned GPUIO_ERROR_BUSY */
+    uint64_t shed;                  /* Prefetches dropped */
+    uint64_t blocked;               /* Submits that waited for space */
+    uint64_t blocked_time_us;
+    double avg_queue_delay_us;      /* Submit to dispatch */
+    uint64_t max_queue_delay_us;
+} localio_queue_stats_t;
+
 /* LocalIO context */
 typedef struct localio_context {
     gpuio_context_t parent;
@@ -98,19 +217,52 @@ int localio_file_read(localio_file_t* file, void* buf, size_t count,
                       uint64_t offset, size_t* bytes_read);
 int localio_file_write(localio_file_t* file, const void* buf, size_t count,
                        uint64_t offset, size_t* bytes_written);
+int localio_file_sync(localio_file_t* file);
+int localio_file_set_io_mode(localio_file_t* file, localio_io_mode_t mode);
+int localio_file_read_batch(localio_file_t* file, const localio_extent_t* extents,
+                            void** bufs, ssize_t* results, int count);
+int localio_file_prefetch(localio_file_t* file, const localio_extent_t* extents,
+                          int count);
+
+int localio_uring_init(localio_uring_t* ring, unsigned entries);
+void localio_uring_cleanup(localio_uring_t* ring);
+int localio_uring_read_batch(localio_uring_t* ring, int fd,
+                             const localio_extent_t* extents, void** bufs,
+                             ssize_t* results, int count);
 
 int localio_queue_init(localio_queue_t* queue);
 void localio_queue_cleanup(localio_queue_t* queue);
 int localio_queue_submit(localio_queue_t* queue, localio_request_t* req);
 int localio_queue_process(localio_queue_t* queue);
+int localio_queue_set_limits(localio_queue_t* queue, int high, int low,
+                             size_t high_bytes, size_t low_bytes,
+                             localio_admit_policy_t policy);
+int localio_queue_get_stats(localio_queue_t* queue,
+                            localio_queue_stats_t* stats);
 
 int localio_gds_init(localio_context_t* ctx);
 void localio_gds_cleanup(localio_context_t* ctx);
-int localio_gds_read(localio_context_t* ctx, int fd, void* gpu_buf,
-                     size_t count, uint64_t offset);
+ssize_t localio_gds_read(localio_context_t* ctx, int fd, void* gpu_buf,
+                         size_t count, uint64_t offset);
 int localio_gds_write(localio_context_t* ctx, int fd, const void* gpu_buf,
                       size_t count, uint64_t offset);
 
+/* Batched GPUDirect Storage IO */
+typedef struct localio_gds_io {
+    int op; /* GPUIO_REQ_READ or GPUIO_REQ_WRITE */
+    int fd;
+    void* gpu_buf;
+    size_t count;
+    uint64_t offset;
+    ssize_t result; /* Bytes transferred, or -1 on error */
+} localio_gds_io_t;
+
+int localio_gds_submit_batch(localio_context_t* ctx, localio_gds_io_t* ios,
+                             int count);
+int localio_read_gpu_batch(localio_context_t* ctx, const char* path,
+                           const localio_extent_t* extents, void** gpu_bufs,
+                           ssize_t* results, int count);
+
 int localio_compress(const void* src, size_t src_len, void* dst, 
                      size_t dst_len, size_t* out_len, int level);
 int localio_decompress(const void* src, size_t src_len, void* dst,
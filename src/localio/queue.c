@@ -0,0 +1,508 @@
+/**
+ * @file queue.c
+ * @brief LocalIO module - IO request queue with elevator merging
+ * @version 1.0.0
+ *
+ * localio_queue_process() drains the pending list as one batch. Requests
+ * older than the latency budget are dispatched first, in arrival order.
+ * The rest are sorted per file by offset and runs of nearby reads are
+ * served by a single IO through a bounce buffer, then split back to the
+ * callers. Files with a pending write in the batch keep arrival order so
+ * reads never overtake an overlapping write.
+ *
+ * Admission control bounds the pending depth and bytes. Once either crosses
+ * its high watermark the queue stays throttled until both drop below the
+ * low watermark; submits then block, fail with GPUIO_ERROR_BUSY, or shed
+ * prefetches depending on admit_policy. Submits made from a completion
+ * callback on a processing thread are never blocked. localio_queue_cleanup()
+ * fails blocked submits with GPUIO_ERROR_CANCELED and waits for them to
+ * leave before destroying the queue.
+ *
+ * Each localio_queue_process() call owns its batch and bounce buffer and
+ * marks only its own thread as processing, so several threads may process
+ * one queue and callbacks may process it re-entrantly.
+ */
+
+#include "localio_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Bounce buffer for merged reads, owned by one localio_queue_process() call */
+typedef struct queue_bounce {
+    void* buf;
+    size_t size;
+} queue_bounce_t;
+
+/* Queue this thread is processing; its callbacks may submit without blocking */
+static __thread localio_queue_t* queue_processing = NULL;
+
+static uint64_t queue_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+int localio_queue_init(localio_queue_t* queue) {
+    if (!queue) return -1;
+    
+    memset(queue, 0, sizeof(*queue));
+    
+    queue->merge_gap = LOCALIO_QUEUE_DEFAULT_MERGE_GAP;
+    queue->max_merge = LOCALIO_QUEUE_DEFAULT_MAX_MERGE;
+    queue->latency_budget_us = LOCALIO_QUEUE_DEFAULT_LATENCY_US;
+    
+    queue->high_watermark = LOCALIO_QUEUE_DEFAULT_HIGH_DEPTH;
+    queue->low_watermark = LOCALIO_QUEUE_DEFAULT_LOW_DEPTH;
+    queue->high_watermark_bytes = LOCALIO_QUEUE_DEFAULT_HIGH_BYTES;
+    queue->low_watermark_bytes = LOCALIO_QUEUE_DEFAULT_LOW_BYTES;
+    queue->admit_policy = LOCALIO_ADMIT_SHED_PREFETCH;
+    
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->cond, NULL);
+    pthread_cond_init(&queue->space_cond, NULL);
+    
+    return 0;
+}
+
+void localio_queue_cleanup(localio_queue_t* queue) {
+    if (!queue) return;
+    
+    pthread_mutex_lock(&queue->lock);
+    localio_request_t* req = queue->head;
+    queue->head = queue->tail = NULL;
+    queue->depth = 0;
+    queue->pending_bytes = 0;
+    queue->closing = true;
+    
+    /* Blocked submitters give up; the last one out wakes us */
+    pthread_cond_broadcast(&queue->space_cond);
+    while (queue->waiters > 0) {
+        pthread_cond_wait(&queue->space_cond, &queue->lock);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    
+    /* Fail anything still pending */
+    while (req) {
+        localio_request_t* next = req->next;
+        req->result = 0;
+        if (req->callback) {
+            req->callback(NULL, GPUIO_ERROR_CANCELED, req->user_data);
+        }
+        req = next;
+    }
+    
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->cond);
+    pthread_cond_destroy(&queue->space_cond);
+}
+
+int localio_queue_set_limits(localio_queue_t* queue, int high, int low,
+                             size_t high_bytes, size_t low_bytes,
+                             localio_admit_policy_t policy) {
+    if (!queue || high < 0 || low < 0 || low > high ||
+        low_bytes > high_bytes) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&queue->lock);
+    queue->high_watermark = high;
+    queue->low_watermark = low;
+    queue->high_watermark_bytes = high_bytes;
+    queue->low_watermark_bytes = low_bytes;
+    queue->admit_policy = policy;
+    
+    /* Re-evaluate against the new limits */
+    queue->throttled = false;
+    pthread_cond_broadcast(&queue->space_cond);
+    pthread_mutex_unlock(&queue->lock);
+    
+    return 0;
+}
+
+int localio_queue_get_stats(localio_queue_t* queue,
+                            localio_queue_stats_t* stats) {
+    if (!queue || !stats) return -1;
+    
+    pthread_mutex_lock(&queue->lock);
+    stats->depth = queue->depth;
+    stats->pending_bytes = queue->pending_bytes;
+    stats->requests_completed = queue->requests_completed;
+    stats->ios_issued = queue->ios_issued;
+    stats->requests_merged = queue->requests_merged;
+    stats->deadline_dispatches = queue->deadline_dispatches;
+    stats->rejected = queue->rejected;
+    stats->shed = queue->shed;
+    stats->blocked = queue->blocked;
+    stats->blocked_time_us = queue->blocked_time_us;
+    stats->avg_queue_delay_us = queue->requests_completed ?
+        (double)queue->queue_delay_total_us / queue->requests_completed : 0.0;
+    stats->max_queue_delay_us = queue->queue_delay_max_us;
+    pthread_mutex_unlock(&queue->lock);
+    
+    return 0;
+}
+
+/* Caller holds queue->lock */
+static bool queue_over_high(localio_queue_t* queue, size_t incoming) {
+    if (queue->high_watermark > 0 && queue->depth >= queue->high_watermark) {
+        return true;
+    }
+    if (queue->high_watermark_bytes > 0 &&
+        queue->pending_bytes + incoming > queue->high_watermark_bytes) {
+        return true;
+    }
+    return false;
+}
+
+/* Caller holds queue->lock */
+static bool queue_below_low(localio_queue_t* queue) {
+    if (queue->high_watermark > 0 && queue->depth > queue->low_watermark) {
+        return false;
+    }
+    if (queue->high_watermark_bytes > 0 &&
+        queue->pending_bytes > queue->low_watermark_bytes) {
+        return false;
+    }
+    return true;
+}
+
+/* Unlink queued prefetches; caller holds queue->lock and completes them */
+static localio_request_t* queue_shed_prefetch(localio_queue_t* queue) {
+    localio_request_t* shed = NULL;
+    localio_request_t** link = &queue->head;
+    
+    queue->tail = NULL;
+    while (*link) {
+        localio_request_t* req = *link;
+        if (req->priority == LOCALIO_PRIO_PREFETCH) {
+            *link = req->next;
+            req->next = shed;
+            shed = req;
+            queue->depth--;
+            queue->pending_bytes -= req->count;
+            queue->shed++;
+        } else {
+            queue->tail = req;
+            link = &req->next;
+        }
+    }
+    
+    return shed;
+}
+
+int localio_queue_submit(localio_queue_t* queue, localio_request_t* req) {
+    if (!queue || !req || !req->file || !req->buf) return -1;
+    
+    req->next = NULL;
+    req->result = 0;
+    
+    localio_request_t* shed = NULL;
+    int ret = 0;
+    
+    pthread_mutex_lock(&queue->lock);
+    
+    if (queue->closing) {
+        ret = GPUIO_ERROR_CANCELED;
+        goto out;
+    }
+    
+    if (!queue->throttled && queue_over_high(queue, req->count)) {
+        queue->throttled = true;
+    }
+    
+    if (queue->throttled) {
+        bool is_prefetch = (req->priority == LOCALIO_PRIO_PREFETCH);
+        bool in_callback = (queue_processing == queue);
+        
+        if (queue->admit_policy == LOCALIO_ADMIT_REJECT ||
+            (queue->admit_policy == LOCALIO_ADMIT_SHED_PREFETCH && is_prefetch)) {
+            if (is_prefetch && queue->admit_policy == LOCALIO_ADMIT_SHED_PREFETCH) {
+                queue->shed++;
+            } else {
+                queue->rejected++;
+            }
+            ret = GPUIO_ERROR_BUSY;
+            goto out;
+        }
+        
+        if (queue->admit_policy == LOCALIO_ADMIT_SHED_PREFETCH) {
+            shed = queue_shed_prefetch(queue);
+            if (queue_below_low(queue)) {
+                queue->throttled = false;
+                pthread_cond_broadcast(&queue->space_cond);
+            }
+        }
+        
+        if (queue->throttled && !in_callback) {
+            uint64_t start = queue_time_us();
+            queue->blocked++;
+            queue->waiters++;
+            while (queue->throttled && !queue->closing) {
+                pthread_cond_wait(&queue->space_cond, &queue->lock);
+            }
+            queue->waiters--;
+            queue->blocked_time_us += queue_time_us() - start;
+            
+            if (queue->closing) {
+                if (queue->waiters == 0) pthread_cond_broadcast(&queue->space_cond);
+                ret = GPUIO_ERROR_CANCELED;
+                goto out;
+            }
+        }
+    }
+    
+    req->submit_time_us = queue_time_us();
+    req->seq = queue->next_seq++;
+    
+    if (queue->tail) {
+        queue->tail->next = req;
+    } else {
+        queue->head = req;
+    }
+    queue->tail = req;
+    queue->depth++;
+    queue->pending_bytes += req->count;
+    
+    pthread_cond_signal(&queue->cond);
+
+out:
+    pthread_mutex_unlock(&queue->lock);
+    
+    /* Complete shed prefetches outside the lock */
+    while (shed) {
+        localio_request_t* next = shed->next;
+        shed->result = 0;
+        if (shed->callback) {
+            shed->callback(NULL, GPUIO_ERROR_CANCELED, shed->user_data);
+        }
+        shed = next;
+    }
+    
+    return ret;
+}
+
+/* Record submit-to-dispatch delay; once per request, by the dispatchers */
+static void queue_note_dispatch(localio_queue_t* queue, localio_request_t* req,
+                                uint64_t now) {
+    uint64_t delay = now - req->submit_time_us;
+    
+    pthread_mutex_lock(&queue->lock);
+    queue->queue_delay_total_us += delay;
+    if (delay > queue->queue_delay_max_us) {
+        queue->queue_delay_max_us = delay;
+    }
+    pthread_mutex_unlock(&queue->lock);
+}
+
+/* Release the request's queue slot, then run its callback */
+static void queue_complete(localio_queue_t* queue, localio_request_t* req,
+                           gpuio_error_t status) {
+    pthread_mutex_lock(&queue->lock);
+    queue->depth--;
+    queue->pending_bytes -= req->count;
+    queue->requests_completed++;
+    if (queue->throttled && queue_below_low(queue)) {
+        queue->throttled = false;
+        pthread_cond_broadcast(&queue->space_cond);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    
+    if (req->callback) {
+        req->callback(NULL, status, req->user_data);
+    }
+}
+
+/* Issue one request on its own; its dispatch is already recorded */
+static void queue_issue_single(localio_queue_t* queue, localio_request_t* req) {
+    size_t n = 0;
+    int ret = (req->op == GPUIO_REQ_WRITE) ?
+        localio_file_write(req->file, req->buf, req->count, req->offset, &n) :
+        localio_file_read(req->file, req->buf, req->count, req->offset, &n);
+    
+    pthread_mutex_lock(&queue->lock);
+    queue->ios_issued++;
+    pthread_mutex_unlock(&queue->lock);
+    
+    req->result = (ret == 0) ? n : 0;
+    queue_complete(queue, req, ret == 0 ? GPUIO_SUCCESS : GPUIO_ERROR_IO);
+}
+
+static void queue_dispatch_single(localio_queue_t* queue,
+                                  localio_request_t* req) {
+    queue_note_dispatch(queue, req, queue_time_us());
+    queue_issue_single(queue, req);
+}
+
+/* Serve reqs[0..count) (sorted reads on one file) with a single read */
+static void queue_dispatch_merged(localio_queue_t* queue,
+                                  queue_bounce_t* bounce,
+                                  localio_request_t** reqs, int count,
+                                  uint64_t start, uint64_t end) {
+    size_t span = (size_t)(end - start);
+    
+    uint64_t now = queue_time_us();
+    for (int i = 0; i < count; i++) {
+        queue_note_dispatch(queue, reqs[i], now);
+    }
+    
+    if (bounce->size < span) {
+        void* buf = realloc(bounce->buf, span);
+        if (!buf) {
+            for (int i = 0; i < count; i++) {
+                queue_issue_single(queue, reqs[i]);
+            }
+            return;
+        }
+        bounce->buf = buf;
+        bounce->size = span;
+    }
+    
+    size_t got = 0;
+    if (localio_file_read(reqs[0]->file, bounce->buf, span, start,
+                          &got) != 0) {
+        /* Retry individually so one bad range doesn't fail its neighbours */
+        for (int i = 0; i < count; i++) {
+            queue_issue_single(queue, reqs[i]);
+        }
+        return;
+    }
+    
+    pthread_mutex_lock(&queue->lock);
+    queue->ios_issued++;
+    queue->requests_merged += count;
+    pthread_mutex_unlock(&queue->lock);
+    
+    for (int i = 0; i < count; i++) {
+        localio_request_t* req = reqs[i];
+        size_t off = (size_t)(req->offset - start);
+        size_t len = (got > off) ? got - off : 0;
+        if (len > req->count) len = req->count;
+        
+        memcpy(req->buf, (char*)bounce->buf + off, len);
+        req->result = len;
+        queue_complete(queue, req, GPUIO_SUCCESS);
+    }
+}
+
+static int queue_cmp_file_seq(const void* a, const void* b) {
+    const localio_request_t* ra = *(localio_request_t* const*)a;
+    const localio_request_t* rb = *(localio_request_t* const*)b;
+    
+    if (ra->file != rb->file) {
+        return ((uintptr_t)ra->file < (uintptr_t)rb->file) ? -1 : 1;
+    }
+    return (ra->seq < rb->seq) ? -1 : (ra->seq > rb->seq);
+}
+
+static int queue_cmp_offset(const void* a, const void* b) {
+    const localio_request_t* ra = *(localio_request_t* const*)a;
+    const localio_request_t* rb = *(localio_request_t* const*)b;
+    
+    if (ra->offset != rb->offset) return (ra->offset < rb->offset) ? -1 : 1;
+    return (ra->seq < rb->seq) ? -1 : (ra->seq > rb->seq);
+}
+
+int localio_queue_process(localio_queue_t* queue) {
+    if (!queue) return -1;
+    
+    /* Take the whole pending list as one batch; depth and pending bytes
+     * are released per request as each one completes */
+    pthread_mutex_lock(&queue->lock);
+    localio_request_t* list = queue->head;
+    queue->head = queue->tail = NULL;
+    pthread_mutex_unlock(&queue->lock);
+    
+    if (!list) return 0;
+    
+    localio_queue_t* outer = queue_processing;
+    queue_processing = queue;
+    queue_bounce_t bounce = { NULL, 0 };
+    
+    int n = 0;
+    for (localio_request_t* req = list; req; req = req->next) n++;
+    
+    localio_request_t** reqs = malloc(n * sizeof(localio_request_t*));
+    if (!reqs) {
+        /* No room to sort; fall back to arrival order */
+        while (list) {
+            localio_request_t* next = list->next;
+            queue_dispatch_single(queue, list);
+            list = next;
+        }
+        goto out;
+    }
+    
+    /* Requests past their latency budget go first, in arrival order */
+    uint64_t now = queue_time_us();
+    int count = 0;
+    int expired = 0;
+    for (localio_request_t* req = list; req; ) {
+        localio_request_t* next = req->next;
+        if (now - req->submit_time_us >= queue->latency_budget_us) {
+            queue_dispatch_single(queue, req);
+            expired++;
+        } else {
+            reqs[count++] = req;
+        }
+        req = next;
+    }
+    pthread_mutex_lock(&queue->lock);
+    queue->deadline_dispatches += expired;
+    pthread_mutex_unlock(&queue->lock);
+    
+    /* Group by file; within read-only groups sort by offset */
+    qsort(reqs, count, sizeof(localio_request_t*), queue_cmp_file_seq);
+    
+    for (int i = 0; i < count; ) {
+        int j = i;
+        int has_write = 0;
+        while (j < count && reqs[j]->file == reqs[i]->file) {
+            if (reqs[j]->op == GPUIO_REQ_WRITE) has_write = 1;
+            j++;
+        }
+        
+        if (has_write || reqs[i]->file->io_mode == LOCALIO_IO_MMAP) {
+            /* Ordering matters, or merging buys nothing */
+            for (int k = i; k < j; k++) {
+                queue_dispatch_single(queue, reqs[k]);
+            }
+            i = j;
+            continue;
+        }
+        
+        qsort(&reqs[i], j - i, sizeof(localio_request_t*), queue_cmp_offset);
+        
+        /* Merge runs of nearby reads */
+        while (i < j) {
+            uint64_t start = reqs[i]->offset;
+            uint64_t end = start + reqs[i]->count;
+            int k = i + 1;
+            
+            while (k < j && reqs[k]->offset <= end + queue->merge_gap) {
+                uint64_t req_end = reqs[k]->offset + reqs[k]->count;
+                uint64_t new_end = (req_end > end) ? req_end : end;
+                if (new_end - start > queue->max_merge) break;
+                end = new_end;
+                k++;
+            }
+            
+            if (k - i > 1) {
+                queue_dispatch_merged(queue, &bounce, &reqs[i], k - i,
+                                      start, end);
+            } else {
+                queue_dispatch_single(queue, reqs[i]);
+            }
+            i = k;
+        }
+    }
+    
+    free(reqs);
+    free(bounce.buf);
+
+out:
+    queue_processing = outer;
+    
+    return n;
+}
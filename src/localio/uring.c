@@ -0,0 +1,226 @@
+/**
+ * @file uring.c
+ * @brief LocalIO module - io_uring read path
+ * @version 1.0.0
+ *
+ * Minimal io_uring ring driven through the raw syscalls, so LocalIO does not
+ * depend on liburing. Used for batched reads; callers fall back to pread when
+ * the kernel does not support io_uring.
+ */
+
+#include "localio_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#define URING_DEFAULT_ENTRIES 64
+
+/* Longest single read; the kernel caps one read near 2 GiB anyway */
+#ifndef URING_MAX_READ
+#define URING_MAX_READ        (1U << 30)
+#endif
+
+static int uring_setup(unsigned entries, struct io_uring_params* p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                       unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                        flags, NULL, 0);
+}
+
+int localio_uring_init(localio_uring_t* ring, unsigned entries) {
+    if (!ring) return -1;
+    
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+    
+    if (entries == 0) entries = URING_DEFAULT_ENTRIES;
+    
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    
+    int fd = uring_setup(entries, &p);
+    if (fd < 0) return -1;
+    
+    ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) goto fail;
+    
+    ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (ring->cq_ptr == MAP_FAILED) {
+        ring->cq_ptr = NULL;
+        goto fail;
+    }
+    
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        goto fail;
+    }
+    
+    char* sq = ring->sq_ptr;
+    char* cq = ring->cq_ptr;
+    ring->sq_head = (unsigned*)(sq + p.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+    ring->sq_mask = *(unsigned*)(sq + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + p.sq_off.array);
+    ring->cq_head = (unsigned*)(cq + p.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    ring->cq_mask = *(unsigned*)(cq + p.cq_off.ring_mask);
+    ring->cqes = cq + p.cq_off.cqes;
+    ring->entries = p.sq_entries;
+    ring->fd = fd;
+    
+    return 0;
+
+fail:
+    if (ring->sq_ptr && ring->sq_ptr != MAP_FAILED) {
+        munmap(ring->sq_ptr, ring->sq_size);
+    }
+    if (ring->cq_ptr) munmap(ring->cq_ptr, ring->cq_size);
+    close(fd);
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+    return -1;
+}
+
+void localio_uring_cleanup(localio_uring_t* ring) {
+    if (!ring || ring->fd < 0) return;
+    
+    munmap(ring->sqes, ring->sqes_size);
+    munmap(ring->cq_ptr, ring->cq_size);
+    munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->fd);
+    
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+/* Queue a read of the part of an extent past its first done bytes */
+static void uring_prep_read(localio_uring_t* ring, unsigned* tail, int fd,
+                            const localio_extent_t* extent, void* buf,
+                            size_t done, int index) {
+    size_t len = extent->count - done;
+    if (len > URING_MAX_READ) len = URING_MAX_READ;
+    
+    unsigned idx = *tail & ring->sq_mask;
+    struct io_uring_sqe* sqe = &((struct io_uring_sqe*)ring->sqes)[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)((char*)buf + done);
+    sqe->len = (uint32_t)len;
+    sqe->off = extent->offset + done;
+    sqe->user_data = (uint64_t)index;
+    ring->sq_array[idx] = idx;
+    (*tail)++;
+}
+
+/*
+ * Reads every extent in full like file_pread(): results[i] is the byte count
+ * (short only at EOF) or -errno. Extents longer than URING_MAX_READ and short
+ * completions are reissued for the remainder, so each request has at most one
+ * SQE outstanding and at most ring->entries are in flight. If io_uring_enter
+ * fails, SQEs the kernel hasn't consumed are withdrawn and the submitted ones
+ * are reaped before returning, so no completion outlives the call.
+ */
+int localio_uring_read_batch(localio_uring_t* ring, int fd,
+                             const localio_extent_t* extents, void** bufs,
+                             ssize_t* results, int count) {
+    if (!ring || ring->fd < 0 || fd < 0 || !extents || !bufs || !results ||
+        count < 0) {
+        return -1;
+    }
+    
+    struct io_uring_cqe* cqes = ring->cqes;
+    unsigned tail = *ring->sq_tail;
+    unsigned inflight = 0;      /* Queued or submitted, not yet reaped */
+    int next = 0;
+    int failed = 0;
+    int enter_err = 0;          /* Set once io_uring_enter has failed */
+    
+    for (int i = 0; i < count; i++) results[i] = 0;
+    
+    while (inflight > 0 || (next < count && !enter_err)) {
+        /* Start new requests while the ring has room */
+        while (!enter_err && next < count && inflight < ring->entries) {
+            if (extents[next].count > 0) {
+                uring_prep_read(ring, &tail, fd, &extents[next], bufs[next],
+                                0, next);
+                inflight++;
+            }
+            next++;
+        }
+        if (inflight == 0) break;
+        __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+        
+        unsigned queued = tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        int ret = uring_enter(ring->fd, queued, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0 && errno != EINTR) {
+            if (enter_err) break; /* Can't even wait for what's in flight */
+            enter_err = errno;
+            
+            /* Withdraw SQEs the kernel never consumed */
+            unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+            struct io_uring_sqe* sqes = ring->sqes;
+            for (unsigned t = head; t != tail; t++) {
+                uint64_t i = sqes[ring->sq_array[t & ring->sq_mask]].user_data;
+                results[i] = -enter_err;
+                failed++;
+                inflight--;
+            }
+            tail = head;
+            __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+            for (int i = next; i < count; i++) {
+                results[i] = -enter_err;
+                failed++;
+            }
+            next = count;
+            continue;
+        }
+        
+        unsigned head = *ring->cq_head;
+        unsigned cq_tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+        while (head != cq_tail) {
+            struct io_uring_cqe* cqe = &cqes[head & ring->cq_mask];
+            uint64_t i = cqe->user_data;
+            int res = cqe->res;
+            head++;
+            if (i >= (uint64_t)count) continue;
+            inflight--;
+            
+            if (res < 0 && res != -EINTR && res != -EAGAIN) {
+                results[i] = res;
+                failed++;
+                continue;
+            }
+            if (res > 0) results[i] += res;
+            
+            /* Reissue the remainder unless the read hit EOF */
+            int more = (res != 0 && (size_t)results[i] < extents[i].count);
+            if (more && enter_err) {
+                results[i] = -enter_err;
+                failed++;
+            } else if (more) {
+                uring_prep_read(ring, &tail, fd, &extents[i], bufs[i],
+                                (size_t)results[i], (int)i);
+                inflight++;
+            }
+        }
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+    
+    return (failed || enter_err) ? -1 : 0;
+}
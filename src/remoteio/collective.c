@@ -0,0 +1,651 @@
+/**
+ * @file collective.c
+ * @brief RemoteIO module - Ring and tree collectives
+ * @version 1.0.0
+ *
+ * Broadcast, allgather, reduce-scatter and allreduce among the ranks of a
+ * communicator, built from chained one-sided writes into each peer's
+ * channel slots (see remoteio_comm_t). Every rank drives its own part of
+ * the schedule: it writes chunks to the peers downstream of it and waits
+ * on counters in its own memory for the chunks coming from upstream, so
+ * nothing but the data and two counters per chunk crosses the wire.
+ *
+ * Schedules are chunk-major: a rank takes one chunk through all the steps
+ * of the collective before moving to the next, so consecutive chunks are
+ * in flight on every link at once and a chunk never waits for a whole
+ * step to finish. Ranks have their own order of sends and receives on
+ * each channel, and a send only ever waits for the receive of a chunk
+ * that was sent earlier, so no schedule deadlocks while a peer has a slot.
+ *
+ * Region lookups need the framed protocol, so peers are reached over the
+ * soft RDMA transport; a communicator is used by one thread at a time.
+ */
+
+#include "remoteio_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#define COLL_RETRY_US  10000     /* Between attempts to reach a starting peer */
+
+static uint64_t coll_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/* ============================================================================
+ * Channel Layout
+ * ============================================================================ */
+
+/* Counter peer p sets after each chunk it writes to us */
+static size_t coll_ready_off(const remoteio_comm_t* comm, int p) {
+    (void)comm;
+    return (size_t)p * REMOTEIO_COLL_LINE;
+}
+
+/* Counter peer p sets after each of our chunks it consumed */
+static size_t coll_credit_off(const remoteio_comm_t* comm, int p) {
+    return (size_t)(comm->size + p) * REMOTEIO_COLL_LINE;
+}
+
+static size_t coll_slot_off(const remoteio_comm_t* comm, int p, int slot) {
+    return (size_t)comm->size * 2 * REMOTEIO_COLL_LINE +
+           ((size_t)p * REMOTEIO_COLL_SLOTS + (size_t)slot) * REMOTEIO_COLL_CHUNK;
+}
+
+/* Our ready (0) or credit (1) counter source for peer p and a slot */
+static uint64_t* coll_word(remoteio_comm_t* comm, int p, int kind, int slot) {
+    return &comm->words[((size_t)p * 2 + (size_t)kind) * REMOTEIO_COLL_SLOTS + (size_t)slot];
+}
+
+/* ============================================================================
+ * Communicator
+ * ============================================================================ */
+
+/* "host:port" or a Unix socket path */
+static int coll_parse_peer(const char* peer, remoteio_coll_peer_t* out) {
+    if (!peer || !peer[0]) return -1;
+    
+    if (peer[0] == '/') {
+        if (strlen(peer) >= sizeof(out->addr)) return -1;
+        strcpy(out->addr, peer);
+        out->port = 0;
+        return 0;
+    }
+    
+    const char* colon = strrchr(peer, ':');
+    if (!colon || colon == peer || (size_t)(colon - peer) >= sizeof(out->addr)) return -1;
+    
+    char* end;
+    long port = strtol(colon + 1, &end, 10);
+    if (*end || port <= 0 || port > 65535) return -1;
+    
+    memcpy(out->addr, peer, (size_t)(colon - peer));
+    out->addr[colon - peer] = '\0';
+    out->port = (uint16_t)port;
+    return 0;
+}
+
+/**
+ * Join a communicator. server must be started, peers[p] is the address of
+ * rank p's server ("host:port" or a Unix socket path; peers[rank] is not
+ * used), and every rank passes the same name. Peers are reached lazily,
+ * the first time a collective needs them, so ranks may start in any order.
+ */
+int remoteio_comm_create(remoteio_context_t* ctx, remoteio_server_t* server,
+                         const char* name, int rank, int size,
+                         const char* const* peers, remoteio_comm_t** comm_out) {
+    if (!ctx || !server || !name || !peers || !comm_out) return -1;
+    if (size < 1 || rank < 0 || rank >= size) return -1;
+    
+    char rname[REMOTEIO_MAX_RESOURCE];
+    if (snprintf(rname, sizeof(rname), "%s.%d", name, rank) >= (int)sizeof(rname)) {
+        return -1;
+    }
+    
+    remoteio_comm_t* comm = calloc(1, sizeof(remoteio_comm_t));
+    if (!comm) return -1;
+    
+    comm->ctx = ctx;
+    comm->server = server;
+    strcpy(comm->name, name);
+    comm->rank = rank;
+    comm->size = size;
+    
+    comm->peers = calloc((size_t)size, sizeof(remoteio_coll_peer_t));
+    comm->words = calloc((size_t)size * 2 * REMOTEIO_COLL_SLOTS, sizeof(uint64_t));
+    if (!comm->peers || !comm->words) goto fail;
+    
+    for (int p = 0; p < size; p++) {
+        if (p != rank && coll_parse_peer(peers[p], &comm->peers[p]) != 0) goto fail;
+    }
+    
+    if (remoteio_register_local(ctx, comm->words,
+                                (size_t)size * 2 * REMOTEIO_COLL_SLOTS * sizeof(uint64_t),
+                                0, &comm->words_mr) != 0) {
+        comm->words_mr = NULL;
+        goto fail;
+    }
+    
+    /* Counters start at zero: nothing sent, nothing consumed */
+    comm->region_len = coll_slot_off(comm, size, 0);
+    void* region;
+    if (posix_memalign(&region, 4096, comm->region_len) != 0) goto fail;
+    comm->region = region;
+    memset(comm->region, 0, comm->region_len);
+    
+    remoteio_remote_mem_t mem;
+    if (remoteio_server_register_region(server, rname, comm->region, comm->region_len,
+                                        REMOTEIO_ACCESS_REMOTE_WRITE, &mem) != 0) {
+        goto fail;
+    }
+    comm->rkey = mem.rkey;
+    
+    *comm_out = comm;
+    return 0;
+
+fail:
+    if (comm->words_mr) remoteio_rdma_unregister_gpu_memory(comm->words_mr);
+    free(comm->region);
+    free(comm->words);
+    free(comm->peers);
+    free(comm);
+    return -1;
+}
+
+/* Wait for the op last posted in a slot, if it's still out */
+static int coll_reap(remoteio_operation_t* op, bool* posted) {
+    if (!*posted) return 0;
+    *posted = false;
+    return remoteio_op_wait(op, REMOTEIO_COLL_TIMEOUT_US);
+}
+
+/* Wait for every chunk we wrote, so the caller may reuse its buffer */
+static int coll_drain(remoteio_comm_t* comm) {
+    int ret = 0;
+    
+    for (int p = 0; p < comm->size; p++) {
+        remoteio_coll_peer_t* peer = &comm->peers[p];
+        
+        for (int s = 0; s < REMOTEIO_COLL_SLOTS; s++) {
+            if (!peer->tx_posted[s]) continue;
+            if (coll_reap(peer->ready_ops[s], &peer->tx_posted[s]) != 0 ||
+                peer->data_ops[s]->status != GPUIO_SUCCESS) {
+                ret = -1;
+            }
+        }
+    }
+    return ret;
+}
+
+/**
+ * Leave a communicator. Peers may still be finishing a collective this
+ * rank completed; their last credit writes fail harmlessly.
+ */
+void remoteio_comm_destroy(remoteio_comm_t* comm) {
+    if (!comm) return;
+    
+    coll_drain(comm);
+    
+    for (int p = 0; p < comm->size; p++) {
+        remoteio_coll_peer_t* peer = &comm->peers[p];
+        
+        for (int s = 0; s < REMOTEIO_COLL_SLOTS; s++) {
+            coll_reap(peer->credit_ops[s], &peer->credit_posted[s]);
+            remoteio_op_free(comm->ctx, peer->data_ops[s]);
+            remoteio_op_free(comm->ctx, peer->ready_ops[s]);
+            remoteio_op_free(comm->ctx, peer->credit_ops[s]);
+        }
+        if (peer->conn) remoteio_disconnect(comm->ctx, peer->conn);
+    }
+    
+    remoteio_server_deregister_region(comm->server, comm->rkey);
+    remoteio_rdma_unregister_gpu_memory(comm->words_mr);
+    free(comm->region);
+    free(comm->words);
+    free(comm->peers);
+    free(comm);
+}
+
+int remoteio_comm_get_stats(remoteio_comm_t* comm, remoteio_comm_stats_t* stats) {
+    if (!comm || !stats) return -1;
+    
+    *stats = comm->stats;
+    return 0;
+}
+
+/* Connect to a peer and find its channels, retrying while it starts up */
+static int coll_connect(remoteio_comm_t* comm, int p) {
+    remoteio_coll_peer_t* peer = &comm->peers[p];
+    if (peer->conn) return 0;
+    
+    char rname[REMOTEIO_MAX_RESOURCE];
+    if (snprintf(rname, sizeof(rname), "%s.%d", comm->name, p) >= (int)sizeof(rname)) {
+        return -1;
+    }
+    
+    uint64_t start = coll_now_us();
+    remoteio_connection_t* conn = NULL;
+    
+    for (;;) {
+        if (!conn && remoteio_connect(comm->ctx, peer->addr, peer->port, &conn) != 0) {
+            conn = NULL;
+        }
+        if (conn && !conn->proto) break;    /* No control channel to look up on */
+        if (conn && remoteio_proto_lookup(comm->ctx, conn, rname, &peer->mem) == 0) break;
+        
+        /* A dropped connection is pooled no longer; get a new one */
+        if (conn && conn->state != REMOTEIO_CONN_CONNECTED) {
+            remoteio_disconnect(comm->ctx, conn);
+            conn = NULL;
+        }
+        if (coll_now_us() - start > REMOTEIO_COLL_TIMEOUT_US) break;
+        usleep(COLL_RETRY_US);
+    }
+    
+    if (!conn || !conn->proto || peer->mem.rkey == 0) {
+        if (conn) remoteio_disconnect(comm->ctx, conn);
+        return -1;
+    }
+    
+    /* Kept from an earlier attempt if that ran out of ops */
+    for (int s = 0; s < REMOTEIO_COLL_SLOTS; s++) {
+        if (!peer->data_ops[s]) peer->data_ops[s] = remoteio_op_alloc(comm->ctx);
+        if (!peer->ready_ops[s]) peer->ready_ops[s] = remoteio_op_alloc(comm->ctx);
+        if (!peer->credit_ops[s]) peer->credit_ops[s] = remoteio_op_alloc(comm->ctx);
+        if (!peer->data_ops[s] || !peer->ready_ops[s] || !peer->credit_ops[s]) {
+            remoteio_disconnect(comm->ctx, conn);
+            return -1;
+        }
+    }
+    
+    peer->conn = conn;
+    return 0;
+}
+
+/* Spin until a counter in our region reaches target */
+static int coll_wait_counter(remoteio_comm_t* comm, size_t offset, uint64_t target,
+                             uint64_t* wait_us) {
+    const uint64_t* counter = (const uint64_t*)(comm->region + offset);
+    if (__atomic_load_n(counter, __ATOMIC_ACQUIRE) >= target) return 0;
+    
+    uint64_t start = coll_now_us();
+    for (unsigned spins = 1; __atomic_load_n(counter, __ATOMIC_ACQUIRE) < target; spins++) {
+        if ((spins & 1023) == 0 && coll_now_us() - start > REMOTEIO_COLL_TIMEOUT_US) {
+            return -1;
+        }
+        sched_yield();
+    }
+    *wait_us += coll_now_us() - start;
+    return 0;
+}
+
+/* One-sided WRITE of a registered range into a peer's region */
+static void coll_set_write(remoteio_operation_t* op, remoteio_coll_peer_t* peer,
+                           remoteio_gdr_region_t* mr, uint64_t offset, size_t len,
+                           uint64_t remote_offset) {
+    op->op = REMOTEIO_OP_WRITE;
+    op->conn = peer->conn;
+    op->local_gdr = mr;
+    op->local_offset = offset;
+    op->remote_mem = &peer->mem;
+    op->remote_offset = remote_offset;
+    op->length = len;
+    op->num_sge = 0;
+    op->next_sg = NULL;
+}
+
+/* Write len bytes of mr at offset into our next slot at peer p */
+static int coll_send(remoteio_comm_t* comm, int p, remoteio_gdr_region_t* mr,
+                     uint64_t offset, size_t len) {
+    if (coll_connect(comm, p) != 0) return -1;
+    
+    remoteio_coll_peer_t* peer = &comm->peers[p];
+    
+    /* The slot is free once the peer consumed the chunk SLOTS back */
+    if (peer->sent >= REMOTEIO_COLL_SLOTS &&
+        coll_wait_counter(comm, coll_credit_off(comm, p),
+                          peer->sent - REMOTEIO_COLL_SLOTS + 1,
+                          &comm->stats.slot_wait_us) != 0) {
+        return -1;
+    }
+    
+    int slot = (int)(peer->sent % REMOTEIO_COLL_SLOTS);
+    remoteio_operation_t* data = peer->data_ops[slot];
+    remoteio_operation_t* ready = peer->ready_ops[slot];
+    
+    if (coll_reap(ready, &peer->tx_posted[slot]) != 0 || data->status != GPUIO_SUCCESS) {
+        return -1;
+    }
+    
+    uint64_t* word = coll_word(comm, p, 0, slot);
+    *word = peer->sent + 1;
+    
+    coll_set_write(data, peer, mr, offset, len, coll_slot_off(comm, comm->rank, slot));
+    coll_set_write(ready, peer, comm->words_mr,
+                   (uint64_t)((uint8_t*)word - (uint8_t*)comm->words), sizeof(*word),
+                   coll_ready_off(comm, comm->rank));
+    data->next_sg = ready;
+    
+    /* Only the counter write is signalled; the data completes with it */
+    int posted = remoteio_op_post_chain(comm->ctx, data, 2);
+    if (posted < 2) {
+        /* The data write alone went out: let it finish with the buffer */
+        if (posted == 1) remoteio_op_wait(data, REMOTEIO_COLL_TIMEOUT_US);
+        return -1;
+    }
+    
+    peer->tx_posted[slot] = true;
+    peer->sent++;
+    comm->stats.chunks_sent++;
+    comm->stats.bytes_sent += len;
+    return 0;
+}
+
+/* Wait for the next chunk from peer p and return its slot */
+static const void* coll_recv(remoteio_comm_t* comm, int p) {
+    remoteio_coll_peer_t* peer = &comm->peers[p];
+    
+    if (coll_wait_counter(comm, coll_ready_off(comm, p), peer->consumed + 1,
+                          &comm->stats.data_wait_us) != 0) {
+        return NULL;
+    }
+    
+    comm->stats.chunks_received++;
+    return comm->region + coll_slot_off(comm, p, (int)(peer->consumed % REMOTEIO_COLL_SLOTS));
+}
+
+/*
+ * Give the slot coll_recv() returned back to its sender. Best effort: a
+ * sender that finished and left needs no more credits, and one that does
+ * times out waiting for them.
+ */
+static void coll_release(remoteio_comm_t* comm, int p) {
+    remoteio_coll_peer_t* peer = &comm->peers[p];
+    int slot = (int)(peer->consumed++ % REMOTEIO_COLL_SLOTS);
+    
+    if (coll_connect(comm, p) != 0) return;
+    
+    remoteio_operation_t* op = peer->credit_ops[slot];
+    coll_reap(op, &peer->credit_posted[slot]);
+    
+    uint64_t* word = coll_word(comm, p, 1, slot);
+    *word = peer->consumed;
+    
+    coll_set_write(op, peer, comm->words_mr,
+                   (uint64_t)((uint8_t*)word - (uint8_t*)comm->words), sizeof(*word),
+                   coll_credit_off(comm, comm->rank));
+    peer->credit_posted[slot] = remoteio_op_post_chain(comm->ctx, op, 1) > 0;
+}
+
+/* ============================================================================
+ * Schedules
+ * ============================================================================ */
+
+static void coll_reduce(float* dst, const float* src, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] += src[i];
+    }
+}
+
+/* Receive the next chunk from peer p into dst, summing floats if reduce */
+static int coll_recv_into(remoteio_comm_t* comm, int p, uint8_t* dst, size_t len,
+                          bool reduce) {
+    const void* src = coll_recv(comm, p);
+    if (!src) return -1;
+    
+    if (reduce) {
+        coll_reduce((float*)dst, (const float*)src, len / sizeof(float));
+    } else {
+        memcpy(dst, src, len);
+    }
+    coll_release(comm, p);
+    return 0;
+}
+
+/* Elements of chunk c of segment s; 0 past its end */
+static size_t coll_chunk(const size_t* seg, int s, size_t chunk_elems, size_t c,
+                         size_t* first) {
+    size_t len = seg[s + 1] - seg[s];
+    size_t start = c * chunk_elems;
+    if (start >= len) return 0;
+    
+    *first = seg[s] + start;
+    return len - start < chunk_elems ? len - start : chunk_elems;
+}
+
+/*
+ * Ring over segments seg[i]..seg[i+1] (in elements of elem bytes). The
+ * reduce-scatter steps leave segment r summed on rank r; the allgather
+ * steps then pass each rank's segment around to everyone.
+ */
+static int coll_ring(remoteio_comm_t* comm, uint8_t* buf, remoteio_gdr_region_t* mr,
+                     const size_t* seg, size_t elem, bool reduce, bool gather) {
+    int n = comm->size;
+    int r = comm->rank;
+    int next = (r + 1) % n;
+    int prev = (r + n - 1) % n;
+    
+    size_t chunk_elems = REMOTEIO_COLL_CHUNK / elem;
+    size_t max_seg = 0;
+    for (int s = 0; s < n; s++) {
+        if (seg[s + 1] - seg[s] > max_seg) max_seg = seg[s + 1] - seg[s];
+    }
+    size_t chunks = (max_seg + chunk_elems - 1) / chunk_elems;
+    
+    int rs_steps = reduce ? n - 1 : 0;
+    int steps = rs_steps + (gather ? n - 1 : 0);
+    
+    for (size_t c = 0; c < chunks; c++) {
+        for (int k = 0; k < steps; k++) {
+            int j = k < rs_steps ? k + 1 : k - rs_steps;
+            int send_seg = ((r - j) % n + n) % n;
+            int recv_seg = ((r - j - 1) % n + n) % n;
+            size_t first;
+            size_t count;
+            
+            count = coll_chunk(seg, send_seg, chunk_elems, c, &first);
+            if (count && coll_send(comm, next, mr, first * elem, count * elem) != 0) {
+                return -1;
+            }
+            
+            count = coll_chunk(seg, recv_seg, chunk_elems, c, &first);
+            if (count && coll_recv_into(comm, prev, buf + first * elem, count * elem,
+                                        k < rs_steps) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* Parent and children of rank in a ring (a chain) or binary tree at root */
+static int coll_links(const remoteio_comm_t* comm, int root, remoteio_coll_algo_t algo,
+                      int* parent, int kids[2]) {
+    int n = comm->size;
+    int v = (comm->rank - root + n) % n;
+    int num_kids = 0;
+    
+    *parent = -1;
+    if (algo == REMOTEIO_COLL_TREE) {
+        if (v > 0) *parent = ((v - 1) / 2 + root) % n;
+        for (int k = 2 * v + 1; k <= 2 * v + 2 && k < n; k++) {
+            kids[num_kids++] = (k + root) % n;
+        }
+    } else {
+        if (v > 0) *parent = (v - 1 + root) % n;
+        if (v + 1 < n) kids[num_kids++] = (v + 1 + root) % n;
+    }
+    return num_kids;
+}
+
+/* Pass root's buffer down the chain or tree, a chunk at a time */
+static int coll_bcast(remoteio_comm_t* comm, uint8_t* buf, remoteio_gdr_region_t* mr,
+                      size_t len, int root, remoteio_coll_algo_t algo) {
+    int parent;
+    int kids[2];
+    int num_kids = coll_links(comm, root, algo, &parent, kids);
+    
+    for (size_t off = 0; off < len; off += REMOTEIO_COLL_CHUNK) {
+        size_t count = len - off < REMOTEIO_COLL_CHUNK ? len - off : REMOTEIO_COLL_CHUNK;
+        
+        if (parent >= 0 && coll_recv_into(comm, parent, buf + off, count, false) != 0) {
+            return -1;
+        }
+        for (int k = 0; k < num_kids; k++) {
+            if (coll_send(comm, kids[k], mr, off, count) != 0) return -1;
+        }
+    }
+    return 0;
+}
+
+/* Sum everyone's buffer into rank 0's, up the binary tree */
+static int coll_tree_reduce(remoteio_comm_t* comm, float* buf, remoteio_gdr_region_t* mr,
+                            size_t count) {
+    int parent;
+    int kids[2];
+    int num_kids = coll_links(comm, 0, REMOTEIO_COLL_TREE, &parent, kids);
+    size_t chunk_elems = REMOTEIO_COLL_CHUNK / sizeof(float);
+    
+    for (size_t first = 0; first < count; first += chunk_elems) {
+        size_t n = count - first < chunk_elems ? count - first : chunk_elems;
+        
+        for (int k = 0; k < num_kids; k++) {
+            if (coll_recv_into(comm, kids[k], (uint8_t*)(buf + first), n * sizeof(float),
+                               true) != 0) {
+                return -1;
+            }
+        }
+        if (parent >= 0 &&
+            coll_send(comm, parent, mr, first * sizeof(float), n * sizeof(float)) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Register the caller's buffer as the source of our writes */
+static int coll_begin(remoteio_comm_t* comm, void* buf, size_t len,
+                      remoteio_gdr_region_t** mr) {
+    *mr = NULL;
+    if (comm->failed) return -1;
+    if (len == 0 || comm->size == 1) return 0;
+    
+    return remoteio_register_local(comm->ctx, buf, len, 0, mr);
+}
+
+/* A collective that failed partway leaves the counters out of step */
+static int coll_end(remoteio_comm_t* comm, remoteio_gdr_region_t* mr, int ret) {
+    if (coll_drain(comm) != 0) ret = -1;
+    if (mr) remoteio_rdma_unregister_gpu_memory(mr);
+    
+    if (ret != 0) {
+        comm->failed = true;
+    } else {
+        comm->stats.collectives++;
+    }
+    return ret;
+}
+
+/* Equal segments of len elements, one per rank */
+static size_t* coll_segments(int n, size_t len) {
+    size_t* seg = malloc((size_t)(n + 1) * sizeof(size_t));
+    if (!seg) return NULL;
+    
+    for (int s = 0; s <= n; s++) {
+        seg[s] = (size_t)s * len;
+    }
+    return seg;
+}
+
+/* ============================================================================
+ * Collectives
+ * ============================================================================ */
+
+/** Copy len bytes of root's buf into everyone's */
+int remoteio_coll_broadcast(remoteio_comm_t* comm, void* buf, size_t len, int root,
+                            remoteio_coll_algo_t algo) {
+    if (!comm || (!buf && len > 0) || root < 0 || root >= comm->size) return -1;
+    
+    remoteio_gdr_region_t* mr;
+    if (coll_begin(comm, buf, len, &mr) != 0) return -1;
+    if (!mr) return 0;
+    
+    return coll_end(comm, mr, coll_bcast(comm, buf, mr, len, root, algo));
+}
+
+/**
+ * Gather every rank's len_per_rank bytes: buf holds size of them and rank
+ * r fills in the r-th before the call.
+ */
+int remoteio_coll_allgather(remoteio_comm_t* comm, void* buf, size_t len_per_rank) {
+    if (!comm || (!buf && len_per_rank > 0)) return -1;
+    
+    remoteio_gdr_region_t* mr;
+    if (coll_begin(comm, buf, len_per_rank * (size_t)comm->size, &mr) != 0) return -1;
+    if (!mr) return 0;
+    
+    size_t* seg = coll_segments(comm->size, len_per_rank);
+    int ret = seg ? coll_ring(comm, buf, mr, seg, 1, false, true) : -1;
+    free(seg);
+    
+    return coll_end(comm, mr, ret);
+}
+
+/**
+ * Sum the ranks' buf (size * count_per_rank floats) in place, in pieces:
+ * afterwards rank r's r-th piece holds the sum and its others are
+ * clobbered.
+ */
+int remoteio_coll_reduce_scatter(remoteio_comm_t* comm, float* buf, size_t count_per_rank) {
+    if (!comm || (!buf && count_per_rank > 0)) return -1;
+    
+    remoteio_gdr_region_t* mr;
+    size_t len = count_per_rank * (size_t)comm->size * sizeof(float);
+    if (coll_begin(comm, buf, len, &mr) != 0) return -1;
+    if (!mr) return 0;
+    
+    size_t* seg = coll_segments(comm->size, count_per_rank);
+    int ret = seg ? coll_ring(comm, (uint8_t*)buf, mr, seg, sizeof(float), true, false) : -1;
+    free(seg);
+    
+    return coll_end(comm, mr, ret);
+}
+
+/**
+ * Sum the ranks' count floats in place on every rank. A ring moves the
+ * least data per rank; a tree takes fewer hops, for small buffers.
+ */
+int remoteio_coll_allreduce(remoteio_comm_t* comm, float* buf, size_t count,
+                            remoteio_coll_algo_t algo) {
+    if (!comm || (!buf && count > 0)) return -1;
+    
+    remoteio_gdr_region_t* mr;
+    if (coll_begin(comm, buf, count * sizeof(float), &mr) != 0) return -1;
+    if (!mr) return 0;
+    
+    int ret;
+    if (algo == REMOTEIO_COLL_TREE) {
+        ret = coll_tree_reduce(comm, buf, mr, count);
+        if (ret == 0) {
+            ret = coll_bcast(comm, (uint8_t*)buf, mr, count * sizeof(float), 0,
+                             REMOTEIO_COLL_TREE);
+        }
+    } else {
+        /* Uneven segments when count doesn't divide; some may be empty */
+        size_t* seg = malloc((size_t)(comm->size + 1) * sizeof(size_t));
+        if (seg) {
+            for (int s = 0; s <= comm->size; s++) {
+                seg[s] = count * (size_t)s / (size_t)comm->size;
+            }
+        }
+        ret = seg ? coll_ring(comm, (uint8_t*)buf, mr, seg, sizeof(float), true, true) : -1;
+        free(seg);
+    }
+    
+    return coll_end(comm, mr, ret);
+}
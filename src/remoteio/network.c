@@ -17,7 +17,10 @@
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <sys/un.h>
 #include <poll.h>
+#include <sys/sendfile.h>
+#include <linux/errqueue.h>
 
 /* Network configuration */
 #define NETWORK_DEFAULT_TIMEOUT_MS  30000
@@ -86,16 +89,34 @@ static int set_socket_options(int fd) {
     return 0;
 }
 
+/* A peer address starting with '/' is a Unix socket path, one starting
+ * with '@' a name in the abstract namespace; port is unused */
+static int unix_sockaddr(const char* path, struct sockaddr_un* sun) {
+    memset(sun, 0, sizeof(*sun));
+    sun->sun_family = AF_UNIX;
+    /* It must fit peer_addr too */
+    if (strlen(path) >= sizeof(sun->sun_path) || strlen(path) >= INET6_ADDRSTRLEN) {
+        return -1;
+    }
+    strcpy(sun->sun_path, path);
+    if (path[0] == '@') sun->sun_path[0] = '\0';
+    return 0;
+}
+
 int remoteio_network_connect(remoteio_context_t* ctx, remoteio_connection_t* conn,
                              const char* addr, uint16_t port) {
     if (!ctx || !conn || !addr) return -1;
     
+    bool local = addr[0] == '/' || addr[0] == '@';
+    struct sockaddr_un sun;
+    if (local && unix_sockaddr(addr, &sun) != 0) return -1;
+    
     /* Create socket */
-    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int fd = socket(local ? AF_UNIX : AF_INET, SOCK_STREAM, 0);
     if (fd < 0) return -1;
     
     /* Set socket options */
-    if (set_socket_options(fd) < 0) {
+    if (!local && set_socket_options(fd) < 0) {
         close(fd);
         return -1;
     }
@@ -112,7 +133,7 @@ int remoteio_network_connect(remoteio_context_t* ctx, remoteio_connection_t* con
     sin.sin_family = AF_INET;
     sin.sin_port = htons(port);
     
-    if (inet_pton(AF_INET, addr, &sin.sin_addr) <= 0) {
+    if (!local && inet_pton(AF_INET, addr, &sin.sin_addr) <= 0) {
         /* Try hostname resolution */
         struct hostent* he = gethostbyname(addr);
         if (!he) {
@@ -123,7 +144,8 @@ int remoteio_network_connect(remoteio_context_t* ctx, remoteio_connection_t* con
     }
     
     /* Connect */
-    int ret = connect(fd, (struct sockaddr*)&sin, sizeof(sin));
+    int ret = local ? connect(fd, (struct sockaddr*)&sun, sizeof(sun))
+                    : connect(fd, (struct sockaddr*)&sin, sizeof(sin));
     if (ret < 0 && errno != EINPROGRESS) {
         close(fd);
         return -1;
@@ -158,10 +180,13 @@ int remoteio_network_connect(remoteio_context_t* ctx, remoteio_connection_t* con
     conn->socket_fd = fd;
     conn->state = REMOTEIO_CONN_CONNECTED;
     conn->transport = REMOTEIO_TRANSPORT_TCP;
-    strncpy(conn->peer_addr, addr, INET_ADDRSTRLEN - 1);
+    strncpy(conn->peer_addr, addr, sizeof(conn->peer_addr) - 1);
     conn->peer_port = port;
     pthread_mutex_unlock(&conn->lock);
     
+    /* Best effort: large payloads go out with MSG_ZEROCOPY when allowed */
+    remoteio_network_enable_zerocopy(conn);
+    
     return 0;
 }
 
@@ -193,11 +218,17 @@ int remoteio_network_send(remoteio_connection_t* conn, const void* buf, size_t l
     if (!conn || !buf || len == 0) return -1;
     if (conn->state != REMOTEIO_CONN_CONNECTED) return -1;
     
+    if (conn->shm) {
+        struct iovec iov = { .iov_base = (void*)buf, .iov_len = len };
+        return remoteio_shm_send(conn, &iov, 1);
+    }
+    
     size_t total_sent = 0;
     const char* ptr = (const char*)buf;
     
     while (total_sent < len) {
-        ssize_t sent = send(conn->socket_fd, ptr + total_sent, len - total_sent, 0);
+        ssize_t sent = send(conn->socket_fd, ptr + total_sent, len - total_sent,
+                            MSG_NOSIGNAL);
         if (sent < 0) {
             if (errno == EINTR) continue;
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
@@ -225,6 +256,309 @@ int remoteio_network_send(remoteio_connection_t* conn, const void* buf, size_t l
     return 0;
 }
 
+/* Gather-write a frame; the iovec array is consumed. flags may add MSG_MORE. */
+int remoteio_network_sendv(remoteio_connection_t* conn, struct iovec* iov, int iovcnt,
+                           int flags) {
+    if (!conn || !iov || iovcnt <= 0) return -1;
+    if (conn->state != REMOTEIO_CONN_CONNECTED) return -1;
+    
+    /* Rings publish a whole call at once; MSG_MORE has nothing to add */
+    if (conn->shm) return remoteio_shm_send(conn, iov, iovcnt);
+    
+    size_t total_sent = 0;
+    
+    while (iovcnt > 0) {
+        /* A peer that went away must not raise SIGPIPE */
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = (size_t)iovcnt };
+        ssize_t sent = sendmsg(conn->socket_fd, &msg, MSG_NOSIGNAL | flags);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct pollfd pfd = {
+                    .fd = conn->socket_fd,
+                    .events = POLLOUT
+                };
+                if (poll(&pfd, 1, NETWORK_DEFAULT_TIMEOUT_MS) <= 0) {
+                    return -1;
+                }
+                continue;
+            }
+            return -1;
+        }
+        total_sent += sent;
+        
+        /* Skip fully written entries, trim a partial one */
+        size_t n = (size_t)sent;
+        while (iovcnt > 0 && n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    
+    pthread_mutex_lock(&conn->lock);
+    conn->bytes_sent += total_sent;
+    pthread_mutex_unlock(&conn->lock);
+    
+    return 0;
+}
+
+/* ============================================================================
+ * Zero-Copy Sends
+ * ============================================================================ */
+
+/*
+ * With SO_ZEROCOPY set, sends flagged MSG_ZEROCOPY pin the caller's pages
+ * instead of copying them. Each such sendmsg() call takes the next number in
+ * a per-socket sequence, and the kernel reports finished ranges of that
+ * sequence on the socket error queue; until then the buffer must not be
+ * touched. conn->zc_sent counts calls made, conn->zc_acked the calls the
+ * kernel has released. Ranges may be reported out of order, so zc_acked
+ * only moves over a contiguous prefix; later ranges wait in zc_done.
+ */
+
+int remoteio_network_enable_zerocopy(remoteio_connection_t* conn) {
+    if (!conn || conn->socket_fd < 0 || conn->shm) return -1;
+    
+    int yes = 1;
+    if (setsockopt(conn->socket_fd, SOL_SOCKET, SO_ZEROCOPY, &yes, sizeof(yes)) != 0) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&conn->lock);
+    conn->zc_enabled = true;
+    pthread_mutex_unlock(&conn->lock);
+    return 0;
+}
+
+/**
+ * Send len bytes with MSG_ZEROCOPY. Callers serialize sends on the socket.
+ * Returns the sequence number the kernel must release before buf may be
+ * reused (see remoteio_network_zc_wait), or -1 on error.
+ */
+int64_t remoteio_network_send_zerocopy(remoteio_connection_t* conn, const void* buf,
+                                       size_t len) {
+    if (!conn || !buf || len == 0) return -1;
+    if (conn->state != REMOTEIO_CONN_CONNECTED) return -1;
+    
+    size_t total_sent = 0;
+    int zc_flag = MSG_ZEROCOPY;
+    uint32_t calls = 0;
+    
+    while (total_sent < len) {
+        ssize_t sent = send(conn->socket_fd, (const char*)buf + total_sent,
+                            len - total_sent, MSG_NOSIGNAL | zc_flag);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS && zc_flag) {
+                /* Out of pinned-page budget: copy the rest */
+                zc_flag = 0;
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct pollfd pfd = {
+                    .fd = conn->socket_fd,
+                    .events = POLLOUT
+                };
+                if (poll(&pfd, 1, NETWORK_DEFAULT_TIMEOUT_MS) <= 0) {
+                    return -1;
+                }
+                continue;
+            }
+            return -1;
+        }
+        if (zc_flag) calls++;
+        total_sent += sent;
+    }
+    
+    pthread_mutex_lock(&conn->lock);
+    conn->bytes_sent += total_sent;
+    conn->zc_sent += calls;
+    conn->zc_bytes += total_sent;
+    uint32_t seq = conn->zc_sent;
+    pthread_mutex_unlock(&conn->lock);
+    
+    return seq;
+}
+
+/*
+ * Record that calls first..last (inclusive) were released and advance
+ * zc_acked over whatever prefix is now complete. Caller holds conn->lock.
+ */
+void remoteio_network_zc_release(remoteio_connection_t* conn, uint32_t first,
+                                 uint32_t last) {
+    uint32_t end = last + 1;
+    if ((int32_t)(end - conn->zc_acked) <= 0) return;
+    
+    if ((int32_t)(first - conn->zc_acked) > 0) {
+        /* A gap before this range: park it until the gap is released */
+        if (conn->zc_num_done == conn->zc_done_cap) {
+            uint32_t cap = conn->zc_done_cap ? conn->zc_done_cap * 2 : 8;
+            remoteio_zc_range_t* done = realloc(conn->zc_done, cap * sizeof(*done));
+            if (!done) return;
+            conn->zc_done = done;
+            conn->zc_done_cap = cap;
+        }
+        conn->zc_done[conn->zc_num_done].first = first;
+        conn->zc_done[conn->zc_num_done].end = end;
+        conn->zc_num_done++;
+        return;
+    }
+    
+    conn->zc_acked = end;
+    
+    /* Absorb parked ranges the prefix now reaches */
+    bool advanced = true;
+    while (advanced) {
+        advanced = false;
+        for (uint32_t i = 0; i < conn->zc_num_done; ) {
+            remoteio_zc_range_t* r = &conn->zc_done[i];
+            if ((int32_t)(r->first - conn->zc_acked) > 0) {
+                i++;
+                continue;
+            }
+            if ((int32_t)(r->end - conn->zc_acked) > 0) {
+                conn->zc_acked = r->end;
+                advanced = true;
+            }
+            *r = conn->zc_done[--conn->zc_num_done];
+        }
+    }
+}
+
+/* Read zero-copy completions off the error queue */
+int remoteio_network_zc_drain(remoteio_connection_t* conn) {
+    if (!conn || conn->socket_fd < 0) return -1;
+    
+    for (;;) {
+        char control[128];
+        struct msghdr msg = {
+            .msg_control = control,
+            .msg_controllen = sizeof(control)
+        };
+        
+        ssize_t ret = recvmsg(conn->socket_fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            return -1;
+        }
+        
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                  (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            
+            struct sock_extended_err serr;
+            memcpy(&serr, CMSG_DATA(cm), sizeof(serr));
+            if (serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr.ee_errno != 0) {
+                continue;
+            }
+            
+            /* Calls ee_info..ee_data (inclusive) are released */
+            pthread_mutex_lock(&conn->lock);
+            remoteio_network_zc_release(conn, serr.ee_info, serr.ee_data);
+            if (serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                /* The kernel fell back to copying, e.g. on loopback */
+                conn->zc_copied += serr.ee_data - serr.ee_info + 1;
+            }
+            pthread_cond_broadcast(&conn->state_cond);
+            pthread_mutex_unlock(&conn->lock);
+        }
+    }
+}
+
+/*
+ * Block until the kernel has released zero-copy send number seq. The
+ * reactor drains the error queue of connections it services and signals
+ * state_cond; the waiter drains as well, for sockets nobody else watches.
+ */
+int remoteio_network_zc_wait(remoteio_connection_t* conn, uint32_t seq) {
+    if (!conn) return -1;
+    
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += NETWORK_DEFAULT_TIMEOUT_MS / 1000;
+    
+    for (;;) {
+        if (remoteio_network_zc_drain(conn) != 0) return -1;
+        
+        struct timespec slice;
+        clock_gettime(CLOCK_REALTIME, &slice);
+        bool expired = slice.tv_sec > deadline.tv_sec ||
+                       (slice.tv_sec == deadline.tv_sec && slice.tv_nsec >= deadline.tv_nsec);
+        slice.tv_nsec += 10 * 1000000L;
+        if (slice.tv_nsec >= 1000000000L) {
+            slice.tv_sec++;
+            slice.tv_nsec -= 1000000000L;
+        }
+        
+        pthread_mutex_lock(&conn->lock);
+        bool done = (int32_t)(conn->zc_acked - seq) >= 0;
+        bool live = conn->state == REMOTEIO_CONN_CONNECTED;
+        if (!done && live && !expired) {
+            pthread_cond_timedwait(&conn->state_cond, &conn->lock, &slice);
+            done = (int32_t)(conn->zc_acked - seq) >= 0;
+        }
+        pthread_mutex_unlock(&conn->lock);
+        
+        if (done) return 0;
+        if (!live || expired) {
+            /* Completions may still be queued behind a hangup */
+            remoteio_network_zc_drain(conn);
+            pthread_mutex_lock(&conn->lock);
+            done = (int32_t)(conn->zc_acked - seq) >= 0;
+            pthread_mutex_unlock(&conn->lock);
+            return done ? 0 : -1;
+        }
+    }
+}
+
+/* Send a file range straight from the page cache */
+int remoteio_network_sendfile(remoteio_connection_t* conn, int fd, uint64_t offset,
+                              size_t len) {
+    if (!conn || fd < 0) return -1;
+    if (conn->state != REMOTEIO_CONN_CONNECTED) return -1;
+    
+    if (conn->shm) return remoteio_shm_sendfile(conn, fd, offset, len);
+    
+    off_t off = (off_t)offset;
+    size_t total_sent = 0;
+    
+    while (total_sent < len) {
+        ssize_t sent = sendfile(conn->socket_fd, fd, &off, len - total_sent);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct pollfd pfd = {
+                    .fd = conn->socket_fd,
+                    .events = POLLOUT
+                };
+                if (poll(&pfd, 1, NETWORK_DEFAULT_TIMEOUT_MS) <= 0) {
+                    return -1;
+                }
+                continue;
+            }
+            return -1;
+        }
+        if (sent == 0) {
+            return -1; /* File shorter than the range */
+        }
+        total_sent += sent;
+    }
+    
+    pthread_mutex_lock(&conn->lock);
+    conn->bytes_sent += total_sent;
+    pthread_mutex_unlock(&conn->lock);
+    
+    return 0;
+}
+
 int remoteio_network_recv(remoteio_connection_t* conn, void* buf, size_t len) {
     if (!conn || !buf || len == 0) return -1;
     if (conn->state != REMOTEIO_CONN_CONNECTED) return -1;
@@ -233,12 +567,12 @@ int remoteio_network_recv(remoteio_connection_t* conn, void* buf, size_t len) {
     char* ptr = (char*)buf;
     
     while (total_recv < len) {
-        ssize_t recvd = recv(conn->socket_fd, ptr + total_recv, len - total_recv, 0);
+        ssize_t recvd = remoteio_network_recv_some(conn, ptr + total_recv, len - total_recv);
         if (recvd < 0) {
             if (errno == EINTR) continue;
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 struct pollfd pfd = {
-                    .fd = conn->socket_fd,
+                    .fd = remoteio_network_poll_fd(conn),
                     .events = POLLIN
                 };
                 if (poll(&pfd, 1, NETWORK_DEFAULT_TIMEOUT_MS) <= 0) {
@@ -261,6 +595,27 @@ int remoteio_network_recv(remoteio_connection_t* conn, void* buf, size_t len) {
     return 0;
 }
 
+/* Read what has arrived without blocking: recv() semantics, -1 with EAGAIN
+ * when nothing has */
+ssize_t remoteio_network_recv_some(remoteio_connection_t* conn, void* buf, size_t len) {
+    if (conn->shm) return remoteio_shm_recv(conn, buf, len);
+    return recv(conn->socket_fd, buf, len, MSG_DONTWAIT);
+}
+
+/* The fd that turns readable when the connection has bytes to receive */
+int remoteio_network_poll_fd(remoteio_connection_t* conn) {
+    return conn->shm ? conn->shm->poll_fd : conn->socket_fd;
+}
+
+/* Fail the stream both ways, waking anyone blocked on it */
+void remoteio_network_shutdown(remoteio_connection_t* conn) {
+    if (conn->shm) {
+        remoteio_shm_shutdown(conn);
+    } else {
+        shutdown(conn->socket_fd, SHUT_RDWR);
+    }
+}
+
 int remoteio_network_send_recv(remoteio_connection_t* conn,
                                const void* send_buf, size_t send_len,
                                void* recv_buf, size_t recv_len) {
@@ -281,20 +636,33 @@ int remoteio_network_send_recv(remoteio_connection_t* conn,
 
 static void* listener_thread(void* arg) {
     remoteio_listener_t* listener = (remoteio_listener_t*)arg;
+    int listen_fd = listener->socket_fd;
     
-    while (listener->running) {
-        struct sockaddr_in client_addr;
+    for (;;) {
+        struct sockaddr_storage client_addr;
         socklen_t addr_len = sizeof(client_addr);
         
-        int client_fd = accept(listener->socket_fd, 
-                               (struct sockaddr*)&client_addr, &addr_len);
+        int client_fd = accept(listen_fd, (struct sockaddr*)&client_addr, &addr_len);
         if (client_fd < 0) {
             if (errno == EINTR || errno == EAGAIN) continue;
             break;
         }
         
+        /* The callback may be installed after the thread starts */
+        pthread_mutex_lock(&listener->lock);
+        int running = listener->running;
+        void (*accept_cb)(remoteio_connection_t*, void*) = listener->accept_cb;
+        void* accept_user_data = listener->accept_user_data;
+        pthread_mutex_unlock(&listener->lock);
+        
+        if (!running) {
+            close(client_fd);
+            break;
+        }
+        
         /* Set socket options for client */
-        set_socket_options(client_fd);
+        bool local = client_addr.ss_family == AF_UNIX;
+        if (!local) set_socket_options(client_fd);
         
         /* Create connection object */
         remoteio_connection_t* conn = calloc(1, sizeof(remoteio_connection_t));
@@ -304,13 +672,17 @@ static void* listener_thread(void* arg) {
             conn->socket_fd = client_fd;
             conn->state = REMOTEIO_CONN_CONNECTED;
             conn->transport = REMOTEIO_TRANSPORT_TCP;
-            inet_ntop(AF_INET, &client_addr.sin_addr, conn->peer_addr, 
-                     INET_ADDRSTRLEN);
-            conn->peer_port = ntohs(client_addr.sin_port);
+            if (local) {
+                strncpy(conn->peer_addr, listener->path, sizeof(conn->peer_addr) - 1);
+            } else {
+                struct sockaddr_in* sin = (struct sockaddr_in*)&client_addr;
+                inet_ntop(AF_INET, &sin->sin_addr, conn->peer_addr, INET_ADDRSTRLEN);
+                conn->peer_port = ntohs(sin->sin_port);
+            }
             conn->ref_count = 1;
             
-            if (listener->accept_cb) {
-                listener->accept_cb(conn, listener->accept_user_data);
+            if (accept_cb) {
+                accept_cb(conn, accept_user_data);
             }
             
             remoteio_conn_release(conn);
@@ -364,6 +736,12 @@ int remoteio_network_listen(remoteio_context_t* ctx, int port,
         return -1;
     }
     
+    /* Port 0 binds an ephemeral port; report the one we got */
+    socklen_t sin_len = sizeof(sin);
+    if (port == 0 && getsockname(fd, (struct sockaddr*)&sin, &sin_len) == 0) {
+        port = ntohs(sin.sin_port);
+    }
+    
     listener->socket_fd = fd;
     listener->port = port;
     listener->running = 1;
@@ -376,18 +754,76 @@ int remoteio_network_listen(remoteio_context_t* ctx, int port,
     return 0;
 }
 
+/* Listen on a Unix socket; a stale socket file at path is replaced. An
+ * '@' name is abstract and leaves no file. */
+int remoteio_network_listen_unix(remoteio_context_t* ctx, const char* path,
+                                 remoteio_listener_t** listener_out) {
+    if (!ctx || !path || !listener_out) return -1;
+    
+    struct sockaddr_un sun;
+    bool abstract = path[0] == '@';
+    if ((path[0] != '/' && !abstract) || unix_sockaddr(path, &sun) != 0) return -1;
+    
+    remoteio_listener_t* listener = calloc(1, sizeof(remoteio_listener_t));
+    if (!listener) return -1;
+    listener->path = strdup(path);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (!listener->path || fd < 0) {
+        if (fd >= 0) close(fd);
+        free(listener->path);
+        free(listener);
+        return -1;
+    }
+    
+    if (!abstract) unlink(path);
+    if (bind(fd, (struct sockaddr*)&sun, sizeof(sun)) < 0 ||
+        listen(fd, NETWORK_MAX_BACKLOG) < 0) {
+        close(fd);
+        free(listener->path);
+        free(listener);
+        return -1;
+    }
+    
+    pthread_mutex_init(&listener->lock, NULL);
+    listener->socket_fd = fd;
+    listener->running = 1;
+    listener->transport = REMOTEIO_TRANSPORT_TCP;
+    
+    if (pthread_create(&listener->thread, NULL, listener_thread, listener) != 0) {
+        close(fd);
+        if (!abstract) unlink(path);
+        pthread_mutex_destroy(&listener->lock);
+        free(listener->path);
+        free(listener);
+        return -1;
+    }
+    
+    *listener_out = listener;
+    return 0;
+}
+
 int remoteio_network_stop_listen(remoteio_listener_t* listener) {
     if (!listener) return -1;
     
+    /* shutdown() wakes a blocked accept(); close() alone does not */
     pthread_mutex_lock(&listener->lock);
     listener->running = 0;
     if (listener->socket_fd >= 0) {
-        close(listener->socket_fd);
-        listener->socket_fd = -1;
+        shutdown(listener->socket_fd, SHUT_RDWR);
     }
     pthread_mutex_unlock(&listener->lock);
     
     pthread_join(listener->thread, NULL);
+    
+    if (listener->socket_fd >= 0) {
+        close(listener->socket_fd);
+        listener->socket_fd = -1;
+    }
+    if (listener->path) {
+        if (listener->path[0] != '@') unlink(listener->path);
+        free(listener->path);
+    }
     pthread_mutex_destroy(&listener->lock);
     free(listener);
     
@@ -408,7 +844,7 @@ int remoteio_conn_create(remoteio_context_t* ctx, const char* addr, uint16_t por
     conn->socket_fd = -1;
     conn->state = REMOTEIO_CONN_DISCONNECTED;
     conn->ref_count = 1;
-    strncpy(conn->peer_addr, addr, INET_ADDRSTRLEN - 1);
+    strncpy(conn->peer_addr, addr, sizeof(conn->peer_addr) - 1);
     conn->peer_port = port;
     
     *conn_out = conn;
@@ -418,6 +854,12 @@ int remoteio_conn_create(remoteio_context_t* ctx, const char* addr, uint16_t por
 int remoteio_conn_destroy(remoteio_connection_t* conn) {
     if (!conn) return -1;
     
+    /* Stop the reactor servicing it before the socket goes away */
+    if (conn->reactor) {
+        remoteio_reactor_remove(conn->reactor, conn);
+    }
+    remoteio_proto_detach(conn);
+    
     pthread_mutex_lock(&conn->lock);
     
     if (conn->state == REMOTEIO_CONN_CONNECTED) {
@@ -426,6 +868,7 @@ int remoteio_conn_destroy(remoteio_connection_t* conn) {
         pthread_mutex_lock(&conn->lock);
     }
     
+    remoteio_shm_close(conn);
     if (conn->socket_fd >= 0) {
         close(conn->socket_fd);
         conn->socket_fd = -1;
@@ -435,6 +878,7 @@ int remoteio_conn_destroy(remoteio_connection_t* conn) {
     pthread_mutex_destroy(&conn->lock);
     pthread_cond_destroy(&conn->state_cond);
     
+    free(conn->zc_done);
     free(conn);
     return 0;
 }
@@ -461,12 +905,181 @@ int remoteio_conn_release(remoteio_connection_t* conn) {
     return 0;
 }
 
-int remoteio_conn_pool_init(remoteio_conn_pool_t* pool, int max_conns) {
+static uint64_t pool_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/* FNV-1a over host and port */
+static int pool_bucket(const char* addr, uint16_t port) {
+    uint32_t h = 2166136261u;
+    for (const char* p = addr; *p; p++) {
+        h ^= (uint8_t)*p;
+        h *= 16777619u;
+    }
+    h ^= port;
+    h *= 16777619u;
+    return (int)(h % REMOTEIO_POOL_BUCKETS);
+}
+
+/* Called with pool lock held */
+static void pool_unlink(remoteio_conn_pool_t* pool, remoteio_connection_t* conn) {
+    remoteio_connection_t** cur = &pool->buckets[pool_bucket(conn->peer_addr, conn->peer_port)];
+    while (*cur) {
+        if (*cur == conn) {
+            *cur = conn->next;
+            conn->next = NULL;
+            conn->pooled = false;
+            pool->num_connections--;
+            return;
+        }
+        cur = &(*cur)->next;
+    }
+}
+
+/* Does conn serve ops wanting transport? A soft RDMA connection is the
+ * framed stream too; AUTO takes any. */
+static bool pool_match(remoteio_connection_t* conn, const char* addr, uint16_t port,
+                       int stream, remoteio_transport_t transport) {
+    return conn->peer_port == port && conn->stream == stream &&
+           (transport == REMOTEIO_TRANSPORT_AUTO || conn->transport == transport ||
+            (transport == REMOTEIO_TRANSPORT_TCP &&
+             conn->transport == REMOTEIO_TRANSPORT_SOFT_RDMA)) &&
+           strcmp(conn->peer_addr, addr) == 0;
+}
+
+static bool pool_conn_live(remoteio_connection_t* conn) {
+    pthread_mutex_lock(&conn->lock);
+    bool live = conn->state == REMOTEIO_CONN_CONNECTED;
+    pthread_mutex_unlock(&conn->lock);
+    return live;
+}
+
+/* Mark a connection dead so its users fail fast and the pool drops it */
+static void pool_fail_conn(remoteio_connection_t* conn) {
+    pthread_mutex_lock(&conn->lock);
+    if (conn->state == REMOTEIO_CONN_CONNECTED) {
+        conn->state = REMOTEIO_CONN_ERROR;
+    }
+    if (conn->socket_fd >= 0) {
+        shutdown(conn->socket_fd, SHUT_RDWR);
+    }
+    pthread_cond_broadcast(&conn->state_cond);
+    pthread_mutex_unlock(&conn->lock);
+}
+
+/* Maintenance: close idle and broken connections, ping quiet ones */
+static void* pool_thread(void* arg) {
+    remoteio_conn_pool_t* pool = (remoteio_conn_pool_t*)arg;
+    
+    pthread_mutex_lock(&pool->lock);
+    
+    while (!pool->stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += REMOTEIO_POOL_SWEEP_US / 1000000;
+        deadline.tv_nsec += (REMOTEIO_POOL_SWEEP_US % 1000000) * 1000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&pool->cond, &pool->lock, &deadline);
+        if (pool->stopping) break;
+        
+        uint64_t now = pool_now_us();
+        remoteio_connection_t* closed = NULL;
+        remoteio_connection_t* check[REMOTEIO_POOL_BUCKETS];
+        int num_check = 0;
+        
+        for (int b = 0; b < REMOTEIO_POOL_BUCKETS; b++) {
+            remoteio_connection_t* conn = pool->buckets[b];
+            while (conn) {
+                remoteio_connection_t* next = conn->next;
+                
+                pthread_mutex_lock(&conn->lock);
+                bool broken = conn->state != REMOTEIO_CONN_CONNECTED;
+                bool in_use = conn->ref_count > 1;
+                pthread_mutex_unlock(&conn->lock);
+                
+                uint64_t quiet = now - conn->last_used_us;
+                if (broken || (!in_use && quiet > pool->idle_timeout_us)) {
+                    pool_unlink(pool, conn);
+                    conn->next = closed;
+                    closed = conn;
+                    if (!broken) pool->idle_closed++;
+                } else if (quiet > pool->health_interval_us && conn->proto &&
+                           num_check < REMOTEIO_POOL_BUCKETS) {
+                    remoteio_conn_acquire(conn);
+                    conn->last_used_us = now;
+                    check[num_check++] = conn;
+                }
+                conn = next;
+            }
+        }
+        
+        pthread_mutex_unlock(&pool->lock);
+        
+        /* Drop the pool's references; users keep theirs */
+        while (closed) {
+            remoteio_connection_t* next = closed->next;
+            closed->next = NULL;
+            remoteio_conn_release(closed);
+            closed = next;
+        }
+        
+        for (int i = 0; i < num_check; i++) {
+            remoteio_connection_t* conn = check[i];
+            int ok = remoteio_proto_ping(pool->ctx, conn, REMOTEIO_POOL_PING_US) == 0;
+            bool evicted = false;
+            
+            if (!ok) {
+                pool_fail_conn(conn);
+            }
+            
+            pthread_mutex_lock(&pool->lock);
+            pool->health_checks++;
+            if (!ok) {
+                pool->health_failures++;
+                if (conn->pooled) {
+                    pool_unlink(pool, conn);
+                    evicted = true;
+                }
+            }
+            pthread_mutex_unlock(&pool->lock);
+            
+            if (evicted) remoteio_conn_release(conn);
+            remoteio_conn_release(conn);
+        }
+        
+        /* Routes due for a probe connect through the pool */
+        if (pool->ctx) remoteio_route_sweep(pool->ctx);
+        
+        pthread_mutex_lock(&pool->lock);
+    }
+    
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+int remoteio_conn_pool_init(remoteio_conn_pool_t* pool, remoteio_context_t* ctx,
+                            int max_conns) {
     if (!pool) return -1;
     
     memset(pool, 0, sizeof(*pool));
+    pool->ctx = ctx;
     pool->max_connections = max_conns;
+    pool->idle_timeout_us = REMOTEIO_POOL_IDLE_US;
+    pool->health_interval_us = REMOTEIO_POOL_HEALTH_US;
     pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    
+    if (pthread_create(&pool->thread, NULL, pool_thread, pool) != 0) {
+        pthread_mutex_destroy(&pool->lock);
+        pthread_cond_destroy(&pool->cond);
+        return -1;
+    }
+    pool->running = true;
     
     return 0;
 }
@@ -474,177 +1087,676 @@ int remoteio_conn_pool_init(remoteio_conn_pool_t* pool, int max_conns) {
 void remoteio_conn_pool_cleanup(remoteio_conn_pool_t* pool) {
     if (!pool) return;
     
+    if (pool->running) {
+        pthread_mutex_lock(&pool->lock);
+        pool->stopping = true;
+        pthread_cond_broadcast(&pool->cond);
+        pthread_mutex_unlock(&pool->lock);
+        pthread_join(pool->thread, NULL);
+        pool->running = false;
+    }
+    
     pthread_mutex_lock(&pool->lock);
+    remoteio_connection_t* closed = NULL;
+    for (int b = 0; b < REMOTEIO_POOL_BUCKETS; b++) {
+        while (pool->buckets[b]) {
+            remoteio_connection_t* conn = pool->buckets[b];
+            pool_unlink(pool, conn);
+            conn->next = closed;
+            closed = conn;
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
     
-    remoteio_connection_t* conn = pool->connections;
-    while (conn) {
-        remoteio_connection_t* next = conn->next;
-        remoteio_conn_release(conn);
-        conn = next;
+    while (closed) {
+        remoteio_connection_t* next = closed->next;
+        closed->next = NULL;
+        remoteio_conn_release(closed);
+        closed = next;
+    }
+    
+    for (int b = 0; b < REMOTEIO_POOL_BUCKETS; b++) {
+        while (pool->stripe_peers[b]) {
+            remoteio_stripe_peer_t* next = pool->stripe_peers[b]->next;
+            free(pool->stripe_peers[b]);
+            pool->stripe_peers[b] = next;
+        }
     }
-    pool->connections = NULL;
-    pool->num_connections = 0;
     
-    pthread_mutex_unlock(&pool->lock);
     pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->cond);
 }
 
+/* Look up a live connection to addr:port for the given stream and
+ * transport; returns it with a reference held */
 remoteio_connection_t* remoteio_conn_pool_get(remoteio_conn_pool_t* pool,
-                                               const char* addr, uint16_t port) {
+                                               const char* addr, uint16_t port, int stream,
+                                               remoteio_transport_t transport) {
     if (!pool || !addr) return NULL;
     
     pthread_mutex_lock(&pool->lock);
     
-    /* Search for existing connection */
-    remoteio_connection_t* conn = pool->connections;
+    remoteio_connection_t* conn = pool->buckets[pool_bucket(addr, port)];
     while (conn) {
-        if (strcmp(conn->peer_addr, addr) == 0 && conn->peer_port == port) {
-            if (conn->state == REMOTEIO_CONN_CONNECTED) {
-                remoteio_conn_acquire(conn);
-                pthread_mutex_unlock(&pool->lock);
-                return conn;
-            }
+        if (pool_match(conn, addr, port, stream, transport) && pool_conn_live(conn)) {
+            remoteio_conn_acquire(conn);
+            conn->last_used_us = pool_now_us();
+            pool->hits++;
+            pthread_mutex_unlock(&pool->lock);
+            return conn;
         }
         conn = conn->next;
     }
     
+    pool->misses++;
     pthread_mutex_unlock(&pool->lock);
     return NULL;
 }
 
-int remoteio_conn_pool_put(remoteio_conn_pool_t* pool, remoteio_connection_t* conn) {
+/* Share a new connection; the pool takes a reference of its own. Fails if
+ * the pool is full or already has a connection to that peer and stream
+ * over the same transport. */
+int remoteio_conn_pool_add(remoteio_conn_pool_t* pool, remoteio_connection_t* conn) {
     if (!pool || !conn) return -1;
     
     pthread_mutex_lock(&pool->lock);
     
-    /* Check if already in pool */
-    remoteio_connection_t* existing = pool->connections;
-    while (existing) {
-        if (existing == conn) {
+    if (conn->pooled || pool->num_connections >= pool->max_connections) {
+        pthread_mutex_unlock(&pool->lock);
+        return -1;
+    }
+    
+    int b = pool_bucket(conn->peer_addr, conn->peer_port);
+    for (remoteio_connection_t* e = pool->buckets[b]; e; e = e->next) {
+        if (pool_match(e, conn->peer_addr, conn->peer_port, conn->stream, conn->transport) &&
+            pool_conn_live(e)) {
             pthread_mutex_unlock(&pool->lock);
-            return 0;
+            return -1;
         }
-        existing = existing->next;
     }
     
-    /* Add to pool if not full */
-    if (pool->num_connections < pool->max_connections) {
-        conn->next = pool->connections;
-        pool->connections = conn;
-        pool->num_connections++;
+    remoteio_conn_acquire(conn);
+    conn->pooled = true;
+    conn->last_used_us = pool_now_us();
+    conn->next = pool->buckets[b];
+    pool->buckets[b] = conn;
+    pool->num_connections++;
+    
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+/* Return a caller's reference; the connection stays open if pooled */
+int remoteio_conn_pool_put(remoteio_conn_pool_t* pool, remoteio_connection_t* conn) {
+    if (!pool || !conn) return -1;
+    
+    pthread_mutex_lock(&pool->lock);
+    conn->last_used_us = pool_now_us();
+    pthread_mutex_unlock(&pool->lock);
+    
+    return remoteio_conn_release(conn);
+}
+
+/* Striping */
+
+/* Called with pool lock held */
+static remoteio_stripe_peer_t* stripe_peer(remoteio_conn_pool_t* pool, const char* addr,
+                                           uint16_t port, bool create) {
+    int b = pool_bucket(addr, port);
+    for (remoteio_stripe_peer_t* peer = pool->stripe_peers[b]; peer; peer = peer->next) {
+        if (peer->port == port && strcmp(peer->addr, addr) == 0) return peer;
+    }
+    if (!create) return NULL;
+    
+    remoteio_stripe_peer_t* peer = calloc(1, sizeof(*peer));
+    if (!peer) return NULL;
+    
+    snprintf(peer->addr, sizeof(peer->addr), "%s", addr);
+    peer->port = port;
+    peer->streams = 1;
+    peer->direction = 1;
+    peer->next = pool->stripe_peers[b];
+    pool->stripe_peers[b] = peer;
+    return peer;
+}
+
+static int stripe_max_streams(remoteio_conn_pool_t* pool) {
+    int max = pool->max_connections;
+    if (max > REMOTEIO_STRIPE_MAX_STREAMS) max = REMOTEIO_STRIPE_MAX_STREAMS;
+    return max < 1 ? 1 : max;
+}
+
+/* Move a peer one stream in its probe direction, turning at a bound if
+ * allowed; settles for REMOTEIO_STRIPE_PROBE_EVERY transfers otherwise */
+static void stripe_probe(remoteio_conn_pool_t* pool, remoteio_stripe_peer_t* peer,
+                         bool may_turn) {
+    int next = peer->streams + peer->direction;
+    if (may_turn && (next < 1 || next > stripe_max_streams(pool))) {
+        peer->direction = -peer->direction;
+        next = peer->streams + peer->direction;
+    }
+    
+    if (next < 1 || next > stripe_max_streams(pool)) {
+        peer->hold = REMOTEIO_STRIPE_PROBE_EVERY;
+        return;
+    }
+    
+    peer->probe_from = peer->streams;
+    peer->streams = next;
+    pool->stripe_probes++;
+}
+
+/* Number of streams the next large transfer to addr:port should use */
+int remoteio_conn_pool_stripe_width(remoteio_conn_pool_t* pool, const char* addr,
+                                    uint16_t port) {
+    if (!pool || !addr) return 1;
+    
+    pthread_mutex_lock(&pool->lock);
+    remoteio_stripe_peer_t* peer = stripe_peer(pool, addr, port, true);
+    int streams = peer ? peer->streams : 1;
+    pthread_mutex_unlock(&pool->lock);
+    
+    return streams;
+}
+
+/*
+ * Feed back a finished striped transfer that asked for wanted streams and
+ * got used. A probe is judged against the throughput of the count it left:
+ * widening must gain REMOTEIO_STRIPE_GAIN_PCT, narrowing may lose no more
+ * than that. Otherwise the peer reverts and the next probe goes the other
+ * way.
+ */
+void remoteio_conn_pool_stripe_update(remoteio_conn_pool_t* pool, const char* addr,
+                                      uint16_t port, int wanted, int used,
+                                      uint64_t bytes, uint64_t elapsed_us) {
+    if (!pool || !addr || used < 1) return;
+    
+    uint64_t bps = bytes * 1000000ULL / (elapsed_us ? elapsed_us : 1);
+    
+    pthread_mutex_lock(&pool->lock);
+    
+    remoteio_stripe_peer_t* peer = stripe_peer(pool, addr, port, false);
+    if (!peer) {
         pthread_mutex_unlock(&pool->lock);
-        return 0;
+        return;
+    }
+    
+    peer->transfers++;
+    if (used > 1) pool->striped_transfers++;
+    
+    if (used < wanted) {
+        /* Ran out of connections; don't ask for more than the pool gave */
+        if (peer->streams > used) peer->streams = used;
+        peer->probe_from = 0;
+        peer->direction = -1;
+        peer->hold = REMOTEIO_STRIPE_PROBE_EVERY;
+    } else if (wanted != peer->streams) {
+        /* Started before the last change; says nothing about it */
+    } else if (peer->probe_from) {
+        bool kept = peer->direction > 0 ?
+            bps * 100 > peer->bps * (100 + REMOTEIO_STRIPE_GAIN_PCT) :
+            bps * 100 >= peer->bps * (100 - REMOTEIO_STRIPE_GAIN_PCT);
+        
+        int from = peer->probe_from;
+        peer->probe_from = 0;
+        if (kept) {
+            /* Keep going the same way */
+            peer->bps = bps;
+            stripe_probe(pool, peer, false);
+        } else {
+            peer->streams = from;
+            peer->direction = -peer->direction;
+            peer->hold = REMOTEIO_STRIPE_PROBE_EVERY;
+        }
+    } else {
+        peer->bps = peer->bps ? (peer->bps * 3 + bps) / 4 : bps;
+        if (peer->hold > 0) peer->hold--;
+        if (peer->hold == 0) stripe_probe(pool, peer, true);
     }
     
     pthread_mutex_unlock(&pool->lock);
-    return -1; /* Pool full */
 }
 
 /* Operation management */
 
+/*
+ * Ops come from a slab preallocated at context creation. Free slab ops sit
+ * on a lock-free stack (ctx->op_free_head, an ABA-tagged index) and in a
+ * small per-thread cache in front of it, so alloc and free touch neither a
+ * lock nor a list walk. Threads move ops between their cache and the stack
+ * in batches. Ops beyond the slab fall back to the heap.
+ *
+ * A thread keeps one cache per context it uses, up to OP_CACHE_CONTEXTS,
+ * so one that is both a server and a client (collectives are) doesn't
+ * flush through the registry lock each time it switches.
+ */
+#define OP_CACHE_SIZE       32
+#define OP_CACHE_BATCH      16
+#define OP_CACHE_CONTEXTS   4
+#define OP_NONE             0u
+
+typedef struct op_cache {
+    remoteio_context_t* ctx;
+    uint64_t ctx_id;
+    uint32_t ops[OP_CACHE_SIZE];         /* Slab index + 1 */
+    int count;
+    uint64_t last_use;                   /* 0 while unused */
+} op_cache_t;
+
+typedef struct op_thread_caches {
+    op_cache_t caches[OP_CACHE_CONTEXTS];
+    uint64_t clock;
+    bool registered;
+} op_thread_caches_t;
+
+static __thread op_thread_caches_t op_caches;
+static pthread_key_t op_cache_key;
+static pthread_once_t op_cache_once = PTHREAD_ONCE_INIT;
+
+/* Live contexts, so a cache never flushes into a destroyed one */
+static pthread_mutex_t op_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static remoteio_context_t* op_registry;
+static uint64_t op_registry_next_id = 1;
+
+/* Push a chain of slab ops, linked through op_links, onto the free stack */
+static void op_stack_push(remoteio_context_t* ctx, uint32_t first, uint32_t last) {
+    uint64_t head = __atomic_load_n(&ctx->op_free_head, __ATOMIC_RELAXED);
+    uint64_t next;
+    do {
+        __atomic_store_n(&ctx->op_links[last - 1], (uint32_t)head, __ATOMIC_RELAXED);
+        next = ((head >> 32) + 1) << 32 | first;
+    } while (!__atomic_compare_exchange_n(&ctx->op_free_head, &head, next, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static uint32_t op_stack_pop(remoteio_context_t* ctx) {
+    uint64_t head = __atomic_load_n(&ctx->op_free_head, __ATOMIC_ACQUIRE);
+    uint64_t next;
+    do {
+        uint32_t top = (uint32_t)head;
+        if (top == OP_NONE) return OP_NONE;
+        /* The tag makes a stale link fail the exchange below */
+        next = ((head >> 32) + 1) << 32 |
+               __atomic_load_n(&ctx->op_links[top - 1], __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&ctx->op_free_head, &head, next, true,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+    return (uint32_t)head;
+}
+
+/* Return count cached ops from the top of the cache to the stack */
+static void op_cache_spill(op_cache_t* cache, int count) {
+    remoteio_context_t* ctx = cache->ctx;
+    uint32_t first = cache->ops[cache->count - 1];
+    uint32_t last = cache->ops[cache->count - count];
+    
+    for (int i = cache->count - 1; i > cache->count - count; i--) {
+        __atomic_store_n(&ctx->op_links[cache->ops[i] - 1], cache->ops[i - 1],
+                         __ATOMIC_RELAXED);
+    }
+    op_stack_push(ctx, first, last);
+    cache->count -= count;
+}
+
+/* Cold path: empty a cache whose context may be gone */
+static void op_cache_flush(op_cache_t* cache) {
+    pthread_mutex_lock(&op_registry_lock);
+    for (remoteio_context_t* c = op_registry; c; c = c->next_live) {
+        if (c == cache->ctx && c->op_cache_id == cache->ctx_id) {
+            if (cache->count > 0) op_cache_spill(cache, cache->count);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&op_registry_lock);
+    
+    cache->count = 0;
+    cache->ctx = NULL;
+    cache->last_use = 0;
+}
+
+static void op_cache_thread_exit(void* arg) {
+    op_thread_caches_t* caches = (op_thread_caches_t*)arg;
+    
+    for (int i = 0; i < OP_CACHE_CONTEXTS; i++) {
+        if (caches->caches[i].ctx) op_cache_flush(&caches->caches[i]);
+    }
+}
+
+static void op_cache_key_init(void) {
+    pthread_key_create(&op_cache_key, op_cache_thread_exit);
+}
+
+static op_cache_t* op_cache_get(remoteio_context_t* ctx) {
+    op_thread_caches_t* caches = &op_caches;
+    op_cache_t* victim = &caches->caches[0];
+    
+    caches->clock++;
+    for (int i = 0; i < OP_CACHE_CONTEXTS; i++) {
+        op_cache_t* cache = &caches->caches[i];
+        if (cache->ctx == ctx && cache->ctx_id == ctx->op_cache_id) {
+            cache->last_use = caches->clock;
+            return cache;
+        }
+        if (cache->last_use < victim->last_use) victim = cache;
+    }
+    
+    /* A context this thread hasn't used lately takes the oldest cache */
+    if (victim->ctx) op_cache_flush(victim);
+    if (!caches->registered) {
+        /* The key's destructor returns the caches when the thread exits */
+        pthread_once(&op_cache_once, op_cache_key_init);
+        pthread_setspecific(op_cache_key, caches);
+        caches->registered = true;
+    }
+    victim->ctx = ctx;
+    victim->ctx_id = ctx->op_cache_id;
+    victim->last_use = caches->clock;
+    return victim;
+}
+
+int remoteio_op_slab_init(remoteio_context_t* ctx, uint32_t max_ops) {
+    if (!ctx || max_ops == 0) return -1;
+    
+    ctx->op_slab = calloc(max_ops, sizeof(remoteio_operation_t));
+    ctx->op_links = calloc(max_ops, sizeof(uint32_t));
+    if (!ctx->op_slab || !ctx->op_links) {
+        free(ctx->op_slab);
+        free(ctx->op_links);
+        ctx->op_slab = NULL;
+        ctx->op_links = NULL;
+        return -1;
+    }
+    
+    ctx->op_slab_size = max_ops;
+    for (uint32_t i = 0; i + 1 < max_ops; i++) {
+        ctx->op_links[i] = i + 2;
+    }
+    ctx->op_links[max_ops - 1] = OP_NONE;
+    ctx->op_free_head = 1;
+    
+    pthread_mutex_lock(&op_registry_lock);
+    ctx->op_cache_id = op_registry_next_id++;
+    ctx->next_live = op_registry;
+    op_registry = ctx;
+    pthread_mutex_unlock(&op_registry_lock);
+    
+    return 0;
+}
+
+/* Ops still cached by other threads are dropped with the slab */
+void remoteio_op_slab_cleanup(remoteio_context_t* ctx) {
+    if (!ctx || !ctx->op_slab) return;
+    
+    pthread_mutex_lock(&op_registry_lock);
+    remoteio_context_t** cur = &op_registry;
+    while (*cur && *cur != ctx) cur = &(*cur)->next_live;
+    if (*cur) *cur = ctx->next_live;
+    pthread_mutex_unlock(&op_registry_lock);
+    
+    for (int i = 0; i < OP_CACHE_CONTEXTS; i++) {
+        op_cache_t* cache = &op_caches.caches[i];
+        if (cache->ctx == ctx) {
+            cache->ctx = NULL;
+            cache->count = 0;
+            cache->last_use = 0;
+        }
+    }
+    
+    free(ctx->op_slab);
+    free(ctx->op_links);
+    ctx->op_slab = NULL;
+    ctx->op_links = NULL;
+    ctx->op_slab_size = 0;
+}
+
 remoteio_operation_t* remoteio_op_alloc(remoteio_context_t* ctx) {
     if (!ctx) return NULL;
     
-    pthread_mutex_lock(&ctx->ops_lock);
+    remoteio_operation_t* op = NULL;
     
-    /* Try to reuse from free list */
-    if (ctx->free_ops) {
-        remoteio_operation_t* op = ctx->free_ops;
-        ctx->free_ops = op->next;
-        memset(op, 0, sizeof(*op));
-        op->id = ctx->next_op_id++;
-        pthread_mutex_unlock(&ctx->ops_lock);
-        return op;
+    if (ctx->op_slab) {
+        op_cache_t* cache = op_cache_get(ctx);
+        
+        /* Refill from the shared stack */
+        while (cache->count < OP_CACHE_BATCH) {
+            uint32_t idx = op_stack_pop(ctx);
+            if (idx == OP_NONE) break;
+            cache->ops[cache->count++] = idx;
+        }
+        
+        if (cache->count > 0) {
+            op = &ctx->op_slab[cache->ops[--cache->count] - 1];
+            memset(op, 0, sizeof(*op));
+        }
     }
     
-    pthread_mutex_unlock(&ctx->ops_lock);
-    
-    /* Allocate new operation */
-    remoteio_operation_t* op = calloc(1, sizeof(remoteio_operation_t));
-    if (op) {
-        pthread_mutex_lock(&ctx->ops_lock);
-        op->id = ctx->next_op_id++;
-        pthread_mutex_unlock(&ctx->ops_lock);
+    if (!op) {
+        /* More outstanding ops than the slab holds */
+        op = calloc(1, sizeof(remoteio_operation_t));
+        if (!op) return NULL;
+        __atomic_fetch_add(&ctx->op_heap_allocs, 1, __ATOMIC_RELAXED);
     }
     
+    pthread_cond_init(&op->done_cond, NULL);
+    op->id = __atomic_fetch_add(&ctx->next_op_id, 1, __ATOMIC_RELAXED);
     return op;
 }
 
+/* Wait out a completion another thread claimed, e.g. the reactor failing
+ * every op of a broken stream, which still touches the op */
+static void op_settle(remoteio_operation_t* op) {
+    pthread_mutex_lock(&op->conn->lock);
+    while (op->claimed && !op->completed) {
+        pthread_cond_wait(&op->done_cond, &op->conn->lock);
+    }
+    pthread_mutex_unlock(&op->conn->lock);
+}
+
 void remoteio_op_free(remoteio_context_t* ctx, remoteio_operation_t* op) {
     if (!ctx || !op) return;
     
-    pthread_mutex_lock(&ctx->ops_lock);
-    
-    /* Add to free list (limit size) */
-    int free_count = 0;
-    remoteio_operation_t* temp = ctx->free_ops;
-    while (temp) {
-        free_count++;
-        temp = temp->next;
+    /* A timed-out op may still be awaiting its response */
+    if (op->conn && op->conn->proto && remoteio_proto_cancel(op->conn, op) != 0) {
+        op_settle(op);
     }
+    pthread_cond_destroy(&op->done_cond);
     
-    if (free_count < 100) {
-        op->next = ctx->free_ops;
-        ctx->free_ops = op;
-        pthread_mutex_unlock(&ctx->ops_lock);
-    } else {
-        pthread_mutex_unlock(&ctx->ops_lock);
+    if (op < ctx->op_slab || op >= ctx->op_slab + ctx->op_slab_size) {
         free(op);
+        return;
     }
+    
+    op_cache_t* cache = op_cache_get(ctx);
+    if (cache->count == OP_CACHE_SIZE) {
+        op_cache_spill(cache, OP_CACHE_BATCH);
+    }
+    cache->ops[cache->count++] = (uint32_t)(op - ctx->op_slab) + 1;
 }
 
 int remoteio_op_submit(remoteio_context_t* ctx, remoteio_operation_t* op) {
     if (!ctx || !op || !op->conn) return -1;
     
-    pthread_mutex_lock(&ctx->ops_lock);
-    
-    /* Add to pending list */
-    op->next = ctx->pending_ops;
-    ctx->pending_ops = op;
-    
-    ctx->requests_submitted++;
-    pthread_cond_broadcast(&ctx->ops_cond);
-    pthread_mutex_unlock(&ctx->ops_lock);
+    __atomic_fetch_add(&ctx->requests_submitted, 1, __ATOMIC_RELAXED);
     
     /* Execute based on transport */
     int ret = -1;
-    
-    if (op->conn->transport == REMOTEIO_TRANSPORT_RDMA && op->conn->rdma_ep) {
+    remoteio_transport_t transport = op->conn->transport;
+    
+    /* Soft RDMA connections still carry named (two-sided) requests, and so
+     * do shared-memory ones, whose one-sided ops are soft too */
+    bool soft = transport == REMOTEIO_TRANSPORT_SOFT_RDMA ||
+                transport == REMOTEIO_TRANSPORT_SHM;
+    if ((transport == REMOTEIO_TRANSPORT_RDMA && op->conn->rdma_ep) ||
+        (soft && op->op != REMOTEIO_OP_PING && op->resource[0] == '\0')) {
+        /* One-sided: remote_offset is relative to remote_mem when given,
+         * else a raw peer address that no rkey covers */
+        remoteio_remote_mem_t remote = {
+            .raddr = 0,
+            .rkey = 0,
+            .length = op->remote_offset + op->length,
+        };
+        if (op->remote_mem) remote = *op->remote_mem;
+        
         switch (op->op) {
             case REMOTEIO_OP_READ:
                 if (op->local_gdr) {
-                    remoteio_remote_mem_t remote = {
-                        .raddr = op->remote_offset,
-                        .rkey = 0, /* TODO: Exchange with remote */
-                        .length = op->length
-                    };
-                    ret = remoteio_rdma_post_read(op->conn, op->local_gdr, &remote,
-                                                  op->local_offset, 0, op->length, op);
+                    ret = soft ? remoteio_soft_rdma_post_read(op->conn, op->local_gdr, &remote,
+                                                              op->local_offset, op->remote_offset,
+                                                              op->length, op)
+                               : remoteio_rdma_post_read(op->conn, op->local_gdr, &remote,
+                                                         op->local_offset, op->remote_offset,
+                                                         op->length, op);
                 }
                 break;
             case REMOTEIO_OP_WRITE:
                 if (op->local_gdr) {
-                    remoteio_remote_mem_t remote = {
-                        .raddr = op->remote_offset,
-                        .rkey = 0,
-                        .length = op->length
-                    };
-                    ret = remoteio_rdma_post_write(op->conn, op->local_gdr, &remote,
-                                                   op->local_offset, 0, op->length, op);
+                    ret = soft ? remoteio_soft_rdma_post_write(op->conn, op->local_gdr, &remote,
+                                                               op->local_offset, op->remote_offset,
+                                                               op->length, op)
+                               : remoteio_rdma_post_write(op->conn, op->local_gdr, &remote,
+                                                          op->local_offset, op->remote_offset,
+                                                          op->length, op);
                 }
                 break;
             default:
                 break;
         }
-    } else {
-        /* TCP fallback - implement simple protocol */
-        /* TODO: Implement TCP-based remote IO protocol */
-        ret = -1;
+    } else if (op->conn->proto) {
+        /* Framed TCP protocol; the reactor completes it */
+        ret = remoteio_proto_submit(op->conn, op);
+    }
+    
+    return ret;
+}
+
+/* Does [offset, offset + len) lie within mr? */
+static bool chain_in_region(const remoteio_gdr_region_t* mr, uint64_t offset, uint64_t len) {
+    return mr && mr->gpu_ptr && offset <= mr->length && len <= mr->length - offset;
+}
+
+/**
+ * Check a chain of one-sided ops (linked by next_sg, all on one connection
+ * and with a remote_mem) and lay out its signalling: every signal_every-th
+ * op and the last are signalled, each batch ending at one. Sets each op's
+ * length to the sum of its pieces. Returns the number of ops, or -1.
+ */
+int remoteio_op_chain_prepare(remoteio_operation_t* chain, int signal_every) {
+    if (!chain || !chain->conn) return -1;
+    if (signal_every < 1) signal_every = 1;
+    
+    int count = 0;
+    for (remoteio_operation_t* op = chain; op; op = op->next_sg) {
+        if (++count > REMOTEIO_CHAIN_MAX_WR || op->conn != chain->conn || !op->remote_mem) {
+            return -1;
+        }
+        if (op->op != REMOTEIO_OP_READ && op->op != REMOTEIO_OP_WRITE) return -1;
+        if (op->num_sge < 0 || op->num_sge > REMOTEIO_CHAIN_MAX_SGE) return -1;
+        
+        if (op->num_sge == 0) {
+            if (!chain_in_region(op->local_gdr, op->local_offset, op->length)) return -1;
+        } else {
+            op->length = 0;
+            for (int i = 0; i < op->num_sge; i++) {
+                const remoteio_sge_t* sge = &op->sge[i];
+                if (sge->length == 0 || !chain_in_region(sge->mr, sge->offset, sge->length)) {
+                    return -1;
+                }
+                op->length += sge->length;
+            }
+        }
+        if (op->length == 0) return -1;
+    }
+    
+    remoteio_operation_t* batch = chain;
+    int i = 0;
+    for (remoteio_operation_t* op = chain; op; op = op->next_sg) {
+        op->batch = batch;
+        op->unsignaled = ++i % signal_every != 0 && op->next_sg;
+        if (!op->unsignaled) batch = op->next_sg;
+        
+        op->completed = 0;
+        op->status = GPUIO_SUCCESS;
+        op->bytes_transferred = 0;
+    }
+    chain->sg_count = count;
+    
+    return count;
+}
+
+/**
+ * Post a chain of one-sided READ/WRITE ops with one doorbell; see
+ * remoteio_op_chain_prepare() for its shape. Wait on the signalled ops,
+ * or simply on the last: ops complete in chain order. Returns the number
+ * of ops posted, or -1 if none were. Fewer than the whole chain means the
+ * rest already failed; the posted ops still run, so wait on the last of
+ * them before reusing their buffers.
+ */
+int remoteio_op_post_chain(remoteio_context_t* ctx, remoteio_operation_t* chain,
+                           int signal_every) {
+    if (!ctx || !chain || !chain->conn) return -1;
+    
+    remoteio_connection_t* conn = chain->conn;
+    int ret = -1;
+    
+    if (conn->transport == REMOTEIO_TRANSPORT_RDMA && conn->rdma_ep) {
+        ret = remoteio_rdma_post_chain(conn, chain, signal_every);
+    } else if (conn->transport == REMOTEIO_TRANSPORT_SOFT_RDMA ||
+               conn->transport == REMOTEIO_TRANSPORT_SHM) {
+        ret = remoteio_soft_rdma_post_chain(conn, chain, signal_every);
     }
     
+    if (ret > 0) {
+        __atomic_fetch_add(&ctx->requests_submitted, (uint64_t)ret, __ATOMIC_RELAXED);
+    }
     return ret;
 }
 
+/**
+ * Publish an op's completion: run its callback, then wake its waiter alone.
+ * The waiter may free the op as soon as it sees completed, so the callback
+ * comes first and must not wait on the op itself. Called on the reactor
+ * thread, or by a submitter finishing its own op.
+ */
+void remoteio_op_complete(remoteio_connection_t* conn, remoteio_operation_t* op,
+                          gpuio_error_t status) {
+    if (op->callback) {
+        op->status = status;
+        op->callback((gpuio_request_t)op, status, op->user_data);
+    }
+    
+    pthread_mutex_lock(&conn->lock);
+    op->status = status;
+    op->completed = 1;
+    if (status == GPUIO_SUCCESS) {
+        conn->reqs_completed++;
+    } else {
+        conn->reqs_failed++;
+    }
+    pthread_cond_broadcast(&op->done_cond);
+    pthread_mutex_unlock(&conn->lock);
+}
+
+/**
+ * Complete a signalled op of a chain together with the unsignalled ops of
+ * its batch, in chain order. Members complete with the status the
+ * transport left in them: their own where it knows it, else the batch's.
+ */
+void remoteio_op_complete_batch(remoteio_connection_t* conn, remoteio_operation_t* op,
+                                gpuio_error_t status) {
+    remoteio_operation_t* member = op->batch;
+    
+    while (member && member != op) {
+        /* Completed members may be freed at once */
+        remoteio_operation_t* next = member->next_sg;
+        gpuio_error_t member_status = member->status;
+        if (member_status == GPUIO_SUCCESS) member->bytes_transferred = member->length;
+        remoteio_op_complete(conn, member, member_status);
+        member = next;
+    }
+    
+    if (status == GPUIO_SUCCESS) op->bytes_transferred = op->length;
+    remoteio_op_complete(conn, op, status);
+}
+
 int remoteio_op_wait(remoteio_operation_t* op, uint64_t timeout_us) {
     if (!op) return -1;
     
@@ -660,7 +1772,7 @@ int remoteio_op_wait(remoteio_operation_t* op, uint64_t timeout_us) {
     pthread_mutex_lock(&op->conn->lock);
     
     while (!op->completed && op->conn->state == REMOTEIO_CONN_CONNECTED) {
-        if (pthread_cond_timedwait(&op->conn->state_cond, &op->conn->lock, &timeout) != 0) {
+        if (pthread_cond_timedwait(&op->done_cond, &op->conn->lock, &timeout) != 0) {
             pthread_mutex_unlock(&op->conn->lock);
             return -1;
         }
@@ -674,10 +1786,15 @@ int remoteio_op_wait(remoteio_operation_t* op, uint64_t timeout_us) {
 int remoteio_op_cancel(remoteio_operation_t* op) {
     if (!op) return -1;
     
+    if (op->conn->proto && remoteio_proto_cancel(op->conn, op) != 0) {
+        op_settle(op);
+        return 0; /* Completed, if only just now */
+    }
+    
     pthread_mutex_lock(&op->conn->lock);
     op->completed = 1;
     op->status = GPUIO_ERROR_CANCELED;
-    pthread_cond_broadcast(&op->conn->state_cond);
+    pthread_cond_broadcast(&op->done_cond);
     pthread_mutex_unlock(&op->conn->lock);
     
     return 0;
@@ -0,0 +1,1284 @@
+/**
+ * @file protocol.c
+ * @brief RemoteIO module - Pipelined TCP request/response protocol
+ * @version 1.0.0
+ *
+ * Client side of the framed protocol described in remoteio_internal.h.
+ * Any number of ops may be outstanding on one connection: submitters write
+ * their frames with writev under a send lock (header, resource and user
+ * payload go out without being copied together), and the context's
+ * completion reactor parses responses as their bytes arrive, matching them
+ * to ops by request id and receiving READ payload straight into the
+ * caller's buffer. When the peer granted
+ * REMOTEIO_CAP_LZ4, payload chunks that compress well travel compressed
+ * and are inflated straight into the caller's buffer too.
+ *
+ * The same connection carries region lookups; the descriptors they return
+ * are cached per context until the peer revokes them.
+ */
+
+#include "remoteio_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <endian.h>
+#include <limits.h>
+#include <poll.h>
+#include <time.h>
+
+/* ============================================================================
+ * Header Encoding
+ * ============================================================================ */
+
+static inline void put_u16(uint8_t* p, uint16_t v) { v = htole16(v); memcpy(p, &v, 2); }
+static inline void put_u32(uint8_t* p, uint32_t v) { v = htole32(v); memcpy(p, &v, 4); }
+static inline void put_u64(uint8_t* p, uint64_t v) { v = htole64(v); memcpy(p, &v, 8); }
+static inline uint16_t get_u16(const uint8_t* p) { uint16_t v; memcpy(&v, p, 2); return le16toh(v); }
+static inline uint32_t get_u32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return le32toh(v); }
+static inline uint64_t get_u64(const uint8_t* p) { uint64_t v; memcpy(&v, p, 8); return le64toh(v); }
+
+void remoteio_msg_encode(const remoteio_msg_hdr_t* hdr, uint8_t out[REMOTEIO_MSG_HDR_SIZE]) {
+    put_u32(out + 0, REMOTEIO_PROTO_MAGIC);
+    out[4] = REMOTEIO_PROTO_VERSION;
+    out[5] = hdr->type;
+    put_u16(out + 6, hdr->flags);
+    put_u64(out + 8, hdr->req_id);
+    put_u64(out + 16, hdr->offset);
+    put_u64(out + 24, hdr->length);
+    put_u32(out + 32, hdr->chunk_len);
+    put_u16(out + 36, hdr->resource_len);
+    put_u16(out + 38, (uint16_t)hdr->status);
+    put_u32(out + 40, hdr->rkey);
+    put_u32(out + 44, hdr->credit_ops);
+    put_u32(out + 48, hdr->credit_bytes);
+}
+
+int remoteio_msg_decode(const uint8_t in[REMOTEIO_MSG_HDR_SIZE], remoteio_msg_hdr_t* hdr) {
+    if (get_u32(in) != REMOTEIO_PROTO_MAGIC || in[4] != REMOTEIO_PROTO_VERSION) {
+        return -1;
+    }
+    
+    hdr->type = in[5];
+    hdr->flags = get_u16(in + 6);
+    hdr->req_id = get_u64(in + 8);
+    hdr->offset = get_u64(in + 16);
+    hdr->length = get_u64(in + 24);
+    hdr->chunk_len = get_u32(in + 32);
+    hdr->resource_len = get_u16(in + 36);
+    hdr->status = (int16_t)get_u16(in + 38);
+    hdr->rkey = get_u32(in + 40);
+    hdr->credit_ops = get_u32(in + 44);
+    hdr->credit_bytes = get_u32(in + 48);
+    
+    if (hdr->chunk_len > REMOTEIO_PROTO_CHUNK ||
+        hdr->resource_len >= REMOTEIO_MAX_RESOURCE) {
+        return -1;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Pending Op Table
+ * ============================================================================ */
+
+static inline int proto_bucket(uint64_t req_id) {
+    return (int)(req_id % REMOTEIO_PROTO_BUCKETS);
+}
+
+/* Called with pending_lock held */
+static void proto_insert(remoteio_proto_conn_t* proto, remoteio_operation_t* op) {
+    int b = proto_bucket(op->id);
+    op->next_pending = proto->pending[b];
+    proto->pending[b] = op;
+    proto->num_pending++;
+}
+
+/* Called with pending_lock held */
+static remoteio_operation_t* proto_find(remoteio_proto_conn_t* proto, uint64_t req_id) {
+    remoteio_operation_t* op = proto->pending[proto_bucket(req_id)];
+    while (op && op->id != req_id) op = op->next_pending;
+    return op;
+}
+
+/* Called with pending_lock held */
+static int proto_remove(remoteio_proto_conn_t* proto, remoteio_operation_t* op) {
+    remoteio_operation_t** cur = &proto->pending[proto_bucket(op->id)];
+    while (*cur) {
+        if (*cur == op) {
+            *cur = op->next_pending;
+            op->next_pending = NULL;
+            proto->num_pending--;
+            return 0;
+        }
+        cur = &(*cur)->next_pending;
+    }
+    return -1;
+}
+
+/* Called with pending_lock held. Take op off the table on behalf of
+ * whoever completes it. */
+static int proto_claim(remoteio_proto_conn_t* proto, remoteio_operation_t* op) {
+    if (proto_remove(proto, op) != 0) return -1;
+    op->claimed = true;
+    return 0;
+}
+
+/* The op's local memory: one-sided ops name a registered region */
+static inline char* proto_op_buf(const remoteio_operation_t* op) {
+    return (char*)(op->one_sided ? op->local_gdr->gpu_ptr : op->local_buf) + op->local_offset;
+}
+
+/* Peer offset (or address) of the op's first byte */
+static inline uint64_t proto_op_base(const remoteio_operation_t* op) {
+    return op->one_sided ? op->raddr : op->remote_offset;
+}
+
+/* Local address of the op's byte at rel, and how many bytes from there are
+ * contiguous; chained ops may gather from several pieces. NULL past the end. */
+static char* proto_op_span(const remoteio_operation_t* op, uint64_t rel, size_t* avail) {
+    if (rel >= op->length) return NULL;
+    
+    if (op->num_sge == 0) {
+        *avail = op->length - rel;
+        return proto_op_buf(op) + rel;
+    }
+    for (int i = 0; i < op->num_sge; i++) {
+        const remoteio_sge_t* sge = &op->sge[i];
+        if (rel < sge->length) {
+            *avail = sge->length - rel;
+            return (char*)sge->mr->gpu_ptr + sge->offset + rel;
+        }
+        rel -= sge->length;
+    }
+    return NULL;
+}
+
+/* Called with pending_lock held. A zero-copy WRITE whose buffer the kernel
+ * still holds is completed by its submitter instead; park the status. */
+static bool proto_hold(remoteio_operation_t* op, gpuio_error_t status) {
+    if (!op->zc_hold) return false;
+    op->resp_done = true;
+    op->resp_status = status;
+    return true;
+}
+
+/* Called with pending_lock held. The signalled op of a chain batch is done:
+ * its unsignalled members leave the table too (successful writes among
+ * them are never answered). */
+static void proto_remove_batch(remoteio_proto_conn_t* proto, remoteio_operation_t* op) {
+    for (remoteio_operation_t* m = op->batch; m && m != op; m = m->next_sg) {
+        proto_claim(proto, m);
+    }
+}
+
+/* Fail every outstanding op, e.g. after the connection broke */
+static void proto_fail_all(remoteio_connection_t* conn, gpuio_error_t status) {
+    remoteio_proto_conn_t* proto = conn->proto;
+    
+    for (;;) {
+        remoteio_operation_t* op = NULL;
+        
+        pthread_mutex_lock(&proto->pending_lock);
+        for (int b = 0; b < REMOTEIO_PROTO_BUCKETS && !op; b++) {
+            op = proto->pending[b];
+        }
+        bool hold = false;
+        if (op) {
+            proto_claim(proto, op);
+            hold = proto_hold(op, status);
+            if (op->batch && !op->unsignaled) proto_remove_batch(proto, op);
+        }
+        pthread_mutex_unlock(&proto->pending_lock);
+        
+        if (!op) break;
+        if (hold || op->unsignaled) continue;   /* Unsignalled: with its batch */
+        
+        if (op->batch) {
+            remoteio_op_complete_batch(conn, op, status);
+        } else {
+            remoteio_op_complete(conn, op, status);
+        }
+    }
+}
+
+/* ============================================================================
+ * Remote Region Cache
+ * ============================================================================ */
+
+/* FNV-1a over peer and name */
+static int region_bucket(const char* addr, uint16_t port, const char* name) {
+    uint32_t h = 2166136261u;
+    for (const char* p = addr; *p; p++) {
+        h ^= (uint8_t)*p;
+        h *= 16777619u;
+    }
+    h ^= port;
+    h *= 16777619u;
+    for (const char* p = name; *p; p++) {
+        h ^= (uint8_t)*p;
+        h *= 16777619u;
+    }
+    return (int)(h % REMOTEIO_REGION_BUCKETS);
+}
+
+int remoteio_region_cache_init(remoteio_region_cache_t* cache) {
+    if (!cache) return -1;
+    
+    memset(cache, 0, sizeof(*cache));
+    pthread_mutex_init(&cache->lock, NULL);
+    return 0;
+}
+
+void remoteio_region_cache_cleanup(remoteio_region_cache_t* cache) {
+    if (!cache) return;
+    
+    for (int b = 0; b < REMOTEIO_REGION_BUCKETS; b++) {
+        while (cache->buckets[b]) {
+            remoteio_region_entry_t* next = cache->buckets[b]->next;
+            free(cache->buckets[b]);
+            cache->buckets[b] = next;
+        }
+    }
+    cache->num_entries = 0;
+    pthread_mutex_destroy(&cache->lock);
+}
+
+/* Called with the cache lock held */
+static remoteio_region_entry_t* region_find(remoteio_region_cache_t* cache, int b,
+                                            const char* addr, uint16_t port,
+                                            const char* name) {
+    for (remoteio_region_entry_t* e = cache->buckets[b]; e; e = e->next) {
+        if (e->mem.peer_port == port && strcmp(e->mem.peer_addr, addr) == 0 &&
+            strcmp(e->name, name) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* Copy out the cached descriptor of a peer's region; -1 on a miss */
+int remoteio_region_cache_get(remoteio_region_cache_t* cache, const char* addr, uint16_t port,
+                              const char* name, remoteio_remote_mem_t* mem_out) {
+    if (!cache || !addr || !name || !mem_out) return -1;
+    
+    int b = region_bucket(addr, port, name);
+    
+    pthread_mutex_lock(&cache->lock);
+    remoteio_region_entry_t* e = region_find(cache, b, addr, port, name);
+    if (e) {
+        *mem_out = e->mem;
+        cache->hits++;
+    } else {
+        cache->misses++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    
+    return e ? 0 : -1;
+}
+
+/* Remember a descriptor; the peer is the one named in mem */
+int remoteio_region_cache_put(remoteio_region_cache_t* cache, const char* name,
+                              const remoteio_remote_mem_t* mem) {
+    if (!cache || !name || !mem || strlen(name) >= REMOTEIO_MAX_RESOURCE) return -1;
+    
+    int b = region_bucket(mem->peer_addr, mem->peer_port, name);
+    
+    pthread_mutex_lock(&cache->lock);
+    remoteio_region_entry_t* e = region_find(cache, b, mem->peer_addr, mem->peer_port, name);
+    if (!e) {
+        e = calloc(1, sizeof(remoteio_region_entry_t));
+        if (!e) {
+            pthread_mutex_unlock(&cache->lock);
+            return -1;
+        }
+        strcpy(e->name, name);
+        e->next = cache->buckets[b];
+        cache->buckets[b] = e;
+        cache->num_entries++;
+    }
+    e->mem = *mem;
+    pthread_mutex_unlock(&cache->lock);
+    
+    return 0;
+}
+
+/* Drop a peer's descriptors for rkey. Returns how many went. */
+int remoteio_region_cache_invalidate(remoteio_region_cache_t* cache, const char* addr,
+                                     uint16_t port, uint32_t rkey) {
+    if (!cache || !addr) return 0;
+    
+    int dropped = 0;
+    
+    pthread_mutex_lock(&cache->lock);
+    for (int b = 0; b < REMOTEIO_REGION_BUCKETS && cache->num_entries > 0; b++) {
+        remoteio_region_entry_t** cur = &cache->buckets[b];
+        while (*cur) {
+            remoteio_region_entry_t* e = *cur;
+            if (e->mem.rkey == rkey && e->mem.peer_port == port &&
+                strcmp(e->mem.peer_addr, addr) == 0) {
+                *cur = e->next;
+                free(e);
+                cache->num_entries--;
+                dropped++;
+            } else {
+                cur = &e->next;
+            }
+        }
+    }
+    cache->invalidations += (uint64_t)dropped;
+    pthread_mutex_unlock(&cache->lock);
+    
+    return dropped;
+}
+
+/* ============================================================================
+ * Flow Control
+ * ============================================================================ */
+
+static bool proto_credit_fits(const remoteio_proto_conn_t* proto, uint32_t bytes) {
+    return (int32_t)(proto->ops_limit - (proto->ops_sent + 1)) >= 0 &&
+           (int32_t)(proto->bytes_limit - (proto->bytes_sent + bytes)) >= 0;
+}
+
+/* Wall-clock time, as condition variable deadlines use */
+static uint64_t proto_realtime_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Take the credits of a request frame carrying bytes of payload. If the
+ * server hasn't granted them yet, wait for it when wait is set, else
+ * return 1. Returns -1 if the stream failed or no grant came in time.
+ * Called with the send lock held, so frames go out in the order they got
+ * their credits.
+ */
+static int proto_credit_take(remoteio_connection_t* conn, uint32_t bytes, bool wait) {
+    remoteio_proto_conn_t* proto = conn->proto;
+    uint64_t start_ns = 0;
+    int ret = 0;
+    
+    pthread_mutex_lock(&proto->credit_lock);
+    while (proto->credits && !proto_credit_fits(proto, bytes)) {
+        if (!wait) {
+            ret = 1;
+            break;
+        }
+        
+        uint64_t now_ns = proto_realtime_ns();
+        if (start_ns == 0) start_ns = now_ns;
+        uint64_t deadline = start_ns + REMOTEIO_CREDIT_TIMEOUT_US * 1000;
+        if (proto->broken || now_ns >= deadline) {
+            ret = -1;
+            break;
+        }
+        
+        struct timespec ts = {
+            .tv_sec = (time_t)(deadline / 1000000000ULL),
+            .tv_nsec = (long)(deadline % 1000000000ULL),
+        };
+        pthread_cond_timedwait(&proto->credit_cond, &proto->credit_lock, &ts);
+    }
+    if (ret == 0 && proto->credits) {
+        proto->ops_sent++;
+        proto->bytes_sent += bytes;
+    }
+    pthread_mutex_unlock(&proto->credit_lock);
+    
+    if (start_ns != 0) {
+        uint64_t stalled_us = (proto_realtime_ns() - start_ns) / 1000;
+        
+        pthread_mutex_lock(&conn->lock);
+        conn->credit_stalls++;
+        conn->credit_stall_us += stalled_us;
+        pthread_mutex_unlock(&conn->lock);
+    }
+    return ret;
+}
+
+/* Every server frame carries its latest limits; they only ever move up */
+static void proto_credit_update(remoteio_proto_conn_t* proto, const remoteio_msg_hdr_t* hdr) {
+    if (!proto->credits) return;
+    
+    pthread_mutex_lock(&proto->credit_lock);
+    bool more = false;
+    if ((int32_t)(hdr->credit_ops - proto->ops_limit) > 0) {
+        proto->ops_limit = hdr->credit_ops;
+        more = true;
+    }
+    if ((int32_t)(hdr->credit_bytes - proto->bytes_limit) > 0) {
+        proto->bytes_limit = hdr->credit_bytes;
+        more = true;
+    }
+    if (more) pthread_cond_broadcast(&proto->credit_cond);
+    pthread_mutex_unlock(&proto->credit_lock);
+}
+
+/* ============================================================================
+ * Receive Path
+ * ============================================================================ */
+
+/* The header and resource of a frame are in: find its op and decide where
+ * the payload goes. Called on the reactor thread. */
+static int proto_rx_begin(remoteio_connection_t* conn) {
+    remoteio_proto_conn_t* proto = conn->proto;
+    const remoteio_msg_hdr_t* hdr = &proto->rx_hdr;
+    
+    proto->rx_dst = NULL;
+    proto->rx_len = hdr->chunk_len;
+    
+    /* Its limits were taken with the header */
+    if (hdr->type == REMOTEIO_MSG_CREDIT) return 0;
+    
+    /* Pushed by the peer, answers no op */
+    if (hdr->type == REMOTEIO_MSG_INVALIDATE) {
+        if (proto->regions) {
+            remoteio_region_cache_invalidate(proto->regions, conn->peer_addr,
+                                             conn->peer_port, hdr->rkey);
+        }
+        return 0;
+    }
+    
+    pthread_mutex_lock(&proto->pending_lock);
+    remoteio_operation_t* op = proto_find(proto, hdr->req_id);
+    proto->rx_op = op;
+    pthread_mutex_unlock(&proto->pending_lock);
+    
+    if (!op) return 0;
+    
+    if (hdr->type == REMOTEIO_MSG_READ_RESP && op->op == REMOTEIO_OP_READ) {
+        if (hdr->chunk_len == 0) return 0;
+        if (hdr->flags & REMOTEIO_MSG_F_COMPRESSED) {
+            if (!proto->rx_scratch || hdr->chunk_len > REMOTEIO_PROTO_CHUNK) return -1;
+            proto->rx_dst = proto->rx_scratch;
+        } else {
+            size_t avail = 0;
+            char* dst = hdr->offset < proto_op_base(op) ? NULL :
+                        proto_op_span(op, hdr->offset - proto_op_base(op), &avail);
+            if (!dst || hdr->chunk_len > avail) {
+                /* Out-of-range chunk: keep the stream in sync, fail the op */
+                op->status = GPUIO_ERROR_IO;
+            } else {
+                proto->rx_dst = dst;
+            }
+        }
+        return 0;
+    }
+    if (hdr->type == REMOTEIO_MSG_WRITE_RESP && op->op == REMOTEIO_OP_WRITE) {
+        op->bytes_transferred = hdr->length;
+        return 0;
+    }
+    if (hdr->type == REMOTEIO_MSG_PONG && op->op == REMOTEIO_OP_PING) {
+        if (hdr->chunk_len > 0 && op->local_buf && hdr->chunk_len <= op->length) {
+            proto->rx_dst = op->local_buf;
+        }
+        return 0;
+    }
+    if (hdr->type == REMOTEIO_MSG_LOOKUP_RESP && op->op == REMOTEIO_OP_LOOKUP) {
+        /* Cached here rather than by the waiter, ahead of any INVALIDATE
+         * behind it on the stream */
+        if (hdr->status == GPUIO_SUCCESS) {
+            op->raddr = hdr->offset;
+            op->rkey = hdr->rkey;
+            op->length = hdr->length;
+            
+            remoteio_remote_mem_t mem = {
+                .raddr = hdr->offset,
+                .rkey = hdr->rkey,
+                .length = hdr->length,
+                .peer_port = conn->peer_port,
+            };
+            strcpy(mem.peer_addr, conn->peer_addr);
+            if (proto->regions) remoteio_region_cache_put(proto->regions, op->resource, &mem);
+        }
+        return 0;
+    }
+    
+    return -1;
+}
+
+/* Inflate a compressed READ_RESP chunk from rx_scratch into the op's buffer */
+static void proto_rx_inflate(remoteio_connection_t* conn, remoteio_operation_t* op,
+                             const remoteio_msg_hdr_t* hdr) {
+    remoteio_proto_conn_t* proto = conn->proto;
+    uint64_t rel = hdr->offset - proto_op_base(op);
+    size_t n = 0;
+    
+    if (hdr->offset < proto_op_base(op) || rel >= op->length ||
+        remoteio_proto_decompress(conn, (const uint8_t*)proto->rx_scratch, hdr->chunk_len,
+                                  proto_op_buf(op) + rel,
+                                  op->length - rel < REMOTEIO_PROTO_CHUNK ?
+                                  op->length - rel : REMOTEIO_PROTO_CHUNK, &n) != 0) {
+        op->status = GPUIO_ERROR_IO;
+        return;
+    }
+    op->bytes_transferred += n;
+}
+
+/* The whole frame is in: account its payload, and complete the op on its
+ * last frame */
+static void proto_rx_end(remoteio_connection_t* conn) {
+    remoteio_proto_conn_t* proto = conn->proto;
+    const remoteio_msg_hdr_t* hdr = &proto->rx_hdr;
+    remoteio_operation_t* op = proto->rx_op;
+    
+    if (op && proto->rx_dst) {
+        if (hdr->flags & REMOTEIO_MSG_F_COMPRESSED) {
+            proto_rx_inflate(conn, op, hdr);
+        } else {
+            op->bytes_transferred += hdr->chunk_len;
+        }
+    }
+    
+    /* One-sided ops are answered per frame; an early refusal sticks */
+    if (op && hdr->status != GPUIO_SUCCESS && op->status == GPUIO_SUCCESS) {
+        op->status = (gpuio_error_t)hdr->status;
+        
+        /* A refused rkey is stale wherever it's cached */
+        if (op->one_sided && hdr->status == GPUIO_ERROR_PERMISSION && proto->regions) {
+            remoteio_region_cache_invalidate(proto->regions, conn->peer_addr,
+                                             conn->peer_port, op->rkey);
+        }
+    }
+    
+    bool done = false;
+    gpuio_error_t status = (gpuio_error_t)hdr->status;
+    pthread_mutex_lock(&proto->pending_lock);
+    proto->rx_op = NULL;
+    if (op && (hdr->flags & REMOTEIO_MSG_F_LAST)) {
+        done = proto_claim(proto, op) == 0;
+        if (done && status == GPUIO_SUCCESS && op->status != GPUIO_SUCCESS) {
+            status = op->status;
+        }
+        if (done && proto_hold(op, status)) done = false;
+        if (done && op->unsignaled) {
+            /* Completes with its batch */
+            op->status = status;
+            done = false;
+        }
+        if (done && op->batch) proto_remove_batch(proto, op);
+    }
+    pthread_cond_broadcast(&proto->rx_cond);
+    pthread_mutex_unlock(&proto->pending_lock);
+    
+    if (done && op->batch) {
+        remoteio_op_complete_batch(conn, op, status);
+    } else if (done) {
+        remoteio_op_complete(conn, op, status);
+    }
+}
+
+/**
+ * Parse whatever response bytes the socket holds without blocking, up to
+ * REMOTEIO_REACTOR_RX_FRAMES frames. A frame may span calls. Returns -1 if
+ * the stream is broken or out of sync.
+ */
+int remoteio_proto_rx_ready(remoteio_connection_t* conn) {
+    if (!conn || !conn->proto) return -1;
+    
+    remoteio_proto_conn_t* proto = conn->proto;
+    char drain[4096];
+    size_t received = 0;
+    int frames = 0;
+    int ret = 0;
+    
+    while (frames < REMOTEIO_REACTOR_RX_FRAMES) {
+        size_t want = proto->rx_len - proto->rx_pos;
+        char* dst;
+        
+        if (proto->rx_stage == REMOTEIO_PROTO_RX_HEADER) {
+            dst = (char*)proto->rx_raw + proto->rx_pos;
+        } else if (proto->rx_stage == REMOTEIO_PROTO_RX_PAYLOAD && proto->rx_dst) {
+            dst = proto->rx_dst + proto->rx_pos;
+        } else {
+            /* Resource names and payload nobody wants are discarded */
+            dst = drain;
+            if (want > sizeof(drain)) want = sizeof(drain);
+        }
+        
+        if (want > 0) {
+            ssize_t n = remoteio_network_recv_some(conn, dst, want);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n <= 0) {
+                ret = -1;
+                break;
+            }
+            proto->rx_pos += (size_t)n;
+            received += (size_t)n;
+            if (proto->rx_pos < proto->rx_len) continue;
+        }
+        
+        /* Stage complete */
+        proto->rx_pos = 0;
+        if (proto->rx_stage == REMOTEIO_PROTO_RX_HEADER) {
+            if (remoteio_msg_decode(proto->rx_raw, &proto->rx_hdr) != 0) {
+                ret = -1;
+                break;
+            }
+            proto_credit_update(proto, &proto->rx_hdr);
+            proto->rx_stage = REMOTEIO_PROTO_RX_RESOURCE;
+            proto->rx_len = proto->rx_hdr.resource_len;
+        } else if (proto->rx_stage == REMOTEIO_PROTO_RX_RESOURCE) {
+            if (proto_rx_begin(conn) != 0) {
+                ret = -1;
+                break;
+            }
+            proto->rx_stage = REMOTEIO_PROTO_RX_PAYLOAD;
+        } else {
+            proto_rx_end(conn);
+            proto->rx_stage = REMOTEIO_PROTO_RX_HEADER;
+            proto->rx_len = REMOTEIO_MSG_HDR_SIZE;
+            frames++;
+        }
+    }
+    
+    if (received > 0) {
+        pthread_mutex_lock(&conn->lock);
+        conn->bytes_received += received;
+        pthread_mutex_unlock(&conn->lock);
+    }
+    
+    return ret;
+}
+
+/* The stream is unusable: fail the connection and everything on it */
+void remoteio_proto_rx_fail(remoteio_connection_t* conn) {
+    if (!conn || !conn->proto) return;
+    
+    remoteio_proto_conn_t* proto = conn->proto;
+    
+    pthread_mutex_lock(&proto->pending_lock);
+    proto->rx_op = NULL;
+    pthread_cond_broadcast(&proto->rx_cond);
+    pthread_mutex_unlock(&proto->pending_lock);
+    
+    /* No more grants are coming */
+    pthread_mutex_lock(&proto->credit_lock);
+    proto->broken = true;
+    pthread_cond_broadcast(&proto->credit_cond);
+    pthread_mutex_unlock(&proto->credit_lock);
+    
+    pthread_mutex_lock(&conn->lock);
+    if (conn->state == REMOTEIO_CONN_CONNECTED) {
+        conn->state = REMOTEIO_CONN_ERROR;
+    }
+    pthread_cond_broadcast(&conn->state_cond);
+    pthread_mutex_unlock(&conn->lock);
+    
+    proto_fail_all(conn, GPUIO_ERROR_NETWORK);
+}
+
+/* ============================================================================
+ * Connection Attach/Detach
+ * ============================================================================ */
+
+/* Agree on capabilities before any op can use the connection; ack gets
+ * the server's answer, with its first credit limits */
+static int proto_hello(remoteio_connection_t* conn, uint32_t want, remoteio_msg_hdr_t* ack) {
+    remoteio_msg_hdr_t hdr = {
+        .type = REMOTEIO_MSG_HELLO,
+        .flags = REMOTEIO_MSG_F_LAST,
+        .offset = want,
+    };
+    uint8_t raw[REMOTEIO_MSG_HDR_SIZE];
+    
+    remoteio_msg_encode(&hdr, raw);
+    if (remoteio_network_send(conn, raw, sizeof(raw)) != 0) return -1;
+    
+    struct pollfd pfd = { .fd = remoteio_network_poll_fd(conn), .events = POLLIN };
+    if (poll(&pfd, 1, REMOTEIO_HELLO_TIMEOUT_MS) <= 0) return -1;
+    if (remoteio_network_recv(conn, raw, sizeof(raw)) != 0 ||
+        remoteio_msg_decode(raw, &hdr) != 0) {
+        return -1;
+    }
+    if (hdr.type != REMOTEIO_MSG_HELLO_ACK || hdr.status != GPUIO_SUCCESS ||
+        hdr.chunk_len != 0 || hdr.resource_len != 0) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&conn->lock);
+    conn->caps = (uint32_t)hdr.offset & want;
+    pthread_mutex_unlock(&conn->lock);
+    
+    *ack = hdr;
+    return 0;
+}
+
+int remoteio_proto_attach(remoteio_connection_t* conn, remoteio_context_t* ctx) {
+    if (!conn || conn->proto || conn->socket_fd < 0) return -1;
+    
+    uint32_t want = REMOTEIO_CAP_CREDITS;
+    
+    /* Over shared memory a chunk costs a memcpy; compressing it costs more */
+    if (ctx && ctx->use_compression && ctx->codec &&
+        conn->transport != REMOTEIO_TRANSPORT_SHM) {
+        want |= REMOTEIO_CAP_LZ4;
+        conn->codec = ctx->codec;
+    }
+    remoteio_msg_hdr_t ack;
+    if (proto_hello(conn, want, &ack) != 0) return -1;
+    
+    remoteio_proto_conn_t* proto = calloc(1, sizeof(remoteio_proto_conn_t));
+    if (!proto) return -1;
+    
+    if ((conn->caps & REMOTEIO_CAP_LZ4) && !(proto->rx_scratch = malloc(REMOTEIO_PROTO_CHUNK))) {
+        free(proto);
+        return -1;
+    }
+    
+    pthread_mutex_init(&proto->send_lock, NULL);
+    pthread_mutex_init(&proto->pending_lock, NULL);
+    pthread_cond_init(&proto->rx_cond, NULL);
+    pthread_mutex_init(&proto->credit_lock, NULL);
+    pthread_cond_init(&proto->credit_cond, NULL);
+    proto->credits = (conn->caps & REMOTEIO_CAP_CREDITS) != 0;
+    proto->ops_limit = ack.credit_ops;
+    proto->bytes_limit = ack.credit_bytes;
+    proto->rx_stage = REMOTEIO_PROTO_RX_HEADER;
+    proto->rx_len = REMOTEIO_MSG_HDR_SIZE;
+    proto->regions = ctx ? &ctx->region_cache : NULL;
+    conn->proto = proto;
+    
+    return 0;
+}
+
+/* Called once the reactor no longer services the connection; outstanding
+ * ops complete with an error */
+void remoteio_proto_detach(remoteio_connection_t* conn) {
+    if (!conn || !conn->proto) return;
+    
+    remoteio_proto_conn_t* proto = conn->proto;
+    
+    proto_fail_all(conn, GPUIO_ERROR_NETWORK);
+    
+    conn->proto = NULL;
+    pthread_mutex_destroy(&proto->send_lock);
+    pthread_mutex_destroy(&proto->pending_lock);
+    pthread_cond_destroy(&proto->rx_cond);
+    pthread_mutex_destroy(&proto->credit_lock);
+    pthread_cond_destroy(&proto->credit_cond);
+    free(proto->rx_scratch);
+    free(proto);
+}
+
+/* ============================================================================
+ * Wire Compression
+ * ============================================================================ */
+
+static uint64_t proto_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static gpuio_codec_t proto_codec(remoteio_connection_t* conn) {
+    pthread_mutex_lock(&conn->lock);
+    gpuio_codec_t codec = (conn->caps & REMOTEIO_CAP_LZ4) ? conn->codec : NULL;
+    pthread_mutex_unlock(&conn->lock);
+    return codec;
+}
+
+/**
+ * Compress one payload chunk of at most REMOTEIO_PROTO_CHUNK bytes into out
+ * (REMOTEIO_PROTO_CHUNK bytes). Returns the compressed frame payload size,
+ * or 0 if the chunk should go raw: compression wasn't negotiated, or the
+ * sample or the chunk didn't save REMOTEIO_COMPRESS_MIN_SAVING percent.
+ */
+size_t remoteio_proto_compress(remoteio_connection_t* conn, const void* src, size_t len,
+                               uint8_t* out) {
+    if (!conn || !src || !out || len < REMOTEIO_COMPRESS_SAMPLE || len > REMOTEIO_PROTO_CHUNK) {
+        return 0;
+    }
+    
+    gpuio_codec_t codec = proto_codec(conn);
+    if (!codec) return 0;
+    
+    uint64_t start = proto_cpu_ns();
+    size_t sample = REMOTEIO_COMPRESS_SAMPLE;
+    size_t packed = 0;
+    bool ok = gpuio_compress(codec, src, sample, out + REMOTEIO_COMPRESS_HDR,
+                             sample - sample * REMOTEIO_COMPRESS_MIN_SAVING / 100,
+                             &packed, NULL) == GPUIO_SUCCESS;
+    if (ok && len > sample) {
+        ok = gpuio_compress(codec, src, len, out + REMOTEIO_COMPRESS_HDR,
+                            len - len * REMOTEIO_COMPRESS_MIN_SAVING / 100,
+                            &packed, NULL) == GPUIO_SUCCESS;
+    }
+    uint64_t elapsed = proto_cpu_ns() - start;
+    
+    if (ok) put_u32(out, (uint32_t)len);
+    
+    pthread_mutex_lock(&conn->lock);
+    conn->compress.compress_ns += elapsed;
+    if (ok) {
+        conn->compress.chunks_compressed++;
+        conn->compress.raw_bytes += len;
+        conn->compress.wire_bytes += REMOTEIO_COMPRESS_HDR + packed;
+    } else {
+        conn->compress.chunks_skipped++;
+    }
+    pthread_mutex_unlock(&conn->lock);
+    
+    return ok ? REMOTEIO_COMPRESS_HDR + packed : 0;
+}
+
+/**
+ * Inflate a compressed chunk payload into dst. Fails unless the chunk
+ * inflates to exactly its declared length and that fits dst_cap.
+ */
+int remoteio_proto_decompress(remoteio_connection_t* conn, const uint8_t* src, size_t len,
+                              void* dst, size_t dst_cap, size_t* dst_len) {
+    if (!conn || !src || !dst || !dst_len || len <= REMOTEIO_COMPRESS_HDR) return -1;
+    
+    gpuio_codec_t codec = proto_codec(conn);
+    if (!codec) return -1;
+    
+    size_t raw_len = get_u32(src);
+    if (raw_len > dst_cap) return -1;
+    
+    uint64_t start = proto_cpu_ns();
+    size_t n = 0;
+    bool ok = gpuio_decompress(codec, src + REMOTEIO_COMPRESS_HDR, len - REMOTEIO_COMPRESS_HDR,
+                               dst, raw_len, &n, NULL) == GPUIO_SUCCESS && n == raw_len;
+    uint64_t elapsed = proto_cpu_ns() - start;
+    
+    pthread_mutex_lock(&conn->lock);
+    conn->compress.decompress_ns += elapsed;
+    if (ok) conn->compress.chunks_decompressed++;
+    pthread_mutex_unlock(&conn->lock);
+    
+    if (!ok) return -1;
+    *dst_len = n;
+    return 0;
+}
+
+/* Snapshot a connection's compression counters; ratio is raw over wire bytes */
+void remoteio_conn_get_compress_stats(remoteio_connection_t* conn,
+                                      remoteio_compress_stats_t* stats, double* ratio) {
+    if (!conn || !stats) return;
+    
+    pthread_mutex_lock(&conn->lock);
+    *stats = conn->compress;
+    pthread_mutex_unlock(&conn->lock);
+    
+    if (ratio) {
+        *ratio = stats->wire_bytes ? (double)stats->raw_bytes / (double)stats->wire_bytes : 1.0;
+    }
+}
+
+/* ============================================================================
+ * Submission
+ * ============================================================================ */
+
+/* Write one frame: header, resource name and (optional) payload. With
+ * zc_seq set, the payload is sent zero-copy and *zc_seq receives the send
+ * number to wait for before the payload buffer may be reused. */
+static int proto_send_frame(remoteio_connection_t* conn, const remoteio_msg_hdr_t* hdr,
+                            const char* resource, const void* payload, int64_t* zc_seq) {
+    uint8_t raw[REMOTEIO_MSG_HDR_SIZE];
+    struct iovec iov[3];
+    int iovcnt = 0;
+    
+    remoteio_msg_encode(hdr, raw);
+    iov[iovcnt].iov_base = raw;
+    iov[iovcnt].iov_len = sizeof(raw);
+    iovcnt++;
+    if (hdr->resource_len > 0) {
+        iov[iovcnt].iov_base = (void*)resource;
+        iov[iovcnt].iov_len = hdr->resource_len;
+        iovcnt++;
+    }
+    bool zerocopy = zc_seq && hdr->chunk_len > 0;
+    if (hdr->chunk_len > 0 && !zerocopy) {
+        iov[iovcnt].iov_base = (void*)payload;
+        iov[iovcnt].iov_len = hdr->chunk_len;
+        iovcnt++;
+    }
+    
+    /* The header is copied as usual; only the payload is pinned */
+    pthread_mutex_lock(&conn->proto->send_lock);
+    if (proto_credit_take(conn, hdr->chunk_len, true) != 0) {
+        /* A server that grants nothing is as good as gone */
+        pthread_mutex_unlock(&conn->proto->send_lock);
+        remoteio_network_shutdown(conn);
+        return -1;
+    }
+    int ret = remoteio_network_sendv(conn, iov, iovcnt, zerocopy ? MSG_MORE : 0);
+    if (ret == 0 && zerocopy) {
+        *zc_seq = remoteio_network_send_zerocopy(conn, payload, hdr->chunk_len);
+        if (*zc_seq < 0) ret = -1;
+    }
+    pthread_mutex_unlock(&conn->proto->send_lock);
+    
+    return ret;
+}
+
+/**
+ * Send an op's request frames. The op completes asynchronously when its
+ * final response frame arrives; wait with remoteio_op_wait().
+ *
+ * Returns 0 if the op is in flight, and it then completes exactly once,
+ * with an error if the stream breaks. Returns -1 if it never went out or
+ * was withdrawn after a failed send; it then never completes.
+ * remoteio_proto_submit_chain() keeps the same contract.
+ */
+int remoteio_proto_submit(remoteio_connection_t* conn, remoteio_operation_t* op) {
+    if (!conn || !conn->proto || !op) return -1;
+    if (op->op == REMOTEIO_OP_PING) {
+        /* Up to a chunk of echo, received into local_buf */
+        if (op->length > REMOTEIO_PROTO_CHUNK || (op->length > 0 && !op->local_buf)) return -1;
+        op->one_sided = false;
+    } else if (op->op == REMOTEIO_OP_LOOKUP) {
+        op->length = 0;
+        op->one_sided = false;
+    } else if (op->op != REMOTEIO_OP_READ && op->op != REMOTEIO_OP_WRITE) {
+        return -1;
+    } else if (op->one_sided ? !op->local_gdr || !op->local_gdr->gpu_ptr : !op->local_buf) {
+        return -1;
+    }
+    
+    remoteio_proto_conn_t* proto = conn->proto;
+    size_t resource_len = op->one_sided ? 0 : strnlen(op->resource, REMOTEIO_MAX_RESOURCE);
+    if (resource_len >= REMOTEIO_MAX_RESOURCE) return -1;
+    if (op->op == REMOTEIO_OP_LOOKUP && resource_len == 0) return -1;
+    
+    op->completed = 0;
+    op->claimed = false;
+    op->status = GPUIO_SUCCESS;
+    op->bytes_transferred = 0;
+    op->resp_done = false;
+    op->num_sge = 0;
+    op->unsignaled = false;
+    op->batch = NULL;
+    
+    pthread_mutex_lock(&conn->lock);
+    op->zc_hold = op->op == REMOTEIO_OP_WRITE && conn->zc_enabled &&
+                  op->length >= REMOTEIO_ZEROCOPY_THRESHOLD;
+    bool compress = op->op == REMOTEIO_OP_WRITE && (conn->caps & REMOTEIO_CAP_LZ4) &&
+                    op->length >= REMOTEIO_COMPRESS_SAMPLE && !op->one_sided;
+    pthread_mutex_unlock(&conn->lock);
+    
+    /* Compressed chunks are staged here; they never go zero-copy */
+    uint8_t* packed = NULL;
+    if (compress) {
+        packed = malloc(op->length < REMOTEIO_PROTO_CHUNK ? op->length : REMOTEIO_PROTO_CHUNK);
+    }
+    
+    /* Register before sending so a fast response always finds the op */
+    pthread_mutex_lock(&proto->pending_lock);
+    proto_insert(proto, op);
+    pthread_mutex_unlock(&proto->pending_lock);
+    
+    pthread_mutex_lock(&conn->lock);
+    conn->reqs_submitted++;
+    pthread_mutex_unlock(&conn->lock);
+    
+    remoteio_msg_hdr_t hdr = {
+        .req_id = op->id,
+        .offset = proto_op_base(op),
+        .length = op->length,
+        .resource_len = (uint16_t)resource_len,
+        .rkey = op->rkey,
+    };
+    
+    int ret = 0;
+    if (op->one_sided && op->op == REMOTEIO_OP_READ) {
+        /* One request per chunk, so the peer serves each in one go */
+        size_t done = 0;
+        
+        hdr.type = REMOTEIO_MSG_RDMA_READ;
+        do {
+            size_t n = op->length - done;
+            if (n > REMOTEIO_PROTO_CHUNK) n = REMOTEIO_PROTO_CHUNK;
+            hdr.offset = op->raddr + done;
+            hdr.length = n;
+            hdr.flags = (done + n == op->length) ? REMOTEIO_MSG_F_LAST : 0;
+            ret = proto_send_frame(conn, &hdr, NULL, NULL, NULL);
+            done += n;
+        } while (ret == 0 && done < op->length);
+    } else if (op->op != REMOTEIO_OP_WRITE) {
+        hdr.type = op->op == REMOTEIO_OP_READ ? REMOTEIO_MSG_READ :
+                   op->op == REMOTEIO_OP_PING ? REMOTEIO_MSG_PING : REMOTEIO_MSG_LOOKUP;
+        hdr.flags = REMOTEIO_MSG_F_LAST;
+        ret = proto_send_frame(conn, &hdr, op->resource, NULL, NULL);
+    } else {
+        const char* src = proto_op_buf(op);
+        size_t done = 0;
+        int64_t zc_seq = -1;
+        
+        hdr.type = op->one_sided ? REMOTEIO_MSG_RDMA_WRITE : REMOTEIO_MSG_WRITE;
+        do {
+            size_t n = op->length - done;
+            if (n > REMOTEIO_PROTO_CHUNK) n = REMOTEIO_PROTO_CHUNK;
+            bool zerocopy = op->zc_hold && n >= REMOTEIO_ZEROCOPY_THRESHOLD;
+            size_t packed_len = packed ? remoteio_proto_compress(conn, src + done, n, packed) : 0;
+            
+            hdr.offset = proto_op_base(op) + done;
+            hdr.flags = (done + n == op->length) ? REMOTEIO_MSG_F_LAST : 0;
+            if (packed_len > 0) {
+                hdr.chunk_len = (uint32_t)packed_len;
+                hdr.flags |= REMOTEIO_MSG_F_COMPRESSED;
+                ret = proto_send_frame(conn, &hdr, op->resource, packed, NULL);
+            } else {
+                hdr.chunk_len = (uint32_t)n;
+                ret = proto_send_frame(conn, &hdr, op->resource, src + done,
+                                       zerocopy ? &zc_seq : NULL);
+            }
+            done += n;
+        } while (ret == 0 && done < op->length);
+        free(packed);
+        
+        if (op->zc_hold) {
+            /* The op completes only once the kernel lets go of its buffer */
+            if (zc_seq >= 0 && remoteio_network_zc_wait(conn, (uint32_t)zc_seq) != 0) {
+                ret = -1;
+            }
+            
+            pthread_mutex_lock(&proto->pending_lock);
+            op->zc_hold = false;
+            bool resp_done = op->resp_done;
+            pthread_mutex_unlock(&proto->pending_lock);
+            
+            if (resp_done) {
+                remoteio_op_complete(conn, op, ret == 0 ? op->resp_status : GPUIO_ERROR_NETWORK);
+                return 0;
+            }
+        }
+    }
+    
+    if (ret != 0) {
+        /* The reactor may already have failed the op; it completes then */
+        if (remoteio_proto_cancel(conn, op) != 0) return 0;
+        
+        pthread_mutex_lock(&conn->lock);
+        conn->reqs_failed++;
+        pthread_mutex_unlock(&conn->lock);
+        return -1;
+    }
+    
+    return 0;
+}
+
+/* Frames one piece of a chained op needs */
+static size_t proto_chain_frames(size_t len) {
+    return (len + REMOTEIO_PROTO_CHUNK - 1) / REMOTEIO_PROTO_CHUNK;
+}
+
+/**
+ * Send a prepared chain of one-sided ops (see remoteio_op_chain_prepare)
+ * as one batch of frames: a single writev per IOV_MAX pieces under one
+ * send lock hold, the software counterpart of a doorbell. Read frames
+ * stop at piece boundaries so every response lands in one piece.
+ * Unsignalled writes are only answered if refused. A chain longer than
+ * the server's credits allow goes out in several batches.
+ *
+ * Returns 0 once the ops are registered; every op then completes, as with
+ * remoteio_proto_submit(). Part of the chain may already be executing
+ * when a send fails, so the ops are not withdrawn: the stream is shut
+ * down and the reactor fails whatever is left. Returns -1, with no op
+ * sent, if the chain can't be framed.
+ */
+int remoteio_proto_submit_chain(remoteio_connection_t* conn, remoteio_operation_t* chain) {
+    if (!conn || !conn->proto || !chain) return -1;
+    
+    remoteio_proto_conn_t* proto = conn->proto;
+    size_t frames = 0;
+    int ops = 0;
+    int signaled = 0;
+    
+    for (remoteio_operation_t* op = chain; op; op = op->next_sg) {
+        if (!op->one_sided) return -1;
+        if (op->num_sge == 0) {
+            frames += proto_chain_frames(op->length);
+        } else {
+            for (int i = 0; i < op->num_sge; i++) {
+                frames += proto_chain_frames(op->sge[i].length);
+            }
+        }
+        ops++;
+        if (!op->unsignaled) signaled++;
+    }
+    
+    uint8_t (*raw)[REMOTEIO_MSG_HDR_SIZE] = malloc(frames * sizeof(*raw));
+    struct iovec* iov = malloc(frames * 2 * sizeof(struct iovec));
+    size_t* frame_end = malloc(frames * sizeof(size_t));    /* Past its last iovec */
+    if (!raw || !iov || !frame_end) {
+        free(raw);
+        free(iov);
+        free(frame_end);
+        return -1;
+    }
+    
+    size_t iovcnt = 0;
+    size_t f = 0;
+    for (remoteio_operation_t* op = chain; op; op = op->next_sg) {
+        bool write = op->op == REMOTEIO_OP_WRITE;
+        remoteio_msg_hdr_t hdr = {
+            .type = write ? REMOTEIO_MSG_RDMA_WRITE : REMOTEIO_MSG_RDMA_READ,
+            .req_id = op->id,
+            .rkey = op->rkey,
+        };
+        uint64_t rel = 0;
+        
+        op->zc_hold = false;
+        op->resp_done = false;
+        op->claimed = false;
+        while (rel < op->length) {
+            size_t n = 0;
+            char* src = proto_op_span(op, rel, &n);
+            if (n > REMOTEIO_PROTO_CHUNK) n = REMOTEIO_PROTO_CHUNK;
+            
+            hdr.offset = op->raddr + rel;
+            hdr.length = write ? op->length : n;
+            hdr.chunk_len = write ? (uint32_t)n : 0;
+            hdr.flags = rel + n == op->length ? REMOTEIO_MSG_F_LAST : 0;
+            if (write && op->unsignaled) hdr.flags |= REMOTEIO_MSG_F_UNSIGNALED;
+            
+            remoteio_msg_encode(&hdr, raw[f]);
+            iov[iovcnt].iov_base = raw[f++];
+            iov[iovcnt++].iov_len = REMOTEIO_MSG_HDR_SIZE;
+            if (write) {
+                iov[iovcnt].iov_base = src;
+                iov[iovcnt++].iov_len = n;
+            }
+            frame_end[f - 1] = iovcnt;
+            rel += n;
+        }
+    }
+    
+    /* Register before sending so a fast response always finds its op */
+    pthread_mutex_lock(&proto->pending_lock);
+    for (remoteio_operation_t* op = chain; op; op = op->next_sg) {
+        proto_insert(proto, op);
+    }
+    pthread_mutex_unlock(&proto->pending_lock);
+    
+    pthread_mutex_lock(&conn->lock);
+    conn->reqs_submitted += (uint64_t)ops;
+    conn->doorbells++;
+    conn->chained_wrs += (uint64_t)ops;
+    conn->signaled_wrs += (uint64_t)signaled;
+    pthread_mutex_unlock(&conn->lock);
+    
+    /* As many frames go out per batch as the credits cover; past that the
+     * rest waits for the server to free what's already sent */
+    int ret = 0;
+    size_t sent = 0;
+    f = 0;
+    pthread_mutex_lock(&proto->send_lock);
+    while (ret == 0 && sent < iovcnt) {
+        size_t ready = sent;
+        while (f < frames) {
+            uint32_t bytes = frame_end[f] - ready > 1 ? (uint32_t)iov[ready + 1].iov_len : 0;
+            int taken = proto_credit_take(conn, bytes, ready == sent);
+            if (taken < 0) ret = -1;
+            if (taken != 0) break;
+            ready = frame_end[f++];
+        }
+        
+        for (size_t i = sent; i < ready && ret == 0; i += IOV_MAX) {
+            size_t cnt = ready - i < IOV_MAX ? ready - i : IOV_MAX;
+            ret = remoteio_network_sendv(conn, iov + i, (int)cnt,
+                                         i + cnt < ready ? MSG_MORE : 0);
+        }
+        sent = ready;
+    }
+    pthread_mutex_unlock(&proto->send_lock);
+    
+    /* Part of the chain may already be executing; let the reactor fail it all */
+    if (ret != 0) remoteio_network_shutdown(conn);
+    
+    free(raw);
+    free(iov);
+    free(frame_end);
+    return 0;
+}
+
+/**
+ * Forget an outstanding op so late responses are discarded. Waits if the
+ * reactor is receiving a frame into the op's buffer. Returns -1 if the op was
+ * not pending: already completed, or claimed and still being completed.
+ */
+int remoteio_proto_cancel(remoteio_connection_t* conn, remoteio_operation_t* op) {
+    if (!conn || !conn->proto || !op) return -1;
+    
+    remoteio_proto_conn_t* proto = conn->proto;
+    
+    pthread_mutex_lock(&proto->pending_lock);
+    while (proto->rx_op == op) {
+        pthread_cond_wait(&proto->rx_cond, &proto->pending_lock);
+    }
+    int ret = proto_remove(proto, op);
+    pthread_mutex_unlock(&proto->pending_lock);
+    
+    return ret;
+}
+
+/**
+ * Round-trip a PING on an idle connection. Returns 0 if the peer answered
+ * within timeout_us.
+ */
+int remoteio_proto_ping(remoteio_context_t* ctx, remoteio_connection_t* conn,
+                        uint64_t timeout_us) {
+    if (!ctx || !conn || !conn->proto) return -1;
+    
+    remoteio_operation_t* op = remoteio_op_alloc(ctx);
+    if (!op) return -1;
+    
+    op->op = REMOTEIO_OP_PING;
+    op->conn = conn;
+    
+    int ret = remoteio_proto_submit(conn, op);
+    if (ret == 0) {
+        ret = remoteio_op_wait(op, timeout_us);
+    }
+    
+    /* Cancels the op if the reply never came */
+    remoteio_op_free(ctx, op);
+    return ret;
+}
+
+/**
+ * Resolve a region the peer advertised under name. Cached descriptors are
+ * used as long as the peer hasn't revoked them; otherwise the peer is
+ * asked. A caller whose one-sided op is refused with GPUIO_ERROR_PERMISSION
+ * should resolve again: the refusal already dropped the stale entry.
+ */
+int remoteio_proto_lookup(remoteio_context_t* ctx, remoteio_connection_t* conn,
+                          const char* name, remoteio_remote_mem_t* mem_out) {
+    if (!ctx || !conn || !conn->proto || !name || !mem_out) return -1;
+    if (name[0] == '\0' || strlen(name) >= REMOTEIO_MAX_RESOURCE) return -1;
+    
+    if (remoteio_region_cache_get(&ctx->region_cache, conn->peer_addr, conn->peer_port,
+                                  name, mem_out) == 0) {
+        return 0;
+    }
+    
+    remoteio_operation_t* op = remoteio_op_alloc(ctx);
+    if (!op) return -1;
+    
+    op->op = REMOTEIO_OP_LOOKUP;
+    op->conn = conn;
+    strcpy(op->resource, name);
+    
+    int ret = remoteio_proto_submit(conn, op);
+    if (ret == 0) {
+        ret = remoteio_op_wait(op, REMOTEIO_LOOKUP_TIMEOUT_US);
+    }
+    
+    if (ret == 0) {
+        memset(mem_out, 0, sizeof(*mem_out));
+        mem_out->raddr = op->raddr;
+        mem_out->rkey = op->rkey;
+        mem_out->length = op->length;
+        strcpy(mem_out->peer_addr, conn->peer_addr);
+        mem_out->peer_port = conn->peer_port;
+    }
+    
+    remoteio_op_free(ctx, op);
+    return ret;
+}
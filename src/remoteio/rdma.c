@@ -19,6 +19,7 @@
 #define RDMA_MAX_RECV_WR      128
 #define RDMA_MAX_SGE          4
 #define RDMA_INLINE_THRESHOLD 256
+#define RDMA_POLL_BATCH       64     /* Work completions reaped per ibv_poll_cq */
 
 /* Internal RDMA context */
 typedef struct remoteio_rdma_ctx {
@@ -26,7 +27,7 @@ typedef struct remoteio_rdma_ctx {
     struct ibv_context* ib_ctx;
     struct ibv_pd* pd;
     int num_devices;
-    struct ibv_device** device_list;
+    struct ibv_context** device_list;
     pthread_mutex_t lock;
 } remoteio_rdma_ctx_t;
 
@@ -52,33 +53,18 @@ int remoteio_rdma_init(remoteio_context_t* ctx) {
     
     pthread_mutex_init(&rdma_ctx->lock, NULL);
     
-    /* Get list of RDMA devices */
+    /* librdmacm hands out every device already opened; use the first */
     rdma_ctx->device_list = rdma_get_devices(&rdma_ctx->num_devices);
     if (!rdma_ctx->device_list || rdma_ctx->num_devices == 0) {
+        if (rdma_ctx->device_list) rdma_free_devices(rdma_ctx->device_list);
         free(rdma_ctx);
         return -1;
     }
-    
-    /* Open first device that supports verbs */
-    rdma_ctx->ib_ctx = NULL;
-    for (int i = 0; i < rdma_ctx->num_devices; i++) {
-        struct ibv_context* test_ctx = ibv_open_device(rdma_ctx->device_list[i]);
-        if (test_ctx) {
-            rdma_ctx->ib_ctx = test_ctx;
-            break;
-        }
-    }
-    
-    if (!rdma_ctx->ib_ctx) {
-        rdma_free_devices(rdma_ctx->device_list);
-        free(rdma_ctx);
-        return -1;
-    }
+    rdma_ctx->ib_ctx = rdma_ctx->device_list[0];
     
     /* Create protection domain */
     rdma_ctx->pd = ibv_alloc_pd(rdma_ctx->ib_ctx);
     if (!rdma_ctx->pd) {
-        ibv_close_device(rdma_ctx->ib_ctx);
         rdma_free_devices(rdma_ctx->device_list);
         free(rdma_ctx);
         return -1;
@@ -88,7 +74,6 @@ int remoteio_rdma_init(remoteio_context_t* ctx) {
     rdma_ctx->cm_channel = rdma_create_event_channel();
     if (!rdma_ctx->cm_channel) {
         ibv_dealloc_pd(rdma_ctx->pd);
-        ibv_close_device(rdma_ctx->ib_ctx);
         rdma_free_devices(rdma_ctx->device_list);
         free(rdma_ctx);
         return -1;
@@ -113,10 +98,6 @@ void remoteio_rdma_cleanup(remoteio_context_t* ctx) {
         ibv_dealloc_pd(rdma_ctx->pd);
     }
     
-    if (rdma_ctx->ib_ctx) {
-        ibv_close_device(rdma_ctx->ib_ctx);
-    }
-    
     if (rdma_ctx->device_list) {
         rdma_free_devices(rdma_ctx->device_list);
     }
@@ -180,7 +161,7 @@ void remoteio_rdma_endpoint_destroy(remoteio_rdma_endpoint_t* ep) {
     free(ep);
 }
 
-static int rdma_create_qp(remoteio_rdma_endpoint_t* ep) {
+static int rdma_ep_create_qp(remoteio_rdma_endpoint_t* ep) {
     if (!ep || !ep->pd) return -1;
     
     struct ibv_qp_init_attr qp_attr = {
@@ -270,7 +251,7 @@ int remoteio_rdma_connect(remoteio_context_t* ctx, remoteio_connection_t* conn,
     rdma_ack_cm_event(event);
     
     /* Create QP */
-    if (rdma_create_qp(ep) != 0) {
+    if (rdma_ep_create_qp(ep) != 0) {
         remoteio_rdma_endpoint_destroy(ep);
         return -1;
     }
@@ -338,6 +319,26 @@ int remoteio_rdma_disconnect(remoteio_connection_t* conn) {
     return 0;
 }
 
+/**
+ * Move the queue pair to the error state: every WR still on it completes
+ * with a flush error, after which the NIC no longer touches its buffers.
+ * The connection is failed.
+ */
+int remoteio_rdma_flush(remoteio_connection_t* conn) {
+    if (!conn || !conn->rdma_ep || !conn->rdma_ep->qp) return -1;
+    
+    struct ibv_qp_attr attr = { .qp_state = IBV_QPS_ERR };
+    if (ibv_modify_qp((struct ibv_qp*)conn->rdma_ep->qp, &attr, IBV_QP_STATE)) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&conn->lock);
+    conn->state = REMOTEIO_CONN_ERROR;
+    pthread_cond_broadcast(&conn->state_cond);
+    pthread_mutex_unlock(&conn->lock);
+    return 0;
+}
+
 int remoteio_rdma_post_read(remoteio_connection_t* conn,
                             remoteio_gdr_region_t* local_mr,
                             remoteio_remote_mem_t* remote,
@@ -371,6 +372,8 @@ int remoteio_rdma_post_read(remoteio_connection_t* conn,
     
     /* Post send */
     struct ibv_send_wr* bad_wr;
+    op->batch = NULL;
+    op->unsignaled = false;
     if (ibv_post_send((struct ibv_qp*)ep->qp, &wr, &bad_wr)) {
         return -1;
     }
@@ -421,6 +424,8 @@ int remoteio_rdma_post_write(remoteio_connection_t* conn,
     
     /* Post send */
     struct ibv_send_wr* bad_wr;
+    op->batch = NULL;
+    op->unsignaled = false;
     if (ibv_post_send((struct ibv_qp*)ep->qp, &wr, &bad_wr)) {
         return -1;
     }
@@ -432,42 +437,177 @@ int remoteio_rdma_post_write(remoteio_connection_t* conn,
     return 0;
 }
 
+/**
+ * Post a chain of one-sided ops linked by next_sg as a linked list of work
+ * requests with a single ibv_post_send. Only the batch-ending WRs are
+ * signalled (see remoteio_op_chain_prepare); the send queue completes in
+ * order, so their completion covers the unsignalled WRs before them.
+ * Unsignalled WRs carry wr_id 0: one that fails still produces a
+ * completion, which is dropped, and the error reaches its batch through
+ * the flushed signalled WR; the whole batch then fails.
+ *
+ * If the post fails part way, the WRs before bad_wr are on the send queue
+ * and complete as usual; a signalled copy of the last of them closes the
+ * batch it cut short. The ops from bad_wr on complete at once with the
+ * post's error, ahead of the posted ones. Returns the number of ops
+ * posted, or -1 if none were.
+ */
+int remoteio_rdma_post_chain(remoteio_connection_t* conn, remoteio_operation_t* chain,
+                             int signal_every) {
+    if (!conn || !chain || chain->conn != conn) return -1;
+    if (conn->state != REMOTEIO_CONN_CONNECTED) return -1;
+    
+    remoteio_rdma_endpoint_t* ep = conn->rdma_ep;
+    if (!ep || !ep->qp) return -1;
+    
+    int count = remoteio_op_chain_prepare(chain, signal_every);
+    if (count < 0) return -1;
+    
+    struct ibv_send_wr* wrs = calloc((size_t)count, sizeof(struct ibv_send_wr));
+    struct ibv_sge* sges = calloc((size_t)count * REMOTEIO_CHAIN_MAX_SGE, sizeof(struct ibv_sge));
+    remoteio_operation_t** ops = calloc((size_t)count, sizeof(remoteio_operation_t*));
+    if (!wrs || !sges || !ops) {
+        free(wrs);
+        free(sges);
+        free(ops);
+        return -1;
+    }
+    
+    int i = 0;
+    int signaled = 0;
+    for (remoteio_operation_t* op = chain; op; op = op->next_sg, i++) {
+        struct ibv_sge* sge = &sges[i * REMOTEIO_CHAIN_MAX_SGE];
+        int num_sge = op->num_sge;
+        
+        if (num_sge == 0) {
+            sge[0].addr = (uint64_t)op->local_gdr->gpu_ptr + op->local_offset;
+            sge[0].length = (uint32_t)op->length;
+            sge[0].lkey = op->local_gdr->lkey;
+            num_sge = 1;
+        } else {
+            for (int j = 0; j < num_sge; j++) {
+                sge[j].addr = (uint64_t)op->sge[j].mr->gpu_ptr + op->sge[j].offset;
+                sge[j].length = op->sge[j].length;
+                sge[j].lkey = op->sge[j].mr->lkey;
+            }
+        }
+        
+        bool write = op->op == REMOTEIO_OP_WRITE;
+        int send_flags = op->unsignaled ? 0 : IBV_SEND_SIGNALED;
+        if (write && op->length <= RDMA_INLINE_THRESHOLD) {
+            send_flags |= IBV_SEND_INLINE;
+        }
+        if (!op->unsignaled) signaled++;
+        
+        ops[i] = op;
+        wrs[i].wr_id = op->unsignaled ? 0 : (uint64_t)op;
+        wrs[i].next = op->next_sg ? &wrs[i + 1] : NULL;
+        wrs[i].opcode = write ? IBV_WR_RDMA_WRITE : IBV_WR_RDMA_READ;
+        wrs[i].send_flags = send_flags;
+        wrs[i].num_sge = num_sge;
+        wrs[i].sg_list = sge;
+        wrs[i].wr.rdma.remote_addr = op->remote_mem->raddr + op->remote_offset;
+        wrs[i].wr.rdma.rkey = op->remote_mem->rkey;
+    }
+    
+    /* One doorbell for the whole chain. Posted ops may complete, and be
+     * freed, as soon as it rings. */
+    struct ibv_send_wr* bad_wr = NULL;
+    int posted = count;
+    int doorbells = 1;
+    int err = ibv_post_send((struct ibv_qp*)ep->qp, wrs, &bad_wr);
+    if (err) posted = bad_wr ? (int)(bad_wr - wrs) : 0;
+    gpuio_error_t status = rdma_error_to_gpuio(err);
+    for (i = posted; i < count; i++) {
+        if (wrs[i].send_flags & IBV_SEND_SIGNALED) signaled--;
+    }
+    
+    if (posted > 0 && posted < count && !(wrs[posted - 1].send_flags & IBV_SEND_SIGNALED)) {
+        /* Nothing posted signals the batch the failure cut short, so its
+         * ops are still ours. One-sided ops are idempotent: post the last
+         * of them again, signalled. */
+        remoteio_operation_t* last = ops[posted - 1];
+        struct ibv_send_wr wr = wrs[posted - 1];
+        wr.next = NULL;
+        wr.wr_id = (uint64_t)last;
+        wr.send_flags |= IBV_SEND_SIGNALED;
+        last->unsignaled = false;
+        if (ibv_post_send((struct ibv_qp*)ep->qp, &wr, &bad_wr) == 0) {
+            doorbells++;
+            signaled++;
+        } else {
+            /* Flush the queue so none of it keeps running, and fail the batch */
+            remoteio_rdma_flush(conn);
+            for (remoteio_operation_t* m = last->batch; m != last; m = m->next_sg) {
+                m->status = status;
+            }
+            remoteio_op_complete_batch(conn, last, status);
+        }
+    }
+    free(wrs);
+    free(sges);
+    
+    if (posted > 0) {
+        pthread_mutex_lock(&conn->lock);
+        conn->reqs_submitted += (uint64_t)posted;
+        conn->doorbells += (uint64_t)doorbells;
+        conn->chained_wrs += (uint64_t)posted;
+        conn->signaled_wrs += (uint64_t)signaled;
+        pthread_mutex_unlock(&conn->lock);
+        
+        /* The rest never reached the send queue */
+        for (i = posted; i < count; i++) {
+            remoteio_op_complete(conn, ops[i], status);
+        }
+    }
+    free(ops);
+    
+    return posted > 0 ? posted : -1;
+}
+
+/* Reap up to max_poll work completions, RDMA_POLL_BATCH per poll. A
+ * signalled WR of a chain completes its whole batch. */
 int remoteio_rdma_poll_completions(remoteio_connection_t* conn, int max_poll) {
     if (!conn || !conn->rdma_ep) return -1;
     
     remoteio_rdma_endpoint_t* ep = conn->rdma_ep;
     if (!ep->cq) return -1;
     
-    struct ibv_wc wc[16];
+    struct ibv_wc wc[RDMA_POLL_BATCH];
     int polled = 0;
     
     while (polled < max_poll) {
-        int n = ibv_poll_cq((struct ibv_cq*)ep->cq, 16, wc);
+        int want = max_poll - polled < RDMA_POLL_BATCH ? max_poll - polled : RDMA_POLL_BATCH;
+        int n = ibv_poll_cq((struct ibv_cq*)ep->cq, want, wc);
         if (n <= 0) break;
         
         for (int i = 0; i < n; i++) {
             remoteio_operation_t* op = (remoteio_operation_t*)wc[i].wr_id;
             if (!op) continue;
             
-            if (wc[i].status == IBV_WC_SUCCESS) {
-                op->status = GPUIO_SUCCESS;
-                op->bytes_transferred = wc[i].byte_len;
-            } else {
-                op->status = GPUIO_ERROR_IO;
+            gpuio_error_t status = wc[i].status == IBV_WC_SUCCESS ?
+                                   GPUIO_SUCCESS : GPUIO_ERROR_IO;
+            if (op->batch) {
+                /* Which unsignalled WRs ran before a failure is unknown */
+                for (remoteio_operation_t* m = op->batch; m != op && status != GPUIO_SUCCESS;
+                     m = m->next_sg) {
+                    m->status = status;
+                }
+                remoteio_op_complete_batch(conn, op, status);
+                continue;
             }
-            op->completed = 1;
-            
-            /* Invoke callback if provided */
-            if (op->callback) {
-                op->callback((gpuio_request_t)op, op->status, op->user_data);
+            if (status == GPUIO_SUCCESS) {
+                /* byte_len is only defined for reads, atomics and receives;
+                 * a successful write or send moved the whole WR */
+                op->bytes_transferred = (wc[i].opcode == IBV_WC_RDMA_WRITE ||
+                                         wc[i].opcode == IBV_WC_SEND) ?
+                                        op->length : wc[i].byte_len;
             }
-            
-            pthread_mutex_lock(&conn->lock);
-            conn->reqs_completed++;
-            pthread_mutex_unlock(&conn->lock);
+            remoteio_op_complete(conn, op, status);
         }
         
         polled += n;
+        if (n < want) break;
     }
     
     return polled;
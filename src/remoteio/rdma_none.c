@@ -0,0 +1,140 @@
+/**
+ * @file rdma_none.c
+ * @brief RemoteIO module - RDMA transport for builds without ibverbs
+ * @version 1.0.0
+ *
+ * Built in place of rdma.c when ibverbs/rdmacm aren't available. Every
+ * entry point fails the way rdma.c does on a machine without an RDMA
+ * device, so contexts come up without rdma_ctx, RDMA connects fall back
+ * to TCP and one-sided ops take the soft path in softrdma.c.
+ */
+
+#include "remoteio_internal.h"
+#include <stdlib.h>
+
+int remoteio_rdma_init(remoteio_context_t* ctx) {
+    (void)ctx;
+    return -1;
+}
+
+void remoteio_rdma_cleanup(remoteio_context_t* ctx) {
+    (void)ctx;
+}
+
+int remoteio_rdma_endpoint_create(remoteio_context_t* ctx,
+                                  remoteio_rdma_endpoint_t** ep_out) {
+    (void)ctx;
+    (void)ep_out;
+    return -1;
+}
+
+void remoteio_rdma_endpoint_destroy(remoteio_rdma_endpoint_t* ep) {
+    (void)ep;
+}
+
+int remoteio_rdma_connect(remoteio_context_t* ctx, remoteio_connection_t* conn,
+                          const char* addr, uint16_t port) {
+    (void)ctx;
+    (void)conn;
+    (void)addr;
+    (void)port;
+    return -1;
+}
+
+int remoteio_rdma_accept(remoteio_context_t* ctx, remoteio_connection_t* conn) {
+    (void)ctx;
+    (void)conn;
+    return -1;
+}
+
+int remoteio_rdma_disconnect(remoteio_connection_t* conn) {
+    (void)conn;
+    return -1;
+}
+
+int remoteio_rdma_flush(remoteio_connection_t* conn) {
+    (void)conn;
+    return -1;
+}
+
+int remoteio_rdma_post_send(remoteio_connection_t* conn, void* buf, size_t len,
+                            remoteio_operation_t* op) {
+    (void)conn;
+    (void)buf;
+    (void)len;
+    (void)op;
+    return -1;
+}
+
+int remoteio_rdma_post_recv(remoteio_connection_t* conn, void* buf, size_t len,
+                            remoteio_operation_t* op) {
+    (void)conn;
+    (void)buf;
+    (void)len;
+    (void)op;
+    return -1;
+}
+
+int remoteio_rdma_post_read(remoteio_connection_t* conn,
+                            remoteio_gdr_region_t* local_mr,
+                            remoteio_remote_mem_t* remote,
+                            uint64_t local_offset, uint64_t remote_offset,
+                            size_t len, remoteio_operation_t* op) {
+    (void)conn;
+    (void)local_mr;
+    (void)remote;
+    (void)local_offset;
+    (void)remote_offset;
+    (void)len;
+    (void)op;
+    return -1;
+}
+
+int remoteio_rdma_post_write(remoteio_connection_t* conn,
+                             remoteio_gdr_region_t* local_mr,
+                             remoteio_remote_mem_t* remote,
+                             uint64_t local_offset, uint64_t remote_offset,
+                             size_t len, remoteio_operation_t* op) {
+    (void)conn;
+    (void)local_mr;
+    (void)remote;
+    (void)local_offset;
+    (void)remote_offset;
+    (void)len;
+    (void)op;
+    return -1;
+}
+
+int remoteio_rdma_post_chain(remoteio_connection_t* conn, remoteio_operation_t* chain,
+                             int signal_every) {
+    (void)conn;
+    (void)chain;
+    (void)signal_every;
+    return -1;
+}
+
+int remoteio_rdma_poll_completions(remoteio_connection_t* conn, int max_poll) {
+    (void)conn;
+    (void)max_poll;
+    return 0;
+}
+
+int remoteio_rdma_register_gpu_memory(remoteio_context_t* ctx,
+                                      void* gpu_ptr, size_t length,
+                                      int gpu_id,
+                                      remoteio_gdr_region_t** region_out) {
+    (void)ctx;
+    (void)gpu_ptr;
+    (void)length;
+    (void)gpu_id;
+    (void)region_out;
+    return -1;
+}
+
+/* Soft regions are released through here too; they carry no MR */
+int remoteio_rdma_unregister_gpu_memory(remoteio_gdr_region_t* region) {
+    if (!region) return -1;
+    
+    free(region);
+    return 0;
+}
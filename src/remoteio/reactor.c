@@ -0,0 +1,270 @@
+/**
+ * @file reactor.c
+ * @brief RemoteIO module - Completion reactor
+ * @version 1.0.0
+ *
+ * One thread per context completes every op. TCP connections register
+ * their sockets with an epoll set (shared-memory ones the fd that wakes
+ * their reader) and the reactor runs the protocol's response parser
+ * whenever one turns readable; RDMA endpoints register too and have
+ * their completion queues polled between waits. Ops are
+ * completed through remoteio_op_complete, which wakes only the thread
+ * waiting on that op.
+ *
+ * A connection stays registered until it is destroyed. The reactor takes
+ * a reference while servicing one, so destruction never races with it.
+ */
+
+#include "remoteio_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#define REACTOR_INITIAL_CONNS  16
+
+/* Called with the reactor lock held */
+static int reactor_find(remoteio_reactor_t* reactor, remoteio_connection_t* conn) {
+    for (int i = 0; i < reactor->num_conns; i++) {
+        if (reactor->conns[i] == conn) return i;
+    }
+    return -1;
+}
+
+/* Reference a registered connection for servicing; false if it's gone or
+ * already on its way out. Called with the reactor lock held. */
+static bool reactor_claim(remoteio_reactor_t* reactor, remoteio_connection_t* conn) {
+    if (reactor_find(reactor, conn) < 0) return false;
+    
+    pthread_mutex_lock(&conn->lock);
+    bool live = conn->ref_count > 0;
+    if (live) conn->ref_count++;
+    pthread_mutex_unlock(&conn->lock);
+    
+    return live;
+}
+
+/*
+ * Service a readable socket. EPOLLERR is level-triggered too and also
+ * signals zero-copy completions, so the error queue is drained first.
+ */
+static void reactor_rx(remoteio_reactor_t* reactor, remoteio_connection_t* conn,
+                       uint32_t events) {
+    pthread_mutex_lock(&reactor->lock);
+    bool claimed = reactor_claim(reactor, conn);
+    if (claimed) reactor->rx_events++;
+    pthread_mutex_unlock(&reactor->lock);
+    
+    if (!claimed) return;
+    
+    if ((events & EPOLLERR) && !conn->shm) remoteio_network_zc_drain(conn);
+    
+    if (remoteio_proto_rx_ready(conn) != 0) {
+        /* Stop watching a dead stream before failing what's on it */
+        pthread_mutex_lock(&reactor->lock);
+        epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, remoteio_network_poll_fd(conn), NULL);
+        reactor->conn_failures++;
+        pthread_mutex_unlock(&reactor->lock);
+        
+        remoteio_proto_rx_fail(conn);
+    }
+    
+    remoteio_conn_release(conn);
+}
+
+/* Reap completions of every registered RDMA endpoint */
+static void reactor_poll_cqs(remoteio_reactor_t* reactor) {
+    int i = 0;
+    
+    for (;;) {
+        remoteio_connection_t* conn = NULL;
+        
+        pthread_mutex_lock(&reactor->lock);
+        for (; i < reactor->num_conns && reactor->num_rdma > 0; i++) {
+            if (reactor->conns[i]->transport == REMOTEIO_TRANSPORT_RDMA &&
+                reactor_claim(reactor, reactor->conns[i])) {
+                conn = reactor->conns[i++];
+                reactor->cq_polls++;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&reactor->lock);
+        
+        if (!conn) break;
+        
+        remoteio_rdma_poll_completions(conn, REMOTEIO_REACTOR_CQ_BATCH);
+        remoteio_conn_release(conn);
+    }
+}
+
+static void* reactor_thread(void* arg) {
+    remoteio_context_t* ctx = (remoteio_context_t*)arg;
+    remoteio_reactor_t* reactor = &ctx->reactor;
+    struct epoll_event events[REMOTEIO_REACTOR_EVENTS];
+    
+    while (__atomic_load_n(&ctx->completion_running, __ATOMIC_ACQUIRE)) {
+        /* CQs have no fd here; poll them on a short timeout instead */
+        pthread_mutex_lock(&reactor->lock);
+        int timeout = reactor->num_rdma > 0 ? REMOTEIO_REACTOR_CQ_POLL_MS : -1;
+        pthread_mutex_unlock(&reactor->lock);
+        
+        int n = epoll_wait(reactor->epoll_fd, events, REMOTEIO_REACTOR_EVENTS, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        
+        pthread_mutex_lock(&reactor->lock);
+        reactor->wakeups++;
+        pthread_mutex_unlock(&reactor->lock);
+        
+        for (int i = 0; i < n; i++) {
+            remoteio_connection_t* conn = (remoteio_connection_t*)events[i].data.ptr;
+            
+            if (!conn) {
+                uint64_t count;
+                if (read(reactor->wake_fd, &count, sizeof(count)) < 0) {
+                    /* Nothing pending */
+                }
+                continue;
+            }
+            reactor_rx(reactor, conn, events[i].events);
+        }
+        
+        reactor_poll_cqs(reactor);
+    }
+    
+    return NULL;
+}
+
+static void reactor_wake(remoteio_reactor_t* reactor) {
+    uint64_t one = 1;
+    if (write(reactor->wake_fd, &one, sizeof(one)) < 0) {
+        /* Counter saturated: a wakeup is pending anyway */
+    }
+}
+
+int remoteio_reactor_start(remoteio_context_t* ctx) {
+    if (!ctx) return -1;
+    
+    remoteio_reactor_t* reactor = &ctx->reactor;
+    
+    memset(reactor, 0, sizeof(*reactor));
+    reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    reactor->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+    if (reactor->epoll_fd < 0 || reactor->wake_fd < 0 ||
+        epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, reactor->wake_fd, &ev) != 0) {
+        goto fail;
+    }
+    
+    pthread_mutex_init(&reactor->lock, NULL);
+    
+    ctx->completion_running = 1;
+    if (pthread_create(&ctx->completion_thread, NULL, reactor_thread, ctx) != 0) {
+        ctx->completion_running = 0;
+        pthread_mutex_destroy(&reactor->lock);
+        goto fail;
+    }
+    
+    return 0;
+
+fail:
+    if (reactor->epoll_fd >= 0) close(reactor->epoll_fd);
+    if (reactor->wake_fd >= 0) close(reactor->wake_fd);
+    reactor->epoll_fd = -1;
+    reactor->wake_fd = -1;
+    return -1;
+}
+
+/* Stop the reactor thread. Ops still outstanding never complete, so
+ * connections should be gone first. */
+void remoteio_reactor_stop(remoteio_context_t* ctx) {
+    if (!ctx || !ctx->completion_running) return;
+    
+    remoteio_reactor_t* reactor = &ctx->reactor;
+    
+    __atomic_store_n(&ctx->completion_running, 0, __ATOMIC_RELEASE);
+    reactor_wake(reactor);
+    pthread_join(ctx->completion_thread, NULL);
+    
+    /* Connections the caller leaked must not point at freed state */
+    for (int i = 0; i < reactor->num_conns; i++) {
+        reactor->conns[i]->reactor = NULL;
+    }
+    
+    close(reactor->epoll_fd);
+    close(reactor->wake_fd);
+    free(reactor->conns);
+    pthread_mutex_destroy(&reactor->lock);
+    memset(reactor, 0, sizeof(*reactor));
+    reactor->epoll_fd = -1;
+    reactor->wake_fd = -1;
+}
+
+/**
+ * Have the reactor complete the connection's ops: TCP connections need
+ * their protocol attached, RDMA ones a connected endpoint.
+ */
+int remoteio_reactor_add(remoteio_reactor_t* reactor, remoteio_connection_t* conn) {
+    if (!reactor || !conn || conn->reactor) return -1;
+    
+    bool rdma = conn->transport == REMOTEIO_TRANSPORT_RDMA;
+    if (rdma ? !conn->rdma_ep : !conn->proto) return -1;
+    
+    pthread_mutex_lock(&reactor->lock);
+    
+    if (reactor->num_conns == reactor->max_conns) {
+        int max = reactor->max_conns ? reactor->max_conns * 2 : REACTOR_INITIAL_CONNS;
+        remoteio_connection_t** conns = realloc(reactor->conns, (size_t)max * sizeof(*conns));
+        if (!conns) {
+            pthread_mutex_unlock(&reactor->lock);
+            return -1;
+        }
+        reactor->conns = conns;
+        reactor->max_conns = max;
+    }
+    
+    if (rdma) {
+        reactor->num_rdma++;
+    } else {
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = conn };
+        if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, remoteio_network_poll_fd(conn),
+                      &ev) != 0) {
+            pthread_mutex_unlock(&reactor->lock);
+            return -1;
+        }
+    }
+    reactor->conns[reactor->num_conns++] = conn;
+    conn->reactor = reactor;
+    
+    pthread_mutex_unlock(&reactor->lock);
+    
+    /* An idle reactor blocks indefinitely until it has CQs to poll */
+    if (rdma) reactor_wake(reactor);
+    
+    return 0;
+}
+
+/* Stop servicing a connection; it is never touched by the reactor again */
+void remoteio_reactor_remove(remoteio_reactor_t* reactor, remoteio_connection_t* conn) {
+    if (!reactor || !conn) return;
+    
+    pthread_mutex_lock(&reactor->lock);
+    
+    int i = reactor_find(reactor, conn);
+    if (i >= 0) {
+        if (conn->transport == REMOTEIO_TRANSPORT_RDMA) {
+            reactor->num_rdma--;
+        } else {
+            epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, remoteio_network_poll_fd(conn), NULL);
+        }
+        reactor->conns[i] = reactor->conns[--reactor->num_conns];
+    }
+    conn->reactor = NULL;
+    
+    pthread_mutex_unlock(&reactor->lock);
+}
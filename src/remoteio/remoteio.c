@@ -44,18 +44,45 @@ remoteio_context_t* remoteio_context_create(gpuio_context_t parent) {
     ctx->inline_threshold = REMOTEIO_INLINE_THRESHOLD;
     
     /* Initialize locks */
-    pthread_mutex_init(&ctx->conn_pool.lock, NULL);
     pthread_mutex_init(&ctx->gdr_lock, NULL);
     pthread_mutex_init(&ctx->ops_lock, NULL);
     pthread_mutex_init(&ctx->stats_lock, NULL);
     pthread_cond_init(&ctx->ops_cond, NULL);
-    
-    /* Initialize connection pool */
-    if (remoteio_conn_pool_init(&ctx->conn_pool, REMOTEIO_MAX_CONNECTIONS) != 0) {
+    remoteio_region_cache_init(&ctx->region_cache);
+    remoteio_route_table_init(&ctx->routes);
+    
+    /* Preallocate ops and start completing them; the pool's health checks
+     * already need both */
+    if (remoteio_op_slab_init(ctx, REMOTEIO_MAX_PENDING_OPS) != 0 ||
+        remoteio_reactor_start(ctx) != 0) {
+        remoteio_op_slab_cleanup(ctx);
+        pthread_mutex_destroy(&ctx->gdr_lock);
+        pthread_mutex_destroy(&ctx->ops_lock);
+        pthread_mutex_destroy(&ctx->stats_lock);
+        pthread_cond_destroy(&ctx->ops_cond);
+        remoteio_region_cache_cleanup(&ctx->region_cache);
+        remoteio_route_table_cleanup(&ctx->routes);
+        free(ctx);
+        return NULL;
+    }
+    if (remoteio_conn_pool_init(&ctx->conn_pool, ctx, REMOTEIO_MAX_CONNECTIONS) != 0) {
+        remoteio_reactor_stop(ctx);
+        remoteio_op_slab_cleanup(ctx);
+        pthread_mutex_destroy(&ctx->gdr_lock);
+        pthread_mutex_destroy(&ctx->ops_lock);
+        pthread_mutex_destroy(&ctx->stats_lock);
+        pthread_cond_destroy(&ctx->ops_cond);
+        remoteio_region_cache_cleanup(&ctx->region_cache);
+        remoteio_route_table_cleanup(&ctx->routes);
         free(ctx);
         return NULL;
     }
     
+    /* Wire compression is optional; without a codec it's never offered */
+    if (gpuio_codec_create(parent, GPUIO_CODEC_LZ4, 1, &ctx->codec) != GPUIO_SUCCESS) {
+        ctx->codec = NULL;
+    }
+    
     /* Initialize RDMA subsystem */
     if (remoteio_rdma_init(ctx) != 0) {
         ctx->use_gdr = 0;
@@ -64,12 +91,16 @@ remoteio_context_t* remoteio_context_create(gpuio_context_t parent) {
     
     /* Initialize network layer */
     if (remoteio_network_init(ctx) != 0) {
+        if (ctx->codec) gpuio_codec_destroy(ctx->codec);
         remoteio_conn_pool_cleanup(&ctx->conn_pool);
-        pthread_mutex_destroy(&ctx->conn_pool.lock);
+        remoteio_reactor_stop(ctx);
+        remoteio_op_slab_cleanup(ctx);
         pthread_mutex_destroy(&ctx->gdr_lock);
         pthread_mutex_destroy(&ctx->ops_lock);
         pthread_mutex_destroy(&ctx->stats_lock);
         pthread_cond_destroy(&ctx->ops_cond);
+        remoteio_region_cache_cleanup(&ctx->region_cache);
+        remoteio_route_table_cleanup(&ctx->routes);
         free(ctx);
         return NULL;
     }
@@ -80,12 +111,8 @@ remoteio_context_t* remoteio_context_create(gpuio_context_t parent) {
 void remoteio_context_destroy(remoteio_context_t* ctx) {
     if (!ctx) return;
     
-    /* Stop completion thread */
-    ctx->completion_running = 0;
-    if (ctx->completion_thread) {
-        pthread_cond_broadcast(&ctx->ops_cond);
-        pthread_join(ctx->completion_thread, NULL);
-    }
+    /* Route probes use everything below */
+    remoteio_route_table_stop(&ctx->routes);
     
     /* Cleanup network layer */
     remoteio_network_cleanup(ctx);
@@ -99,8 +126,15 @@ void remoteio_context_destroy(remoteio_context_t* ctx) {
         ctx->listener = NULL;
     }
     
-    /* Cleanup connection pool */
+    /* Cleanup connection pool; its thread was the last to probe routes */
     remoteio_conn_pool_cleanup(&ctx->conn_pool);
+    remoteio_route_table_cleanup(&ctx->routes);
+    
+    /* Stop the reactor; health-check pings needed it until now */
+    remoteio_reactor_stop(ctx);
+    
+    /* Nothing fills the region cache any more */
+    remoteio_region_cache_cleanup(&ctx->region_cache);
     
     /* Cleanup GDR regions */
     pthread_mutex_lock(&ctx->gdr_lock);
@@ -112,24 +146,13 @@ void remoteio_context_destroy(remoteio_context_t* ctx) {
     }
     pthread_mutex_unlock(&ctx->gdr_lock);
     
-    /* Cleanup pending operations */
-    pthread_mutex_lock(&ctx->ops_lock);
-    remoteio_operation_t* op = ctx->pending_ops;
-    while (op) {
-        remoteio_operation_t* next = op->next;
-        free(op);
-        op = next;
-    }
-    op = ctx->free_ops;
-    while (op) {
-        remoteio_operation_t* next = op->next;
-        free(op);
-        op = next;
-    }
-    pthread_mutex_unlock(&ctx->ops_lock);
+    /* Connections borrowed the codec; they're gone now */
+    if (ctx->codec) gpuio_codec_destroy(ctx->codec);
+    
+    /* Release the op slab */
+    remoteio_op_slab_cleanup(ctx);
     
     /* Destroy locks */
-    pthread_mutex_destroy(&ctx->conn_pool.lock);
     pthread_mutex_destroy(&ctx->gdr_lock);
     pthread_mutex_destroy(&ctx->ops_lock);
     pthread_mutex_destroy(&ctx->stats_lock);
@@ -140,10 +163,95 @@ void remoteio_context_destroy(remoteio_context_t* ctx) {
 
 int remoteio_connect(remoteio_context_t* ctx, const char* addr, uint16_t port,
                      remoteio_connection_t** conn_out) {
+    return remoteio_connect_stream(ctx, addr, port, 0, conn_out);
+}
+
+/*
+ * Get a connection over the given transport, when the peer's route or the
+ * preference picked it. Where RDMA or shared memory can't reach the peer,
+ * the framed stream stands in: that's a TCP fallback, and under AUTO a
+ * reason to probe the route again. In place of shared memory it is
+ * labelled soft RDMA, so it carries one-sided ops as the rings would.
+ */
+static int connect_picked(remoteio_context_t* ctx, const char* addr, uint16_t port,
+                          int stream, remoteio_transport_t transport,
+                          remoteio_connection_t** conn_out) {
+    bool may_fall_back = transport == REMOTEIO_TRANSPORT_RDMA ||
+                         transport == REMOTEIO_TRANSPORT_SHM;
+    remoteio_transport_t fallback = transport == REMOTEIO_TRANSPORT_SHM ?
+                                    REMOTEIO_TRANSPORT_SOFT_RDMA : REMOTEIO_TRANSPORT_TCP;
+    
+    if (may_fall_back) {
+        remoteio_connection_t* conn = remoteio_conn_pool_get(&ctx->conn_pool, addr, port,
+                                                             stream, transport);
+        /* With it preferred, an earlier fallback stands in while pooled */
+        if (!conn && ctx->preferred_transport == transport) {
+            conn = remoteio_conn_pool_get(&ctx->conn_pool, addr, port, stream, fallback);
+        }
+        if (conn) {
+            *conn_out = conn;
+            return 0;
+        }
+    }
+    
+    if (remoteio_connect_transport(ctx, addr, port, stream, transport, conn_out) == 0) {
+        return 0;
+    }
+    if (!may_fall_back ||
+        remoteio_connect_transport(ctx, addr, port, stream, fallback, conn_out) != 0) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&ctx->stats_lock);
+    ctx->tcp_fallbacks++;
+    pthread_mutex_unlock(&ctx->stats_lock);
+    remoteio_route_failed(ctx, addr, port);
+    return 0;
+}
+
+/*
+ * Get the connection for one stream to a peer. Stream 0 is the shared
+ * connection every op uses; higher streams only carry stripes and exist
+ * only while the pool has room for them. Under AUTO this is the transport
+ * the peer's route picks for large named transfers.
+ */
+int remoteio_connect_stream(remoteio_context_t* ctx, const char* addr, uint16_t port,
+                            int stream, remoteio_connection_t** conn_out) {
+    if (!ctx || !addr || !conn_out || stream < 0) return -1;
+    
+    remoteio_transport_t transport = remoteio_route_pick(ctx, addr, port, false, SIZE_MAX);
+    return connect_picked(ctx, addr, port, stream, transport, conn_out);
+}
+
+/* Get the connection for ops of size bytes, named or one-sided, over the
+ * transport the peer's route picks for them */
+int remoteio_connect_route(remoteio_context_t* ctx, const char* addr, uint16_t port,
+                           bool one_sided, size_t size, remoteio_connection_t** conn_out) {
     if (!ctx || !addr || !conn_out) return -1;
     
-    /* Check connection pool first */
-    remoteio_connection_t* conn = remoteio_conn_pool_get(&ctx->conn_pool, addr, port);
+    remoteio_transport_t transport = remoteio_route_pick(ctx, addr, port, one_sided, size);
+    return connect_picked(ctx, addr, port, 0, transport, conn_out);
+}
+
+/*
+ * Get the connection for one stream to a peer over exactly this transport
+ * (not AUTO); fails if the transport can't reach the peer. TCP and soft
+ * RDMA share the framed stream, which under AUTO carries both kinds of op.
+ */
+int remoteio_connect_transport(remoteio_context_t* ctx, const char* addr, uint16_t port,
+                               int stream, remoteio_transport_t transport,
+                               remoteio_connection_t** conn_out) {
+    if (!ctx || !addr || !conn_out || stream < 0) return -1;
+    if (transport == REMOTEIO_TRANSPORT_AUTO) return -1;
+    
+    if (transport == REMOTEIO_TRANSPORT_TCP &&
+        ctx->preferred_transport == REMOTEIO_TRANSPORT_AUTO) {
+        transport = REMOTEIO_TRANSPORT_SOFT_RDMA;
+    }
+    
+    /* Reuse the shared connection to this peer; ops multiplex on it */
+    remoteio_connection_t* conn = remoteio_conn_pool_get(&ctx->conn_pool, addr, port,
+                                                         stream, transport);
     if (conn) {
         *conn_out = conn;
         return 0;
@@ -153,37 +261,30 @@ int remoteio_connect(remoteio_context_t* ctx, const char* addr, uint16_t port,
     if (remoteio_conn_create(ctx, addr, port, &conn) != 0) {
         return -1;
     }
-    
-    /* Determine transport */
-    remoteio_transport_t transport = ctx->preferred_transport;
-    if (transport == REMOTEIO_TRANSPORT_AUTO) {
-        /* Try RDMA first, fallback to TCP */
-        if (ctx->use_gdr && ctx->rdma_ctx) {
-            transport = REMOTEIO_TRANSPORT_RDMA;
-        } else {
-            transport = REMOTEIO_TRANSPORT_TCP;
-        }
-    }
+    conn->stream = stream;
     
     /* Connect based on transport */
     int ret;
-    if (transport == REMOTEIO_TRANSPORT_RDMA && ctx->use_gdr) {
-        ret = remoteio_rdma_connect(ctx, conn, addr, port);
-        if (ret == 0) {
-            conn->transport = REMOTEIO_TRANSPORT_RDMA;
-        } else {
-            /* Fallback to TCP */
-            ret = remoteio_network_connect(ctx, conn, addr, port);
-            if (ret == 0) {
-                conn->transport = REMOTEIO_TRANSPORT_TCP;
-                ctx->tcp_fallbacks++;
-            }
-        }
+    if (transport == REMOTEIO_TRANSPORT_RDMA) {
+        ret = ctx->use_gdr ? remoteio_rdma_connect(ctx, conn, addr, port) : -1;
+        if (ret == 0) conn->transport = REMOTEIO_TRANSPORT_RDMA;
+    } else if (transport == REMOTEIO_TRANSPORT_SHM) {
+        /* Only to a server on this host; the protocol then runs over rings */
+        ret = remoteio_shm_connect(ctx, conn, addr, port);
     } else {
+        /* Soft RDMA rides the same stream, TCP or a Unix socket */
         ret = remoteio_network_connect(ctx, conn, addr, port);
-        if (ret == 0) {
-            conn->transport = REMOTEIO_TRANSPORT_TCP;
-        }
+        if (ret == 0) conn->transport = transport;
+    }
+    
+    /* TCP carries the framed request protocol */
+    if (ret == 0 && conn->transport != REMOTEIO_TRANSPORT_RDMA) {
+        ret = remoteio_proto_attach(conn, ctx);
+    }
+    
+    /* From here on the reactor completes its ops */
+    if (ret == 0) {
+        ret = remoteio_reactor_add(&ctx->reactor, conn);
     }
     
     if (ret != 0) {
@@ -191,82 +292,91 @@ int remoteio_connect(remoteio_context_t* ctx, const char* addr, uint16_t port,
         return -1;
     }
     
+    /* Keep it for later calls. If the pool is full or another thread got
+     * there first, this one is private and closes on disconnect. Stripe
+     * streams are never private: they'd escape max_connections. */
+    if (remoteio_conn_pool_add(&ctx->conn_pool, conn) != 0 && stream > 0) {
+        remoteio_conn_release(conn);
+        conn = remoteio_conn_pool_get(&ctx->conn_pool, addr, port, stream, transport);
+        if (!conn) return -1;
+    }
+    
     *conn_out = conn;
     return 0;
 }
 
+/* Drop the caller's reference; pooled connections stay open */
 int remoteio_disconnect(remoteio_context_t* ctx, remoteio_connection_t* conn) {
     if (!ctx || !conn) return -1;
     
-    /* Return to pool or destroy */
-    if (remoteio_conn_pool_put(&ctx->conn_pool, conn) != 0) {
-        remoteio_conn_destroy(conn);
-    }
-    
-    return 0;
+    return remoteio_conn_pool_put(&ctx->conn_pool, conn);
 }
 
-int remoteio_read(remoteio_context_t* ctx, const char* uri, void* buf,
-                  size_t count, uint64_t offset) {
-    if (!ctx || !uri || !buf || count == 0) return -1;
-    
-    /* Parse URI: rdma://host:port/resource or tcp://host:port/resource */
-    char scheme[16] = {0};
-    char host[256] = {0};
-    int port = REMOTEIO_DEFAULT_PORT;
-    char resource[256] = {0};
-    
-    if (sscanf(uri, "%15[^:]://%255[^:]:%d/%255s", scheme, host, &port, resource) < 2) {
-        if (sscanf(uri, "%15[^:]://%255[^/]/%255s", scheme, host, resource) < 2) {
-            return -1;
-        }
-    }
-    
-    /* Connect to remote */
+/* ============================================================================
+ * Striped Transfers
+ * ============================================================================ */
+
+/* One stripe: a contiguous piece of a transfer on its own stream */
+typedef struct remoteio_stripe {
+    remoteio_context_t* ctx;
     remoteio_connection_t* conn;
-    if (remoteio_connect(ctx, host, port, &conn) != 0) {
-        return -1;
-    }
-    
-    /* Create read operation */
-    remoteio_operation_t* op = remoteio_op_alloc(ctx);
-    if (!op) {
-        remoteio_disconnect(ctx, conn);
-        return -1;
-    }
-    
-    op->op = REMOTEIO_OP_READ;
-    op->conn = conn;
-    op->local_buf = buf;
+    remoteio_operation_t* op;
+    remoteio_op_t type;
+    const char* resource;
+    char* buf;
+    size_t length;
+    uint64_t offset;
+    pthread_t thread;
+    bool threaded;
+    int ret;
+} remoteio_stripe_t;
+
+static int stripe_submit(remoteio_stripe_t* stripe) {
+    remoteio_operation_t* op = remoteio_op_alloc(stripe->ctx);
+    if (!op) return -1;
+    
+    op->op = stripe->type;
+    op->conn = stripe->conn;
+    op->local_buf = stripe->buf;
+    snprintf(op->resource, sizeof(op->resource), "%s", stripe->resource);
     op->local_offset = 0;
-    op->remote_offset = offset;
-    op->length = count;
+    op->remote_offset = stripe->offset;
+    op->length = stripe->length;
     
-    /* Submit operation */
-    int ret = remoteio_op_submit(ctx, op);
-    if (ret == 0) {
-        ret = remoteio_op_wait(op, REMOTEIO_OP_TIMEOUT_US);
-    }
+    stripe->op = op;
+    return remoteio_op_submit(stripe->ctx, op);
+}
+
+static int stripe_finish(remoteio_stripe_t* stripe, int ret) {
+    if (!stripe->op) return -1;
     
-    /* Update statistics */
     if (ret == 0) {
-        pthread_mutex_lock(&ctx->stats_lock);
-        ctx->bytes_read += op->bytes_transferred;
-        ctx->requests_completed++;
-        pthread_mutex_unlock(&ctx->stats_lock);
+        ret = remoteio_op_wait(stripe->op, REMOTEIO_OP_TIMEOUT_US);
+    }
+    if (ret == 0 && stripe->op->bytes_transferred != stripe->length) {
+        ret = -1;
     }
     
-    remoteio_op_free(ctx, op);
-    remoteio_disconnect(ctx, conn);
-    
+    remoteio_op_free(stripe->ctx, stripe->op);
+    stripe->op = NULL;
     return ret;
 }
 
-int remoteio_write(remoteio_context_t* ctx, const char* uri, const void* buf,
-                   size_t count, uint64_t offset) {
-    if (!ctx || !uri || !buf || count == 0) return -1;
-    
-    /* Parse URI */
+/* Writes send their payload inside submit, so each stripe gets a thread */
+static void* stripe_write_thread(void* arg) {
+    remoteio_stripe_t* stripe = (remoteio_stripe_t*)arg;
+    stripe->ret = stripe_finish(stripe, stripe_submit(stripe));
+    return NULL;
+}
+
+/*
+ * Read or write [offset, offset + count) of a remote URI. Large transfers
+ * are split into one contiguous stripe per stream and reassembled in place;
+ * the time they take tunes the peer's stream count.
+ */
+static int remoteio_transfer(remoteio_context_t* ctx, remoteio_op_t type, const char* uri,
+                             char* buf, size_t count, uint64_t offset) {
+    /* Parse URI: rdma://host:port/resource or tcp://host:port/resource */
     char scheme[16] = {0};
     char host[256] = {0};
     int port = REMOTEIO_DEFAULT_PORT;
@@ -278,228 +388,291 @@ int remoteio_write(remoteio_context_t* ctx, const char* uri, const void* buf,
         }
     }
     
-    /* Connect to remote */
-    remoteio_connection_t* conn;
-    if (remoteio_connect(ctx, host, port, &conn) != 0) {
-        return -1;
+    int wanted = 1;
+    if (count >= REMOTEIO_STRIPE_MIN_BYTES) {
+        wanted = remoteio_conn_pool_stripe_width(&ctx->conn_pool, host, (uint16_t)port);
+        if ((size_t)wanted > count / REMOTEIO_STRIPE_UNIT) {
+            wanted = (int)(count / REMOTEIO_STRIPE_UNIT);
+        }
     }
     
-    /* Create write operation */
-    remoteio_operation_t* op = remoteio_op_alloc(ctx);
-    if (!op) {
-        remoteio_disconnect(ctx, conn);
+    /* Connect the streams; use as many as the pool lets us have */
+    remoteio_transport_t transport = remoteio_route_pick(ctx, host, (uint16_t)port, false, count);
+    remoteio_stripe_t stripes[REMOTEIO_STRIPE_MAX_STREAMS];
+    int used = 0;
+    while (used < wanted) {
+        remoteio_connection_t* conn;
+        if (connect_picked(ctx, host, (uint16_t)port, used, transport, &conn) != 0) break;
+        if (used > 0 && conn->transport != stripes[0].conn->transport) {
+            remoteio_disconnect(ctx, conn);
+            break;
+        }
+        stripes[used++].conn = conn;
+    }
+    if (used == 0) {
+        remoteio_route_failed(ctx, host, (uint16_t)port);
         return -1;
     }
     
-    op->op = REMOTEIO_OP_WRITE;
-    op->conn = conn;
-    op->local_buf = (void*)buf;
-    op->local_offset = 0;
-    op->remote_offset = offset;
-    op->length = count;
+    /* Stripe boundaries fall on protocol chunks */
+    size_t per = (count + used - 1) / used;
+    per = (per + REMOTEIO_PROTO_CHUNK - 1) / REMOTEIO_PROTO_CHUNK * REMOTEIO_PROTO_CHUNK;
+    int active = 0;
+    for (int i = 0; i < used; i++) {
+        remoteio_stripe_t* stripe = &stripes[i];
+        size_t start = (size_t)i * per;
+        
+        stripe->ctx = ctx;
+        stripe->op = NULL;
+        stripe->type = type;
+        stripe->resource = resource;
+        stripe->buf = buf + start;
+        stripe->length = start < count ? (count - start < per ? count - start : per) : 0;
+        stripe->offset = offset + start;
+        stripe->threaded = false;
+        stripe->ret = 0;
+        if (stripe->length > 0) active = i + 1;
+    }
+    
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    
+    int ret = 0;
+    if (type == REMOTEIO_OP_WRITE) {
+        for (int i = 1; i < active; i++) {
+            stripes[i].threaded =
+                pthread_create(&stripes[i].thread, NULL, stripe_write_thread, &stripes[i]) == 0;
+        }
+        /* Stripe 0, and any stripe that didn't get a thread, on this one */
+        for (int i = 0; i < active; i++) {
+            if (!stripes[i].threaded) stripe_write_thread(&stripes[i]);
+        }
+        for (int i = 0; i < active; i++) {
+            if (stripes[i].threaded) pthread_join(stripes[i].thread, NULL);
+            if (stripes[i].ret != 0) ret = -1;
+        }
+    } else {
+        /* Read requests are small; the streams' receive threads run in parallel */
+        for (int i = 0; i < active; i++) {
+            stripes[i].ret = stripe_submit(&stripes[i]);
+        }
+        for (int i = 0; i < active; i++) {
+            if (stripe_finish(&stripes[i], stripes[i].ret) != 0) ret = -1;
+        }
+    }
     
-    /* Submit operation */
-    int ret = remoteio_op_submit(ctx, op);
-    if (ret == 0) {
-        ret = remoteio_op_wait(op, REMOTEIO_OP_TIMEOUT_US);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    
+    if (ret == 0 && count >= REMOTEIO_STRIPE_MIN_BYTES) {
+        /* Signed nanoseconds first: tv_nsec goes backwards across a second */
+        int64_t elapsed_ns = (int64_t)(t1.tv_sec - t0.tv_sec) * 1000000000LL +
+                             (t1.tv_nsec - t0.tv_nsec);
+        uint64_t elapsed_us = (uint64_t)(elapsed_ns / 1000);
+        remoteio_conn_pool_stripe_update(&ctx->conn_pool, host, (uint16_t)port,
+                                         wanted, active, count, elapsed_us);
     }
     
     /* Update statistics */
-    if (ret == 0) {
+    if (ret != 0) {
+        remoteio_route_failed(ctx, host, (uint16_t)port);
+    } else {
         pthread_mutex_lock(&ctx->stats_lock);
-        ctx->bytes_written += op->bytes_transferred;
+        if (type == REMOTEIO_OP_READ) {
+            ctx->bytes_read += count;
+        } else {
+            ctx->bytes_written += count;
+        }
         ctx->requests_completed++;
         pthread_mutex_unlock(&ctx->stats_lock);
     }
     
-    remoteio_op_free(ctx, op);
-    remoteio_disconnect(ctx, conn);
+    for (int i = 0; i < used; i++) {
+        remoteio_disconnect(ctx, stripes[i].conn);
+    }
     
     return ret;
 }
 
-int remoteio_read_gpu(remoteio_context_t* ctx, const char* uri, void* gpu_buf,
-                      size_t count, uint64_t offset) {
-    if (!ctx || !uri || !gpu_buf || count == 0) return -1;
-    
-    if (!ctx->use_gdr) {
-        /* Fallback: read to staging buffer then copy to GPU */
-        void* staging = malloc(count);
-        if (!staging) return -1;
-        
-        int ret = remoteio_read(ctx, uri, staging, count, offset);
-        if (ret == 0) {
-            gpuio_error_t err = gpuio_memcpy(ctx->parent, gpu_buf, staging, count, NULL);
-            ret = (err == GPUIO_SUCCESS) ? 0 : -1;
-        }
-        
-        free(staging);
-        return ret;
-    }
-    
-    /* Parse URI */
-    char scheme[16] = {0};
-    char host[256] = {0};
-    int port = REMOTEIO_DEFAULT_PORT;
-    
-    if (sscanf(uri, "%15[^:]://%255[^:]:%d/", scheme, host, &port) < 2) {
-        sscanf(uri, "%15[^:]://%255[^/]/", scheme, host);
-    }
+int remoteio_read(remoteio_context_t* ctx, const char* uri, void* buf,
+                  size_t count, uint64_t offset) {
+    if (!ctx || !uri || !buf || count == 0) return -1;
     
-    /* Connect to remote */
-    remoteio_connection_t* conn;
-    if (remoteio_connect(ctx, host, port, &conn) != 0) {
-        return -1;
-    }
+    return remoteio_transfer(ctx, REMOTEIO_OP_READ, uri, (char*)buf, count, offset);
+}
+
+int remoteio_write(remoteio_context_t* ctx, const char* uri, const void* buf,
+                   size_t count, uint64_t offset) {
+    if (!ctx || !uri || !buf || count == 0) return -1;
     
-    /* Register GPU memory for RDMA if not already registered */
+    return remoteio_transfer(ctx, REMOTEIO_OP_WRITE, uri, (char*)buf, count, offset);
+}
+
+/* Register memory for one-sided ops; the soft transport needs no NIC, and
+ * without one AUTO routes them all to it */
+int remoteio_register_local(remoteio_context_t* ctx, void* ptr, size_t length,
+                            int gpu_id, remoteio_gdr_region_t** region_out) {
+    if (ctx->preferred_transport == REMOTEIO_TRANSPORT_SOFT_RDMA ||
+        ctx->preferred_transport == REMOTEIO_TRANSPORT_SHM ||
+        (ctx->preferred_transport == REMOTEIO_TRANSPORT_AUTO && !ctx->rdma_ctx)) {
+        return remoteio_soft_rdma_register_memory(ptr, length, gpu_id, region_out);
+    }
+    return remoteio_rdma_register_gpu_memory(ctx, ptr, length, gpu_id, region_out);
+}
+
+/* Find the registration covering buf, registering it if there is none */
+static remoteio_gdr_region_t* gpu_region_get(remoteio_context_t* ctx, void* buf, size_t count) {
     pthread_mutex_lock(&ctx->gdr_lock);
     remoteio_gdr_region_t* gdr = ctx->gdr_regions;
     while (gdr) {
-        if (gdr->gpu_ptr == gpu_buf) break;
+        if (gdr->gpu_ptr == buf && gdr->length >= count) break;
         gdr = gdr->next;
     }
     
     if (!gdr) {
         /* Register new region */
         int gpu_id = 0; /* TODO: detect from address */
-        if (remoteio_rdma_register_gpu_memory(ctx, gpu_buf, count, gpu_id, &gdr) == 0) {
+        if (remoteio_register_local(ctx, buf, count, gpu_id, &gdr) == 0) {
             gdr->next = ctx->gdr_regions;
             ctx->gdr_regions = gdr;
         }
     }
     pthread_mutex_unlock(&ctx->gdr_lock);
+    return gdr;
+}
+
+/* Whether some transport can carry one-sided ops for this context */
+static bool gpu_one_sided(remoteio_context_t* ctx) {
+    return ctx->use_gdr || ctx->preferred_transport == REMOTEIO_TRANSPORT_SOFT_RDMA ||
+           ctx->preferred_transport == REMOTEIO_TRANSPORT_SHM ||
+           ctx->preferred_transport == REMOTEIO_TRANSPORT_AUTO;
+}
+
+/*
+ * One-sided read or write of [offset, offset + count) of the region mem
+ * describes, which the URI named. A refusal means the peer revoked the
+ * descriptor and the cache dropped it: resolve it again and retry once.
+ */
+static int remoteio_transfer_gpu(remoteio_context_t* ctx, remoteio_op_t type, const char* uri,
+                                 remoteio_remote_mem_t* mem, void* gpu_buf, size_t count,
+                                 uint64_t offset) {
+    /* Parse URI */
+    char scheme[16] = {0};
+    char host[256] = {0};
+    int port = REMOTEIO_DEFAULT_PORT;
     
-    if (!gdr) {
-        remoteio_disconnect(ctx, conn);
-        return -1;
+    if (sscanf(uri, "%15[^:]://%255[^:]:%d/", scheme, host, &port) < 2) {
+        sscanf(uri, "%15[^:]://%255[^/]/", scheme, host);
     }
     
-    /* Create RDMA read operation */
-    remoteio_operation_t* op = remoteio_op_alloc(ctx);
-    if (!op) {
-        remoteio_disconnect(ctx, conn);
+    remoteio_gdr_region_t* gdr = gpu_region_get(ctx, gpu_buf, count);
+    if (!gdr) return -1;
+    
+    /* Connect over whatever carries one-sided ops of this size best */
+    remoteio_connection_t* conn;
+    if (remoteio_connect_route(ctx, host, (uint16_t)port, true, count, &conn) != 0) {
         return -1;
     }
     
-    op->op = REMOTEIO_OP_READ;
-    op->conn = conn;
-    op->local_gdr = gdr;
-    op->local_offset = 0;
-    op->remote_offset = offset;
-    op->length = count;
-    
-    /* Submit RDMA operation */
-    int ret = remoteio_op_submit(ctx, op);
-    if (ret == 0) {
-        ret = remoteio_op_wait(op, REMOTEIO_OP_TIMEOUT_US);
+    int ret = -1;
+    uint64_t transferred = 0;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (offset > mem->length || count > mem->length - offset) break;
+        
+        remoteio_operation_t* op = remoteio_op_alloc(ctx);
+        if (!op) break;
+        
+        op->op = type;
+        op->conn = conn;
+        op->local_gdr = gdr;
+        op->local_offset = 0;
+        op->remote_mem = mem;
+        op->remote_offset = offset;
+        op->length = count;
+        
+        ret = remoteio_op_submit(ctx, op);
+        if (ret == 0) {
+            ret = remoteio_op_wait(op, REMOTEIO_OP_TIMEOUT_US);
+        }
+        gpuio_error_t status = op->status;
+        transferred = op->bytes_transferred;
+        remoteio_op_free(ctx, op);
+        
+        if (ret == 0 && (status != GPUIO_SUCCESS || transferred != count)) ret = -1;
+        if (ret == 0 || status != GPUIO_ERROR_PERMISSION || attempt > 0 ||
+            remoteio_resolve(ctx, uri, mem) != 0) {
+            break;
+        }
     }
     
     /* Update statistics */
-    if (ret == 0) {
+    if (ret != 0) {
+        remoteio_route_failed(ctx, host, (uint16_t)port);
+    } else {
         pthread_mutex_lock(&ctx->stats_lock);
-        ctx->bytes_read += op->bytes_transferred;
+        if (type == REMOTEIO_OP_READ) {
+            ctx->bytes_read += transferred;
+        } else {
+            ctx->bytes_written += transferred;
+        }
         ctx->rdma_ops++;
         ctx->requests_completed++;
         pthread_mutex_unlock(&ctx->stats_lock);
     }
     
-    remoteio_op_free(ctx, op);
     remoteio_disconnect(ctx, conn);
-    
     return ret;
 }
 
-int remoteio_write_gpu(remoteio_context_t* ctx, const char* uri,
-                       const void* gpu_buf, size_t count, uint64_t offset) {
+/*
+ * GPU transfers go one-sided to the region the URI names, its descriptor
+ * resolved through the region cache. A URI naming a plain export, or a
+ * context with no one-sided transport, is served through a staging buffer.
+ */
+int remoteio_read_gpu(remoteio_context_t* ctx, const char* uri, void* gpu_buf,
+                      size_t count, uint64_t offset) {
     if (!ctx || !uri || !gpu_buf || count == 0) return -1;
     
-    if (!ctx->use_gdr) {
-        /* Fallback: copy from GPU to staging buffer then write */
-        void* staging = malloc(count);
-        if (!staging) return -1;
-        
-        gpuio_error_t err = gpuio_memcpy(ctx->parent, staging, gpu_buf, count, NULL);
-        if (err != GPUIO_SUCCESS) {
-            free(staging);
-            return -1;
-        }
-        
-        int ret = remoteio_write(ctx, uri, staging, count, offset);
-        free(staging);
-        return ret;
+    remoteio_remote_mem_t mem;
+    if (gpu_one_sided(ctx) && remoteio_resolve(ctx, uri, &mem) == 0) {
+        return remoteio_transfer_gpu(ctx, REMOTEIO_OP_READ, uri, &mem, gpu_buf, count, offset);
     }
     
-    /* Parse URI */
-    char scheme[16] = {0};
-    char host[256] = {0};
-    int port = REMOTEIO_DEFAULT_PORT;
-    
-    if (sscanf(uri, "%15[^:]://%255[^:]:%d/", scheme, host, &port) < 2) {
-        sscanf(uri, "%15[^:]://%255[^/]/", scheme, host);
-    }
+    /* Fallback: read to staging buffer then copy to GPU */
+    void* staging = malloc(count);
+    if (!staging) return -1;
     
-    /* Connect to remote */
-    remoteio_connection_t* conn;
-    if (remoteio_connect(ctx, host, port, &conn) != 0) {
-        return -1;
+    int ret = remoteio_read(ctx, uri, staging, count, offset);
+    if (ret == 0) {
+        gpuio_error_t err = gpuio_memcpy(ctx->parent, gpu_buf, staging, count, NULL);
+        ret = (err == GPUIO_SUCCESS) ? 0 : -1;
     }
     
-    /* Register GPU memory for RDMA if not already registered */
-    pthread_mutex_lock(&ctx->gdr_lock);
-    remoteio_gdr_region_t* gdr = ctx->gdr_regions;
-    while (gdr) {
-        if (gdr->gpu_ptr == gpu_buf) break;
-        gdr = gdr->next;
-    }
+    free(staging);
+    return ret;
+}
+
+int remoteio_write_gpu(remoteio_context_t* ctx, const char* uri,
+                       const void* gpu_buf, size_t count, uint64_t offset) {
+    if (!ctx || !uri || !gpu_buf || count == 0) return -1;
     
-    if (!gdr) {
-        /* Register new region */
-        int gpu_id = 0; /* TODO: detect from address */
-        if (remoteio_rdma_register_gpu_memory(ctx, (void*)gpu_buf, count, gpu_id, &gdr) == 0) {
-            gdr->next = ctx->gdr_regions;
-            ctx->gdr_regions = gdr;
-        }
+    remoteio_remote_mem_t mem;
+    if (gpu_one_sided(ctx) && remoteio_resolve(ctx, uri, &mem) == 0) {
+        return remoteio_transfer_gpu(ctx, REMOTEIO_OP_WRITE, uri, &mem, (void*)gpu_buf,
+                                     count, offset);
     }
-    pthread_mutex_unlock(&ctx->gdr_lock);
     
-    if (!gdr) {
-        remoteio_disconnect(ctx, conn);
-        return -1;
-    }
+    /* Fallback: copy from GPU to staging buffer then write */
+    void* staging = malloc(count);
+    if (!staging) return -1;
     
-    /* Create RDMA write operation */
-    remoteio_operation_t* op = remoteio_op_alloc(ctx);
-    if (!op) {
-        remoteio_disconnect(ctx, conn);
+    gpuio_error_t err = gpuio_memcpy(ctx->parent, staging, gpu_buf, count, NULL);
+    if (err != GPUIO_SUCCESS) {
+        free(staging);
         return -1;
     }
     
-    op->op = REMOTEIO_OP_WRITE;
-    op->conn = conn;
-    op->local_gdr = gdr;
-    op->local_offset = 0;
-    op->remote_offset = offset;
-    op->length = count;
-    
-    /* Submit RDMA operation */
-    int ret = remoteio_op_submit(ctx, op);
-    if (ret == 0) {
-        ret = remoteio_op_wait(op, REMOTEIO_OP_TIMEOUT_US);
-    }
-    
-    /* Update statistics */
-    if (ret == 0) {
-        pthread_mutex_lock(&ctx->stats_lock);
-        ctx->bytes_written += op->bytes_transferred;
-        ctx->rdma_ops++;
-        ctx->requests_completed++;
-        pthread_mutex_unlock(&ctx->stats_lock);
-    }
-    
-    remoteio_op_free(ctx, op);
-    remoteio_disconnect(ctx, conn);
-    
+    int ret = remoteio_write(ctx, uri, staging, count, offset);
+    free(staging);
     return ret;
 }
 
@@ -507,7 +680,11 @@ int remoteio_register_gpu_memory(remoteio_context_t* ctx, void* gpu_ptr,
                                   size_t length, int gpu_id) {
     if (!ctx || !gpu_ptr || length == 0) return -1;
     
-    if (!ctx->use_gdr) return -1;
+    if (!ctx->use_gdr && ctx->preferred_transport != REMOTEIO_TRANSPORT_SOFT_RDMA &&
+        ctx->preferred_transport != REMOTEIO_TRANSPORT_SHM &&
+        ctx->preferred_transport != REMOTEIO_TRANSPORT_AUTO) {
+        return -1;
+    }
     
     pthread_mutex_lock(&ctx->gdr_lock);
     
@@ -522,7 +699,7 @@ int remoteio_register_gpu_memory(remoteio_context_t* ctx, void* gpu_ptr,
     }
     
     /* Register new region */
-    int ret = remoteio_rdma_register_gpu_memory(ctx, gpu_ptr, length, gpu_id, &gdr);
+    int ret = remoteio_register_local(ctx, gpu_ptr, length, gpu_id, &gdr);
     if (ret == 0) {
         gdr->next = ctx->gdr_regions;
         ctx->gdr_regions = gdr;
@@ -553,6 +730,36 @@ int remoteio_unregister_gpu_memory(remoteio_context_t* ctx, void* gpu_ptr) {
     return -1; /* Not found */
 }
 
+/**
+ * Resolve a region URI (tcp://host:port/name) to the descriptor the peer
+ * advertised for it, for one-sided ops. Served from the region cache
+ * while the peer hasn't revoked it.
+ */
+int remoteio_resolve(remoteio_context_t* ctx, const char* uri,
+                     remoteio_remote_mem_t* mem_out) {
+    if (!ctx || !uri || !mem_out) return -1;
+    
+    char scheme[16] = {0};
+    char host[256] = {0};
+    int port = REMOTEIO_DEFAULT_PORT;
+    char name[256] = {0};
+    
+    if (sscanf(uri, "%15[^:]://%255[^:]:%d/%255s", scheme, host, &port, name) < 4) {
+        if (sscanf(uri, "%15[^:]://%255[^/]/%255s", scheme, host, name) < 3) {
+            return -1;
+        }
+    }
+    
+    remoteio_connection_t* conn;
+    if (remoteio_connect(ctx, host, (uint16_t)port, &conn) != 0) return -1;
+    
+    /* Hardware RDMA connections have no control channel to ask on */
+    int ret = remoteio_proto_lookup(ctx, conn, name, mem_out);
+    
+    remoteio_disconnect(ctx, conn);
+    return ret;
+}
+
 int remoteio_get_stats(remoteio_context_t* ctx, uint64_t* bytes_read,
                        uint64_t* bytes_written, uint64_t* requests) {
     if (!ctx) return -1;
@@ -566,6 +773,23 @@ int remoteio_get_stats(remoteio_context_t* ctx, uint64_t* bytes_read,
     return 0;
 }
 
+/* Connections that fell back from RDMA to the stream, and route probes */
+int remoteio_get_transport_stats(remoteio_context_t* ctx, uint64_t* tcp_fallbacks,
+                                 uint64_t* probes, uint64_t* reprobes) {
+    if (!ctx) return -1;
+    
+    pthread_mutex_lock(&ctx->stats_lock);
+    if (tcp_fallbacks) *tcp_fallbacks = ctx->tcp_fallbacks;
+    pthread_mutex_unlock(&ctx->stats_lock);
+    
+    pthread_mutex_lock(&ctx->routes.lock);
+    if (probes) *probes = ctx->routes.probes;
+    if (reprobes) *reprobes = ctx->routes.reprobes;
+    pthread_mutex_unlock(&ctx->routes.lock);
+    
+    return 0;
+}
+
 const char* remoteio_op_str(remoteio_op_t op) {
     switch (op) {
         case REMOTEIO_OP_READ: return "READ";
@@ -574,6 +798,8 @@ const char* remoteio_op_str(remoteio_op_t op) {
         case REMOTEIO_OP_RECV: return "RECV";
         case REMOTEIO_OP_ATOMIC_CAS: return "ATOMIC_CAS";
         case REMOTEIO_OP_ATOMIC_FAA: return "ATOMIC_FAA";
+        case REMOTEIO_OP_PING: return "PING";
+        case REMOTEIO_OP_LOOKUP: return "LOOKUP";
         default: return "UNKNOWN";
     }
 }
@@ -594,6 +820,8 @@ const char* remoteio_transport_str(remoteio_transport_t transport) {
         case REMOTEIO_TRANSPORT_RDMA: return "RDMA";
         case REMOTEIO_TRANSPORT_TCP: return "TCP";
         case REMOTEIO_TRANSPORT_AUTO: return "AUTO";
+        case REMOTEIO_TRANSPORT_SOFT_RDMA: return "SOFT_RDMA";
+        case REMOTEIO_TRANSPORT_SHM: return "SHM";
         default: return "UNKNOWN";
     }
 }
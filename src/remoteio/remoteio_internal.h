@@ -8,10 +8,12 @@
 #define REMOTEIO_INTERNAL_H
 
 #include <gpuio/gpuio.h>
+#include <gpuio/gpuio_ai.h>
 #include <pthread.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
@@ -26,6 +28,8 @@ typedef enum {
     REMOTEIO_OP_RECV = 3,
     REMOTEIO_OP_ATOMIC_CAS = 4,
     REMOTEIO_OP_ATOMIC_FAA = 5,
+    REMOTEIO_OP_PING = 6,
+    REMOTEIO_OP_LOOKUP = 7,      /* Resolve an advertised region by name */
 } remoteio_op_t;
 
 /* Connection state */
@@ -42,8 +46,12 @@ typedef enum {
     REMOTEIO_TRANSPORT_RDMA = 0,
     REMOTEIO_TRANSPORT_TCP = 1,
     REMOTEIO_TRANSPORT_AUTO = 2,
+    REMOTEIO_TRANSPORT_SOFT_RDMA = 3,    /* One-sided ops emulated over TCP or a Unix socket */
+    REMOTEIO_TRANSPORT_SHM = 4,          /* Shared-memory rings to a peer on this host */
 } remoteio_transport_t;
 
+#define REMOTEIO_TRANSPORT_COUNT     5            /* Enum values above, AUTO included */
+
 /* RDMA endpoint (opaque handle for ibverbs/rdmacm) */
 typedef struct remoteio_rdma_endpoint {
     void* pd;                    /* Protection domain */
@@ -68,6 +76,24 @@ typedef struct remoteio_gdr_region {
     struct remoteio_gdr_region* next;
 } remoteio_gdr_region_t;
 
+/*
+ * Chained posting: ops linked through next_sg go out as one chain of work
+ * requests with a single doorbell (one ibv_post_send, or one writev on a
+ * soft RDMA connection). Each op is one WR whose local side may be up to
+ * REMOTEIO_CHAIN_MAX_SGE pieces. Only every signal_every-th WR, and the
+ * last, is signalled; its completion also completes the unsignalled ops
+ * of its batch, the ones between it and the previous signalled op.
+ */
+#define REMOTEIO_CHAIN_MAX_WR        128
+#define REMOTEIO_CHAIN_MAX_SGE       4
+
+/* One local piece of a chained work request */
+typedef struct remoteio_sge {
+    remoteio_gdr_region_t* mr;
+    uint64_t offset;
+    uint32_t length;
+} remoteio_sge_t;
+
 /* Remote memory handle (for remote access) */
 typedef struct remoteio_remote_mem {
     uint64_t raddr;              /* Remote virtual address */
@@ -77,7 +103,220 @@ typedef struct remoteio_remote_mem {
     uint16_t peer_port;
 } remoteio_remote_mem_t;
 
+/* ============================================================================
+ * TCP Wire Protocol
+ * ============================================================================ */
+
+/*
+ * Every message is a fixed 52-byte little-endian header, followed by the
+ * resource name (requests only) and chunk_len payload bytes:
+ *
+ *   0  magic         u32     24 length        u64  (whole op)
+ *   4  version       u8      32 chunk_len     u32
+ *   5  type          u8      36 resource_len  u16
+ *   6  flags         u16     38 status        i16  (gpuio_error_t)
+ *   8  req_id        u64     40 rkey          u32  (one-sided requests)
+ *  16  offset        u64     44 credit_ops    u32  (server frames, see below)
+ *                            48 credit_bytes  u32
+ *
+ * offset is the resource offset of the frame's chunk.
+ *
+ * Payloads larger than REMOTEIO_PROTO_CHUNK are split into several frames
+ * so ops sharing a connection interleave; the last one carries
+ * REMOTEIO_MSG_F_LAST. Responses may arrive in any order and are matched
+ * to their op by req_id.
+ *
+ * Regions a server registers under a name are advertised on request:
+ * LOOKUP names one and LOOKUP_RESP answers with its address in offset, its
+ * length and its rkey. When such a region is deregistered the server
+ * pushes INVALIDATE (req_id 0, the revoked rkey) to every client.
+ */
+#define REMOTEIO_PROTO_MAGIC         0x47494F52u  /* "RIOG" */
+#define REMOTEIO_PROTO_VERSION       3
+#define REMOTEIO_MSG_HDR_SIZE        52
+#define REMOTEIO_PROTO_CHUNK         (256 * 1024)
+#define REMOTEIO_MAX_RESOURCE        256
+#define REMOTEIO_PROTO_BUCKETS       256          /* Pending-op hash buckets */
+
+#define REMOTEIO_MSG_F_LAST          0x0001
+#define REMOTEIO_MSG_F_COMPRESSED    0x0002       /* Payload: u32 raw length + LZ4 block */
+#define REMOTEIO_MSG_F_UNSIGNALED    0x0004       /* RDMA_WRITE: acknowledge only on error */
+
+/* Payload chunks at least this large are sent with MSG_ZEROCOPY */
+#define REMOTEIO_ZEROCOPY_THRESHOLD  (64 * 1024)
+
+/*
+ * Capabilities. Right after connecting, the client sends HELLO with the
+ * capabilities it wants in offset; the server answers HELLO_ACK with the
+ * subset it grants, and both ends use exactly that from then on.
+ */
+#define REMOTEIO_CAP_LZ4             0x0001       /* Chunks may be LZ4-compressed */
+#define REMOTEIO_CAP_CREDITS         0x0002       /* Requests are flow-controlled */
+#define REMOTEIO_HELLO_TIMEOUT_MS    5000
+
+/*
+ * With REMOTEIO_CAP_CREDITS every request frame but HELLO costs the client
+ * one op credit and chunk_len byte credits, which the server returns as it
+ * frees the frame. Every server frame, starting with HELLO_ACK, carries in
+ * credit_ops/credit_bytes how far the client's running totals of ops and
+ * bytes sent may go (mod 2^32). A client that would pass either waits for
+ * a later frame to raise them. The server sends them in a header-only
+ * CREDIT frame when no response is about to: once a quarter of a window
+ * was returned unannounced, or when the client has nothing left in flight.
+ */
+#define REMOTEIO_CREDIT_TIMEOUT_US   30000000ULL  /* No grant: the server is stuck */
+
+/*
+ * With REMOTEIO_CAP_LZ4 each payload chunk is compressed on its own, so
+ * the receiver can inflate chunks as they arrive. A chunk is first sampled:
+ * if its first REMOTEIO_COMPRESS_SAMPLE bytes don't shrink by
+ * REMOTEIO_COMPRESS_MIN_SAVING percent, or the whole chunk doesn't, it goes
+ * out raw.
+ */
+#define REMOTEIO_COMPRESS_SAMPLE     4096
+#define REMOTEIO_COMPRESS_MIN_SAVING 10
+#define REMOTEIO_COMPRESS_HDR        4
+
+typedef enum {
+    REMOTEIO_MSG_READ = 1,
+    REMOTEIO_MSG_WRITE = 2,
+    REMOTEIO_MSG_READ_RESP = 3,
+    REMOTEIO_MSG_WRITE_RESP = 4,
+    REMOTEIO_MSG_PING = 5,       /* Health check; PONG echoes length bytes */
+    REMOTEIO_MSG_PONG = 6,
+    REMOTEIO_MSG_HELLO = 7,      /* Capability offer, header only */
+    REMOTEIO_MSG_HELLO_ACK = 8,
+    REMOTEIO_MSG_RDMA_READ = 9,  /* One-sided, see the soft RDMA transport */
+    REMOTEIO_MSG_RDMA_WRITE = 10,
+    REMOTEIO_MSG_LOOKUP = 11,    /* Region descriptor by name */
+    REMOTEIO_MSG_LOOKUP_RESP = 12,
+    REMOTEIO_MSG_INVALIDATE = 13, /* Server push: rkey revoked */
+    REMOTEIO_MSG_CREDIT = 14,    /* Server push: credit limits only */
+} remoteio_msg_type_t;
+
+typedef struct remoteio_msg_hdr {
+    uint8_t type;
+    uint16_t flags;
+    uint64_t req_id;
+    uint64_t offset;
+    uint64_t length;
+    uint32_t chunk_len;
+    uint16_t resource_len;
+    int16_t status;
+    uint32_t rkey;
+    uint32_t credit_ops;
+    uint32_t credit_bytes;
+} remoteio_msg_hdr_t;
+
+struct remoteio_operation;
+struct remoteio_region_cache;
+
+/* Where the response parser is within the current frame */
+typedef enum {
+    REMOTEIO_PROTO_RX_HEADER = 0,
+    REMOTEIO_PROTO_RX_RESOURCE,
+    REMOTEIO_PROTO_RX_PAYLOAD,
+} remoteio_proto_rx_stage_t;
+
+/* Client-side protocol state of a TCP connection */
+typedef struct remoteio_proto_conn {
+    /* Frames are written whole; ops interleave between chunks */
+    pthread_mutex_t send_lock;
+    
+    /* Outstanding ops by req_id */
+    struct remoteio_operation* pending[REMOTEIO_PROTO_BUCKETS];
+    int num_pending;
+    struct remoteio_operation* rx_op;   /* Op whose payload is being received */
+    pthread_mutex_t pending_lock;
+    pthread_cond_t rx_cond;
+    
+    /* Response parser, driven by the completion reactor */
+    remoteio_proto_rx_stage_t rx_stage;
+    uint8_t rx_raw[REMOTEIO_MSG_HDR_SIZE];
+    remoteio_msg_hdr_t rx_hdr;
+    size_t rx_pos;               /* Bytes of the current stage received */
+    size_t rx_len;               /* Bytes the current stage needs */
+    char* rx_dst;                /* Payload target; NULL discards it */
+    char* rx_scratch;            /* Compressed chunks land here first */
+    
+    /* Context's descriptor cache, kept current as responses arrive */
+    struct remoteio_region_cache* regions;
+    
+    /* Flow control (credit_lock; taken under send_lock). Totals sent and
+     * the server's limits for them, mod 2^32. */
+    bool credits;
+    bool broken;                 /* Stream failed: stop waiting for grants */
+    uint32_t ops_sent;
+    uint32_t bytes_sent;
+    uint32_t ops_limit;
+    uint32_t bytes_limit;
+    pthread_mutex_t credit_lock;
+    pthread_cond_t credit_cond;
+} remoteio_proto_conn_t;
+
+/* Wire compression counters of one connection (conn lock) */
+typedef struct remoteio_compress_stats {
+    uint64_t chunks_compressed;
+    uint64_t chunks_skipped;     /* Sent raw: sample or chunk didn't shrink */
+    uint64_t raw_bytes;          /* Before compression, of compressed chunks */
+    uint64_t wire_bytes;         /* After */
+    uint64_t compress_ns;        /* Thread CPU time, including skipped tries */
+    uint64_t chunks_decompressed;
+    uint64_t decompress_ns;
+} remoteio_compress_stats_t;
+
+/*
+ * Same-host shared memory: a peer on this host is reached through two byte
+ * rings in one memfd, one per direction, which carry the framed protocol in
+ * place of a socket. The client creates the memfd (sealed against
+ * shrinking) and an eventfd per side, and passes them over a Unix socket to
+ * the control listener the server keeps under remoteio_shm_name(). That
+ * socket stays open, so either side notices the other go away.
+ *
+ * A reader that finds its ring empty flags itself asleep and waits on its
+ * eventfd, which the writer signals only then. A writer that finds the ring
+ * full waits on a futex in the ring that the reader bumps as it frees room.
+ */
+#define REMOTEIO_SHM_RING_BYTES      (4 * 1024 * 1024)  /* Per direction, a power of two */
+#define REMOTEIO_SHM_WAIT_MS         10           /* Full-ring wait between peer checks */
+
+/* One direction, shared with the peer. Indices only grow; the producer's
+ * and the consumer's fields sit on separate cache lines. */
+typedef struct remoteio_shm_ring {
+    uint64_t head;               /* Bytes written */
+    uint32_t reader_asleep;      /* Reader found it empty: signal its eventfd */
+    uint8_t pad0[52];
+    uint64_t tail;               /* Bytes consumed */
+    uint32_t writer_waiting;     /* Writer found it full: bump space_seq */
+    uint32_t space_seq;          /* Futex word */
+    uint8_t pad1[48];
+} remoteio_shm_ring_t;
+
+/* Local end of a shared-memory connection. Sends are serialized by the
+ * protocol's send lock and only the reactor or event thread receives, so
+ * each ring has one writer and one reader per side. */
+typedef struct remoteio_shm_conn {
+    void* base;                  /* The whole memfd */
+    size_t map_len;
+    uint32_t* closed;            /* Shared: either side shut down */
+    remoteio_shm_ring_t* tx;
+    remoteio_shm_ring_t* rx;
+    char* tx_data;
+    char* rx_data;
+    uint64_t tx_head;            /* Own copies; the shared ones are only published */
+    uint64_t rx_tail;
+    int wake_fd;                 /* eventfd: rx has data */
+    int peer_wake_fd;
+    int poll_fd;                 /* epoll over wake_fd and the control socket */
+} remoteio_shm_conn_t;
+
 /* Network connection */
+/* Zero-copy send calls first..end-1, released ahead of the acked prefix */
+typedef struct remoteio_zc_range {
+    uint32_t first;
+    uint32_t end;
+} remoteio_zc_range_t;
+
 typedef struct remoteio_connection {
     char peer_addr[INET6_ADDRSTRLEN];
     uint16_t peer_port;
@@ -91,6 +330,27 @@ typedef struct remoteio_connection {
     /* RDMA endpoint (if using RDMA) */
     remoteio_rdma_endpoint_t* rdma_ep;
     
+    /* Framed request/response protocol (TCP transport) */
+    remoteio_proto_conn_t* proto;
+    
+    /* Rings the protocol runs over instead of the socket (shared memory) */
+    remoteio_shm_conn_t* shm;
+    
+    /* MSG_ZEROCOPY sends (conn lock) */
+    bool zc_enabled;
+    uint32_t zc_sent;            /* Zero-copy send calls issued */
+    uint32_t zc_acked;           /* Calls released, as a contiguous prefix */
+    remoteio_zc_range_t* zc_done; /* Released ranges past zc_acked, unsorted */
+    uint32_t zc_num_done;
+    uint32_t zc_done_cap;
+    uint64_t zc_bytes;
+    uint64_t zc_copied;          /* Calls the kernel copied anyway */
+    
+    /* Negotiated capabilities and wire compression (conn lock) */
+    uint32_t caps;
+    gpuio_codec_t codec;         /* Borrowed from the context */
+    remoteio_compress_stats_t compress;
+    
     /* Connection attributes */
     uint32_t max_send_wr;
     uint32_t max_recv_wr;
@@ -102,6 +362,11 @@ typedef struct remoteio_connection {
     uint64_t reqs_submitted;
     uint64_t reqs_completed;
     uint64_t reqs_failed;
+    uint64_t doorbells;          /* Chains posted */
+    uint64_t chained_wrs;        /* Work requests posted in chains */
+    uint64_t signaled_wrs;       /* Of those, the ones that complete from the wire */
+    uint64_t credit_stalls;      /* Frames that waited for the server's credits */
+    uint64_t credit_stall_us;
     
     /* Thread safety */
     pthread_mutex_t lock;
@@ -110,6 +375,14 @@ typedef struct remoteio_connection {
     /* Reference counting */
     int ref_count;
     
+    /* Completion reactor servicing the connection, if registered */
+    struct remoteio_reactor* reactor;
+    
+    /* Connection pool (pool lock) */
+    bool pooled;
+    int stream;                  /* Index among striped connections to the peer */
+    uint64_t last_used_us;
+    
     struct remoteio_connection* next;
 } remoteio_connection_t;
 
@@ -126,6 +399,21 @@ typedef struct remoteio_operation {
     };
     remoteio_remote_mem_t* remote_mem;
     
+    /* Named remote resource (TCP protocol) */
+    char resource[REMOTEIO_MAX_RESOURCE];
+    
+    /* One-sided access (soft RDMA): local_gdr holds the data and raddr is
+     * the peer address of its first byte */
+    bool one_sided;
+    uint64_t raddr;
+    uint32_t rkey;
+    
+    /* Zero-copy WRITE: completion waits for the kernel to release the
+     * buffer as well as for the response (pending_lock) */
+    bool zc_hold;
+    bool resp_done;
+    gpuio_error_t resp_status;
+    
     /* Parameters */
     uint64_t local_offset;
     uint64_t remote_offset;
@@ -133,26 +421,219 @@ typedef struct remoteio_operation {
     
     /* Completion */
     volatile int completed;
+    bool claimed;                /* Taken off the pending table to be completed
+                                  * (pending_lock); a cancel then fails */
+    pthread_cond_t done_cond;    /* Signalled for this op alone (conn lock) */
     gpuio_error_t status;
     size_t bytes_transferred;
     gpuio_callback_t callback;
     void* user_data;
     
-    /* For scatter-gather */
+    /* Chained posting: next_sg links the chain and the first op's sg_count
+     * is its length. sge[] is the local side when num_sge > 0, else
+     * local_gdr at local_offset. batch is the first op of the op's
+     * signalling batch. */
     struct remoteio_operation* next_sg;
     int sg_count;
+    remoteio_sge_t sge[REMOTEIO_CHAIN_MAX_SGE];
+    int num_sge;
+    bool unsignaled;
+    struct remoteio_operation* batch;
     
     struct remoteio_operation* next;
+    struct remoteio_operation* next_pending;  /* Connection pending table */
 } remoteio_operation_t;
 
-/* Connection pool */
+/*
+ * Connection pool: one long-lived connection per host:port (and stream, see
+ * striping below), shared by every op to that peer. The pool holds a
+ * reference of its own; callers take another for the duration of their
+ * ops. A maintenance thread closes connections idle longer than
+ * idle_timeout_us and pings ones that have been quiet for
+ * health_interval_us, dropping those that don't answer.
+ */
+#define REMOTEIO_POOL_BUCKETS        64
+#define REMOTEIO_POOL_IDLE_US        60000000ULL  /* 60 seconds */
+#define REMOTEIO_POOL_HEALTH_US      10000000ULL  /* 10 seconds */
+#define REMOTEIO_POOL_PING_US        2000000ULL   /* Health-check reply timeout */
+#define REMOTEIO_POOL_SWEEP_US       1000000ULL
+
+/*
+ * Striping: reads and writes of at least REMOTEIO_STRIPE_MIN_BYTES are split
+ * into contiguous stripes sent over parallel connections to the same peer
+ * (streams 0..N-1). Each peer keeps its own N, which hill-climbs on measured
+ * throughput: after every REMOTEIO_STRIPE_PROBE_EVERY transfers it tries one
+ * stream more or less and keeps the change only if it paid off. Extra
+ * streams are pooled like any other connection, so max_connections bounds N.
+ */
+#define REMOTEIO_STRIPE_MIN_BYTES    (4 * 1024 * 1024)
+#define REMOTEIO_STRIPE_UNIT         (1024 * 1024)  /* Smallest stripe */
+#define REMOTEIO_STRIPE_MAX_STREAMS  8
+#define REMOTEIO_STRIPE_PROBE_EVERY  8
+#define REMOTEIO_STRIPE_GAIN_PCT     10           /* Change that counts as a gain */
+
+typedef struct remoteio_stripe_peer {
+    char addr[INET6_ADDRSTRLEN];
+    uint16_t port;
+    
+    int streams;                 /* Current stream count */
+    int probe_from;              /* Count before an ongoing probe, or 0 */
+    int direction;               /* +1 or -1: which way the next probe goes */
+    int hold;                    /* Transfers left before the next probe */
+    uint64_t bps;                /* Smoothed throughput at probe_from/streams */
+    uint64_t transfers;
+    
+    struct remoteio_stripe_peer* next;
+} remoteio_stripe_peer_t;
+
+struct remoteio_context;
+
 typedef struct remoteio_conn_pool {
-    remoteio_connection_t* connections;
+    remoteio_connection_t* buckets[REMOTEIO_POOL_BUCKETS];
     int num_connections;
     int max_connections;
+    
+    /* Per-peer stripe widths */
+    remoteio_stripe_peer_t* stripe_peers[REMOTEIO_POOL_BUCKETS];
+    
+    uint64_t idle_timeout_us;
+    uint64_t health_interval_us;
+    
+    /* Maintenance thread */
+    struct remoteio_context* ctx;        /* Allocates health-check ops */
+    pthread_t thread;
+    bool running;
+    bool stopping;
+    pthread_cond_t cond;
+    
+    /* Statistics */
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t idle_closed;
+    uint64_t health_checks;
+    uint64_t health_failures;
+    uint64_t striped_transfers;
+    uint64_t stripe_probes;
+    
     pthread_mutex_t lock;
 } remoteio_conn_pool_t;
 
+/*
+ * Transport selection: under REMOTEIO_TRANSPORT_AUTO each peer gets a route,
+ * probed over every transport that reaches it when it is first connected.
+ * Named requests and one-sided ops are routed apart, as not every transport
+ * carries both. The framed stream, and the shared-memory rings to a peer
+ * on this host, are timed with PINGs echoing a size class's worth of
+ * payload; one-sided transports (soft RDMA over either, RDMA given a NIC)
+ * with reads of the region the peer advertises as
+ * REMOTEIO_ROUTE_PROBE_REGION. Each class then goes to the transport
+ * with the fastest round trip. The pool thread probes routes again every
+ * REMOTEIO_ROUTE_REPROBE_US, and at its next sweep once one has failed.
+ */
+#define REMOTEIO_ROUTE_CLASSES       3            /* Up to SMALL, up to MEDIUM, larger */
+#define REMOTEIO_ROUTE_SMALL         4096
+#define REMOTEIO_ROUTE_MEDIUM        (64 * 1024)
+#define REMOTEIO_ROUTE_ROUNDS        3            /* Timed round trips per class; the best counts */
+#define REMOTEIO_ROUTE_PROBE_US      1000000ULL   /* Probe round trip timeout */
+#define REMOTEIO_ROUTE_REPROBE_US    60000000ULL
+#define REMOTEIO_ROUTE_PROBE_REGION  "remoteio.probe"
+#define REMOTEIO_ROUTE_PROBE_BYTES   REMOTEIO_PROTO_CHUNK
+#define REMOTEIO_ROUTE_BUCKETS       64
+
+typedef struct remoteio_route {
+    char addr[INET6_ADDRSTRLEN];
+    uint16_t port;
+    
+    /* The decision, per size class */
+    remoteio_transport_t named[REMOTEIO_ROUTE_CLASSES];
+    remoteio_transport_t one_sided[REMOTEIO_ROUTE_CLASSES];
+    
+    /* Best probe round trip per transport and class; 0 if it can't be used */
+    uint64_t named_ns[REMOTEIO_TRANSPORT_COUNT][REMOTEIO_ROUTE_CLASSES];
+    uint64_t one_sided_ns[REMOTEIO_TRANSPORT_COUNT][REMOTEIO_ROUTE_CLASSES];
+    
+    uint64_t probed_us;          /* End of the last probe, or 0 */
+    uint64_t probes;
+    uint64_t failures;           /* Transfers that failed over the route */
+    bool probing;
+    bool stale;                  /* Probe again at the next sweep */
+    
+    struct remoteio_route* next;
+} remoteio_route_t;
+
+typedef struct remoteio_route_table {
+    remoteio_route_t* buckets[REMOTEIO_ROUTE_BUCKETS];
+    int probing;                 /* Probes running */
+    bool stopping;
+    
+    /* Statistics */
+    uint64_t probes;
+    uint64_t reprobes;           /* Periodic or after a failure */
+    
+    pthread_mutex_t lock;
+    pthread_cond_t cond;         /* A probe finished */
+} remoteio_route_table_t;
+
+/*
+ * Completion reactor: one thread per context completes every op. It waits
+ * in epoll on the sockets of all TCP connections, parsing response frames
+ * as their bytes arrive, and polls the completion queues of RDMA endpoints
+ * between waits. Completing an op signals that op's own condition variable
+ * and runs its callback on the reactor thread.
+ */
+#define REMOTEIO_REACTOR_EVENTS      64
+#define REMOTEIO_REACTOR_CQ_POLL_MS  1      /* epoll timeout while RDMA endpoints are registered */
+#define REMOTEIO_REACTOR_CQ_BATCH    64     /* Completions reaped per endpoint per pass */
+#define REMOTEIO_REACTOR_RX_FRAMES   64     /* Frames parsed per connection per event */
+
+typedef struct remoteio_reactor {
+    int epoll_fd;
+    int wake_fd;                 /* eventfd: stop requests */
+    
+    /* Registered connections (lock) */
+    remoteio_connection_t** conns;
+    int num_conns;
+    int max_conns;
+    int num_rdma;
+    
+    /* Statistics (lock) */
+    uint64_t wakeups;            /* Returns from epoll_wait */
+    uint64_t rx_events;          /* Readable sockets serviced */
+    uint64_t cq_polls;
+    uint64_t conn_failures;      /* Streams the parser gave up on */
+    
+    pthread_mutex_t lock;
+} remoteio_reactor_t;
+
+/*
+ * Remote region cache: descriptors of the named regions peers advertised,
+ * by peer and name. Lookups fill it on the reactor thread as LOOKUP_RESP
+ * frames arrive, so an INVALIDATE that follows on the same connection
+ * always lands after them. An INVALIDATE, or a one-sided op the peer
+ * refuses with GPUIO_ERROR_PERMISSION, drops the peer's entries for that
+ * rkey; the next lookup asks again.
+ */
+#define REMOTEIO_REGION_BUCKETS      64
+#define REMOTEIO_LOOKUP_TIMEOUT_US   5000000ULL
+
+typedef struct remoteio_region_entry {
+    char name[REMOTEIO_MAX_RESOURCE];
+    remoteio_remote_mem_t mem;   /* peer_addr and peer_port name the peer */
+    struct remoteio_region_entry* next;
+} remoteio_region_entry_t;
+
+typedef struct remoteio_region_cache {
+    remoteio_region_entry_t* buckets[REMOTEIO_REGION_BUCKETS];
+    int num_entries;
+    
+    /* Statistics */
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t invalidations;      /* Entries dropped */
+    
+    pthread_mutex_t lock;
+} remoteio_region_cache_t;
+
 /* Network listener */
 typedef struct remoteio_listener {
     int socket_fd;
@@ -170,6 +651,8 @@ typedef struct remoteio_listener {
     pthread_t thread;
     int running;
     
+    char* path;                  /* Unix socket, unlinked on stop */
+    
     pthread_mutex_t lock;
 } remoteio_listener_t;
 
@@ -182,6 +665,8 @@ typedef struct remoteio_context {
     int use_gdr;                 /* GPUDirect RDMA */
     int use_inline;              /* Inline small messages */
     size_t inline_threshold;
+    int use_compression;         /* Ask peers for LZ4 wire compression */
+    gpuio_codec_t codec;         /* LZ4; NULL if unavailable */
     
     /* Connection management */
     remoteio_conn_pool_t conn_pool;
@@ -191,14 +676,26 @@ typedef struct remoteio_context {
     remoteio_gdr_region_t* gdr_regions;
     pthread_mutex_t gdr_lock;
     
-    /* Operations */
-    remoteio_operation_t* pending_ops;
-    remoteio_operation_t* free_ops;
+    /* Regions peers advertised */
+    remoteio_region_cache_t region_cache;
+    
+    /* Transports chosen per peer under AUTO */
+    remoteio_route_table_t routes;
+    
+    /* Operations: preallocated slab behind a lock-free free stack */
+    remoteio_operation_t* op_slab;
+    uint32_t* op_links;          /* Free-stack link per slab op (index + 1) */
+    uint32_t op_slab_size;
+    uint64_t op_free_head;       /* ABA tag << 32 | top index + 1 */
+    uint64_t op_cache_id;        /* Validates per-thread op caches */
+    uint64_t op_heap_allocs;     /* Ops allocated past the slab */
     uint64_t next_op_id;
+    struct remoteio_context* next_live;
     pthread_mutex_t ops_lock;
     pthread_cond_t ops_cond;
     
-    /* Worker thread for async completions */
+    /* Completion reactor; completion_thread runs it */
+    remoteio_reactor_t reactor;
     pthread_t completion_thread;
     int completion_running;
     
@@ -214,12 +711,303 @@ typedef struct remoteio_context {
     uint64_t requests_submitted;
     uint64_t requests_completed;
     uint64_t rdma_ops;
-    uint64_t tcp_fallbacks;
+    uint64_t tcp_fallbacks;      /* Connections that wanted RDMA or shm and got the stream */
     
     /* Thread safety */
     pthread_mutex_t stats_lock;
 } remoteio_context_t;
 
+/* ============================================================================
+ * Storage Server
+ * ============================================================================ */
+
+/*
+ * Serves the wire protocol above to remoteio clients. The listener thread
+ * hands accepted sockets to one epoll event thread, which parses request
+ * frames without blocking and queues them to a small worker pool; workers
+ * execute them against the exported resources and write the responses.
+ *
+ * Resources are named "<export>" for a memory region and
+ * "<export>/<relative path>" for a file under an exported directory.
+ *
+ * Memory may also be registered for one-sided access (the soft RDMA
+ * transport). RDMA_READ and RDMA_WRITE frames name a server address and
+ * the rkey it was registered under, not a resource; the event thread
+ * executes them itself once the access is within a region the rkey grants
+ * it, as a NIC would, and answers with READ_RESP/WRITE_RESP. Regions
+ * registered under a name are advertised to clients that look them up.
+ */
+#define REMOTEIO_SERVER_WORKERS      4
+#define REMOTEIO_SERVER_QUEUE_DEPTH  32           /* Outstanding frames per client */
+#define REMOTEIO_SERVER_CREDIT_BYTES (4 * 1024 * 1024)  /* Payload window per client */
+
+/* Region access rights */
+#define REMOTEIO_ACCESS_REMOTE_READ  0x0001
+#define REMOTEIO_ACCESS_REMOTE_WRITE 0x0002
+
+typedef enum {
+    REMOTEIO_EXPORT_DIR = 0,
+    REMOTEIO_EXPORT_MEMORY = 1,
+} remoteio_export_type_t;
+
+typedef struct remoteio_export {
+    char name[REMOTEIO_MAX_RESOURCE];
+    remoteio_export_type_t type;
+    char* path;                  /* REMOTEIO_EXPORT_DIR */
+    void* base;                  /* REMOTEIO_EXPORT_MEMORY */
+    size_t size;
+    bool writable;
+    struct remoteio_export* next;
+} remoteio_export_t;
+
+/* A file under an exported directory, kept open between requests */
+typedef struct remoteio_server_file {
+    char* path;
+    int fd;
+    bool writable;
+    uint64_t size;
+    
+    int refs;                    /* Server files_lock */
+    struct remoteio_server_file* next;
+} remoteio_server_file_t;
+
+/* Memory registered for one-sided access */
+typedef struct remoteio_server_region {
+    char name[REMOTEIO_MAX_RESOURCE];    /* Empty: not advertised */
+    uint64_t addr;
+    size_t length;
+    uint32_t rkey;               /* Random, never 0 */
+    uint32_t access;             /* REMOTEIO_ACCESS_* */
+    struct remoteio_server_region* next;
+} remoteio_server_region_t;
+
+struct remoteio_server_client;
+
+/* One decoded request frame */
+typedef struct remoteio_server_req {
+    struct remoteio_server_client* client;
+    remoteio_msg_hdr_t hdr;
+    char resource[REMOTEIO_MAX_RESOURCE];
+    char* payload;               /* WRITE chunk, hdr.chunk_len bytes */
+    struct remoteio_server_req* next;
+} remoteio_server_req_t;
+
+/* Progress of a chunked WRITE, answered once all of its bytes landed */
+typedef struct remoteio_server_write {
+    uint64_t req_id;
+    uint64_t done;
+    bool last_seen;
+    gpuio_error_t status;
+    struct remoteio_server_write* next;
+} remoteio_server_write_t;
+
+/* A response frame queued for the workers to send, payload copied in */
+typedef struct remoteio_server_out {
+    remoteio_msg_hdr_t hdr;
+    struct remoteio_server_out* next;
+    char payload[];
+} remoteio_server_out_t;
+
+typedef struct remoteio_server_client {
+    struct remoteio_server* server;
+    remoteio_connection_t* conn;
+    int fd;                      /* What the event loop watches: the socket, or the rings */
+    
+    /* Frame being received (event thread only) */
+    uint8_t rx_hdr[REMOTEIO_MSG_HDR_SIZE];
+    size_t rx_pos;               /* Bytes of the current frame received */
+    remoteio_server_req_t* rx_req;
+    
+    bool hello_done;             /* Event thread: HELLO only comes first */
+    
+    /* Event thread: a same-host client that hasn't handed over its rings,
+     * refused if they aren't in by the deadline */
+    bool shm_hello;
+    uint64_t shm_deadline_ms;
+    
+    /* Queue-depth limit: reading stops while the client is at it */
+    int inflight;
+    bool paused;
+    bool closed;
+    
+    remoteio_server_write_t* writes;
+    
+    /* Frames queued by server_post (lock). While flush_queued, one worker
+     * owns sending them and holds a reference. */
+    remoteio_server_out_t* out_head;
+    remoteio_server_out_t* out_tail;
+    bool flush_queued;
+    struct remoteio_server_client* flush_next;
+    
+    /* Flow control, if negotiated (lock). The event thread alone counts
+     * what arrived; limits are released + window. */
+    bool credits;
+    uint32_t rx_ops;
+    uint32_t rx_bytes;
+    uint32_t released_ops;
+    uint32_t released_bytes;
+    uint32_t announced_ops;      /* Released totals the client was last told */
+    uint32_t announced_bytes;
+    
+    /* Event thread and each queued request hold a reference */
+    int refs;
+    pthread_mutex_t lock;
+    pthread_mutex_t send_lock;   /* Response frames are written whole */
+    
+    struct remoteio_server_client* next;
+} remoteio_server_client_t;
+
+/* reads, writes and errors count ops, however many frames each took;
+ * the byte counters count payload */
+typedef struct remoteio_server_stats {
+    uint64_t clients_accepted;
+    uint64_t reads;              /* Named READ ops served */
+    uint64_t writes;             /* Named WRITE ops fully landed */
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t errors;             /* Named ops that failed */
+    uint64_t throttled;          /* Times a client hit its queue-depth limit */
+    uint64_t sendfile_bytes;     /* File reads sent from the page cache */
+    uint64_t zerocopy_bytes;     /* Memory reads sent with MSG_ZEROCOPY */
+    uint64_t compressed_clients; /* Clients granted REMOTEIO_CAP_LZ4 */
+    uint64_t one_sided_reads;
+    uint64_t one_sided_writes;
+    uint64_t access_violations;  /* One-sided frames refused: rkey, bounds, rights */
+    uint64_t lookups;
+    uint64_t invalidations_sent;
+    uint64_t credit_frames;      /* CREDIT frames sent: no response to ride on */
+    uint64_t shm_clients;        /* Of clients_accepted, those on shared memory */
+} remoteio_server_stats_t;
+
+typedef struct remoteio_server {
+    remoteio_context_t* ctx;
+    remoteio_listener_t* listener;
+    remoteio_listener_t* shm_listener;  /* Same-host control socket, if it could bind */
+    int port;
+    int queue_depth;
+    uint32_t credit_ops;         /* Per-client credit windows */
+    uint32_t credit_bytes;
+    
+    /* Exports and one-sided regions; one-sided frames hold it shared while
+     * they touch region memory */
+    remoteio_export_t* exports;
+    remoteio_server_region_t* regions;
+    pthread_rwlock_t exports_lock;
+    
+    remoteio_server_file_t* files;
+    int num_files;
+    pthread_mutex_t files_lock;
+    
+    /* Event loop */
+    int epoll_fd;
+    int wake_fd;                 /* eventfd: new clients, stop */
+    pthread_t event_thread;
+    bool event_started;
+    remoteio_server_client_t* new_clients;
+    remoteio_server_client_t* clients;
+    int shm_hellos;              /* Event thread: clients with shm_hello set */
+    
+    /* Worker pool */
+    pthread_t* workers;
+    int num_workers;
+    int workers_started;
+    remoteio_server_req_t* queue_head;
+    remoteio_server_req_t* queue_tail;
+    remoteio_server_client_t* flush_head;   /* Clients with queued frames */
+    remoteio_server_client_t* flush_tail;
+    pthread_cond_t queue_cond;
+    
+    bool stopping;
+    
+    /* Guards client lists, the work queue, stopping and stats */
+    pthread_mutex_t lock;
+    remoteio_server_stats_t stats;
+} remoteio_server_t;
+
+/* ============================================================================
+ * Collectives
+ * ============================================================================ */
+
+/*
+ * Collectives over one-sided writes. Ranks 0..size-1 each run a server and
+ * join a communicator under a common name; rank r registers one region,
+ * advertised as "<name>.<r>", holding a receive channel for every peer:
+ * REMOTEIO_COLL_SLOTS slots of REMOTEIO_COLL_CHUNK bytes, a ready counter
+ * and a credit counter.
+ *
+ * A sender writes its n-th chunk for a peer into slot n % SLOTS of that
+ * peer's channel for it, then writes n + 1 to the channel's ready counter.
+ * Both go out as one chain on the same connection, so the counter never
+ * lands before the data. The receiver copies or reduces the slot out and
+ * writes the number of chunks it has consumed to the sender's credit
+ * counter for it. A sender waits while SLOTS of its chunks are unconsumed.
+ * Counters only grow, so collectives run back to back without resetting
+ * anything as long as every rank calls the same ones in the same order.
+ *
+ * Buffers are cut into chunks and every rank forwards a chunk as soon as
+ * it has it, so all links of a ring or tree carry data at once. Ring
+ * allreduce is a reduce-scatter followed by an allgather; tree allreduce
+ * reduces to rank 0 up a binary tree and broadcasts the result back down.
+ */
+#define REMOTEIO_COLL_CHUNK          (256 * 1024)
+#define REMOTEIO_COLL_SLOTS          4
+#define REMOTEIO_COLL_LINE           64           /* Counters are a cache line apart */
+#define REMOTEIO_COLL_TIMEOUT_US     30000000ULL  /* No progress from a peer */
+
+typedef enum {
+    REMOTEIO_COLL_RING = 0,
+    REMOTEIO_COLL_TREE = 1,
+} remoteio_coll_algo_t;
+
+/* Our side of the channels to and from one peer */
+typedef struct remoteio_coll_peer {
+    char addr[256];
+    uint16_t port;
+    remoteio_connection_t* conn; /* Connected on first use */
+    remoteio_remote_mem_t mem;   /* Peer's channel region */
+    
+    uint64_t sent;               /* Chunks written to the peer */
+    uint64_t consumed;           /* Chunks of the peer's we released */
+    
+    /* Per slot: data write chained to its ready-counter write, and the
+     * credit write releasing the slot */
+    remoteio_operation_t* data_ops[REMOTEIO_COLL_SLOTS];
+    remoteio_operation_t* ready_ops[REMOTEIO_COLL_SLOTS];
+    remoteio_operation_t* credit_ops[REMOTEIO_COLL_SLOTS];
+    bool tx_posted[REMOTEIO_COLL_SLOTS];
+    bool credit_posted[REMOTEIO_COLL_SLOTS];
+} remoteio_coll_peer_t;
+
+typedef struct remoteio_comm_stats {
+    uint64_t collectives;
+    uint64_t chunks_sent;
+    uint64_t chunks_received;
+    uint64_t bytes_sent;
+    uint64_t slot_wait_us;       /* Senders out of credits */
+    uint64_t data_wait_us;       /* Receivers waiting for a chunk */
+} remoteio_comm_stats_t;
+
+typedef struct remoteio_comm {
+    remoteio_context_t* ctx;
+    remoteio_server_t* server;
+    char name[REMOTEIO_MAX_RESOURCE];
+    int rank;
+    int size;
+    
+    /* Our channels: counters, then the slots of each peer */
+    uint8_t* region;
+    size_t region_len;
+    uint32_t rkey;
+    
+    /* Sources of our counter writes, one word per peer and slot */
+    uint64_t* words;
+    remoteio_gdr_region_t* words_mr;
+    
+    remoteio_coll_peer_t* peers;
+    bool failed;                 /* Counters out of step: unusable */
+    remoteio_comm_stats_t stats;
+} remoteio_comm_t;
+
 /* ============================================================================
  * RDMA Functions
  * ============================================================================ */
@@ -235,6 +1023,7 @@ int remoteio_rdma_connect(remoteio_context_t* ctx, remoteio_connection_t* conn,
                           const char* addr, uint16_t port);
 int remoteio_rdma_accept(remoteio_context_t* ctx, remoteio_connection_t* conn);
 int remoteio_rdma_disconnect(remoteio_connection_t* conn);
+int remoteio_rdma_flush(remoteio_connection_t* conn);
 
 int remoteio_rdma_post_send(remoteio_connection_t* conn, void* buf, size_t len,
                             remoteio_operation_t* op);
@@ -251,6 +1040,9 @@ int remoteio_rdma_post_write(remoteio_connection_t* conn,
                              uint64_t local_offset, uint64_t remote_offset,
                              size_t len, remoteio_operation_t* op);
 
+int remoteio_rdma_post_chain(remoteio_connection_t* conn, remoteio_operation_t* chain,
+                             int signal_every);
+
 int remoteio_rdma_poll_completions(remoteio_connection_t* conn, int max_poll);
 int remoteio_rdma_register_gpu_memory(remoteio_context_t* ctx,
                                        void* gpu_ptr, size_t length,
@@ -258,6 +1050,25 @@ int remoteio_rdma_register_gpu_memory(remoteio_context_t* ctx,
                                        remoteio_gdr_region_t** region_out);
 int remoteio_rdma_unregister_gpu_memory(remoteio_gdr_region_t* region);
 
+/* ============================================================================
+ * Soft RDMA Functions
+ * ============================================================================ */
+
+int remoteio_soft_rdma_register_memory(void* ptr, size_t length, int gpu_id,
+                                       remoteio_gdr_region_t** region_out);
+int remoteio_soft_rdma_post_read(remoteio_connection_t* conn,
+                                 remoteio_gdr_region_t* local_mr,
+                                 remoteio_remote_mem_t* remote,
+                                 uint64_t local_offset, uint64_t remote_offset,
+                                 size_t len, remoteio_operation_t* op);
+int remoteio_soft_rdma_post_write(remoteio_connection_t* conn,
+                                  remoteio_gdr_region_t* local_mr,
+                                  remoteio_remote_mem_t* remote,
+                                  uint64_t local_offset, uint64_t remote_offset,
+                                  size_t len, remoteio_operation_t* op);
+int remoteio_soft_rdma_post_chain(remoteio_connection_t* conn, remoteio_operation_t* chain,
+                                  int signal_every);
+
 /* ============================================================================
  * Network Functions
  * ============================================================================ */
@@ -270,15 +1081,137 @@ int remoteio_network_connect(remoteio_context_t* ctx, remoteio_connection_t* con
 int remoteio_network_disconnect(remoteio_connection_t* conn);
 
 int remoteio_network_send(remoteio_connection_t* conn, const void* buf, size_t len);
+int remoteio_network_sendv(remoteio_connection_t* conn, struct iovec* iov, int iovcnt,
+                           int flags);
+int remoteio_network_sendfile(remoteio_connection_t* conn, int fd, uint64_t offset,
+                              size_t len);
+
+int remoteio_network_enable_zerocopy(remoteio_connection_t* conn);
+int64_t remoteio_network_send_zerocopy(remoteio_connection_t* conn, const void* buf,
+                                       size_t len);
+int remoteio_network_zc_drain(remoteio_connection_t* conn);
+void remoteio_network_zc_release(remoteio_connection_t* conn, uint32_t first,
+                                 uint32_t last);
+int remoteio_network_zc_wait(remoteio_connection_t* conn, uint32_t seq);
 int remoteio_network_recv(remoteio_connection_t* conn, void* buf, size_t len);
+ssize_t remoteio_network_recv_some(remoteio_connection_t* conn, void* buf, size_t len);
+int remoteio_network_poll_fd(remoteio_connection_t* conn);
+void remoteio_network_shutdown(remoteio_connection_t* conn);
 int remoteio_network_send_recv(remoteio_connection_t* conn,
                                const void* send_buf, size_t send_len,
                                void* recv_buf, size_t recv_len);
 
 int remoteio_network_listen(remoteio_context_t* ctx, int port,
                             remoteio_listener_t** listener_out);
+int remoteio_network_listen_unix(remoteio_context_t* ctx, const char* path,
+                                 remoteio_listener_t** listener_out);
 int remoteio_network_stop_listen(remoteio_listener_t* listener);
 
+/* ============================================================================
+ * Shared Memory Functions
+ * ============================================================================ */
+
+bool remoteio_shm_local(const char* addr);
+int remoteio_shm_name(const char* path, uint16_t port, char* name, size_t len);
+int remoteio_shm_connect(remoteio_context_t* ctx, remoteio_connection_t* conn,
+                         const char* addr, uint16_t port);
+int remoteio_shm_accept(remoteio_connection_t* conn);
+int remoteio_shm_send(remoteio_connection_t* conn, const struct iovec* iov, int iovcnt);
+int remoteio_shm_sendfile(remoteio_connection_t* conn, int fd, uint64_t offset, size_t len);
+ssize_t remoteio_shm_recv(remoteio_connection_t* conn, void* buf, size_t len);
+void remoteio_shm_shutdown(remoteio_connection_t* conn);
+void remoteio_shm_close(remoteio_connection_t* conn);
+
+/* ============================================================================
+ * Protocol Functions
+ * ============================================================================ */
+
+void remoteio_msg_encode(const remoteio_msg_hdr_t* hdr, uint8_t out[REMOTEIO_MSG_HDR_SIZE]);
+int remoteio_msg_decode(const uint8_t in[REMOTEIO_MSG_HDR_SIZE], remoteio_msg_hdr_t* hdr);
+
+int remoteio_proto_attach(remoteio_connection_t* conn, remoteio_context_t* ctx);
+void remoteio_proto_detach(remoteio_connection_t* conn);
+int remoteio_proto_submit(remoteio_connection_t* conn, remoteio_operation_t* op);
+int remoteio_proto_submit_chain(remoteio_connection_t* conn, remoteio_operation_t* chain);
+int remoteio_proto_cancel(remoteio_connection_t* conn, remoteio_operation_t* op);
+size_t remoteio_proto_compress(remoteio_connection_t* conn, const void* src, size_t len,
+                               uint8_t* out);
+int remoteio_proto_decompress(remoteio_connection_t* conn, const uint8_t* src, size_t len,
+                              void* dst, size_t dst_cap, size_t* dst_len);
+void remoteio_conn_get_compress_stats(remoteio_connection_t* conn,
+                                      remoteio_compress_stats_t* stats, double* ratio);
+int remoteio_proto_ping(remoteio_context_t* ctx, remoteio_connection_t* conn,
+                        uint64_t timeout_us);
+int remoteio_proto_rx_ready(remoteio_connection_t* conn);
+void remoteio_proto_rx_fail(remoteio_connection_t* conn);
+int remoteio_proto_lookup(remoteio_context_t* ctx, remoteio_connection_t* conn,
+                          const char* name, remoteio_remote_mem_t* mem_out);
+
+/* ============================================================================
+ * Remote Region Cache
+ * ============================================================================ */
+
+int remoteio_region_cache_init(remoteio_region_cache_t* cache);
+void remoteio_region_cache_cleanup(remoteio_region_cache_t* cache);
+int remoteio_region_cache_get(remoteio_region_cache_t* cache, const char* addr, uint16_t port,
+                              const char* name, remoteio_remote_mem_t* mem_out);
+int remoteio_region_cache_put(remoteio_region_cache_t* cache, const char* name,
+                              const remoteio_remote_mem_t* mem);
+int remoteio_region_cache_invalidate(remoteio_region_cache_t* cache, const char* addr,
+                                     uint16_t port, uint32_t rkey);
+
+/* ============================================================================
+ * Completion Reactor
+ * ============================================================================ */
+
+int remoteio_reactor_start(remoteio_context_t* ctx);
+void remoteio_reactor_stop(remoteio_context_t* ctx);
+int remoteio_reactor_add(remoteio_reactor_t* reactor, remoteio_connection_t* conn);
+void remoteio_reactor_remove(remoteio_reactor_t* reactor, remoteio_connection_t* conn);
+void remoteio_op_complete(remoteio_connection_t* conn, remoteio_operation_t* op,
+                          gpuio_error_t status);
+void remoteio_op_complete_batch(remoteio_connection_t* conn, remoteio_operation_t* op,
+                                gpuio_error_t status);
+
+/* ============================================================================
+ * Server Functions
+ * ============================================================================ */
+
+int remoteio_server_create(remoteio_context_t* ctx, int num_workers, int queue_depth,
+                           remoteio_server_t** server_out);
+void remoteio_server_destroy(remoteio_server_t* server);
+
+int remoteio_server_export_dir(remoteio_server_t* server, const char* name,
+                               const char* path, bool writable);
+int remoteio_server_export_memory(remoteio_server_t* server, const char* name,
+                                  void* base, size_t size, bool writable);
+
+int remoteio_server_register_region(remoteio_server_t* server, const char* name,
+                                    void* base, size_t length, uint32_t access,
+                                    remoteio_remote_mem_t* mem_out);
+int remoteio_server_deregister_region(remoteio_server_t* server, uint32_t rkey);
+
+int remoteio_server_start(remoteio_server_t* server, int port);
+int remoteio_server_start_unix(remoteio_server_t* server, const char* path);
+int remoteio_server_stop(remoteio_server_t* server);
+int remoteio_server_get_stats(remoteio_server_t* server, remoteio_server_stats_t* stats);
+
+/* ============================================================================
+ * Collective Functions
+ * ============================================================================ */
+
+int remoteio_comm_create(remoteio_context_t* ctx, remoteio_server_t* server,
+                         const char* name, int rank, int size,
+                         const char* const* peers, remoteio_comm_t** comm_out);
+void remoteio_comm_destroy(remoteio_comm_t* comm);
+int remoteio_comm_get_stats(remoteio_comm_t* comm, remoteio_comm_stats_t* stats);
+int remoteio_coll_broadcast(remoteio_comm_t* comm, void* buf, size_t len, int root,
+                            remoteio_coll_algo_t algo);
+int remoteio_coll_allgather(remoteio_comm_t* comm, void* buf, size_t len_per_rank);
+int remoteio_coll_reduce_scatter(remoteio_comm_t* comm, float* buf, size_t count_per_rank);
+int remoteio_coll_allreduce(remoteio_comm_t* comm, float* buf, size_t count,
+                            remoteio_coll_algo_t algo);
+
 /* ============================================================================
  * Connection Management
  * ============================================================================ */
@@ -289,19 +1222,46 @@ int remoteio_conn_destroy(remoteio_connection_t* conn);
 int remoteio_conn_acquire(remoteio_connection_t* conn);
 int remoteio_conn_release(remoteio_connection_t* conn);
 
-int remoteio_conn_pool_init(remoteio_conn_pool_t* pool, int max_conns);
+int remoteio_conn_pool_init(remoteio_conn_pool_t* pool, remoteio_context_t* ctx,
+                            int max_conns);
 void remoteio_conn_pool_cleanup(remoteio_conn_pool_t* pool);
 remoteio_connection_t* remoteio_conn_pool_get(remoteio_conn_pool_t* pool,
-                                               const char* addr, uint16_t port);
+                                               const char* addr, uint16_t port, int stream,
+                                               remoteio_transport_t transport);
+int remoteio_conn_pool_add(remoteio_conn_pool_t* pool, remoteio_connection_t* conn);
 int remoteio_conn_pool_put(remoteio_conn_pool_t* pool, remoteio_connection_t* conn);
+int remoteio_conn_pool_stripe_width(remoteio_conn_pool_t* pool, const char* addr,
+                                    uint16_t port);
+void remoteio_conn_pool_stripe_update(remoteio_conn_pool_t* pool, const char* addr,
+                                      uint16_t port, int wanted, int used,
+                                      uint64_t bytes, uint64_t elapsed_us);
+
+/* ============================================================================
+ * Transport Selection
+ * ============================================================================ */
+
+int remoteio_route_table_init(remoteio_route_table_t* table);
+void remoteio_route_table_stop(remoteio_route_table_t* table);
+void remoteio_route_table_cleanup(remoteio_route_table_t* table);
+remoteio_transport_t remoteio_route_pick(remoteio_context_t* ctx, const char* addr,
+                                         uint16_t port, bool one_sided, size_t size);
+void remoteio_route_failed(remoteio_context_t* ctx, const char* addr, uint16_t port);
+void remoteio_route_sweep(remoteio_context_t* ctx);
+int remoteio_route_get(remoteio_context_t* ctx, const char* addr, uint16_t port,
+                       remoteio_route_t* route_out);
 
 /* ============================================================================
  * Operation Management
  * ============================================================================ */
 
+int remoteio_op_slab_init(remoteio_context_t* ctx, uint32_t max_ops);
+void remoteio_op_slab_cleanup(remoteio_context_t* ctx);
 remoteio_operation_t* remoteio_op_alloc(remoteio_context_t* ctx);
 void remoteio_op_free(remoteio_context_t* ctx, remoteio_operation_t* op);
 int remoteio_op_submit(remoteio_context_t* ctx, remoteio_operation_t* op);
+int remoteio_op_chain_prepare(remoteio_operation_t* chain, int signal_every);
+int remoteio_op_post_chain(remoteio_context_t* ctx, remoteio_operation_t* chain,
+                           int signal_every);
 int remoteio_op_wait(remoteio_operation_t* op, uint64_t timeout_us);
 int remoteio_op_cancel(remoteio_operation_t* op);
 
@@ -320,6 +1280,17 @@ const char* remoteio_transport_str(remoteio_transport_t transport);
 remoteio_context_t* remoteio_context_create(gpuio_context_t parent);
 void remoteio_context_destroy(remoteio_context_t* ctx);
 
+int remoteio_connect(remoteio_context_t* ctx, const char* addr, uint16_t port,
+                     remoteio_connection_t** conn_out);
+int remoteio_connect_stream(remoteio_context_t* ctx, const char* addr, uint16_t port,
+                            int stream, remoteio_connection_t** conn_out);
+int remoteio_connect_transport(remoteio_context_t* ctx, const char* addr, uint16_t port,
+                               int stream, remoteio_transport_t transport,
+                               remoteio_connection_t** conn_out);
+int remoteio_connect_route(remoteio_context_t* ctx, const char* addr, uint16_t port,
+                           bool one_sided, size_t size, remoteio_connection_t** conn_out);
+int remoteio_disconnect(remoteio_context_t* ctx, remoteio_connection_t* conn);
+
 int remoteio_read(remoteio_context_t* ctx, const char* uri, void* buf,
                   size_t count, uint64_t offset);
 int remoteio_write(remoteio_context_t* ctx, const char* uri, const void* buf,
@@ -329,7 +1300,14 @@ int remoteio_read_gpu(remoteio_context_t* ctx, const char* uri, void* gpu_buf,
 int remoteio_write_gpu(remoteio_context_t* ctx, const char* uri,
                        const void* gpu_buf, size_t count, uint64_t offset);
 
+int remoteio_register_local(remoteio_context_t* ctx, void* ptr, size_t length,
+                            int gpu_id, remoteio_gdr_region_t** region_out);
+int remoteio_resolve(remoteio_context_t* ctx, const char* uri,
+                     remoteio_remote_mem_t* mem_out);
+
 int remoteio_get_stats(remoteio_context_t* ctx, uint64_t* bytes_read,
                        uint64_t* bytes_written, uint64_t* requests);
+int remoteio_get_transport_stats(remoteio_context_t* ctx, uint64_t* tcp_fallbacks,
+                                 uint64_t* probes, uint64_t* reprobes);
 
 #endif /* REMOTEIO_INTERNAL_H */
@@ -0,0 +1,419 @@
+/**
+ * @file route.c
+ * @brief RemoteIO module - Transport selection
+ * @version 1.0.0
+ *
+ * Chooses transports per peer and size class under REMOTEIO_TRANSPORT_AUTO.
+ * The first connection to a peer probes it: PINGs echoing each class's
+ * probe size time the framed stream for named requests, and reads of the
+ * peer's probe region time soft RDMA over that stream and, with a NIC,
+ * RDMA. A peer on this host is timed over shared memory as well, both
+ * ways. Probes go over the pooled connections later ops use, so they cost
+ * nothing but the round trips.
+ *
+ * A peer that advertises no probe region can't be timed one-sided; it
+ * keeps the old preference of RDMA whenever an endpoint connects.
+ */
+
+#include "remoteio_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Payload each class is timed with */
+static const size_t route_probe_bytes[REMOTEIO_ROUTE_CLASSES] = {
+    64, 16 * 1024, REMOTEIO_ROUTE_PROBE_BYTES,
+};
+
+static uint64_t route_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static int route_class(size_t size) {
+    if (size <= REMOTEIO_ROUTE_SMALL) return 0;
+    if (size <= REMOTEIO_ROUTE_MEDIUM) return 1;
+    return 2;
+}
+
+/* FNV-1a over host and port */
+static int route_bucket(const char* addr, uint16_t port) {
+    uint32_t h = 2166136261u;
+    for (const char* p = addr; *p; p++) {
+        h ^= (uint8_t)*p;
+        h *= 16777619u;
+    }
+    h ^= port;
+    h *= 16777619u;
+    return (int)(h % REMOTEIO_ROUTE_BUCKETS);
+}
+
+/* Called with the table lock held */
+static remoteio_route_t* route_find(remoteio_route_table_t* table, const char* addr,
+                                    uint16_t port, bool create) {
+    int b = route_bucket(addr, port);
+    for (remoteio_route_t* route = table->buckets[b]; route; route = route->next) {
+        if (route->port == port && strcmp(route->addr, addr) == 0) return route;
+    }
+    if (!create) return NULL;
+    
+    remoteio_route_t* route = calloc(1, sizeof(*route));
+    if (!route) return NULL;
+    
+    snprintf(route->addr, sizeof(route->addr), "%s", addr);
+    route->port = port;
+    for (int c = 0; c < REMOTEIO_ROUTE_CLASSES; c++) {
+        route->named[c] = REMOTEIO_TRANSPORT_TCP;
+        route->one_sided[c] = REMOTEIO_TRANSPORT_SOFT_RDMA;
+    }
+    route->next = table->buckets[b];
+    table->buckets[b] = route;
+    return route;
+}
+
+int remoteio_route_table_init(remoteio_route_table_t* table) {
+    if (!table) return -1;
+    
+    memset(table, 0, sizeof(*table));
+    pthread_mutex_init(&table->lock, NULL);
+    pthread_cond_init(&table->cond, NULL);
+    return 0;
+}
+
+/* Start no more probes and wait out running ones; they use the transports
+ * the context is about to tear down */
+void remoteio_route_table_stop(remoteio_route_table_t* table) {
+    if (!table) return;
+    
+    pthread_mutex_lock(&table->lock);
+    table->stopping = true;
+    while (table->probing > 0) {
+        pthread_cond_wait(&table->cond, &table->lock);
+    }
+    pthread_mutex_unlock(&table->lock);
+}
+
+void remoteio_route_table_cleanup(remoteio_route_table_t* table) {
+    if (!table) return;
+    
+    for (int b = 0; b < REMOTEIO_ROUTE_BUCKETS; b++) {
+        while (table->buckets[b]) {
+            remoteio_route_t* next = table->buckets[b]->next;
+            free(table->buckets[b]);
+            table->buckets[b] = next;
+        }
+    }
+    pthread_mutex_destroy(&table->lock);
+    pthread_cond_destroy(&table->cond);
+}
+
+/* ============================================================================
+ * Probing
+ * ============================================================================ */
+
+/* A probe that timed out over RDMA is still on the send queue, and the NIC
+ * may yet write into its buffer. Flush the queue, which fails the
+ * connection, and wait for the op's flushed completion. Returns false if
+ * the queue can't be flushed: the op and its buffer must then be left
+ * alone. Framed connections need nothing: freeing the op cancels it. */
+static bool route_settle(remoteio_operation_t* op) {
+    remoteio_connection_t* conn = op->conn;
+    if (conn->transport != REMOTEIO_TRANSPORT_RDMA) return true;
+    
+    pthread_mutex_lock(&conn->lock);
+    bool completed = op->completed;
+    pthread_mutex_unlock(&conn->lock);
+    if (completed) return true;
+    if (remoteio_rdma_flush(conn) != 0) return false;
+    
+    pthread_mutex_lock(&conn->lock);
+    while (!op->completed) pthread_cond_wait(&op->done_cond, &conn->lock);
+    pthread_mutex_unlock(&conn->lock);
+    return true;
+}
+
+/* Best of REMOTEIO_ROUTE_ROUNDS round trips of op after a warm-up one, in
+ * ns; 0 if any fails. op is set up by the caller and reused. *stuck is
+ * set if a timed-out op could not be settled and must not be freed. */
+static uint64_t route_time(remoteio_context_t* ctx, remoteio_operation_t* op, bool* stuck) {
+    uint64_t best = 0;
+    
+    for (int r = 0; r <= REMOTEIO_ROUTE_ROUNDS; r++) {
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (remoteio_op_submit(ctx, op) != 0) return 0;
+        if (remoteio_op_wait(op, REMOTEIO_ROUTE_PROBE_US) != 0 ||
+            op->status != GPUIO_SUCCESS) {
+            *stuck = !route_settle(op);
+            return 0;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        
+        uint64_t ns = (uint64_t)(t1.tv_sec - t0.tv_sec) * 1000000000ULL +
+                      (uint64_t)(t1.tv_nsec - t0.tv_nsec);
+        if (r > 0 && (best == 0 || ns < best)) best = ns ? ns : 1;
+    }
+    return best;
+}
+
+/* Time echoing PINGs of each class's probe size over a stream */
+static void route_time_named(remoteio_context_t* ctx, remoteio_connection_t* conn,
+                             char* buf, uint64_t ns[REMOTEIO_ROUTE_CLASSES]) {
+    for (int c = 0; c < REMOTEIO_ROUTE_CLASSES; c++) {
+        remoteio_operation_t* op = remoteio_op_alloc(ctx);
+        if (!op) return;
+        
+        op->op = REMOTEIO_OP_PING;
+        op->conn = conn;
+        op->local_buf = buf;
+        op->length = route_probe_bytes[c];
+        bool stuck = false;
+        ns[c] = route_time(ctx, op, &stuck);
+        remoteio_op_free(ctx, op);
+    }
+}
+
+/* Time one-sided reads of each class's probe size from the probe region.
+ * Returns false if a probe was left on an RDMA queue that couldn't be
+ * flushed, leaking it: mr and its memory must then be kept as well. */
+static bool route_time_one_sided(remoteio_context_t* ctx, remoteio_connection_t* conn,
+                                 remoteio_gdr_region_t* mr, remoteio_remote_mem_t* probe,
+                                 uint64_t ns[REMOTEIO_ROUTE_CLASSES]) {
+    for (int c = 0; c < REMOTEIO_ROUTE_CLASSES; c++) {
+        if (route_probe_bytes[c] > probe->length) break;
+        
+        remoteio_operation_t* op = remoteio_op_alloc(ctx);
+        if (!op) break;
+        
+        op->op = REMOTEIO_OP_READ;
+        op->conn = conn;
+        op->local_gdr = mr;
+        op->remote_mem = probe;
+        op->length = route_probe_bytes[c];
+        bool stuck = false;
+        ns[c] = route_time(ctx, op, &stuck);
+        if (stuck) return false;
+        remoteio_op_free(ctx, op);
+    }
+    return true;
+}
+
+/* The transport with the fastest round trip for a class, or fallback */
+static remoteio_transport_t route_best(uint64_t ns[REMOTEIO_TRANSPORT_COUNT][REMOTEIO_ROUTE_CLASSES],
+                                       int c, remoteio_transport_t fallback) {
+    remoteio_transport_t best = fallback;
+    uint64_t best_ns = 0;
+    
+    for (int t = 0; t < REMOTEIO_TRANSPORT_COUNT; t++) {
+        if (ns[t][c] > 0 && (best_ns == 0 || ns[t][c] < best_ns)) {
+            best = (remoteio_transport_t)t;
+            best_ns = ns[t][c];
+        }
+    }
+    return best;
+}
+
+/* Probe every transport to the peer into result */
+static void route_probe(remoteio_context_t* ctx, const char* addr, uint16_t port,
+                        remoteio_route_t* result) {
+    memset(result->named_ns, 0, sizeof(result->named_ns));
+    memset(result->one_sided_ns, 0, sizeof(result->one_sided_ns));
+    for (int c = 0; c < REMOTEIO_ROUTE_CLASSES; c++) {
+        result->named[c] = REMOTEIO_TRANSPORT_TCP;
+        result->one_sided[c] = REMOTEIO_TRANSPORT_SOFT_RDMA;
+    }
+    
+    char* buf = malloc(REMOTEIO_ROUTE_PROBE_BYTES);
+    remoteio_gdr_region_t* soft_mr = NULL;
+    remoteio_gdr_region_t* rdma_mr = NULL;
+    remoteio_remote_mem_t probe;
+    bool has_probe = false;
+    bool rdma_up = false;
+    bool settled = true;
+    
+    if (!buf || remoteio_soft_rdma_register_memory(buf, REMOTEIO_ROUTE_PROBE_BYTES, 0,
+                                                   &soft_mr) != 0) {
+        free(buf);
+        return;
+    }
+    
+    /* The framed stream: named requests, and one-sided ops in software */
+    remoteio_connection_t* conn;
+    if (remoteio_connect_transport(ctx, addr, port, 0, REMOTEIO_TRANSPORT_SOFT_RDMA,
+                                   &conn) == 0) {
+        route_time_named(ctx, conn, buf, result->named_ns[REMOTEIO_TRANSPORT_TCP]);
+        has_probe = remoteio_proto_lookup(ctx, conn, REMOTEIO_ROUTE_PROBE_REGION, &probe) == 0;
+        if (has_probe) {
+            route_time_one_sided(ctx, conn, soft_mr, &probe,
+                                 result->one_sided_ns[REMOTEIO_TRANSPORT_SOFT_RDMA]);
+        }
+        remoteio_disconnect(ctx, conn);
+    }
+    
+    /* A server on this host: the same protocol over shared-memory rings */
+    if (remoteio_shm_local(addr) &&
+        remoteio_connect_transport(ctx, addr, port, 0, REMOTEIO_TRANSPORT_SHM, &conn) == 0) {
+        route_time_named(ctx, conn, buf, result->named_ns[REMOTEIO_TRANSPORT_SHM]);
+        if (has_probe) {
+            route_time_one_sided(ctx, conn, soft_mr, &probe,
+                                 result->one_sided_ns[REMOTEIO_TRANSPORT_SHM]);
+        }
+        remoteio_disconnect(ctx, conn);
+    }
+    
+    /* A NIC: RDMA, which the peer may or may not serve */
+    if (ctx->use_gdr && ctx->rdma_ctx &&
+        remoteio_connect_transport(ctx, addr, port, 0, REMOTEIO_TRANSPORT_RDMA, &conn) == 0) {
+        rdma_up = true;
+        if (has_probe &&
+            remoteio_rdma_register_gpu_memory(ctx, buf, REMOTEIO_ROUTE_PROBE_BYTES, 0,
+                                              &rdma_mr) == 0) {
+            settled = route_time_one_sided(ctx, conn, rdma_mr, &probe,
+                                           result->one_sided_ns[REMOTEIO_TRANSPORT_RDMA]);
+            if (settled) remoteio_rdma_unregister_gpu_memory(rdma_mr);
+        }
+        remoteio_disconnect(ctx, conn);
+    }
+    
+    for (int c = 0; c < REMOTEIO_ROUTE_CLASSES; c++) {
+        result->named[c] = route_best(result->named_ns, c, REMOTEIO_TRANSPORT_TCP);
+        if (has_probe) {
+            result->one_sided[c] = route_best(result->one_sided_ns, c,
+                                              REMOTEIO_TRANSPORT_SOFT_RDMA);
+        } else {
+            result->one_sided[c] = rdma_up ? REMOTEIO_TRANSPORT_RDMA :
+                                             REMOTEIO_TRANSPORT_SOFT_RDMA;
+        }
+    }
+    
+    remoteio_rdma_unregister_gpu_memory(soft_mr);
+    if (settled) free(buf);
+}
+
+/* Probe a route claimed with probing set, and publish the outcome */
+static void route_run(remoteio_context_t* ctx, remoteio_route_t* route) {
+    remoteio_route_table_t* table = &ctx->routes;
+    remoteio_route_t result;
+    
+    route_probe(ctx, route->addr, route->port, &result);
+    
+    pthread_mutex_lock(&table->lock);
+    memcpy(route->named, result.named, sizeof(route->named));
+    memcpy(route->one_sided, result.one_sided, sizeof(route->one_sided));
+    memcpy(route->named_ns, result.named_ns, sizeof(route->named_ns));
+    memcpy(route->one_sided_ns, result.one_sided_ns, sizeof(route->one_sided_ns));
+    route->probed_us = route_now_us();
+    route->probes++;
+    route->probing = false;
+    route->stale = false;
+    table->probing--;
+    table->probes++;
+    pthread_cond_broadcast(&table->cond);
+    pthread_mutex_unlock(&table->lock);
+}
+
+/* ============================================================================
+ * Decisions
+ * ============================================================================ */
+
+/**
+ * Transport for ops of size bytes to a peer: the preferred one, or under
+ * AUTO the one its route picks. A peer seen for the first time is probed
+ * first; threads asking meanwhile wait for that probe.
+ */
+remoteio_transport_t remoteio_route_pick(remoteio_context_t* ctx, const char* addr,
+                                         uint16_t port, bool one_sided, size_t size) {
+    if (ctx->preferred_transport != REMOTEIO_TRANSPORT_AUTO) return ctx->preferred_transport;
+    
+    remoteio_route_table_t* table = &ctx->routes;
+    remoteio_transport_t fallback = one_sided ? REMOTEIO_TRANSPORT_SOFT_RDMA :
+                                                REMOTEIO_TRANSPORT_TCP;
+    int c = route_class(size);
+    
+    pthread_mutex_lock(&table->lock);
+    
+    remoteio_route_t* route = route_find(table, addr, port, true);
+    if (!route) {
+        pthread_mutex_unlock(&table->lock);
+        return fallback;
+    }
+    
+    if (route->probed_us == 0 && !route->probing && !table->stopping) {
+        route->probing = true;
+        table->probing++;
+        pthread_mutex_unlock(&table->lock);
+        
+        route_run(ctx, route);
+        
+        pthread_mutex_lock(&table->lock);
+    }
+    while (route->probed_us == 0 && route->probing) {
+        pthread_cond_wait(&table->cond, &table->lock);
+    }
+    
+    remoteio_transport_t transport = one_sided ? route->one_sided[c] : route->named[c];
+    pthread_mutex_unlock(&table->lock);
+    
+    return transport;
+}
+
+/* A transfer over the peer's route failed; probe it again at the next sweep */
+void remoteio_route_failed(remoteio_context_t* ctx, const char* addr, uint16_t port) {
+    if (!ctx || !addr || ctx->preferred_transport != REMOTEIO_TRANSPORT_AUTO) return;
+    
+    pthread_mutex_lock(&ctx->routes.lock);
+    remoteio_route_t* route = route_find(&ctx->routes, addr, port, false);
+    if (route) {
+        route->failures++;
+        route->stale = true;
+    }
+    pthread_mutex_unlock(&ctx->routes.lock);
+}
+
+/* Probe routes that went stale or are due; called by the pool thread */
+void remoteio_route_sweep(remoteio_context_t* ctx) {
+    remoteio_route_table_t* table = &ctx->routes;
+    uint64_t now = route_now_us();
+    
+    for (;;) {
+        remoteio_route_t* due = NULL;
+        
+        pthread_mutex_lock(&table->lock);
+        for (int b = 0; b < REMOTEIO_ROUTE_BUCKETS && !due && !table->stopping; b++) {
+            for (remoteio_route_t* route = table->buckets[b]; route; route = route->next) {
+                if (!route->probing && route->probed_us != 0 && route->probed_us < now &&
+                    (route->stale || now - route->probed_us >= REMOTEIO_ROUTE_REPROBE_US)) {
+                    due = route;
+                    break;
+                }
+            }
+        }
+        if (due) {
+            due->probing = true;
+            table->probing++;
+            table->reprobes++;
+        }
+        pthread_mutex_unlock(&table->lock);
+        
+        if (!due) return;
+        route_run(ctx, due);
+    }
+}
+
+/* Copy out a peer's route: what it picks per class, and the probe times
+ * behind it. Fails if the peer was never routed. */
+int remoteio_route_get(remoteio_context_t* ctx, const char* addr, uint16_t port,
+                       remoteio_route_t* route_out) {
+    if (!ctx || !addr || !route_out) return -1;
+    
+    pthread_mutex_lock(&ctx->routes.lock);
+    remoteio_route_t* route = route_find(&ctx->routes, addr, port, false);
+    if (route) {
+        *route_out = *route;
+        route_out->next = NULL;
+    }
+    pthread_mutex_unlock(&ctx->routes.lock);
+    
+    return route ? 0 : -1;
+}
@@ -0,0 +1,1708 @@
+/**
+ * @file server.c
+ * @brief RemoteIO module - Storage server
+ * @version 1.0.0
+ *
+ * Exports local directories and memory regions to remoteio clients over
+ * the framed TCP protocol. Connections come in through the listener
+ * started by remoteio_network_listen(); one epoll thread reads request
+ * frames from all clients without blocking and a small worker pool
+ * executes them. File reads go to the socket with sendfile() straight from
+ * the page cache, and large reads of exported memory are sent with
+ * MSG_ZEROCOPY, so payload is never copied through a user-space buffer.
+ * Clients that negotiated REMOTEIO_CAP_LZ4 get chunks compressed instead
+ * wherever that pays off.
+ *
+ * One-sided RDMA_READ/RDMA_WRITE frames skip the workers: the event thread
+ * executes them against the registered regions as soon as they are in.
+ * It answers LOOKUPs of named regions the same way, and deregistering a
+ * named region tells every client to drop its cached descriptor. Frames
+ * the event thread answers are queued with server_post() and written by a
+ * worker, so one client that stops reading never stalls the others. Every
+ * server advertises REMOTEIO_ROUTE_PROBE_REGION, a chunk of zeros clients
+ * read to choose a transport.
+ *
+ * Clients that negotiated REMOTEIO_CAP_CREDITS get a window of
+ * queue_depth frames and REMOTEIO_SERVER_CREDIT_BYTES of payload; a frame's
+ * credits come back when its memory is freed, announced on the next
+ * response or in a CREDIT frame. A client that oversteps is closed. For the
+ * others at most queue_depth frames may be queued or executing; at the
+ * limit the socket is dropped from the epoll set until a worker finishes
+ * one, which pushes back on the client through TCP.
+ *
+ * Clients on the same host may connect through the control socket named
+ * by remoteio_shm_name() instead and hand over shared-memory rings (see
+ * shm.c). The event thread takes them over when the client's hello comes
+ * in, so a silent client holds up nobody. The protocol over them is the
+ * same; file reads are read into the ring rather than sent from the page
+ * cache.
+ */
+
+#include "remoteio_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/random.h>
+#include <sys/stat.h>
+#include <time.h>
+
+/* Server configuration */
+#define SERVER_MAX_EVENTS          64
+#define SERVER_FRAMES_PER_EVENT    16           /* Fairness between clients */
+#define SERVER_MAX_OPEN_FILES      256          /* Idle files kept open */
+#define SERVER_MAX_WORKERS         64
+#define SERVER_HELLO_POLL_MS       100          /* Shm handshake deadline checks */
+
+/* PONG echoes and the probe region clients time one-sided reads on */
+static const char server_zeros[REMOTEIO_PROTO_CHUNK];
+
+/* ============================================================================
+ * Exports
+ * ============================================================================ */
+
+static int server_add_export(remoteio_server_t* server, remoteio_export_t* exp) {
+    pthread_rwlock_wrlock(&server->exports_lock);
+    
+    for (remoteio_export_t* e = server->exports; e; e = e->next) {
+        if (strcmp(e->name, exp->name) == 0) {
+            pthread_rwlock_unlock(&server->exports_lock);
+            return -1;
+        }
+    }
+    
+    exp->next = server->exports;
+    server->exports = exp;
+    
+    pthread_rwlock_unlock(&server->exports_lock);
+    return 0;
+}
+
+static int server_valid_name(const char* name) {
+    size_t len = name ? strlen(name) : 0;
+    return len > 0 && len < REMOTEIO_MAX_RESOURCE && !strchr(name, '/');
+}
+
+int remoteio_server_export_dir(remoteio_server_t* server, const char* name,
+                               const char* path, bool writable) {
+    if (!server || !server_valid_name(name) || !path) return -1;
+    
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) return -1;
+    
+    remoteio_export_t* exp = calloc(1, sizeof(remoteio_export_t));
+    if (!exp) return -1;
+    
+    snprintf(exp->name, sizeof(exp->name), "%s", name);
+    exp->type = REMOTEIO_EXPORT_DIR;
+    exp->path = strdup(path);
+    exp->writable = writable;
+    
+    if (!exp->path || server_add_export(server, exp) != 0) {
+        free(exp->path);
+        free(exp);
+        return -1;
+    }
+    return 0;
+}
+
+int remoteio_server_export_memory(remoteio_server_t* server, const char* name,
+                                  void* base, size_t size, bool writable) {
+    if (!server || !server_valid_name(name) || !base || size == 0) return -1;
+    
+    remoteio_export_t* exp = calloc(1, sizeof(remoteio_export_t));
+    if (!exp) return -1;
+    
+    snprintf(exp->name, sizeof(exp->name), "%s", name);
+    exp->type = REMOTEIO_EXPORT_MEMORY;
+    exp->base = base;
+    exp->size = size;
+    exp->writable = writable;
+    
+    if (server_add_export(server, exp) != 0) {
+        free(exp);
+        return -1;
+    }
+    return 0;
+}
+
+/* A relative path must stay inside its export directory */
+static int server_valid_rel(const char* rel) {
+    if (!rel || !*rel || *rel == '/') return 0;
+    
+    const char* p = rel;
+    while (*p) {
+        const char* end = strchr(p, '/');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len == 2 && p[0] == '.' && p[1] == '.') return 0;
+        if (!end) break;
+        p = end + 1;
+    }
+    return 1;
+}
+
+/* Split "<export>[/<path>]" and find the export. Exports are never removed
+ * while the server runs, so the pointer stays valid. */
+static remoteio_export_t* server_lookup(remoteio_server_t* server, const char* resource,
+                                        const char** rel_out) {
+    const char* slash = strchr(resource, '/');
+    size_t name_len = slash ? (size_t)(slash - resource) : strlen(resource);
+    remoteio_export_t* found = NULL;
+    
+    pthread_rwlock_rdlock(&server->exports_lock);
+    for (remoteio_export_t* e = server->exports; e; e = e->next) {
+        if (strlen(e->name) == name_len && memcmp(e->name, resource, name_len) == 0) {
+            found = e;
+            break;
+        }
+    }
+    pthread_rwlock_unlock(&server->exports_lock);
+    
+    *rel_out = slash ? slash + 1 : NULL;
+    return found;
+}
+
+/* ============================================================================
+ * One-Sided Regions
+ * ============================================================================ */
+
+static void server_invalidate(remoteio_server_t* server, uint32_t rkey);
+
+/* Called with exports_lock held */
+static remoteio_server_region_t* server_region_find(remoteio_server_t* server, uint32_t rkey) {
+    for (remoteio_server_region_t* r = server->regions; r; r = r->next) {
+        if (r->rkey == rkey) return r;
+    }
+    return NULL;
+}
+
+/* Called with exports_lock held */
+static remoteio_server_region_t* server_region_named(remoteio_server_t* server,
+                                                     const char* name) {
+    for (remoteio_server_region_t* r = server->regions; r; r = r->next) {
+        if (r->name[0] && strcmp(r->name, name) == 0) return r;
+    }
+    return NULL;
+}
+
+/**
+ * Register memory for one-sided access by clients. mem_out receives the
+ * address, the rkey and the length to hand them. A region given a name is
+ * also advertised: clients can look it up instead.
+ */
+int remoteio_server_register_region(remoteio_server_t* server, const char* name,
+                                    void* base, size_t length, uint32_t access,
+                                    remoteio_remote_mem_t* mem_out) {
+    if (!server || !base || length == 0 || !mem_out) return -1;
+    if (access == 0 ||
+        (access & ~(REMOTEIO_ACCESS_REMOTE_READ | REMOTEIO_ACCESS_REMOTE_WRITE))) {
+        return -1;
+    }
+    if (name && !server_valid_name(name)) return -1;
+    
+    remoteio_server_region_t* region = calloc(1, sizeof(remoteio_server_region_t));
+    if (!region) return -1;
+    
+    if (name) strcpy(region->name, name);
+    region->addr = (uint64_t)(uintptr_t)base;
+    region->length = length;
+    region->access = access;
+    
+    /* Random keys: a client can only use the ones it was given */
+    pthread_rwlock_wrlock(&server->exports_lock);
+    if (name && server_region_named(server, name)) {
+        pthread_rwlock_unlock(&server->exports_lock);
+        free(region);
+        return -1;
+    }
+    do {
+        if (getrandom(&region->rkey, sizeof(region->rkey), 0) != sizeof(region->rkey)) {
+            pthread_rwlock_unlock(&server->exports_lock);
+            free(region);
+            return -1;
+        }
+    } while (region->rkey == 0 || server_region_find(server, region->rkey));
+    region->next = server->regions;
+    server->regions = region;
+    pthread_rwlock_unlock(&server->exports_lock);
+    
+    memset(mem_out, 0, sizeof(*mem_out));
+    mem_out->raddr = region->addr;
+    mem_out->rkey = region->rkey;
+    mem_out->length = length;
+    mem_out->peer_port = (uint16_t)server->port;
+    return 0;
+}
+
+/* Revoke a region. One-sided frames already touching it finish first; none
+ * touch it once this returns. Clients are told to forget named ones. */
+int remoteio_server_deregister_region(remoteio_server_t* server, uint32_t rkey) {
+    if (!server) return -1;
+    
+    pthread_rwlock_wrlock(&server->exports_lock);
+    remoteio_server_region_t** cur = &server->regions;
+    while (*cur && (*cur)->rkey != rkey) cur = &(*cur)->next;
+    remoteio_server_region_t* region = *cur;
+    if (region) *cur = region->next;
+    pthread_rwlock_unlock(&server->exports_lock);
+    
+    if (!region) return -1;
+    
+    if (region->name[0]) server_invalidate(server, rkey);
+    free(region);
+    return 0;
+}
+
+/* Called with exports_lock held: does rkey grant access to all of
+ * [addr, addr + len)? */
+static bool server_region_check(remoteio_server_t* server, uint32_t rkey, uint64_t addr,
+                                uint64_t len, uint32_t access) {
+    remoteio_server_region_t* region = server_region_find(server, rkey);
+    if (!region || !(region->access & access)) return false;
+    
+    return addr >= region->addr && addr - region->addr <= region->length &&
+           len <= region->length - (addr - region->addr);
+}
+
+/* ============================================================================
+ * Open Files
+ * ============================================================================ */
+
+static gpuio_error_t errno_status(int err) {
+    switch (err) {
+        case ENOENT:
+        case ENOTDIR:
+            return GPUIO_ERROR_NOT_FOUND;
+        case EACCES:
+        case EPERM:
+        case EROFS:
+            return GPUIO_ERROR_PERMISSION;
+        case ENOMEM:
+            return GPUIO_ERROR_NOMEM;
+        default:
+            return GPUIO_ERROR_IO;
+    }
+}
+
+static void server_file_close(remoteio_server_file_t* file) {
+    close(file->fd);
+    free(file->path);
+    free(file);
+}
+
+static remoteio_server_file_t* server_file_get(remoteio_server_t* server,
+                                               const remoteio_export_t* exp,
+                                               const char* rel, bool create,
+                                               gpuio_error_t* status) {
+    char path[PATH_MAX];
+    if (!server_valid_rel(rel) ||
+        snprintf(path, sizeof(path), "%s/%s", exp->path, rel) >= (int)sizeof(path)) {
+        *status = GPUIO_ERROR_INVALID_ARG;
+        return NULL;
+    }
+    
+    pthread_mutex_lock(&server->files_lock);
+    
+    remoteio_server_file_t* file = server->files;
+    while (file && strcmp(file->path, path) != 0) file = file->next;
+    
+    if (file && create && !file->writable) {
+        pthread_mutex_unlock(&server->files_lock);
+        *status = GPUIO_ERROR_PERMISSION;
+        return NULL;
+    }
+    
+    if (!file) {
+        int flags = (exp->writable ? O_RDWR : O_RDONLY) | O_CLOEXEC;
+        if (create) flags |= O_CREAT;
+        
+        int fd = open(path, flags, 0644);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            *status = fd < 0 ? errno_status(errno) : GPUIO_ERROR_INVALID_ARG;
+            if (fd >= 0) close(fd);
+            pthread_mutex_unlock(&server->files_lock);
+            return NULL;
+        }
+        
+        file = calloc(1, sizeof(remoteio_server_file_t));
+        if (!file || !(file->path = strdup(path))) {
+            free(file);
+            close(fd);
+            pthread_mutex_unlock(&server->files_lock);
+            *status = GPUIO_ERROR_NOMEM;
+            return NULL;
+        }
+        
+        file->fd = fd;
+        file->writable = exp->writable;
+        file->size = (uint64_t)st.st_size;
+        
+        file->next = server->files;
+        server->files = file;
+        server->num_files++;
+    }
+    
+    file->refs++;
+    pthread_mutex_unlock(&server->files_lock);
+    
+    return file;
+}
+
+static void server_file_put(remoteio_server_t* server, remoteio_server_file_t* file) {
+    pthread_mutex_lock(&server->files_lock);
+    
+    if (--file->refs == 0 && server->num_files > SERVER_MAX_OPEN_FILES) {
+        remoteio_server_file_t** cur = &server->files;
+        while (*cur != file) cur = &(*cur)->next;
+        *cur = file->next;
+        server->num_files--;
+        server_file_close(file);
+    }
+    
+    pthread_mutex_unlock(&server->files_lock);
+}
+
+/* ============================================================================
+ * Clients
+ * ============================================================================ */
+
+static void server_client_put(remoteio_server_client_t* client) {
+    pthread_mutex_lock(&client->lock);
+    int refs = --client->refs;
+    pthread_mutex_unlock(&client->lock);
+    
+    if (refs > 0) return;
+    
+    /* Closes the socket */
+    remoteio_conn_release(client->conn);
+    
+    if (client->rx_req) {
+        free(client->rx_req->payload);
+        free(client->rx_req);
+    }
+    while (client->writes) {
+        remoteio_server_write_t* next = client->writes->next;
+        free(client->writes);
+        client->writes = next;
+    }
+    while (client->out_head) {
+        remoteio_server_out_t* next = client->out_head->next;
+        free(client->out_head);
+        client->out_head = next;
+    }
+    
+    pthread_mutex_destroy(&client->lock);
+    pthread_mutex_destroy(&client->send_lock);
+    free(client);
+}
+
+/* Event thread: stop serving a client. Queued requests still finish. */
+static void server_client_close(remoteio_server_t* server, remoteio_server_client_t* client,
+                                bool hard) {
+    pthread_mutex_lock(&client->lock);
+    client->closed = true;
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+    if (hard) remoteio_network_shutdown(client->conn);
+    pthread_mutex_unlock(&client->lock);
+    
+    if (client->shm_hello) {
+        client->shm_hello = false;
+        server->shm_hellos--;
+    }
+    
+    pthread_mutex_lock(&server->lock);
+    remoteio_server_client_t** cur = &server->clients;
+    while (*cur && *cur != client) cur = &(*cur)->next;
+    if (*cur) *cur = client->next;
+    pthread_mutex_unlock(&server->lock);
+    
+    server_client_put(client);
+}
+
+static uint64_t server_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/* Listener thread: hand an accepted connection to the event loop. A
+ * same-host client's rings are still to come when shm_hello is set. */
+static void server_client_add(remoteio_server_t* server, remoteio_connection_t* conn,
+                              bool shm_hello) {
+    remoteio_server_client_t* client = calloc(1, sizeof(remoteio_server_client_t));
+    if (!client) return;
+    
+    int flags = fcntl(conn->socket_fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(conn->socket_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        free(client);
+        return;
+    }
+    
+    /* Lets large memory-export reads go out without a copy */
+    if (!shm_hello) remoteio_network_enable_zerocopy(conn);
+    
+    remoteio_conn_acquire(conn);
+    client->server = server;
+    client->conn = conn;
+    client->fd = remoteio_network_poll_fd(conn);
+    client->shm_hello = shm_hello;
+    client->shm_deadline_ms = server_now_ms() + REMOTEIO_HELLO_TIMEOUT_MS;
+    client->refs = 1;
+    pthread_mutex_init(&client->lock, NULL);
+    pthread_mutex_init(&client->send_lock, NULL);
+    
+    pthread_mutex_lock(&server->lock);
+    if (server->stopping) {
+        pthread_mutex_unlock(&server->lock);
+        server_client_put(client);
+        return;
+    }
+    client->next = server->new_clients;
+    server->new_clients = client;
+    if (!shm_hello) server->stats.clients_accepted++;
+    pthread_mutex_unlock(&server->lock);
+    
+    uint64_t one = 1;
+    if (write(server->wake_fd, &one, sizeof(one)) < 0) {
+        /* Counter saturated; the event thread is awake anyway */
+    }
+}
+
+static void server_accept(remoteio_connection_t* conn, void* user_data) {
+    server_client_add((remoteio_server_t*)user_data, conn, false);
+}
+
+/* A client on this host hands over its rings first, on the event thread */
+static void server_shm_accept(remoteio_connection_t* conn, void* user_data) {
+    server_client_add((remoteio_server_t*)user_data, conn, true);
+}
+
+/* Event thread: take over a same-host client's rings once its hello is in;
+ * from then on the client is watched through them */
+static void server_shm_hello(remoteio_server_t* server, remoteio_server_client_t* client,
+                             uint32_t events) {
+    if ((events & (EPOLLERR | EPOLLHUP)) || remoteio_shm_accept(client->conn) != 0) {
+        server_client_close(server, client, true);
+        return;
+    }
+    
+    client->shm_hello = false;
+    server->shm_hellos--;
+    
+    pthread_mutex_lock(&client->lock);
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+    client->fd = remoteio_network_poll_fd(client->conn);
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = client };
+    int ret = epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, client->fd, &ev);
+    pthread_mutex_unlock(&client->lock);
+    if (ret != 0) {
+        server_client_close(server, client, true);
+        return;
+    }
+    
+    pthread_mutex_lock(&server->lock);
+    server->stats.clients_accepted++;
+    server->stats.shm_clients++;
+    pthread_mutex_unlock(&server->lock);
+}
+
+/* Event thread: refuse same-host clients whose hello is overdue */
+static void server_shm_expire(remoteio_server_t* server) {
+    uint64_t now = server_now_ms();
+    
+    for (;;) {
+        pthread_mutex_lock(&server->lock);
+        remoteio_server_client_t* client = server->clients;
+        while (client && !(client->shm_hello && now >= client->shm_deadline_ms)) {
+            client = client->next;
+        }
+        pthread_mutex_unlock(&server->lock);
+        if (!client) break;
+        server_client_close(server, client, true);
+    }
+}
+
+/* ============================================================================
+ * Request Intake (event thread)
+ * ============================================================================ */
+
+static void server_one_sided(remoteio_server_t* server, remoteio_server_req_t* req);
+static void server_region_lookup(remoteio_server_t* server, remoteio_server_req_t* req);
+static void server_credit_flush(remoteio_server_client_t* client);
+
+static void server_dispatch(remoteio_server_t* server, remoteio_server_client_t* client,
+                            remoteio_server_req_t* req) {
+    bool throttled = false;
+    
+    pthread_mutex_lock(&client->lock);
+    client->refs++;
+    if (++client->inflight >= server->queue_depth && !client->paused) {
+        struct epoll_event ev = { .events = 0, .data.ptr = client };
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, client->fd, &ev);
+        client->paused = true;
+        throttled = true;
+    }
+    pthread_mutex_unlock(&client->lock);
+    
+    pthread_mutex_lock(&server->lock);
+    req->next = NULL;
+    if (server->queue_tail) {
+        server->queue_tail->next = req;
+    } else {
+        server->queue_head = req;
+    }
+    server->queue_tail = req;
+    if (throttled) server->stats.throttled++;
+    pthread_cond_signal(&server->queue_cond);
+    pthread_mutex_unlock(&server->lock);
+}
+
+/* Start a frame once its header is in */
+static int server_begin_frame(remoteio_server_client_t* client) {
+    remoteio_msg_hdr_t hdr;
+    if (remoteio_msg_decode(client->rx_hdr, &hdr) != 0) return -1;
+    
+    /* Capabilities are fixed once the first frame is in */
+    if (hdr.type == REMOTEIO_MSG_HELLO && client->hello_done) return -1;
+    client->hello_done = true;
+    
+    if (hdr.type == REMOTEIO_MSG_RDMA_READ || hdr.type == REMOTEIO_MSG_RDMA_WRITE) {
+        /* One-sided frames name memory, not a resource, and travel raw */
+        if (hdr.resource_len != 0 || (hdr.flags & REMOTEIO_MSG_F_COMPRESSED)) return -1;
+        if (hdr.type == REMOTEIO_MSG_RDMA_READ &&
+            (hdr.chunk_len != 0 || hdr.length > REMOTEIO_PROTO_CHUNK)) {
+            return -1;
+        }
+    } else if (hdr.type == REMOTEIO_MSG_LOOKUP) {
+        if (hdr.resource_len == 0 || hdr.chunk_len != 0) return -1;
+    } else if (hdr.type == REMOTEIO_MSG_READ || hdr.type == REMOTEIO_MSG_PING ||
+               hdr.type == REMOTEIO_MSG_HELLO) {
+        if (hdr.chunk_len != 0) return -1;
+        if (hdr.type == REMOTEIO_MSG_PING && hdr.length > REMOTEIO_PROTO_CHUNK) return -1;
+    } else if (hdr.type != REMOTEIO_MSG_WRITE) {
+        return -1;
+    } else if ((hdr.flags & REMOTEIO_MSG_F_COMPRESSED) && hdr.chunk_len <= REMOTEIO_COMPRESS_HDR) {
+        return -1;
+    }
+    
+    /* A client past its credit limits ignores the protocol; drop it */
+    if (hdr.type != REMOTEIO_MSG_HELLO) {
+        remoteio_server_t* server = client->server;
+        pthread_mutex_lock(&client->lock);
+        bool over = client->credits &&
+                    ((int32_t)(client->released_ops + server->credit_ops -
+                               (client->rx_ops + 1)) < 0 ||
+                     (int32_t)(client->released_bytes + server->credit_bytes -
+                               (client->rx_bytes + hdr.chunk_len)) < 0);
+        client->rx_ops++;
+        client->rx_bytes += hdr.chunk_len;
+        pthread_mutex_unlock(&client->lock);
+        if (over) return -1;
+    }
+    
+    remoteio_server_req_t* req = calloc(1, sizeof(remoteio_server_req_t));
+    if (!req) return -1;
+    
+    if (hdr.chunk_len > 0 && !(req->payload = malloc(hdr.chunk_len))) {
+        free(req);
+        return -1;
+    }
+    
+    req->client = client;
+    req->hdr = hdr;
+    client->rx_req = req;
+    return 0;
+}
+
+/* Read whatever the socket has. Returns -1 if the client must be closed. */
+static int server_client_read(remoteio_server_t* server, remoteio_server_client_t* client) {
+    int frames = 0;
+    
+    while (frames < SERVER_FRAMES_PER_EVENT) {
+        pthread_mutex_lock(&client->lock);
+        bool paused = client->paused;
+        pthread_mutex_unlock(&client->lock);
+        if (paused) return 0;
+        
+        void* dst;
+        size_t want;
+        remoteio_server_req_t* req = client->rx_req;
+        
+        if (!req) {
+            dst = client->rx_hdr + client->rx_pos;
+            want = REMOTEIO_MSG_HDR_SIZE - client->rx_pos;
+        } else {
+            size_t pos = client->rx_pos - REMOTEIO_MSG_HDR_SIZE;
+            if (pos < req->hdr.resource_len) {
+                dst = req->resource + pos;
+                want = req->hdr.resource_len - pos;
+            } else {
+                pos -= req->hdr.resource_len;
+                dst = req->payload + pos;
+                want = req->hdr.chunk_len - pos;
+            }
+        }
+        
+        ssize_t n = remoteio_network_recv_some(client->conn, dst, want);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                /* Idle until the client hears it may send more */
+                pthread_mutex_lock(&client->lock);
+                bool idle = client->inflight == 0;
+                pthread_mutex_unlock(&client->lock);
+                if (idle) server_credit_flush(client);
+                return 0;
+            }
+            return -1;
+        }
+        if (n == 0) return -1;
+        client->rx_pos += (size_t)n;
+        
+        if (!req && client->rx_pos == REMOTEIO_MSG_HDR_SIZE) {
+            if (server_begin_frame(client) != 0) return -1;
+            req = client->rx_req;
+        }
+        
+        if (req && client->rx_pos == REMOTEIO_MSG_HDR_SIZE + req->hdr.resource_len +
+                                     req->hdr.chunk_len) {
+            req->resource[req->hdr.resource_len] = '\0';
+            client->rx_req = NULL;
+            client->rx_pos = 0;
+            if (req->hdr.type == REMOTEIO_MSG_RDMA_READ ||
+                req->hdr.type == REMOTEIO_MSG_RDMA_WRITE) {
+                server_one_sided(server, req);
+                free(req->payload);
+                free(req);
+            } else if (req->hdr.type == REMOTEIO_MSG_LOOKUP) {
+                server_region_lookup(server, req);
+                free(req);
+            } else {
+                server_dispatch(server, client, req);
+            }
+            frames++;
+        }
+    }
+    
+    return 0;
+}
+
+static void server_wake(remoteio_server_t* server) {
+    uint64_t count;
+    if (read(server->wake_fd, &count, sizeof(count)) < 0) {
+        /* Nothing pending */
+    }
+    
+    pthread_mutex_lock(&server->lock);
+    remoteio_server_client_t* list = server->new_clients;
+    server->new_clients = NULL;
+    pthread_mutex_unlock(&server->lock);
+    
+    while (list) {
+        remoteio_server_client_t* client = list;
+        list = client->next;
+        
+        pthread_mutex_lock(&server->lock);
+        client->next = server->clients;
+        server->clients = client;
+        pthread_mutex_unlock(&server->lock);
+        if (client->shm_hello) server->shm_hellos++;
+        
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = client };
+        if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, client->fd, &ev) != 0) {
+            server_client_close(server, client, true);
+        }
+    }
+}
+
+static void* server_event_thread(void* arg) {
+    remoteio_server_t* server = (remoteio_server_t*)arg;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    
+    for (;;) {
+        int timeout = server->shm_hellos > 0 ? SERVER_HELLO_POLL_MS : -1;
+        int n = epoll_wait(server->epoll_fd, events, SERVER_MAX_EVENTS, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        
+        pthread_mutex_lock(&server->lock);
+        bool stopping = server->stopping;
+        pthread_mutex_unlock(&server->lock);
+        if (stopping) break;
+        
+        for (int i = 0; i < n; i++) {
+            remoteio_server_client_t* client = events[i].data.ptr;
+            
+            if (!client) {
+                server_wake(server);
+                continue;
+            }
+            
+            if (client->shm_hello) {
+                server_shm_hello(server, client, events[i].events);
+                continue;
+            }
+            
+            if (events[i].events & EPOLLERR) {
+                /* Usually zero-copy completions; a real error closes */
+                int err = 0;
+                socklen_t len = sizeof(err);
+                remoteio_network_zc_drain(client->conn);
+                if (getsockopt(client->conn->socket_fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 ||
+                    err) {
+                    server_client_close(server, client, true);
+                    continue;
+                }
+            }
+            
+            if (events[i].events & EPOLLHUP) {
+                server_client_close(server, client, true);
+            } else if (!(events[i].events & (EPOLLIN | EPOLLRDHUP))) {
+                continue;
+            } else if (server_client_read(server, client) != 0) {
+                server_client_close(server, client, false);
+            }
+        }
+        
+        /* After the events, none of which may name a client closed here */
+        if (server->shm_hellos > 0) server_shm_expire(server);
+    }
+    
+    /* Stopping: drop every client; shutdown unblocks workers mid-send */
+    server_wake(server);
+    for (;;) {
+        pthread_mutex_lock(&server->lock);
+        remoteio_server_client_t* client = server->clients;
+        pthread_mutex_unlock(&server->lock);
+        if (!client) break;
+        server_client_close(server, client, true);
+    }
+    
+    return NULL;
+}
+
+/* ============================================================================
+ * Responses
+ * ============================================================================ */
+
+/* Stamp an outgoing frame with the client's current credit limits */
+static void server_credit_stamp(remoteio_server_client_t* client, remoteio_msg_hdr_t* hdr) {
+    remoteio_server_t* server = client->server;
+    
+    pthread_mutex_lock(&client->lock);
+    if (client->credits) {
+        hdr->credit_ops = client->released_ops + server->credit_ops;
+        hdr->credit_bytes = client->released_bytes + server->credit_bytes;
+        client->announced_ops = client->released_ops;
+        client->announced_bytes = client->released_bytes;
+    }
+    pthread_mutex_unlock(&client->lock);
+}
+
+/*
+ * Write one response frame. The payload comes from memory, or from file at
+ * payload offset when file is given. A large memory payload goes out
+ * zero-copy if zc_seq is given, which then receives the send number to
+ * wait on (see remoteio_network_zc_wait) before the memory may change,
+ * else -1. Compressed payloads sit in worker scratch and are always copied.
+ */
+static int server_send(remoteio_server_client_t* client, const remoteio_msg_hdr_t* hdr,
+                       const void* payload, remoteio_server_file_t* file, uint64_t file_off,
+                       int64_t* zc_seq) {
+    remoteio_connection_t* conn = client->conn;
+    uint8_t raw[REMOTEIO_MSG_HDR_SIZE];
+    struct iovec iov[2];
+    int iovcnt = 1;
+    
+    remoteio_msg_hdr_t out = *hdr;
+    server_credit_stamp(client, &out);
+    
+    pthread_mutex_lock(&conn->lock);
+    bool zerocopy = zc_seq && !file && !(hdr->flags & REMOTEIO_MSG_F_COMPRESSED) &&
+                    conn->zc_enabled && hdr->chunk_len >= REMOTEIO_ZEROCOPY_THRESHOLD;
+    pthread_mutex_unlock(&conn->lock);
+    bool split = file || zerocopy;
+    
+    remoteio_msg_encode(&out, raw);
+    iov[0].iov_base = raw;
+    iov[0].iov_len = sizeof(raw);
+    if (hdr->chunk_len > 0 && !split) {
+        iov[1].iov_base = (void*)payload;
+        iov[1].iov_len = hdr->chunk_len;
+        iovcnt++;
+    }
+    
+    pthread_mutex_lock(&client->send_lock);
+    int ret = remoteio_network_sendv(conn, iov, iovcnt,
+                                     split && hdr->chunk_len > 0 ? MSG_MORE : 0);
+    if (ret == 0 && hdr->chunk_len > 0 && split) {
+        if (file) {
+            ret = remoteio_network_sendfile(conn, file->fd, file_off, hdr->chunk_len);
+        } else {
+            *zc_seq = remoteio_network_send_zerocopy(conn, payload, hdr->chunk_len);
+            if (*zc_seq < 0) ret = -1;
+        }
+    }
+    pthread_mutex_unlock(&client->send_lock);
+    
+    /* A half-written frame desyncs the stream; let the event thread close it */
+    if (ret != 0) remoteio_network_shutdown(conn);
+    return ret;
+}
+
+static int server_send_status(remoteio_server_client_t* client, const remoteio_msg_hdr_t* req,
+                              uint8_t type, gpuio_error_t status) {
+    remoteio_msg_hdr_t resp = {
+        .type = type,
+        .flags = REMOTEIO_MSG_F_LAST,
+        .req_id = req->req_id,
+        .offset = req->offset,
+        .length = req->length,
+        .status = (int16_t)status,
+    };
+    return server_send(client, &resp, NULL, NULL, 0, NULL);
+}
+
+/* Answer a PING with the echo it asked for */
+static void server_pong(remoteio_server_client_t* client, const remoteio_msg_hdr_t* req) {
+    remoteio_msg_hdr_t resp = {
+        .type = REMOTEIO_MSG_PONG,
+        .flags = REMOTEIO_MSG_F_LAST,
+        .req_id = req->req_id,
+        .length = req->length,
+        .chunk_len = (uint32_t)req->length,
+    };
+    server_send(client, &resp, server_zeros, NULL, 0, NULL);
+}
+
+/*
+ * Queue a frame for a worker to send. Called wherever a blocking send must
+ * not happen: on the event thread and under exports_lock. The payload is
+ * copied, and a client's queued frames go out in order.
+ */
+static int server_post(remoteio_server_client_t* client, const remoteio_msg_hdr_t* hdr,
+                       const void* payload) {
+    remoteio_server_t* server = client->server;
+    
+    remoteio_server_out_t* out = malloc(sizeof(remoteio_server_out_t) + hdr->chunk_len);
+    if (!out) {
+        /* A lost response would leave the client waiting; fail it now */
+        remoteio_network_shutdown(client->conn);
+        return -1;
+    }
+    out->hdr = *hdr;
+    out->next = NULL;
+    if (hdr->chunk_len > 0) memcpy(out->payload, payload, hdr->chunk_len);
+    
+    pthread_mutex_lock(&client->lock);
+    if (client->out_tail) {
+        client->out_tail->next = out;
+    } else {
+        client->out_head = out;
+    }
+    client->out_tail = out;
+    bool schedule = !client->flush_queued;
+    if (schedule) {
+        client->flush_queued = true;
+        client->refs++;
+    }
+    pthread_mutex_unlock(&client->lock);
+    
+    if (schedule) {
+        pthread_mutex_lock(&server->lock);
+        client->flush_next = NULL;
+        if (server->flush_tail) {
+            server->flush_tail->flush_next = client;
+        } else {
+            server->flush_head = client;
+        }
+        server->flush_tail = client;
+        pthread_cond_signal(&server->queue_cond);
+        pthread_mutex_unlock(&server->lock);
+    }
+    return 0;
+}
+
+/* Worker: send a client's queued frames. Payloads are private copies, so
+ * they are copied into the socket rather than sent zero-copy. */
+static void server_flush(remoteio_server_client_t* client) {
+    for (;;) {
+        pthread_mutex_lock(&client->lock);
+        remoteio_server_out_t* out = client->out_head;
+        if (out) {
+            client->out_head = out->next;
+            if (!client->out_head) client->out_tail = NULL;
+        } else {
+            client->flush_queued = false;
+        }
+        pthread_mutex_unlock(&client->lock);
+        if (!out) break;
+        
+        uint8_t raw[REMOTEIO_MSG_HDR_SIZE];
+        server_credit_stamp(client, &out->hdr);
+        remoteio_msg_encode(&out->hdr, raw);
+        struct iovec iov[2] = {
+            { .iov_base = raw, .iov_len = sizeof(raw) },
+            { .iov_base = out->payload, .iov_len = out->hdr.chunk_len },
+        };
+        
+        pthread_mutex_lock(&client->send_lock);
+        int ret = remoteio_network_sendv(client->conn, iov, out->hdr.chunk_len > 0 ? 2 : 1, 0);
+        pthread_mutex_unlock(&client->send_lock);
+        if (ret != 0) remoteio_network_shutdown(client->conn);
+        free(out);
+    }
+    
+    server_client_put(client);
+}
+
+/* Announce returned credits in a frame of their own, if any are pending */
+static void server_credit_flush(remoteio_server_client_t* client) {
+    pthread_mutex_lock(&client->lock);
+    bool pending = client->credits && !client->closed &&
+                   (client->released_ops != client->announced_ops ||
+                    client->released_bytes != client->announced_bytes);
+    pthread_mutex_unlock(&client->lock);
+    if (!pending) return;
+    
+    remoteio_msg_hdr_t msg = {
+        .type = REMOTEIO_MSG_CREDIT,
+        .flags = REMOTEIO_MSG_F_LAST,
+    };
+    if (server_post(client, &msg, NULL) == 0) {
+        pthread_mutex_lock(&client->server->lock);
+        client->server->stats.credit_frames++;
+        pthread_mutex_unlock(&client->server->lock);
+    }
+}
+
+/*
+ * Return a request frame's credits once its payload is consumed. The next
+ * response carries them; a quarter of a window is not left waiting for one.
+ */
+static void server_credit_release(remoteio_server_client_t* client, uint32_t bytes) {
+    remoteio_server_t* server = client->server;
+    
+    pthread_mutex_lock(&client->lock);
+    bool flush = false;
+    if (client->credits) {
+        client->released_ops++;
+        client->released_bytes += bytes;
+        flush = client->released_ops - client->announced_ops >= (server->credit_ops + 3) / 4 ||
+                client->released_bytes - client->announced_bytes >= server->credit_bytes / 4;
+    }
+    pthread_mutex_unlock(&client->lock);
+    
+    if (flush) server_credit_flush(client);
+}
+
+/* ============================================================================
+ * One-Sided Requests and Lookups (event thread)
+ * ============================================================================ */
+
+/*
+ * Execute a one-sided frame in place, as a NIC would: no worker hop and no
+ * export lookup. Region memory is only touched under the shared
+ * exports_lock so deregistration can fence it; for the same reason read
+ * data is copied into the queued response before the lock is dropped.
+ * Writes are acknowledged once, on their last chunk, unless a chunk is
+ * refused; unsignalled ones only if refused.
+ */
+static void server_one_sided(remoteio_server_t* server, remoteio_server_req_t* req) {
+    const remoteio_msg_hdr_t* hdr = &req->hdr;
+    remoteio_server_client_t* client = req->client;
+    bool is_read = hdr->type == REMOTEIO_MSG_RDMA_READ;
+    uint64_t len = is_read ? hdr->length : hdr->chunk_len;
+    char* mem = (char*)(uintptr_t)hdr->offset;
+    
+    pthread_rwlock_rdlock(&server->exports_lock);
+    bool ok = server_region_check(server, hdr->rkey, hdr->offset, len,
+                                  is_read ? REMOTEIO_ACCESS_REMOTE_READ :
+                                            REMOTEIO_ACCESS_REMOTE_WRITE);
+    
+    remoteio_msg_hdr_t resp = {
+        .type = is_read ? REMOTEIO_MSG_READ_RESP : REMOTEIO_MSG_WRITE_RESP,
+        .flags = hdr->flags & REMOTEIO_MSG_F_LAST,
+        .req_id = hdr->req_id,
+        .offset = hdr->offset,
+        .length = hdr->length,
+        .status = (int16_t)(ok ? GPUIO_SUCCESS : GPUIO_ERROR_PERMISSION),
+    };
+    
+    /* Counted before the response so a completed op is always reflected */
+    pthread_mutex_lock(&server->lock);
+    if (!ok) {
+        server->stats.access_violations++;
+    } else if (is_read) {
+        server->stats.bytes_read += len;
+        if (hdr->flags & REMOTEIO_MSG_F_LAST) server->stats.one_sided_reads++;
+    } else {
+        server->stats.bytes_written += len;
+        if (hdr->flags & REMOTEIO_MSG_F_LAST) server->stats.one_sided_writes++;
+    }
+    pthread_mutex_unlock(&server->lock);
+    
+    if (is_read) {
+        resp.chunk_len = ok ? (uint32_t)len : 0;
+        server_credit_release(client, 0);
+        server_post(client, &resp, mem);
+    } else {
+        if (ok && len > 0) memcpy(mem, req->payload, len);
+        server_credit_release(client, hdr->chunk_len);
+        if (!ok || ((hdr->flags & REMOTEIO_MSG_F_LAST) &&
+                    !(hdr->flags & REMOTEIO_MSG_F_UNSIGNALED))) {
+            server_post(client, &resp, NULL);
+        }
+    }
+    pthread_rwlock_unlock(&server->exports_lock);
+}
+
+/* Answer a LOOKUP with the named region's descriptor. It is queued under
+ * the lock, so an INVALIDATE for the region can only follow it. */
+static void server_region_lookup(remoteio_server_t* server, remoteio_server_req_t* req) {
+    remoteio_msg_hdr_t resp = {
+        .type = REMOTEIO_MSG_LOOKUP_RESP,
+        .flags = REMOTEIO_MSG_F_LAST,
+        .req_id = req->hdr.req_id,
+        .status = (int16_t)GPUIO_ERROR_NOT_FOUND,
+    };
+    
+    pthread_rwlock_rdlock(&server->exports_lock);
+    remoteio_server_region_t* region = server_region_named(server, req->resource);
+    if (region) {
+        resp.offset = region->addr;
+        resp.length = region->length;
+        resp.rkey = region->rkey;
+        resp.status = GPUIO_SUCCESS;
+    }
+    server_credit_release(req->client, 0);
+    server_post(req->client, &resp, NULL);
+    pthread_rwlock_unlock(&server->exports_lock);
+    
+    pthread_mutex_lock(&server->lock);
+    server->stats.lookups++;
+    pthread_mutex_unlock(&server->lock);
+}
+
+/* Push INVALIDATE for a revoked rkey to every client. Clients that miss it
+ * (out of memory here) still drop the descriptor on their first refusal. */
+static void server_invalidate(remoteio_server_t* server, uint32_t rkey) {
+    remoteio_msg_hdr_t msg = {
+        .type = REMOTEIO_MSG_INVALIDATE,
+        .flags = REMOTEIO_MSG_F_LAST,
+        .rkey = rkey,
+    };
+    
+    /* Pin the clients so the sends can happen without the server lock */
+    pthread_mutex_lock(&server->lock);
+    int n = 0;
+    for (remoteio_server_client_t* c = server->clients; c; c = c->next) n++;
+    remoteio_server_client_t** clients = n > 0 ? malloc((size_t)n * sizeof(*clients)) : NULL;
+    n = 0;
+    for (remoteio_server_client_t* c = clients ? server->clients : NULL; c; c = c->next) {
+        pthread_mutex_lock(&c->lock);
+        if (!c->closed) {
+            c->refs++;
+            clients[n++] = c;
+        }
+        pthread_mutex_unlock(&c->lock);
+    }
+    pthread_mutex_unlock(&server->lock);
+    
+    /* Queued behind any LOOKUP_RESP already posted for the region */
+    int sent = 0;
+    for (int i = 0; i < n; i++) {
+        if (server_post(clients[i], &msg, NULL) == 0) sent++;
+        server_client_put(clients[i]);
+    }
+    free(clients);
+    
+    pthread_mutex_lock(&server->lock);
+    server->stats.invalidations_sent += (uint64_t)sent;
+    pthread_mutex_unlock(&server->lock);
+}
+
+/* ============================================================================
+ * Request Execution (workers)
+ * ============================================================================ */
+
+static ssize_t server_pread(int fd, void* buf, size_t count, uint64_t offset) {
+    size_t done = 0;
+    while (done < count) {
+        ssize_t n = pread(fd, (char*)buf + done, count - done, (off_t)(offset + done));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        done += (size_t)n;
+    }
+    return (ssize_t)done;
+}
+
+static ssize_t server_pwrite(int fd, const void* buf, size_t count, uint64_t offset) {
+    size_t done = 0;
+    while (done < count) {
+        ssize_t n = pwrite(fd, (const char*)buf + done, count - done, (off_t)(offset + done));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    return (ssize_t)done;
+}
+
+/*
+ * Stream [offset, offset + length) of memory or a file as READ_RESP chunks.
+ * With compression negotiated, scratch (two chunks) holds the compressed
+ * chunk and, for files, the raw one read to compress; chunks that don't
+ * compress take the copy-free path. Memory sent zero-copy is still the
+ * kernel's until it is released, and a later WRITE to the export must not
+ * show through, so the read is only done once the kernel let go of it.
+ */
+static gpuio_error_t server_read(remoteio_server_t* server, remoteio_server_client_t* client,
+                                 const remoteio_msg_hdr_t* hdr, const char* base,
+                                 remoteio_server_file_t* file, char* scratch) {
+    remoteio_msg_hdr_t resp = {
+        .type = REMOTEIO_MSG_READ_RESP,
+        .req_id = hdr->req_id,
+        .length = hdr->length,
+    };
+    uint64_t sendfile_bytes = 0;
+    uint64_t zerocopy_bytes = 0;
+    int64_t zc_last = -1;
+    uint64_t done = 0;
+    
+    pthread_mutex_lock(&client->conn->lock);
+    bool compress = scratch && (client->conn->caps & REMOTEIO_CAP_LZ4);
+    pthread_mutex_unlock(&client->conn->lock);
+    
+    do {
+        uint64_t n = hdr->length - done;
+        if (n > REMOTEIO_PROTO_CHUNK) n = REMOTEIO_PROTO_CHUNK;
+        uint64_t off = hdr->offset + done;
+        
+        resp.offset = off;
+        resp.flags = (done + n == hdr->length) ? REMOTEIO_MSG_F_LAST : 0;
+        
+        size_t packed = 0;
+        if (compress) {
+            const char* src = base ? base + off : scratch + REMOTEIO_PROTO_CHUNK;
+            if (base || server_pread(file->fd, scratch + REMOTEIO_PROTO_CHUNK, n, off) == (ssize_t)n) {
+                packed = remoteio_proto_compress(client->conn, src, n, (uint8_t*)scratch);
+            }
+        }
+        
+        int ret;
+        if (packed > 0) {
+            resp.chunk_len = (uint32_t)packed;
+            resp.flags |= REMOTEIO_MSG_F_COMPRESSED;
+            ret = server_send(client, &resp, scratch, NULL, 0, NULL);
+        } else {
+            int64_t zc_seq = -1;
+            resp.chunk_len = (uint32_t)n;
+            ret = server_send(client, &resp, base ? base + off : NULL, file, off, &zc_seq);
+            if (file) {
+                sendfile_bytes += n;
+            } else if (zc_seq >= 0) {
+                zerocopy_bytes += n;
+                zc_last = zc_seq;
+            }
+        }
+        if (ret != 0) return GPUIO_ERROR_NETWORK;
+        done += n;
+    } while (done < hdr->length);
+    
+    /* Releases are acknowledged in order, so the last send covers the rest */
+    if (zc_last >= 0 && remoteio_network_zc_wait(client->conn, (uint32_t)zc_last) != 0) {
+        remoteio_network_shutdown(client->conn);
+        return GPUIO_ERROR_NETWORK;
+    }
+    
+    pthread_mutex_lock(&server->lock);
+    server->stats.sendfile_bytes += sendfile_bytes;
+    server->stats.zerocopy_bytes += zerocopy_bytes;
+    pthread_mutex_unlock(&server->lock);
+    
+    return GPUIO_SUCCESS;
+}
+
+static gpuio_error_t server_exec_read(remoteio_server_t* server, remoteio_server_req_t* req,
+                                      char* scratch) {
+    const remoteio_msg_hdr_t* hdr = &req->hdr;
+    const char* rel;
+    remoteio_export_t* exp = server_lookup(server, req->resource, &rel);
+    gpuio_error_t status = GPUIO_SUCCESS;
+    
+    if (!exp || (exp->type == REMOTEIO_EXPORT_MEMORY && rel)) {
+        status = GPUIO_ERROR_NOT_FOUND;
+    } else if (exp->type == REMOTEIO_EXPORT_MEMORY) {
+        if (hdr->length == 0 || hdr->offset > exp->size ||
+            hdr->length > exp->size - hdr->offset) {
+            status = GPUIO_ERROR_INVALID_ARG;
+        } else {
+            return server_read(server, req->client, hdr, exp->base, NULL, scratch);
+        }
+    } else {
+        remoteio_server_file_t* file = server_file_get(server, exp, rel, false, &status);
+        if (file) {
+            uint64_t size = __atomic_load_n(&file->size, __ATOMIC_ACQUIRE);
+            if (hdr->length == 0 || hdr->offset > size || hdr->length > size - hdr->offset) {
+                /* Answer now; the client would otherwise wait out its timeout */
+                status = GPUIO_ERROR_INVALID_ARG;
+                server_send_status(req->client, hdr, REMOTEIO_MSG_READ_RESP, status);
+            } else {
+                status = server_read(server, req->client, hdr, NULL, file, scratch);
+            }
+            server_file_put(server, file);
+            return status;
+        }
+    }
+    
+    server_send_status(req->client, hdr, REMOTEIO_MSG_READ_RESP, status);
+    return status;
+}
+
+/* Account one WRITE chunk; answer and count the op once all of it has landed */
+static void server_write_progress(remoteio_server_t* server, remoteio_server_client_t* client,
+                                  const remoteio_msg_hdr_t* hdr, gpuio_error_t status) {
+    bool finished = false;
+    gpuio_error_t final = status;
+    
+    pthread_mutex_lock(&client->lock);
+    
+    remoteio_server_write_t** cur = &client->writes;
+    while (*cur && (*cur)->req_id != hdr->req_id) cur = &(*cur)->next;
+    remoteio_server_write_t* w = *cur;
+    
+    if (!w && (hdr->flags & REMOTEIO_MSG_F_LAST) && hdr->chunk_len == hdr->length) {
+        /* Single-frame write: nothing to track */
+        finished = true;
+    } else {
+        if (!w && (w = calloc(1, sizeof(remoteio_server_write_t)))) {
+            w->req_id = hdr->req_id;
+            w->next = client->writes;
+            client->writes = w;
+            cur = &client->writes;
+        }
+        if (!w) {
+            finished = true;
+            final = GPUIO_ERROR_NOMEM;
+        } else {
+            w->done += hdr->chunk_len;
+            if (status != GPUIO_SUCCESS && w->status == GPUIO_SUCCESS) w->status = status;
+            if (hdr->flags & REMOTEIO_MSG_F_LAST) w->last_seen = true;
+            
+            if (w->last_seen && w->done >= hdr->length) {
+                finished = true;
+                final = w->status;
+                *cur = w->next;
+                free(w);
+            }
+        }
+    }
+    
+    pthread_mutex_unlock(&client->lock);
+    
+    if (finished) {
+        pthread_mutex_lock(&server->lock);
+        if (final == GPUIO_SUCCESS) {
+            server->stats.writes++;
+        } else {
+            server->stats.errors++;
+        }
+        pthread_mutex_unlock(&server->lock);
+        
+        server_send_status(client, hdr, REMOTEIO_MSG_WRITE_RESP, final);
+    }
+}
+
+static gpuio_error_t server_exec_write(remoteio_server_t* server, remoteio_server_req_t* req,
+                                       char* scratch) {
+    const remoteio_msg_hdr_t* hdr = &req->hdr;
+    const char* data = req->payload;
+    uint32_t wire_len = req->hdr.chunk_len;
+    
+    if (req->hdr.flags & REMOTEIO_MSG_F_COMPRESSED) {
+        /* From here on the chunk is its raw self */
+        size_t n = 0;
+        if (!scratch ||
+            remoteio_proto_decompress(req->client->conn, (const uint8_t*)req->payload,
+                                      req->hdr.chunk_len, scratch, REMOTEIO_PROTO_CHUNK, &n) != 0) {
+            /* The chunk's length is unknown, so the op can't be answered */
+            remoteio_network_shutdown(req->client->conn);
+            pthread_mutex_lock(&server->lock);
+            server->stats.errors++;
+            pthread_mutex_unlock(&server->lock);
+            return GPUIO_ERROR_IO;
+        }
+        data = scratch;
+        req->hdr.chunk_len = (uint32_t)n;
+        req->hdr.flags &= (uint16_t)~REMOTEIO_MSG_F_COMPRESSED;
+    }
+    
+    const char* rel;
+    remoteio_export_t* exp = server_lookup(server, req->resource, &rel);
+    gpuio_error_t status = GPUIO_SUCCESS;
+    uint64_t end = hdr->offset + hdr->chunk_len;
+    
+    if (!exp || (exp->type == REMOTEIO_EXPORT_MEMORY && rel)) {
+        status = GPUIO_ERROR_NOT_FOUND;
+    } else if (!exp->writable) {
+        status = GPUIO_ERROR_PERMISSION;
+    } else if (end < hdr->offset) {
+        status = GPUIO_ERROR_INVALID_ARG;
+    } else if (exp->type == REMOTEIO_EXPORT_MEMORY) {
+        if (end > exp->size) {
+            status = GPUIO_ERROR_INVALID_ARG;
+        } else {
+            memcpy((char*)exp->base + hdr->offset, data, hdr->chunk_len);
+        }
+    } else {
+        remoteio_server_file_t* file = server_file_get(server, exp, rel, true, &status);
+        if (file) {
+            if (server_pwrite(file->fd, data, hdr->chunk_len, hdr->offset) < 0) {
+                status = errno_status(errno);
+            } else {
+                uint64_t size = __atomic_load_n(&file->size, __ATOMIC_RELAXED);
+                while (end > size &&
+                       !__atomic_compare_exchange_n(&file->size, &size, end, false,
+                                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+                }
+            }
+            server_file_put(server, file);
+        }
+    }
+    
+    if (status == GPUIO_SUCCESS) {
+        pthread_mutex_lock(&server->lock);
+        server->stats.bytes_written += hdr->chunk_len;
+        pthread_mutex_unlock(&server->lock);
+    }
+    
+    server_credit_release(req->client, wire_len);
+    server_write_progress(server, req->client, hdr, status);
+    return status;
+}
+
+/* Grant the capabilities this server supports out of the client's offer */
+static void server_hello(remoteio_server_t* server, remoteio_server_req_t* req,
+                         bool can_compress) {
+    remoteio_connection_t* conn = req->client->conn;
+    uint32_t grant = (uint32_t)req->hdr.offset &
+                     ((can_compress ? REMOTEIO_CAP_LZ4 : 0) | REMOTEIO_CAP_CREDITS);
+    
+    pthread_mutex_lock(&conn->lock);
+    conn->caps = grant;
+    conn->codec = server->ctx->codec;
+    pthread_mutex_unlock(&conn->lock);
+    
+    /* The ACK below opens the first window */
+    pthread_mutex_lock(&req->client->lock);
+    req->client->credits = (grant & REMOTEIO_CAP_CREDITS) != 0;
+    pthread_mutex_unlock(&req->client->lock);
+    
+    if (grant & REMOTEIO_CAP_LZ4) {
+        pthread_mutex_lock(&server->lock);
+        server->stats.compressed_clients++;
+        pthread_mutex_unlock(&server->lock);
+    }
+    
+    remoteio_msg_hdr_t resp = {
+        .type = REMOTEIO_MSG_HELLO_ACK,
+        .flags = REMOTEIO_MSG_F_LAST,
+        .req_id = req->hdr.req_id,
+        .offset = grant,
+    };
+    server_send(req->client, &resp, NULL, NULL, 0, NULL);
+}
+
+/* Release a finished request's queue slot, resuming a throttled client */
+static void server_req_done(remoteio_server_t* server, remoteio_server_req_t* req) {
+    remoteio_server_client_t* client = req->client;
+    
+    pthread_mutex_lock(&client->lock);
+    if (--client->inflight < server->queue_depth && client->paused && !client->closed) {
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = client };
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, client->fd, &ev);
+        client->paused = false;
+    }
+    bool idle = client->inflight == 0;
+    pthread_mutex_unlock(&client->lock);
+    
+    if (idle) server_credit_flush(client);
+    server_client_put(client);
+    free(req->payload);
+    free(req);
+}
+
+static void* server_worker_thread(void* arg) {
+    remoteio_server_t* server = (remoteio_server_t*)arg;
+    
+    /* Compressed chunks and the raw file data they're made from */
+    char* scratch = server->ctx->codec ? malloc(2 * REMOTEIO_PROTO_CHUNK) : NULL;
+    
+    for (;;) {
+        pthread_mutex_lock(&server->lock);
+        while (!server->queue_head && !server->flush_head && !server->stopping) {
+            pthread_cond_wait(&server->queue_cond, &server->lock);
+        }
+        
+        /* Queued responses first: they are already late */
+        remoteio_server_client_t* flush = server->flush_head;
+        if (flush) {
+            server->flush_head = flush->flush_next;
+            if (!server->flush_head) server->flush_tail = NULL;
+            pthread_mutex_unlock(&server->lock);
+            server_flush(flush);
+            continue;
+        }
+        
+        remoteio_server_req_t* req = server->queue_head;
+        if (!req) {
+            pthread_mutex_unlock(&server->lock);
+            break;
+        }
+        server->queue_head = req->next;
+        if (!server->queue_head) server->queue_tail = NULL;
+        pthread_mutex_unlock(&server->lock);
+        
+        if (req->hdr.type == REMOTEIO_MSG_PING) {
+            server_credit_release(req->client, 0);
+            server_pong(req->client, &req->hdr);
+            server_req_done(server, req);
+            continue;
+        }
+        if (req->hdr.type == REMOTEIO_MSG_HELLO) {
+            server_hello(server, req, scratch != NULL);
+            server_req_done(server, req);
+            continue;
+        }
+        
+        /* A READ is one request; a WRITE counts when its last chunk lands */
+        if (req->hdr.type == REMOTEIO_MSG_READ) {
+            server_credit_release(req->client, 0);
+            gpuio_error_t status = server_exec_read(server, req, scratch);
+            
+            pthread_mutex_lock(&server->lock);
+            if (status != GPUIO_SUCCESS) {
+                server->stats.errors++;
+            } else {
+                server->stats.reads++;
+                server->stats.bytes_read += req->hdr.length;
+            }
+            pthread_mutex_unlock(&server->lock);
+        } else {
+            server_exec_write(server, req, scratch);
+        }
+        
+        server_req_done(server, req);
+    }
+    
+    free(scratch);
+    return NULL;
+}
+
+/* ============================================================================
+ * Lifecycle
+ * ============================================================================ */
+
+int remoteio_server_create(remoteio_context_t* ctx, int num_workers, int queue_depth,
+                           remoteio_server_t** server_out) {
+    if (!ctx || !server_out) return -1;
+    
+    remoteio_server_t* server = calloc(1, sizeof(remoteio_server_t));
+    if (!server) return -1;
+    
+    server->ctx = ctx;
+    server->num_workers = num_workers > 0 ? num_workers : REMOTEIO_SERVER_WORKERS;
+    if (server->num_workers > SERVER_MAX_WORKERS) server->num_workers = SERVER_MAX_WORKERS;
+    server->queue_depth = queue_depth > 0 ? queue_depth : REMOTEIO_SERVER_QUEUE_DEPTH;
+    server->credit_ops = (uint32_t)server->queue_depth;
+    server->credit_bytes = REMOTEIO_SERVER_CREDIT_BYTES;
+    
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    server->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    server->workers = calloc(server->num_workers, sizeof(pthread_t));
+    
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+    if (server->epoll_fd < 0 || server->wake_fd < 0 || !server->workers ||
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->wake_fd, &ev) != 0) {
+        if (server->epoll_fd >= 0) close(server->epoll_fd);
+        if (server->wake_fd >= 0) close(server->wake_fd);
+        free(server->workers);
+        free(server);
+        return -1;
+    }
+    
+    pthread_rwlock_init(&server->exports_lock, NULL);
+    pthread_mutex_init(&server->files_lock, NULL);
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_cond_init(&server->queue_cond, NULL);
+    
+    /* Clients choosing a transport time one-sided reads of it */
+    remoteio_remote_mem_t probe;
+    if (remoteio_server_register_region(server, REMOTEIO_ROUTE_PROBE_REGION,
+                                        (void*)server_zeros, sizeof(server_zeros),
+                                        REMOTEIO_ACCESS_REMOTE_READ, &probe) != 0) {
+        remoteio_server_destroy(server);
+        return -1;
+    }
+    
+    *server_out = server;
+    return 0;
+}
+
+/* Stop threads started so far; clients are dropped */
+static void server_shutdown(remoteio_server_t* server) {
+    pthread_mutex_lock(&server->lock);
+    server->stopping = true;
+    pthread_cond_broadcast(&server->queue_cond);
+    pthread_mutex_unlock(&server->lock);
+    
+    if (server->event_started) {
+        uint64_t one = 1;
+        if (write(server->wake_fd, &one, sizeof(one)) < 0) {
+            /* Counter saturated; the event thread is awake anyway */
+        }
+        pthread_join(server->event_thread, NULL);
+        server->event_started = false;
+    }
+    
+    for (int i = 0; i < server->workers_started; i++) {
+        pthread_join(server->workers[i], NULL);
+    }
+    server->workers_started = 0;
+}
+
+/* Listen on a TCP port, or on a Unix socket when path is given */
+static int server_start(remoteio_server_t* server, int port, const char* path) {
+    if (!server || server->listener || server->stopping) return -1;
+    
+    if (pthread_create(&server->event_thread, NULL, server_event_thread, server) != 0) {
+        return -1;
+    }
+    server->event_started = true;
+    
+    for (int i = 0; i < server->num_workers; i++) {
+        if (pthread_create(&server->workers[i], NULL, server_worker_thread, server) != 0) {
+            server_shutdown(server);
+            return -1;
+        }
+        server->workers_started++;
+    }
+    
+    remoteio_listener_t* listener;
+    if ((path ? remoteio_network_listen_unix(server->ctx, path, &listener)
+              : remoteio_network_listen(server->ctx, port, &listener)) != 0) {
+        server_shutdown(server);
+        return -1;
+    }
+    
+    pthread_mutex_lock(&listener->lock);
+    listener->accept_cb = server_accept;
+    listener->accept_user_data = server;
+    pthread_mutex_unlock(&listener->lock);
+    
+    server->listener = listener;
+    server->port = listener->port;
+    
+    /* Clients on this host may come through shared memory too. Without the
+     * control socket (the name is taken) they simply use the stream. */
+    char name[INET6_ADDRSTRLEN];
+    if (remoteio_shm_name(path, (uint16_t)server->port, name, sizeof(name)) == 0 &&
+        remoteio_network_listen_unix(server->ctx, name, &listener) == 0) {
+        pthread_mutex_lock(&listener->lock);
+        listener->accept_cb = server_shm_accept;
+        listener->accept_user_data = server;
+        pthread_mutex_unlock(&listener->lock);
+        server->shm_listener = listener;
+    }
+    
+    return 0;
+}
+
+/**
+ * Start serving on a TCP port (0 picks a free one, see server->port).
+ * Exports may be added before or after starting.
+ */
+int remoteio_server_start(remoteio_server_t* server, int port) {
+    return server_start(server, port, NULL);
+}
+
+/* Start serving on a Unix socket at path, for clients on this host */
+int remoteio_server_start_unix(remoteio_server_t* server, const char* path) {
+    if (!path) return -1;
+    return server_start(server, 0, path);
+}
+
+int remoteio_server_stop(remoteio_server_t* server) {
+    if (!server) return -1;
+    
+    /* No new clients once the listeners are gone */
+    if (server->listener) {
+        remoteio_network_stop_listen(server->listener);
+        server->listener = NULL;
+    }
+    if (server->shm_listener) {
+        remoteio_network_stop_listen(server->shm_listener);
+        server->shm_listener = NULL;
+    }
+    
+    server_shutdown(server);
+    return 0;
+}
+
+void remoteio_server_destroy(remoteio_server_t* server) {
+    if (!server) return;
+    
+    remoteio_server_stop(server);
+    
+    while (server->files) {
+        remoteio_server_file_t* next = server->files->next;
+        server_file_close(server->files);
+        server->files = next;
+    }
+    
+    while (server->exports) {
+        remoteio_export_t* next = server->exports->next;
+        free(server->exports->path);
+        free(server->exports);
+        server->exports = next;
+    }
+    
+    while (server->regions) {
+        remoteio_server_region_t* next = server->regions->next;
+        free(server->regions);
+        server->regions = next;
+    }
+    
+    close(server->epoll_fd);
+    close(server->wake_fd);
+    free(server->workers);
+    
+    pthread_rwlock_destroy(&server->exports_lock);
+    pthread_mutex_destroy(&server->files_lock);
+    pthread_mutex_destroy(&server->lock);
+    pthread_cond_destroy(&server->queue_cond);
+    free(server);
+}
+
+int remoteio_server_get_stats(remoteio_server_t* server, remoteio_server_stats_t* stats) {
+    if (!server || !stats) return -1;
+    
+    pthread_mutex_lock(&server->lock);
+    *stats = server->stats;
+    pthread_mutex_unlock(&server->lock);
+    
+    return 0;
+}
@@ -0,0 +1,621 @@
+/**
+ * @file shm.c
+ * @brief RemoteIO module - Same-host shared memory transport
+ * @version 1.0.0
+ *
+ * Carries the framed protocol between processes on one host through two
+ * byte rings in a memfd instead of through the TCP stack. Frames are
+ * copied into the ring once by the sender and out once by the receiver,
+ * with no system call unless the receiver has gone to sleep or the ring is
+ * full. Everything above the byte stream, from the HELLO exchange to
+ * one-sided frames, is the same as on a socket: network.c routes sends and
+ * receives of a connection with conn->shm here, and the reactor and the
+ * server's event thread wait on remoteio_network_poll_fd().
+ *
+ * The control channel is a Unix socket in the abstract namespace, named
+ * after the server's port or path. After the handshake nothing crosses it;
+ * it only lets each side see the other exit, which a ring cannot show.
+ */
+
+#include "remoteio_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <ifaddrs.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define SHM_MAGIC          0x4d485352u  /* "RSHM" */
+#define SHM_VERSION        1
+#define SHM_DATA_OFFSET    4096         /* Ring data starts a page in */
+#define SHM_SEALS          (F_SEAL_SHRINK | F_SEAL_SEAL)
+#define SHM_TIMEOUT_MS     30000        /* Longest wait for room in a full ring */
+
+/* Start of the memfd */
+typedef struct shm_layout {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t ring_bytes;
+    uint32_t closed;
+    uint8_t pad[44];
+    remoteio_shm_ring_t rings[2];    /* Client to server, server to client */
+} shm_layout_t;
+
+/* Handshake: the client sends it with the memfd and both eventfds, the
+ * server echoes it once the rings are mapped */
+typedef struct shm_hello {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t ring_bytes;
+} shm_hello_t;
+
+#define SHM_HELLO_FDS      3            /* memfd, client eventfd, server eventfd */
+
+static size_t shm_map_len(void) {
+    return SHM_DATA_OFFSET + 2 * (size_t)REMOTEIO_SHM_RING_BYTES;
+}
+
+static int shm_futex(uint32_t* word, int op, uint32_t val, const struct timespec* timeout) {
+    /* Not FUTEX_PRIVATE_FLAG: the word is shared with another process */
+    return (int)syscall(SYS_futex, word, op, val, timeout, NULL, 0);
+}
+
+/* ============================================================================
+ * Peers and Names
+ * ============================================================================ */
+
+/* Is addr this host: a Unix socket path, loopback, or one of our addresses? */
+bool remoteio_shm_local(const char* addr) {
+    if (!addr) return false;
+    if (addr[0] == '/' || strcmp(addr, "localhost") == 0) return true;
+    
+    struct in_addr in;
+    if (inet_pton(AF_INET, addr, &in) != 1) return false;
+    if ((ntohl(in.s_addr) >> 24) == 127) return true;
+    
+    struct ifaddrs* ifs;
+    if (getifaddrs(&ifs) != 0) return false;
+    
+    bool local = false;
+    for (struct ifaddrs* ifa = ifs; ifa && !local; ifa = ifa->ifa_next) {
+        if (ifa->ifa_addr && ifa->ifa_addr->sa_family == AF_INET) {
+            local = ((struct sockaddr_in*)ifa->ifa_addr)->sin_addr.s_addr == in.s_addr;
+        }
+    }
+    freeifaddrs(ifs);
+    return local;
+}
+
+/**
+ * Name of the control socket of a server listening on a Unix socket at
+ * path, or else on port. It is abstract ('@'), so nothing is left behind;
+ * paths are hashed to keep it short.
+ */
+int remoteio_shm_name(const char* path, uint16_t port, char* name, size_t len) {
+    int n;
+    
+    if (path) {
+        /* FNV-1a */
+        uint32_t h = 2166136261u;
+        for (const char* p = path; *p; p++) {
+            h ^= (uint8_t)*p;
+            h *= 16777619u;
+        }
+        n = snprintf(name, len, "@remoteio-shm.p%08x", h);
+    } else {
+        n = snprintf(name, len, "@remoteio-shm.%u", port);
+    }
+    return n > 0 && (size_t)n < len ? 0 : -1;
+}
+
+/* ============================================================================
+ * Setup
+ * ============================================================================ */
+
+static void shm_free(remoteio_shm_conn_t* shm) {
+    if (shm->base) munmap(shm->base, shm->map_len);
+    if (shm->wake_fd >= 0) close(shm->wake_fd);
+    if (shm->peer_wake_fd >= 0) close(shm->peer_wake_fd);
+    if (shm->poll_fd >= 0) close(shm->poll_fd);
+    free(shm);
+}
+
+/* Take over a mapping and the eventfds; client picks which ring is ours */
+static remoteio_shm_conn_t* shm_wrap(void* base, int wake_fd, int peer_wake_fd,
+                                     int socket_fd, bool client) {
+    remoteio_shm_conn_t* shm = calloc(1, sizeof(remoteio_shm_conn_t));
+    if (!shm) return NULL;
+    
+    shm_layout_t* layout = (shm_layout_t*)base;
+    char* data = (char*)base + SHM_DATA_OFFSET;
+    
+    shm->base = base;
+    shm->map_len = shm_map_len();
+    shm->closed = &layout->closed;
+    shm->tx = &layout->rings[client ? 0 : 1];
+    shm->rx = &layout->rings[client ? 1 : 0];
+    shm->tx_data = data + (client ? 0 : REMOTEIO_SHM_RING_BYTES);
+    shm->rx_data = data + (client ? REMOTEIO_SHM_RING_BYTES : 0);
+    shm->wake_fd = wake_fd;
+    shm->peer_wake_fd = peer_wake_fd;
+    
+    /* Readable when the peer wrote, or when its socket closed */
+    struct epoll_event ev = { .events = EPOLLIN };
+    shm->poll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (shm->poll_fd < 0 ||
+        epoll_ctl(shm->poll_fd, EPOLL_CTL_ADD, wake_fd, &ev) != 0) {
+        goto fail;
+    }
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    if (epoll_ctl(shm->poll_fd, EPOLL_CTL_ADD, socket_fd, &ev) != 0) goto fail;
+    
+    return shm;
+
+fail:
+    shm->base = NULL;
+    shm->wake_fd = -1;
+    shm->peer_wake_fd = -1;
+    shm_free(shm);
+    return NULL;
+}
+
+static void shm_attach(remoteio_connection_t* conn, remoteio_shm_conn_t* shm) {
+    pthread_mutex_lock(&conn->lock);
+    conn->shm = shm;
+    conn->transport = REMOTEIO_TRANSPORT_SHM;
+    conn->zc_enabled = false;
+    pthread_mutex_unlock(&conn->lock);
+}
+
+/* Wait up to timeout_ms for the control socket to be readable */
+static int shm_wait_socket(int fd, int timeout_ms) {
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int ret;
+    do {
+        ret = poll(&pfd, 1, timeout_ms);
+    } while (ret < 0 && errno == EINTR);
+    return ret > 0 ? 0 : -1;
+}
+
+/**
+ * Connect to a server on this host through shared memory: the control
+ * socket of the server at addr:port, then the rings. The connection keeps
+ * addr and port as its peer, as the pool knows it by them.
+ */
+int remoteio_shm_connect(remoteio_context_t* ctx, remoteio_connection_t* conn,
+                         const char* addr, uint16_t port) {
+    if (!ctx || !conn || !addr || !remoteio_shm_local(addr)) return -1;
+    
+    char name[INET6_ADDRSTRLEN];
+    if (remoteio_shm_name(addr[0] == '/' ? addr : NULL, port, name, sizeof(name)) != 0 ||
+        remoteio_network_connect(ctx, conn, name, 0) != 0) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&conn->lock);
+    snprintf(conn->peer_addr, sizeof(conn->peer_addr), "%s", addr);
+    conn->peer_port = port;
+    pthread_mutex_unlock(&conn->lock);
+    
+    size_t map_len = shm_map_len();
+    int fds[SHM_HELLO_FDS] = {
+        memfd_create("remoteio-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING),
+        eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC),
+        eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC),
+    };
+    void* base = MAP_FAILED;
+    remoteio_shm_conn_t* shm = NULL;
+    
+    if (fds[0] < 0 || fds[1] < 0 || fds[2] < 0 ||
+        ftruncate(fds[0], (off_t)map_len) != 0 ||
+        fcntl(fds[0], F_ADD_SEALS, SHM_SEALS) != 0) {
+        goto fail;
+    }
+    
+    /* Fault the rings in now rather than on the first transfers */
+    base = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fds[0], 0);
+    if (base == MAP_FAILED) goto fail;
+    
+    shm_layout_t* layout = (shm_layout_t*)base;
+    layout->magic = SHM_MAGIC;
+    layout->version = SHM_VERSION;
+    layout->ring_bytes = REMOTEIO_SHM_RING_BYTES;
+    
+    /* Neither reader has looked yet: the first write must wake it */
+    layout->rings[0].reader_asleep = 1;
+    layout->rings[1].reader_asleep = 1;
+    
+    /* Hand the rings over */
+    shm_hello_t hello = {
+        .magic = SHM_MAGIC,
+        .version = SHM_VERSION,
+        .ring_bytes = REMOTEIO_SHM_RING_BYTES,
+    };
+    union {
+        char buf[CMSG_SPACE(sizeof(fds))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct iovec iov = { .iov_base = &hello, .iov_len = sizeof(hello) };
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf),
+    };
+    struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+    
+    if (sendmsg(conn->socket_fd, &msg, MSG_NOSIGNAL) != (ssize_t)sizeof(hello)) goto fail;
+    
+    /* The server echoes the hello once it has mapped them */
+    shm_hello_t ack;
+    if (shm_wait_socket(conn->socket_fd, REMOTEIO_HELLO_TIMEOUT_MS) != 0 ||
+        recv(conn->socket_fd, &ack, sizeof(ack), MSG_WAITALL) != (ssize_t)sizeof(ack) ||
+        memcmp(&ack, &hello, sizeof(ack)) != 0) {
+        goto fail;
+    }
+    
+    shm = shm_wrap(base, fds[1], fds[2], conn->socket_fd, true);
+    if (!shm) goto fail;
+    
+    close(fds[0]);
+    shm_attach(conn, shm);
+    return 0;
+
+fail:
+    if (base != MAP_FAILED) munmap(base, map_len);
+    for (int i = 0; i < SHM_HELLO_FDS; i++) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+    return -1;
+}
+
+/**
+ * Server side of the handshake, on a connection accepted from the control
+ * socket: take the client's rings, check them and answer. Never waits;
+ * call it once the socket is readable. The caller refuses a client that
+ * says nothing within REMOTEIO_HELLO_TIMEOUT_MS.
+ */
+int remoteio_shm_accept(remoteio_connection_t* conn) {
+    if (!conn || conn->socket_fd < 0 || conn->shm) return -1;
+    
+    shm_hello_t hello;
+    union {
+        char buf[CMSG_SPACE(SHM_HELLO_FDS * sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct iovec iov = { .iov_base = &hello, .iov_len = sizeof(hello) };
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf),
+    };
+    
+    ssize_t n = recvmsg(conn->socket_fd, &msg, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+    
+    /* Whatever arrived is ours to close */
+    int fds[SHM_HELLO_FDS] = { -1, -1, -1 };
+    int nfds = 0;
+    for (struct cmsghdr* cm = n > 0 ? CMSG_FIRSTHDR(&msg) : NULL; cm;
+         cm = CMSG_NXTHDR(&msg, cm)) {
+        if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) continue;
+        int count = (int)((cm->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        for (int i = 0; i < count; i++) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cm) + i * sizeof(int), sizeof(int));
+            if (nfds < SHM_HELLO_FDS) {
+                fds[nfds++] = fd;
+            } else {
+                close(fd);
+            }
+        }
+    }
+    
+    size_t map_len = shm_map_len();
+    void* base = MAP_FAILED;
+    struct stat st;
+    int seals;
+    
+    /* The client could otherwise shrink the file under our mapping */
+    if (n != (ssize_t)sizeof(hello) || (msg.msg_flags & MSG_CTRUNC) || nfds != SHM_HELLO_FDS ||
+        hello.magic != SHM_MAGIC || hello.version != SHM_VERSION ||
+        hello.ring_bytes != REMOTEIO_SHM_RING_BYTES ||
+        fstat(fds[0], &st) != 0 || (size_t)st.st_size != map_len ||
+        (seals = fcntl(fds[0], F_GET_SEALS)) < 0 || (seals & F_SEAL_SHRINK) == 0) {
+        goto fail;
+    }
+    
+    base = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fds[0], 0);
+    if (base == MAP_FAILED) goto fail;
+    
+    shm_layout_t* layout = (shm_layout_t*)base;
+    if (layout->magic != SHM_MAGIC || layout->version != SHM_VERSION ||
+        layout->ring_bytes != REMOTEIO_SHM_RING_BYTES) {
+        goto fail;
+    }
+    
+    /* Our eventfd is the second the client made */
+    remoteio_shm_conn_t* shm = shm_wrap(base, fds[2], fds[1], conn->socket_fd, false);
+    if (!shm) goto fail;
+    fds[1] = fds[2] = -1;
+    base = MAP_FAILED;
+    
+    if (send(conn->socket_fd, &hello, sizeof(hello), MSG_NOSIGNAL) != (ssize_t)sizeof(hello)) {
+        shm_free(shm);
+        goto fail;
+    }
+    
+    close(fds[0]);
+    shm_attach(conn, shm);
+    return 0;
+
+fail:
+    if (base != MAP_FAILED) munmap(base, map_len);
+    for (int i = 0; i < SHM_HELLO_FDS; i++) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+    return -1;
+}
+
+/* ============================================================================
+ * Data Path
+ * ============================================================================ */
+
+static bool shm_closed(remoteio_shm_conn_t* shm) {
+    return __atomic_load_n(shm->closed, __ATOMIC_ACQUIRE) != 0;
+}
+
+/* The control socket is quiet until the peer closes it */
+static bool shm_peer_alive(remoteio_connection_t* conn) {
+    char c;
+    ssize_t n = recv(conn->socket_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+}
+
+/* Make len more bytes visible to the reader, waking it if it sleeps */
+static void shm_publish(remoteio_shm_conn_t* shm, size_t len) {
+    shm->tx_head += len;
+    __atomic_store_n(&shm->tx->head, shm->tx_head, __ATOMIC_SEQ_CST);
+    
+    if (__atomic_load_n(&shm->tx->reader_asleep, __ATOMIC_SEQ_CST)) {
+        __atomic_store_n(&shm->tx->reader_asleep, 0, __ATOMIC_RELAXED);
+        uint64_t one = 1;
+        if (write(shm->peer_wake_fd, &one, sizeof(one)) < 0) {
+            /* Counter saturated: a wakeup is pending anyway */
+        }
+    }
+}
+
+/* Free bytes in tx, waiting while there are none; -1 once the connection
+ * is gone or the peer stalls for SHM_TIMEOUT_MS */
+static int64_t shm_wait_room(remoteio_connection_t* conn) {
+    remoteio_shm_conn_t* shm = conn->shm;
+    remoteio_shm_ring_t* tx = shm->tx;
+    int waited_ms = 0;
+    
+    for (;;) {
+        uint32_t seq = __atomic_load_n(&tx->space_seq, __ATOMIC_ACQUIRE);
+        uint64_t used = shm->tx_head - __atomic_load_n(&tx->tail, __ATOMIC_ACQUIRE);
+        
+        /* A tail past the head means the peer broke the ring */
+        if (used > REMOTEIO_SHM_RING_BYTES || shm_closed(shm)) return -1;
+        if (used < REMOTEIO_SHM_RING_BYTES) return (int64_t)(REMOTEIO_SHM_RING_BYTES - used);
+        
+        /* Ask for a wakeup, then look again: the reader may have missed it */
+        __atomic_store_n(&tx->writer_waiting, 1, __ATOMIC_SEQ_CST);
+        if (shm->tx_head - __atomic_load_n(&tx->tail, __ATOMIC_SEQ_CST) <
+            REMOTEIO_SHM_RING_BYTES) {
+            continue;
+        }
+        
+        if (waited_ms >= SHM_TIMEOUT_MS || !shm_peer_alive(conn)) return -1;
+        struct timespec ts = { .tv_sec = 0, .tv_nsec = REMOTEIO_SHM_WAIT_MS * 1000000L };
+        shm_futex(&tx->space_seq, FUTEX_WAIT, seq, &ts);
+        waited_ms += REMOTEIO_SHM_WAIT_MS;
+    }
+}
+
+/**
+ * Write the pieces to the peer, waiting for room as needed; like
+ * remoteio_network_sendv() the caller serializes sends. They are published
+ * together, so the reader wakes once for a whole frame that fits.
+ */
+int remoteio_shm_send(remoteio_connection_t* conn, const struct iovec* iov, int iovcnt) {
+    if (!conn || !conn->shm || !iov || iovcnt < 0) return -1;
+    
+    remoteio_shm_conn_t* shm = conn->shm;
+    const uint64_t mask = REMOTEIO_SHM_RING_BYTES - 1;
+    uint64_t room = 0;
+    size_t pending = 0;
+    size_t total = 0;
+    
+    for (int i = 0; i < iovcnt; i++) {
+        const char* src = (const char*)iov[i].iov_base;
+        size_t left = iov[i].iov_len;
+        
+        while (left > 0) {
+            if (room == 0) {
+                if (pending > 0) shm_publish(shm, pending);
+                pending = 0;
+                int64_t free_bytes = shm_wait_room(conn);
+                if (free_bytes < 0) return -1;
+                room = (uint64_t)free_bytes;
+            }
+            
+            uint64_t pos = (shm->tx_head + pending) & mask;
+            size_t n = left < room ? left : (size_t)room;
+            if (n > REMOTEIO_SHM_RING_BYTES - pos) n = (size_t)(REMOTEIO_SHM_RING_BYTES - pos);
+            
+            memcpy(shm->tx_data + pos, src, n);
+            src += n;
+            left -= n;
+            room -= n;
+            pending += n;
+            total += n;
+        }
+    }
+    if (pending > 0) shm_publish(shm, pending);
+    
+    pthread_mutex_lock(&conn->lock);
+    conn->bytes_sent += total;
+    pthread_mutex_unlock(&conn->lock);
+    
+    return 0;
+}
+
+/* Send a file range, read straight into the ring */
+int remoteio_shm_sendfile(remoteio_connection_t* conn, int fd, uint64_t offset, size_t len) {
+    if (!conn || !conn->shm || fd < 0) return -1;
+    
+    remoteio_shm_conn_t* shm = conn->shm;
+    const uint64_t mask = REMOTEIO_SHM_RING_BYTES - 1;
+    uint64_t room = 0;
+    size_t pending = 0;
+    size_t done = 0;
+    
+    while (done < len) {
+        if (room == 0) {
+            if (pending > 0) shm_publish(shm, pending);
+            pending = 0;
+            int64_t free_bytes = shm_wait_room(conn);
+            if (free_bytes < 0) return -1;
+            room = (uint64_t)free_bytes;
+        }
+        
+        uint64_t pos = (shm->tx_head + pending) & mask;
+        size_t n = len - done < room ? len - done : (size_t)room;
+        if (n > REMOTEIO_SHM_RING_BYTES - pos) n = (size_t)(REMOTEIO_SHM_RING_BYTES - pos);
+        
+        ssize_t got = pread(fd, shm->tx_data + pos, n, (off_t)(offset + done));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) {
+            /* Error, or the file is shorter than the range */
+            return -1;
+        }
+        done += (size_t)got;
+        room -= (size_t)got;
+        pending += (size_t)got;
+    }
+    if (pending > 0) shm_publish(shm, pending);
+    
+    pthread_mutex_lock(&conn->lock);
+    conn->bytes_sent += done;
+    pthread_mutex_unlock(&conn->lock);
+    
+    return 0;
+}
+
+/**
+ * Take up to len bytes the peer wrote, without blocking: recv() semantics,
+ * 0 once the peer is gone and the ring drained, -1 with EAGAIN when there
+ * is nothing yet. An empty ring leaves the reader flagged asleep, so the
+ * next write signals wake_fd and remoteio_network_poll_fd() turns readable.
+ * wake_fd is only drained here, at an empty ring, so it stays readable
+ * while unread data remains, as a socket would.
+ */
+ssize_t remoteio_shm_recv(remoteio_connection_t* conn, void* buf, size_t len) {
+    if (!conn || !conn->shm || !buf) {
+        errno = EINVAL;
+        return -1;
+    }
+    
+    remoteio_shm_conn_t* shm = conn->shm;
+    remoteio_shm_ring_t* rx = shm->rx;
+    uint64_t avail = __atomic_load_n(&rx->head, __ATOMIC_ACQUIRE) - shm->rx_tail;
+    
+    if (avail == 0) {
+        /* Ask for a wakeup, then look again: the writer may have missed it */
+        __atomic_store_n(&rx->reader_asleep, 1, __ATOMIC_SEQ_CST);
+        uint64_t count;
+        if (read(shm->wake_fd, &count, sizeof(count)) < 0) {
+            /* Nothing pending */
+        }
+        avail = __atomic_load_n(&rx->head, __ATOMIC_SEQ_CST) - shm->rx_tail;
+        if (avail == 0) {
+            if (shm_closed(shm) || !shm_peer_alive(conn)) return 0;
+            errno = EAGAIN;
+            return -1;
+        }
+        
+        /* Data raced in after the drain. The caller may stop reading before
+         * the ring is empty, so keep wake_fd readable for it. */
+        __atomic_store_n(&rx->reader_asleep, 0, __ATOMIC_RELAXED);
+        uint64_t one = 1;
+        if (write(shm->wake_fd, &one, sizeof(one)) < 0) {
+            /* Counter saturated: a wakeup is pending anyway */
+        }
+    }
+    if (avail > REMOTEIO_SHM_RING_BYTES) {
+        errno = EPROTO;
+        return -1;
+    }
+    
+    uint64_t pos = shm->rx_tail & (REMOTEIO_SHM_RING_BYTES - 1);
+    size_t n = len < avail ? len : (size_t)avail;
+    size_t first = n < REMOTEIO_SHM_RING_BYTES - pos ? n : (size_t)(REMOTEIO_SHM_RING_BYTES - pos);
+    memcpy(buf, shm->rx_data + pos, first);
+    memcpy((char*)buf + first, shm->rx_data, n - first);
+    
+    shm->rx_tail += n;
+    __atomic_store_n(&rx->tail, shm->rx_tail, __ATOMIC_SEQ_CST);
+    
+    if (__atomic_load_n(&rx->writer_waiting, __ATOMIC_SEQ_CST)) {
+        __atomic_store_n(&rx->writer_waiting, 0, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&rx->space_seq, 1, __ATOMIC_SEQ_CST);
+        shm_futex(&rx->space_seq, FUTEX_WAKE, INT_MAX, NULL);
+    }
+    
+    return (ssize_t)n;
+}
+
+/* ============================================================================
+ * Teardown
+ * ============================================================================ */
+
+/* Mark the rings closed and wake everyone waiting on either side */
+static void shm_close_rings(remoteio_shm_conn_t* shm) {
+    __atomic_store_n(shm->closed, 1, __ATOMIC_SEQ_CST);
+    
+    uint64_t one = 1;
+    if (write(shm->peer_wake_fd, &one, sizeof(one)) < 0 ||
+        write(shm->wake_fd, &one, sizeof(one)) < 0) {
+        /* Counter saturated: a wakeup is pending anyway */
+    }
+    for (int i = 0; i < 2; i++) {
+        remoteio_shm_ring_t* ring = i ? shm->rx : shm->tx;
+        __atomic_fetch_add(&ring->space_seq, 1, __ATOMIC_SEQ_CST);
+        shm_futex(&ring->space_seq, FUTEX_WAKE, INT_MAX, NULL);
+    }
+}
+
+/* Fail the connection for both sides; what was written may still be read */
+void remoteio_shm_shutdown(remoteio_connection_t* conn) {
+    if (!conn || !conn->shm) return;
+    
+    shm_close_rings(conn->shm);
+    shutdown(conn->socket_fd, SHUT_RDWR);
+}
+
+/* Unmap the rings; the connection must no longer be in use */
+void remoteio_shm_close(remoteio_connection_t* conn) {
+    if (!conn || !conn->shm) return;
+    
+    remoteio_shm_conn_t* shm = conn->shm;
+    shm_close_rings(shm);
+    conn->shm = NULL;
+    shm_free(shm);
+}
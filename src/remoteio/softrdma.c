@@ -0,0 +1,104 @@
+/**
+ * @file softrdma.c
+ * @brief RemoteIO module - Software one-sided RDMA
+ * @version 1.0.0
+ *
+ * Emulates one-sided RDMA READ/WRITE for machines without an RDMA NIC. The
+ * post functions take the same arguments as their ibverbs counterparts in
+ * rdma.c; instead of a work request they send RDMA_READ/RDMA_WRITE frames
+ * over the connection's framed protocol (TCP, or a Unix socket when the
+ * peer address is a path). The server's event thread checks the rkey and
+ * bounds against its region table and accesses the memory directly, and
+ * the completion reactor completes the op as it would a CQ entry.
+ *
+ * Chains of such ops go out as one batch of frames, see
+ * remoteio_proto_submit_chain(); that is what small-transfer tests use in
+ * place of doorbell batching on a real NIC.
+ *
+ * Local memory needs no pinning here, so registration only records it.
+ */
+
+#include "remoteio_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Describe local memory for one-sided ops; no keys are involved */
+int remoteio_soft_rdma_register_memory(void* ptr, size_t length, int gpu_id,
+                                       remoteio_gdr_region_t** region_out) {
+    if (!ptr || length == 0 || !region_out) return -1;
+    
+    remoteio_gdr_region_t* region = calloc(1, sizeof(remoteio_gdr_region_t));
+    if (!region) return -1;
+    
+    region->gpu_ptr = ptr;
+    region->gpu_phys = (uint64_t)(uintptr_t)ptr;
+    region->length = length;
+    region->gpu_id = gpu_id;
+    
+    *region_out = region;
+    return 0;
+}
+
+/* Fill in op for a one-sided transfer and send it */
+static int soft_rdma_post(remoteio_connection_t* conn, remoteio_op_t type,
+                          remoteio_gdr_region_t* local_mr, remoteio_remote_mem_t* remote,
+                          uint64_t local_offset, uint64_t remote_offset, size_t len,
+                          remoteio_operation_t* op) {
+    if (!conn || !local_mr || !remote || !op) return -1;
+    if (conn->state != REMOTEIO_CONN_CONNECTED || !conn->proto) return -1;
+    
+    /* The local side is checked here; the peer checks its own */
+    if (local_offset > local_mr->length || len > local_mr->length - local_offset) {
+        return -1;
+    }
+    
+    op->op = type;
+    op->conn = conn;
+    op->local_gdr = local_mr;
+    op->local_offset = local_offset;
+    op->length = len;
+    op->one_sided = true;
+    op->raddr = remote->raddr + remote_offset;
+    op->rkey = remote->rkey;
+    
+    return remoteio_proto_submit(conn, op);
+}
+
+int remoteio_soft_rdma_post_read(remoteio_connection_t* conn,
+                                 remoteio_gdr_region_t* local_mr,
+                                 remoteio_remote_mem_t* remote,
+                                 uint64_t local_offset, uint64_t remote_offset,
+                                 size_t len, remoteio_operation_t* op) {
+    return soft_rdma_post(conn, REMOTEIO_OP_READ, local_mr, remote,
+                          local_offset, remote_offset, len, op);
+}
+
+int remoteio_soft_rdma_post_write(remoteio_connection_t* conn,
+                                  remoteio_gdr_region_t* local_mr,
+                                  remoteio_remote_mem_t* remote,
+                                  uint64_t local_offset, uint64_t remote_offset,
+                                  size_t len, remoteio_operation_t* op) {
+    return soft_rdma_post(conn, REMOTEIO_OP_WRITE, local_mr, remote,
+                          local_offset, remote_offset, len, op);
+}
+
+/**
+ * Post a chain of one-sided ops linked by next_sg with one batch of frames;
+ * same contract as remoteio_rdma_post_chain().
+ */
+int remoteio_soft_rdma_post_chain(remoteio_connection_t* conn, remoteio_operation_t* chain,
+                                  int signal_every) {
+    if (!conn || !chain || chain->conn != conn) return -1;
+    if (conn->state != REMOTEIO_CONN_CONNECTED || !conn->proto) return -1;
+    
+    if (remoteio_op_chain_prepare(chain, signal_every) < 0) return -1;
+    
+    for (remoteio_operation_t* op = chain; op; op = op->next_sg) {
+        op->one_sided = true;
+        op->raddr = op->remote_mem->raddr + op->remote_offset;
+        op->rkey = op->remote_mem->rkey;
+    }
+    
+    if (remoteio_proto_submit_chain(conn, chain) != 0) return -1;
+    return chain->sg_count;
+}
@@ -0,0 +1,244 @@
+/**
+ * @file bench_localio.c
+ * @brief LocalIO random small-read benchmark (pread vs io_uring vs mmap)
+ * @version 1.0.0
+ *
+ * Issues random record reads against a scratch file through each per-file
+ * read path and reports the record size at which mmap stops winning. Then
+ * times GPU-destination reads one at a time against localio_read_gpu_batch;
+ * point GPUIO_CUFILE_LIBRARY at libcufile (or the stub) for the batch API.
+ *
+ * Usage: bench_localio [file_size_mb] [scratch_path]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "localio_internal.h"
+
+#define DEFAULT_FILE_MB   256
+#define READS_PER_SIZE    20000
+#define BATCH_SIZE        32
+#define MAX_RECORD        (1 << 20)
+#define GPU_READS         4096
+
+static double get_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static const char* mode_names[] = { "pread", "io_uring", "mmap" };
+
+static int create_scratch(const char* path, size_t size) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    
+    char* chunk = malloc(1 << 20);
+    if (!chunk) {
+        close(fd);
+        return -1;
+    }
+    for (int i = 0; i < (1 << 20); i++) chunk[i] = (char)(i * 31);
+    
+    for (size_t done = 0; done < size; done += (1 << 20)) {
+        if (write(fd, chunk, 1 << 20) != (1 << 20)) {
+            free(chunk);
+            close(fd);
+            return -1;
+        }
+    }
+    
+    free(chunk);
+    fsync(fd);
+    close(fd);
+    return 0;
+}
+
+/* Random reads in batches of BATCH_SIZE; returns reads per second */
+static double bench_mode(localio_file_t* file, size_t record,
+                         const uint64_t* offsets, char* bufs) {
+    localio_extent_t extents[BATCH_SIZE];
+    void* ptrs[BATCH_SIZE];
+    ssize_t results[BATCH_SIZE];
+    
+    for (int i = 0; i < BATCH_SIZE; i++) {
+        ptrs[i] = bufs + (size_t)i * record;
+    }
+    
+    double start = get_time_us();
+    
+    for (int base = 0; base < READS_PER_SIZE; base += BATCH_SIZE) {
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            extents[i].offset = offsets[base + i];
+            extents[i].count = record;
+        }
+        
+        if (file->io_mode == LOCALIO_IO_MMAP) {
+            localio_file_prefetch(file, extents, BATCH_SIZE);
+        }
+        
+        if (file->io_mode == LOCALIO_IO_PREAD) {
+            /* One syscall per record, as a naive loader would issue */
+            for (int i = 0; i < BATCH_SIZE; i++) {
+                localio_file_read(file, ptrs[i], record, extents[i].offset,
+                                  NULL);
+            }
+        } else {
+            localio_file_read_batch(file, extents, ptrs, results, BATCH_SIZE);
+        }
+    }
+    
+    double elapsed = get_time_us() - start;
+    return READS_PER_SIZE / (elapsed / 1e6);
+}
+
+/* GPU-destination reads in batches of BATCH_SIZE: per-record localio_gds_read
+ * on one descriptor, or one localio_read_gpu_batch call; returns reads/s */
+static double bench_gpu(localio_context_t* ctx, const char* path, size_t record,
+                        const uint64_t* offsets, char* bufs, int batched) {
+    localio_extent_t extents[BATCH_SIZE];
+    void* ptrs[BATCH_SIZE];
+    ssize_t results[BATCH_SIZE];
+    
+    for (int i = 0; i < BATCH_SIZE; i++) {
+        ptrs[i] = bufs + (size_t)i * record;
+    }
+    
+    double start = get_time_us();
+    
+    for (int base = 0; base < GPU_READS; base += BATCH_SIZE) {
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            extents[i].offset = offsets[base + i];
+            extents[i].count = record;
+        }
+        
+        if (batched) {
+            localio_read_gpu_batch(ctx, path, extents, ptrs, results, BATCH_SIZE);
+        } else {
+            int fd = open(path, O_RDONLY);
+            if (fd < 0) return 0;
+            for (int i = 0; i < BATCH_SIZE; i++) {
+                localio_gds_read(ctx, fd, ptrs[i], record, extents[i].offset);
+            }
+            close(fd);
+        }
+    }
+    
+    double elapsed = get_time_us() - start;
+    return GPU_READS / (elapsed / 1e6);
+}
+
+int main(int argc, char* argv[]) {
+    size_t file_mb = (argc > 1) ? (size_t)atol(argv[1]) : DEFAULT_FILE_MB;
+    const char* path = (argc > 2) ? argv[2] : "/tmp/gpuio_bench_localio.dat";
+    size_t file_size = file_mb << 20;
+    
+    printf("============================================================\n");
+    printf("gpuio LocalIO Random Read Benchmark\n");
+    printf("============================================================\n");
+    printf("\nConfiguration:\n");
+    printf("  File: %s (%zu MB)\n", path, file_mb);
+    printf("  Reads per size: %d (batches of %d)\n", READS_PER_SIZE, BATCH_SIZE);
+    
+    if (file_size < MAX_RECORD || create_scratch(path, file_size) != 0) {
+        fprintf(stderr, "Failed to create scratch file %s\n", path);
+        return 1;
+    }
+    
+    localio_context_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    pthread_mutex_init(&ctx.files_lock, NULL);
+    
+    localio_file_t* file;
+    if (localio_file_open(&ctx, path, GPUIO_MEM_READ, &file) != 0) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        unlink(path);
+        return 1;
+    }
+    
+    uint64_t* offsets = malloc(READS_PER_SIZE * sizeof(uint64_t));
+    char* bufs = malloc((size_t)BATCH_SIZE * MAX_RECORD);
+    if (!offsets || !bufs) return 1;
+    
+    printf("\n  %10s | %14s | %14s | %14s\n", "Record",
+           mode_names[0], mode_names[1], mode_names[2]);
+    printf("  %10s | %14s | %14s | %14s\n", "", "reads/s", "reads/s", "reads/s");
+    
+    size_t crossover = 0;
+    uint64_t seed = 42;
+    
+    for (size_t record = 64; record <= MAX_RECORD; record *= 4) {
+        for (int i = 0; i < READS_PER_SIZE; i++) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            offsets[i] = (seed >> 17) % (file_size - record);
+        }
+        
+        double rate[3];
+        for (int m = 0; m < 3; m++) {
+            if (localio_file_set_io_mode(file, (localio_io_mode_t)m) != 0) {
+                rate[m] = 0;
+                continue;
+            }
+            rate[m] = bench_mode(file, record, offsets, bufs);
+        }
+        
+        printf("  %8zu B | %14.0f | %14.0f | %14.0f\n",
+               record, rate[0], rate[1], rate[2]);
+        
+        /* mmap has to beat the best syscall path (0 if unavailable) */
+        double best_syscall = rate[0] > rate[1] ? rate[0] : rate[1];
+        if (!crossover && rate[2] < best_syscall) {
+            crossover = record;
+        }
+    }
+    
+    if (crossover) {
+        printf("\n  mmap stops winning at %zu-byte records\n", crossover);
+    } else {
+        printf("\n  mmap wins at every record size tested\n");
+    }
+    
+    localio_file_close(file);
+    free(ctx.files);
+    pthread_mutex_destroy(&ctx.files_lock);
+    
+    /* GPU-destination reads; bounced through host memory without GDS */
+    printf("\nGPU reads (serial vs batched):\n");
+    if (gpuio_init(&ctx.parent, NULL) == GPUIO_SUCCESS) {
+        localio_gds_init(&ctx);
+        printf("  GDS: %s\n", ctx.gds_available ? "cuFile loaded" :
+                                                  "unavailable, host bounce");
+        printf("\n  %10s | %14s | %14s\n", "Record", "serial", "batched");
+        printf("  %10s | %14s | %14s\n", "", "reads/s", "reads/s");
+        
+        for (size_t record = 4096; record <= MAX_RECORD; record *= 4) {
+            for (int i = 0; i < GPU_READS; i++) {
+                seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                offsets[i] = ((seed >> 17) % (file_size - record)) & ~4095ULL;
+            }
+            
+            double serial = bench_gpu(&ctx, path, record, offsets, bufs, 0);
+            double batched = bench_gpu(&ctx, path, record, offsets, bufs, 1);
+            printf("  %8zu B | %14.0f | %14.0f\n", record, serial, batched);
+        }
+        
+        localio_gds_cleanup(&ctx);
+        gpuio_finalize(ctx.parent);
+    } else {
+        printf("  gpuio_init failed, skipped\n");
+    }
+    
+    free(offsets);
+    free(bufs);
+    unlink(path);
+    
+    printf("\n============================================================\n");
+    printf("Benchmarks Complete\n");
+    printf("============================================================\n");
+    
+    return 0;
+}
@@ -8,6 +8,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <time.h>
 #include <gpuio/gpuio.h>
 #include <gpuio/gpuio_ai.h>
 
@@ -597,6 +601,773 @@ TEST(codec_types) {
     }
 }
 
+TEST(codec_lz4_roundtrip) {
+    gpuio_codec_t codec;
+    gpuio_error_t err = gpuio_codec_create(g_ctx, GPUIO_CODEC_LZ4, 1, &codec);
+    ASSERT_EQ(err, GPUIO_SUCCESS);
+    
+    size_t size = 256 * 1024;
+    size_t bound = size + size / 255 + 16;
+    uint8_t* input = malloc(size);
+    uint8_t* packed = malloc(bound);
+    uint8_t* output = malloc(size);
+    ASSERT_NOT_NULL(input);
+    ASSERT_NOT_NULL(packed);
+    ASSERT_NOT_NULL(output);
+    
+    /* Repetitive records with some noise: compresses well */
+    uint32_t rng = 12345;
+    for (size_t i = 0; i < size; i++) {
+        rng = rng * 1103515245u + 12345u;
+        input[i] = (i % 97 == 0) ? (uint8_t)(rng >> 24) : (uint8_t)("tensor-shard-"[i % 13]);
+    }
+    
+    size_t packed_size = 0;
+    err = gpuio_compress(codec, input, size, packed, bound, &packed_size, NULL);
+    ASSERT_EQ(err, GPUIO_SUCCESS);
+    ASSERT(packed_size < size / 4);
+    
+    size_t output_size = 0;
+    err = gpuio_decompress(codec, packed, packed_size, output, size, &output_size, NULL);
+    ASSERT_EQ(err, GPUIO_SUCCESS);
+    ASSERT_EQ(output_size, size);
+    ASSERT(memcmp(input, output, size) == 0);
+    
+    /* Random bytes don't fit in their own size, but round-trip within the bound */
+    for (size_t i = 0; i < size; i++) {
+        rng = rng * 1103515245u + 12345u;
+        input[i] = (uint8_t)(rng >> 24);
+    }
+    err = gpuio_compress(codec, input, size, packed, size, &packed_size, NULL);
+    ASSERT_EQ(err, GPUIO_ERROR_INVALID_ARG);
+    err = gpuio_compress(codec, input, size, packed, bound, &packed_size, NULL);
+    ASSERT_EQ(err, GPUIO_SUCCESS);
+    err = gpuio_decompress(codec, packed, packed_size, output, size, &output_size, NULL);
+    ASSERT_EQ(err, GPUIO_SUCCESS);
+    ASSERT_EQ(output_size, size);
+    ASSERT(memcmp(input, output, size) == 0);
+    
+    /* Corrupt input is rejected, never overrun */
+    packed[0] = 0x0F;
+    packed[1] = 0xFF;
+    packed[2] = 0xFF;
+    err = gpuio_decompress(codec, packed, 3, output, size, &output_size, NULL);
+    ASSERT_EQ(err, GPUIO_ERROR_IO);
+    
+    free(input);
+    free(packed);
+    free(output);
+    gpuio_codec_destroy(codec);
+}
+
+/* ============================================================================
+ * Checkpoint Tests
+ * ============================================================================ */
+
+static void remove_dir(const char* path) {
+    DIR* dir = opendir(path);
+    if (!dir) return;
+    
+    struct dirent* ent;
+    char file[1024];
+    while ((ent = readdir(dir)) != NULL) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) {
+            continue;
+        }
+        snprintf(file, sizeof(file), "%s/%s", path, ent->d_name);
+        unlink(file);
+    }
+    closedir(dir);
+    rmdir(path);
+}
+
+static int count_shards(const char* path) {
+    DIR* dir = opendir(path);
+    if (!dir) return -1;
+    
+    int count = 0;
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strncmp(ent->d_name, "shard_", 6) == 0) count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+TEST(checkpoint_save_load) {
+    char path[] = "/tmp/gpuio_ckpt_XXXXXX";
+    ASSERT_NOT_NULL(mkdtemp(path));
+    
+    size_t sizes[] = { 4096 * 3 + 17, 1 << 20, 3 * (1 << 20) + 5, 100 };
+    const char* names[] = { "embed", "layer0.w", "layer1.w", "bias" };
+    uint8_t* tensors[4];
+    
+    for (int i = 0; i < 4; i++) {
+        tensors[i] = malloc(sizes[i]);
+        ASSERT_NOT_NULL(tensors[i]);
+        for (size_t j = 0; j < sizes[i]; j++) {
+            tensors[i][j] = (uint8_t)(j * 7 + i);
+        }
+        ASSERT_EQ(gpuio_ai_checkpoint_register_tensor(g_ai_ctx, names[i],
+                                                      tensors[i], sizes[i]),
+                  GPUIO_SUCCESS);
+    }
+    
+    gpuio_checkpoint_config_t config = {
+        .num_shards = 3,
+        .num_threads = 2,
+        .io_size = 1 << 20,
+        .direct_io = true,
+    };
+    ASSERT_EQ(gpuio_ai_checkpoint_configure(g_ai_ctx, &config), GPUIO_SUCCESS);
+    
+    ASSERT_EQ(gpuio_ai_checkpoint_save(g_ai_ctx, path, false, NULL), GPUIO_SUCCESS);
+    ASSERT_EQ(count_shards(path), 3);
+    
+    /* Save again: the previous generation's shards are replaced */
+    ASSERT_EQ(gpuio_ai_checkpoint_save(g_ai_ctx, path, false, NULL), GPUIO_SUCCESS);
+    ASSERT_EQ(count_shards(path), 3);
+    
+    for (int i = 0; i < 4; i++) {
+        memset(tensors[i], 0, sizes[i]);
+    }
+    
+    ASSERT_EQ(gpuio_ai_checkpoint_load(g_ai_ctx, path, NULL), GPUIO_SUCCESS);
+    
+    for (int i = 0; i < 4; i++) {
+        for (size_t j = 0; j < sizes[i]; j++) {
+            ASSERT_EQ(tensors[i][j], (uint8_t)(j * 7 + i));
+        }
+    }
+    
+    gpuio_checkpoint_stats_t stats;
+    ASSERT_EQ(gpuio_ai_checkpoint_get_stats(g_ai_ctx, &stats), GPUIO_SUCCESS);
+    ASSERT(stats.checkpoints_saved >= 2);
+    ASSERT(stats.checkpoints_loaded >= 1);
+    ASSERT_EQ(stats.last_save_bytes, sizes[0] + sizes[1] + sizes[2] + sizes[3]);
+    ASSERT(stats.last_save_gbps > 0);
+    
+    for (int i = 0; i < 4; i++) {
+        gpuio_ai_checkpoint_unregister_tensor(g_ai_ctx, names[i]);
+        free(tensors[i]);
+    }
+    remove_dir(path);
+}
+
+TEST(checkpoint_detects_corruption) {
+    char path[] = "/tmp/gpuio_ckpt_XXXXXX";
+    ASSERT_NOT_NULL(mkdtemp(path));
+    
+    size_t size = 256 * 1024;
+    uint8_t* data = malloc(size);
+    ASSERT_NOT_NULL(data);
+    memset(data, 0x5a, size);
+    
+    ASSERT_EQ(gpuio_ai_checkpoint_register_tensor(g_ai_ctx, "weights", data, size),
+              GPUIO_SUCCESS);
+    ASSERT_EQ(gpuio_ai_checkpoint_save(g_ai_ctx, path, false, NULL), GPUIO_SUCCESS);
+    
+    /* Flip one byte in the (single) shard */
+    DIR* dir = opendir(path);
+    ASSERT_NOT_NULL(dir);
+    struct dirent* ent;
+    char shard[1024] = "";
+    while ((ent = readdir(dir)) != NULL) {
+        if (strncmp(ent->d_name, "shard_", 6) == 0) {
+            snprintf(shard, sizeof(shard), "%s/%s", path, ent->d_name);
+        }
+    }
+    closedir(dir);
+    ASSERT(shard[0] != '\0');
+    
+    int fd = open(shard, O_WRONLY);
+    ASSERT(fd >= 0);
+    uint8_t bad = 0;
+    ASSERT_EQ(pwrite(fd, &bad, 1, 1234), 1);
+    close(fd);
+    
+    ASSERT_EQ(gpuio_ai_checkpoint_load(g_ai_ctx, path, NULL), GPUIO_ERROR_IO);
+    
+    /* Unknown tensor names are rejected */
+    ASSERT_EQ(gpuio_ai_checkpoint_unregister_tensor(g_ai_ctx, "missing"),
+              GPUIO_ERROR_NOT_FOUND);
+    
+    gpuio_ai_checkpoint_unregister_tensor(g_ai_ctx, "weights");
+    free(data);
+    remove_dir(path);
+}
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static int g_ckpt_callbacks = 0;
+static gpuio_error_t g_ckpt_callback_status = GPUIO_ERROR_GENERAL;
+
+static void ckpt_done(const char* path, gpuio_error_t status, void* user_data) {
+    (void)path;
+    (void)user_data;
+    g_ckpt_callbacks++;
+    g_ckpt_callback_status = status;
+}
+
+TEST(checkpoint_async_save) {
+    char path[] = "/tmp/gpuio_ckpt_XXXXXX";
+    ASSERT_NOT_NULL(mkdtemp(path));
+    
+    size_t size = 4 << 20;
+    uint8_t* data = malloc(size);
+    ASSERT_NOT_NULL(data);
+    for (size_t i = 0; i < size; i++) data[i] = (uint8_t)(i * 13);
+    
+    ASSERT_EQ(gpuio_ai_checkpoint_register_tensor(g_ai_ctx, "async.w", data, size),
+              GPUIO_SUCCESS);
+    
+    /* 4MB at 32MB/s takes ~125ms to persist */
+    gpuio_checkpoint_config_t config = {
+        .num_shards = 2,
+        .io_size = 1 << 20,
+        .async_bandwidth = 32 << 20,
+    };
+    ASSERT_EQ(gpuio_ai_checkpoint_configure(g_ai_ctx, &config), GPUIO_SUCCESS);
+    ASSERT_EQ(gpuio_ai_checkpoint_set_callback(g_ai_ctx, ckpt_done, NULL),
+              GPUIO_SUCCESS);
+    
+    g_ckpt_callbacks = 0;
+    uint64_t start = now_us();
+    ASSERT_EQ(gpuio_ai_checkpoint_save(g_ai_ctx, path, true, NULL), GPUIO_SUCCESS);
+    uint64_t returned = now_us() - start;
+    
+    /* Training may mutate the tensor while the snapshot is persisted */
+    memset(data, 0xff, size);
+    
+    ASSERT_EQ(gpuio_ai_checkpoint_wait(g_ai_ctx, -1), GPUIO_SUCCESS);
+    uint64_t persisted = now_us() - start;
+    ASSERT(returned < persisted);
+    ASSERT(persisted >= 100000);
+    ASSERT_EQ(g_ckpt_callbacks, 1);
+    ASSERT_EQ(g_ckpt_callback_status, GPUIO_SUCCESS);
+    
+    gpuio_checkpoint_stats_t stats;
+    ASSERT_EQ(gpuio_ai_checkpoint_get_stats(g_ai_ctx, &stats), GPUIO_SUCCESS);
+    ASSERT(stats.async_saves >= 1);
+    ASSERT(stats.last_snapshot_time_us <= returned);
+    
+    ASSERT_EQ(gpuio_ai_checkpoint_load(g_ai_ctx, path, NULL), GPUIO_SUCCESS);
+    for (size_t i = 0; i < size; i++) {
+        ASSERT_EQ(data[i], (uint8_t)(i * 13));
+    }
+    
+    gpuio_ai_checkpoint_set_callback(g_ai_ctx, NULL, NULL);
+    gpuio_ai_checkpoint_unregister_tensor(g_ai_ctx, "async.w");
+    free(data);
+    remove_dir(path);
+}
+
+TEST(checkpoint_incremental) {
+    char base[] = "/tmp/gpuio_ckpt_XXXXXX";
+    ASSERT_NOT_NULL(mkdtemp(base));
+    char dir_a[512], dir_b[512], dir_c[512];
+    snprintf(dir_a, sizeof(dir_a), "%s/a", base);
+    snprintf(dir_b, sizeof(dir_b), "%s/b", base);
+    snprintf(dir_c, sizeof(dir_c), "%s/c", base);
+    
+    size_t frozen_size = 4 << 20;
+    size_t trained_size = (2 << 20) + 100;
+    uint8_t* frozen = malloc(frozen_size);
+    uint8_t* trained = malloc(trained_size);
+    ASSERT_NOT_NULL(frozen);
+    ASSERT_NOT_NULL(trained);
+    for (size_t i = 0; i < frozen_size; i++) frozen[i] = (uint8_t)(i * 3);
+    memset(trained, 1, trained_size);
+    
+    ASSERT_EQ(gpuio_ai_checkpoint_register_tensor(g_ai_ctx, "frozen", frozen,
+                                                  frozen_size), GPUIO_SUCCESS);
+    ASSERT_EQ(gpuio_ai_checkpoint_register_tensor(g_ai_ctx, "trained", trained,
+                                                  trained_size), GPUIO_SUCCESS);
+    
+    gpuio_checkpoint_config_t config = { .num_shards = 2 };
+    ASSERT_EQ(gpuio_ai_checkpoint_configure(g_ai_ctx, &config), GPUIO_SUCCESS);
+    
+    ASSERT_EQ(gpuio_ai_checkpoint_save(g_ai_ctx, dir_a, false, NULL), GPUIO_SUCCESS);
+    
+    /* Only the first block of "trained" changes */
+    memset(trained, 2, 1000);
+    ASSERT_EQ(gpuio_ai_checkpoint_save_incremental(g_ai_ctx, dir_b, dir_a, false, NULL),
+              GPUIO_SUCCESS);
+    
+    gpuio_checkpoint_stats_t stats;
+    ASSERT_EQ(gpuio_ai_checkpoint_get_stats(g_ai_ctx, &stats), GPUIO_SUCCESS);
+    ASSERT_EQ(stats.last_save_bytes, frozen_size + trained_size);
+    ASSERT_EQ(stats.last_save_stored_bytes, (uint64_t)(1 << 20));
+    ASSERT(stats.last_save_dedup_ratio > 0.8);
+    
+    /* Second generation: the tail block changes, chain is c -> b -> a */
+    trained[trained_size - 1] = 9;
+    ASSERT_EQ(gpuio_ai_checkpoint_save_incremental(g_ai_ctx, dir_c, dir_b, true, NULL),
+              GPUIO_SUCCESS);
+    ASSERT_EQ(gpuio_ai_checkpoint_wait(g_ai_ctx, -1), GPUIO_SUCCESS);
+    ASSERT_EQ(gpuio_ai_checkpoint_get_stats(g_ai_ctx, &stats), GPUIO_SUCCESS);
+    ASSERT_EQ(stats.last_save_stored_bytes, (uint64_t)100);
+    
+    /* A checkpoint cannot be its own parent */
+    ASSERT_EQ(gpuio_ai_checkpoint_save_incremental(g_ai_ctx, dir_c, dir_c, false, NULL),
+              GPUIO_ERROR_INVALID_ARG);
+    
+    /* Nor can it replace any checkpoint further up its own chain */
+    ASSERT_EQ(gpuio_ai_checkpoint_save_incremental(g_ai_ctx, dir_a, dir_b, false, NULL),
+              GPUIO_ERROR_INVALID_ARG);
+    ASSERT_EQ(gpuio_ai_checkpoint_save_incremental(g_ai_ctx, dir_a, dir_c, false, NULL),
+              GPUIO_ERROR_INVALID_ARG);
+    ASSERT_EQ(gpuio_ai_checkpoint_save_incremental(g_ai_ctx, dir_b, dir_c, false, NULL),
+              GPUIO_ERROR_INVALID_ARG);
+    
+    memset(frozen, 0, frozen_size);
+    memset(trained, 0, trained_size);
+    ASSERT_EQ(gpuio_ai_checkpoint_load(g_ai_ctx, dir_c, NULL), GPUIO_SUCCESS);
+    for (size_t i = 0; i < frozen_size; i++) {
+        ASSERT_EQ(frozen[i], (uint8_t)(i * 3));
+    }
+    ASSERT_EQ(trained[0], 2);
+    ASSERT_EQ(trained[1000], 1);
+    ASSERT_EQ(trained[trained_size - 1], 9);
+    
+    ASSERT_EQ(gpuio_ai_checkpoint_load(g_ai_ctx, dir_b, NULL), GPUIO_SUCCESS);
+    ASSERT_EQ(trained[trained_size - 1], 1);
+    
+    /* Without the root of the chain the frozen blocks cannot be resolved */
+    remove_dir(dir_a);
+    memset(frozen, 7, frozen_size);
+    memset(trained, 7, trained_size);
+    ASSERT_EQ(gpuio_ai_checkpoint_load(g_ai_ctx, dir_c, NULL), GPUIO_ERROR_NOT_FOUND);
+    
+    /* The chain is checked before anything is written into the tensors */
+    for (size_t i = 0; i < frozen_size; i++) ASSERT_EQ(frozen[i], 7);
+    for (size_t i = 0; i < trained_size; i++) ASSERT_EQ(trained[i], 7);
+    
+    gpuio_ai_checkpoint_unregister_tensor(g_ai_ctx, "frozen");
+    gpuio_ai_checkpoint_unregister_tensor(g_ai_ctx, "trained");
+    free(frozen);
+    free(trained);
+    remove_dir(dir_b);
+    remove_dir(dir_c);
+    remove_dir(base);
+}
+
+TEST(checkpoint_lazy_restore) {
+    char base[] = "/tmp/gpuio_ckpt_XXXXXX";
+    ASSERT_NOT_NULL(mkdtemp(base));
+    char dir_a[512], dir_b[512];
+    snprintf(dir_a, sizeof(dir_a), "%s/a", base);
+    snprintf(dir_b, sizeof(dir_b), "%s/b", base);
+    
+    enum { NUM_LAYERS = 6 };
+    size_t size = (1 << 20) + 4096;
+    uint8_t* layers[NUM_LAYERS];
+    char names[NUM_LAYERS][32];
+    
+    for (int l = 0; l < NUM_LAYERS; l++) {
+        layers[l] = malloc(size);
+        ASSERT_NOT_NULL(layers[l]);
+        memset(layers[l], l + 1, size);
+        snprintf(names[l], sizeof(names[l]), "layer%d", l);
+        ASSERT_EQ(gpuio_ai_checkpoint_register_tensor(g_ai_ctx, names[l],
+                                                      layers[l], size),
+                  GPUIO_SUCCESS);
+    }
+    
+    gpuio_checkpoint_config_t config = { .num_shards = 3 };
+    ASSERT_EQ(gpuio_ai_checkpoint_configure(g_ai_ctx, &config), GPUIO_SUCCESS);
+    ASSERT_EQ(gpuio_ai_checkpoint_save(g_ai_ctx, dir_a, false, NULL), GPUIO_SUCCESS);
+    
+    /* Last layer is fine-tuned, so the restore spans the chain b -> a */
+    memset(layers[NUM_LAYERS - 1], 0x77, size);
+    ASSERT_EQ(gpuio_ai_checkpoint_save_incremental(g_ai_ctx, dir_b, dir_a, false, NULL),
+              GPUIO_SUCCESS);
+    
+    for (int l = 0; l < NUM_LAYERS; l++) memset(layers[l], 0, size);
+    
+    ASSERT_EQ(gpuio_ai_checkpoint_load_lazy(g_ai_ctx, dir_b), GPUIO_SUCCESS);
+    
+    /* First touch of the last layer must not wait for the others */
+    ASSERT_EQ(gpuio_ai_checkpoint_acquire(g_ai_ctx, names[NUM_LAYERS - 1]),
+              GPUIO_SUCCESS);
+    ASSERT_EQ(layers[NUM_LAYERS - 1][0], 0x77);
+    ASSERT_EQ(layers[NUM_LAYERS - 1][size - 1], 0x77);
+    ASSERT_EQ(gpuio_ai_checkpoint_acquire(g_ai_ctx, "no.such.tensor"),
+              GPUIO_ERROR_NOT_FOUND);
+    
+    ASSERT_EQ(gpuio_ai_checkpoint_wait(g_ai_ctx, -1), GPUIO_SUCCESS);
+    for (int l = 0; l < NUM_LAYERS - 1; l++) {
+        ASSERT_EQ(layers[l][0], l + 1);
+        ASSERT_EQ(layers[l][size - 1], l + 1);
+    }
+    
+    gpuio_checkpoint_stats_t stats;
+    ASSERT_EQ(gpuio_ai_checkpoint_get_stats(g_ai_ctx, &stats), GPUIO_SUCCESS);
+    ASSERT(stats.last_restore_ready_us <= stats.last_restore_time_us);
+    ASSERT_EQ(stats.last_load_bytes, (uint64_t)NUM_LAYERS * size);
+    
+    /* The reaped restore still answers for its tensors, and only those */
+    ASSERT_EQ(gpuio_ai_checkpoint_acquire(g_ai_ctx, names[0]), GPUIO_SUCCESS);
+    ASSERT_EQ(gpuio_ai_checkpoint_acquire(g_ai_ctx, "no.such.tensor"),
+              GPUIO_ERROR_NOT_FOUND);
+    
+    /* Corrupt the start of every shard in the parent */
+    DIR* dir = opendir(dir_a);
+    ASSERT_NOT_NULL(dir);
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strncmp(ent->d_name, "shard_", 6) != 0) continue;
+        char shard[1024];
+        snprintf(shard, sizeof(shard), "%s/%s", dir_a, ent->d_name);
+        int fd = open(shard, O_WRONLY);
+        ASSERT(fd >= 0);
+        uint8_t bad = 0;
+        ASSERT_EQ(pwrite(fd, &bad, 1, 1234), 1);
+        close(fd);
+    }
+    closedir(dir);
+    
+    /* Per-tensor results outlive the restore that produced them */
+    ASSERT_EQ(gpuio_ai_checkpoint_load_lazy(g_ai_ctx, dir_b), GPUIO_SUCCESS);
+    ASSERT_EQ(gpuio_ai_checkpoint_wait(g_ai_ctx, -1), GPUIO_ERROR_IO);
+    int failed = 0;
+    for (int l = 0; l < NUM_LAYERS; l++) {
+        gpuio_error_t err = gpuio_ai_checkpoint_acquire(g_ai_ctx, names[l]);
+        ASSERT(err == GPUIO_SUCCESS || err == GPUIO_ERROR_IO);
+        if (err != GPUIO_SUCCESS) failed++;
+    }
+    ASSERT(failed > 0);
+    ASSERT_EQ(gpuio_ai_checkpoint_acquire(g_ai_ctx, names[NUM_LAYERS - 1]),
+              GPUIO_SUCCESS);
+    
+    /* Missing ancestors are reported before the call returns */
+    remove_dir(dir_a);
+    ASSERT_EQ(gpuio_ai_checkpoint_load_lazy(g_ai_ctx, dir_b), GPUIO_ERROR_NOT_FOUND);
+    
+    for (int l = 0; l < NUM_LAYERS; l++) {
+        gpuio_ai_checkpoint_unregister_tensor(g_ai_ctx, names[l]);
+        free(layers[l]);
+    }
+    remove_dir(dir_b);
+    remove_dir(base);
+}
+
+/* ============================================================================
+ * Data Loader Tests
+ * ============================================================================ */
+
+#define DL_SHARDS 5
+#define DL_PER_SHARD 200
+#define DL_RECORDS (DL_SHARDS * DL_PER_SHARD)
+
+/*
+ * Shard s holds records s*DL_PER_SHARD .. +DL_PER_SHARD-1. A record starts
+ * with its id; length-prefixed records vary in size and one exceeds the
+ * loader's read size.
+ */
+static int write_dl_shards(const char* dir, size_t record_size,
+                           char paths[DL_SHARDS][512]) {
+    uint8_t buf[4096];
+    
+    for (int s = 0; s < DL_SHARDS; s++) {
+        snprintf(paths[s], 512, "%s/shard_%d.rec", dir, s);
+        FILE* f = fopen(paths[s], "wb");
+        if (!f) return -1;
+        
+        for (int i = 0; i < DL_PER_SHARD; i++) {
+            uint32_t id = (uint32_t)(s * DL_PER_SHARD + i);
+            uint32_t len = record_size ? (uint32_t)record_size :
+                           (id == 7 ? 3000 : 8 + id % 37);
+            memset(buf, (int)(id & 0xff), len);
+            memcpy(buf, &id, sizeof(id));
+            if (!record_size) fwrite(&len, sizeof(len), 1, f);
+            fwrite(buf, 1, len, f);
+        }
+        fclose(f);
+    }
+    
+    return 0;
+}
+
+/* Drain a loader, recording ids in delivery order; returns record count */
+static int drain_dl(gpuio_data_loader_t loader, uint32_t* ids, int max_ids,
+                    uint64_t* epochs) {
+    gpuio_data_batch_t batch;
+    int n = 0;
+    
+    while (gpuio_data_loader_next(loader, &batch) == GPUIO_SUCCESS) {
+        for (int i = 0; i < batch.num_inputs && n < max_ids; i++) {
+            memcpy(&ids[n], batch.inputs[i], sizeof(uint32_t));
+            if (epochs) epochs[n] = batch.epoch;
+            n++;
+        }
+        gpuio_data_loader_release(loader, &batch);
+    }
+    
+    return n;
+}
+
+TEST(data_loader_epoch_coverage) {
+    char dir[] = "/tmp/gpuio_dl_XXXXXX";
+    ASSERT_NOT_NULL(mkdtemp(dir));
+    char paths[DL_SHARDS][512];
+    ASSERT_EQ(write_dl_shards(dir, 0, paths), 0);
+    
+    const char* shard_paths[DL_SHARDS];
+    for (int s = 0; s < DL_SHARDS; s++) shard_paths[s] = paths[s];
+    
+    gpuio_data_loader_config_t config = {
+        .shard_paths = shard_paths,
+        .num_shards = DL_SHARDS,
+        .batch_size = 16,
+        .num_readers = 3,
+        .prefetch_batches = 2,
+        .shuffle_buffer = 64,
+        .read_size = 1024,
+        .seed = 42,
+        .num_epochs = 2,
+    };
+    gpuio_data_loader_t loader = NULL;
+    ASSERT_EQ(gpuio_data_loader_create(g_ai_ctx, &config, &loader), GPUIO_SUCCESS);
+    
+    static uint32_t ids[2 * DL_RECORDS];
+    static uint64_t epochs[2 * DL_RECORDS];
+    ASSERT_EQ(drain_dl(loader, ids, 2 * DL_RECORDS, epochs), 2 * DL_RECORDS);
+    
+    /* Every record exactly once per epoch, and the epochs differ in order */
+    for (int e = 0; e < 2; e++) {
+        static uint8_t seen[DL_RECORDS];
+        memset(seen, 0, sizeof(seen));
+        for (int i = 0; i < DL_RECORDS; i++) {
+            uint32_t id = ids[e * DL_RECORDS + i];
+            ASSERT_EQ(epochs[e * DL_RECORDS + i], (uint64_t)e);
+            ASSERT(id < DL_RECORDS);
+            ASSERT_EQ(seen[id], 0);
+            seen[id] = 1;
+        }
+    }
+    ASSERT(memcmp(ids, ids + DL_RECORDS, DL_RECORDS * sizeof(uint32_t)) != 0);
+    
+    gpuio_data_batch_t batch;
+    ASSERT_EQ(gpuio_data_loader_next(loader, &batch), GPUIO_ERROR_NOT_FOUND);
+    
+    gpuio_data_loader_stats_t stats;
+    ASSERT_EQ(gpuio_data_loader_get_stats(loader, &stats), GPUIO_SUCCESS);
+    ASSERT_EQ(stats.records, (uint64_t)(2 * DL_RECORDS));
+    ASSERT_EQ(stats.batches, (uint64_t)(2 * ((DL_RECORDS + 15) / 16)));
+    ASSERT(stats.stall_us_max >= stats.last_stall_us);
+    ASSERT(stats.avg_stall_us <= (double)stats.stall_us_max);
+    
+    ASSERT_EQ(gpuio_data_loader_destroy(loader), GPUIO_SUCCESS);
+    
+    /* A truncated shard surfaces as an IO error */
+    ASSERT_EQ(truncate(paths[2], 10), 0);
+    config.num_epochs = 1;
+    ASSERT_EQ(gpuio_data_loader_create(g_ai_ctx, &config, &loader), GPUIO_SUCCESS);
+    gpuio_error_t err;
+    while ((err = gpuio_data_loader_next(loader, &batch)) == GPUIO_SUCCESS) {
+        gpuio_data_loader_release(loader, &batch);
+    }
+    ASSERT_EQ(err, GPUIO_ERROR_IO);
+    ASSERT_EQ(gpuio_data_loader_destroy(loader), GPUIO_SUCCESS);
+    
+    remove_dir(dir);
+}
+
+TEST(data_loader_deterministic) {
+    char dir[] = "/tmp/gpuio_dl_XXXXXX";
+    ASSERT_NOT_NULL(mkdtemp(dir));
+    char paths[DL_SHARDS][512];
+    ASSERT_EQ(write_dl_shards(dir, 24, paths), 0);
+    
+    const char* shard_paths[DL_SHARDS];
+    for (int s = 0; s < DL_SHARDS; s++) shard_paths[s] = paths[s];
+    
+    gpuio_data_loader_config_t config = {
+        .shard_paths = shard_paths,
+        .num_shards = DL_SHARDS,
+        .record_size = 24,
+        .batch_size = 32,
+        .num_readers = 4,
+        .shuffle_buffer = 128,
+        .read_size = 240,
+        .seed = 7,
+        .num_epochs = 1,
+    };
+    
+    static uint32_t runs[3][DL_RECORDS];
+    uint64_t seeds[3] = { 7, 7, 8 };
+    for (int r = 0; r < 3; r++) {
+        gpuio_data_loader_t loader = NULL;
+        config.seed = seeds[r];
+        ASSERT_EQ(gpuio_data_loader_create(g_ai_ctx, &config, &loader), GPUIO_SUCCESS);
+        ASSERT_EQ(drain_dl(loader, runs[r], DL_RECORDS, NULL), DL_RECORDS);
+        ASSERT_EQ(gpuio_data_loader_destroy(loader), GPUIO_SUCCESS);
+    }
+    
+    ASSERT(memcmp(runs[0], runs[1], sizeof(runs[0])) == 0);
+    ASSERT(memcmp(runs[0], runs[2], sizeof(runs[0])) != 0);
+    
+    remove_dir(dir);
+}
+
+/* ============================================================================
+ * Training Step Tests
+ * ============================================================================ */
+
+static void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+typedef struct {
+    uint64_t value;
+    size_t size;
+    const void* ptr;
+    int limit;
+    uint64_t expected;
+    int mismatches;
+    int records;
+} train_source_t;
+
+/* Simulated storage read: 15ms per step */
+static gpuio_error_t slow_source(void* user_data, uint64_t step,
+                                 gpuio_training_inputs_t* inputs) {
+    train_source_t* src = (train_source_t*)user_data;
+    if (step >= (uint64_t)src->limit) return GPUIO_ERROR_NOT_FOUND;
+    
+    sleep_ms(15);
+    src->value = step;
+    src->size = sizeof(src->value);
+    src->ptr = &src->value;
+    inputs->inputs = &src->ptr;
+    inputs->input_sizes = &src->size;
+    inputs->num_inputs = 1;
+    return GPUIO_SUCCESS;
+}
+
+/* Simulated forward/backward: 25ms per step */
+static gpuio_error_t slow_compute(void* user_data, const gpuio_training_inputs_t* staged,
+                                  float* loss) {
+    train_source_t* src = (train_source_t*)user_data;
+    uint64_t step;
+    memcpy(&step, staged->inputs[0], sizeof(step));
+    if (step != src->expected++) src->mismatches++;
+    *loss = (float)step;
+    sleep_ms(25);
+    return GPUIO_SUCCESS;
+}
+
+static gpuio_error_t count_compute(void* user_data, const gpuio_training_inputs_t* staged,
+                                   float* loss) {
+    train_source_t* src = (train_source_t*)user_data;
+    src->records += staged->num_inputs;
+    *loss = 0.0f;
+    return GPUIO_SUCCESS;
+}
+
+TEST(training_step_overlaps_prefetch) {
+    train_source_t src = { .limit = 8 };
+    gpuio_training_params_t params = {
+        .source = slow_source,
+        .source_data = &src,
+        .num_buffers = 2,
+        .compute = slow_compute,
+        .compute_data = &src,
+    };
+    gpuio_training_result_t result;
+    uint64_t wait_us = 0, fetch_us = 0;
+    
+    for (int i = 0; i < 8; i++) {
+        ASSERT_EQ(gpuio_ai_training_step(g_ai_ctx, &params, &result), GPUIO_SUCCESS);
+        ASSERT_EQ(result.loss, (float)i);
+        ASSERT(result.fetch_time_us >= 15000);
+        if (i > 0) {
+            wait_us += result.io_wait_us;
+            fetch_us += result.fetch_time_us;
+        }
+    }
+    ASSERT_EQ(src.mismatches, 0);
+    
+    /* Fetches after the first hide behind the previous step's compute */
+    ASSERT(wait_us * 2 < fetch_us);
+    
+    ASSERT_EQ(gpuio_ai_training_step(g_ai_ctx, &params, &result), GPUIO_ERROR_NOT_FOUND);
+    ASSERT_EQ(result.status, GPUIO_ERROR_NOT_FOUND);
+    ASSERT_EQ(gpuio_ai_training_step(g_ai_ctx, &params, &result), GPUIO_ERROR_NOT_FOUND);
+    ASSERT_EQ(gpuio_ai_training_reset(g_ai_ctx), GPUIO_SUCCESS);
+    
+    /* Without a source, inputs and labels are staged in place */
+    uint64_t value = 41;
+    const void* inputs[] = { &value };
+    size_t sizes[] = { sizeof(value) };
+    float labels[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+    gpuio_training_params_t direct = {
+        .inputs = inputs,
+        .input_sizes = sizes,
+        .num_inputs = 1,
+        .labels = labels,
+        .labels_size = sizeof(labels),
+        .compute = slow_compute,
+        .compute_data = &src,
+    };
+    src.expected = 41;
+    ASSERT_EQ(gpuio_ai_training_step(g_ai_ctx, &direct, &result), GPUIO_SUCCESS);
+    ASSERT_EQ(src.mismatches, 0);
+    ASSERT_EQ(result.overlap, 0.0);
+    
+    gpuio_ai_training_reset(g_ai_ctx);
+}
+
+TEST(training_step_from_loader) {
+    char dir[] = "/tmp/gpuio_dl_XXXXXX";
+    ASSERT_NOT_NULL(mkdtemp(dir));
+    char paths[DL_SHARDS][512];
+    ASSERT_EQ(write_dl_shards(dir, 0, paths), 0);
+    
+    const char* shard_paths[DL_SHARDS];
+    for (int s = 0; s < DL_SHARDS; s++) shard_paths[s] = paths[s];
+    
+    gpuio_data_loader_config_t config = {
+        .shard_paths = shard_paths,
+        .num_shards = DL_SHARDS,
+        .batch_size = 50,
+        .shuffle_buffer = 100,
+        .seed = 3,
+        .num_epochs = 1,
+    };
+    gpuio_data_loader_t loader = NULL;
+    ASSERT_EQ(gpuio_data_loader_create(g_ai_ctx, &config, &loader), GPUIO_SUCCESS);
+    
+    /* The loader wins over a source callback without rebinding each step */
+    train_source_t counter = { 0 };
+    gpuio_training_params_t params = {
+        .loader = loader,
+        .source = slow_source,
+        .source_data = &counter,
+        .num_buffers = 3,
+        .compute = count_compute,
+        .compute_data = &counter,
+    };
+    gpuio_training_result_t result;
+    int steps = 0;
+    while (gpuio_ai_training_step(g_ai_ctx, &params, &result) == GPUIO_SUCCESS) {
+        ASSERT_EQ(result.step, (uint64_t)steps);
+        steps++;
+    }
+    ASSERT_EQ(result.status, GPUIO_ERROR_NOT_FOUND);
+    ASSERT_EQ(steps, DL_RECORDS / 50);
+    ASSERT_EQ(counter.records, DL_RECORDS);
+    
+    ASSERT_EQ(gpuio_ai_training_reset(g_ai_ctx), GPUIO_SUCCESS);
+    ASSERT_EQ(gpuio_data_loader_destroy(loader), GPUIO_SUCCESS);
+    remove_dir(dir);
+}
+
 /* ============================================================================
  * Test Runner
  * ============================================================================ */
@@ -653,6 +1424,25 @@ int main(int argc, char* argv[]) {
     print_header("Compression Tests");
     RUN_TEST(codec_create_destroy);
     RUN_TEST(codec_types);
+    RUN_TEST(codec_lz4_roundtrip);
+    
+    /* Checkpoint Tests */
+    print_header("Checkpoint Tests");
+    RUN_TEST(checkpoint_save_load);
+    RUN_TEST(checkpoint_detects_corruption);
+    RUN_TEST(checkpoint_async_save);
+    RUN_TEST(checkpoint_incremental);
+    RUN_TEST(checkpoint_lazy_restore);
+    
+    /* Data Loader Tests */
+    print_header("Data Loader Tests");
+    RUN_TEST(data_loader_epoch_coverage);
+    RUN_TEST(data_loader_deterministic);
+    
+    /* Training Step Tests */
+    print_header("Training Step Tests");
+    RUN_TEST(training_step_overlaps_prefetch);
+    RUN_TEST(training_step_from_loader);
     
     /* Teardown */
     printf("\nTearing down test environment...\n");
@@ -0,0 +1,1256 @@
+/**
+ * @file test_localio.c
+ * @brief Unit tests for the localio module
+ * @version 1.0.0
+ *
+ * Exercises the localio IO paths against scratch files. GDS tests load the
+ * host-memory cuFile stand-in through GPUIO_CUFILE_LIBRARY, so they run
+ * without the GPUDirect Storage stack.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <gpuio/gpuio.h>
+#include "localio_internal.h"
+#include "cufile_compat.h"
+
+/* Test statistics */
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/* Test macros */
+#define TEST(name) static void test_##name(void)
+#define RUN_TEST(name) do { \
+    int failed_before = tests_failed; \
+    printf("  Running %s... ", #name); \
+    fflush(stdout); \
+    tests_run++; \
+    test_##name(); \
+    if (tests_failed == failed_before) { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } \
+} while(0)
+
+#define ASSERT(expr) do { \
+    if (!(expr)) { \
+        printf("FAILED\n    Assertion failed: %s at line %d\n", #expr, __LINE__); \
+        tests_failed++; \
+        return; \
+    } \
+} while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_NOT_NULL(ptr) ASSERT((ptr) != NULL)
+
+#define SCRATCH_SIZE  (1 << 20)
+
+/* Scratch directory holding "data" (SCRATCH_SIZE bytes of pattern) */
+static char g_dir[] = "/tmp/gpuio_test_localio.XXXXXX";
+static char g_data_path[64];
+static char g_out_path[64];
+
+static char pattern_byte(uint64_t offset) {
+    return (char)(offset * 7 + offset / 4096);
+}
+
+/* ============================================================================
+ * Setup/Teardown
+ * ============================================================================ */
+
+static int setup(void) {
+    if (!mkdtemp(g_dir)) return -1;
+    snprintf(g_data_path, sizeof(g_data_path), "%s/data", g_dir);
+    snprintf(g_out_path, sizeof(g_out_path), "%s/out", g_dir);
+    
+    char* data = malloc(SCRATCH_SIZE);
+    if (!data) return -1;
+    for (uint64_t i = 0; i < SCRATCH_SIZE; i++) data[i] = pattern_byte(i);
+    
+    int fd = open(g_data_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ssize_t n = (fd >= 0) ? write(fd, data, SCRATCH_SIZE) : -1;
+    free(data);
+    if (fd >= 0) close(fd);
+    
+    return (n == SCRATCH_SIZE) ? 0 : -1;
+}
+
+static void teardown(void) {
+    unlink(g_data_path);
+    unlink(g_out_path);
+    rmdir(g_dir);
+}
+
+/* ============================================================================
+ * Queue Tests
+ * ============================================================================ */
+
+static localio_context_t g_local_ctx;
+static localio_file_t* g_file = NULL;
+
+typedef struct completion {
+    int calls;
+    gpuio_error_t status;
+} completion_t;
+
+static void on_complete(gpuio_request_t request, gpuio_error_t status,
+                        void* user_data) {
+    (void)request;
+    completion_t* done = user_data;
+    __atomic_store_n(&done->status, status, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&done->calls, 1, __ATOMIC_RELAXED);
+}
+
+static void make_read(localio_request_t* req, void* buf, uint64_t offset,
+                      size_t count, completion_t* done) {
+    memset(req, 0, sizeof(*req));
+    req->op = GPUIO_REQ_READ;
+    req->buf = buf;
+    req->count = count;
+    req->offset = offset;
+    req->file = g_file;
+    req->callback = on_complete;
+    req->user_data = done;
+}
+
+/* Queue with no watermarks and a budget no request reaches */
+static int queue_open(localio_queue_t* queue, size_t merge_gap,
+                      size_t max_merge) {
+    if (localio_queue_init(queue) != 0) return -1;
+    queue->merge_gap = merge_gap;
+    queue->max_merge = max_merge;
+    queue->latency_budget_us = 60 * 1000000ULL;
+    return localio_queue_set_limits(queue, 0, 0, 0, 0, LOCALIO_ADMIT_BLOCK);
+}
+
+static int buf_matches(const char* buf, uint64_t offset, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (buf[i] != pattern_byte(offset + i)) return 0;
+    }
+    return 1;
+}
+
+TEST(queue_merge_gap) {
+    localio_queue_t queue;
+    ASSERT_EQ(queue_open(&queue, 4096, 1 << 20), 0);
+    
+    /* B starts exactly merge_gap past A; C is one byte further out */
+    static char buf[3][1000];
+    const uint64_t offsets[3] = { 0, 1000 + 4096, 6096 + 4097 };
+    localio_request_t reqs[3];
+    completion_t done = { 0, GPUIO_SUCCESS };
+    
+    for (int i = 2; i >= 0; i--) {
+        make_read(&reqs[i], buf[i], offsets[i], 1000, &done);
+        ASSERT_EQ(localio_queue_submit(&queue, &reqs[i]), 0);
+    }
+    ASSERT_EQ(localio_queue_process(&queue), 3);
+    ASSERT_EQ(done.calls, 3);
+    ASSERT_EQ(done.status, GPUIO_SUCCESS);
+    
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(reqs[i].result, 1000);
+        ASSERT(buf_matches(buf[i], offsets[i], 1000));
+    }
+    
+    localio_queue_stats_t stats;
+    ASSERT_EQ(localio_queue_get_stats(&queue, &stats), 0);
+    ASSERT_EQ(stats.ios_issued, 2);
+    ASSERT_EQ(stats.requests_merged, 2);
+    ASSERT_EQ(stats.requests_completed, 3);
+    ASSERT_EQ(stats.deadline_dispatches, 0);
+    
+    localio_queue_cleanup(&queue);
+}
+
+TEST(queue_max_merge) {
+    localio_queue_t queue;
+    ASSERT_EQ(queue_open(&queue, 4096, 8192), 0);
+    
+    /* Contiguous 3000-byte reads: a third would stretch a run past 8192,
+     * and the lone 10000-byte read can't join anything */
+    static char buf[5][10000];
+    const uint64_t offsets[5] = { 0, 3000, 6000, 9000, 12000 };
+    const size_t counts[5] = { 3000, 3000, 3000, 3000, 10000 };
+    localio_request_t reqs[5];
+    completion_t done = { 0, GPUIO_SUCCESS };
+    
+    for (int i = 0; i < 5; i++) {
+        make_read(&reqs[i], buf[i], offsets[i], counts[i], &done);
+        ASSERT_EQ(localio_queue_submit(&queue, &reqs[i]), 0);
+    }
+    ASSERT_EQ(localio_queue_process(&queue), 5);
+    ASSERT_EQ(done.calls, 5);
+    
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ(reqs[i].result, counts[i]);
+        ASSERT(buf_matches(buf[i], offsets[i], counts[i]));
+    }
+    
+    localio_queue_stats_t stats;
+    ASSERT_EQ(localio_queue_get_stats(&queue, &stats), 0);
+    ASSERT_EQ(stats.ios_issued, 3);
+    ASSERT_EQ(stats.requests_merged, 4);
+    
+    localio_queue_cleanup(&queue);
+}
+
+TEST(queue_latency_budget) {
+    localio_queue_t queue;
+    ASSERT_EQ(queue_open(&queue, 4096, 1 << 20), 0);
+    queue.latency_budget_us = 20000;
+    
+    /* A and B age past the budget and go out unmerged; C is fresh */
+    static char buf[3][512];
+    localio_request_t reqs[3];
+    completion_t done = { 0, GPUIO_SUCCESS };
+    for (int i = 0; i < 3; i++) {
+        make_read(&reqs[i], buf[i], (uint64_t)i * 512, 512, &done);
+    }
+    
+    ASSERT_EQ(localio_queue_submit(&queue, &reqs[0]), 0);
+    ASSERT_EQ(localio_queue_submit(&queue, &reqs[1]), 0);
+    usleep(40000);
+    ASSERT_EQ(localio_queue_submit(&queue, &reqs[2]), 0);
+    ASSERT_EQ(localio_queue_process(&queue), 3);
+    ASSERT_EQ(done.calls, 3);
+    for (int i = 0; i < 3; i++) {
+        ASSERT(buf_matches(buf[i], (uint64_t)i * 512, 512));
+    }
+    
+    localio_queue_stats_t stats;
+    ASSERT_EQ(localio_queue_get_stats(&queue, &stats), 0);
+    ASSERT_EQ(stats.deadline_dispatches, 2);
+    ASSERT_EQ(stats.ios_issued, 3);
+    ASSERT_EQ(stats.requests_merged, 0);
+    ASSERT(stats.max_queue_delay_us >= 40000);
+    
+    /* A zero budget flushes everything unmerged */
+    queue.latency_budget_us = 0;
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(localio_queue_submit(&queue, &reqs[i]), 0);
+    }
+    ASSERT_EQ(localio_queue_process(&queue), 3);
+    ASSERT_EQ(localio_queue_get_stats(&queue, &stats), 0);
+    ASSERT_EQ(stats.deadline_dispatches, 5);
+    ASSERT_EQ(stats.ios_issued, 6);
+    
+    localio_queue_cleanup(&queue);
+}
+
+TEST(queue_failed_merge_delay) {
+    /* Reads of a directory fail, so the merged read falls back to single
+     * reads; each request's queue delay must still count once */
+    localio_file_t* dir = NULL;
+    ASSERT_EQ(localio_file_open(&g_local_ctx, g_dir, GPUIO_MEM_READ, &dir), 0);
+    
+    localio_queue_t queue;
+    ASSERT_EQ(queue_open(&queue, 4096, 1 << 20), 0);
+    
+    static char buf[4][512];
+    localio_request_t reqs[4];
+    completion_t done = { 0, GPUIO_SUCCESS };
+    for (int i = 0; i < 4; i++) {
+        make_read(&reqs[i], buf[i], (uint64_t)i * 512, 512, &done);
+        reqs[i].file = dir;
+        ASSERT_EQ(localio_queue_submit(&queue, &reqs[i]), 0);
+    }
+    usleep(20000);
+    ASSERT_EQ(localio_queue_process(&queue), 4);
+    ASSERT_EQ(done.calls, 4);
+    ASSERT_EQ(done.status, GPUIO_ERROR_IO);
+    
+    localio_queue_stats_t stats;
+    ASSERT_EQ(localio_queue_get_stats(&queue, &stats), 0);
+    ASSERT_EQ(stats.requests_merged, 0);
+    ASSERT(stats.max_queue_delay_us >= 20000);
+    ASSERT(stats.avg_queue_delay_us <= (double)stats.max_queue_delay_us);
+    
+    localio_queue_cleanup(&queue);
+    localio_file_close(dir);
+}
+
+#define PROCESS_THREADS   4
+#define PROCESS_REQUESTS  2048
+
+typedef struct process_arg {
+    localio_queue_t* queue;
+    int id;
+    int bad;
+} process_arg_t;
+
+/* Submit clustered reads and process them, racing the other threads */
+static void* process_thread(void* p) {
+    process_arg_t* arg = p;
+    const size_t count = 4000;
+    char* bufs = malloc(PROCESS_REQUESTS * count);
+    localio_request_t* reqs = calloc(PROCESS_REQUESTS, sizeof(localio_request_t));
+    completion_t done = { 0, GPUIO_SUCCESS };
+    if (!bufs || !reqs) {
+        arg->bad = 1;
+        goto out;
+    }
+    
+    for (int i = 0; i < PROCESS_REQUESTS; i++) {
+        uint64_t offset = ((uint64_t)arg->id * 262144 + (uint64_t)i * 4096) %
+                          (SCRATCH_SIZE - count);
+        make_read(&reqs[i], bufs + (size_t)i * count, offset, count, &done);
+        if (localio_queue_submit(arg->queue, &reqs[i]) != 0) arg->bad = 1;
+        if (i % 16 == 15) localio_queue_process(arg->queue);
+    }
+    
+    /* Other threads may be finishing our requests; wait for all of them */
+    while (__atomic_load_n(&done.calls, __ATOMIC_RELAXED) < PROCESS_REQUESTS) {
+        localio_queue_process(arg->queue);
+        usleep(100);
+    }
+    
+    for (int i = 0; i < PROCESS_REQUESTS; i++) {
+        if (reqs[i].result != count ||
+            !buf_matches(reqs[i].buf, reqs[i].offset, count)) {
+            arg->bad = 1;
+        }
+    }
+
+out:
+    free(reqs);
+    free(bufs);
+    return NULL;
+}
+
+TEST(queue_concurrent_process) {
+    localio_queue_t queue;
+    ASSERT_EQ(queue_open(&queue, 4096, 1 << 20), 0);
+    
+    pthread_t threads[PROCESS_THREADS];
+    process_arg_t args[PROCESS_THREADS];
+    for (int i = 0; i < PROCESS_THREADS; i++) {
+        args[i].queue = &queue;
+        args[i].id = i;
+        args[i].bad = 0;
+        ASSERT_EQ(pthread_create(&threads[i], NULL, process_thread, &args[i]), 0);
+    }
+    for (int i = 0; i < PROCESS_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < PROCESS_THREADS; i++) ASSERT_EQ(args[i].bad, 0);
+    
+    localio_queue_stats_t stats;
+    ASSERT_EQ(localio_queue_get_stats(&queue, &stats), 0);
+    ASSERT_EQ(stats.requests_completed, PROCESS_THREADS * PROCESS_REQUESTS);
+    ASSERT_EQ(stats.depth, 0);
+    ASSERT_EQ(stats.pending_bytes, 0);
+    ASSERT(stats.requests_merged > 0);
+    
+    localio_queue_cleanup(&queue);
+}
+
+/* ============================================================================
+ * Admission Control Tests
+ * ============================================================================ */
+
+#define CHAIN_MAX 4
+
+/* Completion that acts from inside the i-th callback it receives */
+typedef struct chain {
+    localio_queue_t* queue;
+    int calls;
+    localio_request_t* nested[CHAIN_MAX];       /* Submitted, then processed */
+    localio_request_t* follow_up[CHAIN_MAX];    /* Submitted last */
+    int ret[CHAIN_MAX];
+} chain_t;
+
+static void on_complete_chain(gpuio_request_t request, gpuio_error_t status,
+                              void* user_data) {
+    (void)request;
+    (void)status;
+    chain_t* chain = user_data;
+    int i = chain->calls++;
+    if (i >= CHAIN_MAX) return;
+    
+    if (chain->nested[i]) {
+        localio_queue_submit(chain->queue, chain->nested[i]);
+        localio_queue_process(chain->queue);
+    }
+    if (chain->follow_up[i]) {
+        chain->ret[i] = localio_queue_submit(chain->queue, chain->follow_up[i]);
+    }
+}
+
+/* Reads 8 KiB apart so each is dispatched alone, in offset order */
+static void make_chain_read(localio_request_t* req, void* buf, int index,
+                            size_t count, chain_t* chain) {
+    make_read(req, buf, (uint64_t)index * 8192, count, NULL);
+    req->callback = on_complete_chain;
+    req->user_data = chain;
+}
+
+TEST(queue_default_limits) {
+    localio_queue_t queue;
+    ASSERT_EQ(localio_queue_init(&queue), 0);
+    ASSERT_EQ(queue.admit_policy, LOCALIO_ADMIT_SHED_PREFETCH);
+    ASSERT_EQ(queue.high_watermark, LOCALIO_QUEUE_DEFAULT_HIGH_DEPTH);
+    ASSERT_EQ(queue.low_watermark, LOCALIO_QUEUE_DEFAULT_LOW_DEPTH);
+    
+    ASSERT_EQ(localio_queue_set_limits(&queue, 2, 4, 0, 0, LOCALIO_ADMIT_BLOCK), -1);
+    ASSERT_EQ(localio_queue_set_limits(&queue, 4, 2, 100, 200, LOCALIO_ADMIT_BLOCK), -1);
+    ASSERT_EQ(localio_queue_set_limits(&queue, -1, 0, 0, 0, LOCALIO_ADMIT_BLOCK), -1);
+    ASSERT_EQ(queue.admit_policy, LOCALIO_ADMIT_SHED_PREFETCH);
+    
+    localio_queue_cleanup(&queue);
+}
+
+TEST(queue_admit_reject) {
+    localio_queue_t queue;
+    ASSERT_EQ(queue_open(&queue, 0, 1 << 20), 0);
+    ASSERT_EQ(localio_queue_set_limits(&queue, 4, 2, 0, 0, LOCALIO_ADMIT_REJECT), 0);
+    
+    static char buf[7][512];
+    localio_request_t reqs[7];
+    chain_t chain;
+    memset(&chain, 0, sizeof(chain));
+    chain.queue = &queue;
+    completion_t done = { 0, GPUIO_SUCCESS };
+    
+    for (int i = 0; i < 4; i++) {
+        make_chain_read(&reqs[i], buf[i], i, 512, &chain);
+        ASSERT_EQ(localio_queue_submit(&queue, &reqs[i]), 0);
+    }
+    for (int i = 4; i < 7; i++) make_read(&reqs[i], buf[i], 0, 512, &done);
+    
+    localio_queue_stats_t stats;
+    ASSERT_EQ(localio_queue_get_stats(&queue, &stats), 0);
+    ASSERT_EQ(stats.depth, 4);
+    ASSERT_EQ(stats.pending_bytes, 4 * 512);
+    
+    /* At the high watermark */
+    ASSERT_EQ(localio_queue_submit(&queue, &reqs[4]), GPUIO_ERROR_BUSY);
+    
+    /* Still throttled at depth 3, open again at the low watermark */
+    chain.follow_up[0] = &reqs[5];
+    chain.follow_up[1] = &reqs[6];
+    ASSERT_EQ(localio_queue_process(&queue), 4);
+    ASSERT_EQ(chain.calls, 4);
+    ASSERT_EQ(chain.ret[0], GPUIO_ERROR_BUSY);
+    ASSERT_EQ(chain.ret[1], 0);
+    
+    ASSERT_EQ(localio_queue_process(&queue), 1);
+    ASSERT_EQ(done.calls, 1);
+    ASSERT_EQ(localio_queue_get_stats(&queue, &stats), 0);
+    ASSERT_EQ(stats.rejected, 2);
+    ASSERT_EQ(stats.shed, 0);
+    ASSERT_EQ(stats.blocked, 0);
+    ASSERT_EQ(stats.requests_completed, 5);
+    ASSERT_EQ(stats.depth, 0);
+    ASSERT_EQ(stats.pending_bytes, 0);
+    
+    localio_queue_cleanup(&queue);
+}
+
+TEST(queue_admit_shed_prefetch) {
+    localio_queue_t queue;
+    ASSERT_EQ(queue_open(&queue, 0, 1 << 20), 0);
+    ASSERT_EQ(localio_queue_set_limits(&queue, 4, 2, 0, 0,
+                                       LOCALIO_ADMIT_SHED_PREFETCH), 0);
+    
+    static char buf[6][512];
+    localio_request_t reqs[6];
+    completion_t normal = { 0, GPUIO_SUCCESS };
+    completion_t prefetch = { 0, GPUIO_SUCCESS };
+    
+    /* Two prefetches and two normal reads fill the queue */
+    for (int i = 0; i < 6; i++) {
+        bool is_prefetch = (i == 0 || i == 2 || i == 4);
+        make_read(&reqs[i], buf[i], (uint64_t)i * 8192, 512,
+                  is_prefetch ? &prefetch : &normal);
+        if (is_prefetch) reqs[i].priority = LOCALIO_PRIO_PREFETCH;
+    }
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(localio_queue_submit(&queue, &reqs[i]), 0);
+    }
+    
+    /* A new prefetch is turned away */
+    ASSERT_EQ(localio_queue_submit(&queue, &reqs[4]), GPUIO_ERROR_BUSY);
+    ASSERT_EQ(prefetch.calls, 0);
+    
+    /* A normal read cancels the queued prefetches and gets in */
+    ASSERT_EQ(localio_queue_submit(&queue, &reqs[5]), 0);
+    ASSERT_EQ(prefetch.calls, 2);
+    ASSERT_EQ(prefetch.status, GPUIO_ERROR_CANCELED);
+    
+    localio_queue_stats_t stats;
+    ASSERT_EQ(localio_queue_get_stats(&queue, &stats), 0);
+    ASSERT_EQ(stats.depth, 3);
+    ASSERT_EQ(stats.pending_bytes, 3 * 512);
+    ASSERT_EQ(stats.shed, 3);
+    ASSERT_EQ(stats.rejected, 0);
+    ASSERT_EQ(stats.blocked, 0);
+    
+    ASSERT_EQ(localio_queue_process(&queue), 3);
+    ASSERT_EQ(normal.calls, 3);
+    ASSERT_EQ(normal.status, GPUIO_SUCCESS);
+    ASSERT(buf_matches(buf[5], 5 * 8192, 512));
+    
+    localio_queue_cleanup(&queue);
+}
+
+typedef struct blocked_submit {
+    localio_queue_t* queue;
+    localio_request_t* req;
+    int ret;
+    int returned;
+} blocked_submit_t;
+
+static void* blocked_submit_thread(void* p) {
+    blocked_submit_t* arg = p;
+    arg->ret = localio_queue_submit(arg->queue, arg->req);
+    __atomic_store_n(&arg->returned, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+TEST(queue_admit_block) {
+    localio_queue_t queue;
+    ASSERT_EQ(queue_open(&queue, 0, 1 << 20), 0);
+    ASSERT_EQ(localio_queue_set_limits(&queue, 2, 1, 0, 0, LOCALIO_ADMIT_BLOCK), 0);
+    
+    static char buf[3][512];
+    localio_request_t reqs[3];
+    completion_t done = { 0, GPUIO_SUCCESS };
+    for (int i = 0; i < 3; i++) {
+        make_read(&reqs[i], buf[i], (uint64_t)i * 8192, 512, &done);
+    }
+    ASSERT_EQ(localio_queue_submit(&queue, &reqs[0]), 0);
+    ASSERT_EQ(localio_queue_submit(&queue, &reqs[1]), 0);
+    
+    /* The third submit waits until processing drains to the low watermark */
+    blocked_submit_t arg = { &queue, &reqs[2], -1, 0 };
+    pthread_t thread;
+    ASSERT_EQ(pthread_create(&thread, NULL, blocked_submit_thread, &arg), 0);
+    usleep(30000);
+    ASSERT_EQ(__atomic_load_n(&arg.returned, __ATOMIC_ACQUIRE), 0);
+    
+    ASSERT_EQ(localio_queue_process(&queue), 2);
+    pthread_join(thread, NULL);
+    ASSERT_EQ(arg.ret, 0);
+    ASSERT_EQ(localio_queue_process(&queue), 1);
+    ASSERT_EQ(done.calls, 3);
+    
+    localio_queue_stats_t stats;
+    ASSERT_EQ(localio_queue_get_stats(&queue, &stats), 0);
+    ASSERT_EQ(stats.blocked, 1);
+    ASSERT(stats.blocked_time_us >= 20000);
+    ASSERT_EQ(stats.rejected, 0);
+    ASSERT_EQ(stats.requests_completed, 3);
+    ASSERT(stats.avg_queue_delay_us > 0.0);
+    ASSERT(stats.max_queue_delay_us >= 20000);
+    
+    localio_queue_cleanup(&queue);
+}
+
+TEST(queue_cleanup_wakes_blocked) {
+    localio_queue_t queue;
+    ASSERT_EQ(queue_open(&queue, 0, 1 << 20), 0);
+    ASSERT_EQ(localio_queue_set_limits(&queue, 2, 1, 0, 0, LOCALIO_ADMIT_BLOCK), 0);
+    
+    static char buf[4][512];
+    localio_request_t reqs[4];
+    completion_t queued = { 0, GPUIO_SUCCESS };
+    completion_t blocked = { 0, GPUIO_SUCCESS };
+    for (int i = 0; i < 4; i++) {
+        make_read(&reqs[i], buf[i], (uint64_t)i * 8192, 512,
+                  i < 2 ? &queued : &blocked);
+    }
+    ASSERT_EQ(localio_queue_submit(&queue, &reqs[0]), 0);
+    ASSERT_EQ(localio_queue_submit(&queue, &reqs[1]), 0);
+    
+    blocked_submit_t args[2] = {
+        { &queue, &reqs[2], 0, 0 },
+        { &queue, &reqs[3], 0, 0 },
+    };
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++) {
+        ASSERT_EQ(pthread_create(&threads[i], NULL, blocked_submit_thread, &args[i]), 0);
+    }
+    
+    /* Both must be waiting before the queue goes away */
+    localio_queue_stats_t stats = { 0 };
+    for (int spin = 0; spin < 1000 && stats.blocked < 2; spin++) {
+        usleep(1000);
+        ASSERT_EQ(localio_queue_get_stats(&queue, &stats), 0);
+    }
+    ASSERT_EQ(stats.blocked, 2);
+    
+    localio_queue_cleanup(&queue);
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+        ASSERT_EQ(args[i].ret, GPUIO_ERROR_CANCELED);
+    }
+    
+    /* Queued requests are canceled through their callbacks, refused ones not */
+    ASSERT_EQ(queued.calls, 2);
+    ASSERT_EQ(queued.status, GPUIO_ERROR_CANCELED);
+    ASSERT_EQ(blocked.calls, 0);
+}
+
+TEST(queue_block_from_callback) {
+    /* Byte watermark only. A callback that processes the queue and then
+     * submits past the high watermark must not block: it would wait on
+     * completions only its own thread can run */
+    localio_queue_t queue;
+    ASSERT_EQ(queue_open(&queue, 0, 1 << 20), 0);
+    ASSERT_EQ(localio_queue_set_limits(&queue, 0, 0, 3000, 0, LOCALIO_ADMIT_BLOCK), 0);
+    
+    static char buf[4][4000];
+    localio_request_t reqs[4];
+    chain_t chain;
+    memset(&chain, 0, sizeof(chain));
+    chain.queue = &queue;
+    completion_t done = { 0, GPUIO_SUCCESS };
+    
+    make_chain_read(&reqs[0], buf[0], 0, 1000, &chain);
+    make_chain_read(&reqs[1], buf[1], 1, 1000, &chain);
+    make_read(&reqs[2], buf[2], 3 * 8192, 500, &done);
+    make_read(&reqs[3], buf[3], 4 * 8192, 4000, &done);
+    chain.nested[0] = &reqs[2];
+    chain.follow_up[0] = &reqs[3];
+    
+    ASSERT_EQ(localio_queue_submit(&queue, &reqs[0]), 0);
+    ASSERT_EQ(localio_queue_submit(&queue, &reqs[1]), 0);
+    ASSERT_EQ(localio_queue_process(&queue), 2);
+    ASSERT_EQ(chain.calls, 2);
+    ASSERT_EQ(chain.ret[0], 0);
+    ASSERT_EQ(done.calls, 1);
+    
+    ASSERT_EQ(localio_queue_process(&queue), 1);
+    ASSERT_EQ(done.calls, 2);
+    ASSERT(buf_matches(buf[3], 4 * 8192, 4000));
+    
+    localio_queue_stats_t stats;
+    ASSERT_EQ(localio_queue_get_stats(&queue, &stats), 0);
+    ASSERT_EQ(stats.blocked, 0);
+    ASSERT_EQ(stats.pending_bytes, 0);
+    ASSERT_EQ(stats.requests_completed, 4);
+    
+    localio_queue_cleanup(&queue);
+}
+
+/* ============================================================================
+ * Read Path Tests
+ * ============================================================================ */
+
+TEST(file_mmap_matches_pread) {
+    enum { COUNT = 16 };
+    localio_file_t* file;
+    ASSERT_EQ(localio_file_open(&g_local_ctx, g_data_path, GPUIO_MEM_READ, &file), 0);
+    
+    localio_extent_t extents[COUNT];
+    char* pread_buf = malloc(COUNT * 4096);
+    char* mmap_buf = calloc(COUNT, 4096);
+    void* bufs[COUNT];
+    ssize_t results[COUNT];
+    ASSERT_NOT_NULL(pread_buf);
+    ASSERT_NOT_NULL(mmap_buf);
+    
+    /* Small scattered records, some crossing page boundaries */
+    for (int i = 0; i < COUNT; i++) {
+        extents[i].offset = ((uint64_t)i * 70001) % (SCRATCH_SIZE - 4096);
+        extents[i].count = 64 + (size_t)i * 250;
+        bufs[i] = pread_buf + (size_t)i * 4096;
+    }
+    ASSERT_EQ(localio_file_read_batch(file, extents, bufs, results, COUNT), 0);
+    
+    ASSERT_EQ(localio_file_set_io_mode(file, LOCALIO_IO_MMAP), 0);
+    ASSERT_NOT_NULL(file->map_base);
+    ASSERT_EQ(file->map_size, (size_t)SCRATCH_SIZE);
+    
+    for (int i = 0; i < COUNT; i++) bufs[i] = mmap_buf + (size_t)i * 4096;
+    ASSERT_EQ(localio_file_read_batch(file, extents, bufs, results, COUNT), 0);
+    for (int i = 0; i < COUNT; i++) {
+        ASSERT_EQ(results[i], (ssize_t)extents[i].count);
+        ASSERT(memcmp(pread_buf + (size_t)i * 4096, mmap_buf + (size_t)i * 4096,
+                      extents[i].count) == 0);
+        ASSERT(buf_matches(mmap_buf + (size_t)i * 4096, extents[i].offset,
+                           extents[i].count));
+    }
+    
+    /* Single reads take the same path */
+    size_t n = 0;
+    ASSERT_EQ(localio_file_read(file, mmap_buf, 1000, 12345, &n), 0);
+    ASSERT_EQ(n, 1000);
+    ASSERT(buf_matches(mmap_buf, 12345, 1000));
+    
+    /* Switching back drops the mapping */
+    ASSERT_EQ(localio_file_set_io_mode(file, LOCALIO_IO_PREAD), 0);
+    ASSERT(file->map_base == NULL);
+    ASSERT_EQ(localio_file_read(file, pread_buf, 1000, 12345, &n), 0);
+    ASSERT_EQ(n, 1000);
+    ASSERT(memcmp(pread_buf, mmap_buf, 1000) == 0);
+    
+    free(pread_buf);
+    free(mmap_buf);
+    localio_file_close(file);
+}
+
+TEST(file_mmap_eof_clamp) {
+    localio_file_t* file;
+    ASSERT_EQ(localio_file_open(&g_local_ctx, g_data_path, GPUIO_MEM_READ, &file), 0);
+    ASSERT_EQ(localio_file_set_io_mode(file, LOCALIO_IO_MMAP), 0);
+    
+    char buf[3][4096];
+    size_t n = 1;
+    ASSERT_EQ(localio_file_read(file, buf[0], 4096, SCRATCH_SIZE - 100, &n), 0);
+    ASSERT_EQ(n, 100);
+    ASSERT(buf_matches(buf[0], SCRATCH_SIZE - 100, 100));
+    ASSERT_EQ(localio_file_read(file, buf[0], 4096, SCRATCH_SIZE, &n), 0);
+    ASSERT_EQ(n, 0);
+    
+    localio_extent_t extents[3] = {
+        { SCRATCH_SIZE - 1000, 4096 },      /* Straddles EOF */
+        { SCRATCH_SIZE + 4096, 4096 },      /* Entirely past EOF */
+        { SCRATCH_SIZE - 4096, 4096 },      /* Ends exactly at EOF */
+    };
+    void* bufs[3] = { buf[0], buf[1], buf[2] };
+    ssize_t results[3];
+    ASSERT_EQ(localio_file_read_batch(file, extents, bufs, results, 3), 0);
+    ASSERT_EQ(results[0], 1000);
+    ASSERT_EQ(results[1], 0);
+    ASSERT_EQ(results[2], 4096);
+    ASSERT(buf_matches(buf[0], SCRATCH_SIZE - 1000, 1000));
+    ASSERT(buf_matches(buf[2], SCRATCH_SIZE - 4096, 4096));
+    
+    localio_file_close(file);
+}
+
+TEST(file_mmap_rejects_writable) {
+    /* A writable handle on a non-empty regular file: only the flags rule it out */
+    localio_file_t* file;
+    ASSERT_EQ(localio_file_open(&g_local_ctx, g_data_path, GPUIO_MEM_READ_WRITE,
+                                &file), 0);
+    ASSERT_EQ(file->size, (size_t)SCRATCH_SIZE);
+    
+    ASSERT_EQ(localio_file_set_io_mode(file, LOCALIO_IO_MMAP), -1);
+    ASSERT_EQ(file->io_mode, LOCALIO_IO_PREAD);
+    ASSERT(file->map_base == NULL);
+    
+    /* The handle keeps reading through pread */
+    char buf[512];
+    size_t n = 0;
+    ASSERT_EQ(localio_file_read(file, buf, sizeof(buf), 4000, &n), 0);
+    ASSERT_EQ(n, sizeof(buf));
+    ASSERT(buf_matches(buf, 4000, sizeof(buf)));
+    
+    localio_file_close(file);
+}
+
+TEST(file_prefetch) {
+    localio_file_t* file;
+    ASSERT_EQ(localio_file_open(&g_local_ctx, g_data_path, GPUIO_MEM_READ, &file), 0);
+    
+    localio_extent_t valid[2] = { { 0, 65536 }, { SCRATCH_SIZE - 5000, 5000 } };
+    localio_extent_t invalid[3] = {
+        { SCRATCH_SIZE - 100, SIZE_MAX },   /* Runs off the end */
+        { SCRATCH_SIZE + 4096, 4096 },      /* Past EOF */
+        { UINT64_MAX - 10, 4096 },          /* End wraps around */
+    };
+    
+    /* Both read paths; the hint never fails a readable range */
+    for (int mode = 0; mode < 2; mode++) {
+        if (mode == 1) {
+            ASSERT_EQ(localio_file_set_io_mode(file, LOCALIO_IO_MMAP), 0);
+        }
+        ASSERT_EQ(localio_file_prefetch(file, valid, 2), 0);
+        ASSERT_EQ(localio_file_prefetch(file, invalid, 3), 0);
+        ASSERT_EQ(localio_file_prefetch(file, valid, 0), 0);
+        
+        char buf[5000];
+        size_t n = 0;
+        ASSERT_EQ(localio_file_read(file, buf, sizeof(buf), SCRATCH_SIZE - 5000, &n), 0);
+        ASSERT_EQ(n, sizeof(buf));
+        ASSERT(buf_matches(buf, SCRATCH_SIZE - 5000, sizeof(buf)));
+    }
+    
+    ASSERT_EQ(localio_file_prefetch(file, NULL, 1), -1);
+    ASSERT_EQ(localio_file_prefetch(file, valid, -1), -1);
+    ASSERT_EQ(localio_file_prefetch(NULL, valid, 1), -1);
+    
+    localio_file_close(file);
+}
+
+/* ============================================================================
+ * io_uring Tests
+ * ============================================================================ */
+
+/* Small ring and (via URING_MAX_READ) small reads, so batches wrap the ring
+ * and long extents are issued in pieces */
+static localio_uring_t g_ring;
+
+TEST(uring_read_batch_split) {
+    enum { COUNT = 50 };
+    int fd = open(g_data_path, O_RDONLY);
+    ASSERT(fd >= 0);
+    
+    localio_extent_t extents[COUNT];
+    void* bufs[COUNT];
+    ssize_t results[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+        extents[i].count = 1 + (size_t)i * 797;
+        extents[i].offset = ((uint64_t)i * 104729) % (SCRATCH_SIZE - extents[i].count);
+        bufs[i] = malloc(extents[i].count);
+        ASSERT_NOT_NULL(bufs[i]);
+    }
+    
+    ASSERT_EQ(localio_uring_read_batch(&g_ring, fd, extents, bufs, results, COUNT), 0);
+    
+    for (int i = 0; i < COUNT; i++) {
+        ASSERT_EQ(results[i], (ssize_t)extents[i].count);
+        const char* b = bufs[i];
+        for (size_t k = 0; k < extents[i].count; k += 61) {
+            ASSERT_EQ(b[k], pattern_byte(extents[i].offset + k));
+        }
+        ASSERT_EQ(b[extents[i].count - 1],
+                  pattern_byte(extents[i].offset + extents[i].count - 1));
+        free(bufs[i]);
+    }
+    
+    close(fd);
+}
+
+TEST(uring_read_batch_eof) {
+    int fd = open(g_data_path, O_RDONLY);
+    ASSERT(fd >= 0);
+    
+    static char buf[3][10000];
+    void* bufs[3] = { buf[0], buf[1], buf[2] };
+    ssize_t results[3];
+    localio_extent_t extents[3] = {
+        { SCRATCH_SIZE - 9000, 10000 },     /* Straddles EOF, split in three */
+        { SCRATCH_SIZE + 4096, 4096 },      /* Entirely past EOF */
+        { 0, 0 },                           /* Empty */
+    };
+    
+    ASSERT_EQ(localio_uring_read_batch(&g_ring, fd, extents, bufs, results, 3), 0);
+    ASSERT_EQ(results[0], 9000);
+    ASSERT_EQ(results[1], 0);
+    ASSERT_EQ(results[2], 0);
+    ASSERT_EQ(buf[0][8999], pattern_byte(SCRATCH_SIZE - 1));
+    
+    close(fd);
+}
+
+TEST(uring_read_batch_error_then_reuse) {
+    /* Reads of a directory fail; the ring must come back clean */
+    int dir_fd = open(g_dir, O_RDONLY | O_DIRECTORY);
+    int fd = open(g_data_path, O_RDONLY);
+    ASSERT(dir_fd >= 0 && fd >= 0);
+    
+    enum { COUNT = 9 };
+    static char buf[COUNT][4096];
+    void* bufs[COUNT];
+    ssize_t results[COUNT];
+    localio_extent_t extents[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+        bufs[i] = buf[i];
+        extents[i].offset = (uint64_t)i * 8192;
+        extents[i].count = 4096;
+    }
+    
+    ASSERT_EQ(localio_uring_read_batch(&g_ring, dir_fd, extents, bufs, results, COUNT), -1);
+    for (int i = 0; i < COUNT; i++) ASSERT(results[i] < 0);
+    
+    ASSERT_EQ(localio_uring_read_batch(&g_ring, fd, extents, bufs, results, COUNT), 0);
+    for (int i = 0; i < COUNT; i++) {
+        ASSERT_EQ(results[i], 4096);
+        ASSERT_EQ(buf[i][4095], pattern_byte(extents[i].offset + 4095));
+    }
+    
+    close(dir_fd);
+    close(fd);
+}
+
+TEST(uring_enter_failure_withdraws) {
+    /* Same rings, but io_uring_enter fails: nothing may be left queued */
+    localio_uring_t broken = g_ring;
+    broken.fd = open("/dev/null", O_RDONLY);
+    int fd = open(g_data_path, O_RDONLY);
+    ASSERT(broken.fd >= 0 && fd >= 0);
+    
+    static char stale[4][512];
+    memset(stale, 0, sizeof(stale));
+    void* bufs[4] = { stale[0], stale[1], stale[2], stale[3] };
+    ssize_t results[4];
+    localio_extent_t extents[4] = {
+        { 4096, 512 }, { 8192, 512 }, { 12288, 512 }, { 16384, 512 },
+    };
+    
+    ASSERT_EQ(localio_uring_read_batch(&broken, fd, extents, bufs, results, 4), -1);
+    for (int i = 0; i < 4; i++) ASSERT(results[i] < 0);
+    close(broken.fd);
+    
+    char buf[512];
+    void* buf_ptr = buf;
+    ASSERT_EQ(localio_uring_read_batch(&g_ring, fd, extents, &buf_ptr, results, 1), 0);
+    ASSERT_EQ(results[0], 512);
+    ASSERT_EQ(buf[0], pattern_byte(4096));
+    
+    /* The withdrawn reads never ran */
+    for (int i = 0; i < 4; i++) ASSERT_EQ(stale[i][0], 0);
+    
+    close(fd);
+}
+
+/* ============================================================================
+ * GDS Fallback Tests
+ * ============================================================================ */
+
+static localio_context_t g_host_ctx;
+
+TEST(gds_serial_short_read) {
+    /* Without GDS each entry goes through a host bounce buffer */
+    int fd = open(g_data_path, O_RDONLY);
+    ASSERT(fd >= 0);
+    
+    char buf[2][4096];
+    localio_gds_io_t ios[2] = {
+        { GPUIO_REQ_READ, fd, buf[0], 4096, SCRATCH_SIZE - 1000, 0 },
+        { GPUIO_REQ_READ, fd, buf[1], 4096, SCRATCH_SIZE + 4096, 0 },
+    };
+    
+    ASSERT_EQ(localio_gds_submit_batch(&g_host_ctx, ios, 2), 0);
+    ASSERT_EQ(ios[0].result, 1000);
+    ASSERT_EQ(ios[1].result, 0);
+    ASSERT_EQ(buf[0][999], pattern_byte(SCRATCH_SIZE - 1));
+    
+    ASSERT_EQ(localio_gds_read(&g_host_ctx, fd, buf[0], 4096, 0), 4096);
+    close(fd);
+    
+    /* The path-level batch call falls back to the same serial reads */
+    localio_extent_t extents[2] = {
+        { 8192, 4096 },
+        { SCRATCH_SIZE - 1000, 4096 },
+    };
+    void* ptrs[2] = { buf[0], buf[1] };
+    ssize_t results[2];
+    ASSERT_EQ(localio_read_gpu_batch(&g_host_ctx, g_data_path, extents, ptrs,
+                                     results, 2), 0);
+    ASSERT_EQ(results[0], 4096);
+    ASSERT_EQ(results[1], 1000);
+    ASSERT(buf_matches(buf[0], 8192, 4096));
+    ASSERT(buf_matches(buf[1], SCRATCH_SIZE - 1000, 1000));
+}
+
+/* ============================================================================
+ * GDS Batch Tests
+ * ============================================================================ */
+
+#ifdef CUFILE_STUB_PATH
+
+static localio_context_t g_gds_ctx;
+
+TEST(gds_stub_loaded) {
+    ASSERT_EQ(g_gds_ctx.gds_available, 1);
+    ASSERT_NOT_NULL(g_gds_ctx.gds_handle);
+}
+
+TEST(gds_batch_read_chunks) {
+    /* More than one cuFile batch, spread over two descriptors of one file */
+    const int count = CUFILE_MAX_BATCH_IO_SIZE * 2 + 44;
+    const size_t io_size = 1024;
+    int fds[2];
+    fds[0] = open(g_data_path, O_RDONLY);
+    fds[1] = open(g_data_path, O_RDONLY);
+    ASSERT(fds[0] >= 0 && fds[1] >= 0);
+    
+    char* bufs = calloc(count, io_size);
+    localio_gds_io_t* ios = calloc(count, sizeof(localio_gds_io_t));
+    ASSERT_NOT_NULL(bufs);
+    ASSERT_NOT_NULL(ios);
+    
+    for (int i = 0; i < count; i++) {
+        ios[i].op = GPUIO_REQ_READ;
+        ios[i].fd = fds[i % 2];
+        ios[i].gpu_buf = bufs + (size_t)i * io_size;
+        ios[i].count = io_size;
+        ios[i].offset = ((uint64_t)i * 2039 * io_size) % (SCRATCH_SIZE - io_size);
+    }
+    
+    ASSERT_EQ(localio_gds_submit_batch(&g_gds_ctx, ios, count), 0);
+    
+    for (int i = 0; i < count; i++) {
+        ASSERT_EQ(ios[i].result, (ssize_t)io_size);
+        for (size_t b = 0; b < io_size; b += 97) {
+            ASSERT_EQ(bufs[(size_t)i * io_size + b],
+                      pattern_byte(ios[i].offset + b));
+        }
+    }
+    
+    free(ios);
+    free(bufs);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(gds_batch_write_then_read) {
+    const int count = 64;
+    const size_t io_size = 4096;
+    int fd = open(g_out_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT(fd >= 0);
+    
+    char* src = malloc((size_t)count * io_size);
+    char* dst = calloc(count, io_size);
+    localio_gds_io_t ios[64];
+    ASSERT_NOT_NULL(src);
+    ASSERT_NOT_NULL(dst);
+    for (size_t i = 0; i < (size_t)count * io_size; i++) src[i] = (char)(i * 3 + 1);
+    
+    /* Write in reverse file order so completion order doesn't matter */
+    for (int i = 0; i < count; i++) {
+        ios[i].op = GPUIO_REQ_WRITE;
+        ios[i].fd = fd;
+        ios[i].gpu_buf = src + (size_t)(count - 1 - i) * io_size;
+        ios[i].count = io_size;
+        ios[i].offset = (uint64_t)(count - 1 - i) * io_size;
+    }
+    ASSERT_EQ(localio_gds_submit_batch(&g_gds_ctx, ios, count), 0);
+    for (int i = 0; i < count; i++) ASSERT_EQ(ios[i].result, (ssize_t)io_size);
+    
+    for (int i = 0; i < count; i++) {
+        ios[i].op = GPUIO_REQ_READ;
+        ios[i].gpu_buf = dst + (size_t)i * io_size;
+        ios[i].offset = (uint64_t)i * io_size;
+    }
+    ASSERT_EQ(localio_gds_submit_batch(&g_gds_ctx, ios, count), 0);
+    ASSERT(memcmp(src, dst, (size_t)count * io_size) == 0);
+    
+    free(src);
+    free(dst);
+    close(fd);
+}
+
+TEST(gds_batch_short_read) {
+    int fd = open(g_data_path, O_RDONLY);
+    ASSERT(fd >= 0);
+    
+    char buf[2][4096];
+    localio_gds_io_t ios[2] = {
+        /* Straddles EOF: only the first 1000 bytes exist */
+        { GPUIO_REQ_READ, fd, buf[0], 4096, SCRATCH_SIZE - 1000, 0 },
+        /* Entirely past EOF */
+        { GPUIO_REQ_READ, fd, buf[1], 4096, SCRATCH_SIZE + 4096, 0 },
+    };
+    
+    ASSERT_EQ(localio_gds_submit_batch(&g_gds_ctx, ios, 2), 0);
+    ASSERT_EQ(ios[0].result, 1000);
+    ASSERT_EQ(ios[1].result, 0);
+    ASSERT_EQ(buf[0][0], pattern_byte(SCRATCH_SIZE - 1000));
+    
+    close(fd);
+}
+
+TEST(gds_read_gpu_batch) {
+    /* The path-level entry point, through the stub's batch API */
+    enum { COUNT = 40 };
+    localio_extent_t extents[COUNT];
+    char* bufs = calloc(COUNT, 4096);
+    void* ptrs[COUNT];
+    ssize_t results[COUNT];
+    ASSERT_NOT_NULL(bufs);
+    
+    for (int i = 0; i < COUNT; i++) {
+        extents[i].offset = ((uint64_t)i * 52361) % (SCRATCH_SIZE - 4096);
+        extents[i].count = 4096;
+        ptrs[i] = bufs + (size_t)i * 4096;
+    }
+    /* The last one straddles EOF */
+    extents[COUNT - 1].offset = SCRATCH_SIZE - 100;
+    
+    uint64_t before = g_gds_ctx.bytes_read;
+    ASSERT_EQ(localio_read_gpu_batch(&g_gds_ctx, g_data_path, extents, ptrs,
+                                     results, COUNT), 0);
+    for (int i = 0; i < COUNT - 1; i++) {
+        ASSERT_EQ(results[i], 4096);
+        ASSERT(buf_matches(ptrs[i], extents[i].offset, 4096));
+    }
+    ASSERT_EQ(results[COUNT - 1], 100);
+    ASSERT(buf_matches(ptrs[COUNT - 1], SCRATCH_SIZE - 100, 100));
+    ASSERT_EQ(g_gds_ctx.bytes_read - before, (uint64_t)(COUNT - 1) * 4096 + 100);
+    
+    ASSERT_EQ(localio_read_gpu_batch(&g_gds_ctx, g_data_path, extents, ptrs,
+                                     results, 0), 0);
+    ASSERT_EQ(localio_read_gpu_batch(&g_gds_ctx, "/nonexistent/gpuio", extents,
+                                     ptrs, results, 1), -1);
+    
+    free(bufs);
+}
+
+TEST(gds_batch_invalid_args) {
+    char buf[16];
+    localio_gds_io_t io = { GPUIO_REQ_READ, -1, buf, sizeof(buf), 0, 0 };
+    
+    ASSERT_EQ(localio_gds_submit_batch(&g_gds_ctx, &io, 1), -1);
+    ASSERT_EQ(localio_gds_submit_batch(&g_gds_ctx, NULL, 1), -1);
+    ASSERT_EQ(localio_gds_submit_batch(&g_gds_ctx, &io, 0), 0);
+}
+
+TEST(gds_stub_destroy_while_queued) {
+    /* Destroy right after submit: queued entries are canceled while the
+     * stub's workers are still picking them up */
+    void* lib = dlopen(CUFILE_STUB_PATH, RTLD_LAZY);
+    ASSERT_NOT_NULL(lib);
+    
+    cufile_handle_register_fn handle_register;
+    cufile_handle_deregister_fn handle_deregister;
+    cufile_batch_setup_fn batch_setup;
+    cufile_batch_submit_fn batch_submit;
+    cufile_batch_destroy_fn batch_destroy;
+    *(void**)(&handle_register) = dlsym(lib, "cuFileHandleRegister");
+    *(void**)(&handle_deregister) = dlsym(lib, "cuFileHandleDeregister");
+    *(void**)(&batch_setup) = dlsym(lib, "cuFileBatchIOSetUp");
+    *(void**)(&batch_submit) = dlsym(lib, "cuFileBatchIOSubmit");
+    *(void**)(&batch_destroy) = dlsym(lib, "cuFileBatchIODestroy");
+    ASSERT(handle_register && handle_deregister && batch_setup &&
+           batch_submit && batch_destroy);
+    
+    int fd = open(g_data_path, O_RDONLY);
+    ASSERT(fd >= 0);
+    
+    CUfileDescr_t descr;
+    memset(&descr, 0, sizeof(descr));
+    descr.type = CU_FILE_HANDLE_TYPE_OPAQUE_FD;
+    descr.handle.fd = fd;
+    CUfileHandle_t fh;
+    ASSERT_EQ(handle_register(&fh, &descr).err, CU_FILE_SUCCESS);
+    
+    enum { NR = 32, IO_SIZE = 512 };
+    static char bufs[NR][IO_SIZE];
+    CUfileIOParams_t params[NR];
+    memset(params, 0, sizeof(params));
+    for (int i = 0; i < NR; i++) {
+        params[i].mode = CUFILE_BATCH;
+        params[i].u.batch.devPtr_base = bufs[i];
+        params[i].u.batch.file_offset = (off_t)i * IO_SIZE;
+        params[i].u.batch.size = IO_SIZE;
+        params[i].fh = fh;
+        params[i].opcode = CUFILE_READ;
+    }
+    
+    for (int iter = 0; iter < 2000; iter++) {
+        CUfileBatchHandle_t batch;
+        ASSERT_EQ(batch_setup(&batch, NR).err, CU_FILE_SUCCESS);
+        ASSERT_EQ(batch_submit(batch, NR, params, 0).err, CU_FILE_SUCCESS);
+        batch_destroy(batch);
+    }
+    
+    handle_deregister(fh);
+    close(fd);
+    dlclose(lib);
+}
+
+#endif /* CUFILE_STUB_PATH */
+
+/* ============================================================================
+ * Main
+ * ============================================================================ */
+
+static void print_header(const char* name) {
+    printf("\n%s\n", name);
+    printf("------------------------------------------------------------\n");
+}
+
+int main(int argc, char* argv[]) {
+    (void)argc;
+    (void)argv;
+    printf("gpuio LocalIO Unit Tests\n");
+    printf("Version: %s\n", gpuio_get_version_string());
+    
+    if (setup() != 0) {
+        printf("Setup failed\n");
+        teardown();
+        return 1;
+    }
+    
+    print_header("Queue Tests");
+    memset(&g_local_ctx, 0, sizeof(g_local_ctx));
+    pthread_mutex_init(&g_local_ctx.files_lock, NULL);
+    if (localio_file_open(&g_local_ctx, g_data_path, GPUIO_MEM_READ, &g_file) != 0) {
+        printf("  Failed to open %s\n", g_data_path);
+        teardown();
+        return 1;
+    }
+    RUN_TEST(queue_merge_gap);
+    RUN_TEST(queue_max_merge);
+    RUN_TEST(queue_latency_budget);
+    RUN_TEST(queue_failed_merge_delay);
+    RUN_TEST(queue_concurrent_process);
+    
+    print_header("Admission Control Tests");
+    RUN_TEST(queue_default_limits);
+    RUN_TEST(queue_admit_reject);
+    RUN_TEST(queue_admit_shed_prefetch);
+    RUN_TEST(queue_admit_block);
+    RUN_TEST(queue_cleanup_wakes_blocked);
+    RUN_TEST(queue_block_from_callback);
+    
+    print_header("Read Path Tests");
+    RUN_TEST(file_mmap_matches_pread);
+    RUN_TEST(file_mmap_eof_clamp);
+    RUN_TEST(file_mmap_rejects_writable);
+    RUN_TEST(file_prefetch);
+    localio_file_close(g_file);
+    free(g_local_ctx.files);
+    pthread_mutex_destroy(&g_local_ctx.files_lock);
+    
+    print_header("io_uring Tests");
+    if (localio_uring_init(&g_ring, 4) == 0) {
+        RUN_TEST(uring_read_batch_split);
+        RUN_TEST(uring_read_batch_eof);
+        RUN_TEST(uring_read_batch_error_then_reuse);
+        RUN_TEST(uring_enter_failure_withdraws);
+        localio_uring_cleanup(&g_ring);
+    } else {
+        printf("  io_uring unavailable, skipped\n");
+    }
+
+    print_header("GDS Fallback Tests");
+    memset(&g_host_ctx, 0, sizeof(g_host_ctx));
+    if (gpuio_init(&g_host_ctx.parent, NULL) == GPUIO_SUCCESS) {
+        RUN_TEST(gds_serial_short_read);
+        gpuio_finalize(g_host_ctx.parent);
+    } else {
+        printf("  gpuio_init failed, skipped\n");
+    }
+
+#ifdef CUFILE_STUB_PATH
+    print_header("GDS Batch Tests");
+    setenv("GPUIO_CUFILE_LIBRARY", CUFILE_STUB_PATH, 1);
+    localio_gds_init(&g_gds_ctx);
+    RUN_TEST(gds_stub_loaded);
+    if (g_gds_ctx.gds_available) {
+        RUN_TEST(gds_batch_read_chunks);
+        RUN_TEST(gds_batch_write_then_read);
+        RUN_TEST(gds_batch_short_read);
+        RUN_TEST(gds_read_gpu_batch);
+        RUN_TEST(gds_batch_invalid_args);
+        RUN_TEST(gds_stub_destroy_while_queued);
+    }
+    localio_gds_cleanup(&g_gds_ctx);
+#endif
+
+    teardown();
+    
+    /* Summary */
+    printf("\n============================================================\n");
+    printf("Test Summary:\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("============================================================\n");
+    
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,2526 @@
+/**
+ * @file test_remoteio.c
+ * @brief Loopback tests for the remoteio module
+ * @version 1.0.0
+ *
+ * Every test talks over 127.0.0.1, a Unix socket or shared memory to an
+ * in-process server, or to a bare peer that speaks the framed protocol
+ * from remoteio_internal.h. One-sided ops take the soft path.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <gpuio/gpuio.h>
+#include "remoteio_internal.h"
+
+/* Test statistics */
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/* Test macros */
+#define TEST(name) static void test_##name(void)
+#define RUN_TEST(name) do { \
+    int failed_before = tests_failed; \
+    printf("  Running %s... ", #name); \
+    fflush(stdout); \
+    tests_run++; \
+    test_##name(); \
+    if (tests_failed == failed_before) { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } \
+} while(0)
+
+#define ASSERT(expr) do { \
+    if (!(expr)) { \
+        printf("FAILED\n    Assertion failed: %s at line %d\n", #expr, __LINE__); \
+        tests_failed++; \
+        return; \
+    } \
+} while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_NOT_NULL(ptr) ASSERT((ptr) != NULL)
+
+#define STORE_SIZE    (4 << 20)
+#define WAIT_US       10000000ULL
+#define UNIX_PATH     "/tmp/gpuio_test_remoteio.sock"
+
+/* How the peer treats the next connection it accepts */
+typedef enum {
+    PEER_SERVE = 0,              /* Answer every request in order */
+    PEER_HOLD_FIRST = 1,         /* Answer the first READ after the second request */
+    PEER_HANG_UP = 2,            /* Close the socket on the first request */
+} peer_mode_t;
+
+/* Shared peer and servers: all serve the resource "mem" over g_store; the
+ * TCP server also registers it read-write as "rw", and g_ro_store
+ * read-only as "ro" */
+static gpuio_context_t g_ctx = NULL;
+static remoteio_context_t* g_server_ctx = NULL;
+static remoteio_server_t* g_server = NULL;
+static remoteio_server_t* g_unix_server = NULL;
+static char* g_store = NULL;
+static char* g_ro_store = NULL;
+static remoteio_remote_mem_t g_rw_mem;
+static remoteio_remote_mem_t g_ro_mem;
+static int g_peer_fd = -1;
+static int g_peer_port = 0;
+static pthread_t g_peer_thread;
+static volatile peer_mode_t g_peer_mode = PEER_SERVE;
+
+/* ============================================================================
+ * Protocol Peer
+ * ============================================================================ */
+
+static int peer_recv(int fd, void* buf, size_t len) {
+    char* p = buf;
+    while (len > 0) {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int peer_send(int fd, const void* buf, size_t len) {
+    const char* p = buf;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/* Send the READ_RESP frames for one request */
+static int peer_answer_read(int fd, const remoteio_msg_hdr_t* req) {
+    uint8_t raw[REMOTEIO_MSG_HDR_SIZE];
+    uint64_t done = 0;
+    
+    do {
+        uint64_t n = req->length - done;
+        if (n > REMOTEIO_PROTO_CHUNK) n = REMOTEIO_PROTO_CHUNK;
+    
+        remoteio_msg_hdr_t resp = {
+            .type = REMOTEIO_MSG_READ_RESP,
+            .flags = (done + n == req->length) ? REMOTEIO_MSG_F_LAST : 0,
+            .req_id = req->req_id,
+            .offset = req->offset + done,
+            .length = req->length,
+            .chunk_len = (uint32_t)n,
+        };
+        remoteio_msg_encode(&resp, raw);
+        if (peer_send(fd, raw, sizeof(raw)) != 0 ||
+            peer_send(fd, g_store + req->offset + done, n) != 0) {
+            return -1;
+        }
+        done += n;
+    } while (done < req->length);
+    
+    return 0;
+}
+
+static int peer_answer_write(int fd, const remoteio_msg_hdr_t* req) {
+    uint8_t raw[REMOTEIO_MSG_HDR_SIZE];
+    remoteio_msg_hdr_t resp = {
+        .type = REMOTEIO_MSG_WRITE_RESP,
+        .flags = REMOTEIO_MSG_F_LAST,
+        .req_id = req->req_id,
+        .length = req->length,
+    };
+    
+    remoteio_msg_encode(&resp, raw);
+    return peer_send(fd, raw, sizeof(raw));
+}
+
+static void* peer_conn_thread(void* arg) {
+    int fd = (int)(intptr_t)arg;
+    peer_mode_t mode = g_peer_mode;
+    remoteio_msg_hdr_t held;
+    bool holding = false;
+    uint8_t raw[REMOTEIO_MSG_HDR_SIZE];
+    char resource[REMOTEIO_MAX_RESOURCE];
+    remoteio_msg_hdr_t req;
+    
+    g_peer_mode = PEER_SERVE;
+    
+    while (peer_recv(fd, raw, sizeof(raw)) == 0 && remoteio_msg_decode(raw, &req) == 0) {
+        if (mode == PEER_HANG_UP && req.type != REMOTEIO_MSG_HELLO) break;
+        if (peer_recv(fd, resource, req.resource_len) != 0) break;
+        if (req.offset + req.length > STORE_SIZE) break;
+    
+        int rc = 0;
+        if (req.type == REMOTEIO_MSG_HELLO) {
+            /* Grant nothing: payloads stay raw */
+            remoteio_msg_hdr_t ack = { .type = REMOTEIO_MSG_HELLO_ACK, .flags = REMOTEIO_MSG_F_LAST };
+            remoteio_msg_encode(&ack, raw);
+            rc = peer_send(fd, raw, sizeof(raw));
+        } else if (req.type == REMOTEIO_MSG_WRITE) {
+            if (peer_recv(fd, g_store + req.offset, req.chunk_len) != 0) break;
+            if (req.flags & REMOTEIO_MSG_F_LAST) rc = peer_answer_write(fd, &req);
+        } else if (req.type == REMOTEIO_MSG_READ) {
+            if (mode == PEER_HOLD_FIRST && !holding) {
+                held = req;
+                holding = true;
+                mode = PEER_SERVE;
+                continue;
+            }
+            rc = peer_answer_read(fd, &req);
+        } else {
+            break;
+        }
+    
+        if (rc == 0 && holding) {
+            rc = peer_answer_read(fd, &held);
+            holding = false;
+        }
+        if (rc != 0) break;
+    }
+    
+    close(fd);
+    return NULL;
+}
+
+static void* peer_accept_thread(void* arg) {
+    (void)arg;
+    
+    for (;;) {
+        int fd = accept(g_peer_fd, NULL, NULL);
+        if (fd < 0) break;
+    
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, peer_conn_thread, (void*)(intptr_t)fd) != 0) {
+            close(fd);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+    
+    return NULL;
+}
+
+/* ============================================================================
+ * Setup/Teardown
+ * ============================================================================ */
+
+static int setup(void) {
+    if (gpuio_init(&g_ctx, NULL) != GPUIO_SUCCESS) return -1;
+    
+    g_store = calloc(1, STORE_SIZE);
+    g_ro_store = malloc(STORE_SIZE);
+    if (!g_store || !g_ro_store) return -1;
+    for (int i = 0; i < STORE_SIZE; i++) g_ro_store[i] = (char)(i * 13 + 5);
+    
+    g_peer_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (g_peer_fd < 0) return -1;
+    
+    struct sockaddr_in sin = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t len = sizeof(sin);
+    if (bind(g_peer_fd, (struct sockaddr*)&sin, sizeof(sin)) != 0 ||
+        listen(g_peer_fd, 16) != 0 ||
+        getsockname(g_peer_fd, (struct sockaddr*)&sin, &len) != 0) {
+        return -1;
+    }
+    g_peer_port = ntohs(sin.sin_port);
+    
+    if (pthread_create(&g_peer_thread, NULL, peer_accept_thread, NULL) != 0) {
+        close(g_peer_fd);
+        g_peer_fd = -1;
+        return -1;
+    }
+    
+    g_server_ctx = remoteio_context_create(g_ctx);
+    if (!g_server_ctx) return -1;
+    
+    if (remoteio_server_create(g_server_ctx, 2, 32, &g_server) != 0 ||
+        remoteio_server_export_memory(g_server, "mem", g_store, STORE_SIZE, true) != 0 ||
+        remoteio_server_register_region(g_server, "rw", g_store, STORE_SIZE,
+                                        REMOTEIO_ACCESS_REMOTE_READ |
+                                        REMOTEIO_ACCESS_REMOTE_WRITE, &g_rw_mem) != 0 ||
+        remoteio_server_register_region(g_server, "ro", g_ro_store, STORE_SIZE,
+                                        REMOTEIO_ACCESS_REMOTE_READ, &g_ro_mem) != 0 ||
+        remoteio_server_start(g_server, 0) != 0) {
+        return -1;
+    }
+    
+    if (remoteio_server_create(g_server_ctx, 2, 32, &g_unix_server) != 0 ||
+        remoteio_server_export_memory(g_unix_server, "mem", g_store, STORE_SIZE, true) != 0 ||
+        remoteio_server_start_unix(g_unix_server, UNIX_PATH) != 0) {
+        return -1;
+    }
+    
+    return 0;
+}
+
+static void teardown(void) {
+    if (g_unix_server) remoteio_server_destroy(g_unix_server);
+    if (g_server) remoteio_server_destroy(g_server);
+    if (g_server_ctx) remoteio_context_destroy(g_server_ctx);
+    if (g_peer_fd >= 0) {
+        shutdown(g_peer_fd, SHUT_RDWR);
+        close(g_peer_fd);
+        pthread_join(g_peer_thread, NULL);
+    }
+    if (g_ctx) gpuio_finalize(g_ctx);
+    free(g_store);
+    free(g_ro_store);
+}
+
+/* Client context that always uses the given transport */
+static remoteio_context_t* client_create(remoteio_transport_t transport) {
+    remoteio_context_t* ctx = remoteio_context_create(g_ctx);
+    if (ctx) ctx->preferred_transport = transport;
+    return ctx;
+}
+
+/* Connection to port with the framed protocol attached, completed by the
+ * context's reactor */
+static remoteio_connection_t* proto_connect(remoteio_context_t* ctx, int port) {
+    remoteio_connection_t* conn;
+    if (remoteio_conn_create(ctx, "127.0.0.1", (uint16_t)port, &conn) != 0) return NULL;
+    
+    if (remoteio_network_connect(ctx, conn, "127.0.0.1", (uint16_t)port) != 0 ||
+        remoteio_proto_attach(conn, ctx) != 0 ||
+        remoteio_reactor_add(&ctx->reactor, conn) != 0) {
+        remoteio_conn_destroy(conn);
+        return NULL;
+    }
+    return conn;
+}
+
+/* Allocate and submit one named op on conn */
+static remoteio_operation_t* named_submit(remoteio_context_t* ctx, remoteio_connection_t* conn,
+                                          remoteio_op_t type, const char* resource,
+                                          void* buf, uint64_t offset, size_t len) {
+    remoteio_operation_t* op = remoteio_op_alloc(ctx);
+    if (!op) return NULL;
+    
+    op->op = type;
+    op->conn = conn;
+    snprintf(op->resource, sizeof(op->resource), "%s", resource);
+    op->local_buf = buf;
+    op->remote_offset = offset;
+    op->length = len;
+    
+    if (remoteio_op_submit(ctx, op) != 0) {
+        remoteio_op_free(ctx, op);
+        return NULL;
+    }
+    return op;
+}
+
+/* Run one named op on conn; 0 only if it completed with every byte */
+static int named_op(remoteio_context_t* ctx, remoteio_connection_t* conn, remoteio_op_t type,
+                    const char* resource, void* buf, uint64_t offset, size_t len) {
+    remoteio_operation_t* op = named_submit(ctx, conn, type, resource, buf, offset, len);
+    if (!op) return -1;
+    
+    int ret = remoteio_op_wait(op, WAIT_US);
+    if (ret == 0 && (op->status != GPUIO_SUCCESS || op->bytes_transferred != len)) ret = -1;
+    
+    remoteio_op_free(ctx, op);
+    return ret;
+}
+
+/* Run one one-sided op on conn; 0 only if it completed with every byte */
+static int one_sided_op(remoteio_context_t* ctx, remoteio_connection_t* conn,
+                        remoteio_op_t type, remoteio_gdr_region_t* local,
+                        remoteio_remote_mem_t* remote, uint64_t remote_offset, size_t len) {
+    remoteio_operation_t* op = remoteio_op_alloc(ctx);
+    if (!op) return -1;
+    
+    op->op = type;
+    op->conn = conn;
+    op->local_gdr = local;
+    op->remote_mem = remote;
+    op->remote_offset = remote_offset;
+    op->length = len;
+    
+    int ret = remoteio_op_submit(ctx, op);
+    if (ret == 0) ret = remoteio_op_wait(op, WAIT_US);
+    if (ret == 0 && (op->status != GPUIO_SUCCESS || op->bytes_transferred != len)) ret = -1;
+    
+    remoteio_op_free(ctx, op);
+    return ret;
+}
+
+/* Workers count an op after answering it; wait up to 1s for the stats */
+static void server_stats_wait(remoteio_server_t* server, uint64_t bytes_read,
+                              uint64_t bytes_written, uint64_t errors,
+                              remoteio_server_stats_t* stats) {
+    for (int i = 0; i < 100; i++) {
+        remoteio_server_get_stats(server, stats);
+        if (stats->bytes_read >= bytes_read && stats->bytes_written >= bytes_written &&
+            stats->errors >= errors) {
+            return;
+        }
+        usleep(10000);
+    }
+}
+
+/* Write a pattern through conn, read it back and compare with the store */
+static int named_round_trip(remoteio_context_t* ctx, remoteio_connection_t* conn,
+                            uint64_t offset, size_t len, int seed) {
+    char* out = malloc(len);
+    char* in = malloc(len);
+    int ret = -1;
+    
+    if (out && in) {
+        for (size_t i = 0; i < len; i++) out[i] = (char)(i * 7 + seed);
+        if (named_op(ctx, conn, REMOTEIO_OP_WRITE, "mem", out, offset, len) == 0 &&
+            memcmp(g_store + offset, out, len) == 0 &&
+            named_op(ctx, conn, REMOTEIO_OP_READ, "mem", in, offset, len) == 0 &&
+            memcmp(in, out, len) == 0) {
+            ret = 0;
+        }
+    }
+    
+    free(out);
+    free(in);
+    return ret;
+}
+
+/* Wait up to 10s for a pool counter to reach want */
+static bool pool_wait(remoteio_conn_pool_t* pool, uint64_t* counter, uint64_t want) {
+    for (int i = 0; i < 1000; i++) {
+        pthread_mutex_lock(&pool->lock);
+        bool reached = *counter >= want;
+        pthread_mutex_unlock(&pool->lock);
+        if (reached) return true;
+        usleep(10000);
+    }
+    return false;
+}
+
+/* ============================================================================
+ * Framed Protocol Tests
+ * ============================================================================ */
+
+TEST(header_round_trip) {
+    remoteio_msg_hdr_t in = {
+        .type = REMOTEIO_MSG_READ_RESP,
+        .flags = REMOTEIO_MSG_F_LAST,
+        .req_id = 0x0102030405060708ULL,
+        .offset = 1ULL << 40,
+        .length = 3 * REMOTEIO_PROTO_CHUNK,
+        .chunk_len = REMOTEIO_PROTO_CHUNK,
+        .resource_len = 3,
+        .status = (int16_t)GPUIO_ERROR_IO,
+    };
+    uint8_t raw[REMOTEIO_MSG_HDR_SIZE];
+    remoteio_msg_hdr_t out;
+    
+    remoteio_msg_encode(&in, raw);
+    ASSERT_EQ(remoteio_msg_decode(raw, &out), 0);
+    ASSERT_EQ(out.type, in.type);
+    ASSERT_EQ(out.flags, in.flags);
+    ASSERT_EQ(out.req_id, in.req_id);
+    ASSERT_EQ(out.offset, in.offset);
+    ASSERT_EQ(out.length, in.length);
+    ASSERT_EQ(out.chunk_len, in.chunk_len);
+    ASSERT_EQ(out.resource_len, in.resource_len);
+    ASSERT_EQ(out.status, in.status);
+    
+    /* Bad magic and oversized chunks are rejected */
+    raw[0] ^= 0xFF;
+    ASSERT_NE(remoteio_msg_decode(raw, &out), 0);
+    in.chunk_len = REMOTEIO_PROTO_CHUNK + 1;
+    remoteio_msg_encode(&in, raw);
+    ASSERT_NE(remoteio_msg_decode(raw, &out), 0);
+}
+
+TEST(uri_rw_tcp) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    
+    char uri[128];
+    snprintf(uri, sizeof(uri), "tcp://127.0.0.1:%d/mem", g_peer_port);
+    
+    /* Several protocol chunks in one op */
+    size_t len = 3 * REMOTEIO_PROTO_CHUNK + 17;
+    char* out = malloc(len);
+    char* in = calloc(1, len);
+    ASSERT_NOT_NULL(out);
+    ASSERT_NOT_NULL(in);
+    for (size_t i = 0; i < len; i++) out[i] = (char)(i * 7 + 1);
+    
+    ASSERT_EQ(remoteio_write(ctx, uri, out, len, 4096), 0);
+    ASSERT_EQ(memcmp(g_store + 4096, out, len), 0);
+    ASSERT_EQ(remoteio_read(ctx, uri, in, len, 4096), 0);
+    ASSERT_EQ(memcmp(in, out, len), 0);
+    
+    free(out);
+    free(in);
+    remoteio_context_destroy(ctx);
+}
+
+TEST(responses_out_of_order) {
+    remoteio_context_t* ctx = remoteio_context_create(g_ctx);
+    ASSERT_NOT_NULL(ctx);
+    
+    for (int i = 0; i < 65536; i++) g_store[i] = (char)(i * 11 + 3);
+    
+    g_peer_mode = PEER_HOLD_FIRST;
+    remoteio_connection_t* conn = proto_connect(ctx, g_peer_port);
+    ASSERT_NOT_NULL(conn);
+    
+    /* The peer answers the second read before the first */
+    char first[1000], second[70000];
+    remoteio_operation_t* a = named_submit(ctx, conn, REMOTEIO_OP_READ, "mem", first, 100, sizeof(first));
+    remoteio_operation_t* b = named_submit(ctx, conn, REMOTEIO_OP_READ, "mem", second, 0, 60000);
+    ASSERT_NOT_NULL(a);
+    ASSERT_NOT_NULL(b);
+    
+    ASSERT_EQ(remoteio_op_wait(b, WAIT_US), 0);
+    ASSERT_EQ(remoteio_op_wait(a, WAIT_US), 0);
+    ASSERT_EQ(a->bytes_transferred, sizeof(first));
+    ASSERT_EQ(b->bytes_transferred, 60000);
+    ASSERT_EQ(memcmp(first, g_store + 100, sizeof(first)), 0);
+    ASSERT_EQ(memcmp(second, g_store, 60000), 0);
+    ASSERT_EQ(conn->reqs_completed, 2);
+    
+    remoteio_op_free(ctx, a);
+    remoteio_op_free(ctx, b);
+    remoteio_conn_release(conn);
+    remoteio_context_destroy(ctx);
+}
+
+TEST(broken_stream_fails_ops) {
+    remoteio_context_t* ctx = remoteio_context_create(g_ctx);
+    ASSERT_NOT_NULL(ctx);
+    
+    g_peer_mode = PEER_HANG_UP;
+    remoteio_connection_t* conn = proto_connect(ctx, g_peer_port);
+    ASSERT_NOT_NULL(conn);
+    
+    char buf[4096];
+    remoteio_operation_t* op = named_submit(ctx, conn, REMOTEIO_OP_READ, "mem", buf, 0, sizeof(buf));
+    ASSERT_NOT_NULL(op);
+    
+    /* The receive thread fails the op once the peer hangs up */
+    ASSERT_NE(remoteio_op_wait(op, WAIT_US), 0);
+    for (int i = 0; i < 1000 && !op->completed; i++) usleep(1000);
+    ASSERT(op->completed);
+    ASSERT_EQ(op->status, GPUIO_ERROR_NETWORK);
+    ASSERT_EQ(conn->state, REMOTEIO_CONN_ERROR);
+    
+    remoteio_op_free(ctx, op);
+    remoteio_conn_release(conn);
+    remoteio_context_destroy(ctx);
+}
+
+/* Holds the reactor inside an op's completion callback for a while */
+static void slow_callback(gpuio_request_t request, gpuio_error_t status, void* user_data) {
+    volatile int* stage = (volatile int*)user_data;
+    (void)request;
+    (void)status;
+    
+    __atomic_store_n(stage, 1, __ATOMIC_RELEASE);
+    usleep(100000);
+    __atomic_store_n(stage, 2, __ATOMIC_RELEASE);
+}
+
+TEST(op_free_during_fail) {
+    remoteio_context_t* ctx = remoteio_context_create(g_ctx);
+    ASSERT_NOT_NULL(ctx);
+    
+    g_peer_mode = PEER_HANG_UP;
+    remoteio_connection_t* conn = proto_connect(ctx, g_peer_port);
+    ASSERT_NOT_NULL(conn);
+    
+    char buf[4096];
+    volatile int stage = 0;
+    remoteio_operation_t* op = remoteio_op_alloc(ctx);
+    ASSERT_NOT_NULL(op);
+    op->op = REMOTEIO_OP_READ;
+    op->conn = conn;
+    snprintf(op->resource, sizeof(op->resource), "mem");
+    op->local_buf = buf;
+    op->length = sizeof(buf);
+    op->callback = slow_callback;
+    op->user_data = (void*)&stage;
+    ASSERT_EQ(remoteio_op_submit(ctx, op), 0);
+    
+    /* Freed while the reactor is failing it: the free waits until the
+     * reactor is done with the op */
+    for (int i = 0; i < 1000 && __atomic_load_n(&stage, __ATOMIC_ACQUIRE) == 0; i++) {
+        usleep(1000);
+    }
+    ASSERT_EQ(__atomic_load_n(&stage, __ATOMIC_ACQUIRE), 1);
+    remoteio_op_free(ctx, op);
+    ASSERT_EQ(__atomic_load_n(&stage, __ATOMIC_ACQUIRE), 2);
+    
+    remoteio_conn_release(conn);
+    remoteio_context_destroy(ctx);
+}
+
+/* ============================================================================
+ * Server Tests
+ * ============================================================================ */
+
+TEST(server_memory_rw) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    
+    remoteio_server_stats_t before, after;
+    remoteio_server_get_stats(g_server, &before);
+    
+    char uri[128];
+    snprintf(uri, sizeof(uri), "tcp://127.0.0.1:%d/mem", g_server->port);
+    
+    size_t len = 3 * REMOTEIO_PROTO_CHUNK + 17;
+    char* out = malloc(len);
+    char* in = calloc(1, len);
+    ASSERT_NOT_NULL(out);
+    ASSERT_NOT_NULL(in);
+    for (size_t i = 0; i < len; i++) out[i] = (char)(i * 5 + 2);
+    
+    ASSERT_EQ(remoteio_write(ctx, uri, out, len, 777), 0);
+    ASSERT_EQ(memcmp(g_store + 777, out, len), 0);
+    ASSERT_EQ(remoteio_read(ctx, uri, in, len, 777), 0);
+    ASSERT_EQ(memcmp(in, out, len), 0);
+    
+    /* Past the end of the export and unknown resources fail */
+    remoteio_connection_t* conn = proto_connect(ctx, g_server->port);
+    ASSERT_NOT_NULL(conn);
+    ASSERT_NE(named_op(ctx, conn, REMOTEIO_OP_READ, "mem", in, STORE_SIZE - 10, 20), 0);
+    ASSERT_NE(named_op(ctx, conn, REMOTEIO_OP_READ, "nosuch", in, 0, 20), 0);
+    ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_READ, "mem", in, 777, 100), 0);
+    remoteio_conn_release(conn);
+    
+    server_stats_wait(g_server, before.bytes_read + len + 100,
+                      before.bytes_written + len, before.errors + 2, &after);
+    ASSERT(after.clients_accepted > before.clients_accepted);
+    ASSERT_EQ(after.bytes_written - before.bytes_written, len);
+    ASSERT_EQ(after.bytes_read - before.bytes_read, len + 100);
+    
+    /* Each op counts once, however many chunks it took */
+    ASSERT_EQ(after.writes - before.writes, 1);
+    ASSERT_EQ(after.reads - before.reads, 2);
+    ASSERT_EQ(after.errors - before.errors, 2);
+    
+    free(out);
+    free(in);
+    remoteio_context_destroy(ctx);
+}
+
+TEST(server_dir_export) {
+    char dir[] = "/tmp/gpuio_test_remoteio_XXXXXX";
+    ASSERT_NOT_NULL(mkdtemp(dir));
+    char path[128];
+    snprintf(path, sizeof(path), "%s/data.bin", dir);
+    FILE* f = fopen(path, "w");
+    ASSERT_NOT_NULL(f);
+    for (int i = 0; i < 100000; i++) fputc((char)(i * 3), f);
+    fclose(f);
+    
+    ASSERT_EQ(remoteio_server_export_dir(g_server, "dir", dir, true), 0);
+    ASSERT_EQ(remoteio_server_export_dir(g_server, "rodir", dir, false), 0);
+    
+    remoteio_context_t* ctx = remoteio_context_create(g_ctx);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_connection_t* conn = proto_connect(ctx, g_server->port);
+    ASSERT_NOT_NULL(conn);
+    
+    /* Whole file from the mapping, then a write through the export */
+    char buf[100000];
+    ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_READ, "dir/data.bin", buf, 0, sizeof(buf)), 0);
+    for (int i = 0; i < 100000; i++) ASSERT_EQ(buf[i], (char)(i * 3));
+    
+    memset(buf, 0x5A, 5000);
+    ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_WRITE, "dir/data.bin", buf, 1000, 5000), 0);
+    memset(buf, 0, 5000);
+    ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_READ, "rodir/data.bin", buf, 1000, 5000), 0);
+    for (int i = 0; i < 5000; i++) ASSERT_EQ(buf[i], 0x5A);
+    
+    /* Read-only exports and paths escaping the export are refused */
+    ASSERT_NE(named_op(ctx, conn, REMOTEIO_OP_WRITE, "rodir/data.bin", buf, 0, 10), 0);
+    ASSERT_NE(named_op(ctx, conn, REMOTEIO_OP_READ, "dir/../data.bin", buf, 0, 10), 0);
+    
+    remoteio_conn_release(conn);
+    remoteio_context_destroy(ctx);
+    unlink(path);
+    rmdir(dir);
+}
+
+TEST(server_queue_depth) {
+    /* A queue depth of one throttles a client on its first frame */
+    remoteio_server_t* server;
+    ASSERT_EQ(remoteio_server_create(g_server_ctx, 2, 1, &server), 0);
+    ASSERT_EQ(remoteio_server_export_memory(server, "mem", g_store, STORE_SIZE, true), 0);
+    ASSERT_EQ(remoteio_server_start(server, 0), 0);
+    
+    remoteio_context_t* ctx = remoteio_context_create(g_ctx);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_connection_t* conn = proto_connect(ctx, server->port);
+    ASSERT_NOT_NULL(conn);
+    
+    enum { NUM_OPS = 8, OP_LEN = 2 * REMOTEIO_PROTO_CHUNK };
+    static char bufs[NUM_OPS][OP_LEN];
+    remoteio_operation_t* ops[NUM_OPS];
+    for (int i = 0; i < NUM_OPS; i++) {
+        memset(bufs[i], i + 1, OP_LEN);
+        ops[i] = named_submit(ctx, conn, REMOTEIO_OP_WRITE, "mem", bufs[i],
+                              (uint64_t)i * OP_LEN, OP_LEN);
+        ASSERT_NOT_NULL(ops[i]);
+    }
+    for (int i = 0; i < NUM_OPS; i++) {
+        ASSERT_EQ(remoteio_op_wait(ops[i], WAIT_US), 0);
+        ASSERT_EQ(ops[i]->bytes_transferred, OP_LEN);
+        remoteio_op_free(ctx, ops[i]);
+    }
+    for (int i = 0; i < NUM_OPS; i++) {
+        ASSERT_EQ(memcmp(g_store + (size_t)i * OP_LEN, bufs[i], OP_LEN), 0);
+    }
+    
+    remoteio_server_stats_t stats;
+    server_stats_wait(server, 0, (uint64_t)NUM_OPS * OP_LEN, 0, &stats);
+    ASSERT(stats.throttled > 0);
+    ASSERT_EQ(stats.bytes_written, (uint64_t)NUM_OPS * OP_LEN);
+    
+    remoteio_conn_release(conn);
+    remoteio_context_destroy(ctx);
+    remoteio_server_destroy(server);
+}
+
+/* ============================================================================
+ * Connection Pool Tests
+ * ============================================================================ */
+
+TEST(pool_hash_lookup) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_conn_pool_t* pool = &ctx->conn_pool;
+    
+    /* Two peers, each connected once and then found again */
+    remoteio_connection_t *server, *peer, *again;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &server), 0);
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_peer_port, &peer), 0);
+    ASSERT(server != peer);
+    uint64_t hits = pool->hits;
+    
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &again), 0);
+    ASSERT(again == server);
+    remoteio_disconnect(ctx, again);
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_peer_port, &again), 0);
+    ASSERT(again == peer);
+    remoteio_disconnect(ctx, again);
+    ASSERT_EQ(pool->hits, hits + 2);
+    ASSERT_EQ(pool->num_connections, 2);
+    
+    /* Callers' references come back; the pool keeps its own */
+    remoteio_disconnect(ctx, server);
+    remoteio_disconnect(ctx, peer);
+    ASSERT_EQ(server->ref_count, 1);
+    char buf[1000];
+    ASSERT_EQ(named_op(ctx, server, REMOTEIO_OP_READ, "mem", buf, 0, sizeof(buf)), 0);
+    
+    remoteio_context_destroy(ctx);
+}
+
+TEST(pool_idle_eviction) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_conn_pool_t* pool = &ctx->conn_pool;
+    pthread_mutex_lock(&pool->lock);
+    pool->idle_timeout_us = 100000;
+    pthread_mutex_unlock(&pool->lock);
+    
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    
+    /* Not while someone holds it */
+    usleep(1500000);
+    pthread_mutex_lock(&pool->lock);
+    uint64_t closed = pool->idle_closed;
+    pthread_mutex_unlock(&pool->lock);
+    ASSERT_EQ(closed, 0);
+    remoteio_disconnect(ctx, conn);
+    
+    ASSERT(pool_wait(pool, &pool->idle_closed, 1));
+    pthread_mutex_lock(&pool->lock);
+    int left = pool->num_connections;
+    uint64_t misses = pool->misses;
+    pthread_mutex_unlock(&pool->lock);
+    ASSERT_EQ(left, 0);
+    
+    /* The next call connects afresh */
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    ASSERT_EQ(pool->misses, misses + 1);
+    char buf[1000];
+    ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_READ, "mem", buf, 0, sizeof(buf)), 0);
+    remoteio_disconnect(ctx, conn);
+    
+    remoteio_context_destroy(ctx);
+}
+
+TEST(pool_health_check) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_conn_pool_t* pool = &ctx->conn_pool;
+    pthread_mutex_lock(&pool->lock);
+    pool->health_interval_us = 100000;
+    pthread_mutex_unlock(&pool->lock);
+    
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    remoteio_disconnect(ctx, conn);
+    
+    /* A quiet connection is pinged, answered and kept */
+    ASSERT(pool_wait(pool, &pool->health_checks, 2));
+    ASSERT_EQ(pool->health_failures, 0);
+    remoteio_connection_t* again;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &again), 0);
+    ASSERT(again == conn);
+    remoteio_disconnect(ctx, again);
+    
+    remoteio_context_destroy(ctx);
+}
+
+/* A peer that completes the HELLO and then never answers anything */
+typedef struct {
+    int listen_fd;
+    int fds[2];
+} mute_peer_t;
+
+static void* mute_peer_thread(void* arg) {
+    mute_peer_t* peer = (mute_peer_t*)arg;
+    
+    for (int i = 0; i < 2; i++) {
+        int fd = accept(peer->listen_fd, NULL, NULL);
+        if (fd < 0) break;
+        peer->fds[i] = fd;
+    
+        uint8_t raw[REMOTEIO_MSG_HDR_SIZE];
+        remoteio_msg_hdr_t hdr;
+        if (recv(fd, raw, sizeof(raw), MSG_WAITALL) != (ssize_t)sizeof(raw) ||
+            remoteio_msg_decode(raw, &hdr) != 0 || hdr.type != REMOTEIO_MSG_HELLO) {
+            break;
+        }
+        remoteio_msg_hdr_t ack = { .type = REMOTEIO_MSG_HELLO_ACK, .flags = REMOTEIO_MSG_F_LAST };
+        remoteio_msg_encode(&ack, raw);
+        if (send(fd, raw, sizeof(raw), MSG_NOSIGNAL) != (ssize_t)sizeof(raw)) break;
+    }
+    return NULL;
+}
+
+TEST(pool_reconnect_dead) {
+    mute_peer_t peer = { .listen_fd = socket(AF_INET, SOCK_STREAM, 0), .fds = { -1, -1 } };
+    ASSERT(peer.listen_fd >= 0);
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addr_len = sizeof(addr);
+    ASSERT_EQ(bind(peer.listen_fd, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(peer.listen_fd, 4), 0);
+    ASSERT_EQ(getsockname(peer.listen_fd, (struct sockaddr*)&addr, &addr_len), 0);
+    uint16_t port = ntohs(addr.sin_port);
+    pthread_t thread;
+    ASSERT_EQ(pthread_create(&thread, NULL, mute_peer_thread, &peer), 0);
+    
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_conn_pool_t* pool = &ctx->conn_pool;
+    pthread_mutex_lock(&pool->lock);
+    pool->health_interval_us = 100000;
+    pthread_mutex_unlock(&pool->lock);
+    
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", port, &conn), 0);
+    remoteio_disconnect(ctx, conn);
+    
+    /* The unanswered PING fails the connection and evicts it */
+    ASSERT(pool_wait(pool, &pool->health_failures, 1));
+    pthread_mutex_lock(&pool->lock);
+    int left = pool->num_connections;
+    pthread_mutex_unlock(&pool->lock);
+    ASSERT_EQ(left, 0);
+    
+    /* So the next call reconnects instead of reusing it */
+    remoteio_connection_t* again;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", port, &again), 0);
+    pthread_mutex_lock(&again->lock);
+    bool live = again->state == REMOTEIO_CONN_CONNECTED;
+    pthread_mutex_unlock(&again->lock);
+    ASSERT(live);
+    remoteio_disconnect(ctx, again);
+    remoteio_context_destroy(ctx);
+    
+    pthread_join(thread, NULL);
+    close(peer.listen_fd);
+    for (int i = 0; i < 2; i++) {
+        if (peer.fds[i] >= 0) close(peer.fds[i]);
+    }
+}
+
+/* ============================================================================
+ * Op Slab Tests
+ * ============================================================================ */
+
+static bool op_in_slab(remoteio_context_t* ctx, remoteio_operation_t* op) {
+    return op >= ctx->op_slab && op < ctx->op_slab + ctx->op_slab_size;
+}
+
+TEST(op_slab_exhaustion) {
+    remoteio_context_t* ctx = remoteio_context_create(g_ctx);
+    ASSERT_NOT_NULL(ctx);
+    uint32_t size = ctx->op_slab_size;
+    remoteio_operation_t** ops = calloc(size + 1, sizeof(*ops));
+    ASSERT_NOT_NULL(ops);
+    
+    /* Every slab op once, with distinct ids, then one from the heap */
+    for (uint32_t i = 0; i < size; i++) {
+        ops[i] = remoteio_op_alloc(ctx);
+        ASSERT_NOT_NULL(ops[i]);
+        ASSERT(op_in_slab(ctx, ops[i]));
+        ASSERT(i == 0 || ops[i]->id != ops[i - 1]->id);
+    }
+    ops[size] = remoteio_op_alloc(ctx);
+    ASSERT_NOT_NULL(ops[size]);
+    ASSERT(!op_in_slab(ctx, ops[size]));
+    ASSERT_EQ(ctx->op_heap_allocs, 1);
+    
+    for (uint32_t i = 0; i <= size; i++) remoteio_op_free(ctx, ops[i]);
+    
+    /* Freed ops go back to the slab, so there is room again */
+    for (uint32_t i = 0; i < size; i++) {
+        ops[i] = remoteio_op_alloc(ctx);
+        ASSERT_NOT_NULL(ops[i]);
+        ASSERT(op_in_slab(ctx, ops[i]));
+    }
+    for (uint32_t i = 0; i < size; i++) remoteio_op_free(ctx, ops[i]);
+    ASSERT_EQ(ctx->op_heap_allocs, 1);
+    
+    free(ops);
+    remoteio_context_destroy(ctx);
+}
+
+typedef struct {
+    remoteio_context_t* ctx;
+    int rounds;
+    int errors;
+} op_churn_arg_t;
+
+/* Allocate and free in bursts; a held op must never be handed out twice */
+static void* op_churn_run(void* arg) {
+    op_churn_arg_t* a = (op_churn_arg_t*)arg;
+    remoteio_operation_t* held[40];
+    
+    for (int round = 0; round < a->rounds; round++) {
+        int n = 1 + round % 40;
+        for (int i = 0; i < n; i++) {
+            held[i] = remoteio_op_alloc(a->ctx);
+            if (!held[i] || held[i]->user_data) a->errors++;
+            if (held[i]) held[i]->user_data = a;
+        }
+        for (int i = 0; i < n; i++) {
+            if (!held[i]) continue;
+            if (held[i]->user_data != a) a->errors++;
+            held[i]->user_data = NULL;
+            remoteio_op_free(a->ctx, held[i]);
+        }
+    }
+    return NULL;
+}
+
+TEST(op_slab_threads) {
+    enum { THREADS = 4 };
+    remoteio_context_t* ctx = remoteio_context_create(g_ctx);
+    ASSERT_NOT_NULL(ctx);
+    
+    pthread_t threads[THREADS];
+    op_churn_arg_t args[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        args[i] = (op_churn_arg_t){ .ctx = ctx, .rounds = 5000 };
+        ASSERT_EQ(pthread_create(&threads[i], NULL, op_churn_run, &args[i]), 0);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        ASSERT_EQ(args[i].errors, 0);
+    }
+    
+    /* 4 x 40 held at most, well inside the slab */
+    ASSERT_EQ(ctx->op_heap_allocs, 0);
+    remoteio_context_destroy(ctx);
+}
+
+TEST(op_cache_per_context) {
+    enum { CONTEXTS = 5, ROUNDS = 2000 };
+    remoteio_context_t* ctxs[CONTEXTS];
+    
+    /* More contexts than the thread keeps caches for */
+    for (int i = 0; i < CONTEXTS; i++) {
+        ctxs[i] = remoteio_context_create(g_ctx);
+        ASSERT_NOT_NULL(ctxs[i]);
+    }
+    
+    for (int round = 0; round < ROUNDS; round++) {
+        int n = round % 7 < 5 ? 2 : CONTEXTS;
+        remoteio_operation_t* ops[CONTEXTS];
+        for (int i = 0; i < n; i++) {
+            ops[i] = remoteio_op_alloc(ctxs[i]);
+            ASSERT_NOT_NULL(ops[i]);
+            ASSERT(op_in_slab(ctxs[i], ops[i]));
+        }
+        for (int i = 0; i < n; i++) remoteio_op_free(ctxs[i], ops[i]);
+    }
+    
+    /* A destroyed context's cache is dropped; the others keep working */
+    remoteio_context_destroy(ctxs[0]);
+    for (int i = 1; i < CONTEXTS; i++) {
+        remoteio_operation_t* op = remoteio_op_alloc(ctxs[i]);
+        ASSERT_NOT_NULL(op);
+        ASSERT(op_in_slab(ctxs[i], op));
+        remoteio_op_free(ctxs[i], op);
+        ASSERT_EQ(ctxs[i]->op_heap_allocs, 0);
+        remoteio_context_destroy(ctxs[i]);
+    }
+}
+
+/* What a completion callback saw of its op */
+typedef struct {
+    remoteio_operation_t* op;
+    int calls;
+    int completed;
+    gpuio_error_t status;
+} op_callback_t;
+
+static void op_callback(gpuio_request_t request, gpuio_error_t status, void* user_data) {
+    op_callback_t* cb = (op_callback_t*)user_data;
+    remoteio_operation_t* op = (remoteio_operation_t*)request;
+    
+    cb->calls++;
+    cb->completed = op == cb->op ? op->completed : -1;
+    cb->status = status;
+}
+
+TEST(op_callback_before_wait) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    
+    char buf[1000];
+    op_callback_t cb = { 0 };
+    remoteio_operation_t* op = remoteio_op_alloc(ctx);
+    ASSERT_NOT_NULL(op);
+    op->op = REMOTEIO_OP_READ;
+    op->conn = conn;
+    snprintf(op->resource, sizeof(op->resource), "mem");
+    op->local_buf = buf;
+    op->length = sizeof(buf);
+    op->callback = op_callback;
+    op->user_data = &cb;
+    cb.op = op;
+    
+    /* The callback runs while the op is still the waiter's to free */
+    ASSERT_EQ(remoteio_op_submit(ctx, op), 0);
+    ASSERT_EQ(remoteio_op_wait(op, WAIT_US), 0);
+    remoteio_op_free(ctx, op);
+    ASSERT_EQ(cb.calls, 1);
+    ASSERT_EQ(cb.completed, 0);
+    ASSERT_EQ(cb.status, GPUIO_SUCCESS);
+    
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+}
+
+/* ============================================================================
+ * Wire Compression Tests
+ * ============================================================================ */
+
+/* Bytes LZ4 can't shrink */
+static void fill_random(char* buf, size_t len, uint32_t seed) {
+    uint32_t x = seed | 1;
+    for (size_t i = 0; i < len; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        buf[i] = (char)x;
+    }
+}
+
+TEST(compression_negotiation) {
+    remoteio_server_stats_t before, after;
+    remoteio_server_get_stats(g_server, &before);
+    
+    /* Asked for and granted */
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    ctx->use_compression = 1;
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    ASSERT(conn->caps & REMOTEIO_CAP_LZ4);
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+    
+    /* Not asked for */
+    ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    ASSERT(!(conn->caps & REMOTEIO_CAP_LZ4));
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+    
+    /* Never over shared memory, where it only costs */
+    ctx = client_create(REMOTEIO_TRANSPORT_SHM);
+    ASSERT_NOT_NULL(ctx);
+    ctx->use_compression = 1;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    ASSERT_EQ(conn->transport, REMOTEIO_TRANSPORT_SHM);
+    ASSERT(!(conn->caps & REMOTEIO_CAP_LZ4));
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+    
+    remoteio_server_get_stats(g_server, &after);
+    ASSERT_EQ(after.compressed_clients, before.compressed_clients + 1);
+}
+
+TEST(compression_skips_incompressible) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    ctx->use_compression = 1;
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    ASSERT(conn->caps & REMOTEIO_CAP_LZ4);
+    
+    size_t len = REMOTEIO_PROTO_CHUNK;
+    char* buf = malloc(len);
+    char* in = malloc(len);
+    ASSERT(buf && in);
+    remoteio_compress_stats_t stats;
+    
+    /* Random throughout: the sample already fails */
+    fill_random(buf, len, 7);
+    ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_WRITE, "mem", buf, 0, len), 0);
+    ASSERT_EQ(memcmp(g_store, buf, len), 0);
+    remoteio_conn_get_compress_stats(conn, &stats, NULL);
+    ASSERT_EQ(stats.chunks_skipped, 1);
+    ASSERT_EQ(stats.chunks_compressed, 0);
+    
+    /* A compressible sample in front of random data: the chunk fails */
+    memset(buf, 0, REMOTEIO_COMPRESS_SAMPLE);
+    ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_WRITE, "mem", buf, 0, len), 0);
+    ASSERT_EQ(memcmp(g_store, buf, len), 0);
+    remoteio_conn_get_compress_stats(conn, &stats, NULL);
+    ASSERT_EQ(stats.chunks_skipped, 2);
+    ASSERT_EQ(stats.chunks_compressed, 0);
+    ASSERT_EQ(stats.wire_bytes, 0);
+    
+    /* Reading it back comes raw too */
+    ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_READ, "mem", in, 0, len), 0);
+    ASSERT_EQ(memcmp(in, buf, len), 0);
+    remoteio_conn_get_compress_stats(conn, &stats, NULL);
+    ASSERT_EQ(stats.chunks_decompressed, 0);
+    
+    free(buf);
+    free(in);
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+}
+
+TEST(compression_stats_per_connection) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    ctx->use_compression = 1;
+    remoteio_connection_t *conn, *other;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    ASSERT_EQ(remoteio_connect_stream(ctx, "127.0.0.1", (uint16_t)g_server->port, 1, &other), 0);
+    ASSERT(conn != other);
+    
+    size_t len = 2 * REMOTEIO_PROTO_CHUNK;
+    char* buf = malloc(len);
+    char* in = malloc(len);
+    ASSERT(buf && in);
+    for (size_t i = 0; i < len; i++) buf[i] = (char)(i % 251 < 200 ? 0 : i);
+    
+    ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_WRITE, "mem", buf, 0, len), 0);
+    ASSERT_EQ(memcmp(g_store, buf, len), 0);
+    ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_READ, "mem", in, 0, len), 0);
+    ASSERT_EQ(memcmp(in, buf, len), 0);
+    
+    /* Both chunks went out compressed, and came back that way */
+    remoteio_compress_stats_t stats;
+    double ratio;
+    remoteio_conn_get_compress_stats(conn, &stats, &ratio);
+    ASSERT_EQ(stats.chunks_compressed, 2);
+    ASSERT_EQ(stats.chunks_skipped, 0);
+    ASSERT_EQ(stats.raw_bytes, len);
+    ASSERT(stats.wire_bytes > 0 && stats.wire_bytes < len / 4);
+    ASSERT(stats.compress_ns > 0);
+    ASSERT_EQ(stats.chunks_decompressed, 2);
+    ASSERT(ratio > 4.0);
+    
+    /* The other connection to the same server counted none of it */
+    remoteio_conn_get_compress_stats(other, &stats, &ratio);
+    ASSERT_EQ(stats.chunks_compressed, 0);
+    ASSERT_EQ(stats.wire_bytes, 0);
+    ASSERT_EQ(stats.compress_ns, 0);
+    ASSERT_EQ(stats.chunks_decompressed, 0);
+    ASSERT(ratio == 1.0);
+    
+    free(buf);
+    free(in);
+    remoteio_disconnect(ctx, other);
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+}
+
+/* ============================================================================
+ * Zero-Copy Tests
+ * ============================================================================ */
+
+TEST(zerocopy_release_order) {
+    remoteio_connection_t* conn = calloc(1, sizeof(*conn));
+    ASSERT_NOT_NULL(conn);
+    
+    /* Ranges past a gap are held until the gap is released */
+    remoteio_network_zc_release(conn, 2, 3);
+    ASSERT_EQ(conn->zc_acked, 0);
+    remoteio_network_zc_release(conn, 5, 5);
+    ASSERT_EQ(conn->zc_acked, 0);
+    remoteio_network_zc_release(conn, 0, 0);
+    ASSERT_EQ(conn->zc_acked, 1);
+    remoteio_network_zc_release(conn, 1, 1);
+    ASSERT_EQ(conn->zc_acked, 4);
+    remoteio_network_zc_release(conn, 0, 2);
+    ASSERT_EQ(conn->zc_acked, 4);
+    remoteio_network_zc_release(conn, 4, 4);
+    ASSERT_EQ(conn->zc_acked, 6);
+    ASSERT_EQ(conn->zc_num_done, 0);
+    
+    /* The call counter wraps */
+    conn->zc_acked = UINT32_MAX - 1;
+    remoteio_network_zc_release(conn, 0, 1);
+    ASSERT_EQ(conn->zc_acked, UINT32_MAX - 1);
+    remoteio_network_zc_release(conn, UINT32_MAX - 1, UINT32_MAX);
+    ASSERT_EQ(conn->zc_acked, 2);
+    ASSERT_EQ(conn->zc_num_done, 0);
+    
+    free(conn->zc_done);
+    free(conn);
+}
+
+/* True once the kernel released every zero-copy send on conn */
+static bool zc_settled(remoteio_connection_t* conn) {
+    remoteio_network_zc_drain(conn);
+    pthread_mutex_lock(&conn->lock);
+    bool settled = conn->zc_acked == conn->zc_sent && conn->zc_num_done == 0;
+    pthread_mutex_unlock(&conn->lock);
+    return settled;
+}
+
+TEST(zerocopy_write_and_read) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    ASSERT(conn->zc_enabled);
+    
+    remoteio_server_stats_t before, after;
+    remoteio_server_get_stats(g_server, &before);
+    
+    /* Large chunks go out zero-copy both ways */
+    size_t len = 2 * REMOTEIO_PROTO_CHUNK + 3 * REMOTEIO_ZEROCOPY_THRESHOLD;
+    ASSERT_EQ(named_round_trip(ctx, conn, 0, len, 7), 0);
+    ASSERT(conn->zc_sent > 0);
+    ASSERT(zc_settled(conn));
+    
+    /* Counted once the last chunk went out, which may be after it arrived */
+    for (int i = 0; i < 100; i++) {
+        remoteio_server_get_stats(g_server, &after);
+        if (after.zerocopy_bytes > before.zerocopy_bytes) break;
+        usleep(10000);
+    }
+    ASSERT_EQ(after.zerocopy_bytes, before.zerocopy_bytes + len);
+    
+    /* The server only counts the read once the kernel released its memory */
+    bool settled = true;
+    pthread_mutex_lock(&g_server->lock);
+    for (remoteio_server_client_t* c = g_server->clients; c; c = c->next) {
+        if (!zc_settled(c->conn)) settled = false;
+    }
+    pthread_mutex_unlock(&g_server->lock);
+    ASSERT(settled);
+    
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+}
+
+TEST(reactor_drains_error_queue) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    ASSERT(conn->zc_enabled);
+    
+    /* A zero-copy frame nobody waits on; the PONG matches no op */
+    remoteio_msg_hdr_t ping = {
+        .type = REMOTEIO_MSG_PING,
+        .flags = REMOTEIO_MSG_F_LAST,
+        .req_id = UINT64_MAX,
+    };
+    uint8_t raw[REMOTEIO_MSG_HDR_SIZE];
+    remoteio_msg_encode(&ping, raw);
+    ASSERT(remoteio_network_send_zerocopy(conn, raw, sizeof(raw)) > 0);
+    
+    /* The reactor reads the completion off the error queue... */
+    bool settled = false;
+    for (int i = 0; i < 100 && !settled; i++) {
+        pthread_mutex_lock(&conn->lock);
+        settled = conn->zc_acked == conn->zc_sent;
+        pthread_mutex_unlock(&conn->lock);
+        if (!settled) usleep(10000);
+    }
+    ASSERT(settled);
+    
+    /* ...so the level-triggered EPOLLERR doesn't keep waking it */
+    pthread_mutex_lock(&ctx->reactor.lock);
+    uint64_t before = ctx->reactor.rx_events;
+    pthread_mutex_unlock(&ctx->reactor.lock);
+    usleep(100000);
+    pthread_mutex_lock(&ctx->reactor.lock);
+    uint64_t after = ctx->reactor.rx_events;
+    pthread_mutex_unlock(&ctx->reactor.lock);
+    ASSERT(after - before < 10);
+    
+    ASSERT_EQ(named_round_trip(ctx, conn, 0, 4096, 8), 0);
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+}
+
+TEST(sendfile_read) {
+    char dir[] = "/tmp/gpuio_test_remoteio_XXXXXX";
+    ASSERT_NOT_NULL(mkdtemp(dir));
+    char path[128];
+    snprintf(path, sizeof(path), "%s/big.bin", dir);
+    
+    size_t len = REMOTEIO_PROTO_CHUNK + 12345;
+    char* data = malloc(len);
+    char* buf = malloc(len);
+    ASSERT_NOT_NULL(data);
+    ASSERT_NOT_NULL(buf);
+    for (size_t i = 0; i < len; i++) data[i] = (char)(i * 11 + 3);
+    FILE* f = fopen(path, "w");
+    ASSERT_NOT_NULL(f);
+    ASSERT_EQ(fwrite(data, 1, len, f), len);
+    fclose(f);
+    
+    ASSERT_EQ(remoteio_server_export_dir(g_server, "big", dir, false), 0);
+    
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    
+    remoteio_server_stats_t before, after;
+    remoteio_server_get_stats(g_server, &before);
+    
+    /* File reads leave the page cache with sendfile(), chunk by chunk */
+    ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_READ, "big/big.bin", buf, 0, len), 0);
+    ASSERT_EQ(memcmp(buf, data, len), 0);
+    ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_READ, "big/big.bin", buf, 100, 1000), 0);
+    ASSERT_EQ(memcmp(buf, data + 100, 1000), 0);
+    
+    for (int i = 0; i < 100; i++) {
+        remoteio_server_get_stats(g_server, &after);
+        if (after.sendfile_bytes == before.sendfile_bytes + len + 1000) break;
+        usleep(10000);
+    }
+    ASSERT_EQ(after.sendfile_bytes, before.sendfile_bytes + len + 1000);
+    ASSERT_EQ(after.zerocopy_bytes, before.zerocopy_bytes);
+    
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+    free(data);
+    free(buf);
+    unlink(path);
+    rmdir(dir);
+}
+
+/* ============================================================================
+ * Striping Tests
+ * ============================================================================ */
+
+TEST(stripe_hill_climb) {
+    remoteio_context_t* ctx = remoteio_context_create(g_ctx);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_conn_pool_t* pool = &ctx->conn_pool;
+    const char* host = "192.0.2.1";
+    uint64_t mb = 1 << 20;
+    
+    /* A new peer starts on one stream and probes a second at once */
+    ASSERT_EQ(remoteio_conn_pool_stripe_width(pool, host, 9), 1);
+    remoteio_conn_pool_stripe_update(pool, host, 9, 1, 1, 8 * mb, 1000);
+    ASSERT_EQ(remoteio_conn_pool_stripe_width(pool, host, 9), 2);
+    ASSERT_EQ(pool->stripe_probes, 1);
+    
+    /* A transfer planned before the change says nothing about it */
+    remoteio_conn_pool_stripe_update(pool, host, 9, 1, 1, 8 * mb, 100);
+    ASSERT_EQ(remoteio_conn_pool_stripe_width(pool, host, 9), 2);
+    
+    /* Widening that pays off is kept and widens again */
+    remoteio_conn_pool_stripe_update(pool, host, 9, 2, 2, 8 * mb, 500);
+    ASSERT_EQ(remoteio_conn_pool_stripe_width(pool, host, 9), 3);
+    ASSERT_EQ(pool->striped_transfers, 1);
+    
+    /* Less than a 10% gain reverts, and the next probe narrows */
+    remoteio_conn_pool_stripe_update(pool, host, 9, 3, 3, 8 * mb, 480);
+    ASSERT_EQ(remoteio_conn_pool_stripe_width(pool, host, 9), 2);
+    for (int i = 0; i < REMOTEIO_STRIPE_PROBE_EVERY - 1; i++) {
+        remoteio_conn_pool_stripe_update(pool, host, 9, 2, 2, 8 * mb, 500);
+        ASSERT_EQ(remoteio_conn_pool_stripe_width(pool, host, 9), 2);
+    }
+    remoteio_conn_pool_stripe_update(pool, host, 9, 2, 2, 8 * mb, 500);
+    ASSERT_EQ(remoteio_conn_pool_stripe_width(pool, host, 9), 1);
+    ASSERT_EQ(pool->stripe_probes, 3);
+    
+    /* Narrowing that loses more than 10% goes back */
+    remoteio_conn_pool_stripe_update(pool, host, 9, 1, 1, 8 * mb, 1000);
+    ASSERT_EQ(remoteio_conn_pool_stripe_width(pool, host, 9), 2);
+    
+    /* Getting fewer streams than asked for caps the width */
+    remoteio_conn_pool_stripe_update(pool, host, 9, 2, 1, 8 * mb, 500);
+    ASSERT_EQ(remoteio_conn_pool_stripe_width(pool, host, 9), 1);
+    
+    /* max_connections bounds the width */
+    pthread_mutex_lock(&pool->lock);
+    pool->max_connections = 2;
+    pthread_mutex_unlock(&pool->lock);
+    const char* other = "192.0.2.2";
+    ASSERT_EQ(remoteio_conn_pool_stripe_width(pool, other, 9), 1);
+    remoteio_conn_pool_stripe_update(pool, other, 9, 1, 1, 8 * mb, 1000);
+    remoteio_conn_pool_stripe_update(pool, other, 9, 2, 2, 8 * mb, 100);
+    ASSERT_EQ(remoteio_conn_pool_stripe_width(pool, other, 9), 2);
+    
+    remoteio_context_destroy(ctx);
+}
+
+TEST(stripe_uri_transfer) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_conn_pool_t* pool = &ctx->conn_pool;
+    uint16_t port = (uint16_t)g_server->port;
+    
+    char uri[128];
+    snprintf(uri, sizeof(uri), "tcp://127.0.0.1:%d/mem", g_server->port);
+    char* buf = malloc(STORE_SIZE);
+    ASSERT_NOT_NULL(buf);
+    for (int i = 0; i < STORE_SIZE; i++) buf[i] = (char)(i * 3 + 1);
+    
+    /* The first large transfer runs on one stream and probes two */
+    ASSERT_EQ(remoteio_write(ctx, uri, buf, STORE_SIZE, 0), 0);
+    ASSERT_EQ(memcmp(g_store, buf, STORE_SIZE), 0);
+    ASSERT_EQ(remoteio_conn_pool_stripe_width(pool, "127.0.0.1", port), 2);
+    ASSERT_EQ(pool->striped_transfers, 0);
+    ASSERT_EQ(pool->num_connections, 1);
+    
+    /* The second is split across both, in place */
+    memset(buf, 0, STORE_SIZE);
+    ASSERT_EQ(remoteio_read(ctx, uri, buf, STORE_SIZE, 0), 0);
+    ASSERT_EQ(memcmp(g_store, buf, STORE_SIZE), 0);
+    ASSERT_EQ(pool->striped_transfers, 1);
+    ASSERT_EQ(pool->num_connections, 2);
+    
+    /* Judged against one stream: widened again or reverted */
+    int width = remoteio_conn_pool_stripe_width(pool, "127.0.0.1", port);
+    ASSERT((width == 3 && pool->stripe_probes == 2) ||
+           (width == 1 && pool->stripe_probes == 1));
+    
+    free(buf);
+    remoteio_context_destroy(ctx);
+}
+
+/* The one stripe peer a fresh context has recorded */
+static remoteio_stripe_peer_t* stripe_only_peer(remoteio_conn_pool_t* pool) {
+    for (int b = 0; b < REMOTEIO_POOL_BUCKETS; b++) {
+        if (pool->stripe_peers[b]) return pool->stripe_peers[b];
+    }
+    return NULL;
+}
+
+TEST(stripe_time_across_second) {
+    /* A transfer whose clock readings straddle a second boundary has
+     * t1.tv_nsec < t0.tv_nsec; its throughput must still be measured right */
+    char uri[128];
+    snprintf(uri, sizeof(uri), "tcp://127.0.0.1:%d/mem", g_server->port);
+    char* buf = malloc(STORE_SIZE);
+    ASSERT_NOT_NULL(buf);
+    memset(buf, 0x5a, STORE_SIZE);
+    
+    int straddled = 0;
+    for (int attempt = 0; attempt < 5 && straddled < 2; attempt++) {
+        remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+        ASSERT_NOT_NULL(ctx);
+        
+        /* Connect and pick a route first; too small to be striped */
+        ASSERT_EQ(remoteio_write(ctx, uri, buf, 4096, 0), 0);
+        
+        /* Start just before the next second */
+        struct timespec t0, t1;
+        do {
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            if (t0.tv_nsec < 990000000L) usleep(1000);
+        } while (t0.tv_nsec < 999800000L);
+        
+        ASSERT_EQ(remoteio_write(ctx, uri, buf, STORE_SIZE, 0), 0);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        
+        if (t1.tv_sec > t0.tv_sec && t1.tv_nsec < t0.tv_nsec) {
+            straddled++;
+            
+            /* The first transfer to a peer records its throughput as is;
+             * it can't be below what this thread measured around it */
+            uint64_t us = (uint64_t)((t1.tv_sec - t0.tv_sec) * 1000000000LL +
+                                     (t1.tv_nsec - t0.tv_nsec)) / 1000 + 1;
+            remoteio_stripe_peer_t* peer = stripe_only_peer(&ctx->conn_pool);
+            ASSERT_NOT_NULL(peer);
+            ASSERT_EQ(peer->transfers, 1);
+            ASSERT(peer->bps >= (uint64_t)STORE_SIZE * 1000000ULL / us);
+        }
+        
+        remoteio_context_destroy(ctx);
+    }
+    ASSERT(straddled > 0);
+    ASSERT_EQ(memcmp(g_store, buf, STORE_SIZE), 0);
+    
+    free(buf);
+}
+
+/* ============================================================================
+ * Reactor Tests
+ * ============================================================================ */
+
+typedef struct {
+    pthread_t reactor;
+    int done;
+    int off_reactor;
+} reactor_tally_t;
+
+static void reactor_tally_cb(gpuio_request_t request, gpuio_error_t status, void* user_data) {
+    reactor_tally_t* tally = (reactor_tally_t*)user_data;
+    (void)request;
+    
+    if (status != GPUIO_SUCCESS || !pthread_equal(pthread_self(), tally->reactor)) {
+        __atomic_add_fetch(&tally->off_reactor, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&tally->done, 1, __ATOMIC_RELEASE);
+}
+
+TEST(reactor_completes_many_ops) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_connection_t* conn = proto_connect(ctx, g_server->port);
+    ASSERT_NOT_NULL(conn);
+    ASSERT(conn->reactor == &ctx->reactor);
+    
+    enum { OPS = 64, LEN = 4096 };
+    char* buf = malloc(OPS * LEN);
+    ASSERT_NOT_NULL(buf);
+    for (int i = 0; i < OPS * LEN; i++) g_store[i] = (char)(i * 7 + 3);
+    reactor_tally_t tally = { .reactor = ctx->completion_thread };
+    remoteio_operation_t* ops[OPS];
+    
+    /* All outstanding on one connection at once */
+    for (int i = 0; i < OPS; i++) {
+        ops[i] = remoteio_op_alloc(ctx);
+        ASSERT_NOT_NULL(ops[i]);
+        ops[i]->op = REMOTEIO_OP_READ;
+        ops[i]->conn = conn;
+        snprintf(ops[i]->resource, sizeof(ops[i]->resource), "mem");
+        ops[i]->local_buf = buf + i * LEN;
+        ops[i]->remote_offset = (uint64_t)i * LEN;
+        ops[i]->length = LEN;
+        ops[i]->callback = reactor_tally_cb;
+        ops[i]->user_data = &tally;
+        ASSERT_EQ(remoteio_op_submit(ctx, ops[i]), 0);
+    }
+    for (int i = 0; i < OPS; i++) {
+        ASSERT_EQ(remoteio_op_wait(ops[i], WAIT_US), 0);
+    }
+    ASSERT_EQ(memcmp(buf, g_store, OPS * LEN), 0);
+    
+    /* Every callback ran on the reactor thread */
+    for (int i = 0; i < 1000 && __atomic_load_n(&tally.done, __ATOMIC_ACQUIRE) < OPS; i++) {
+        usleep(1000);
+    }
+    ASSERT_EQ(__atomic_load_n(&tally.done, __ATOMIC_ACQUIRE), OPS);
+    ASSERT_EQ(tally.off_reactor, 0);
+    
+    for (int i = 0; i < OPS; i++) remoteio_op_free(ctx, ops[i]);
+    free(buf);
+    remoteio_conn_release(conn);
+    remoteio_context_destroy(ctx);
+}
+
+/* ============================================================================
+ * One-Sided Tests
+ * ============================================================================ */
+
+TEST(named_rw_unix) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, UNIX_PATH, 0, &conn), 0);
+    ASSERT_EQ(named_round_trip(ctx, conn, 12345, 300000, 3), 0);
+    remoteio_disconnect(ctx, conn);
+    
+    remoteio_context_destroy(ctx);
+}
+
+TEST(named_rw_soft_rdma) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_SOFT_RDMA);
+    ASSERT_NOT_NULL(ctx);
+    
+    /* Soft RDMA connections carry named requests as well */
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    ASSERT_EQ(conn->transport, REMOTEIO_TRANSPORT_SOFT_RDMA);
+    ASSERT_EQ(named_round_trip(ctx, conn, 777, 65536, 4), 0);
+    remoteio_disconnect(ctx, conn);
+    
+    remoteio_context_destroy(ctx);
+}
+
+TEST(one_sided_rkey_and_bounds) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_SOFT_RDMA);
+    ASSERT_NOT_NULL(ctx);
+    
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    
+    char* local = malloc(65536);
+    ASSERT_NOT_NULL(local);
+    for (int i = 0; i < 65536; i++) local[i] = (char)(i * 11 + 9);
+    remoteio_gdr_region_t* region;
+    ASSERT_EQ(remoteio_soft_rdma_register_memory(local, 65536, 0, &region), 0);
+    
+    remoteio_server_stats_t before, after;
+    remoteio_server_get_stats(g_server, &before);
+    
+    /* In range and permitted, several chunks at once */
+    ASSERT_EQ(one_sided_op(ctx, conn, REMOTEIO_OP_WRITE, region, &g_rw_mem, 8192, 65536), 0);
+    ASSERT_EQ(memcmp(g_store + 8192, local, 65536), 0);
+    ASSERT_EQ(one_sided_op(ctx, conn, REMOTEIO_OP_READ, region, &g_ro_mem, 100, 4096), 0);
+    ASSERT_EQ(memcmp(local, g_ro_store + 100, 4096), 0);
+    
+    /* Unknown rkey */
+    remoteio_remote_mem_t bad = g_rw_mem;
+    bad.rkey ^= 0x5a5a;
+    ASSERT_NE(one_sided_op(ctx, conn, REMOTEIO_OP_READ, region, &bad, 0, 4096), 0);
+    
+    /* Past the end of the region the server registered */
+    bad = g_rw_mem;
+    bad.length = 2 * STORE_SIZE;
+    ASSERT_NE(one_sided_op(ctx, conn, REMOTEIO_OP_READ, region, &bad, STORE_SIZE - 100, 4096), 0);
+    
+    /* Write to a read-only region leaves it untouched */
+    char saved[64];
+    memcpy(saved, g_ro_store, sizeof(saved));
+    ASSERT_NE(one_sided_op(ctx, conn, REMOTEIO_OP_WRITE, region, &g_ro_mem, 0, 64), 0);
+    ASSERT_EQ(memcmp(saved, g_ro_store, sizeof(saved)), 0);
+    
+    remoteio_server_get_stats(g_server, &after);
+    ASSERT(after.access_violations >= before.access_violations + 3);
+    
+    /* The connection survives the rejections */
+    ASSERT_EQ(one_sided_op(ctx, conn, REMOTEIO_OP_READ, region, &g_rw_mem, 0, 1000), 0);
+    
+    /* A deregistered region is refused from then on */
+    remoteio_remote_mem_t gone;
+    ASSERT_EQ(remoteio_server_register_region(g_server, NULL, g_store, 4096,
+                                              REMOTEIO_ACCESS_REMOTE_READ, &gone), 0);
+    ASSERT_EQ(one_sided_op(ctx, conn, REMOTEIO_OP_READ, region, &gone, 0, 4096), 0);
+    ASSERT_EQ(remoteio_server_deregister_region(g_server, gone.rkey), 0);
+    ASSERT_NE(one_sided_op(ctx, conn, REMOTEIO_OP_READ, region, &gone, 0, 4096), 0);
+    
+    remoteio_rdma_unregister_gpu_memory(region);
+    free(local);
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+}
+
+TEST(one_sided_stuck_reader) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    
+    /* A peer that asks for far more than its socket buffers hold, then
+     * never reads a byte of it */
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT(fd >= 0);
+    int small = 4096;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons((uint16_t)g_server->port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    ASSERT_EQ(connect(fd, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    for (int i = 0; i < 64; i++) {
+        remoteio_msg_hdr_t read = {
+            .type = REMOTEIO_MSG_RDMA_READ,
+            .flags = REMOTEIO_MSG_F_LAST,
+            .req_id = (uint64_t)i + 1,
+            .offset = g_ro_mem.raddr,
+            .length = REMOTEIO_PROTO_CHUNK,
+            .rkey = g_ro_mem.rkey,
+        };
+        uint8_t raw[REMOTEIO_MSG_HDR_SIZE];
+        remoteio_msg_encode(&read, raw);
+        ASSERT_EQ(send(fd, raw, sizeof(raw), MSG_NOSIGNAL), (ssize_t)sizeof(raw));
+    }
+    usleep(100000);
+    
+    /* Other clients are still served promptly */
+    char buf[1000];
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_READ, "mem", buf, 0, sizeof(buf)), 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ASSERT(end.tv_sec - start.tv_sec < 2);
+    ASSERT_EQ(memcmp(buf, g_store, sizeof(buf)), 0);
+    
+    close(fd);
+    ASSERT_EQ(named_round_trip(ctx, conn, 0, 4096, 3), 0);
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+}
+
+/* ============================================================================
+ * Region Cache Tests
+ * ============================================================================ */
+
+/* Wait up to 1s for the cache to have dropped n entries */
+static bool invalidations_wait(remoteio_region_cache_t* cache, uint64_t n) {
+    for (int i = 0; i < 100; i++) {
+        pthread_mutex_lock(&cache->lock);
+        bool reached = cache->invalidations >= n;
+        pthread_mutex_unlock(&cache->lock);
+        if (reached) return true;
+        usleep(10000);
+    }
+    return false;
+}
+
+TEST(region_lookup_and_cache) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_region_cache_t* cache = &ctx->region_cache;
+    char uri[128];
+    
+    /* The first lookup asks the server; the second is answered locally */
+    remoteio_remote_mem_t mem;
+    snprintf(uri, sizeof(uri), "tcp://127.0.0.1:%d/rw", g_server->port);
+    ASSERT_EQ(remoteio_resolve(ctx, uri, &mem), 0);
+    ASSERT_EQ(mem.raddr, g_rw_mem.raddr);
+    ASSERT_EQ(mem.rkey, g_rw_mem.rkey);
+    ASSERT_EQ(mem.length, (size_t)STORE_SIZE);
+    ASSERT_EQ(cache->misses, 1);
+    ASSERT_EQ(remoteio_resolve(ctx, uri, &mem), 0);
+    ASSERT_EQ(mem.rkey, g_rw_mem.rkey);
+    ASSERT_EQ(cache->hits, 1);
+    
+    /* Exports and unknown names don't resolve */
+    snprintf(uri, sizeof(uri), "tcp://127.0.0.1:%d/mem", g_server->port);
+    ASSERT_NE(remoteio_resolve(ctx, uri, &mem), 0);
+    snprintf(uri, sizeof(uri), "tcp://127.0.0.1:%d/nosuch", g_server->port);
+    ASSERT_NE(remoteio_resolve(ctx, uri, &mem), 0);
+    ASSERT_EQ(cache->num_entries, 1);
+    
+    remoteio_context_destroy(ctx);
+}
+
+TEST(region_invalidate_push) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_SOFT_RDMA);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_region_cache_t* cache = &ctx->region_cache;
+    char uri[128];
+    snprintf(uri, sizeof(uri), "tcp://127.0.0.1:%d/tmp", g_server->port);
+    
+    remoteio_remote_mem_t first, second, mem;
+    ASSERT_EQ(remoteio_server_register_region(g_server, "tmp", g_store, 4096,
+                                              REMOTEIO_ACCESS_REMOTE_READ, &first), 0);
+    ASSERT_EQ(remoteio_resolve(ctx, uri, &mem), 0);
+    ASSERT_EQ(mem.rkey, first.rkey);
+    
+    /* Deregistering pushes the revocation to the still-pooled connection */
+    ASSERT_EQ(remoteio_server_deregister_region(g_server, first.rkey), 0);
+    ASSERT(invalidations_wait(cache, 1));
+    ASSERT_NE(remoteio_region_cache_get(cache, "127.0.0.1", (uint16_t)g_server->port,
+                                        "tmp", &mem), 0);
+    ASSERT_NE(remoteio_resolve(ctx, uri, &mem), 0);
+    
+    /* The name can be registered again, and resolves to the new region */
+    ASSERT_EQ(remoteio_server_register_region(g_server, "tmp", g_store + 4096, 4096,
+                                              REMOTEIO_ACCESS_REMOTE_READ, &second), 0);
+    ASSERT_EQ(remoteio_resolve(ctx, uri, &mem), 0);
+    ASSERT_EQ(mem.rkey, second.rkey);
+    ASSERT_EQ(mem.raddr, second.raddr);
+    
+    /* A stale entry the push never reached is dropped when it is refused */
+    remoteio_remote_mem_t stale = mem;
+    stale.rkey ^= 0x5a5a;
+    ASSERT_EQ(remoteio_region_cache_put(cache, "stale", &stale), 0);
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    char local[64];
+    remoteio_gdr_region_t* region;
+    ASSERT_EQ(remoteio_soft_rdma_register_memory(local, sizeof(local), 0, &region), 0);
+    ASSERT_NE(one_sided_op(ctx, conn, REMOTEIO_OP_READ, region, &stale, 0, sizeof(local)), 0);
+    ASSERT(invalidations_wait(cache, 2));
+    ASSERT_NE(remoteio_region_cache_get(cache, "127.0.0.1", (uint16_t)g_server->port,
+                                        "stale", &mem), 0);
+    
+    remoteio_rdma_unregister_gpu_memory(region);
+    remoteio_disconnect(ctx, conn);
+    ASSERT_EQ(remoteio_server_deregister_region(g_server, second.rkey), 0);
+    remoteio_context_destroy(ctx);
+}
+
+TEST(gpu_entry_points) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_SOFT_RDMA);
+    ASSERT_NOT_NULL(ctx);
+    
+    size_t len = 65536;
+    char* out = malloc(len);
+    char* in = malloc(len);
+    ASSERT(out && in);
+    for (size_t i = 0; i < len; i++) out[i] = (char)(i * 5 + 1);
+    
+    /* A named region goes one-sided, at the offset within it */
+    char uri[128];
+    snprintf(uri, sizeof(uri), "tcp://127.0.0.1:%d/rw", g_server->port);
+    ASSERT_EQ(remoteio_write_gpu(ctx, uri, out, len, 32768), 0);
+    ASSERT_EQ(memcmp(g_store + 32768, out, len), 0);
+    memset(in, 0, len);
+    ASSERT_EQ(remoteio_read_gpu(ctx, uri, in, len, 32768), 0);
+    ASSERT_EQ(memcmp(in, out, len), 0);
+    ASSERT_EQ(ctx->rdma_ops, 2);
+    
+    /* Past the region's end */
+    ASSERT_NE(remoteio_read_gpu(ctx, uri, in, len, STORE_SIZE - 100), 0);
+    
+    /* Registered again elsewhere: the stale descriptor is not used */
+    remoteio_remote_mem_t first, second;
+    ASSERT_EQ(remoteio_server_register_region(g_server, "gpu", g_store + 262144, len,
+                                              REMOTEIO_ACCESS_REMOTE_WRITE, &first), 0);
+    snprintf(uri, sizeof(uri), "tcp://127.0.0.1:%d/gpu", g_server->port);
+    ASSERT_EQ(remoteio_write_gpu(ctx, uri, out, len, 0), 0);
+    ASSERT_EQ(memcmp(g_store + 262144, out, len), 0);
+    ASSERT_EQ(remoteio_server_deregister_region(g_server, first.rkey), 0);
+    ASSERT_EQ(remoteio_server_register_region(g_server, "gpu", g_store + 524288, len,
+                                              REMOTEIO_ACCESS_REMOTE_WRITE, &second), 0);
+    ASSERT_EQ(remoteio_write_gpu(ctx, uri, out, len, 0), 0);
+    ASSERT_EQ(memcmp(g_store + 524288, out, len), 0);
+    ASSERT_EQ(remoteio_server_deregister_region(g_server, second.rkey), 0);
+    
+    /* A plain export is staged through a named read */
+    uint64_t ops = ctx->rdma_ops;
+    snprintf(uri, sizeof(uri), "tcp://127.0.0.1:%d/mem", g_server->port);
+    memset(in, 0, len);
+    ASSERT_EQ(remoteio_read_gpu(ctx, uri, in, len, 32768), 0);
+    ASSERT_EQ(memcmp(in, out, len), 0);
+    ASSERT_EQ(ctx->rdma_ops, ops);
+    
+    /* Destroying the context drops the buffers' registrations */
+    remoteio_context_destroy(ctx);
+    free(out);
+    free(in);
+}
+
+/* ============================================================================
+ * Chain Tests
+ * ============================================================================ */
+
+/* Link n 4 KiB one-sided writes from local into remote, op i at i * 4096 */
+static int chain_build(remoteio_context_t* ctx, remoteio_connection_t* conn,
+                       remoteio_gdr_region_t* local, remoteio_remote_mem_t* remote,
+                       remoteio_operation_t** ops, int n) {
+    for (int i = 0; i < n; i++) {
+        ops[i] = remoteio_op_alloc(ctx);
+        if (!ops[i]) return -1;
+        ops[i]->op = REMOTEIO_OP_WRITE;
+        ops[i]->conn = conn;
+        ops[i]->local_gdr = local;
+        ops[i]->local_offset = (uint64_t)i * 4096;
+        ops[i]->remote_mem = remote;
+        ops[i]->remote_offset = (uint64_t)i * 4096;
+        ops[i]->length = 4096;
+        ops[i]->next_sg = NULL;
+        if (i > 0) ops[i - 1]->next_sg = ops[i];
+    }
+    return 0;
+}
+
+TEST(chain_signal_counts) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_SOFT_RDMA);
+    ASSERT_NOT_NULL(ctx);
+    
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    
+    enum { N = 100 };
+    char* local = malloc(N * 4096);
+    ASSERT_NOT_NULL(local);
+    for (int i = 0; i < N * 4096; i++) local[i] = (char)(i * 5 + 3);
+    remoteio_gdr_region_t* region;
+    ASSERT_EQ(remoteio_soft_rdma_register_memory(local, N * 4096, 0, &region), 0);
+    
+    remoteio_operation_t* ops[N];
+    ASSERT_EQ(chain_build(ctx, conn, region, &g_rw_mem, ops, N), 0);
+    
+    /* Every 8th op and the tail are signalled: 12 + 1 */
+    ASSERT_EQ(remoteio_op_post_chain(ctx, ops[0], 8), N);
+    ASSERT_EQ(remoteio_op_wait(ops[N - 1], WAIT_US), 0);
+    for (int i = 0; i < N; i++) {
+        ASSERT(ops[i]->completed);
+        ASSERT_EQ(ops[i]->status, GPUIO_SUCCESS);
+    }
+    ASSERT_EQ(memcmp(g_store, local, N * 4096), 0);
+    ASSERT_EQ(conn->doorbells, 1);
+    ASSERT_EQ(conn->chained_wrs, N);
+    ASSERT_EQ(conn->signaled_wrs, 13);
+    
+    for (int i = 0; i < N; i++) remoteio_op_free(ctx, ops[i]);
+    remoteio_rdma_unregister_gpu_memory(region);
+    free(local);
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+}
+
+TEST(chain_member_error) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_SOFT_RDMA);
+    ASSERT_NOT_NULL(ctx);
+    
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    
+    enum { N = 4 };
+    char* local = malloc(N * 4096);
+    ASSERT_NOT_NULL(local);
+    for (int i = 0; i < N * 4096; i++) local[i] = (char)(i * 3 + 7);
+    remoteio_gdr_region_t* region;
+    ASSERT_EQ(remoteio_soft_rdma_register_memory(local, N * 4096, 0, &region), 0);
+    
+    /* One unsignalled write into the read-only region */
+    remoteio_operation_t* ops[N];
+    ASSERT_EQ(chain_build(ctx, conn, region, &g_rw_mem, ops, N), 0);
+    ops[1]->remote_mem = &g_ro_mem;
+    char saved[4096];
+    memcpy(saved, g_ro_store + 4096, sizeof(saved));
+    
+    /* Its error is still acked, and lands on it alone */
+    ASSERT_EQ(remoteio_op_post_chain(ctx, ops[0], N), N);
+    ASSERT_EQ(remoteio_op_wait(ops[N - 1], WAIT_US), 0);
+    for (int i = 0; i < N; i++) {
+        ASSERT(ops[i]->completed);
+        if (i == 1) {
+            ASSERT_NE(ops[i]->status, GPUIO_SUCCESS);
+        } else {
+            ASSERT_EQ(ops[i]->status, GPUIO_SUCCESS);
+            ASSERT_EQ(memcmp(g_store + i * 4096, local + i * 4096, 4096), 0);
+        }
+    }
+    ASSERT_EQ(memcmp(g_ro_store + 4096, saved, sizeof(saved)), 0);
+    
+    for (int i = 0; i < N; i++) remoteio_op_free(ctx, ops[i]);
+    remoteio_rdma_unregister_gpu_memory(region);
+    free(local);
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+}
+
+/* ============================================================================
+ * Collective Tests
+ * ============================================================================ */
+
+#define COLL_RANKS  4
+#define COLL_COUNT  (REMOTEIO_COLL_CHUNK + 1001)
+
+typedef int (*coll_body_t)(remoteio_comm_t* comm);
+
+typedef struct {
+    int rank;
+    const char* const* peers;
+    coll_body_t body;
+    remoteio_context_t* ctx;
+    remoteio_server_t* server;
+    int result;
+} coll_rank_t;
+
+/* Byte i of rank (or root) seed's data */
+static uint8_t coll_byte(int seed, size_t i) {
+    return (uint8_t)(i * 31 + (size_t)seed * 17 + 1);
+}
+
+static void* coll_rank_run(void* arg) {
+    coll_rank_t* r = (coll_rank_t*)arg;
+    remoteio_comm_t* comm;
+    
+    r->result = -1;
+    if (remoteio_comm_create(r->ctx, r->server, "test", r->rank, COLL_RANKS,
+                             r->peers, &comm) != 0) {
+        return NULL;
+    }
+    
+    int ok = r->body(comm) == 0;
+    
+    /* Nobody tears down its server while a peer still writes to it */
+    float done = 1;
+    if (remoteio_coll_allreduce(comm, &done, 1, REMOTEIO_COLL_TREE) != 0) ok = 0;
+    
+    remoteio_comm_destroy(comm);
+    r->result = ok ? 0 : -1;
+    return NULL;
+}
+
+/* Run body on COLL_RANKS ranks at once; the number of ranks it failed on */
+static int coll_run(coll_body_t body) {
+    coll_rank_t ranks[COLL_RANKS];
+    char addrs[COLL_RANKS][32];
+    const char* peers[COLL_RANKS];
+    pthread_t threads[COLL_RANKS];
+    int failed = 0;
+    
+    memset(ranks, 0, sizeof(ranks));
+    for (int i = 0; i < COLL_RANKS; i++) {
+        ranks[i].ctx = client_create(REMOTEIO_TRANSPORT_SOFT_RDMA);
+        if (!ranks[i].ctx ||
+            remoteio_server_create(ranks[i].ctx, 2, 32, &ranks[i].server) != 0 ||
+            remoteio_server_start(ranks[i].server, 0) != 0) {
+            return COLL_RANKS;
+        }
+        snprintf(addrs[i], sizeof(addrs[i]), "127.0.0.1:%d", ranks[i].server->port);
+        peers[i] = addrs[i];
+    }
+    
+    for (int i = 0; i < COLL_RANKS; i++) {
+        ranks[i].rank = i;
+        ranks[i].peers = peers;
+        ranks[i].body = body;
+        if (pthread_create(&threads[i], NULL, coll_rank_run, &ranks[i]) != 0) return COLL_RANKS;
+    }
+    for (int i = 0; i < COLL_RANKS; i++) pthread_join(threads[i], NULL);
+    
+    for (int i = 0; i < COLL_RANKS; i++) {
+        if (ranks[i].result != 0) failed++;
+        remoteio_server_destroy(ranks[i].server);
+        remoteio_context_destroy(ranks[i].ctx);
+    }
+    return failed;
+}
+
+/* Sum of rank + (i % 7) over all ranks */
+static float coll_sum(size_t i) {
+    return (float)(COLL_RANKS * (i % 7) + COLL_RANKS * (COLL_RANKS - 1) / 2);
+}
+
+static int coll_allreduce_body(remoteio_comm_t* comm) {
+    /* COLL_COUNT leaves the ring uneven segments; 3 leaves one empty */
+    static const size_t counts[] = { COLL_COUNT, 3 };
+    float* buf = malloc(COLL_COUNT * sizeof(float));
+    int ok = buf != NULL;
+    
+    for (int c = 0; ok && c < 2; c++) {
+        for (int algo = REMOTEIO_COLL_RING; ok && algo <= REMOTEIO_COLL_TREE; algo++) {
+            for (size_t i = 0; i < counts[c]; i++) buf[i] = (float)comm->rank + (float)(i % 7);
+            ok = remoteio_coll_allreduce(comm, buf, counts[c], (remoteio_coll_algo_t)algo) == 0;
+            for (size_t i = 0; ok && i < counts[c]; i++) ok = buf[i] == coll_sum(i);
+        }
+    }
+    
+    free(buf);
+    return ok ? 0 : -1;
+}
+
+static int coll_broadcast_body(remoteio_comm_t* comm) {
+    size_t len = 2 * REMOTEIO_COLL_CHUNK + 333;
+    size_t chunks = 3;
+    uint8_t* buf = malloc(len);
+    int ok = buf != NULL;
+    
+    /* Every root, including the non-zero ones, down the chain and the tree */
+    for (int algo = REMOTEIO_COLL_RING; ok && algo <= REMOTEIO_COLL_TREE; algo++) {
+        for (int root = 0; ok && root < comm->size; root++) {
+            for (size_t i = 0; i < len; i++) {
+                buf[i] = comm->rank == root ? coll_byte(root + 10 * algo, i) : 0xee;
+            }
+            remoteio_comm_stats_t before, after;
+            remoteio_comm_get_stats(comm, &before);
+            ok = remoteio_coll_broadcast(comm, buf, len, root, (remoteio_coll_algo_t)algo) == 0;
+            for (size_t i = 0; ok && i < len; i++) ok = buf[i] == coll_byte(root + 10 * algo, i);
+            
+            /* The chain's root feeds one peer, the tree's root two */
+            remoteio_comm_get_stats(comm, &after);
+            if (ok && comm->rank == root) {
+                size_t kids = algo == REMOTEIO_COLL_TREE ? 2 : 1;
+                ok = after.chunks_sent - before.chunks_sent == kids * chunks;
+            }
+        }
+    }
+    
+    free(buf);
+    return ok ? 0 : -1;
+}
+
+static int coll_allgather_body(remoteio_comm_t* comm) {
+    size_t per_rank = REMOTEIO_COLL_CHUNK + 77;
+    uint8_t* buf = malloc(per_rank * (size_t)comm->size);
+    if (!buf) return -1;
+    
+    memset(buf, 0xee, per_rank * (size_t)comm->size);
+    for (size_t i = 0; i < per_rank; i++) {
+        buf[(size_t)comm->rank * per_rank + i] = coll_byte(comm->rank, i);
+    }
+    int ok = remoteio_coll_allgather(comm, buf, per_rank) == 0;
+    for (int r = 0; ok && r < comm->size; r++) {
+        for (size_t i = 0; ok && i < per_rank; i++) {
+            ok = buf[(size_t)r * per_rank + i] == coll_byte(r, i);
+        }
+    }
+    
+    free(buf);
+    return ok ? 0 : -1;
+}
+
+static int coll_reduce_scatter_body(remoteio_comm_t* comm) {
+    size_t per_rank = REMOTEIO_COLL_CHUNK / sizeof(float) + 555;
+    size_t count = per_rank * (size_t)comm->size;
+    float* buf = malloc(count * sizeof(float));
+    if (!buf) return -1;
+    
+    for (size_t i = 0; i < count; i++) buf[i] = (float)comm->rank + (float)(i % 7);
+    int ok = remoteio_coll_reduce_scatter(comm, buf, per_rank) == 0;
+    
+    /* Only our own piece is defined afterwards */
+    size_t first = (size_t)comm->rank * per_rank;
+    for (size_t i = first; ok && i < first + per_rank; i++) ok = buf[i] == coll_sum(i);
+    
+    free(buf);
+    return ok ? 0 : -1;
+}
+
+TEST(allreduce_four_ranks) {
+    ASSERT_EQ(coll_run(coll_allreduce_body), 0);
+}
+
+TEST(broadcast_four_ranks) {
+    ASSERT_EQ(coll_run(coll_broadcast_body), 0);
+}
+
+TEST(allgather_four_ranks) {
+    ASSERT_EQ(coll_run(coll_allgather_body), 0);
+}
+
+TEST(reduce_scatter_four_ranks) {
+    ASSERT_EQ(coll_run(coll_reduce_scatter_body), 0);
+}
+
+TEST(comm_failed_latch) {
+    remoteio_context_t* ctx[2];
+    remoteio_server_t* server[2];
+    remoteio_comm_t* comm[2];
+    char addrs[2][32];
+    const char* peers[2] = { addrs[0], addrs[1] };
+    
+    for (int i = 0; i < 2; i++) {
+        ctx[i] = client_create(REMOTEIO_TRANSPORT_SOFT_RDMA);
+        ASSERT_NOT_NULL(ctx[i]);
+        ASSERT_EQ(remoteio_server_create(ctx[i], 2, 32, &server[i]), 0);
+        ASSERT_EQ(remoteio_server_start(server[i], 0), 0);
+        snprintf(addrs[i], sizeof(addrs[i]), "127.0.0.1:%d", server[i]->port);
+    }
+    for (int i = 0; i < 2; i++) {
+        ASSERT_EQ(remoteio_comm_create(ctx[i], server[i], "latch", i, 2, peers, &comm[i]), 0);
+    }
+    
+    /* The root only writes, so it can run alone while a slot is free */
+    char buf[1000];
+    memset(buf, 1, sizeof(buf));
+    ASSERT_EQ(remoteio_coll_broadcast(comm[0], buf, sizeof(buf), 0, REMOTEIO_COLL_RING), 0);
+    ASSERT(!comm[0]->failed);
+    
+    /* With the peer's channels gone the next one fails partway... */
+    ASSERT_EQ(remoteio_server_deregister_region(server[1], comm[1]->rkey), 0);
+    ASSERT_NE(remoteio_coll_broadcast(comm[0], buf, sizeof(buf), 0, REMOTEIO_COLL_RING), 0);
+    ASSERT(comm[0]->failed);
+    
+    /* ...and the communicator refuses everything after it */
+    remoteio_comm_stats_t before, after;
+    remoteio_comm_get_stats(comm[0], &before);
+    float one = 1;
+    ASSERT_NE(remoteio_coll_allreduce(comm[0], &one, 1, REMOTEIO_COLL_TREE), 0);
+    ASSERT_NE(remoteio_coll_broadcast(comm[0], buf, sizeof(buf), 0, REMOTEIO_COLL_TREE), 0);
+    remoteio_comm_get_stats(comm[0], &after);
+    ASSERT_EQ(after.chunks_sent, before.chunks_sent);
+    ASSERT_EQ(after.collectives, 1);
+    
+    for (int i = 0; i < 2; i++) {
+        remoteio_comm_destroy(comm[i]);
+        remoteio_server_destroy(server[i]);
+        remoteio_context_destroy(ctx[i]);
+    }
+}
+
+/* ============================================================================
+ * Flow Control Tests
+ * ============================================================================ */
+
+/* Keep a server's workers from finishing named ops for a moment */
+static void* hold_exports(void* arg) {
+    remoteio_server_t* server = (remoteio_server_t*)arg;
+    pthread_rwlock_wrlock(&server->exports_lock);
+    usleep(300000);
+    pthread_rwlock_unlock(&server->exports_lock);
+    return NULL;
+}
+
+TEST(credit_exhaustion) {
+    remoteio_context_t* server_ctx = remoteio_context_create(g_ctx);
+    ASSERT_NOT_NULL(server_ctx);
+    
+    /* Four ops or 256 KB outstanding at most, per connection */
+    remoteio_server_t* server;
+    char* store = calloc(1, STORE_SIZE);
+    ASSERT_NOT_NULL(store);
+    ASSERT_EQ(remoteio_server_create(server_ctx, 2, 4, &server), 0);
+    server->credit_bytes = 256 * 1024;
+    ASSERT_EQ(remoteio_server_export_memory(server, "mem", store, STORE_SIZE, true), 0);
+    ASSERT_EQ(remoteio_server_start(server, 0), 0);
+    
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_TCP);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)server->port, &conn), 0);
+    ASSERT(conn->proto->credits);
+    ASSERT_EQ(conn->proto->ops_limit, 4);
+    ASSERT_EQ(conn->proto->bytes_limit, 256 * 1024);
+    
+    /* Sixteen 60 KB writes in flight overrun both limits; below the
+     * zero-copy threshold, so submitting never waits for the server */
+    enum { N = 16, LEN = 60 * 1024 };
+    char* src = malloc(N * LEN);
+    ASSERT_NOT_NULL(src);
+    for (int i = 0; i < N * LEN; i++) src[i] = (char)(i * 17 + 2);
+    
+    /* No credits come back while the workers can't look the export up */
+    pthread_t holder;
+    ASSERT_EQ(pthread_create(&holder, NULL, hold_exports, server), 0);
+    while (pthread_rwlock_tryrdlock(&server->exports_lock) == 0) {
+        pthread_rwlock_unlock(&server->exports_lock);
+        usleep(1000);
+    }
+    
+    remoteio_operation_t* ops[N];
+    for (int i = 0; i < N; i++) {
+        ops[i] = remoteio_op_alloc(ctx);
+        ASSERT_NOT_NULL(ops[i]);
+        ops[i]->op = REMOTEIO_OP_WRITE;
+        ops[i]->conn = conn;
+        strcpy(ops[i]->resource, "mem");
+        ops[i]->local_buf = src + (size_t)i * LEN;
+        ops[i]->remote_offset = (uint64_t)i * LEN;
+        ops[i]->length = LEN;
+        ASSERT_EQ(remoteio_op_submit(ctx, ops[i]), 0);
+    }
+    pthread_join(holder, NULL);
+    for (int i = 0; i < N; i++) {
+        ASSERT_EQ(remoteio_op_wait(ops[i], WAIT_US), 0);
+        ASSERT_EQ(ops[i]->status, GPUIO_SUCCESS);
+        remoteio_op_free(ctx, ops[i]);
+    }
+    ASSERT_EQ(memcmp(store, src, N * LEN), 0);
+    ASSERT(conn->credit_stalls > 0);
+    
+    remoteio_server_stats_t stats;
+    remoteio_server_get_stats(server, &stats);
+    ASSERT(stats.credit_frames > 0);
+    
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+    remoteio_server_destroy(server);
+    remoteio_context_destroy(server_ctx);
+    free(src);
+    free(store);
+}
+
+/* ============================================================================
+ * Transport Selection Tests
+ * ============================================================================ */
+
+TEST(auto_fallback_counter) {
+    uint64_t fallbacks, probes, reprobes;
+    
+    /* No RDMA device here: the preference falls back once, then sticks */
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_RDMA);
+    ASSERT_NOT_NULL(ctx);
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    ASSERT_EQ(conn->transport, REMOTEIO_TRANSPORT_TCP);
+    remoteio_disconnect(ctx, conn);
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    remoteio_disconnect(ctx, conn);
+    ASSERT_EQ(remoteio_get_transport_stats(ctx, &fallbacks, &probes, &reprobes), 0);
+    ASSERT_EQ(fallbacks, 1);
+    ASSERT_EQ(probes, 0);
+    remoteio_context_destroy(ctx);
+    
+    /* AUTO probes the peer once and never falls back */
+    ctx = remoteio_context_create(g_ctx);
+    ASSERT_NOT_NULL(ctx);
+    ASSERT_EQ(ctx->preferred_transport, REMOTEIO_TRANSPORT_AUTO);
+    char uri[128];
+    char buf[1000];
+    snprintf(uri, sizeof(uri), "tcp://127.0.0.1:%d/mem", g_server->port);
+    ASSERT_EQ(remoteio_read(ctx, uri, buf, sizeof(buf), 0), 0);
+    ASSERT_EQ(remoteio_read(ctx, uri, buf, sizeof(buf), 0), 0);
+    ASSERT_EQ(memcmp(buf, g_store, sizeof(buf)), 0);
+    
+    remoteio_route_t route;
+    ASSERT_EQ(remoteio_route_get(ctx, "127.0.0.1", (uint16_t)g_server->port, &route), 0);
+    ASSERT(route.named_ns[REMOTEIO_TRANSPORT_TCP][0] > 0);
+    ASSERT_EQ(remoteio_get_transport_stats(ctx, &fallbacks, &probes, &reprobes), 0);
+    ASSERT_EQ(fallbacks, 0);
+    ASSERT_EQ(probes, 1);
+    remoteio_context_destroy(ctx);
+}
+
+/* ============================================================================
+ * Shared Memory Tests
+ * ============================================================================ */
+
+TEST(named_rw_shm) {
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_SHM);
+    ASSERT_NOT_NULL(ctx);
+    
+    remoteio_server_stats_t before, after;
+    remoteio_server_get_stats(g_server, &before);
+    
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    ASSERT_EQ(conn->transport, REMOTEIO_TRANSPORT_SHM);
+    
+    /* Larger than one ring, so the writer has to wait for room */
+    ASSERT_EQ(named_round_trip(ctx, conn, 0, STORE_SIZE, 5), 0);
+    ASSERT_EQ(named_round_trip(ctx, conn, 99, 1000, 6), 0);
+    remoteio_disconnect(ctx, conn);
+    
+    remoteio_server_get_stats(g_server, &after);
+    ASSERT_EQ(after.shm_clients, before.shm_clients + 1);
+    
+    remoteio_context_destroy(ctx);
+}
+
+TEST(shm_silent_client) {
+    remoteio_server_stats_t before, after;
+    remoteio_server_get_stats(g_server, &before);
+    
+    /* A same-host peer that connects to the control socket and says nothing */
+    char name[INET6_ADDRSTRLEN];
+    ASSERT_EQ(remoteio_shm_name(NULL, (uint16_t)g_server->port, name, sizeof(name)), 0);
+    struct sockaddr_un sun = { .sun_family = AF_UNIX };
+    strcpy(sun.sun_path, name);
+    sun.sun_path[0] = '\0';
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT(fd >= 0);
+    ASSERT_EQ(connect(fd, (struct sockaddr*)&sun, sizeof(sun)), 0);
+    usleep(100000);
+    
+    /* Others still get their rings straight away */
+    remoteio_context_t* ctx = client_create(REMOTEIO_TRANSPORT_SHM);
+    ASSERT_NOT_NULL(ctx);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    remoteio_connection_t* conn;
+    ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ASSERT_EQ(conn->transport, REMOTEIO_TRANSPORT_SHM);
+    ASSERT(end.tv_sec - start.tv_sec < 2);
+    ASSERT_EQ(named_round_trip(ctx, conn, 4096, 1000, 4), 0);
+    remoteio_disconnect(ctx, conn);
+    remoteio_context_destroy(ctx);
+    
+    /* The silent one is refused once its time is up */
+    struct timeval tv = { .tv_sec = 2 * REMOTEIO_HELLO_TIMEOUT_MS / 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    char c;
+    ASSERT_EQ(recv(fd, &c, 1, 0), 0);
+    close(fd);
+    
+    remoteio_server_get_stats(g_server, &after);
+    ASSERT_EQ(after.shm_clients, before.shm_clients + 1);
+}
+
+TEST(read_past_eof) {
+    char dir[] = "/tmp/gpuio_test_remoteio_XXXXXX";
+    ASSERT_NOT_NULL(mkdtemp(dir));
+    char path[128];
+    snprintf(path, sizeof(path), "%s/small.bin", dir);
+    FILE* f = fopen(path, "w");
+    ASSERT_NOT_NULL(f);
+    fputs("gpuio\n", f);
+    fclose(f);
+    
+    ASSERT_EQ(remoteio_server_export_dir(g_server, "files", dir, false), 0);
+    
+    remoteio_transport_t transports[] = { REMOTEIO_TRANSPORT_TCP, REMOTEIO_TRANSPORT_SHM };
+    for (int t = 0; t < 2; t++) {
+        remoteio_context_t* ctx = client_create(transports[t]);
+        ASSERT_NOT_NULL(ctx);
+        remoteio_connection_t* conn;
+        ASSERT_EQ(remoteio_connect(ctx, "127.0.0.1", (uint16_t)g_server->port, &conn), 0);
+        ASSERT_EQ(conn->transport, transports[t]);
+        
+        char buf[64];
+        ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_READ, "files/small.bin", buf, 0, 6), 0);
+        ASSERT_EQ(memcmp(buf, "gpuio\n", 6), 0);
+        
+        /* Past EOF, starting beyond it, and empty: each answered at once */
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ASSERT_NE(named_op(ctx, conn, REMOTEIO_OP_READ, "files/small.bin", buf, 0, 64), 0);
+        ASSERT_NE(named_op(ctx, conn, REMOTEIO_OP_READ, "files/small.bin", buf, 7, 1), 0);
+        ASSERT_NE(named_op(ctx, conn, REMOTEIO_OP_READ, "files/small.bin", buf, 0, 0), 0);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        ASSERT(end.tv_sec - start.tv_sec < 2);
+        
+        /* The connection still serves requests */
+        ASSERT_EQ(named_op(ctx, conn, REMOTEIO_OP_READ, "files/small.bin", buf, 2, 4), 0);
+        ASSERT_EQ(memcmp(buf, "uio\n", 4), 0);
+        
+        remoteio_disconnect(ctx, conn);
+        remoteio_context_destroy(ctx);
+    }
+    
+    unlink(path);
+    rmdir(dir);
+}
+
+static void print_header(const char* title) {
+    printf("\n%s\n", title);
+    printf("%.*s\n", (int)strlen(title),
+           "============================================================");
+}
+
+int main(int argc, char* argv[]) {
+    (void)argc;
+    (void)argv;
+    printf("gpuio RemoteIO Unit Tests\n");
+    printf("Version: %s\n", gpuio_get_version_string());
+    
+    printf("\nSetting up loopback peer and server...\n");
+    if (setup() != 0) {
+        printf("Setup failed\n");
+        teardown();
+        return 1;
+    }
+    printf("Setup complete (peer port %d, server port %d).\n", g_peer_port, g_server->port);
+    
+    print_header("Framed Protocol Tests");
+    RUN_TEST(header_round_trip);
+    RUN_TEST(uri_rw_tcp);
+    RUN_TEST(responses_out_of_order);
+    RUN_TEST(broken_stream_fails_ops);
+    RUN_TEST(op_free_during_fail);
+    
+    print_header("Server Tests");
+    RUN_TEST(server_memory_rw);
+    RUN_TEST(server_dir_export);
+    RUN_TEST(server_queue_depth);
+    
+    print_header("Connection Pool Tests");
+    RUN_TEST(pool_hash_lookup);
+    RUN_TEST(pool_idle_eviction);
+    RUN_TEST(pool_health_check);
+    RUN_TEST(pool_reconnect_dead);
+    
+    print_header("Op Slab Tests");
+    RUN_TEST(op_slab_exhaustion);
+    RUN_TEST(op_slab_threads);
+    RUN_TEST(op_cache_per_context);
+    RUN_TEST(op_callback_before_wait);
+    
+    print_header("Wire Compression Tests");
+    RUN_TEST(compression_negotiation);
+    RUN_TEST(compression_skips_incompressible);
+    RUN_TEST(compression_stats_per_connection);
+    
+    print_header("Zero-Copy Tests");
+    RUN_TEST(zerocopy_release_order);
+    RUN_TEST(zerocopy_write_and_read);
+    RUN_TEST(reactor_drains_error_queue);
+    RUN_TEST(sendfile_read);
+    
+    print_header("Striping Tests");
+    RUN_TEST(stripe_hill_climb);
+    RUN_TEST(stripe_uri_transfer);
+    RUN_TEST(stripe_time_across_second);
+    
+    print_header("Reactor Tests");
+    RUN_TEST(reactor_completes_many_ops);
+    
+    print_header("One-Sided Tests");
+    RUN_TEST(named_rw_unix);
+    RUN_TEST(named_rw_soft_rdma);
+    RUN_TEST(one_sided_rkey_and_bounds);
+    RUN_TEST(one_sided_stuck_reader);
+    
+    print_header("Region Cache Tests");
+    RUN_TEST(region_lookup_and_cache);
+    RUN_TEST(region_invalidate_push);
+    RUN_TEST(gpu_entry_points);
+    
+    print_header("Chain Tests");
+    RUN_TEST(chain_signal_counts);
+    RUN_TEST(chain_member_error);
+    
+    print_header("Collective Tests");
+    RUN_TEST(allreduce_four_ranks);
+    RUN_TEST(broadcast_four_ranks);
+    RUN_TEST(allgather_four_ranks);
+    RUN_TEST(reduce_scatter_four_ranks);
+    RUN_TEST(comm_failed_latch);
+    
+    print_header("Flow Control Tests");
+    RUN_TEST(credit_exhaustion);
+    
+    print_header("Transport Selection Tests");
+    RUN_TEST(auto_fallback_counter);
+    
+    print_header("Shared Memory Tests");
+    RUN_TEST(named_rw_shm);
+    RUN_TEST(shm_silent_client);
+    RUN_TEST(read_past_eof);
+    
+    teardown();
+    
+    /* Summary */
+    printf("\n============================================================\n");
+    printf("Test Summary:\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("============================================================\n");
+    
+    return tests_failed > 0 ? 1 : 0;
+}